@@ -1574,7 +1574,7 @@ CameraDevice::ServiceCallback::onCaptureStarted(
 
     auto it = dev->mSequenceCallbackMap.find(sequenceId);
     if (it != dev->mSequenceCallbackMap.end()) {
-        CallbackHolder cbh = (*it).second;
+        const CallbackHolder& cbh = (*it).second;
         ACameraCaptureSession_captureCallback_start onStart = cbh.mOnCaptureStarted;
         sp<ACameraCaptureSession> session = cbh.mSession;
         if ((size_t) burstId >= cbh.mRequests.size()) {
@@ -1627,13 +1627,9 @@ CameraDevice::ServiceCallback::onResultReceived(
         return ret;
     }
 
-    CameraMetadata metadataCopy = metadata;
-    metadataCopy.update(ANDROID_LENS_INFO_SHADING_MAP_SIZE, dev->mShadingMapSize, /*data_count*/2);
-    metadataCopy.update(ANDROID_SYNC_FRAME_NUMBER, &frameNumber, /*data_count*/1);
-
     auto it = dev->mSequenceCallbackMap.find(sequenceId);
     if (it != dev->mSequenceCallbackMap.end()) {
-        CallbackHolder cbh = (*it).second;
+        const CallbackHolder& cbh = (*it).second;
         sp<ACameraCaptureSession> session = cbh.mSession;
         if ((size_t) burstId >= cbh.mRequests.size()) {
             ALOGE("%s: Error: request index %d out of bound (size %zu)",
@@ -1641,10 +1637,13 @@ CameraDevice::ServiceCallback::onResultReceived(
             dev->setCameraDeviceErrorLocked(ACAMERA_ERROR_CAMERA_SERVICE);
         }
         sp<CaptureRequest> request = cbh.mRequests[burstId];
+        // Only copy the result once we know there is a callback to deliver it to
+        CameraMetadata metadataCopy = metadata;
+        metadataCopy.update(ANDROID_LENS_INFO_SHADING_MAP_SIZE, dev->mShadingMapSize,
+                /*data_count*/2);
+        metadataCopy.update(ANDROID_SYNC_FRAME_NUMBER, &frameNumber, /*data_count*/1);
         sp<ACameraMetadata> result(new ACameraMetadata(
                 metadataCopy.release(), ACameraMetadata::ACM_RESULT));
-        sp<ACameraPhysicalCaptureResultInfo> physicalResult(
-                new ACameraPhysicalCaptureResultInfo(physicalResultInfos, frameNumber));
 
         sp<AMessage> msg = new AMessage(
                 cbh.mIsLogicalCameraCallback ? kWhatLogicalCaptureResult : kWhatCaptureResult,
@@ -1657,6 +1656,8 @@ CameraDevice::ServiceCallback::onResultReceived(
             msg->setPointer(kCallbackFpKey,
                     (void *)cbh.mOnCaptureProgressed);
         } else if (cbh.mIsLogicalCameraCallback) {
+            sp<ACameraPhysicalCaptureResultInfo> physicalResult(
+                    new ACameraPhysicalCaptureResultInfo(physicalResultInfos, frameNumber));
             msg->setPointer(kCallbackFpKey,
                     (void *)cbh.mOnLogicalCameraCaptureCompleted);
             msg->setObject(kPhysicalCaptureResultKey, physicalResult);
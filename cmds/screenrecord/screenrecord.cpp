@@ -119,6 +119,7 @@ static uint32_t gVideoHeight = 0;
 static uint32_t gBitRate = 20000000;     // 20Mbps
 static uint32_t gTimeLimitSec = kMaxTimeLimitSec;
 static uint32_t gBframes = 0;
+static uint32_t gIntraRefreshPeriod = 0; // frames; 0 uses periodic sync frames
 static PhysicalDisplayId gPhysicalDisplayId;
 // Set by signal handler to stop recording.
 static volatile bool gStopRequested = false;
@@ -202,6 +203,15 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
         format->setInt32(KEY_PROFILE, AVCProfileMain);
         format->setInt32(KEY_LEVEL, AVCLevel41);
     }
+    if (gIntraRefreshPeriod > 0) {
+        format->setInt32(KEY_INTRA_REFRESH_PERIOD, gIntraRefreshPeriod);
+    }
+    if (gOutputFormat == FORMAT_H264) {
+        // The raw stream is usually piped to a viewer, so ask the encoder to
+        // hold on to as few frames as possible and to run at realtime priority.
+        format->setInt32(KEY_LATENCY, 1);
+        format->setInt32(KEY_PRIORITY, 0);
+    }
 
     sp<android::ALooper> looper = new android::ALooper;
     looper->setName("screenrecord_looper");
@@ -1063,6 +1073,7 @@ int main(int argc, char* const argv[]) {
         { "monotonic-time",     no_argument,        NULL, 'm' },
         { "persistent-surface", no_argument,        NULL, 'p' },
         { "bframes",            required_argument,  NULL, 'B' },
+        { "intra-refresh-period", required_argument, NULL, 'I' },
         { "display-id",         required_argument,  NULL, 'd' },
         { NULL,                 0,                  NULL, 0 }
     };
@@ -1169,6 +1180,11 @@ int main(int argc, char* const argv[]) {
                 return 2;
             }
             break;
+        case 'I':
+            if (parseValueWithUnit(optarg, &gIntraRefreshPeriod) != NO_ERROR) {
+                return 2;
+            }
+            break;
         case 'd':
             gPhysicalDisplayId = atoll(optarg);
             if (gPhysicalDisplayId == 0) {
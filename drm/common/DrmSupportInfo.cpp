@@ -43,12 +43,12 @@ bool DrmSupportInfo::operator==(const DrmSupportInfo& drmSupportInfo) const {
 }
 
 bool DrmSupportInfo::isSupportedMimeType(const String8& mimeType) const {
-    if (String8("") == mimeType) {
+    if (mimeType.isEmpty()) {
         return false;
     }
 
     for (size_t i = 0; i < mMimeTypeVector.size(); i++) {
-        const String8 item = mMimeTypeVector.itemAt(i);
+        const String8& item = mMimeTypeVector.itemAt(i);
 
         if (!strcasecmp(item.string(), mimeType.string())) {
             return true;
@@ -59,7 +59,7 @@ bool DrmSupportInfo::isSupportedMimeType(const String8& mimeType) const {
 
 bool DrmSupportInfo::isSupportedFileSuffix(const String8& fileType) const {
     for (size_t i = 0; i < mFileSuffixVector.size(); i++) {
-        const String8 item = mFileSuffixVector.itemAt(i);
+        const String8& item = mFileSuffixVector.itemAt(i);
 
         if (!strcasecmp(item.string(), fileType.string())) {
             return true;
@@ -731,7 +731,7 @@ String8 DrmManager::getSupportedPlugInId(const String8& mimeType) {
             const DrmSupportInfo& drmSupportInfo = mSupportInfoToPlugInIdMap.keyAt(index);
 
             if (drmSupportInfo.isSupportedMimeType(mimeType)) {
-                plugInId = mSupportInfoToPlugInIdMap.valueFor(drmSupportInfo);
+                plugInId = mSupportInfoToPlugInIdMap.valueAt(index);
                 break;
             }
         }
@@ -747,7 +747,7 @@ String8 DrmManager::getSupportedPlugInIdFromPath(int uniqueId, const String8& pa
         const DrmSupportInfo& drmSupportInfo = mSupportInfoToPlugInIdMap.keyAt(index);
 
         if (drmSupportInfo.isSupportedFileSuffix(fileSuffix)) {
-            String8 key = mSupportInfoToPlugInIdMap.valueFor(drmSupportInfo);
+            const String8& key = mSupportInfoToPlugInIdMap.valueAt(index);
             IDrmEngine& drmEngine = mPlugInManager.getPlugIn(key);
 
             if (drmEngine.canHandle(uniqueId, path)) {
@@ -343,14 +343,12 @@ ssize_t CryptoHal::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
     hPattern.encryptBlocks = pattern.mEncryptBlocks;
     hPattern.skipBlocks = pattern.mSkipBlocks;
 
-    std::vector<SubSample> stdSubSamples;
+    // Fill the HIDL vector directly rather than staging through a std::vector copy.
+    hidl_vec<SubSample> hSubSamples(numSubSamples);
     for (size_t i = 0; i < numSubSamples; i++) {
-        SubSample subSample;
-        subSample.numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
-        subSample.numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
-        stdSubSamples.push_back(subSample);
+        hSubSamples[i].numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
+        hSubSamples[i].numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
     }
-    auto hSubSamples = hidl_vec<SubSample>(stdSubSamples);
 
     bool secure;
     if (hDestination.type == BufferType::SHARED_MEMORY) {
@@ -89,8 +89,12 @@ bool isEqualSessionId(const Vector<uint8_t> &sessionId1, const Vector<uint8_t> &
 }
 
 sp<DrmSessionManager> DrmSessionManager::Instance() {
-    static sp<DrmSessionManager> drmSessionManager = new DrmSessionManager();
-    drmSessionManager->init();
+    // init() only needs to run once; Instance() is called on every DRM session operation.
+    static sp<DrmSessionManager> drmSessionManager = [] {
+        sp<DrmSessionManager> manager = new DrmSessionManager();
+        manager->init();
+        return manager;
+    }();
     return drmSessionManager;
 }
 
@@ -143,14 +147,21 @@ void DrmSessionManager::addSession(int pid,
 void DrmSessionManager::useSession(const Vector<uint8_t> &sessionId) {
     ALOGV("useSession(%s)", GetSessionIdString(sessionId).string());
 
-    Mutex::Autolock lock(mLock);
-    auto it = mSessionMap.find(toStdVec(sessionId));
-    if (mService == NULL || it == mSessionMap.end()) {
-        return;
+    std::shared_ptr<IResourceManagerService> service;
+    SessionInfo info;
+    {
+        Mutex::Autolock lock(mLock);
+        auto it = mSessionMap.find(toStdVec(sessionId));
+        if (mService == NULL || it == mSessionMap.end()) {
+            return;
+        }
+        service = mService;
+        info = it->second;
     }
 
-    auto info = it->second;
-    mService->addResource(info.pid, info.uid, info.clientId, NULL, toResourceVec(sessionId, -1));
+    // useSession is called for every DRM operation; don't serialize all sessions
+    // on the binder call to the resource manager.
+    service->addResource(info.pid, info.uid, info.clientId, NULL, toResourceVec(sessionId, -1));
 }
 
 void DrmSessionManager::removeSession(const Vector<uint8_t> &sessionId) {
@@ -49,6 +49,7 @@ namespace android {
 #define CBLK_OVERRUN   0x100 // set by server immediately on input overrun, cleared by client
 #define CBLK_INTERRUPT 0x200 // set by client on interrupt(), cleared by client in obtainBuffer()
 #define CBLK_STREAM_END_DONE 0x400 // set by server on render completion, cleared by client
+#define CBLK_BUFFER_SIZE_AUTO 0x800 // set by client: server may adjust mBufferSizeInFrames
 
 //EL_FIXME 20 seconds may not be enough and must be reconciled with new obtainBuffer implementation
 #define MAX_RUN_OFFLOADED_TIMEOUT_MS 20000 // assuming up to a maximum of 20 seconds of offloaded
@@ -179,7 +180,8 @@ private:
                 // server write-only, client read
                 ExtendedTimestampQueue::Shared mExtendedTimestampQueue;
 
-                // This is set by AudioTrack.setBufferSizeInFrames().
+                // This is set by AudioTrack.setBufferSizeInFrames(),
+                // or by the server if CBLK_BUFFER_SIZE_AUTO is set.
                 // A write will not fill the buffer above this limit.
     volatile    uint32_t   mBufferSizeInFrames;  // effective size of the buffer
 
@@ -320,9 +322,16 @@ public:
         return mEpoch;
     }
 
-    uint32_t      getBufferSizeInFrames() const { return mBufferSizeInFrames; }
-    // See documentation for AudioTrack::setBufferSizeInFrames()
+    uint32_t      getBufferSizeInFrames() const {
+        // the server chooses the size in auto mode.
+        return mBufferSizeAuto
+                ? android_atomic_acquire_load((int32_t *)&mCblk->mBufferSizeInFrames)
+                : mBufferSizeInFrames;
+    }
+    // See documentation for AudioTrack::setBufferSizeInFrames(), also leaves auto mode.
     uint32_t      setBufferSizeInFrames(uint32_t requestedSize);
+    // See documentation for AudioTrack::setAutoBufferSize()
+    void          setBufferSizeAuto(bool enabled);
 
     status_t    getTimestamp(ExtendedTimestamp *timestamp) {
         if (timestamp == nullptr) {
@@ -340,8 +349,9 @@ public:
     virtual void stop() { }; // called by client in AudioTrack::stop()
 
 private:
-    // This is a copy of mCblk->mBufferSizeInFrames
+    // This is a copy of mCblk->mBufferSizeInFrames, unless mBufferSizeAuto
     uint32_t   mBufferSizeInFrames;  // effective size of the buffer
+    bool       mBufferSizeAuto = false; // copy of CBLK_BUFFER_SIZE_AUTO
 
     Modulo<uint32_t> mEpoch;
 
@@ -636,6 +646,11 @@ public:
     // Called on server side track start().
     virtual void        start();
 
+    // If the client enabled CBLK_BUFFER_SIZE_AUTO, adjusts the effective buffer size
+    // from each server request: desiredFrames wanted, underrun if none were available.
+    // Not multi-thread safe on server side, call from the thread calling obtainBuffer().
+    void                autoTuneBufferSize(size_t desiredFrames, bool underrun);
+
 private:
     AudioPlaybackRate             mPlaybackRate;  // last observed playback rate
     PlaybackRateQueue::Observer   mPlaybackRateObserver;
@@ -648,6 +663,11 @@ private:
     bool                          mUnderrunning;  // used to detect edge of underrun
 
     std::atomic<bool>             mDrained; // is the track buffer drained
+
+    // autoTuneBufferSize() state
+    size_t                        mAutoStepFrames = 0;  // largest request seen
+    bool                          mAutoUnderrunning = false;
+    int64_t                       mAutoNextShrinkNs = 0;
 };
 
 class StaticAudioTrackServerProxy : public AudioTrackServerProxy {
@@ -461,7 +461,7 @@ bool Accessor::Impl::BufferPool::handleReleaseBuffer(
                 iter->second->mTransactionCount == 0) {
             if (!iter->second->mInvalidated) {
                 mStats.onBufferUnused(iter->second->mAllocSize);
-                mFreeBuffers.insert(bufferId);
+                mFreeBuffers.push_back(bufferId);
             } else {
                 mStats.onBufferUnused(iter->second->mAllocSize);
                 mStats.onBufferEvicted(iter->second->mAllocSize);
@@ -550,7 +550,7 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
                 && bufferIter->second->mTransactionCount == 0) {
                 if (!bufferIter->second->mInvalidated) {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                    mFreeBuffers.insert(message.bufferId);
+                    mFreeBuffers.push_back(message.bufferId);
                 } else {
                     mStats.onBufferUnused(bufferIter->second->mAllocSize);
                     mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -570,7 +570,8 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
 }
 
 void Accessor::Impl::BufferPool::processStatusMessages() {
-    std::vector<BufferStatusMessage> messages;
+    // mStatusMessages keeps its capacity, so that this does not allocate in steady state.
+    std::vector<BufferStatusMessage> &messages = mStatusMessages;
     mObserver.getBufferStatusChanges(messages);
     mTimestampUs = getTimestampNow();
     for (BufferStatusMessage& message: messages) {
@@ -629,7 +630,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        mFreeBuffers.push_back(bufferId);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -659,7 +660,7 @@ bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
                     // TODO: handle freebuffer insert fail
                     if (!bufferIter->second->mInvalidated) {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
-                        mFreeBuffers.insert(bufferId);
+                        mFreeBuffers.push_back(bufferId);
                     } else {
                         mStats.onBufferUnused(bufferIter->second->mAllocSize);
                         mStats.onBufferEvicted(bufferIter->second->mAllocSize);
@@ -679,16 +680,17 @@ bool Accessor::Impl::BufferPool::getFreeBuffer(
         const std::shared_ptr<BufferPoolAllocator> &allocator,
         const std::vector<uint8_t> &params, BufferId *pId,
         const native_handle_t** handle) {
-    auto bufferIt = mFreeBuffers.begin();
-    for (;bufferIt != mFreeBuffers.end(); ++bufferIt) {
+    // Prefer the most recently freed buffer, which is the most likely to still be cached.
+    auto bufferIt = mFreeBuffers.rbegin();
+    for (;bufferIt != mFreeBuffers.rend(); ++bufferIt) {
         BufferId bufferId = *bufferIt;
         if (allocator->compatible(params, mBuffers[bufferId]->mConfig)) {
             break;
         }
     }
-    if (bufferIt != mFreeBuffers.end()) {
+    if (bufferIt != mFreeBuffers.rend()) {
         BufferId id = *bufferIt;
-        mFreeBuffers.erase(bufferIt);
+        mFreeBuffers.erase(std::next(bufferIt).base());
         mStats.onBufferRecycled(mBuffers[id]->mAllocSize);
         *handle = mBuffers[id]->handle();
         *pId = id;
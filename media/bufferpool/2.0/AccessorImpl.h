@@ -19,6 +19,7 @@
 
 #include <map>
 #include <set>
+#include <vector>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -114,8 +115,11 @@ private:
                 mTransactions;
 
         std::map<BufferId, std::unique_ptr<InternalBuffer>> mBuffers;
-        std::set<BufferId> mFreeBuffers;
+        // Buffers waiting to be recycled, in the order they were freed.
+        std::vector<BufferId> mFreeBuffers;
         std::set<ConnectionId> mConnectionIds;
+        // Buffer status messages being processed, kept to reuse the storage.
+        std::vector<BufferStatusMessage> mStatusMessages;
 
         struct Invalidation {
             static std::atomic<std::uint32_t> sInvSeqId;
@@ -26,6 +26,7 @@
 #include <hidl/LegacySupport.h>
 #include <hidl/Status.h>
 #include <unistd.h>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -47,6 +48,9 @@ constexpr static int kNumAllocationTest = 3;
 // Number of iteration for buffer recycling test.
 constexpr static int kNumRecycleTest = 3;
 
+// Number of iteration for buffer transfer latency test.
+constexpr static int kNumTransferLatencyTest = 1000;
+
 // media.bufferpool test setup
 class BufferpoolSingleTest : public ::testing::Test {
  public:
@@ -156,6 +160,38 @@ TEST_F(BufferpoolSingleTest, TransferBuffer) {
   ASSERT_TRUE(TestBufferPoolAllocator::Verify(recvHandle, 0x77));
 }
 
+// Buffer transfer latency test.
+// Measure the time to allocate a recycled buffer and transfer it,
+// which is paid for every buffer a codec sends.
+TEST_F(BufferpoolSingleTest, TransferLatency) {
+  description("average time of a recycled buffer allocation and transfer");
+  ResultStatus status;
+  std::vector<uint8_t> vecParams;
+  getTestAllocatorParams(&vecParams);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kNumTransferLatencyTest; ++i) {
+    std::shared_ptr<BufferPoolData> sbuffer, rbuffer;
+    native_handle_t *allocHandle = nullptr;
+    native_handle_t *recvHandle = nullptr;
+    TransactionId transactionId;
+    int64_t postUs;
+
+    status = mManager->allocate(mConnectionId, vecParams, &allocHandle, &sbuffer);
+    ASSERT_TRUE(status == ResultStatus::OK);
+    status = mManager->postSend(mReceiverId, sbuffer, &transactionId, &postUs);
+    ASSERT_TRUE(status == ResultStatus::OK);
+    status = mManager->receive(mReceiverId, transactionId, sbuffer->mId, postUs,
+                               &recvHandle, &rbuffer);
+    ASSERT_TRUE(status == ResultStatus::OK);
+    EXPECT_TRUE(rbuffer && rbuffer->mId == sbuffer->mId);
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double averageUs = elapsed.count() / kNumTransferLatencyTest;
+  RecordProperty("transferLatencyUs", std::to_string(averageUs));
+}
+
 }  // anonymous namespace
 
 int main(int argc, char** argv) {
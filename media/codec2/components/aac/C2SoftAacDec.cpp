@@ -18,6 +18,7 @@
 #define LOG_TAG "C2SoftAacDec"
 #include <log/log.h>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <math.h>
 #include <numeric>
@@ -112,6 +113,13 @@ public:
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 8192))
                 .build());
 
+        // The access units of a buffer are all decoded before the output delay ring buffer
+        // is drained, so they have to fit in it along with the decoder delay.
+        addParameter(
+                DefineParam(mMaxAccessUnits, C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS)
+                .withConstValue(new C2StreamMaxAccessUnitsInfo::input(0u, 4))
+                .build());
+
         addParameter(
                 DefineParam(mAacFormat, C2_PARAMKEY_AAC_PACKAGING)
                 .withDefault(new C2StreamAacFormatInfo::input(0u, C2Config::AAC_PACKAGING_RAW))
@@ -240,6 +248,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2StreamMaxAccessUnitsInfo::input> mMaxAccessUnits;
     std::shared_ptr<C2StreamAacFormatInfo::input> mAacFormat;
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamDrcCompressionModeTuning::input> mDrcCompressMode;
@@ -568,10 +577,16 @@ void C2SoftAacDec::process(
     C2ReadView view = mDummyReadView;
     size_t offset = 0u;
     size_t size = 0u;
+    std::shared_ptr<const C2StreamAccessUnitInfos::input> auInfos;
     if (!work->input.buffers.empty()) {
         view = work->input.buffers[0]->data().linearBlocks().front().map().get();
         size = view.capacity();
+        auInfos = std::static_pointer_cast<const C2StreamAccessUnitInfos::input>(
+                work->input.buffers[0]->getInfo(C2StreamAccessUnitInfos::input::PARAM_TYPE));
     }
+    // With several raw access units in the buffer, fill the decoder one access unit at a time.
+    size_t auIndex = 0u;
+    size_t auRemaining = 0u;
 
     bool eos = (work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0;
     bool codecConfig = (work->input.flags & C2FrameData::FLAG_CODEC_CONFIG) != 0;
@@ -664,6 +679,14 @@ void C2SoftAacDec::process(
             // const_cast because of libAACdec method signature.
             inBuffer[0] = const_cast<UCHAR *>(view.data() + offset);
             inBufferLength[0] = size;
+            if (auInfos) {
+                if (auRemaining == 0u && auIndex < auInfos->flexCount()) {
+                    auRemaining = auInfos->m.values[auIndex++].size;
+                }
+                if (auRemaining > 0u && auRemaining < size) {
+                    inBufferLength[0] = auRemaining;
+                }
+            }
         }
 
         // Fill and decode
@@ -727,6 +750,7 @@ void C2SoftAacDec::process(
         UINT inBufferUsedLength = inBufferLength[0] - bytesValid[0];
         size -= inBufferUsedLength;
         offset += inBufferUsedLength;
+        auRemaining -= std::min<size_t>(auRemaining, inBufferUsedLength);
 
         AAC_DECODER_ERROR decoderErr;
         do {
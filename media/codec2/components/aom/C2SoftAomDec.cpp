@@ -505,6 +505,21 @@ void C2SoftAomDec::process(const std::unique_ptr<C2Work>& work,
     }
 }
 
+static void copyPlane(uint8_t *dst, size_t dstStride, const uint8_t *src,
+        size_t srcStride, size_t width, size_t height) {
+    if (height == 0) return;
+    // Matching strides let the whole plane go out in a single copy.
+    if (srcStride == dstStride) {
+        memcpy(dst, src, srcStride * (height - 1) + width);
+        return;
+    }
+    for (size_t i = 0; i < height; ++i) {
+        memcpy(dst, src, width);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
 static void copyOutputBufferToYuvPlanarFrame(
         uint8_t *dst, const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV,
         size_t srcYStride, size_t srcUStride, size_t srcVStride,
@@ -512,25 +527,13 @@ static void copyOutputBufferToYuvPlanarFrame(
         uint32_t width, uint32_t height) {
     uint8_t* dstStart = dst;
 
-    for (size_t i = 0; i < height; ++i) {
-        memcpy(dst, srcY, width);
-        srcY += srcYStride;
-        dst += dstYStride;
-    }
+    copyPlane(dst, dstYStride, srcY, srcYStride, width, height);
 
     dst = dstStart + dstYStride * height;
-    for (size_t i = 0; i < height / 2; ++i) {
-         memcpy(dst, srcV, width / 2);
-        srcV += srcVStride;
-        dst += dstUVStride;
-    }
+    copyPlane(dst, dstUVStride, srcV, srcVStride, width / 2, height / 2);
 
     dst = dstStart + (dstYStride * height) + (dstUVStride * height / 2);
-    for (size_t i = 0; i < height / 2; ++i) {
-         memcpy(dst, srcU, width / 2);
-        srcU += srcUStride;
-        dst += dstUVStride;
-    }
+    copyPlane(dst, dstUVStride, srcU, srcUStride, width / 2, height / 2);
 }
 
 static void convertYUV420Planar16ToY410(uint32_t *dst,
@@ -22,6 +22,10 @@
 #include <media/stagefright/foundation/AMessage.h>
 
 #include <inttypes.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 #include <C2Config.h>
 #include <C2Debug.h>
@@ -132,6 +136,30 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
     }
 }
 
+void SimpleC2Component::OutputHandler::setComponent(
+        const std::shared_ptr<SimpleC2Component> &thiz) {
+    mThiz = thiz;
+}
+
+void SimpleC2Component::OutputHandler::onMessageReceived(const sp<AMessage> &msg) {
+    std::shared_ptr<SimpleC2Component> thiz = mThiz.lock();
+    if (!thiz) {
+        ALOGD("component not yet set; msg = %s", msg->debugString().c_str());
+        return;
+    }
+
+    switch (msg->what()) {
+        case kWhatDeliver: {
+            thiz->deliverQueuedWork();
+            break;
+        }
+        default: {
+            ALOGD("Unrecognized msg: %d", msg->what());
+            break;
+        }
+    }
+}
+
 class SimpleC2Component::BlockingBlockPool : public C2BlockPool {
 public:
     BlockingBlockPool(const std::shared_ptr<C2BlockPool>& base): mBase{base} {}
@@ -197,20 +225,28 @@ SimpleC2Component::SimpleC2Component(
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
       mLooper(new ALooper),
-      mHandler(new WorkHandler) {
+      mHandler(new WorkHandler),
+      mOutputLooper(new ALooper),
+      mOutputHandler(new OutputHandler) {
     mLooper->setName(intf->getName().c_str());
     (void)mLooper->registerHandler(mHandler);
     mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
+    mOutputLooper->setName((intf->getName() + "-out").c_str());
+    (void)mOutputLooper->registerHandler(mOutputHandler);
+    mOutputLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
 }
 
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    mOutputLooper->unregisterHandler(mOutputHandler->id());
+    (void)mOutputLooper->stop();
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
         const std::shared_ptr<C2Component::Listener> &listener, c2_blocking_t mayBlock) {
     mHandler->setComponent(shared_from_this());
+    mOutputHandler->setComponent(shared_from_this());
 
     Mutexed<ExecState>::Locked state(mExecState);
     if (state->mState == RUNNING) {
@@ -277,6 +313,7 @@ c2_status_t SimpleC2Component::flush_sm(
             queue->pending().erase(queue->pending().begin());
         }
     }
+    flushOutput(flushedWork);
 
     return C2_OK;
 }
@@ -343,6 +380,7 @@ c2_status_t SimpleC2Component::stop() {
     }
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatStop, mHandler))->postAndAwaitResponse(&reply);
+    waitForOutput();
     int32_t err;
     CHECK(reply->findInt32("err", &err));
     if (err != C2_OK) {
@@ -364,6 +402,7 @@ c2_status_t SimpleC2Component::reset() {
     }
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatReset, mHandler))->postAndAwaitResponse(&reply);
+    waitForOutput();
     return C2_OK;
 }
 
@@ -371,6 +410,7 @@ c2_status_t SimpleC2Component::release() {
     ALOGV("release");
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatRelease, mHandler))->postAndAwaitResponse(&reply);
+    waitForOutput();
     return C2_OK;
 }
 
@@ -388,6 +428,71 @@ std::list<std::unique_ptr<C2Work>> vec(std::unique_ptr<C2Work> &work) {
 
 }  // namespace
 
+void SimpleC2Component::deliverWork(std::unique_ptr<C2Work> work) {
+    const size_t depth = outputDepth();
+    if (depth == 0u) {
+        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
+        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        return;
+    }
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (queue->mWork.size() >= depth) {
+        queue.waitForCondition(queue->mDelivered);
+    }
+    const bool queueWasEmpty = queue->mWork.empty();
+    queue->mWork.push_back(std::move(work));
+    if (queueWasEmpty) {
+        (new AMessage(OutputHandler::kWhatDeliver, mOutputHandler))->post();
+    }
+}
+
+void SimpleC2Component::deliverQueuedWork() {
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (!queue->mWork.empty()) {
+        // Return everything that is waiting in one callback.
+        std::list<std::unique_ptr<C2Work>> items;
+        items.splice(items.end(), queue->mWork);
+        queue->mDelivering = true;
+        queue.unlock();
+
+        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
+        listener->onWorkDone_nb(shared_from_this(), std::move(items));
+
+        queue.lock();
+        queue->mDelivering = false;
+        queue->mDelivered.broadcast();
+    }
+}
+
+void SimpleC2Component::waitForOutput() {
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (!queue->mWork.empty() || queue->mDelivering) {
+        queue.waitForCondition(queue->mDelivered);
+    }
+}
+
+void SimpleC2Component::flushOutput(std::list<std::unique_ptr<C2Work>>* const flushedWork) {
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    // Finished work that has not been returned yet is flushed ahead of the
+    // work that was not processed, as it was queued before it.
+    flushedWork->splice(flushedWork->begin(), queue->mWork);
+    queue->mDelivered.broadcast();
+    // Work that is being returned can't be taken back, wait for it so that
+    // no callback comes after the flush.
+    while (queue->mDelivering) {
+        queue.waitForCondition(queue->mDelivered);
+    }
+}
+
+void SimpleC2Component::reportError(c2_status_t err) {
+    // The error must not overtake work finished before it.
+    waitForOutput();
+    Mutexed<ExecState>::Locked state(mExecState);
+    std::shared_ptr<C2Component::Listener> listener = state->mListener;
+    state.unlock();
+    listener->onError_nb(shared_from_this(), err);
+}
+
 void SimpleC2Component::finish(
         uint64_t frameIndex, std::function<void(const std::unique_ptr<C2Work> &)> fillWork) {
     std::unique_ptr<C2Work> work;
@@ -402,8 +507,7 @@ void SimpleC2Component::finish(
     }
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        deliverWork(std::move(work));
         ALOGV("returning pending work");
     }
 }
@@ -428,8 +532,7 @@ void SimpleC2Component::cloneAndSend(
     work->worklets.emplace_back(new C2Worklet);
     if (work) {
         fillWork(work);
-        std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        deliverWork(std::move(work));
         ALOGV("cloned and sending work");
     }
 }
@@ -500,10 +603,7 @@ bool SimpleC2Component::processQueue() {
             return err;
         }();
         if (err != C2_OK) {
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onError_nb(shared_from_this(), err);
+            reportError(err);
             return hasQueuedWork;
         }
     }
@@ -511,10 +611,7 @@ bool SimpleC2Component::processQueue() {
     if (!work) {
         c2_status_t err = drain(drainMode, mOutputBlockPool);
         if (err != C2_OK) {
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onError_nb(shared_from_this(), err);
+            reportError(err);
         }
         return hasQueuedWork;
     }
@@ -550,19 +647,13 @@ bool SimpleC2Component::processQueue() {
         work->result = C2_NOT_FOUND;
         queue.unlock();
 
-        Mutexed<ExecState>::Locked state(mExecState);
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        deliverWork(std::move(work));
         return hasQueuedWork;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
-        Mutexed<ExecState>::Locked state(mExecState);
         ALOGV("returning this work");
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        deliverWork(std::move(work));
     } else {
         ALOGV("queue pending work");
         work->input.buffers.clear();
@@ -579,10 +670,7 @@ bool SimpleC2Component::processQueue() {
         if (unexpected) {
             ALOGD("unexpected pending work");
             unexpected->result = C2_CORRUPTED;
-            Mutexed<ExecState>::Locked state(mExecState);
-            std::shared_ptr<C2Component::Listener> listener = state->mListener;
-            state.unlock();
-            listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
+            deliverWork(std::move(unexpected));
         }
     }
     return hasQueuedWork;
@@ -608,4 +696,35 @@ std::shared_ptr<C2Buffer> SimpleC2Component::createGraphicBuffer(
     return C2Buffer::CreateGraphicBuffer(block->share(crop, ::C2Fence()));
 }
 
+// static
+size_t SimpleC2Component::getCpuCoreCount() {
+    long cpuCoreCount = 1;
+    // Count the cores this process may run on rather than the online ones, so that a
+    // codec confined to a cpuset does not start threads it cannot run.
+    cpu_set_t cpuSet;
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+        cpuCoreCount = CPU_COUNT(&cpuSet);
+    } else {
+        cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (cpuCoreCount < 1) {
+        cpuCoreCount = 1;
+    }
+    ALOGV("Number of CPU cores: %ld", cpuCoreCount);
+    return (size_t)cpuCoreCount;
+}
+
+// static
+size_t SimpleC2Component::getNumThreadsForPictureSize(
+        uint32_t width, uint32_t height, size_t maxThreads) {
+    const uint64_t area = (uint64_t)width * height;
+    size_t numThreads = maxThreads;
+    if (area <= 352 * 288) {
+        numThreads = 1;
+    } else if (area <= 1280 * 720) {
+        numThreads = std::min<size_t>(2, maxThreads);
+    }
+    return std::max<size_t>(1, std::min(numThreads, getCpuCoreCount()));
+}
+
 } // namespace android
@@ -52,6 +52,7 @@ public:
 
     // for handler
     bool processQueue();
+    void deliverQueuedWork();
 
 protected:
     /**
@@ -107,6 +108,19 @@ protected:
             uint32_t drainMode,
             const std::shared_ptr<C2BlockPool> &pool) = 0;
 
+    /**
+     * Return the number of finished work items that may wait to be returned to the
+     * client while the component goes on processing.
+     *
+     * Finished work is returned to the listener from a separate thread, so that the
+     * listener callback, which usually crosses processes, overlaps with process(). Once
+     * this many items are waiting, finishing more work blocks until they are returned.
+     * Return 0 to return work from the processing thread instead.
+     */
+    virtual size_t outputDepth() const { return kDefaultOutputDepth; }
+
+    static constexpr size_t kDefaultOutputDepth = 4;
+
     // for derived classes
     /**
      * Finish pending work.
@@ -152,6 +166,20 @@ protected:
             const std::shared_ptr<C2GraphicBlock> &block,
             const C2Rect &crop);
 
+    /**
+     * Return the number of CPU cores this process may run on, which may be fewer than
+     * the online cores, e.g. in a background cpuset.
+     */
+    static size_t getCpuCoreCount();
+
+    /**
+     * Return the number of threads for a video codec working on |width| x |height|
+     * pictures. Small pictures do not have enough rows to keep several threads busy:
+     * 1 up to CIF, 2 up to 720p and |maxThreads| above, capped by getCpuCoreCount().
+     */
+    static size_t getNumThreadsForPictureSize(
+            uint32_t width, uint32_t height, size_t maxThreads);
+
     static constexpr uint32_t NO_DRAIN = ~0u;
 
     C2ReadView mDummyReadView;
@@ -235,6 +263,42 @@ private:
     };
     Mutexed<WorkQueue> mWorkQueue;
 
+    class OutputHandler : public AHandler {
+    public:
+        enum {
+            kWhatDeliver,
+        };
+
+        OutputHandler() = default;
+        ~OutputHandler() override = default;
+
+        void setComponent(const std::shared_ptr<SimpleC2Component> &thiz);
+
+    protected:
+        void onMessageReceived(const sp<AMessage> &msg) override;
+
+    private:
+        std::weak_ptr<SimpleC2Component> mThiz;
+    };
+
+    struct OutputQueue {
+        std::list<std::unique_ptr<C2Work>> mWork;   // finished work not yet returned
+        bool mDelivering = false;                   // work is being returned
+        Condition mDelivered;
+    };
+    Mutexed<OutputQueue> mOutputQueue;
+
+    sp<ALooper> mOutputLooper;
+    sp<OutputHandler> mOutputHandler;
+
+    // Returns finished work to the listener, in order.
+    void deliverWork(std::unique_ptr<C2Work> work);
+    // Waits until all finished work has been returned to the listener.
+    void waitForOutput();
+    // Moves finished work that has not been returned yet to |flushedWork|.
+    void flushOutput(std::list<std::unique_ptr<C2Work>>* const flushedWork);
+    void reportError(c2_status_t err);
+
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
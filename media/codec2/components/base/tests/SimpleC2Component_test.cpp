@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2Component_test"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+
+#include <SimpleC2Component.h>
+
+namespace android {
+
+namespace {
+
+class TestInterface : public C2ComponentInterface {
+public:
+    C2String getName() const override { return "c2.test.simple"; }
+    c2_node_id_t getId() const override { return 0; }
+    c2_status_t query_vb(
+            const std::vector<C2Param*> &, const std::vector<C2Param::Index> &,
+            c2_blocking_t, std::vector<std::unique_ptr<C2Param>>* const) const override {
+        return C2_BAD_INDEX;
+    }
+    c2_status_t config_vb(
+            const std::vector<C2Param*> &, c2_blocking_t,
+            std::vector<std::unique_ptr<C2SettingResult>>* const) override {
+        return C2_BAD_INDEX;
+    }
+    c2_status_t createTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t releaseTunnel_sm(c2_node_id_t) override { return C2_OMITTED; }
+    c2_status_t querySupportedParams_nb(
+            std::vector<std::shared_ptr<C2ParamDescriptor>> * const) const override {
+        return C2_OK;
+    }
+    c2_status_t querySupportedValues_vb(
+            std::vector<C2FieldSupportedValuesQuery> &, c2_blocking_t) const override {
+        return C2_OK;
+    }
+};
+
+// Finishes every work item right away, and tells when it starts processing
+// the work item with frame index |mBarrierIndex|.
+class TestComponent : public SimpleC2Component {
+public:
+    explicit TestComponent(uint64_t barrierIndex)
+        : SimpleC2Component(std::make_shared<TestInterface>()),
+          mBarrierIndex(barrierIndex) {
+    }
+
+    std::future<void> barrier() { return mBarrier.get_future(); }
+
+protected:
+    c2_status_t onInit() override { return C2_OK; }
+    c2_status_t onStop() override { return C2_OK; }
+    void onReset() override {}
+    void onRelease() override {}
+    c2_status_t onFlush_sm() override { return C2_OK; }
+    void process(const std::unique_ptr<C2Work> &work,
+                 const std::shared_ptr<C2BlockPool> &) override {
+        if (work->input.ordinal.frameIndex.peeku() == mBarrierIndex) {
+            mBarrier.set_value();
+        }
+        work->result = C2_OK;
+        work->workletsProcessed = 1u;
+    }
+    c2_status_t drain(uint32_t, const std::shared_ptr<C2BlockPool> &) override {
+        return C2_OK;
+    }
+
+private:
+    const uint64_t mBarrierIndex;
+    std::promise<void> mBarrier;
+};
+
+// Holds the first callback until release() is called, so that the work
+// finished meanwhile stays queued in the component.
+class TestListener : public C2Component::Listener {
+public:
+    void onWorkDone_nb(std::weak_ptr<C2Component>,
+                       std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::unique_lock<std::mutex> lock(mLock);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            mDone.insert(work->input.ordinal.frameIndex.peeku());
+        }
+        mCalled = true;
+        mCondition.notify_all();
+        mCondition.wait(lock, [this] { return mReleased; });
+    }
+    void onTripped_nb(std::weak_ptr<C2Component>,
+                      std::vector<std::shared_ptr<C2SettingResult>>) override {}
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t) override {}
+
+    void waitForCall() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mCalled; });
+    }
+    void release() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mReleased = true;
+        mCondition.notify_all();
+    }
+    std::set<uint64_t> done() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mDone;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mCalled = false;
+    bool mReleased = false;
+    std::set<uint64_t> mDone;
+};
+
+void queueWork(const std::shared_ptr<C2Component> &component, uint64_t frameIndex) {
+    std::list<std::unique_ptr<C2Work>> items;
+    items.emplace_back(new C2Work);
+    items.back()->input.ordinal.frameIndex = frameIndex;
+    items.back()->input.flags = (C2FrameData::flags_t)0;
+    ASSERT_EQ(C2_OK, component->queue_nb(&items));
+}
+
+}  // namespace
+
+// Work finished before a flush must be flushed, not returned after it.
+TEST(SimpleC2ComponentTest, FlushWithOutputPending) {
+    constexpr uint64_t kBarrierIndex = 4;
+    std::shared_ptr<TestComponent> component = std::make_shared<TestComponent>(kBarrierIndex);
+    std::shared_ptr<TestListener> listener = std::make_shared<TestListener>();
+    ASSERT_EQ(C2_OK, component->setListener_vb(listener, C2_MAY_BLOCK));
+    ASSERT_EQ(C2_OK, component->start());
+
+    // Work 0 is being returned, and the listener holds on to it.
+    queueWork(component, 0);
+    listener->waitForCall();
+
+    // Work 1 to 3 finish and wait to be returned. Work 4 is processed after them.
+    std::future<void> barrier = component->barrier();
+    for (uint64_t i = 1; i <= kBarrierIndex; ++i) {
+        queueWork(component, i);
+    }
+    barrier.wait();
+
+    std::list<std::unique_ptr<C2Work>> flushedWork;
+    std::future<c2_status_t> flushed = std::async(std::launch::async, [&] {
+        return component->flush_sm(C2Component::FLUSH_COMPONENT, &flushedWork);
+    });
+    // The flush waits for the callback in progress.
+    EXPECT_EQ(std::future_status::timeout, flushed.wait_for(std::chrono::milliseconds(100)));
+    listener->release();
+    ASSERT_EQ(C2_OK, flushed.get());
+
+    std::set<uint64_t> flushedIndices;
+    for (const std::unique_ptr<C2Work> &work : flushedWork) {
+        flushedIndices.insert(work->input.ordinal.frameIndex.peeku());
+    }
+    EXPECT_EQ(C2_OK, component->stop());
+    std::set<uint64_t> done = listener->done();
+
+    EXPECT_EQ(1u, done.count(0));
+    for (uint64_t i = 1; i < kBarrierIndex; ++i) {
+        EXPECT_EQ(1u, flushedIndices.count(i)) << "work " << i << " not flushed";
+        EXPECT_EQ(0u, done.count(i)) << "work " << i << " returned after the flush";
+    }
+    // Work 4 may have been processed during the flush, but is returned once.
+    EXPECT_EQ(1u, flushedIndices.count(kBarrierIndex) + done.count(kBarrierIndex));
+}
+
+}  // namespace android
@@ -286,6 +286,10 @@ public:
         return mColorAspects;
     }
 
+    std::shared_ptr<C2StreamPictureSizeInfo::output> getSize_l() {
+        return mSize;
+    }
+
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamPictureSizeInfo::output> mSize;
@@ -298,19 +302,6 @@ private:
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
 };
 
-static size_t getCpuCoreCount() {
-    long cpuCoreCount = 1;
-#if defined(_SC_NPROCESSORS_ONLN)
-    cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
-#else
-    // _SC_NPROC_ONLN must be defined...
-    cpuCoreCount = sysconf(_SC_NPROC_ONLN);
-#endif
-    CHECK(cpuCoreCount >= 1);
-    ALOGV("Number of CPU cores: %ld", cpuCoreCount);
-    return (size_t)cpuCoreCount;
-}
-
 static void *ivd_aligned_malloc(void *ctxt, WORD32 alignment, WORD32 size) {
     (void) ctxt;
     return memalign(alignment, size);
@@ -496,7 +487,12 @@ status_t C2SoftHevcDec::getVersion() {
 
 status_t C2SoftHevcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    {
+        // The stream has not been parsed yet, so go by the configured picture size.
+        IntfImpl::Lock lock = mIntf->lock();
+        std::shared_ptr<C2StreamPictureSizeInfo::output> size = mIntf->getSize_l();
+        mNumCores = getNumThreadsForPictureSize(size->width, size->height, MAX_NUM_CORES);
+    }
     mStride = ALIGN32(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -917,6 +913,10 @@ void C2SoftHevcDec::process(
                 mWidth = s_decode_op.u4_pic_wd;
                 mHeight = s_decode_op.u4_pic_ht;
                 CHECK_EQ(0u, s_decode_op.u4_output_present);
+                // Only the header is decoded so far: size the decoder threads by the new
+                // picture before its first frame, e.g. after a resolution change.
+                mNumCores = getNumThreadsForPictureSize(mWidth, mHeight, MAX_NUM_CORES);
+                (void) setNumCores();
 
                 C2StreamPictureSizeInfo::output size(0u, mWidth, mHeight);
                 std::vector<std::unique_ptr<C2SettingResult>> failures;
@@ -34,6 +34,9 @@ namespace android {
 namespace {
 
 constexpr char COMPONENT_NAME[] = "c2.android.opus.decoder";
+// Packets accepted in one input buffer. Each needs room for kMaxNumSamplesPerBuffer samples
+// in the output block.
+constexpr uint32_t kMaxAccessUnits = 8;
 
 }  // namespace
 
@@ -84,6 +87,11 @@ public:
                 DefineParam(mInputMaxBufSize, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE)
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 960 * 6))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnits, C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS)
+                .withConstValue(new C2StreamMaxAccessUnitsInfo::input(0u, kMaxAccessUnits))
+                .build());
     }
 
 private:
@@ -91,6 +99,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2StreamMaxAccessUnitsInfo::input> mMaxAccessUnits;
 };
 
 C2SoftOpusDec::C2SoftOpusDec(const char *name, c2_node_id_t id,
@@ -374,10 +383,33 @@ void C2SoftOpusDec::process(
     // other timestamp).
     if (work->input.ordinal.timestamp.peeku() == 0) mSamplesToDiscard = mCodecDelay;
 
+    // The buffer may hold several packets, described by the access unit infos; their
+    // output is decoded back to back into one block, timestamped with the first packet.
+    std::shared_ptr<const C2StreamAccessUnitInfos::input> auInfos =
+        std::static_pointer_cast<const C2StreamAccessUnitInfos::input>(
+                work->input.buffers[0]->getInfo(C2StreamAccessUnitInfos::input::PARAM_TYPE));
+    size_t numPackets = 1;
+    if (auInfos && auInfos->flexCount() > 1) {
+        numPackets = auInfos->flexCount();
+        size_t packetsSize = 0;
+        for (size_t i = 0; i < numPackets; ++i) {
+            packetsSize += auInfos->m.values[i].size;
+        }
+        if (numPackets > kMaxAccessUnits || packetsSize > inSize) {
+            ALOGE("invalid access unit infos: %zu packets of %zu bytes in %zu bytes",
+                  numPackets, packetsSize, inSize);
+            mSignalledError = true;
+            work->result = C2_BAD_VALUE;
+            return;
+        }
+    }
+
+    // Size the output for the stream's channel count rather than kMaxChannels; most
+    // streams are stereo, so this keeps each per-access-unit block a quarter the size.
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchLinearBlock(
-                          kMaxNumSamplesPerBuffer * kMaxChannels * sizeof(int16_t),
+                          numPackets * kMaxNumSamplesPerBuffer * mHeader.channels * sizeof(int16_t),
                           usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
@@ -391,18 +423,24 @@ void C2SoftOpusDec::process(
         return;
     }
 
-    int numSamples = opus_multistream_decode(mDecoder,
-                                             data,
-                                             inSize,
-                                             reinterpret_cast<int16_t *> (wView.data()),
-                                             kMaxOpusOutputPacketSizeSamples,
-                                             0);
-    if (numSamples < 0) {
-        ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
-        numSamples = 0;
-        mSignalledError = true;
-        work->result = C2_CORRUPTED;
-        return;
+    int numSamples = 0;
+    for (size_t i = 0; i < numPackets; ++i) {
+        const size_t packetSize = numPackets > 1 ? auInfos->m.values[i].size : inSize;
+        int packetSamples = opus_multistream_decode(mDecoder,
+                                                    data,
+                                                    packetSize,
+                                                    reinterpret_cast<int16_t *> (wView.data())
+                                                            + numSamples * mHeader.channels,
+                                                    kMaxOpusOutputPacketSizeSamples,
+                                                    0);
+        if (packetSamples < 0) {
+            ALOGE("opus_multistream_decode returned numSamples %d", packetSamples);
+            mSignalledError = true;
+            work->result = C2_CORRUPTED;
+            return;
+        }
+        numSamples += packetSamples;
+        data += packetSize;
     }
 
     int outOffset = 0;
@@ -31,21 +31,6 @@
 
 namespace android {
 
-#if 0
-static size_t getCpuCoreCount() {
-    long cpuCoreCount = 1;
-#if defined(_SC_NPROCESSORS_ONLN)
-    cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
-#else
-    // _SC_NPROC_ONLN must be defined...
-    cpuCoreCount = sysconf(_SC_NPROC_ONLN);
-#endif
-    CHECK(cpuCoreCount >= 1);
-    ALOGV("Number of CPU cores: %ld", cpuCoreCount);
-    return (size_t)cpuCoreCount;
-}
-#endif
-
 C2SoftVpxEnc::C2SoftVpxEnc(const char* name, c2_node_id_t id,
                            const std::shared_ptr<IntfImpl>& intfImpl)
     : SimpleC2Component(
@@ -158,8 +143,10 @@ status_t C2SoftVpxEnc::initEncoder() {
 
     mCodecConfiguration->g_w = mSize->width;
     mCodecConfiguration->g_h = mSize->height;
-    //mCodecConfiguration->g_threads = getCpuCoreCount();
-    mCodecConfiguration->g_threads = 0;
+    // Encoder threads split each frame by macroblock rows (VP8 token partitions, VP9
+    // tiles and row-mt), so they add no frame latency.
+    mCodecConfiguration->g_threads =
+            getNumThreadsForPictureSize(mSize->width, mSize->height, 4 /* maxThreads */);
     mCodecConfiguration->g_error_resilient = mErrorResilience;
 
     // timebase unit is microsecond
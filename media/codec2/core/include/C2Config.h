@@ -249,6 +249,10 @@ enum C2ParamIndexKind : C2Param::type_index_t {
 
     // low latency mode
     kParamIndexLowLatencyMode, // bool
+
+    // multiple access units in one input buffer
+    kParamIndexAccessUnitInfos, // struct[]
+    kParamIndexMaxAccessUnits, // u32
 };
 
 }
@@ -823,6 +827,46 @@ typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexLowLatencyMode>
         C2GlobalLowLatencyModeTuning;
 constexpr char C2_PARAMKEY_LOW_LATENCY_MODE[] = "algo.low-latency";
 
+/**
+ * Access units packed into a linear input buffer.
+ *
+ * Attached to an input buffer that holds more than one access unit. The access units are laid
+ * out back to back from the start of the buffer in decoding order, and each entry describes
+ * one of them. This lets a client queue many small access units (e.g. compressed audio frames)
+ * in one work item. The timestamp of the work is that of the first access unit.
+ *
+ * Components that do not support this info process the buffer as a single access unit, so
+ * clients shall only pack access units for components that support it.
+ */
+struct C2AccessUnitInfosStruct {
+    inline C2AccessUnitInfosStruct() = default;
+    inline C2AccessUnitInfosStruct(uint32_t flags_, uint32_t size_, int64_t timestamp_)
+        : flags(flags_), size(size_), timestamp(timestamp_) { }
+
+    uint32_t flags;     ///< C2FrameData::flags_t of the access unit
+    uint32_t size;      ///< size of the access unit in bytes
+    int64_t timestamp;  ///< timestamp of the access unit
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(AccessUnitInfos)
+    C2FIELD(flags, "flags")
+    C2FIELD(size, "size")
+    C2FIELD(timestamp, "timestamp")
+};
+
+typedef C2StreamParam<C2Info, C2SimpleArrayStruct<C2AccessUnitInfosStruct>,
+        kParamIndexAccessUnitInfos> C2StreamAccessUnitInfos;
+constexpr char C2_PARAMKEY_INPUT_ACCESS_UNIT_INFOS[] = "input.access-unit-infos";
+
+/**
+ * Maximum number of access units the component accepts in one input buffer.
+ *
+ * Components that accept C2StreamAccessUnitInfos declare this. Clients shall not pack more
+ * access units than this into one buffer.
+ */
+typedef C2StreamParam<C2Info, C2Uint32Value, kParamIndexMaxAccessUnits>
+        C2StreamMaxAccessUnitsInfo;
+constexpr char C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS[] = "input.access-units.max-count";
+
 /**
  * Reference characteristics.
  *
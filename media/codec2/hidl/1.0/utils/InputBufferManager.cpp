@@ -306,7 +306,9 @@ void InputBufferManager::_onBufferDestroyed(const C2Buffer* buf, void* arg) {
 
     DeathNotifications &deathNotifications = mDeathNotifications[bufferId->listener];
     deathNotifications.indices[bufferId->frameIndex].emplace_back(bufferId->bufferIndex);
-    ++deathNotifications.count;
+    if (deathNotifications.count++ == 0) {
+        deathNotifications.firstPendingNs = systemTime();
+    }
     mOnBufferDestroyed.notify_one();
 
     mTrackedBufferCache.erase(bufferId);
@@ -369,6 +371,37 @@ bool InputBufferManager::processNotifications(nsecs_t* timeToRetryNs) {
                 continue;
             }
 
+            // If the listener still has many buffers in flight, wait for more
+            // of them to be released so they can be sent in one callback, but
+            // not for longer than kMaxNotificationDelayNs.
+            nsecs_t timeSinceFirstPendingNs =
+                    timeNowNs - deathNotifications.firstPendingNs;
+            if (notificationIntervalNs > 0 &&
+                    timeSinceFirstPendingNs < kMaxNotificationDelayNs) {
+                size_t numTracked = 0;
+                auto findListener = mTrackedBuffersMap.find(it->first);
+                if (findListener != mTrackedBuffersMap.end()) {
+                    for (const std::pair<const uint64_t,
+                                         std::set<TrackedBuffer*>>& p :
+                            findListener->second) {
+                        numTracked += p.second.size();
+                    }
+                }
+                if (deathNotifications.count < numTracked) {
+                    retry = true;
+                    *timeToRetryNs = std::min(*timeToRetryNs,
+                            kMaxNotificationDelayNs - timeSinceFirstPendingNs);
+                    LOG(VERBOSE) << "InputBufferManager::processNotifications -- "
+                                 << "Notifications for listener @ "
+                                     << std::hex << listener.get()
+                                 << " will be batched (" << std::dec
+                                 << deathNotifications.count << " pending, "
+                                 << numTracked << " tracked).";
+                    ++it;
+                    continue;
+                }
+            }
+
             // Create the argument for the callback.
             notifications.emplace_back(listener, deathNotifications.count);
             hidl_vec<IComponentListener::InputBuffer> &inputBuffers =
@@ -410,6 +443,8 @@ bool InputBufferManager::processNotifications(nsecs_t* timeToRetryNs) {
                                           << notification.listener.get()
                        << std::dec << ".";
         } else {
+            ++mNumCallbacksSent;
+            mNumBuffersNotified += notification.inputBuffers.size();
 #if LOG_NDEBUG == 0
             std::stringstream inputBufferLog;
             for (const IComponentListener::InputBuffer& inputBuffer :
@@ -428,6 +463,18 @@ bool InputBufferManager::processNotifications(nsecs_t* timeToRetryNs) {
 #endif
         }
     }
+    nsecs_t timeNowNs = systemTime();
+    if (timeNowNs - mStatsStartNs >= 1000000000LL /* 1s */) {
+        if (mNumCallbacksSent > 0) {
+            LOG(VERBOSE) << "InputBufferManager::processNotifications -- "
+                         << mNumCallbacksSent << " callbacks for "
+                         << mNumBuffersNotified << " buffers in the last "
+                         << (timeNowNs - mStatsStartNs) / 1000000 << "ms.";
+        }
+        mNumCallbacksSent = 0;
+        mNumBuffersNotified = 0;
+        mStatsStartNs = timeNowNs;
+    }
 #if LOG_NDEBUG == 0
     if (retry) {
         LOG(VERBOSE) << "InputBufferManager::processNotifications -- "
@@ -74,6 +74,12 @@ using namespace ::android;
  * configurable via calling setNotificationInterval(). The default value of
  * mNotificationIntervalNs is kDefaultNotificationInternalNs.
  *
+ * In addition, notifications for a listener are held back while fewer than
+ * half of its in-flight buffers (pending plus still tracked) have been
+ * released, so that a deep pipeline is notified in larger batches. A pending
+ * notification is never held back for more than kMaxNotificationDelayNs
+ * nanoseconds, and batching is disabled if mNotificationIntervalNs is 0.
+ *
  * Public Member Functions
  * -----------------------
  *
@@ -99,6 +105,11 @@ struct InputBufferManager {
      */
     static constexpr nsecs_t kDefaultNotificationIntervalNs = 1000000; /* 1ms */
 
+    /**
+     * The maximum time a pending notification may be held back for batching.
+     */
+    static constexpr nsecs_t kMaxNotificationDelayNs = 4000000; /* 4ms */
+
     /**
      * Track all buffers in a C2FrameData object.
      *
@@ -225,6 +236,10 @@ private:
         // count = 0.
         nsecs_t lastSentNs;
 
+        // The time at which count last went from 0 to 1. This bounds how long
+        // pending notifications can be held back for batching.
+        nsecs_t firstPendingNs;
+
         // Map: frameIndex -> vector of bufferIndices
         // This is essentially a collection of (framdeIndex, bufferIndex).
         std::map<uint64_t, std::vector<size_t>> indices;
@@ -233,6 +248,7 @@ private:
                 nsecs_t notificationIntervalNs = kDefaultNotificationIntervalNs)
               : count(0),
                 lastSentNs(systemTime() - notificationIntervalNs),
+                firstPendingNs(0),
                 indices() {}
     };
 
@@ -272,6 +288,12 @@ private:
     // retrying if some destructions have not been notified.
     bool processNotifications(nsecs_t* timeToRetryNs);
 
+    // Statistics on sent notifications, only accessed from mMainThread.
+    // These are logged and reset about once per second.
+    size_t mNumCallbacksSent{0};
+    size_t mNumBuffersNotified{0};
+    nsecs_t mStatsStartNs{0};
+
     // Main function for the input buffer manager thread.
     void main();
 
@@ -534,6 +534,9 @@ struct CCodec::ClientListener : public Codec2Client::Listener {
             }
         }
 
+        // The component store may come back with different components.
+        CCodecConfig::InvalidateParamSchemas();
+
         // Report to MediaCodec.
         sp<CCodec> codec(mCodec.promote());
         if (!codec || !codec->mCallback) {
@@ -208,6 +208,33 @@ status_t CCodecBufferChannel::queueInputBufferInternal(sp<MediaCodecBuffer> buff
     if (buffer->meta()->findInt32("csd", &tmp) && tmp) {
         flags |= C2FrameData::FLAG_CODEC_CONFIG;
     }
+    // Several access units packed into the buffer, described by an array of
+    // MediaCodec::AccessUnitInfo.
+    std::shared_ptr<C2StreamAccessUnitInfos::input> auInfos;
+    sp<ABuffer> auInfosBuffer;
+    if (buffer->meta()->findBuffer("access-unit-infos", &auInfosBuffer)
+            && auInfosBuffer != nullptr && auInfosBuffer->size() > 0u) {
+        if (auInfosBuffer->size() % sizeof(MediaCodec::AccessUnitInfo) != 0u) {
+            ALOGW("[%s] queueInputBuffer: malformed access unit infos (%zu bytes) ignored",
+                  mName, auInfosBuffer->size());
+        } else {
+            const size_t count = auInfosBuffer->size() / sizeof(MediaCodec::AccessUnitInfo);
+            const MediaCodec::AccessUnitInfo *infos =
+                (const MediaCodec::AccessUnitInfo *)auInfosBuffer->data();
+            auInfos = C2StreamAccessUnitInfos::input::AllocShared(count, 0u);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t auFlags = 0;
+                if (infos[i].flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) {
+                    auFlags |= C2FrameData::FLAG_CODEC_CONFIG;
+                }
+                if (infos[i].flags & MediaCodec::BUFFER_FLAG_EOS) {
+                    auFlags |= C2FrameData::FLAG_END_OF_STREAM;
+                }
+                auInfos->m.values[i] = C2AccessUnitInfosStruct(
+                        auFlags, infos[i].size, infos[i].timeUs);
+            }
+        }
+    }
     ALOGV("[%s] queueInputBuffer: buffer->size() = %zu", mName, buffer->size());
     std::unique_ptr<C2Work> work(new C2Work);
     work->input.ordinal.timestamp = timeUs;
@@ -245,6 +272,9 @@ status_t CCodecBufferChannel::queueInputBufferInternal(sp<MediaCodecBuffer> buff
                       "buffer starvation on component.", mName);
             }
         }
+        if (auInfos) {
+            c2buffer->setInfo(auInfos);
+        }
         work->input.buffers.push_back(c2buffer);
         queuedBuffers.push_back(c2buffer);
     } else if (eos) {
@@ -1340,7 +1370,17 @@ void CCodecBufferChannel::stop() {
     if (mInputSurface != nullptr) {
         mInputSurface.reset();
     }
-    mPipelineWatcher.lock()->flush();
+    Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
+    if (watcher->latency(100) != PipelineWatcher::Clock::duration::zero()) {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        ALOGI("[%s] pipeline latency p50=%lldus p99=%lldus, slack %u",
+              mName,
+              (long long)duration_cast<microseconds>(watcher->latency(50)).count(),
+              (long long)duration_cast<microseconds>(watcher->latency(99)).count(),
+              watcher->slack());
+    }
+    watcher->flush();
 }
 
 void CCodecBufferChannel::reset() {
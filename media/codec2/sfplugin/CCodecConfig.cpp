@@ -24,6 +24,7 @@
 #include <util/C2InterfaceHelper.h>
 
 #include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/foundation/Mutexed.h>
 
 #include "CCodecConfig.h"
 #include "Codec2Mapper.h"
@@ -240,9 +241,8 @@ struct StandardParams {
     const std::vector<ConfigMapper> &getConfigMappersForSdkKey(std::string key) const {
         auto it = mConfigMappers.find(key);
         if (it == mConfigMappers.end()) {
-            if (mComplained.count(key) == 0) {
+            if (mComplained.lock()->insert(key).second) {
                 ALOGD("no c2 equivalents for %s", key.c_str());
-                mComplained.insert(key);
             }
             return NO_MAPPERS;
         }
@@ -312,11 +312,94 @@ struct StandardParams {
 
 private:
     std::map<SdkKey, std::vector<ConfigMapper>> mConfigMappers;
-    mutable std::set<std::string> mComplained;
+    mutable Mutexed<std::set<std::string>> mComplained;
 };
 
 const std::vector<ConfigMapper> StandardParams::NO_MAPPERS;
 
+namespace {
+
+/**
+ * Structure of the parameters of a component: its supported parameter descriptors, the
+ * reflected structures of those parameters and the standard SDK mappings for its media type.
+ *
+ * These do not change for a given component name, so they are shared by all CCodecConfig
+ * instances for that component, and only the parameter values are queried per instance.
+ */
+struct ParamSchema {
+    struct Descs {
+        std::vector<std::shared_ptr<C2ParamDescriptor>> paramDescs;
+        std::shared_ptr<StandardParams> standardParams;  ///< nullptr until initialized
+    };
+    Mutexed<Descs> descs;
+
+    /// reflected structures by core index, nullptr if the structure could not be described
+    Mutexed<std::map<uint32_t, std::shared_ptr<const C2StructDescriptor>>> structDescs;
+
+    static std::shared_ptr<ParamSchema> Get(const std::string &componentName) {
+        Mutexed<SchemaMap>::Locked schemas(Schemas());
+        std::shared_ptr<ParamSchema> &schema = (*schemas)[componentName];
+        if (!schema) {
+            schema = std::make_shared<ParamSchema>();
+        }
+        return schema;
+    }
+
+    static void InvalidateAll() {
+        Schemas().lock()->clear();
+    }
+
+private:
+    typedef std::map<std::string, std::shared_ptr<ParamSchema>> SchemaMap;
+
+    static Mutexed<SchemaMap> &Schemas() {
+        static Mutexed<SchemaMap> sSchemas;
+        return sSchemas;
+    }
+};
+
+/**
+ * Reflector that describes each structure at most once per component name, falling back to
+ * the component store's reflector for structures not yet described.
+ */
+class CachingParamReflector : public C2ParamReflector {
+public:
+    CachingParamReflector(
+            const std::shared_ptr<C2ParamReflector> &reflector,
+            const std::shared_ptr<ParamSchema> &schema)
+        : mReflector(reflector), mSchema(schema) { }
+
+    virtual ~CachingParamReflector() override = default;
+
+    virtual std::unique_ptr<C2StructDescriptor> describe(
+            C2Param::CoreIndex coreIndex) const override {
+        std::shared_ptr<const C2StructDescriptor> desc;
+        {
+            Mutexed<std::map<uint32_t, std::shared_ptr<const C2StructDescriptor>>>::Locked
+                structDescs(mSchema->structDescs);
+            auto it = structDescs->find(coreIndex.coreIndex());
+            if (it != structDescs->end()) {
+                desc = it->second;
+                return desc ? std::make_unique<C2StructDescriptor>(*desc) : nullptr;
+            }
+        }
+        desc = mReflector->describe(coreIndex);
+        mSchema->structDescs.lock()->emplace(coreIndex.coreIndex(), desc);
+        return desc ? std::make_unique<C2StructDescriptor>(*desc) : nullptr;
+    }
+
+private:
+    std::shared_ptr<C2ParamReflector> mReflector;
+    std::shared_ptr<ParamSchema> mSchema;
+};
+
+}  // namespace
+
+// static
+void CCodecConfig::InvalidateParamSchemas() {
+    ParamSchema::InvalidateAll();
+}
+
 
 CCodecConfig::CCodecConfig()
     : mInputFormat(new AMessage),
@@ -384,6 +467,8 @@ void CCodecConfig::initializeStandardParams() {
 
     add(ConfigMapper(KEY_MAX_INPUT_SIZE, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE, "value")
         .limitTo(D::INPUT));
+    add(ConfigMapper("max-access-units", C2_PARAMKEY_INPUT_MAX_ACCESS_UNITS, "value")
+        .limitTo(D::AUDIO & D::DECODER & D::INPUT & D::READ));
     // remove when codecs switch to PARAMKEY
     deprecated(ConfigMapper(KEY_MAX_INPUT_SIZE, "coded.max-frame-size", "value")
                .limitTo(D::INPUT));
@@ -974,21 +1059,33 @@ status_t CCodecConfig::initialize(
         mCodingMediaType = "";
     }
 
-    c2err = configurable->querySupportedParams(&mParamDescs);
-    if (c2err != C2_OK) {
-        ALOGD("Query supported params failed after returning %zu values => %s",
-                mParamDescs.size(), asString(c2err));
-        return UNKNOWN_ERROR;
+    // the parameter structure is only queried for the first instance of a component
+    std::shared_ptr<ParamSchema> schema = ParamSchema::Get(configurable->getName());
+    std::shared_ptr<StandardParams> standardParams;
+    {
+        Mutexed<ParamSchema::Descs>::Locked descs(schema->descs);
+        if (descs->standardParams) {
+            mParamDescs = descs->paramDescs;
+            standardParams = descs->standardParams;
+        }
+    }
+    if (!standardParams) {
+        c2err = configurable->querySupportedParams(&mParamDescs);
+        if (c2err != C2_OK) {
+            ALOGD("Query supported params failed after returning %zu values => %s",
+                    mParamDescs.size(), asString(c2err));
+            return UNKNOWN_ERROR;
+        }
     }
     for (const std::shared_ptr<C2ParamDescriptor> &desc : mParamDescs) {
         mSupportedIndices.emplace(desc->index());
     }
 
-    mReflector = reflector;
-    if (mReflector == nullptr) {
+    if (reflector == nullptr) {
         ALOGE("Null param reflector");
         return UNKNOWN_ERROR;
     }
+    mReflector = std::make_shared<CachingParamReflector>(reflector, schema);
 
     // enumerate all fields
     mParamUpdater = std::make_shared<ReflectedParamUpdater>();
@@ -1019,7 +1116,16 @@ status_t CCodecConfig::initialize(
         }
     }
 
-    initializeStandardParams();
+    if (standardParams) {
+        mStandardParams = standardParams;
+    } else {
+        initializeStandardParams();
+        Mutexed<ParamSchema::Descs>::Locked descs(schema->descs);
+        if (!descs->standardParams) {
+            descs->paramDescs = mParamDescs;
+            descs->standardParams = mStandardParams;
+        }
+    }
 
     // subscribe to all supported standard (exposed) params
     // TODO: limit this to params that are actually in the domain
@@ -143,6 +143,10 @@ struct CCodecConfig {
 
     CCodecConfig();
 
+    /// Drops the parameter structures cached per component name, e.g. after the component
+    /// store has changed.
+    static void InvalidateParamSchemas();
+
     /// initializes the members required to manage the format: descriptors, reflector,
     /// reflected param helper, domain, standard params, and subscribes to standard
     /// indices.
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PipelineWatcher"
 
+#include <algorithm>
 #include <numeric>
 
 #include <log/log.h>
@@ -42,6 +43,8 @@ PipelineWatcher &PipelineWatcher::outputDelay(uint32_t value) {
 
 PipelineWatcher &PipelineWatcher::smoothnessFactor(uint32_t value) {
     mSmoothnessFactor = value;
+    mSlack = value;
+    mFramesSinceStarved = 0;
     return *this;
 }
 
@@ -60,6 +63,7 @@ void PipelineWatcher::onWorkQueued(
         (void)mFramesInPipeline.erase(it);
     }
     (void)mFramesInPipeline.try_emplace(frameIndex, std::move(buffers), queuedAt);
+    mInputWithheld = false;
 }
 
 std::shared_ptr<C2Buffer> PipelineWatcher::onInputBufferReleased(
@@ -91,17 +95,53 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
               (unsigned long long)frameIndex);
         return;
     }
+    Clock::duration latency = Clock::now() - it->second.queuedAt;
+    if (mLatencies.size() < kLatencySamples) {
+        mLatencies.push_back(latency);
+    } else {
+        mLatencies[mNextLatency] = latency;
+    }
+    mNextLatency = (mNextLatency + 1) % kLatencySamples;
     (void)mFramesInPipeline.erase(it);
+
+    // If input was withheld and the component has no input left to work on,
+    // the slack was too small to keep it busy.
+    bool inputsPending = std::any_of(
+            mFramesInPipeline.begin(),
+            mFramesInPipeline.end(),
+            [](const decltype(mFramesInPipeline)::value_type &value) {
+                for (const std::shared_ptr<C2Buffer> &buffer : value.second.buffers) {
+                    if (buffer) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+    if (mInputWithheld && !inputsPending) {
+        if (mSlack < mSmoothnessFactor) {
+            ++mSlack;
+            ALOGV("onWorkDone: component starved; slack raised to %u", mSlack);
+        }
+        mFramesSinceStarved = 0;
+    } else if (++mFramesSinceStarved >= kFramesToShrinkSlack) {
+        if (mSlack > 0) {
+            --mSlack;
+            ALOGV("onWorkDone: slack lowered to %u", mSlack);
+        }
+        mFramesSinceStarved = 0;
+    }
 }
 
 void PipelineWatcher::flush() {
     mFramesInPipeline.clear();
+    mInputWithheld = false;
 }
 
 bool PipelineWatcher::pipelineFull() const {
     if (mFramesInPipeline.size() >=
-            mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
+            mInputDelay + mPipelineDelay + mOutputDelay + mSlack) {
         ALOGV("pipelineFull: too many frames in pipeline (%zu)", mFramesInPipeline.size());
+        mInputWithheld = true;
         return true;
     }
     size_t sizeWithInputReleased = std::count_if(
@@ -116,16 +156,18 @@ bool PipelineWatcher::pipelineFull() const {
                 return true;
             });
     if (sizeWithInputReleased >=
-            mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
+            mPipelineDelay + mOutputDelay + mSlack) {
         ALOGV("pipelineFull: too many frames in pipeline, with input released (%zu)",
               sizeWithInputReleased);
+        mInputWithheld = true;
         return true;
     }
 
     size_t sizeWithInputsPending = mFramesInPipeline.size() - sizeWithInputReleased;
-    if (sizeWithInputsPending > mPipelineDelay + mInputDelay + mSmoothnessFactor) {
+    if (sizeWithInputsPending > mPipelineDelay + mInputDelay + mSlack) {
         ALOGV("pipelineFull: too many inputs pending (%zu) in pipeline, with inputs released (%zu)",
               sizeWithInputsPending, sizeWithInputReleased);
+        mInputWithheld = true;
         return true;
     }
     ALOGV("pipeline has room (total: %zu, input released: %zu)",
@@ -151,4 +193,14 @@ PipelineWatcher::Clock::duration PipelineWatcher::elapsed(
     return durations[n];
 }
 
+PipelineWatcher::Clock::duration PipelineWatcher::latency(uint32_t percent) const {
+    if (mLatencies.empty()) {
+        return Clock::duration::zero();
+    }
+    std::vector<Clock::duration> latencies(mLatencies);
+    size_t n = std::min(latencies.size() - 1, latencies.size() * percent / 100);
+    std::nth_element(latencies.begin(), latencies.begin() + n, latencies.end());
+    return latencies[n];
+}
+
 }  // namespace android
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <C2Work.h>
 
@@ -37,7 +38,11 @@ public:
         : mInputDelay(0),
           mPipelineDelay(0),
           mOutputDelay(0),
-          mSmoothnessFactor(0) {}
+          mSmoothnessFactor(0),
+          mSlack(0),
+          mInputWithheld(false),
+          mFramesSinceStarved(0),
+          mNextLatency(0) {}
     ~PipelineWatcher() = default;
 
     /**
@@ -59,6 +64,10 @@ public:
     PipelineWatcher &outputDelay(uint32_t value);
 
     /**
+     * The smoothness factor is the most extra work items allowed in the
+     * pipeline. The watcher starts with all of it, then shrinks it while the
+     * component never runs out of input, and grows it back when it does.
+     *
      * \param value the new smoothness factor value
      * \return  this object
      */
@@ -117,11 +126,38 @@ public:
      */
     Clock::duration elapsed(const Clock::time_point &now, size_t n) const;
 
+    /**
+     * Return a percentile of the processing time of recently finished work
+     * items, from queued to done.
+     *
+     * \param percent  percentile, in the range [0, 100]
+     * \return  processing time, or zero if no work item has finished yet.
+     */
+    Clock::duration latency(uint32_t percent) const;
+
+    /**
+     * \return  the portion of the smoothness factor currently in use.
+     */
+    uint32_t slack() const { return mSlack; }
+
 private:
+    // the slack shrinks by one after this many work items without starving
+    // the component
+    static constexpr uint32_t kFramesToShrinkSlack = 64;
+    // number of recent work items kept for latency()
+    static constexpr size_t kLatencySamples = 128;
+
     uint32_t mInputDelay;
     uint32_t mPipelineDelay;
     uint32_t mOutputDelay;
     uint32_t mSmoothnessFactor;
+    uint32_t mSlack;  // in [0, mSmoothnessFactor]
+    // pipelineFull() returned true since the last queued work item
+    mutable bool mInputWithheld;
+    uint32_t mFramesSinceStarved;
+
+    std::vector<Clock::duration> mLatencies;  // ring of kLatencySamples
+    size_t mNextLatency;
 
     struct Frame {
         Frame(std::vector<std::shared_ptr<C2Buffer>> &&b,
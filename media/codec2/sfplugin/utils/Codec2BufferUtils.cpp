@@ -64,30 +64,64 @@ struct MemCopier<false, S> {
  */
 template<bool ToMediaImage, typename View, typename ImagePixel>
 static status_t _ImageCopy(View &view, const MediaImage2 *img, ImagePixel *imgBase) {
-    // TODO: more efficient copying --- e.g. copy interleaved planes together, etc.
     const C2PlanarLayout &layout = view.layout();
     const size_t bpp = divUp(img->mBitDepthAllocated, 8u);
 
+    auto isPlaneSupported = [&layout, img, bpp](uint32_t i) {
+        const C2PlaneInfo &plane = layout.planes[i];
+        return plane.colSampling == img->mPlane[i].mHorizSubsampling
+                && plane.rowSampling == img->mPlane[i].mVertSubsampling
+                && plane.allocatedDepth == img->mBitDepthAllocated
+                && plane.allocatedDepth >= plane.bitDepth
+                // MediaImage only supports MSB values
+                && plane.rightShift == plane.allocatedDepth - plane.bitDepth
+                && (bpp == 1 || plane.endianness == plane.NATIVE);
+    };
+
     for (uint32_t i = 0; i < layout.numPlanes; ++i) {
         typename std::conditional<ToMediaImage, uint8_t, const uint8_t>::type *imgRow =
             imgBase + img->mPlane[i].mOffset;
         typename std::conditional<ToMediaImage, const uint8_t, uint8_t>::type *viewRow =
             viewRow = view.data()[i];
         const C2PlaneInfo &plane = layout.planes[i];
-        if (plane.colSampling != img->mPlane[i].mHorizSubsampling
-                || plane.rowSampling != img->mPlane[i].mVertSubsampling
-                || plane.allocatedDepth != img->mBitDepthAllocated
-                || plane.allocatedDepth < plane.bitDepth
-                // MediaImage only supports MSB values
-                || plane.rightShift != plane.allocatedDepth - plane.bitDepth
-                || (bpp > 1 && plane.endianness != plane.NATIVE)) {
+        if (!isPlaneSupported(i)) {
             return BAD_VALUE;
         }
 
         uint32_t planeW = img->mWidth / plane.colSampling;
         uint32_t planeH = img->mHeight / plane.rowSampling;
 
-        bool canCopyByRow = (plane.colInc == 1) && (img->mPlane[i].mColInc == 1);
+        // Two planes interleaved the same way on both sides (e.g. the chroma of NV12/NV21 or
+        // P010) are copied together by row, instead of pixel by pixel for each plane.
+        if (i + 1 < layout.numPlanes
+                && plane.colInc == 2 * bpp && img->mPlane[i].mColInc == 2 * bpp
+                && layout.planes[i + 1].colInc == plane.colInc
+                && img->mPlane[i + 1].mColInc == img->mPlane[i].mColInc
+                && layout.planes[i + 1].rowInc == plane.rowInc
+                && img->mPlane[i + 1].mRowInc == img->mPlane[i].mRowInc
+                && layout.planes[i + 1].colSampling == plane.colSampling
+                && layout.planes[i + 1].rowSampling == plane.rowSampling
+                && isPlaneSupported(i + 1)) {
+            const ptrdiff_t viewDelta = view.data()[i + 1] - view.data()[i];
+            const ptrdiff_t imgDelta =
+                    (ptrdiff_t)img->mPlane[i + 1].mOffset - (ptrdiff_t)img->mPlane[i].mOffset;
+            if ((viewDelta == (ptrdiff_t)bpp || viewDelta == -(ptrdiff_t)bpp)
+                    && imgDelta == viewDelta) {
+                if (viewDelta < 0) {
+                    imgRow += imgDelta;
+                    viewRow += viewDelta;
+                }
+                for (uint32_t row = 0; row < planeH; ++row) {
+                    MemCopier<ToMediaImage, 0>::copy(imgRow, viewRow, planeW * 2 * bpp);
+                    imgRow += img->mPlane[i].mRowInc;
+                    viewRow += plane.rowInc;
+                }
+                ++i;
+                continue;
+            }
+        }
+
+        bool canCopyByRow = (plane.colInc == bpp) && (img->mPlane[i].mColInc == bpp);
         bool canCopyByPlane = canCopyByRow && (plane.rowInc == img->mPlane[i].mRowInc);
         if (canCopyByPlane) {
             MemCopier<ToMediaImage, 0>::copy(imgRow, viewRow, plane.rowInc * planeH);
@@ -20,6 +20,9 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "FLACExtractor.h"
 // libFLAC parser
 #include "FLAC/stream_decoder.h"
@@ -93,6 +96,10 @@ class FLACParser {
 public:
     enum {
         kMaxChannels = FCC_8,
+        // libFLAC reads a few KB at a time, the read callback reads ahead in
+        // blocks of this size aligned to kReadAlignment.
+        kReadBufferSize = 128 * 1024,
+        kReadAlignment = 4096,
     };
 
     explicit FLACParser(
@@ -154,6 +161,20 @@ private:
     off64_t mCurrentPos;
     bool mEOF;
 
+    // data read ahead for the read callback
+    std::vector<FLAC__byte> mReadBuffer;
+    off64_t mReadBufferPos;
+    size_t mReadBufferSize;
+
+    // Start of the decoded frames, about one per second of audio. Seeks near them
+    // decode from there, rather than bisecting the file as libFLAC does without
+    // a SEEKTABLE.
+    struct SeekPoint {
+        FLAC__uint64 mSample;
+        FLAC__uint64 mOffset;
+    };
+    std::vector<SeekPoint> mSeekPoints;
+
     // cached when the STREAMINFO metadata is parsed by libFLAC
     FLAC__StreamMetadata_StreamInfo mStreamInfo;
     bool mStreamInfoValid;
@@ -169,6 +190,8 @@ private:
 
     status_t init();
     MediaBufferHelper *readBuffer(bool doSeek, FLAC__uint64 sample);
+    void addSeekPoint();
+    bool seekToSeekPoint(FLAC__uint64 sample);
 
     // no copy constructor or assignment
     FLACParser(const FLACParser &);
@@ -292,7 +315,29 @@ FLAC__StreamDecoderReadStatus FLACParser::readCallback(
         FLAC__byte buffer[], size_t *bytes)
 {
     size_t requested = *bytes;
-    ssize_t actual = mDataSource->readAt(mCurrentPos, buffer, requested);
+    ssize_t actual;
+    if (requested >= kReadBufferSize) {
+        actual = mDataSource->readAt(mCurrentPos, buffer, requested);
+    } else {
+        if (mCurrentPos < mReadBufferPos
+                || mCurrentPos >= mReadBufferPos + (off64_t)mReadBufferSize) {
+            off64_t pos = mCurrentPos - mCurrentPos % kReadAlignment;
+            mReadBuffer.resize(kReadBufferSize);
+            ssize_t n = mDataSource->readAt(pos, mReadBuffer.data(), kReadBufferSize);
+            mReadBufferPos = pos;
+            mReadBufferSize = n > 0 ? n : 0;
+            if (n < 0) {
+                *bytes = 0;
+                return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+            }
+        }
+        actual = 0;
+        if (mCurrentPos < mReadBufferPos + (off64_t)mReadBufferSize) {
+            actual = std::min((off64_t)requested,
+                    mReadBufferPos + (off64_t)mReadBufferSize - mCurrentPos);
+            memcpy(buffer, &mReadBuffer[mCurrentPos - mReadBufferPos], actual);
+        }
+    }
     if (0 > actual) {
         *bytes = 0;
         return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
@@ -458,6 +503,8 @@ FLACParser::FLACParser(
       mDecoder(NULL),
       mCurrentPos(0LL),
       mEOF(false),
+      mReadBufferPos(0LL),
+      mReadBufferSize(0),
       mStreamInfoValid(false),
       mWriteRequested(false),
       mWriteCompleted(false),
@@ -582,8 +629,11 @@ MediaBufferHelper *FLACParser::readBuffer(bool doSeek, FLAC__uint64 sample)
     mWriteRequested = true;
     mWriteCompleted = false;
     if (doSeek) {
+        if (seekToSeekPoint(sample)) {
+            ALOGV("FLACParser::readBuffer seek to sample %lld from seek point",
+                    (long long)sample);
         // We implement the seek callback, so this works without explicit flush
-        if (!FLAC__stream_decoder_seek_absolute(mDecoder, sample)) {
+        } else if (!FLAC__stream_decoder_seek_absolute(mDecoder, sample)) {
             ALOGE("FLACParser::readBuffer seek to sample %lld failed", (long long)sample);
             return NULL;
         }
@@ -612,6 +662,7 @@ MediaBufferHelper *FLACParser::readBuffer(bool doSeek, FLAC__uint64 sample)
                 mWriteHeader.sample_rate, mWriteHeader.channels, mWriteHeader.bits_per_sample);
         return NULL;
     }
+    addSeekPoint();
     // acquire a media buffer
     CHECK(mGroup != NULL);
     MediaBufferHelper *buffer;
@@ -647,6 +698,65 @@ MediaBufferHelper *FLACParser::readBuffer(bool doSeek, FLAC__uint64 sample)
     return buffer;
 }
 
+void FLACParser::addSeekPoint()
+{
+    // The decode position is the end of the frame just written, that is the start
+    // of the next one.
+    FLAC__uint64 offset;
+    if (mWriteHeader.number_type != FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER
+            || !FLAC__stream_decoder_get_decode_position(mDecoder, &offset)) {
+        return;
+    }
+    SeekPoint point = { mWriteHeader.number.sample_number + mWriteHeader.blocksize, offset };
+    auto it = std::upper_bound(mSeekPoints.begin(), mSeekPoints.end(), point.mSample,
+            [](FLAC__uint64 s, const SeekPoint &p) { return s < p.mSample; });
+    if (it != mSeekPoints.begin() && (it - 1)->mSample + getSampleRate() > point.mSample) {
+        return;
+    }
+    mSeekPoints.insert(it, point);
+}
+
+bool FLACParser::seekToSeekPoint(FLAC__uint64 sample)
+{
+    auto it = std::upper_bound(mSeekPoints.begin(), mSeekPoints.end(), sample,
+            [](FLAC__uint64 s, const SeekPoint &p) { return s < p.mSample; });
+    // Decode at most a couple of seconds, libFLAC is faster farther away.
+    if (it == mSeekPoints.begin() || sample - (it - 1)->mSample > 2 * getSampleRate()) {
+        return false;
+    }
+    --it;
+
+    if (!FLAC__stream_decoder_flush(mDecoder)) {
+        return false;
+    }
+    mCurrentPos = it->mOffset;
+    mEOF = false;
+    for (;;) {
+        mWriteRequested = true;
+        mWriteCompleted = false;
+        if (!FLAC__stream_decoder_process_single(mDecoder) || !mWriteCompleted
+                || mWriteHeader.number_type != FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER
+                || mWriteHeader.number.sample_number > sample) {
+            mWriteRequested = true;
+            mWriteCompleted = false;
+            return false;
+        }
+        FLAC__uint64 firstSample = mWriteHeader.number.sample_number;
+        if (sample < firstSample + mWriteHeader.blocksize) {
+            // Drop the samples before the seek sample,
+            // as FLAC__stream_decoder_seek_absolute() does.
+            unsigned skip = sample - firstSample;
+            for (unsigned c = 0; c < getChannels(); ++c) {
+                mWriteBuffer[c] += skip;
+            }
+            mWriteHeader.blocksize -= skip;
+            mWriteHeader.number.sample_number = sample;
+            return true;
+        }
+        addSeekPoint();
+    }
+}
+
 // FLACsource
 
 FLACSource::FLACSource(
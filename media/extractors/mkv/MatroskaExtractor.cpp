@@ -36,12 +36,18 @@
 #include <media/stagefright/foundation/avc_utils.h>
 #include <utils/String8.h>
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <inttypes.h>
 #include <vector>
 
 namespace android {
 
+// Reads ahead in windows of kReadAheadSize bytes, since mkvparser reads the
+// element headers a few bytes at a time and the frames of a block one by one.
+// A window stays cached until a read falls outside of it, so that the tracks,
+// which are read from their own threads but interleaved in the same clusters,
+// mostly share the windows rather than reading from the source for each frame.
 struct DataSourceBaseReader : public mkvparser::IMkvReader {
     explicit DataSourceBaseReader(DataSourceHelper *source)
         : mSource(source) {
@@ -55,6 +61,13 @@ struct DataSourceBaseReader : public mkvparser::IMkvReader {
             return 0;
         }
 
+        if (length < kReadAheadSize) {
+            Mutex::Autolock autoLock(mLock);
+            if (readCached_l(position, length, buffer)) {
+                return 0;
+            }
+        }
+
         ssize_t n = mSource->readAt(position, buffer, length);
 
         if (n <= 0) {
@@ -89,7 +102,62 @@ struct DataSourceBaseReader : public mkvparser::IMkvReader {
     }
 
 private:
+    enum {
+        kReadAheadSize = 256 * 1024,
+        kNumWindows = 2,
+    };
+
+    struct Window {
+        Window() : mOffset(0), mSize(0), mLastUse(0) {}
+
+        off64_t mOffset;
+        size_t mSize;
+        uint32_t mLastUse;
+        std::vector<uint8_t> mData;
+    };
+
     DataSourceHelper *mSource;
+    Mutex mLock;
+    Window mWindows[kNumWindows];
+    uint32_t mUseCount = 0;
+
+    // Copies the range from a window, reading the window that starts at position
+    // in place of the least recently used one if none holds it. Returns false if
+    // the range can't be read ahead, the caller then reads it from the source.
+    bool readCached_l(off64_t position, size_t length, unsigned char *buffer) {
+        Window *window = NULL;
+        for (Window &w : mWindows) {
+            if (position >= w.mOffset && position + (off64_t)length <= w.mOffset + (off64_t)w.mSize) {
+                window = &w;
+                break;
+            }
+            if (window == NULL || w.mLastUse < window->mLastUse) {
+                window = &w;
+            }
+        }
+
+        if (position < window->mOffset
+                || position + (off64_t)length > window->mOffset + (off64_t)window->mSize) {
+            // Read ahead of sources of unknown size, such as live streams,
+            // would wait for data that is not needed yet.
+            off64_t size;
+            if (mSource->getSize(&size) != OK || position >= size) {
+                return false;
+            }
+            size_t windowSize = std::min((off64_t)kReadAheadSize, size - position);
+            window->mData.resize(kReadAheadSize);
+            ssize_t n = mSource->readAt(position, window->mData.data(), windowSize);
+            window->mOffset = position;
+            window->mSize = n > 0 ? n : 0;
+            if (window->mSize < length) {
+                return false;
+            }
+        }
+
+        window->mLastUse = ++mUseCount;
+        memcpy(buffer, window->mData.data() + (position - window->mOffset), length);
+        return true;
+    }
 
     DataSourceBaseReader(const DataSourceBaseReader &);
     DataSourceBaseReader &operator=(const DataSourceBaseReader &);
@@ -97,6 +165,213 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Index of the cluster positions by time, for seeking in files without Cues.
+// Clusters are otherwise only known to mkvparser once it has parsed everything
+// before them. The index scans only the EBML element headers of the segment,
+// on demand from the seeks, and only up to the time they need. It reads the
+// source from the thread of the seek, like the rest of the extractor does.
+struct ClusterIndex {
+    ClusterIndex(DataSourceHelper *source, long long segmentStart,
+            long long firstClusterPosition, long long timecodeScale);
+
+    // Finds the position, relative to the segment, of the last cluster that
+    // starts at or before timeNs.
+    bool find(long long timeNs, long long *position);
+
+private:
+    enum {
+        kBufferSize = 64 * 1024,
+    };
+
+    struct Entry {
+        long long mTimeNs;
+        long long mPosition;
+    };
+
+    Mutex mLock;
+    DataSourceHelper *mSource;
+    const long long mSegmentStart;
+    const long long mTimecodeScale;
+    std::vector<Entry> mEntries;
+    off64_t mNextOffset;
+    bool mDone;
+
+    std::vector<uint8_t> mBuffer;
+    off64_t mBufferOffset;
+    size_t mBufferSize;
+
+    size_t fill_l(off64_t offset, size_t size, const uint8_t **data);
+    bool readElementHeader_l(off64_t offset, uint32_t *id, long long *size,
+            off64_t *dataOffset);
+    bool indexNext_l();
+
+    ClusterIndex(const ClusterIndex &);
+    ClusterIndex &operator=(const ClusterIndex &);
+};
+
+ClusterIndex::ClusterIndex(DataSourceHelper *source, long long segmentStart,
+        long long firstClusterPosition, long long timecodeScale)
+    : mSource(source),
+      mSegmentStart(segmentStart),
+      mTimecodeScale(timecodeScale),
+      mNextOffset(segmentStart + firstClusterPosition),
+      mDone(false),
+      mBuffer(kBufferSize),
+      mBufferOffset(0),
+      mBufferSize(0) {
+}
+
+bool ClusterIndex::find(long long timeNs, long long *position) {
+    Mutex::Autolock autoLock(mLock);
+
+    while (mEntries.empty() || mEntries.back().mTimeNs <= timeNs) {
+        if (!indexNext_l()) {
+            break;
+        }
+    }
+
+    auto it = std::upper_bound(mEntries.begin(), mEntries.end(), timeNs,
+            [](long long time, const Entry &entry) {
+                return time < entry.mTimeNs;
+            });
+    if (it == mEntries.begin()) {
+        return false;
+    }
+    *position = (--it)->mPosition;
+    return true;
+}
+
+// Returns the number of bytes available at offset, up to size.
+size_t ClusterIndex::fill_l(off64_t offset, size_t size, const uint8_t **data) {
+    if (offset < mBufferOffset || offset + (off64_t)size > mBufferOffset + (off64_t)mBufferSize) {
+        ssize_t n = mSource->readAt(offset, mBuffer.data(), mBuffer.size());
+        mBufferOffset = offset;
+        mBufferSize = n > 0 ? n : 0;
+    }
+    *data = mBuffer.data() + (offset - mBufferOffset);
+    return std::min(size, (size_t)(mBufferOffset + mBufferSize - offset));
+}
+
+// Reads the ID and size of the element at offset. size is set to -1 if it is unknown.
+bool ClusterIndex::readElementHeader_l(
+        off64_t offset, uint32_t *id, long long *size, off64_t *dataOffset) {
+    const uint8_t *data;
+    size_t available = fill_l(offset, 12, &data);
+    if (available < 2) {
+        return false;
+    }
+
+    size_t idLength = 1;
+    while (idLength <= 4 && !(data[0] & (0x80 >> (idLength - 1)))) {
+        ++idLength;
+    }
+    if (idLength > 4 || idLength >= available) {
+        return false;
+    }
+    *id = 0;
+    for (size_t i = 0; i < idLength; ++i) {
+        *id = (*id << 8) | data[i];
+    }
+
+    const uint8_t *sizeData = data + idLength;
+    size_t sizeLength = 1;
+    while (sizeLength <= 8 && !(sizeData[0] & (0x80 >> (sizeLength - 1)))) {
+        ++sizeLength;
+    }
+    if (sizeLength > 8 || idLength + sizeLength > available) {
+        return false;
+    }
+    uint64_t value = sizeData[0] & (0xff >> sizeLength);
+    bool unknown = value == (0xffu >> sizeLength);
+    for (size_t i = 1; i < sizeLength; ++i) {
+        value = (value << 8) | sizeData[i];
+        unknown = unknown && sizeData[i] == 0xff;
+    }
+    if (!unknown && value > (uint64_t)INT64_MAX - offset) {
+        return false;
+    }
+    *size = unknown ? -1 : (long long)value;
+    *dataOffset = offset + idLength + sizeLength;
+    return true;
+}
+
+// Indexes the next cluster. Returns false once there are no more clusters.
+bool ClusterIndex::indexNext_l() {
+    while (!mDone) {
+        uint32_t id;
+        long long size;
+        off64_t dataOffset;
+        if (!readElementHeader_l(mNextOffset, &id, &size, &dataOffset)) {
+            mDone = true;
+            break;
+        }
+
+        if (id != libwebm::kMkvCluster) {
+            if (size < 0) {
+                mDone = true;
+                break;
+            }
+            mNextOffset = dataOffset + size;
+            continue;
+        }
+
+        // The Timecode element comes first. The end of clusters of unknown size,
+        // common in live recordings, is the next top level element.
+        long long timecode = -1;
+        off64_t childOffset = dataOffset;
+        bool foundEnd = size >= 0;
+        while (size < 0 || (childOffset < dataOffset + size && timecode < 0)) {
+            uint32_t childId;
+            long long childSize;
+            off64_t childDataOffset;
+            if (!readElementHeader_l(childOffset, &childId, &childSize, &childDataOffset)) {
+                break;
+            }
+            if (size < 0 && (childId == libwebm::kMkvCluster
+                    || childId == libwebm::kMkvCues
+                    || childId == libwebm::kMkvTags
+                    || childId == libwebm::kMkvChapters
+                    || childId == libwebm::kMkvAttachments
+                    || childId == libwebm::kMkvSeekHead
+                    || childId == libwebm::kMkvInfo
+                    || childId == libwebm::kMkvTracks)) {
+                foundEnd = true;
+                break;
+            }
+            if (childSize < 0) {
+                break;
+            }
+            if (childId == libwebm::kMkvTimecode && timecode < 0
+                    && childSize >= 1 && childSize <= 8) {
+                const uint8_t *data;
+                if (fill_l(childDataOffset, childSize, &data) < (size_t)childSize) {
+                    break;
+                }
+                timecode = 0;
+                for (long long i = 0; i < childSize; ++i) {
+                    timecode = (timecode << 8) | data[i];
+                }
+            }
+            childOffset = childDataOffset + childSize;
+        }
+
+        if (timecode >= 0 && timecode <= INT64_MAX / mTimecodeScale) {
+            Entry entry = { timecode * mTimecodeScale, mNextOffset - mSegmentStart };
+            mEntries.push_back(entry);
+        }
+
+        if (!foundEnd) {
+            mDone = true;
+        } else {
+            mNextOffset = size >= 0 ? dataOffset + size : childOffset;
+        }
+        return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct BlockIterator {
     BlockIterator(MatroskaExtractor *extractor, unsigned long trackNum, unsigned long index);
 
@@ -585,6 +860,20 @@ int64_t BlockIterator::blockTimeUs() const {
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
     mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
+
+    // mkvparser only knows the clusters up to the ones played so far,
+    // jump to an indexed cluster after them.
+    long long position;
+    if (mExtractor->mClusterIndex != NULL
+            && mExtractor->mClusterIndex->find(seekTimeUs * 1000ll, &position)
+            && (mCluster == NULL || mCluster->EOS() || position > mCluster->GetPosition())) {
+        const mkvparser::Cluster *cluster =
+                mExtractor->mSegment->FindOrPreloadCluster(position);
+        if (cluster != NULL && !cluster->EOS()) {
+            mCluster = cluster;
+        }
+    }
+
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
         ALOGE("get last blockenry failed!");
@@ -1328,6 +1617,7 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
     : mDataSource(source),
       mReader(new DataSourceBaseReader(mDataSource)),
       mSegment(NULL),
+      mClusterIndex(NULL),
       mExtractedThumbnails(false),
       mIsWebm(false),
       mSeekPreRollNs(0) {
@@ -1395,13 +1685,19 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
                 }
             }
 
+            long len;
+            ret = mSegment->LoadCluster(pos, len);
             if (mCues) {
-                long len;
-                ret = mSegment->LoadCluster(pos, len);
                 ALOGV("has Cue data, Cluster num=%ld", mSegment->GetCount());
-            } else  {
-                long status_Load = mSegment->Load();
-                ALOGW("no Cue data,Segment Load status:%ld",status_Load);
+            } else if (ret == 0) {
+                // Instead of loading all clusters before playback can start,
+                // index them when seeking.
+                ALOGW("no Cue data, indexing clusters on seek");
+                const mkvparser::Cluster *first = mSegment->GetFirst();
+                if (first != NULL && !first->EOS()) {
+                    mClusterIndex = new ClusterIndex(mDataSource, mSegment->m_start,
+                            first->GetPosition(), mSegment->GetInfo()->GetTimeCodeScale());
+                }
             }
         } else if (ret > 0) {
             ret = mkvparser::E_BUFFER_NOT_FULL;
@@ -1431,6 +1727,9 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
 }
 
 MatroskaExtractor::~MatroskaExtractor() {
+    delete mClusterIndex;
+    mClusterIndex = NULL;
+
     delete mSegment;
     mSegment = NULL;
 
@@ -32,6 +32,7 @@ struct AMessage;
 class String8;
 
 class MetaData;
+struct ClusterIndex;
 struct DataSourceBaseReader;
 struct MatroskaSource;
 
@@ -87,6 +88,8 @@ private:
     DataSourceHelper *mDataSource;
     DataSourceBaseReader *mReader;
     mkvparser::Segment *mSegment;
+    // Positions of the clusters by time, for files without Cues.
+    ClusterIndex *mClusterIndex;
     bool mExtractedThumbnails;
     bool mIsLiveStreaming;
     bool mIsWebm;
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameIndexSeeker"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "FrameIndexSeeker.h"
+
+#include <media/stagefright/foundation/avc_utils.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/DataSourceBase.h>
+
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+
+namespace android {
+
+// Same as in MP3Extractor: the bits of the header that don't change from frame to frame.
+static const uint32_t kMask = 0xfffe0c00;
+
+// static
+FrameIndexSeeker *FrameIndexSeeker::CreateFromSource(
+        DataSourceHelper *source, off64_t firstFramePos, uint32_t fixedHeader) {
+    // Seeks may read the whole file, which is only reasonable for local files.
+    off64_t fileSize;
+    if (!(source->flags() & DataSourceBase::kIsLocalFileSource)
+            || source->getSize(&fileSize) != OK || fileSize <= firstFramePos) {
+        return NULL;
+    }
+
+    return new FrameIndexSeeker(source, firstFramePos, fixedHeader, fileSize);
+}
+
+FrameIndexSeeker::FrameIndexSeeker(DataSourceHelper *source, off64_t firstFramePos,
+        uint32_t fixedHeader, off64_t fileSize)
+    : mSource(source),
+      mFixedHeader(fixedHeader),
+      mFileSize(fileSize),
+      mNextPos(firstFramePos),
+      mNumFrames(0),
+      mNumSamples(0),
+      mSampleRate(0),
+      mDone(false),
+      mBuffer(kBufferSize),
+      mBufferPos(0),
+      mBufferSize(0) {
+}
+
+FrameIndexSeeker::~FrameIndexSeeker() {
+}
+
+bool FrameIndexSeeker::getDuration(int64_t *durationUs) {
+    Mutex::Autolock autoLock(mLock);
+    if (!mDone || mSampleRate <= 0) {
+        return false;
+    }
+    *durationUs = mNumSamples * 1000000LL / mSampleRate;
+    return true;
+}
+
+bool FrameIndexSeeker::getOffsetForTime(int64_t *timeUs, off64_t *pos) {
+    Mutex::Autolock autoLock(mLock);
+
+    while (mEntries.empty() || mEntries.back().mTimeUs <= *timeUs) {
+        if (!indexNext_l()) {
+            break;
+        }
+    }
+
+    ALOGV("indexed %" PRIu64 " frames", mNumFrames);
+
+    auto it = std::upper_bound(mEntries.begin(), mEntries.end(), *timeUs,
+            [](int64_t time, const Entry &entry) {
+                return time < entry.mTimeUs;
+            });
+    if (it == mEntries.begin()) {
+        return false;
+    }
+    --it;
+    *timeUs = it->mTimeUs;
+    *pos = it->mPos;
+    return true;
+}
+
+bool FrameIndexSeeker::readHeader_l(off64_t pos, uint32_t *header) {
+    if (pos < mBufferPos || pos + 4 > mBufferPos + (off64_t)mBufferSize) {
+        ssize_t n = mSource->readAt(pos, mBuffer.data(), mBuffer.size());
+        mBufferPos = pos;
+        mBufferSize = n > 0 ? n : 0;
+        if (mBufferSize < 4) {
+            return false;
+        }
+    }
+    *header = U32_AT(&mBuffer[pos - mBufferPos]);
+    return true;
+}
+
+bool FrameIndexSeeker::indexNext_l() {
+    if (mDone) {
+        return false;
+    }
+
+    const off64_t endPos = std::min(mNextPos + (off64_t)kBufferSize, mFileSize);
+    while (mNextPos < endPos) {
+        uint32_t header;
+        if (!readHeader_l(mNextPos, &header)) {
+            mDone = true;
+            break;
+        }
+
+        size_t frameSize;
+        int sampleRate;
+        int numSamples;
+        if ((header & kMask) != (mFixedHeader & kMask)
+                || !GetMPEGAudioFrameSize(
+                        header, &frameSize, &sampleRate, NULL, NULL, &numSamples)) {
+            // Lost sync, look for the next frame header byte by byte, like MP3Source.
+            ++mNextPos;
+            continue;
+        }
+
+        if (mNumFrames % kFramesPerEntry == 0) {
+            Entry entry = { (int64_t)(mNumSamples * 1000000LL / sampleRate), mNextPos };
+            mEntries.push_back(entry);
+        }
+        ++mNumFrames;
+        mNumSamples += numSamples;
+        mSampleRate = sampleRate;
+        mNextPos += frameSize;
+    }
+
+    if (mNextPos >= mFileSize) {
+        mDone = true;
+    }
+    return true;
+}
+
+}  // namespace android
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_INDEX_SEEKER_H_
+
+#define FRAME_INDEX_SEEKER_H_
+
+#include "MP3Seeker.h"
+
+#include <vector>
+
+#include <utils/threads.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Seeker for files that have neither a XING nor a VBRI header. It indexes the
+// position of every kFramesPerEntry-th frame by scanning the frame headers of
+// the file. Nothing is scanned until the first seek, and each seek past the
+// indexed frames scans only up to the time it needs, on the thread of the seek.
+// getDuration() is exact only once a seek has scanned the whole file.
+struct FrameIndexSeeker : public MP3Seeker {
+    static FrameIndexSeeker *CreateFromSource(
+            DataSourceHelper *source, off64_t firstFramePos, uint32_t fixedHeader);
+
+    virtual ~FrameIndexSeeker();
+
+    virtual bool getDuration(int64_t *durationUs);
+    virtual bool getOffsetForTime(int64_t *timeUs, off64_t *pos);
+
+private:
+    enum {
+        kFramesPerEntry = 32,
+        kBufferSize = 64 * 1024,
+    };
+
+    struct Entry {
+        int64_t mTimeUs;
+        off64_t mPos;
+    };
+
+    Mutex mLock;
+    DataSourceHelper *mSource;
+    const uint32_t mFixedHeader;
+    const off64_t mFileSize;
+
+    std::vector<Entry> mEntries;
+    off64_t mNextPos;
+    uint64_t mNumFrames;
+    uint64_t mNumSamples;
+    int mSampleRate;
+    bool mDone;
+
+    std::vector<uint8_t> mBuffer;
+    off64_t mBufferPos;
+    size_t mBufferSize;
+
+    FrameIndexSeeker(DataSourceHelper *source, off64_t firstFramePos,
+            uint32_t fixedHeader, off64_t fileSize);
+
+    bool readHeader_l(off64_t pos, uint32_t *header);
+    // Scans the frames of the next buffer's worth of data.
+    // Returns false once the end of the file is reached.
+    bool indexNext_l();
+
+    DISALLOW_EVIL_CONSTRUCTORS(FrameIndexSeeker);
+};
+
+}  // namespace android
+
+#endif  // FRAME_INDEX_SEEKER_H_
@@ -20,6 +20,7 @@
 
 #include "MP3Extractor.h"
 
+#include "FrameIndexSeeker.h"
 #include "ID3.h"
 #include "VBRISeeker.h"
 #include "XINGSeeker.h"
@@ -310,6 +311,10 @@ MP3Extractor::MP3Extractor(
         }
         mFirstFramePos = pos;
         mFixedHeader = header;
+    } else {
+        // Without a table of contents, seeking by the average bitrate is far off
+        // in VBR files. Index the frames when seeking instead.
+        mSeeker = FrameIndexSeeker::CreateFromSource(mDataSource, mFirstFramePos, mFixedHeader);
     }
 
     size_t frame_size;
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FragmentIndex"
+#include <utils/Log.h>
+
+#include <algorithm>
+
+#include "FragmentIndex.h"
+
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+namespace android {
+
+// The 'mfra' box is only read if it is at most this large.
+static const off64_t kMaxRandomAccessSize = 16 * 1024 * 1024;
+
+FragmentIndex::FragmentIndex(DataSourceHelper *source)
+    : mDataSource(source),
+      mSegmentsEndTimeUs(0),
+      mSegmentsEndOffset(0),
+      mRandomAccessParsed(false) {
+}
+
+FragmentIndex::~FragmentIndex() {
+}
+
+void FragmentIndex::addSegment(size_t size, uint32_t durationUs) {
+    Mutex::Autolock autoLock(mLock);
+
+    Segment segment;
+    segment.mStartTimeUs = mSegmentsEndTimeUs;
+    segment.mDurationUs = durationUs;
+    segment.mOffset = mSegmentsEndOffset;
+    segment.mSize = size;
+    mSegments.push_back(segment);
+
+    mSegmentsEndTimeUs += durationUs;
+    mSegmentsEndOffset += size;
+}
+
+size_t FragmentIndex::countSegments() const {
+    Mutex::Autolock autoLock(mLock);
+    return mSegments.size();
+}
+
+bool FragmentIndex::findSegment(int64_t timeUs, int64_t *startTimeUs, uint32_t *durationUs,
+        off64_t *offset, size_t *size) const {
+    Mutex::Autolock autoLock(mLock);
+
+    // The first segment that ends after timeUs.
+    auto it = std::upper_bound(mSegments.begin(), mSegments.end(), timeUs,
+            [](int64_t time, const Segment &segment) {
+                return time < segment.mStartTimeUs + segment.mDurationUs;
+            });
+    if (it == mSegments.end()) {
+        *startTimeUs = mSegmentsEndTimeUs;
+        *durationUs = 0;
+        *offset = mSegmentsEndOffset;
+        *size = 0;
+        return false;
+    }
+    *startTimeUs = it->mStartTimeUs;
+    *durationUs = it->mDurationUs;
+    *offset = it->mOffset;
+    *size = it->mSize;
+    return true;
+}
+
+void FragmentIndex::setBaseDecodeTime(int32_t trackId, uint64_t baseDecodeTime) {
+    Mutex::Autolock autoLock(mLock);
+
+    TrackFragments &track = mTracks[trackId];
+    if (track.mHasBaseDecodeTime) {
+        return;
+    }
+    track.mHasBaseDecodeTime = true;
+    track.mBaseDecodeTime = baseDecodeTime;
+    addRandomAccessPoints_l(&track);
+}
+
+bool FragmentIndex::getBaseDecodeTime(int32_t trackId, uint64_t *baseDecodeTime) const {
+    Mutex::Autolock autoLock(mLock);
+
+    auto it = mTracks.find(trackId);
+    if (it == mTracks.end() || !it->second.mHasBaseDecodeTime) {
+        return false;
+    }
+    *baseDecodeTime = it->second.mBaseDecodeTime;
+    return true;
+}
+
+void FragmentIndex::addFragment(int32_t trackId, off64_t moofOffset, uint64_t time) {
+    Mutex::Autolock autoLock(mLock);
+
+    ALOGV("track %d fragment @ %lld time %llu",
+            trackId, (long long)moofOffset, (unsigned long long)time);
+    // Keep the first of the fragments that start at the same time, the others may
+    // only have samples of other tracks.
+    mTracks[trackId].mFragments.emplace(time, moofOffset);
+}
+
+bool FragmentIndex::findFragment(
+        int32_t trackId, uint64_t time, Fragment *before, Fragment *after) {
+    Mutex::Autolock autoLock(mLock);
+
+    parseRandomAccess_l();
+
+    before->mMoofOffset = -1;
+    after->mMoofOffset = -1;
+
+    auto track = mTracks.find(trackId);
+    if (track == mTracks.end()) {
+        return false;
+    }
+    const std::map<uint64_t, off64_t> &fragments = track->second.mFragments;
+
+    auto it = fragments.upper_bound(time);
+    if (it != fragments.end()) {
+        after->mTime = it->first;
+        after->mMoofOffset = it->second;
+    }
+    if (it == fragments.begin()) {
+        return false;
+    }
+    --it;
+    before->mTime = it->first;
+    before->mMoofOffset = it->second;
+    return true;
+}
+
+void FragmentIndex::parseRandomAccess_l() {
+    if (mRandomAccessParsed) {
+        return;
+    }
+    mRandomAccessParsed = true;
+
+    // The 'mfro' box is the last box of the 'mfra' box at the end of the file,
+    // and holds the size of the 'mfra' box.
+    off64_t fileSize;
+    if (mDataSource->getSize(&fileSize) != OK || fileSize < 16) {
+        return;
+    }
+    uint8_t mfro[16];
+    if (mDataSource->readAt(fileSize - 16, mfro, sizeof(mfro)) < (ssize_t)sizeof(mfro)
+            || U32_AT(mfro) != 16 || U32_AT(&mfro[4]) != FOURCC("mfro")) {
+        return;
+    }
+    off64_t mfraSize = U32_AT(&mfro[12]);
+    if (mfraSize < 8 + 16 || mfraSize > fileSize || mfraSize > kMaxRandomAccessSize) {
+        return;
+    }
+
+    off64_t offset = fileSize - mfraSize;
+    uint8_t header[8];
+    if (mDataSource->readAt(offset, header, sizeof(header)) < (ssize_t)sizeof(header)
+            || U32_AT(header) != mfraSize || U32_AT(&header[4]) != FOURCC("mfra")) {
+        return;
+    }
+
+    off64_t stopOffset = fileSize;
+    offset += 8;
+    while (offset + 8 <= stopOffset) {
+        if (mDataSource->readAt(offset, header, sizeof(header)) < (ssize_t)sizeof(header)) {
+            return;
+        }
+        off64_t boxSize = U32_AT(header);
+        if (boxSize < 8 || offset + boxSize > stopOffset) {
+            return;
+        }
+        if (U32_AT(&header[4]) == FOURCC("tfra")
+                && parseTrackFragmentRandomAccess_l(offset + 8, boxSize - 8) != OK) {
+            ALOGW("ignoring malformed tfra box");
+        }
+        offset += boxSize;
+    }
+
+    for (auto &track : mTracks) {
+        addRandomAccessPoints_l(&track.second);
+    }
+}
+
+status_t FragmentIndex::parseTrackFragmentRandomAccess_l(off64_t offset, off64_t size) {
+    if (size < 16) {
+        return ERROR_MALFORMED;
+    }
+    std::vector<uint8_t> data(size);
+    if (mDataSource->readAt(offset, data.data(), size) < (ssize_t)size) {
+        return ERROR_IO;
+    }
+
+    uint32_t version = data[0];
+    int32_t trackId = U32_AT(&data[4]);
+    uint32_t lengths = U32_AT(&data[8]);
+    size_t trafNumberSize = ((lengths >> 4) & 3) + 1;
+    size_t trunNumberSize = ((lengths >> 2) & 3) + 1;
+    size_t sampleNumberSize = (lengths & 3) + 1;
+    uint32_t numEntries = U32_AT(&data[12]);
+
+    size_t timeSize = version == 1 ? 8 : 4;
+    size_t entrySize = 2 * timeSize + trafNumberSize + trunNumberSize + sampleNumberSize;
+    if (numEntries > (size - 16) / entrySize) {
+        return ERROR_MALFORMED;
+    }
+
+    auto readNumber = [](const uint8_t *ptr, size_t numBytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < numBytes; ++i) {
+            value = (value << 8) | ptr[i];
+        }
+        return value;
+    };
+
+    TrackFragments &track = mTracks[trackId];
+    const uint8_t *ptr = &data[16];
+    for (uint32_t i = 0; i < numEntries; ++i, ptr += entrySize) {
+        uint64_t time = readNumber(ptr, timeSize);
+        off64_t moofOffset = readNumber(ptr + timeSize, timeSize);
+        const uint8_t *numbers = ptr + 2 * timeSize + trafNumberSize;
+        uint64_t trunNumber = readNumber(numbers, trunNumberSize);
+        uint64_t sampleNumber = readNumber(numbers + trunNumberSize, sampleNumberSize);
+        // Only the random access points that start a fragment are fragment times.
+        if (trunNumber == 1 && sampleNumber == 1 && moofOffset >= 0) {
+            track.mRandomAccessPoints[time] = moofOffset;
+        }
+    }
+    ALOGV("track %d has %zu random access fragments",
+            trackId, track.mRandomAccessPoints.size());
+    return OK;
+}
+
+void FragmentIndex::addRandomAccessPoints_l(TrackFragments *track) {
+    if (!track->mHasBaseDecodeTime) {
+        return;
+    }
+    for (const auto &point : track->mRandomAccessPoints) {
+        if (point.first >= track->mBaseDecodeTime) {
+            track->mFragments.emplace(point.first - track->mBaseDecodeTime, point.second);
+        }
+    }
+    track->mRandomAccessPoints.clear();
+}
+
+}  // namespace android
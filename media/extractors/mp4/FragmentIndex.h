@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAGMENT_INDEX_H_
+
+#define FRAGMENT_INDEX_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include <media/stagefright/MediaErrors.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+/*
+ * FragmentIndex keeps track of the movie fragments of a fragmented MP4 file,
+ * for all tracks of an MPEG4Extractor.
+ *
+ * It is built incrementally, from the segments of the 'sidx' box, from the
+ * 'tfra' boxes of the 'mfra' box at the end of the file, and from the fragments
+ * that the tracks parse while reading or seeking. Fragment times are in media
+ * timescale ticks, counted from the first fragment of the track.
+ */
+class FragmentIndex : public RefBase {
+public:
+    explicit FragmentIndex(DataSourceHelper *source);
+
+    // Segments of the 'sidx' box, in file order.
+    void addSegment(size_t size, uint32_t durationUs);
+    size_t countSegments() const;
+
+    // Finds the segment that contains timeUs. Its offset is relative to the first
+    // fragment of the file. Returns false, with the start and offset of the end
+    // of the last segment, if timeUs is past the last segment.
+    bool findSegment(int64_t timeUs, int64_t *startTimeUs, uint32_t *durationUs,
+            off64_t *offset, size_t *size) const;
+
+    struct Fragment {
+        off64_t mMoofOffset;
+        uint64_t mTime;
+    };
+
+    // Decode time in the 'tfdt' box of the first fragment of the track,
+    // the indexed fragment times are relative to it.
+    void setBaseDecodeTime(int32_t trackId, uint64_t baseDecodeTime);
+    bool getBaseDecodeTime(int32_t trackId, uint64_t *baseDecodeTime) const;
+
+    void addFragment(int32_t trackId, off64_t moofOffset, uint64_t time);
+
+    // Finds the last indexed fragment of the track that starts at or before time,
+    // and the first indexed fragment after it. after->mMoofOffset is set to -1 if
+    // there is none. Returns false if no fragment of the track starts before time.
+    bool findFragment(int32_t trackId, uint64_t time, Fragment *before, Fragment *after);
+
+protected:
+    ~FragmentIndex();
+
+private:
+    struct Segment {
+        int64_t mStartTimeUs;
+        uint32_t mDurationUs;
+        off64_t mOffset;
+        size_t mSize;
+    };
+
+    struct TrackFragments {
+        TrackFragments() : mHasBaseDecodeTime(false), mBaseDecodeTime(0) {}
+
+        bool mHasBaseDecodeTime;
+        uint64_t mBaseDecodeTime;
+        // Offset of the moof box by fragment time.
+        std::map<uint64_t, off64_t> mFragments;
+        // Absolute fragment times from the 'tfra' box, added once the base is known.
+        std::map<uint64_t, off64_t> mRandomAccessPoints;
+    };
+
+    DataSourceHelper *mDataSource;
+    mutable Mutex mLock;
+
+    std::vector<Segment> mSegments;
+    int64_t mSegmentsEndTimeUs;
+    off64_t mSegmentsEndOffset;
+
+    std::map<int32_t, TrackFragments> mTracks;
+    bool mRandomAccessParsed;
+
+    void parseRandomAccess_l();
+    status_t parseTrackFragmentRandomAccess_l(off64_t offset, off64_t size);
+    void addRandomAccessPoints_l(TrackFragments *track);
+
+    FragmentIndex(const FragmentIndex &);
+    FragmentIndex &operator=(const FragmentIndex &);
+};
+
+}  // namespace android
+
+#endif  // FRAGMENT_INDEX_H_
@@ -30,6 +30,7 @@
 #include <utils/Log.h>
 
 #include "AC4Parser.h"
+#include "FragmentIndex.h"
 #include "MPEG4Extractor.h"
 #include "SampleTable.h"
 #include "ItemTable.h"
@@ -71,6 +72,15 @@ enum {
     // maximum size of an atom. Some atoms can be bigger according to the spec,
     // but we only allow up to this size.
     kMaxAtomSize = 64 * 1024 * 1024,
+
+    // maximum size of a moov or meta box read at once before it is parsed
+    kMaxHeaderCacheSize = 16 * 1024 * 1024,
+
+    // maximum size of a moof box probed while searching for a fragment
+    kMaxFragmentProbeSize = 4 * 1024 * 1024,
+
+    // seeking in fragmented files walks fragment by fragment in ranges this small
+    kMinFragmentSearchRange = 1024 * 1024,
 };
 
 class MPEG4Source : public MediaTrackHelper {
@@ -81,7 +91,7 @@ public:
                 DataSourceHelper *dataSource,
                 int32_t timeScale,
                 const sp<SampleTable> &sampleTable,
-                Vector<SidxEntry> &sidx,
+                const sp<FragmentIndex> &fragmentIndex,
                 const Trex *trex,
                 off64_t firstMoofOffset,
                 const sp<ItemTable> &itemTable,
@@ -110,13 +120,15 @@ private:
     sp<SampleTable> mSampleTable;
     uint32_t mCurrentSampleIndex;
     uint32_t mCurrentFragmentIndex;
-    Vector<SidxEntry> &mSegments;
+    sp<FragmentIndex> mFragmentIndex;
     const Trex *mTrex;
     off64_t mFirstMoofOffset;
     off64_t mCurrentMoofOffset;
     off64_t mCurrentMoofSize;
     off64_t mNextMoofOffset;
     uint32_t mCurrentTime; // in media timescale ticks
+    bool mHasFragmentDecodeTime;
+    uint64_t mFragmentDecodeTime; // from the 'tfdt' box of the current fragment
     int32_t mLastParsedTrackId;
     int32_t mTrackId;
 
@@ -171,6 +183,16 @@ private:
     status_t parseClearEncryptedSizes(off64_t offset, bool isSampleEncryption,
             uint32_t flags, off64_t size);
     status_t parseSampleEncryption(off64_t offset, off64_t size);
+    status_t parseTrackFragmentDecodeTime(off64_t offset, off64_t size);
+
+    void indexCurrentFragment();
+    status_t parseFragment(const FragmentIndex::Fragment &fragment);
+    status_t seekToFragment(uint64_t seekTime, ReadOptions::SeekMode mode);
+    void searchFragment(uint64_t seekTime, FragmentIndex::Fragment *fragment);
+    bool findFragmentFrom(off64_t offset, off64_t end, uint64_t baseDecodeTime,
+            FragmentIndex::Fragment *fragment);
+    status_t probeFragment(off64_t moofOffset, uint64_t baseDecodeTime,
+            off64_t *moofSize, uint64_t *time);
     // returns -1 for invalid layer ID
     int32_t parseHEVCLayerId(const uint8_t *data, size_t size);
 
@@ -229,7 +251,10 @@ public:
     uint32_t flags() override;
 
     status_t setCachedRange(off64_t offset, size_t size, bool assumeSourceOwnershipOnSuccess);
+    bool isCached(off64_t offset, size_t size);
 
+    // Frees the cached data, all requests are forwarded from now on.
+    void releaseCache();
 
 private:
     Mutex mLock;
@@ -318,6 +343,16 @@ status_t CachedRangedDataSource::setCachedRange(off64_t offset,
     return OK;
 }
 
+bool CachedRangedDataSource::isCached(off64_t offset, size_t size) {
+    Mutex::Autolock autoLock(mLock);
+    return isInRange(mCachedOffset, mCachedSize, offset, size);
+}
+
+void CachedRangedDataSource::releaseCache() {
+    Mutex::Autolock autoLock(mLock);
+    clearCache();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static const bool kUseHexDump = false;
@@ -416,6 +451,7 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mLastTrack(NULL) {
     ALOGV("mime=%s, mPreferHeif=%d", mime, mPreferHeif);
     mFileMetaData = AMediaFormat_new();
+    mFragmentIndex = new FragmentIndex(source);
 }
 
 MPEG4Extractor::~MPEG4Extractor() {
@@ -438,9 +474,8 @@ MPEG4Extractor::~MPEG4Extractor() {
 }
 
 uint32_t MPEG4Extractor::flags() const {
-    return CAN_PAUSE |
-            ((mMoofOffset == 0 || mSidxEntries.size() != 0) ?
-                    (CAN_SEEK_BACKWARD | CAN_SEEK_FORWARD | CAN_SEEK) : 0);
+    // Fragmented files without a 'sidx' box are seeked through mFragmentIndex.
+    return CAN_PAUSE | CAN_SEEK_BACKWARD | CAN_SEEK_FORWARD | CAN_SEEK;
 }
 
 media_status_t MPEG4Extractor::getMetaData(AMediaFormat *meta) {
@@ -640,6 +675,18 @@ media_status_t MPEG4Extractor::getTrackMetaData(
     return AMEDIA_OK;
 }
 
+void MPEG4Extractor::cacheHeaderBox(off64_t offset, size_t size) {
+    CachedRangedDataSource *cachedSource = new CachedRangedDataSource(mDataSource);
+    if (cachedSource->setCachedRange(
+            offset, size, true /* assume ownership on success */) == OK) {
+        ALOGV("caching %zu bytes @ %lld", size, (long long)offset);
+        mDataSource = cachedSource;
+        mHeaderCaches.push(cachedSource);
+    } else {
+        delete cachedSource;
+    }
+}
+
 status_t MPEG4Extractor::readMetaData() {
     if (mInitCheck != NO_INIT) {
         return mInitCheck;
@@ -668,6 +715,16 @@ status_t MPEG4Extractor::readMetaData() {
         }
     }
 
+    // Sample tables are read on demand from now on. Keep them in memory
+    // only for sources which would otherwise cache their stbl boxes.
+    if (!(mDataSource->flags()
+            & (DataSourceBase::kWantsPrefetching | DataSourceBase::kIsCachingDataSource))) {
+        for (size_t i = 0; i < mHeaderCaches.size(); i++) {
+            mHeaderCaches[i]->releaseCache();
+        }
+    }
+    mHeaderCaches.clear();
+
     if (mIsHeif && (mItemTable != NULL) && (mItemTable->countImages() > 0)) {
         off64_t exifOffset;
         size_t exifSize;
@@ -883,6 +940,12 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
         hexdump(buffer, n);
     }
 
+    if (depth == 0 && (chunk_type == FOURCC("moov") || chunk_type == FOURCC("meta"))
+            && chunk_size <= kMaxHeaderCacheSize) {
+        // Parse the box from memory instead of reading every box header on its own.
+        cacheHeaderBox(*offset, chunk_size);
+    }
+
     PathAdder autoAdder(&mPath, chunk_type);
 
     // (data_offset - *offset) is either 8 or 16
@@ -955,9 +1018,13 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
             if (chunk_type == FOURCC("stbl")) {
                 ALOGV("sampleTable chunk is %" PRIu64 " bytes long.", chunk_size);
 
-                if (mDataSource->flags()
+                bool inHeaderCache = false;
+                for (size_t i = 0; i < mHeaderCaches.size(); i++) {
+                    inHeaderCache |= mHeaderCaches[i]->isCached(*offset, chunk_size);
+                }
+                if (!inHeaderCache && (mDataSource->flags()
                         & (DataSourceBase::kWantsPrefetching
-                            | DataSourceBase::kIsCachingDataSource)) {
+                            | DataSourceBase::kIsCachingDataSource))) {
                     CachedRangedDataSource *cachedSource =
                         new CachedRangedDataSource(mDataSource);
 
@@ -3562,10 +3629,7 @@ status_t MPEG4Extractor::parseSegmentIndex(off64_t offset, size_t size) {
         total_duration += d2;
         offset += 12;
         ALOGV(" item %d, %08x %08x %08x", i, d1, d2, d3);
-        SidxEntry se;
-        se.mSize = d1 & 0x7fffffff;
-        se.mDurationUs = 1000000LL * d2 / timeScale;
-        mSidxEntries.add(se);
+        mFragmentIndex->addSegment(d1 & 0x7fffffff, 1000000LL * d2 / timeScale);
     }
 
     uint64_t sidxDuration = total_duration * 1000000 / timeScale;
@@ -4359,7 +4423,7 @@ MediaTrackHelper *MPEG4Extractor::getTrack(size_t index) {
 
     MPEG4Source* source =
             new MPEG4Source(track->meta, mDataSource, track->timescale, track->sampleTable,
-                            mSidxEntries, trex, mMoofOffset, itemTable,
+                            mFragmentIndex, trex, mMoofOffset, itemTable,
                             track->elst_shift_start_ticks, elst_initial_empty_edit_ticks);
     if (source->init() != OK) {
         delete source;
@@ -4849,7 +4913,7 @@ MPEG4Source::MPEG4Source(
         DataSourceHelper *dataSource,
         int32_t timeScale,
         const sp<SampleTable> &sampleTable,
-        Vector<SidxEntry> &sidx,
+        const sp<FragmentIndex> &fragmentIndex,
         const Trex *trex,
         off64_t firstMoofOffset,
         const sp<ItemTable> &itemTable,
@@ -4861,13 +4925,15 @@ MPEG4Source::MPEG4Source(
       mSampleTable(sampleTable),
       mCurrentSampleIndex(0),
       mCurrentFragmentIndex(0),
-      mSegments(sidx),
+      mFragmentIndex(fragmentIndex),
       mTrex(trex),
       mFirstMoofOffset(firstMoofOffset),
       mCurrentMoofOffset(firstMoofOffset),
       mCurrentMoofSize(0),
       mNextMoofOffset(-1),
       mCurrentTime(0),
+      mHasFragmentDecodeTime(false),
+      mFragmentDecodeTime(0),
       mDefaultEncryptedByteBlock(0),
       mDefaultSkipByteBlock(0),
       mCurrentSampleInfoAllocSize(0),
@@ -5016,7 +5082,11 @@ MPEG4Source::MPEG4Source(
 status_t MPEG4Source::init() {
     if (mFirstMoofOffset != 0) {
         off64_t offset = mFirstMoofOffset;
-        return parseChunk(&offset);
+        status_t err = parseChunk(&offset);
+        if (err == OK) {
+            indexCurrentFragment();
+        }
+        return err;
     }
     return OK;
 }
@@ -5124,6 +5194,7 @@ status_t MPEG4Source::parseChunk(off64_t *offset) {
             *offset = data_offset;
             if (chunk_type == FOURCC("moof")) {
                 mCurrentMoofSize = chunk_data_size;
+                mHasFragmentDecodeTime = false;
             }
             while (*offset < stop_offset) {
                 status_t err = parseChunk(offset);
@@ -5184,6 +5255,18 @@ status_t MPEG4Source::parseChunk(off64_t *offset) {
                 break;
         }
 
+        case FOURCC("tfdt"): {
+                status_t err;
+                if (mLastParsedTrackId == mTrackId) {
+                    if ((err = parseTrackFragmentDecodeTime(data_offset, chunk_data_size)) != OK) {
+                        return err;
+                    }
+                }
+
+                *offset += chunk_size;
+                break;
+        }
+
         case FOURCC("trun"): {
                 status_t err;
                 if (mLastParsedTrackId == mTrackId) {
@@ -5636,6 +5719,36 @@ status_t MPEG4Source::parseTrackFragmentHeader(off64_t offset, off64_t size) {
     return OK;
 }
 
+status_t MPEG4Source::parseTrackFragmentDecodeTime(off64_t offset, off64_t size) {
+    if (size < 8) {
+        return -EINVAL;
+    }
+
+    uint32_t flags;
+    if (!mDataSource->getUInt32(offset, &flags)) { // actually version + flags
+        return ERROR_MALFORMED;
+    }
+
+    uint32_t version = flags >> 24;
+    if (version == 1) {
+        if (size < 12 || !mDataSource->getUInt64(offset + 4, &mFragmentDecodeTime)) {
+            return ERROR_MALFORMED;
+        }
+    } else if (version == 0) {
+        uint32_t decodeTime;
+        if (!mDataSource->getUInt32(offset + 4, &decodeTime)) {
+            return ERROR_MALFORMED;
+        }
+        mFragmentDecodeTime = decodeTime;
+    } else {
+        // unknown version, ignore the box
+        return OK;
+    }
+
+    mHasFragmentDecodeTime = true;
+    return OK;
+}
+
 status_t MPEG4Source::parseTrackFragmentRun(off64_t offset, off64_t size) {
 
     ALOGV("MPEG4Source::parseTrackFragmentRun");
@@ -6334,6 +6447,239 @@ media_status_t MPEG4Source::read(
     }
 }
 
+void MPEG4Source::indexCurrentFragment() {
+    // The fragment just parsed starts at mCurrentTime.
+    if (mHasFragmentDecodeTime && mFragmentDecodeTime >= mCurrentTime) {
+        mFragmentIndex->setBaseDecodeTime(mTrackId, mFragmentDecodeTime - mCurrentTime);
+    }
+    mFragmentIndex->addFragment(mTrackId, mCurrentMoofOffset, mCurrentTime);
+}
+
+status_t MPEG4Source::parseFragment(const FragmentIndex::Fragment &fragment) {
+    mCurrentMoofOffset = fragment.mMoofOffset;
+    mNextMoofOffset = -1;
+    mCurrentSamples.clear();
+    mCurrentSampleIndex = 0;
+    off64_t offset = fragment.mMoofOffset;
+    status_t err = parseChunk(&offset);
+    if (err != OK) {
+        return err;
+    }
+    mCurrentTime = fragment.mTime;
+    indexCurrentFragment();
+    return OK;
+}
+
+// Moves to the fragment to read from after a seek to seekTime, in media timescale
+// ticks. As for 'sidx' segments, fragments are expected to start with a sync sample.
+status_t MPEG4Source::seekToFragment(uint64_t seekTime, ReadOptions::SeekMode mode) {
+    FragmentIndex::Fragment fragment, after;
+    if (!mFragmentIndex->findFragment(mTrackId, seekTime, &fragment, &after)) {
+        fragment.mMoofOffset = mFirstMoofOffset;
+        fragment.mTime = 0;
+    }
+    if (after.mMoofOffset < 0) {
+        // The fragments after this one are not indexed yet.
+        searchFragment(seekTime, &fragment);
+    }
+
+    status_t err = parseFragment(fragment);
+    while (err == OK && mNextMoofOffset > mCurrentMoofOffset) {
+        uint64_t endTime = fragment.mTime;
+        for (size_t i = 0; i < mCurrentSamples.size(); i++) {
+            endTime += mCurrentSamples[i].duration;
+        }
+        FragmentIndex::Fragment next = { mNextMoofOffset, endTime };
+
+        if (seekTime < endTime) {
+            // The requested time is somewhere in this fragment
+            if ((mode == ReadOptions::SEEK_NEXT_SYNC && seekTime > fragment.mTime) ||
+                (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
+                (seekTime - fragment.mTime) > (endTime - seekTime))) {
+                // requested next sync, or closest sync and it was closer to the end of
+                // this fragment
+                err = parseFragment(next);
+            }
+            break;
+        }
+        fragment = next;
+        err = parseFragment(fragment);
+    }
+    return err;
+}
+
+// Narrows down the fragment to walk from to a range of at most kMinFragmentSearchRange
+// bytes, by a binary search over the file using the decode times of the 'tfdt' boxes.
+void MPEG4Source::searchFragment(uint64_t seekTime, FragmentIndex::Fragment *fragment) {
+    uint64_t baseDecodeTime;
+    off64_t end;
+    if (!mFragmentIndex->getBaseDecodeTime(mTrackId, &baseDecodeTime)
+            || mDataSource->getSize(&end) != OK) {
+        return;
+    }
+
+    while (end - fragment->mMoofOffset > kMinFragmentSearchRange) {
+        off64_t middle = fragment->mMoofOffset + (end - fragment->mMoofOffset) / 2;
+        FragmentIndex::Fragment found;
+        if (!findFragmentFrom(middle, end, baseDecodeTime, &found)) {
+            end = middle;
+            continue;
+        }
+        ALOGV("found fragment @ %lld time %llu",
+                (long long)found.mMoofOffset, (unsigned long long)found.mTime);
+        mFragmentIndex->addFragment(mTrackId, found.mMoofOffset, found.mTime);
+        if (found.mTime <= seekTime) {
+            *fragment = found;
+        } else {
+            end = found.mMoofOffset;
+        }
+    }
+}
+
+// Finds the first fragment of this track with a 'tfdt' box in [offset, end).
+// offset may be in the middle of a box, so the moof boxes are first found by
+// their content, then by following the boxes after the first one.
+bool MPEG4Source::findFragmentFrom(off64_t offset, off64_t end, uint64_t baseDecodeTime,
+        FragmentIndex::Fragment *fragment) {
+    static const size_t kScanSize = 64 * 1024;
+    std::vector<uint8_t> buffer(kScanSize);
+
+    off64_t boxOffset = -1;
+    while (boxOffset < 0) {
+        if (offset + 16 > end) {
+            return false;
+        }
+        ssize_t n = mDataSource->readAt(
+                offset, buffer.data(), std::min((off64_t)kScanSize, end - offset));
+        if (n < 16) {
+            return false;
+        }
+        for (ssize_t i = 0; i + 16 <= n; ++i) {
+            // A moof box starts with a mfhd box.
+            if (buffer[i + 4] != 'm' || U32_AT(&buffer[i + 4]) != FOURCC("moof")
+                    || U32_AT(&buffer[i + 12]) != FOURCC("mfhd")) {
+                continue;
+            }
+            off64_t moofSize;
+            uint64_t time;
+            status_t err = probeFragment(offset + i, baseDecodeTime, &moofSize, &time);
+            if (err == OK) {
+                fragment->mMoofOffset = offset + i;
+                fragment->mTime = time;
+                return true;
+            } else if (err == NAME_NOT_FOUND) {
+                // a fragment of another track
+                boxOffset = offset + i + moofSize;
+                break;
+            }
+        }
+        offset += n - 15;
+    }
+
+    while (boxOffset + 8 <= end) {
+        uint8_t header[16];
+        if (mDataSource->readAt(boxOffset, header, 8) < 8) {
+            return false;
+        }
+        uint64_t boxSize = U32_AT(header);
+        uint32_t boxType = U32_AT(&header[4]);
+        if (boxSize == 1) {
+            if (mDataSource->readAt(boxOffset + 8, &header[8], 8) < 8) {
+                return false;
+            }
+            boxSize = U64_AT(&header[8]);
+        }
+        if (boxSize < 8 || boxSize > (uint64_t)(end - boxOffset)) {
+            // includes boxes that extend to the end of file
+            return false;
+        }
+
+        if (boxType == FOURCC("moof")) {
+            off64_t moofSize;
+            uint64_t time;
+            status_t err = probeFragment(boxOffset, baseDecodeTime, &moofSize, &time);
+            if (err == OK) {
+                fragment->mMoofOffset = boxOffset;
+                fragment->mTime = time;
+                return true;
+            } else if (err != NAME_NOT_FOUND) {
+                return false;
+            }
+        }
+        boxOffset += boxSize;
+    }
+    return false;
+}
+
+// Gets the time of the fragment at moofOffset from the 'tfdt' box of this track.
+// Returns NAME_NOT_FOUND if it is a moof box without one.
+status_t MPEG4Source::probeFragment(off64_t moofOffset, uint64_t baseDecodeTime,
+        off64_t *moofSize, uint64_t *time) {
+    uint8_t header[8];
+    if (mDataSource->readAt(moofOffset, header, sizeof(header)) < (ssize_t)sizeof(header)) {
+        return ERROR_IO;
+    }
+    uint32_t size = U32_AT(header);
+    if (U32_AT(&header[4]) != FOURCC("moof") || size < 16 || size > kMaxFragmentProbeSize) {
+        return ERROR_MALFORMED;
+    }
+    std::vector<uint8_t> moof(size - 8);
+    if (mDataSource->readAt(moofOffset + 8, moof.data(), moof.size())
+            < (ssize_t)moof.size()) {
+        return ERROR_IO;
+    }
+    *moofSize = size;
+
+    size_t offset = 0;
+    while (offset + 8 <= moof.size()) {
+        uint32_t boxSize = U32_AT(&moof[offset]);
+        uint32_t boxType = U32_AT(&moof[offset + 4]);
+        if (boxSize < 8 || boxSize > moof.size() - offset
+                || (offset == 0 && boxType != FOURCC("mfhd"))) {
+            return ERROR_MALFORMED;
+        }
+
+        if (boxType == FOURCC("traf")) {
+            int32_t trackId = -1;
+            bool hasDecodeTime = false;
+            uint64_t decodeTime = 0;
+            size_t trafEnd = offset + boxSize;
+            size_t childOffset = offset + 8;
+            while (childOffset + 8 <= trafEnd) {
+                uint32_t childSize = U32_AT(&moof[childOffset]);
+                uint32_t childType = U32_AT(&moof[childOffset + 4]);
+                if (childSize < 8 || childSize > trafEnd - childOffset) {
+                    return ERROR_MALFORMED;
+                }
+                const uint8_t *payload = &moof[childOffset + 8];
+                size_t payloadSize = childSize - 8;
+                if (childType == FOURCC("tfhd") && payloadSize >= 8) {
+                    trackId = U32_AT(&payload[4]);
+                } else if (childType == FOURCC("tfdt") && payloadSize >= 8) {
+                    if (payload[0] == 1 && payloadSize >= 12) {
+                        decodeTime = U64_AT(&payload[4]);
+                        hasDecodeTime = true;
+                    } else if (payload[0] == 0) {
+                        decodeTime = U32_AT(&payload[4]);
+                        hasDecodeTime = true;
+                    }
+                }
+                childOffset += childSize;
+            }
+
+            if (trackId == mTrackId && hasDecodeTime) {
+                if (decodeTime < baseDecodeTime) {
+                    return ERROR_MALFORMED;
+                }
+                *time = decodeTime - baseDecodeTime;
+                return OK;
+            }
+        }
+        offset += boxSize;
+    }
+    return NAME_NOT_FOUND;
+}
+
 media_status_t MPEG4Source::fragmentedRead(
         MediaBufferHelper **out, const ReadOptions *options) {
 
@@ -6366,27 +6712,24 @@ media_status_t MPEG4Source::fragmentedRead(
               ", elstShiftStartUs:%" PRIu64, seekTimeUs, elstInitialEmptyEditUs,
               elstShiftStartUs);
 
-        int numSidxEntries = mSegments.size();
-        if (numSidxEntries != 0) {
-            int64_t totalTime = 0;
-            off64_t totalOffset = mFirstMoofOffset;
-            for (int i = 0; i < numSidxEntries; i++) {
-                const SidxEntry *se = &mSegments[i];
-                if (totalTime + se->mDurationUs > seekTimeUs) {
-                    // The requested time is somewhere in this segment
-                    if ((mode == ReadOptions::SEEK_NEXT_SYNC && seekTimeUs > totalTime) ||
-                        (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
-                        (seekTimeUs - totalTime) > (totalTime + se->mDurationUs - seekTimeUs))) {
-                        // requested next sync, or closest sync and it was closer to the end of
-                        // this segment
-                        totalTime += se->mDurationUs;
-                        totalOffset += se->mSize;
-                    }
-                    break;
+        if (mFragmentIndex->countSegments() != 0) {
+            int64_t totalTime;
+            uint32_t durationUs;
+            off64_t totalOffset;
+            size_t size;
+            if (mFragmentIndex->findSegment(
+                    seekTimeUs, &totalTime, &durationUs, &totalOffset, &size)) {
+                // The requested time is somewhere in this segment
+                if ((mode == ReadOptions::SEEK_NEXT_SYNC && seekTimeUs > totalTime) ||
+                    (mode == ReadOptions::SEEK_CLOSEST_SYNC &&
+                    (seekTimeUs - totalTime) > (totalTime + durationUs - seekTimeUs))) {
+                    // requested next sync, or closest sync and it was closer to the end of
+                    // this segment
+                    totalTime += durationUs;
+                    totalOffset += size;
                 }
-                totalTime += se->mDurationUs;
-                totalOffset += se->mSize;
             }
+            totalOffset += mFirstMoofOffset;
             mCurrentMoofOffset = totalOffset;
             mNextMoofOffset = -1;
             mCurrentSamples.clear();
@@ -6397,17 +6740,11 @@ media_status_t MPEG4Source::fragmentedRead(
             }
             mCurrentTime = totalTime * mTimescale / 1000000ll;
         } else {
-            // without sidx boxes, we can only seek to 0
-            mCurrentMoofOffset = mFirstMoofOffset;
-            mNextMoofOffset = -1;
-            mCurrentSamples.clear();
-            mCurrentSampleIndex = 0;
-            off64_t tmp = mCurrentMoofOffset;
-            status_t err = parseChunk(&tmp);
+            uint64_t seekTime = seekTimeUs > 0 ? seekTimeUs * mTimescale / 1000000ll : 0;
+            status_t err = seekToFragment(seekTime, mode);
             if (err != OK) {
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            mCurrentTime = 0;
         }
 
         if (mBuffer != NULL) {
@@ -6443,6 +6780,7 @@ media_status_t MPEG4Source::fragmentedRead(
             if (err != OK) {
                 return AMEDIA_ERROR_UNKNOWN;
             }
+            indexCurrentFragment();
             if (mCurrentSampleIndex >= mCurrentSamples.size()) {
                 return AMEDIA_ERROR_END_OF_STREAM;
             }
@@ -32,7 +32,9 @@
 namespace android {
 struct AMessage;
 struct CDataSource;
+class CachedRangedDataSource;
 class DataSourceHelper;
+class FragmentIndex;
 class SampleTable;
 class String8;
 namespace heif {
@@ -40,11 +42,6 @@ class ItemTable;
 }
 using heif::ItemTable;
 
-struct SidxEntry {
-    size_t mSize;
-    uint32_t mDurationUs;
-};
-
 struct Trex {
     uint32_t track_ID;
     uint32_t default_sample_description_index;
@@ -128,7 +125,7 @@ private:
 
     static const int kTx3gGrowth = 16 * 1024;
 
-    Vector<SidxEntry> mSidxEntries;
+    sp<FragmentIndex> mFragmentIndex;
     off64_t mMoofOffset;
     bool mMoofFound;
     bool mMdatFound;
@@ -145,6 +142,9 @@ private:
     bool mHasMoovBox;
     bool mPreferHeif;
 
+    // Sources caching the moov box, or the meta box of HEIF files, while they are parsed.
+    Vector<CachedRangedDataSource *> mHeaderCaches;
+
     Track *mFirstTrack, *mLastTrack;
 
     AMediaFormat *mFileMetaData;
@@ -157,6 +157,7 @@ private:
     KeyedVector<uint32_t, AString> mMetaKeyMap;
 
     status_t readMetaData();
+    void cacheHeaderBox(off64_t offset, size_t size);
     status_t parseChunk(off64_t *offset, int depth);
     status_t parseITunesMetaData(off64_t offset, size_t size);
     status_t parseColorInfo(off64_t offset, size_t size);
@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "SampleTable.h"
@@ -125,10 +126,15 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mSampleSizeFieldSize(0),
       mDefaultSampleSize(0),
       mNumSampleSizes(0),
+      mSampleSizeBlockUse(0),
+      mHasMaxSampleSize(false),
+      mMaxSampleSize(0),
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mSortedTimeBlockUse(0),
+      mSampleTimeTableBuilt(false),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -138,6 +144,14 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mLastSyncSampleIndex(0),
       mSampleToChunkEntries(NULL),
       mTotalSize(0) {
+    for (size_t i = 0; i < kNumSampleSizeBlocks; ++i) {
+        mSampleSizeBlocks[i].mBlockIndex = UINT32_MAX;
+        mSampleSizeBlocks[i].mLastUse = 0;
+    }
+    for (size_t i = 0; i < kNumSortedTimeBlocks; ++i) {
+        mSortedTimeBlocks[i].mBlockIndex = SIZE_MAX;
+        mSortedTimeBlocks[i].mLastUse = 0;
+    }
     mSampleIterator = new SampleIterator(this);
 }
 
@@ -595,19 +609,32 @@ status_t SampleTable::getMaxSampleSize(size_t *max_size) {
 
     *max_size = 0;
 
-    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
-        size_t sample_size;
-        status_t err = getSampleSize_l(i, &sample_size);
-
-        if (err != OK) {
-            return err;
+    if (mDefaultSampleSize > 0) {
+        if (mNumSampleSizes > 0) {
+            *max_size = mDefaultSampleSize;
         }
+        return OK;
+    }
+
+    if (!mHasMaxSampleSize) {
+        size_t maxSampleSize = 0;
+        for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+            size_t sample_size;
+            status_t err = getSampleSize_l(i, &sample_size);
+
+            if (err != OK) {
+                return err;
+            }
 
-        if (sample_size > *max_size) {
-            *max_size = sample_size;
+            if (sample_size > maxSampleSize) {
+                maxSampleSize = sample_size;
+            }
         }
+        mMaxSampleSize = maxSampleSize;
+        mHasMaxSampleSize = true;
     }
 
+    *max_size = mMaxSampleSize;
     return OK;
 }
 
@@ -629,15 +656,191 @@ int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
     return 0;
 }
 
-void SampleTable::buildSampleEntriesTable() {
-    Mutex::Autolock autoLock(mLock);
+uint64_t SampleTable::nextCompositionTime(
+        SampleTimeCursor *cursor, bool *inTable) const {
+    while (cursor->mTimeToSampleIndex < mTimeToSampleCount
+            && cursor->mTimeToSampleOffset
+                    >= mTimeToSample[2 * cursor->mTimeToSampleIndex]) {
+        ++cursor->mTimeToSampleIndex;
+        cursor->mTimeToSampleOffset = 0;
+    }
+
+    if (cursor->mTimeToSampleIndex >= mTimeToSampleCount) {
+        *inTable = false;
+        return 0;
+    }
+    *inTable = true;
+
+    int32_t compTimeDelta = 0;
+    if (mCompositionTimeDeltaEntries != NULL) {
+        while (cursor->mDeltaIndex < mNumCompositionTimeDeltaEntries
+                && cursor->mDeltaOffset
+                        >= (uint32_t)mCompositionTimeDeltaEntries[2 * cursor->mDeltaIndex]) {
+            ++cursor->mDeltaIndex;
+            cursor->mDeltaOffset = 0;
+        }
+        if (cursor->mDeltaIndex < mNumCompositionTimeDeltaEntries) {
+            compTimeDelta = mCompositionTimeDeltaEntries[2 * cursor->mDeltaIndex + 1];
+        }
+        ++cursor->mDeltaOffset;
+    }
+
+    uint64_t &sampleTime = cursor->mDecodingTime;
+    if ((compTimeDelta < 0 && sampleTime <
+            (compTimeDelta == INT32_MIN ?
+                    INT32_MAX : uint32_t(-compTimeDelta)))
+            || (compTimeDelta > 0 &&
+                    sampleTime > UINT64_MAX - compTimeDelta)) {
+        ALOGE("%llu + %d would overflow, clamping",
+                (unsigned long long) sampleTime, compTimeDelta);
+        if (compTimeDelta < 0) {
+            sampleTime = 0;
+        } else {
+            sampleTime = UINT64_MAX;
+        }
+        compTimeDelta = 0;
+    }
+
+    uint64_t compositionTime = compTimeDelta > 0 ? sampleTime + compTimeDelta:
+            sampleTime - (-compTimeDelta);
+
+    uint32_t delta = mTimeToSample[2 * cursor->mTimeToSampleIndex + 1];
+    ++cursor->mTimeToSampleOffset;
+    if (sampleTime > UINT64_MAX - delta) {
+        ALOGE("%llu + %u would overflow, clamping",
+            (unsigned long long) sampleTime, delta);
+        sampleTime = UINT64_MAX;
+    } else {
+        sampleTime += delta;
+    }
+
+    return compositionTime;
+}
+
+bool SampleTable::buildSampleTimeBlocks_l() {
+    size_t maxBlockSamples = 0;
+    auto addBlock = [this, &maxBlockSamples](SampleTimeBlock block, uint32_t endSample) {
+        // Merge with the previous blocks the samples of which are presented later.
+        while (!mSampleTimeBlocks.empty()
+                && block.mMinTime < mSampleTimeBlocks.back().mMaxTime) {
+            const SampleTimeBlock &previous = mSampleTimeBlocks.back();
+            block.mFirstSample = previous.mFirstSample;
+            block.mCursor = previous.mCursor;
+            block.mMinTime = std::min(block.mMinTime, previous.mMinTime);
+            block.mMaxTime = std::max(block.mMaxTime, previous.mMaxTime);
+            mSampleTimeBlocks.pop_back();
+        }
+        maxBlockSamples = std::max(maxBlockSamples, (size_t)(endSample - block.mFirstSample));
+        mSampleTimeBlocks.push_back(block);
+    };
+
+    SampleTimeCursor cursor = { 0, 0, 0, 0, 0 };
+    SampleTimeBlock block = { 0, cursor, UINT64_MAX, 0 };
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        SampleTimeCursor start = cursor;
+        bool inTable;
+        uint64_t time = nextCompositionTime(&cursor, &inTable);
+        if (!inTable) {
+            // 'stts' does not cover every sample.
+            mSampleTimeBlocks.clear();
+            return false;
+        }
+
+        // A block ends before a sample presented after all samples of the block,
+        // which is usually the next reference frame.
+        if (i - block.mFirstSample >= kSampleTimeBlockSamples && time >= block.mMaxTime) {
+            addBlock(block, i);
+            block.mFirstSample = i;
+            block.mCursor = start;
+            block.mMinTime = time;
+            block.mMaxTime = time;
+        } else {
+            block.mMinTime = std::min(block.mMinTime, time);
+            block.mMaxTime = std::max(block.mMaxTime, time);
+        }
+    }
+    addBlock(block, mNumSampleSizes);
+
+    uint64_t size = (uint64_t)mSampleTimeBlocks.size() * sizeof(SampleTimeBlock)
+            + (uint64_t)kNumSortedTimeBlocks * maxBlockSamples * sizeof(SampleTimeEntry);
+    if (mTotalSize + size > kMaxTotalSize) {
+        mSampleTimeBlocks.clear();
+        return false;
+    }
+    mTotalSize += size;
+
+    ALOGV("%u samples in %zu time blocks of up to %zu samples",
+            mNumSampleSizes, mSampleTimeBlocks.size(), maxBlockSamples);
+    return true;
+}
+
+SampleTable::SampleTimeEntry SampleTable::getSampleTimeEntry_l(size_t rank) {
+    if (mSampleTimeEntries != NULL) {
+        return mSampleTimeEntries[rank];
+    }
+
+    // The block holding rank is the last one starting at or before it.
+    size_t blockIndex = std::upper_bound(
+            mSampleTimeBlocks.begin(), mSampleTimeBlocks.end(), rank,
+            [](size_t value, const SampleTimeBlock &block) {
+                return value < block.mFirstSample;
+            }) - mSampleTimeBlocks.begin() - 1;
+    const SampleTimeBlock &block = mSampleTimeBlocks[blockIndex];
+
+    SortedTimeBlock *sorted = NULL;
+    SortedTimeBlock *oldest = &mSortedTimeBlocks[0];
+    for (size_t i = 0; i < kNumSortedTimeBlocks; ++i) {
+        if (mSortedTimeBlocks[i].mBlockIndex == blockIndex) {
+            sorted = &mSortedTimeBlocks[i];
+            break;
+        }
+        if (mSortedTimeBlocks[i].mLastUse < oldest->mLastUse) {
+            oldest = &mSortedTimeBlocks[i];
+        }
+    }
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (sorted == NULL) {
+        uint32_t endSample = blockIndex + 1 < mSampleTimeBlocks.size()
+                ? mSampleTimeBlocks[blockIndex + 1].mFirstSample : mNumSampleSizes;
+        sorted = oldest;
+        sorted->mBlockIndex = blockIndex;
+        sorted->mEntries.resize(endSample - block.mFirstSample);
+
+        SampleTimeCursor cursor = block.mCursor;
+        for (size_t i = 0; i < sorted->mEntries.size(); ++i) {
+            bool inTable;
+            sorted->mEntries[i].mSampleIndex = block.mFirstSample + i;
+            sorted->mEntries[i].mCompositionTime = nextCompositionTime(&cursor, &inTable);
+        }
+        qsort(sorted->mEntries.data(), sorted->mEntries.size(), sizeof(SampleTimeEntry),
+              CompareIncreasingTime);
+    }
+    sorted->mLastUse = ++mSortedTimeBlockUse;
+
+    return sorted->mEntries[rank - block.mFirstSample];
+}
+
+uint64_t SampleTable::getSampleTime_l(
+        size_t sample_index, uint64_t scale_num, uint64_t scale_den) {
+    if (sample_index >= (size_t)mNumSampleSizes || scale_den == 0
+            || (mSampleTimeEntries == NULL && mSampleTimeBlocks.empty())) {
+        return 0;
+    }
+    return (getSampleTimeEntry_l(sample_index).mCompositionTime * scale_num) / scale_den;
+}
+
+void SampleTable::buildSampleEntriesTable_l() {
+    if (mSampleTimeTableBuilt || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
+    mSampleTimeTableBuilt = true;
+
+    if (buildSampleTimeBlocks_l()) {
+        return;
+    }
 
     mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
     if (mTotalSize > kMaxTotalSize) {
@@ -717,9 +920,11 @@ void SampleTable::buildSampleEntriesTable() {
 status_t SampleTable::findSampleAtTime(
         uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
         uint32_t *sample_index, uint32_t flags) {
-    buildSampleEntriesTable();
+    Mutex::Autolock autoLock(mLock);
+
+    buildSampleEntriesTable_l();
 
-    if (mSampleTimeEntries == NULL) {
+    if (mSampleTimeEntries == NULL && mSampleTimeBlocks.empty()) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,23 +932,39 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSampleTimeEntry_l(req_time).mSampleIndex;
         return OK;
     }
 
     uint32_t left = 0;
     uint32_t right_plus_one = mNumSampleSizes;
+    if (mSampleTimeEntries == NULL && scale_den != 0) {
+        // Only the first block presented at or after req_time needs to be searched.
+        size_t blockIndex = std::lower_bound(
+                mSampleTimeBlocks.begin(), mSampleTimeBlocks.end(), req_time,
+                [scale_num, scale_den](const SampleTimeBlock &block, uint64_t value) {
+                    return (block.mMaxTime * scale_num) / scale_den < value;
+                }) - mSampleTimeBlocks.begin();
+        if (blockIndex == mSampleTimeBlocks.size()) {
+            left = mNumSampleSizes;
+        } else {
+            left = mSampleTimeBlocks[blockIndex].mFirstSample;
+            if (blockIndex + 1 < mSampleTimeBlocks.size()) {
+                right_plus_one = mSampleTimeBlocks[blockIndex + 1].mFirstSample;
+            }
+        }
+    }
     while (left < right_plus_one) {
         uint32_t center = left + (right_plus_one - left) / 2;
         uint64_t centerTime =
-            getSampleTime(center, scale_num, scale_den);
+            getSampleTime_l(center, scale_num, scale_den);
 
         if (req_time < centerTime) {
             right_plus_one = center;
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSampleTimeEntry_l(center).mSampleIndex;
             return OK;
         }
     }
@@ -783,16 +1004,16 @@ status_t SampleTable::findSampleAtTime(
             CHECK(flags == kFlagClosest);
             // pick closest based on timestamp. use abs_difference for safety
             if (abs_difference(
-                    getSampleTime(closestIndex, scale_num, scale_den), req_time) >
+                    getSampleTime_l(closestIndex, scale_num, scale_den), req_time) >
                 abs_difference(
-                    req_time, getSampleTime(closestIndex - 1, scale_num, scale_den))) {
+                    req_time, getSampleTime_l(closestIndex - 1, scale_num, scale_den))) {
                 --closestIndex;
             }
             break;
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSampleTimeEntry_l(closestIndex).mSampleIndex;
     return OK;
 }
 
@@ -945,6 +1166,87 @@ status_t SampleTable::getSampleSize_l(
             sampleIndex, sampleSize);
 }
 
+status_t SampleTable::readSampleSize_l(
+        uint32_t sampleIndex, size_t *sampleSize) {
+    uint32_t blockIndex = sampleIndex / kSampleSizeBlockSamples;
+
+    SampleSizeBlock *block = NULL;
+    SampleSizeBlock *oldest = &mSampleSizeBlocks[0];
+    for (size_t i = 0; i < kNumSampleSizeBlocks; ++i) {
+        if (mSampleSizeBlocks[i].mBlockIndex == blockIndex) {
+            block = &mSampleSizeBlocks[i];
+            break;
+        }
+        if (mSampleSizeBlocks[i].mLastUse < oldest->mLastUse) {
+            oldest = &mSampleSizeBlocks[i];
+        }
+    }
+
+    if (block == NULL) {
+        // kSampleSizeBlockSamples is even, so blocks of 4 bit fields start on a byte.
+        uint32_t firstSample = blockIndex * kSampleSizeBlockSamples;
+        uint32_t numSamples = std::min(mNumSampleSizes - firstSample,
+                (uint32_t)kSampleSizeBlockSamples);
+        off64_t offset = mSampleSizeOffset + 12
+                + ((uint64_t)firstSample * mSampleSizeFieldSize) / 8;
+        size_t size = ((uint64_t)numSamples * mSampleSizeFieldSize + 7) / 8;
+
+        block = oldest;
+        block->mData.resize(size);
+        ssize_t n = mDataSource->readAt(offset, block->mData.data(), size);
+        // Keep what could be read, the sizes past the end of a truncated file
+        // are reported as an error below.
+        block->mData.resize(n > 0 ? n : 0);
+        block->mBlockIndex = blockIndex;
+    }
+    block->mLastUse = ++mSampleSizeBlockUse;
+
+    uint32_t i = sampleIndex % kSampleSizeBlockSamples;
+    const uint8_t *data = block->mData.data();
+    size_t available = block->mData.size();
+    switch (mSampleSizeFieldSize) {
+        case 32:
+        {
+            if (4 * (size_t)i + 4 > available) {
+                return ERROR_IO;
+            }
+            *sampleSize = U32_AT(&data[4 * i]);
+            break;
+        }
+
+        case 16:
+        {
+            if (2 * (size_t)i + 2 > available) {
+                return ERROR_IO;
+            }
+            *sampleSize = U16_AT(&data[2 * i]);
+            break;
+        }
+
+        case 8:
+        {
+            if ((size_t)i + 1 > available) {
+                return ERROR_IO;
+            }
+            *sampleSize = data[i];
+            break;
+        }
+
+        default:
+        {
+            CHECK_EQ(mSampleSizeFieldSize, 4u);
+
+            if ((size_t)i / 2 + 1 > available) {
+                return ERROR_IO;
+            }
+            *sampleSize = (i & 1) ? data[i / 2] & 0x0f : data[i / 2] >> 4;
+            break;
+        }
+    }
+
+    return OK;
+}
+
 uint32_t SampleTable::getLastSampleIndexInChunk() {
     Mutex::Autolock autoLock(mLock);
     return mSampleIterator->getLastSampleIndexInChunk();
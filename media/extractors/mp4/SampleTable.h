@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <stdint.h>
 
+#include <vector>
+
 #include <media/MediaExtractorPluginHelper.h>
 #include <media/stagefright/MediaErrors.h>
 #include <utils/RefBase.h>
@@ -122,6 +124,20 @@ private:
     uint32_t mDefaultSampleSize;
     uint32_t mNumSampleSizes;
 
+    // Sample sizes are read from the 'stsz' or 'stz2' box a block of
+    // kSampleSizeBlockSamples at a time, and the most recently used blocks are kept.
+    static const uint32_t kSampleSizeBlockSamples = 4096;
+    static const size_t kNumSampleSizeBlocks = 4;
+    struct SampleSizeBlock {
+        uint32_t mBlockIndex;
+        uint32_t mLastUse;
+        std::vector<uint8_t> mData;
+    };
+    SampleSizeBlock mSampleSizeBlocks[kNumSampleSizeBlocks];
+    uint32_t mSampleSizeBlockUse;
+    bool mHasMaxSampleSize;
+    size_t mMaxSampleSize;
+
     bool mHasTimeToSample;
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
@@ -132,6 +148,36 @@ private:
     };
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Instead of keeping mSampleTimeEntries for every sample, samples are split in
+    // decode order into blocks whose composition times do not overlap, so that the
+    // samples sorted by composition time are the sorted blocks one after the other.
+    // Only the position of each block in 'stts' and 'ctts' is kept, and a few blocks
+    // are sorted on demand. mSampleTimeEntries is used if the tables are malformed.
+    static const uint32_t kSampleTimeBlockSamples = 1024;
+    static const size_t kNumSortedTimeBlocks = 2;
+    struct SampleTimeCursor {
+        uint32_t mTimeToSampleIndex;
+        uint32_t mTimeToSampleOffset;
+        uint32_t mDeltaIndex;
+        uint32_t mDeltaOffset;
+        uint64_t mDecodingTime;
+    };
+    struct SampleTimeBlock {
+        uint32_t mFirstSample;
+        SampleTimeCursor mCursor;
+        uint64_t mMinTime;
+        uint64_t mMaxTime;
+    };
+    std::vector<SampleTimeBlock> mSampleTimeBlocks;
+    struct SortedTimeBlock {
+        size_t mBlockIndex;
+        uint32_t mLastUse;
+        std::vector<SampleTimeEntry> mEntries;
+    };
+    SortedTimeBlock mSortedTimeBlocks[kNumSortedTimeBlocks];
+    uint32_t mSortedTimeBlockUse;
+    bool mSampleTimeTableBuilt;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -156,19 +202,21 @@ private:
     friend struct SampleIterator;
 
     // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
-    }
+    uint64_t getSampleTime_l(
+            size_t sample_index, uint64_t scale_num, uint64_t scale_den);
+
+    // Returns the sample with the given rank in composition time order.
+    SampleTimeEntry getSampleTimeEntry_l(size_t rank);
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
+    status_t readSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
     static int CompareIncreasingTime(const void *, const void *);
 
-    void buildSampleEntriesTable();
+    uint64_t nextCompositionTime(SampleTimeCursor *cursor, bool *inTable) const;
+    void buildSampleEntriesTable_l();
+    bool buildSampleTimeBlocks_l();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
@@ -49,6 +49,10 @@ using hardware::cas::V1_0::ICas;
 static const size_t kTSPacketSize = 188;
 static const int kMaxDurationReadSize = 250000LL;
 static const int kMaxDurationRetry = 6;
+// Seeks past the known sync points bisect the file down to this range,
+// and parse it from its start to the sync point.
+static const off64_t kMinSeekProbeRange = 2 * 1024 * 1024;
+static const off64_t kMaxSeekProbeSize = 8 * 1024 * 1024;
 
 struct MPEG2TSSource : public MediaTrackHelper {
     MPEG2TSSource(
@@ -236,6 +240,11 @@ MPEG2TSExtractor::MPEG2TSExtractor(DataSourceHelper *source)
     : mDataSource(source),
       mParser(new ATSParser),
       mLastSyncEvent(0),
+      mSeekSyncPoints(NULL),
+      mSeekSourceType(ATSParser::VIDEO),
+      mPastSyncPoints(false),
+      mLastSeekSyncTimeUs(-1),
+      mFirstPTSTimeUs(-1),
       mOffset(0) {
     char header;
     if (source->readAt(0, &header, 1) == 1 && header == 0x47) {
@@ -350,6 +359,7 @@ void MPEG2TSExtractor::init() {
                     if (!isScrambledFormat(*(format.get()))) {
                         if (findIndexOfSource(impl, &index) == OK) {
                             mSeekSyncPoints = &mSyncPoints.editItemAt(index);
+                            mSeekSourceType = ATSParser::VIDEO;
                         }
                     }
                 }
@@ -367,6 +377,7 @@ void MPEG2TSExtractor::init() {
                     if (!isScrambledFormat(*(format.get())) && !haveVideo) {
                         if (findIndexOfSource(impl, &index) == OK) {
                             mSeekSyncPoints = &mSyncPoints.editItemAt(index);
+                            mSeekSourceType = ATSParser::AUDIO;
                         }
                     }
                 }
@@ -392,6 +403,8 @@ void MPEG2TSExtractor::init() {
         }
     }
 
+    mFirstPTSTimeUs = mParser->getFirstPTSTimeUs();
+
     off64_t size;
     if (mDataSource->getSize(&size) == OK && (haveAudio || haveVideo)) {
         size_t prevSyncSize = 1;
@@ -495,6 +508,13 @@ void MPEG2TSExtractor::addSyncPoint_l(const ATSParser::SyncEvent &event) {
     for (size_t i = 0; i < mSourceImpls.size(); ++i) {
         if (mSourceImpls[i].get() == event.getMediaSource().get()) {
             KeyedVector<int64_t, off64_t> *syncPoints = &mSyncPoints.editItemAt(i);
+            if (syncPoints == mSeekSyncPoints) {
+                mLastSeekSyncTimeUs = event.getTimeUs();
+                if (mPastSyncPoints) {
+                    // Keep mSeekSyncPoints free of gaps.
+                    syncPoints = &mProbedSyncPoints;
+                }
+            }
             syncPoints->add(event.getTimeUs(), event.getOffset());
             // We're keeping the size of the sync points at most 5mb per a track.
             size_t size = syncPoints->size();
@@ -627,6 +647,19 @@ status_t MPEG2TSExtractor::seek(int64_t seekTimeUs,
     bool shouldSeekBeyond =
             (seekTimeUs > mSeekSyncPoints->keyAt(mSeekSyncPoints->size() - 1));
 
+    if (shouldSeekBeyond) {
+        status_t err = seekToProbedSyncPoint(seekTimeUs);
+        if (err == OK) {
+            err = seekBeyond(seekTimeUs);
+            if (err != OK) {
+                return err;
+            }
+            return fastForwardToSync();
+        } else if (err != NAME_NOT_FOUND) {
+            return err;
+        }
+    }
+
     // Determine the sync point to seek.
     size_t index = 0;
     for (; index < mSeekSyncPoints->size(); ++index) {
@@ -659,9 +692,14 @@ status_t MPEG2TSExtractor::seek(int64_t seekTimeUs,
         default:
             return ERROR_UNSUPPORTED;
     }
-    if (!shouldSeekBeyond || mOffset <= mSeekSyncPoints->valueAt(index)) {
+    if (!shouldSeekBeyond || mPastSyncPoints || mOffset <= mSeekSyncPoints->valueAt(index)) {
         int64_t actualSeekTimeUs = mSeekSyncPoints->keyAt(index);
-        mOffset = mSeekSyncPoints->valueAt(index);
+        {
+            Mutex::Autolock autoLock(mLock);
+            mOffset = mSeekSyncPoints->valueAt(index);
+            mPastSyncPoints = false;
+            mLastSeekSyncTimeUs = actualSeekTimeUs;
+        }
         status_t err = queueDiscontinuityForSeek(actualSeekTimeUs);
         if (err != OK) {
             return err;
@@ -675,6 +713,10 @@ status_t MPEG2TSExtractor::seek(int64_t seekTimeUs,
         }
     }
 
+    return fastForwardToSync();
+}
+
+status_t MPEG2TSExtractor::fastForwardToSync() {
     // Fast-forward to sync frame.
     for (size_t i = 0; i < mSourceImpls.size(); ++i) {
         const sp<AnotherPacketSource> &impl = mSourceImpls[i];
@@ -739,14 +781,13 @@ status_t MPEG2TSExtractor::queueDiscontinuityForSeek(int64_t actualSeekTimeUs) {
 
 status_t MPEG2TSExtractor::seekBeyond(int64_t seekTimeUs) {
     // If we're seeking beyond where we know --- read until we reach there.
-    size_t syncPointsSize = mSeekSyncPoints->size();
+    int64_t lastSyncTimeUs = mLastSeekSyncTimeUs;
 
-    while (seekTimeUs > mSeekSyncPoints->keyAt(
-            mSeekSyncPoints->size() - 1)) {
+    while (seekTimeUs > mLastSeekSyncTimeUs) {
         status_t err;
-        if (syncPointsSize < mSeekSyncPoints->size()) {
-            syncPointsSize = mSeekSyncPoints->size();
-            int64_t syncTimeUs = mSeekSyncPoints->keyAt(syncPointsSize - 1);
+        if (lastSyncTimeUs < mLastSeekSyncTimeUs) {
+            lastSyncTimeUs = mLastSeekSyncTimeUs;
+            int64_t syncTimeUs = lastSyncTimeUs;
             // Dequeue buffers before sync point in order to avoid too much
             // cache building up.
             sp<ABuffer> buffer;
@@ -773,6 +814,112 @@ status_t MPEG2TSExtractor::seekBeyond(int64_t seekTimeUs) {
     return OK;
 }
 
+status_t MPEG2TSExtractor::seekToProbedSyncPoint(int64_t seekTimeUs) {
+    // Only local files are probed, the same as for estimating their duration.
+    off64_t size;
+    if (!(mDataSource->flags() & DataSourceBase::kIsLocalFileSource)
+            || mFirstPTSTimeUs < 0 || mDataSource->getSize(&size) != OK) {
+        return NAME_NOT_FOUND;
+    }
+
+    // The sync point closest before seekTimeUs is between the last known one
+    // before it and the first known one after it.
+    size_t last = mSeekSyncPoints->size() - 1;
+    const off64_t knownOffset = mSeekSyncPoints->valueAt(last);
+    int64_t lowTimeUs = mSeekSyncPoints->keyAt(last);
+    off64_t lowOffset = knownOffset;
+    off64_t highOffset = size;
+    {
+        Mutex::Autolock autoLock(mLock);
+        for (size_t i = 0; i < mProbedSyncPoints.size(); ++i) {
+            int64_t timeUs = mProbedSyncPoints.keyAt(i);
+            off64_t offset = mProbedSyncPoints.valueAt(i);
+            if (timeUs <= seekTimeUs) {
+                if (timeUs > lowTimeUs && offset > lowOffset) {
+                    lowTimeUs = timeUs;
+                    lowOffset = offset;
+                }
+            } else if (offset < highOffset) {
+                highOffset = offset;
+            }
+        }
+    }
+
+    const off64_t packetSize = kTSPacketSize + mHeaderSkip;
+    while (highOffset - lowOffset > kMinSeekProbeRange) {
+        off64_t offset = lowOffset + (highOffset - lowOffset) / 2;
+        offset -= offset % packetSize;
+
+        int64_t timeUs;
+        off64_t syncOffset;
+        status_t err = probeSyncPoint(offset, highOffset, &timeUs, &syncOffset);
+        if (err != OK) {
+            // There may be sync points too far apart to be found in the upper half,
+            // the parser reads through them from the lower bound.
+            highOffset = offset;
+            continue;
+        }
+
+        {
+            Mutex::Autolock autoLock(mLock);
+            mProbedSyncPoints.add(timeUs, syncOffset);
+        }
+        if (timeUs <= seekTimeUs) {
+            lowTimeUs = timeUs;
+            lowOffset = syncOffset;
+        } else {
+            highOffset = offset;
+        }
+    }
+
+    if (lowOffset == knownOffset) {
+        return NAME_NOT_FOUND;
+    }
+
+    ALOGV("seeking to probed sync point %" PRId64 " at %lld for %" PRId64,
+            lowTimeUs, (long long)lowOffset, seekTimeUs);
+    {
+        Mutex::Autolock autoLock(mLock);
+        mOffset = lowOffset;
+        mPastSyncPoints = true;
+        mLastSeekSyncTimeUs = lowTimeUs;
+    }
+    return queueDiscontinuityForSeek(lowTimeUs);
+}
+
+status_t MPEG2TSExtractor::probeSyncPoint(
+        off64_t offset, off64_t limit, int64_t *timeUs, off64_t *syncOffset) {
+    sp<ATSParser> parser = new ATSParser(ATSParser::TS_TIMESTAMPS_ARE_ABSOLUTE);
+    limit = min(limit, offset + kMaxSeekProbeSize);
+
+    uint8_t packet[kTSPacketSize];
+    while (offset < limit) {
+        ssize_t n = mDataSource->readAt(offset + mHeaderSkip, packet, kTSPacketSize);
+        if (n < (ssize_t)kTSPacketSize) {
+            return (n < 0) ? (status_t)n : ERROR_END_OF_STREAM;
+        }
+
+        ATSParser::SyncEvent event(offset);
+        offset += mHeaderSkip + n;
+        status_t err = parser->feedTSPacket(packet, kTSPacketSize, &event);
+        if (err != OK) {
+            return err;
+        }
+
+        if (event.hasReturnedData() && event.getType() == mSeekSourceType) {
+            // The probe parser starts from the PTS of the packets it reads, without
+            // knowing whether the PTS wrapped around since the start of the file.
+            if (event.getTimeUs() < mFirstPTSTimeUs) {
+                return ERROR_UNSUPPORTED;
+            }
+            *timeUs = event.getTimeUs() - mFirstPTSTimeUs;
+            *syncOffset = event.getOffset();
+            return OK;
+        }
+    }
+    return NAME_NOT_FOUND;
+}
+
 status_t MPEG2TSExtractor::feedUntilBufferAvailable(
         const sp<AnotherPacketSource> &impl) {
     status_t finalResult;
@@ -74,6 +74,18 @@ private:
     // Sync points used for seeking --- normally one for video track is used.
     // If no video track is present, audio track will be used instead.
     KeyedVector<int64_t, off64_t> *mSeekSyncPoints;
+    ATSParser::SourceType mSeekSourceType;
+
+    // Sparse sync points of the seek track past the ones above, which cover the
+    // file from its start. They are probed by bisection when seeking past the
+    // known area, and added by playback after such a seek.
+    KeyedVector<int64_t, off64_t> mProbedSyncPoints;
+    // Whether the parser was moved to a probed sync point.
+    bool mPastSyncPoints;
+    // Time of the last sync point of the seek track fed to the parser.
+    int64_t mLastSeekSyncTimeUs;
+    // Absolute time of the first PTS, that the times of the sync points are relative to.
+    int64_t mFirstPTSTimeUs;
 
     off64_t mOffset;
 
@@ -92,7 +104,14 @@ private:
     status_t seek(int64_t seekTimeUs,
             const MediaTrackHelper::ReadOptions::SeekMode& seekMode);
     status_t queueDiscontinuityForSeek(int64_t actualSeekTimeUs);
+    status_t fastForwardToSync();
     status_t seekBeyond(int64_t seekTimeUs);
+    // Moves the parser to the probed sync point closest before seekTimeUs, past the
+    // sync points known so far. Returns NAME_NOT_FOUND if there is none.
+    status_t seekToProbedSyncPoint(int64_t seekTimeUs);
+    // Finds the first sync point of the seek track at or after offset, parsing at
+    // most up to limit with a parser of its own.
+    status_t probeSyncPoint(off64_t offset, off64_t limit, int64_t *timeUs, off64_t *syncOffset);
 
     status_t feedUntilBufferAvailable(const sp<AnotherPacketSource> &impl);
     status_t findIndexOfSource(const sp<AnotherPacketSource> &impl, size_t *index);
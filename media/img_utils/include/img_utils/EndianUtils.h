@@ -120,6 +120,9 @@ class ANDROID_API EndianOutput : public Output {
         virtual status_t write(const double* buf, size_t offset, size_t count);
 
     protected:
+        // Size of the stack buffer used to batch endian-converted values into a single write.
+        static const size_t kWriteChunkBytes = 512;
+
         template<typename T>
         inline status_t writeHelper(const T* buf, size_t offset, size_t count);
 
@@ -133,32 +136,28 @@ inline status_t EndianOutput::writeHelper(const T* buf, size_t offset, size_t co
     assert(offset <= count);
     status_t res = OK;
     size_t size = sizeof(T);
-    switch(mEndian) {
-        case BIG: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToBigEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+    if (mEndian != BIG && mEndian != LITTLE) {
+        return BAD_VALUE;
+    }
+
+    // Convert a chunk of values at a time and pass each chunk to the output in one call
+    const size_t chunkCount = kWriteChunkBytes / size;
+    T tmp[kWriteChunkBytes / sizeof(T)];
+    for (size_t i = offset; i < count; i += chunkCount) {
+        size_t n = (count - i < chunkCount) ? count - i : chunkCount;
+        if (mEndian == BIG) {
+            for (size_t j = 0; j < n; ++j) {
+                tmp[j] = convertToBigEndian<T>(buf[offset + i + j]);
             }
-            break;
-        }
-        case LITTLE: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToLittleEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                tmp[j] = convertToLittleEndian<T>(buf[offset + i + j]);
             }
-            break;
         }
-        default: {
-            return BAD_VALUE;
+        if ((res = mOutput->write(reinterpret_cast<uint8_t*>(tmp), 0, n * size)) != OK) {
+            return res;
         }
+        mOffset += n * size;
     }
     return res;
 }
@@ -1532,6 +1532,34 @@ AAUDIO_API aaudio_allowed_capture_policy_t AAudioStream_getAllowedCapturePolicy(
 AAUDIO_API bool AAudioStream_isPrivacySensitive(AAudioStream* stream)
         __INTRODUCED_IN(30);
 
+/**
+ * Passes back estimates of the timing of the hardware clock that drives the stream.
+ * They are filtered from the timestamps of the stream and can be used to
+ * schedule writes or reads as late as the jitter allows, which reduces latency.
+ *
+ * Estimates are only available for MMAP streams, see AAudioStream_isMMapUsed(),
+ * once the stream has been started for a short time.
+ * Before then {@link #AAUDIO_ERROR_INVALID_STATE} will be returned.
+ * So {@link #AAUDIO_ERROR_INVALID_STATE} should not be considered a fatal error.
+ *
+ * Any of the pointers may be NULL if that estimate is not needed.
+ *
+ * Added in API level 31.
+ *
+ * @param stream reference provided by AAudioStreamBuilder_openStream()
+ * @param nextBurstTimeNanoseconds pointer to a variable to receive the predicted
+ *        CLOCK_MONOTONIC time when the hardware will transfer its next burst
+ * @param jitterNanoseconds pointer to a variable to receive the standard deviation
+ *        of the lateness of the timestamps
+ * @param driftPartsPerMillion pointer to a variable to receive how far the hardware clock
+ *        is from the nominal sample rate, positive if it is slower
+ * @return {@link #AAUDIO_OK}, {@link #AAUDIO_ERROR_INVALID_STATE}
+ *        or {@link #AAUDIO_ERROR_UNIMPLEMENTED} if the stream does not use MMAP
+ */
+AAUDIO_API aaudio_result_t AAudioStream_getClockEstimates(AAudioStream* stream,
+        int64_t *nextBurstTimeNanoseconds, int32_t *jitterNanoseconds,
+        double *driftPartsPerMillion) __INTRODUCED_IN(31);
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,16 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <type_traits>
+
+#ifdef __ANDROID__
+#include <audio_utils/primitives.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "AAudioFlowGraph.h"
 
 #include <flowgraph/ClipToRange.h>
@@ -32,6 +42,178 @@
 
 using namespace flowgraph;
 
+namespace {
+
+// Per sample conversions matching those of the Source and Sink nodes.
+struct FormatFloat {
+    static float read(const void *data, int32_t index) {
+        return static_cast<const float *>(data)[index];
+    }
+    static void write(void *data, int32_t index, float value) {
+        static_cast<float *>(data)[index] = value;
+    }
+};
+
+struct FormatI16 {
+    static float read(const void *data, int32_t index) {
+        const int16_t sample = static_cast<const int16_t *>(data)[index];
+#ifdef __ANDROID__
+        return float_from_i16(sample);
+#else
+        return sample * (1.0f / 32768);
+#endif
+    }
+    static void write(void *data, int32_t index, float value) {
+#ifdef __ANDROID__
+        static_cast<int16_t *>(data)[index] = clamp16_from_float(value);
+#else
+        int32_t n = (int32_t) (value * 32768.0f);
+        static_cast<int16_t *>(data)[index] = std::min(INT16_MAX, std::max(INT16_MIN, n));
+#endif
+    }
+};
+
+struct FormatI24Packed {
+    static constexpr int kBytesPerSample = 3;
+    static float read(const void *data, int32_t index) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data) + index * kBytesPerSample;
+#ifdef __ANDROID__
+        return float_from_p24(bytes);
+#else
+        // Assemble the data assuming Little Endian format, shifted to 32 bit for the sign.
+        static const float scale = 1. / (float)(1UL << 31);
+        const int32_t pad = (int32_t) (((uint32_t) bytes[2] << 24)
+                | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[0] << 8));
+        return pad * scale;
+#endif
+    }
+    static void write(void *data, int32_t index, float value) {
+        uint8_t *bytes = static_cast<uint8_t *>(data) + index * kBytesPerSample;
+#ifdef __ANDROID__
+        const int32_t n = clamp24_from_float(value);
+#else
+        const int32_t kI24PackedMax = 0x007FFFFF;
+        const int32_t kI24PackedMin = 0xFF800000;
+        int32_t n = (int32_t) (value * 0x00800000);
+        n = std::min(kI24PackedMax, std::max(kI24PackedMin, n)); // clip
+#endif
+        // Write as a packed 24-bit integer in Little Endian format.
+        bytes[0] = (uint8_t) n;
+        bytes[1] = (uint8_t) (n >> 8);
+        bytes[2] = (uint8_t) (n >> 16);
+    }
+};
+
+// Processes the leading samples of a block whose channel count is unchanged
+// with vector instructions. Returns the number of samples done.
+template <class SOURCE, class SINK>
+int32_t processVector(const void *source, void *destination, int32_t numSamples, float volume) {
+    (void) source;
+    (void) destination;
+    (void) numSamples;
+    (void) volume;
+    return 0;
+}
+
+#if defined(__aarch64__) && defined(__ANDROID__)
+// The usual legacy stream writes 16 bit data to a 16 bit or float device.
+// These give the same results as float_from_i16() and clamp16_from_float(),
+// which both round to nearest even.
+template <>
+int32_t processVector<FormatI16, FormatI16>(const void *source, void *destination,
+                                            int32_t numSamples, float volume) {
+    const int16_t *src = static_cast<const int16_t *>(source);
+    int16_t *dst = static_cast<int16_t *>(destination);
+    int32_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        const float32x4_t lo = vmulq_n_f32(vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(s)), 15),
+                                           volume);
+        const float32x4_t hi = vmulq_n_f32(vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(s)), 15),
+                                           volume);
+        vst1q_s16(dst + i, vcombine_s16(
+                vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(lo, 32768.f))),
+                vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(hi, 32768.f)))));
+    }
+    return i;
+}
+
+template <>
+int32_t processVector<FormatI16, FormatFloat>(const void *source, void *destination,
+                                              int32_t numSamples, float volume) {
+    const int16_t *src = static_cast<const int16_t *>(source);
+    float *dst = static_cast<float *>(destination);
+    int32_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(s)), 15),
+                                       volume));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(s)), 15),
+                                           volume));
+    }
+    return i;
+}
+#endif // __aarch64__ && __ANDROID__
+
+// Does in one pass what the Source, RampLinear, ClipToRange, MonoToMultiConverter
+// and Sink nodes would do for a steady volume, without the intermediate blocks.
+// Like the graph built by configure(), it only clips when both formats are float.
+template <class SOURCE, class SINK>
+void processFused(const void *source, void *destination, int32_t numFrames,
+                  int32_t sourceChannelCount, int32_t sinkChannelCount, float volume) {
+    constexpr bool clip = std::is_same<SOURCE, FormatFloat>::value
+            && std::is_same<SINK, FormatFloat>::value;
+    const auto convert = [volume](float sample) {
+        sample *= volume;
+        return clip ? std::min(kDefaultMaxHeadroom, std::max(kDefaultMinHeadroom, sample))
+                    : sample;
+    };
+    if (sourceChannelCount == sinkChannelCount) {
+        const int32_t numSamples = numFrames * sinkChannelCount;
+        for (int32_t i = processVector<SOURCE, SINK>(source, destination, numSamples, volume);
+                i < numSamples; i++) {
+            SINK::write(destination, i, convert(SOURCE::read(source, i)));
+        }
+    } else { // mono to multi
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            const float sample = convert(SOURCE::read(source, frame));
+            for (int32_t channel = 0; channel < sinkChannelCount; channel++) {
+                SINK::write(destination, frame * sinkChannelCount + channel, sample);
+            }
+        }
+    }
+}
+
+template <class SOURCE>
+AAudioFlowGraph::FusedProcessor selectFusedProcessor(audio_format_t sinkFormat) {
+    switch (sinkFormat) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            return processFused<SOURCE, FormatFloat>;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return processFused<SOURCE, FormatI16>;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            return processFused<SOURCE, FormatI24Packed>;
+        default:
+            return nullptr;
+    }
+}
+
+AAudioFlowGraph::FusedProcessor selectFusedProcessor(audio_format_t sourceFormat,
+                                                     audio_format_t sinkFormat) {
+    switch (sourceFormat) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            return selectFusedProcessor<FormatFloat>(sinkFormat);
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return selectFusedProcessor<FormatI16>(sinkFormat);
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            return selectFusedProcessor<FormatI24Packed>(sinkFormat);
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           audio_format_t sinkFormat,
@@ -96,10 +278,21 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // The graph above is still used while the volume ramps.
+    mFusedProcessor = selectFusedProcessor(sourceFormat, sinkFormat);
+    mSourceChannelCount = sourceChannelCount;
+    mSinkChannelCount = sinkChannelCount;
+
     return AAUDIO_OK;
 }
 
 void AAudioFlowGraph::process(const void *source, void *destination, int32_t numFrames) {
+    float volume;
+    if (mFusedProcessor != nullptr && mVolumeRamp->isSteady(&volume)) {
+        mFusedProcessor(source, destination, numFrames,
+                        mSourceChannelCount, mSinkChannelCount, volume);
+        return;
+    }
     mSource->setData(source, numFrames);
     mSink->read(destination, numFrames);
 }
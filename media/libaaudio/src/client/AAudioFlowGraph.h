@@ -52,7 +52,19 @@ public:
 
     void setRampLengthInFrames(int32_t numFrames);
 
+    /**
+     * Converts, scales and expands numFrames in one pass when the volume is steady.
+     * Selected in configure() for each pair of source and sink formats.
+     */
+    typedef void (*FusedProcessor)(const void *source, void *destination, int32_t numFrames,
+                                   int32_t sourceChannelCount, int32_t sinkChannelCount,
+                                   float volume);
+
 private:
+    FusedProcessor                                   mFusedProcessor = nullptr;
+    int32_t                                          mSourceChannelCount = 0;
+    int32_t                                          mSinkChannelCount = 0;
+
     std::unique_ptr<flowgraph::AudioSource>          mSource;
     std::unique_ptr<flowgraph::RampLinear>           mVolumeRamp;
     std::unique_ptr<flowgraph::ClipToRange>          mClipper;
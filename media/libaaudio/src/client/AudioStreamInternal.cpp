@@ -437,6 +437,7 @@ aaudio_result_t AudioStreamInternal::requestStop() {
     mClockModel.stop(AudioClock::getNanoseconds());
     setState(AAUDIO_STREAM_STATE_STOPPING);
     mAtomicInternalTimestamp.clear();
+    mAtomicClockEstimates.clear();
 
     result = mServiceInterface.stopStream(mServiceStreamHandle);
     if (result == AAUDIO_ERROR_INVALID_HANDLE) {
@@ -503,6 +504,32 @@ aaudio_result_t AudioStreamInternal::getTimestamp(clockid_t clockId,
     return AAUDIO_ERROR_INVALID_STATE;
 }
 
+aaudio_result_t AudioStreamInternal::getClockEstimates(int64_t *nextBurstTimeNanoseconds,
+                                                       int32_t *jitterNanoseconds,
+                                                       double *driftPartsPerMillion) {
+    if (!mAtomicClockEstimates.isValid()) {
+        return AAUDIO_ERROR_INVALID_STATE;
+    }
+    const ClockModelEstimates estimates = mAtomicClockEstimates.read();
+    if (nextBurstTimeNanoseconds != nullptr) {
+        // Extrapolate from the burst predicted with the last timestamp.
+        int64_t nextBurstTime = estimates.burstNanoTime;
+        const int64_t nanosDelta = AudioClock::getNanoseconds() - nextBurstTime;
+        if (nanosDelta >= 0 && estimates.burstPeriodNanos > 0.0) {
+            const int64_t burstsDelta = (int64_t) (nanosDelta / estimates.burstPeriodNanos) + 1;
+            nextBurstTime += (int64_t) (burstsDelta * estimates.burstPeriodNanos);
+        }
+        *nextBurstTimeNanoseconds = nextBurstTime;
+    }
+    if (jitterNanoseconds != nullptr) {
+        *jitterNanoseconds = estimates.jitterNanos;
+    }
+    if (driftPartsPerMillion != nullptr) {
+        *driftPartsPerMillion = estimates.driftPpm;
+    }
+    return AAUDIO_OK;
+}
+
 aaudio_result_t AudioStreamInternal::updateStateMachine() {
     if (isDataCallbackActive()) {
         return AAUDIO_OK; // state is getting updated by the callback thread read/write call
@@ -751,6 +778,14 @@ aaudio_result_t AudioStreamInternal::processData(void *buffer, int32_t numFrames
 
 void AudioStreamInternal::processTimestamp(uint64_t position, int64_t time) {
     mClockModel.processTimestamp(position, time);
+    if (mClockModel.isRunning()) {
+        ClockModelEstimates estimates;
+        estimates.burstNanoTime = mClockModel.predictNextBurstTime(time);
+        estimates.burstPeriodNanos = mClockModel.getDriftingBurstPeriodNanos();
+        estimates.jitterNanos = mClockModel.getJitterNanos();
+        estimates.driftPpm = mClockModel.getDriftPpm();
+        mAtomicClockEstimates.write(estimates);
+    }
 }
 
 aaudio_result_t AudioStreamInternal::setBufferSize(int32_t requestedFrames) {
@@ -54,6 +54,10 @@ public:
                                        int64_t *framePosition,
                                        int64_t *timeNanoseconds) override;
 
+    aaudio_result_t getClockEstimates(int64_t *nextBurstTimeNanoseconds,
+                                      int32_t *jitterNanoseconds,
+                                      double *driftPartsPerMillion) override;
+
     virtual aaudio_result_t updateStateMachine() override;
 
     aaudio_result_t open(const AudioStreamBuilder &builder) override;
@@ -175,6 +179,9 @@ protected:
 
     SimpleDoubleBuffer<Timestamp>  mAtomicInternalTimestamp;
 
+    // Written by the thread that processes the timestamps, read by the app.
+    SimpleDoubleBuffer<ClockModelEstimates> mAtomicClockEstimates;
+
     AtomicRequestor          mNeedCatchUp;   // Ask read() or write() to sync on first timestamp.
 
     float                    mStreamVolume = 1.0f;
@@ -22,6 +22,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <algorithm>
+#include <math.h>
 
 #include "utility/AudioClock.h"
 #include "utility/AAudioUtilities.h"
@@ -68,6 +69,7 @@ void IsochronousClockModel::start(int64_t nanoTime) {
     ALOGV("start(nanos = %lld)\n", (long long) nanoTime);
     mMarkerNanoTime = nanoTime;
     mState = STATE_STARTING;
+    resetEstimates(0, nanoTime);
     if (mHistogramMicros) {
         mHistogramMicros->clear();
     }
@@ -130,12 +132,14 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
         } else {
 //            ALOGD("processTimestamp() - advance to STATE_RUNNING");
             mState = STATE_RUNNING;
+            resetEstimates(mMarkerFramePosition, mMarkerNanoTime);
         }
         break;
     case STATE_RUNNING:
         if (mHistogramMicros) {
             mHistogramMicros->add(latenessNanos / AAUDIO_NANOS_PER_MICROSECOND);
         }
+        updateEstimates(framePosition, nanoTime, latenessNanos);
         // Modify estimated position based on lateness.
         // This affects the "early" side of the window, which controls output glitches.
         if (latenessNanos < 0) {
@@ -196,6 +200,79 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
     }
 }
 
+void IsochronousClockModel::resetEstimates(int64_t framePosition, int64_t nanoTime) {
+    mLatenessMeanNanos = 0.0;
+    mLatenessVarianceNanos = 0.0;
+    mLatenessValid = false;
+    mAnchorFramePosition = framePosition;
+    mAnchorNanoTime = nanoTime;
+    // The anchor is the first sample of the first window.
+    mWindowStartNanoTime = nanoTime;
+    mWindowMinOffsetNanos = 0;
+    mWindowMinNanoTime = nanoTime;
+    mWindowCount = 0;
+    mDriftPpm = 0.0;
+}
+
+void IsochronousClockModel::updateEstimates(int64_t framePosition, int64_t nanoTime,
+                                            int64_t latenessNanos) {
+    // Jitter, from an exponential filter of the mean and variance of the lateness.
+    if (!mLatenessValid) {
+        mLatenessMeanNanos = latenessNanos;
+        mLatenessValid = true;
+    } else {
+        const double deviation = latenessNanos - mLatenessMeanNanos;
+        mLatenessMeanNanos += kLatenessFilterGain * deviation;
+        mLatenessVarianceNanos += kLatenessFilterGain
+                * ((deviation * deviation) - mLatenessVarianceNanos);
+    }
+
+    // Drift. Late timestamps are mostly scheduler or HAL noise, so only the earliest
+    // timestamp of each window is used, which tracks the hardware clock closely.
+    const int64_t offsetNanos = nanoTime - mAnchorNanoTime
+            - convertDeltaPositionToTime(framePosition - mAnchorFramePosition);
+    if (nanoTime - mWindowStartNanoTime >= kDriftWindowNanos) {
+        if (mWindowCount > 0 && mWindowMinNanoTime > mPreviousMinNanoTime) {
+            const double driftPpm = 1.0e6 * (mWindowMinOffsetNanos - mPreviousMinOffsetNanos)
+                    / (mWindowMinNanoTime - mPreviousMinNanoTime);
+            mDriftPpm = (mWindowCount == 1)
+                    ? driftPpm
+                    : mDriftPpm + kDriftFilterGain * (driftPpm - mDriftPpm);
+#if ICM_LOG_DRIFT
+            ALOGD("%s() - STATE_RUNNING - #%d, window drift = %.1f ppm, filtered = %.1f ppm",
+                  __func__, mTimestampCount, driftPpm, mDriftPpm);
+#endif
+        }
+        mWindowCount++;
+        mPreviousMinOffsetNanos = mWindowMinOffsetNanos;
+        mPreviousMinNanoTime = mWindowMinNanoTime;
+        mWindowStartNanoTime = nanoTime;
+        mWindowMinOffsetNanos = offsetNanos;
+        mWindowMinNanoTime = nanoTime;
+    } else if (offsetNanos < mWindowMinOffsetNanos) {
+        mWindowMinOffsetNanos = offsetNanos;
+        mWindowMinNanoTime = nanoTime;
+    }
+}
+
+int32_t IsochronousClockModel::getJitterNanos() const {
+    return (int32_t) sqrt(mLatenessVarianceNanos);
+}
+
+double IsochronousClockModel::getDriftingBurstPeriodNanos() const {
+    return mBurstPeriodNanos * (1.0 + (mDriftPpm * 1.0e-6));
+}
+
+int64_t IsochronousClockModel::predictNextBurstTime(int64_t nanoTime) const {
+    const int64_t nextBurstPosition = convertTimeToPosition(nanoTime) + mFramesPerBurst;
+    const int64_t time = convertPositionToTime(nextBurstPosition);
+    if (mState != STATE_RUNNING) {
+        return time;
+    }
+    // The marker only follows a drifting clock in small steps, so correct the time since then.
+    return time + (int64_t) ((time - mMarkerNanoTime) * mDriftPpm * 1.0e-6);
+}
+
 void IsochronousClockModel::setSampleRate(int32_t sampleRate) {
     mSampleRate = sampleRate;
     update();
@@ -269,6 +346,8 @@ void IsochronousClockModel::dump() const {
     ALOGD("mSampleRate          = %6d", mSampleRate);
     ALOGD("mFramesPerBurst      = %6d", mFramesPerBurst);
     ALOGD("mMaxMeasuredLatenessNanos = %6d", mMaxMeasuredLatenessNanos);
+    ALOGD("jitter               = %6d nanos", getJitterNanos());
+    ALOGD("mDriftPpm            = %8.1f", mDriftPpm);
     ALOGD("mState               = %6d", mState);
 }
 
@@ -25,6 +25,16 @@
 
 namespace aaudio {
 
+/**
+ * Estimates made by the IsochronousClockModel, which can be passed to another thread.
+ */
+struct ClockModelEstimates {
+    int64_t burstNanoTime = 0;      // predicted time of a hardware burst
+    double  burstPeriodNanos = 0.0; // corrected for drift
+    int32_t jitterNanos = 0;
+    double  driftPpm = 0.0;
+};
+
 /**
  * Model an isochronous data stream using occasional timestamps as input.
  * This can be used to predict the position of the stream at a given time.
@@ -123,6 +133,39 @@ public:
      */
     int64_t convertDeltaTimeToPosition(int64_t nanosDelta) const;
 
+    /**
+     * Estimate how far the hardware clock drifts from the nominal sample rate.
+     * This is filtered over the earliest timestamps of successive windows of about a second,
+     * so it is zero until the model has been running for at least two windows.
+     *
+     * @return drift in parts per million, positive if the hardware clock is slow
+     */
+    double getDriftPpm() const {
+        return mDriftPpm;
+    }
+
+    /**
+     * Estimate the jitter of the timestamps, from both the scheduler and the HAL,
+     * as the filtered standard deviation of their lateness.
+     *
+     * @return jitter in nanoseconds
+     */
+    int32_t getJitterNanos() const;
+
+    /**
+     * Predict when the hardware will transfer the first burst after the specified time,
+     * correcting the model for the estimated drift.
+     *
+     * @param nanoTime time of interest
+     * @return time in nanoseconds
+     */
+    int64_t predictNextBurstTime(int64_t nanoTime) const;
+
+    /**
+     * @return burst period in nanoseconds corrected for the estimated drift
+     */
+    double getDriftingBurstPeriodNanos() const;
+
     void dump() const;
 
     void dumpHistogram() const;
@@ -131,6 +174,8 @@ private:
 
     int32_t getLateTimeOffsetNanos() const;
     void update();
+    void resetEstimates(int64_t framePosition, int64_t nanoTime);
+    void updateEstimates(int64_t framePosition, int64_t nanoTime, int64_t latenessNanos);
 
     enum clock_model_state_t {
         STATE_STOPPED,
@@ -146,6 +191,13 @@ private:
     // Initial small threshold for causing a drift later in time.
     static constexpr int32_t   kInitialLatenessForDriftNanos = 10 * 1000;
 
+    // Gain of the filters for the mean and variance of the lateness.
+    static constexpr double    kLatenessFilterGain = 1.0 / 32;
+    // Gain of the filter for the drift measured over each window.
+    static constexpr double    kDriftFilterGain    = 1.0 / 4;
+    // Duration of the windows whose earliest timestamps are used to measure drift.
+    static constexpr int64_t   kDriftWindowNanos   = 1000 * 1000 * 1000;
+
     static constexpr int32_t   kHistogramBinWidthMicros = 50;
     static constexpr int32_t   kHistogramBinCount = 128;
 
@@ -162,6 +214,23 @@ private:
 
     int32_t             mTimestampCount = 0;  // For logging.
 
+    // Filtered statistics of the lateness of the timestamps.
+    double              mLatenessMeanNanos = 0.0;
+    double              mLatenessVarianceNanos = 0.0; // in nanoseconds squared
+    bool                mLatenessValid = false;
+
+    // Drift is measured from the offset of the earliest timestamp in each window,
+    // relative to the nominal clock that starts at the anchor.
+    int64_t             mAnchorFramePosition = 0;
+    int64_t             mAnchorNanoTime = 0;
+    int64_t             mWindowStartNanoTime = 0;
+    int64_t             mWindowMinOffsetNanos = 0;
+    int64_t             mWindowMinNanoTime = 0;
+    int64_t             mPreviousMinOffsetNanos = 0;
+    int64_t             mPreviousMinNanoTime = 0;
+    int32_t             mWindowCount = 0;
+    double              mDriftPpm = 0.0;
+
     // distribution of timestamps relative to earliest
     std::unique_ptr<android::audio_utils::Histogram>   mHistogramMicros;
 
@@ -519,6 +519,16 @@ AAUDIO_API aaudio_result_t AAudioStream_getTimestamp(AAudioStream* stream,
     return audioStream->getTimestamp(clockid, framePosition, timeNanoseconds);
 }
 
+AAUDIO_API aaudio_result_t AAudioStream_getClockEstimates(AAudioStream* stream,
+                                      int64_t *nextBurstTimeNanoseconds,
+                                      int32_t *jitterNanoseconds,
+                                      double *driftPartsPerMillion)
+{
+    AudioStream *audioStream = convertAAudioStreamToAudioStream(stream);
+    return audioStream->getClockEstimates(nextBurstTimeNanoseconds, jitterNanoseconds,
+                                          driftPartsPerMillion);
+}
+
 AAUDIO_API aaudio_policy_t AAudio_getMMapPolicy() {
     return AudioGlobal_getMMapPolicy();
 }
@@ -98,6 +98,19 @@ public:
                                        int64_t *framePosition,
                                        int64_t *timeNanoseconds) = 0;
 
+    /**
+     * Pass back the estimates of the hardware clock made from the timestamps.
+     * Any of the pointers may be null.
+     */
+    virtual aaudio_result_t getClockEstimates(int64_t *nextBurstTimeNanoseconds,
+                                              int32_t *jitterNanoseconds,
+                                              double *driftPartsPerMillion) {
+        (void) nextBurstTimeNanoseconds;
+        (void) jitterNanoseconds;
+        (void) driftPartsPerMillion;
+        return AAUDIO_ERROR_UNIMPLEMENTED;
+    }
+
     /**
      * Update state machine.()
      * @return
@@ -15,6 +15,8 @@
  */
 
 #include <cstring>
+#include <errno.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 
@@ -25,6 +27,9 @@
 #include <algorithm>
 #include <memory>
 
+#include <android-base/unique_fd.h>
+#include <cutils/ashmem.h>
+
 #include "FifoControllerBase.h"
 #include "FifoController.h"
 #include "FifoControllerIndirect.h"
@@ -39,7 +44,16 @@ FifoBuffer::FifoBuffer(int32_t bytesPerFrame, fifo_frames_t capacityInFrames)
     mFifo = std::make_unique<FifoController>(capacityInFrames, capacityInFrames);
     // allocate buffer
     int32_t bytesPerBuffer = bytesPerFrame * capacityInFrames;
-    mStorage = new uint8_t[bytesPerBuffer];
+    if (canMirror(bytesPerBuffer)) {
+        android::base::unique_fd fd(ashmem_create_region("FifoBuffer", bytesPerBuffer));
+        if (fd.get() >= 0) {
+            mStorage = static_cast<uint8_t *>(mapMirrored(fd.get(), 0, bytesPerBuffer));
+            mStorageMirrored = (mStorage != nullptr);
+        }
+    }
+    if (mStorage == nullptr) {
+        mStorage = new uint8_t[bytesPerBuffer];
+    }
     mStorageOwned = true;
     ALOGV("%s() capacityInFrames = %d, bytesPerFrame = %d",
           __func__, capacityInFrames, bytesPerFrame);
@@ -49,10 +63,12 @@ FifoBuffer::FifoBuffer( int32_t   bytesPerFrame,
                         fifo_frames_t   capacityInFrames,
                         fifo_counter_t *  readIndexAddress,
                         fifo_counter_t *  writeIndexAddress,
-                        void *  dataStorageAddress
+                        void *  dataStorageAddress,
+                        bool    dataStorageMirrored
                         )
         : mBytesPerFrame(bytesPerFrame)
         , mStorage(static_cast<uint8_t *>(dataStorageAddress))
+        , mStorageMirrored(dataStorageMirrored)
 {
     mFifo = std::make_unique<FifoControllerIndirect>(capacityInFrames,
                                        capacityInFrames,
@@ -63,7 +79,47 @@ FifoBuffer::FifoBuffer( int32_t   bytesPerFrame,
 
 FifoBuffer::~FifoBuffer() {
     if (mStorageOwned) {
-        delete[] mStorage;
+        if (mStorageMirrored) {
+            unmapMirrored(mStorage, convertFramesToBytes(mFifo->getCapacity()));
+        } else {
+            delete[] mStorage;
+        }
+    }
+}
+
+bool FifoBuffer::canMirror(size_t sizeInBytes) {
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    return sizeInBytes > 0 && (sizeInBytes % pageSize) == 0;
+}
+
+void *FifoBuffer::mapMirrored(int fd, size_t offsetInBytes, size_t sizeInBytes) {
+    if (!canMirror(sizeInBytes)) {
+        ALOGE("%s() size %zu is not a multiple of the page size", __func__, sizeInBytes);
+        return nullptr;
+    }
+    // Reserve the address range for both mappings, then replace each half
+    // with a mapping of the same pages.
+    uint8_t *address = (uint8_t *) mmap(nullptr, 2 * sizeInBytes, PROT_NONE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+        ALOGE("%s() reserving %zu bytes failed %d", __func__, 2 * sizeInBytes, errno);
+        return nullptr;
+    }
+    for (int i = 0; i < 2; i++) {
+        void *half = mmap(address + i * sizeInBytes, sizeInBytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_FIXED, fd, offsetInBytes);
+        if (half == MAP_FAILED) {
+            ALOGE("%s() mapping half %d failed %d", __func__, i, errno);
+            munmap(address, 2 * sizeInBytes);
+            return nullptr;
+        }
+    }
+    return address;
+}
+
+void FifoBuffer::unmapMirrored(void *address, size_t sizeInBytes) {
+    if (address != nullptr) {
+        munmap(address, 2 * sizeInBytes);
     }
 }
 
@@ -80,7 +136,8 @@ void FifoBuffer::fillWrappingBuffer(WrappingBuffer *wrappingBuffer,
         fifo_frames_t capacity = mFifo->getCapacity();
         uint8_t *source = &mStorage[convertFramesToBytes(startIndex)];
         // Does the available data cross the end of the FIFO?
-        if ((startIndex + framesAvailable) > capacity) {
+        // The mirror continues past the end, so mirrored data never wraps.
+        if (!mStorageMirrored && (startIndex + framesAvailable) > capacity) {
             wrappingBuffer->data[0] = source;
             fifo_frames_t firstFrames = capacity - startIndex;
             wrappingBuffer->numFrames[0] = firstFrames;
@@ -38,13 +38,23 @@ struct WrappingBuffer {
 
 class FifoBuffer {
 public:
+    /**
+     * Allocate the storage. If the storage size is a multiple of the page size,
+     * it is mirrored, see isStorageMirrored().
+     */
     FifoBuffer(int32_t bytesPerFrame, fifo_frames_t capacityInFrames);
 
+    /**
+     * Use external storage.
+     * @param dataStorageMirrored true if the storage is followed by a second mapping of
+     *        itself, for example by mapMirrored()
+     */
     FifoBuffer(int32_t bytesPerFrame,
                fifo_frames_t capacityInFrames,
                fifo_counter_t *readCounterAddress,
                fifo_counter_t *writeCounterAddress,
-               void *dataStorageAddress);
+               void *dataStorageAddress,
+               bool dataStorageMirrored = false);
 
     ~FifoBuffer();
 
@@ -63,7 +73,8 @@ public:
     /**
      * Return pointer to available full frames in data1 and set size in numFrames1.
      * if the data is split across the end of the FIFO then set data2 and numFrames2.
-     * Other wise set them to null
+     * Other wise set them to null.
+     * If the storage is mirrored then the data is never split.
      * @param wrappingBuffer
      * @return total full frames available
      */
@@ -72,7 +83,8 @@ public:
     /**
      * Return pointer to available empty frames in data1 and set size in numFrames1.
      * if the room is split across the end of the FIFO then set data2 and numFrames2.
-     * Other wise set them to null
+     * Other wise set them to null.
+     * If the storage is mirrored then the room is never split.
      * @param wrappingBuffer
      * @return total empty frames available
      */
@@ -82,6 +94,32 @@ public:
         return mBytesPerFrame;
     }
 
+    /**
+     * @return true if the storage is mapped twice, back to back, so that any
+     *         capacity sized region starting within the FIFO is contiguous
+     */
+    bool isStorageMirrored() const {
+        return mStorageMirrored;
+    }
+
+    /**
+     * @return true if storage of this size can be mirrored by mapMirrored()
+     */
+    static bool canMirror(size_t sizeInBytes);
+
+    /**
+     * Map sizeInBytes of fd, starting at offsetInBytes, twice and back to back.
+     * Writing at address + n is then visible at address + sizeInBytes + n.
+     * The size and offset must be multiples of the page size.
+     * @return address of the first mapping, or nullptr on failure
+     */
+    static void *mapMirrored(int fd, size_t offsetInBytes, size_t sizeInBytes);
+
+    /**
+     * Release memory returned by mapMirrored().
+     */
+    static void unmapMirrored(void *address, size_t sizeInBytes);
+
     // Proxy methods for the internal FifoController
 
     fifo_counter_t getReadCounter() {
@@ -131,6 +169,7 @@ private:
     // memory shared between processes and cannot be deleted trivially.
     uint8_t                  *mStorage = nullptr;
     bool                      mStorageOwned = false; // did this object allocate the storage?
+    bool                      mStorageMirrored = false;
     std::unique_ptr<FifoControllerBase> mFifo{};
 };
 
@@ -53,6 +53,22 @@ public:
         return mTarget.load();
     }
 
+    /**
+     * Check whether every frame of the next block would be scaled by the same level,
+     * because no ramp is in progress and the target has not changed.
+     * Only call this from the thread that processes the graph.
+     *
+     * @param level set to the steady level if true is returned
+     * @return true if the ramp is steady
+     */
+    bool isSteady(float *level) const {
+        if (mRemaining > 0 || getTarget() != mLevelTo) {
+            return false;
+        }
+        *level = mLevelTo;
+        return true;
+    }
+
     /**
      * Force the nextSegment to start from this level.
      *
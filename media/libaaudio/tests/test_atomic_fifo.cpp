@@ -18,6 +18,8 @@
 
 #include <gtest/gtest.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <vector>
 
 #include "fifo/FifoBuffer.h"
 #include "fifo/FifoController.h"
@@ -386,3 +388,38 @@ TEST(test_fifo_buffer, fifo_full_wrap) {
     TestFifoBuffer tester(capacity);
     tester.checkFullWrap();
 }
+
+TEST(test_fifo_buffer, fifo_mirrored_wrap) {
+    // One page of int16_t frames can be mirrored.
+    const fifo_frames_t capacity = (fifo_frames_t) (sysconf(_SC_PAGESIZE) / sizeof(int16_t));
+    FifoBuffer fifoBuffer(sizeof(int16_t), capacity);
+    ASSERT_TRUE(fifoBuffer.isStorageMirrored());
+
+    // Move the indices near the end so that the next write wraps.
+    const fifo_frames_t offset = capacity - 17; // arbitrary
+    fifoBuffer.setReadCounter(offset);
+    fifoBuffer.setWriteCounter(offset);
+
+    const fifo_frames_t numFrames = 53; // arbitrary, more than what is left before the end
+    std::vector<int16_t> data(numFrames);
+    for (fifo_frames_t i = 0; i < numFrames; i++) {
+        data[i] = (int16_t) (i * 7 + 3);
+    }
+    WrappingBuffer wrappingBuffer;
+    ASSERT_EQ(capacity, fifoBuffer.getEmptyRoomAvailable(&wrappingBuffer));
+    ASSERT_EQ(capacity, wrappingBuffer.numFrames[0]);
+    ASSERT_EQ(0, wrappingBuffer.numFrames[1]);
+    ASSERT_EQ(numFrames, fifoBuffer.write(data.data(), numFrames));
+
+    ASSERT_EQ(numFrames, fifoBuffer.getFullDataAvailable(&wrappingBuffer));
+    ASSERT_EQ(numFrames, wrappingBuffer.numFrames[0]);
+    ASSERT_EQ(0, wrappingBuffer.numFrames[1]);
+    const int16_t *contiguous = static_cast<const int16_t *>(wrappingBuffer.data[0]);
+    for (fifo_frames_t i = 0; i < numFrames; i++) {
+        ASSERT_EQ(data[i], contiguous[i]);
+    }
+
+    std::vector<int16_t> readBack(numFrames);
+    ASSERT_EQ(numFrames, fifoBuffer.read(readBack.data(), numFrames));
+    ASSERT_EQ(data, readBack);
+}
@@ -51,7 +51,8 @@ public:
 
     // Test processing of timestamps when the hardware may be slightly off from
     // the expected sample rate.
-    void checkDriftingClock(double hardwareFramesPerSecond, int numLoops) {
+    void checkDriftingClock(double hardwareFramesPerSecond, int numLoops,
+                            bool checkPosition = true) {
         const int64_t startTimeNanos = 500000000; // arbitrary
         model.start(startTimeNanos);
 
@@ -80,7 +81,9 @@ public:
             // Apply drifting timestamp.
             model.processTimestamp(alignedPosition, currentTimeNanos);
 
-            ASSERT_EQ(alignedPosition, model.convertTimeToPosition(currentTimeNanos));
+            if (checkPosition) {
+                ASSERT_EQ(alignedPosition, model.convertTimeToPosition(currentTimeNanos));
+            }
         }
     }
 
@@ -163,4 +166,39 @@ TEST_F(ClockModelTestFixture, clock_slow_drift) {
 
 TEST_F(ClockModelTestFixture, clock_fast_drift) {
     checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
-}
\ No newline at end of file
+}
+// The drift estimate should converge on the rate error of the hardware clock.
+// The positions are not checked here, the tests above do that.
+static void checkDriftEstimate(const IsochronousClockModel &model, double hardwareRatio) {
+    constexpr double kToleranceDriftPpm = 50.0; // arbitrary
+    const double expectedDriftPpm = 1.0e6 * ((1.0 / hardwareRatio) - 1.0);
+    EXPECT_NEAR(expectedDriftPpm, model.getDriftPpm(), kToleranceDriftPpm);
+    // Positions are rounded down to a whole burst, so the timestamps are up to a burst late.
+    EXPECT_GT(model.getJitterNanos(), 0);
+    EXPECT_LT(model.getJitterNanos(), NANOS_PER_BURST);
+}
+
+TEST_F(ClockModelTestFixture, clock_estimate_no_drift) {
+    checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT, false);
+    checkDriftEstimate(model, 1.0);
+}
+
+TEST_F(ClockModelTestFixture, clock_estimate_slow_drift) {
+    checkDriftingClock(0.998 * SAMPLE_RATE, NUM_LOOPS_DRIFT, false);
+    checkDriftEstimate(model, 0.998);
+}
+
+TEST_F(ClockModelTestFixture, clock_estimate_fast_drift) {
+    checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT, false);
+    checkDriftEstimate(model, 1.002);
+}
+
+// The predicted burst should be the first one after the time of interest.
+TEST_F(ClockModelTestFixture, clock_predict_next_burst) {
+    checkDriftingClock(SAMPLE_RATE, NUM_LOOPS_DRIFT, false);
+    const int64_t nanoTime = model.convertPositionToTime(100 * HW_FRAMES_PER_BURST)
+            + (NANOS_PER_BURST / 3);
+    const int64_t nextBurstTime = model.predictNextBurstTime(nanoTime);
+    EXPECT_GT(nextBurstTime, nanoTime);
+    EXPECT_LE(nextBurstTime, nanoTime + NANOS_PER_BURST + (NANOS_PER_BURST / 10));
+}
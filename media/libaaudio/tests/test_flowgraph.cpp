@@ -22,6 +22,7 @@
 
 #include <gtest/gtest.h>
 
+#include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
 #include "flowgraph/MonoToMultiConverter.h"
 #include "flowgraph/SourceFloat.h"
@@ -155,3 +156,41 @@ TEST(test_flowgraph, module_clip_to_range) {
         EXPECT_NEAR(expected[i], output[i], tolerance);
     }
 }
+
+// Once the volume is steady the graph is replaced by a fused kernel,
+// which must produce the same samples as the nodes.
+TEST(test_flowgraph, fused_matches_nodes) {
+    constexpr int rampSize = 4;
+    constexpr int numFrames = 37; // not a multiple of the block or vector size
+    constexpr float volume = 0.3f;
+    int16_t input[numFrames];
+    for (int i = 0; i < numFrames; i++) {
+        input[i] = (int16_t) (i * 1771 - 32768);
+    }
+
+    AAudioFlowGraph flowGraph;
+    ASSERT_EQ(AAUDIO_OK, flowGraph.configure(AUDIO_FORMAT_PCM_16_BIT, 1,
+                                             AUDIO_FORMAT_PCM_16_BIT, 2));
+    flowGraph.setRampLengthInFrames(rampSize);
+    flowGraph.setTargetVolume(volume);
+    int16_t output[numFrames * 2] = {};
+    flowGraph.process(input, output, rampSize); // complete the ramp
+    flowGraph.process(input, output, numFrames);
+
+    SourceI16 sourceI16{1};
+    RampLinear rampLinear{1};
+    MonoToMultiConverter monoToStereo{2};
+    SinkI16 sinkI16{2};
+    rampLinear.setTarget(volume);
+    rampLinear.forceCurrent(volume);
+    sourceI16.output.connect(&rampLinear.input);
+    rampLinear.output.connect(&monoToStereo.input);
+    monoToStereo.output.connect(&sinkI16.input);
+    sourceI16.setData(input, numFrames);
+    int16_t expected[numFrames * 2] = {};
+    ASSERT_EQ(numFrames, sinkI16.read(expected, numFrames));
+
+    for (int i = 0; i < numFrames * 2; i++) {
+        EXPECT_EQ(expected[i], output[i]);
+    }
+}
@@ -1042,6 +1042,17 @@ audio_devices_t AudioSystem::getDevicesForStream(audio_stream_type_t stream)
     return aps->getDevicesForStream(stream);
 }
 
+status_t AudioSystem::getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                           std::vector<audio_devices_t> *devices)
+{
+    if (devices == nullptr || streams.size() > AUDIO_STREAM_CNT) {
+        return BAD_VALUE;
+    }
+    const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
+    if (aps == 0) return PERMISSION_DENIED;
+    return aps->getDevicesForStreams(streams, devices);
+}
+
 status_t AudioSystem::getDevicesForAttributes(const AudioAttributes &aa,
                                               AudioDeviceTypeAddrVector *devices) {
     if (devices == nullptr) {
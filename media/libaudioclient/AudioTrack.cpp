@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AudioTrack"
 
+#include <algorithm>
 #include <inttypes.h>
 #include <math.h>
 #include <sys/resource.h>
@@ -672,10 +673,25 @@ status_t AudioTrack::start()
             .set(AMEDIAMETRICS_PROP_STATUS, (int32_t)status)
             .record(); });
 
+    const State previousState = mState;
+    int32_t flags = startBegin_l();
 
+    if (!(flags & CBLK_INVALID)) {
+        status = mAudioTrack->start();
+        if (status == DEAD_OBJECT) {
+            flags |= CBLK_INVALID;
+        }
+    }
+    status = startEnd_l(status, flags, previousState);
+    return status;
+}
+
+// Client side state changes of start() before the server start(), returns the cblk flags.
+int32_t AudioTrack::startBegin_l()
+{
     mInUnderrun = true;
 
-    State previousState = mState;
+    const State previousState = mState;
     if (previousState == STATE_PAUSED_STOPPING) {
         mState = STATE_STOPPING;
     } else {
@@ -741,14 +757,12 @@ status_t AudioTrack::start()
         }
     }
     mNewPosition = mPosition + mUpdatePeriod;
-    int32_t flags = android_atomic_and(~(CBLK_STREAM_END_DONE | CBLK_DISABLED), &mCblk->mFlags);
+    return android_atomic_and(~(CBLK_STREAM_END_DONE | CBLK_DISABLED), &mCblk->mFlags);
+}
 
-    if (!(flags & CBLK_INVALID)) {
-        status = mAudioTrack->start();
-        if (status == DEAD_OBJECT) {
-            flags |= CBLK_INVALID;
-        }
-    }
+// Completes start() given the server status, flags from startBegin_l() and the prior state.
+status_t AudioTrack::startEnd_l(status_t status, int32_t flags, State previousState)
+{
     if (flags & CBLK_INVALID) {
         status = restoreTrack_l("start");
     }
@@ -803,9 +817,19 @@ void AudioTrack::stop()
 
     ALOGV("%s(%d): prior state:%s", __func__, mPortId, stateToString(mState));
 
-    if (mState != STATE_ACTIVE && mState != STATE_PAUSED) {
+    if (!stopBegin_l()) {
         return;
     }
+    mAudioTrack->stop();
+    stopEnd_l();
+}
+
+// Client side state changes of stop() before the server stop(), returns false if not needed.
+bool AudioTrack::stopBegin_l()
+{
+    if (mState != STATE_ACTIVE && mState != STATE_PAUSED) {
+        return false;
+    }
 
     if (isOffloaded_l()) {
         mState = STATE_STOPPING;
@@ -818,8 +842,11 @@ void AudioTrack::stop()
 
     mProxy->stop(); // notify server not to read beyond current client position until start().
     mProxy->interrupt();
-    mAudioTrack->stop();
+    return true;
+}
 
+void AudioTrack::stopEnd_l()
+{
     // Note: legacy handling - stop does not clear playback marker
     // and periodic update counter, but flush does for streaming tracks.
 
@@ -904,16 +931,29 @@ void AudioTrack::pause()
 
     ALOGV("%s(%d): prior state:%s", __func__, mPortId, stateToString(mState));
 
+    if (!pauseBegin_l()) {
+        return;
+    }
+    mAudioTrack->pause();
+    pauseEnd_l();
+}
+
+// Client side state changes of pause() before the server pause(), returns false if not needed.
+bool AudioTrack::pauseBegin_l()
+{
     if (mState == STATE_ACTIVE) {
         mState = STATE_PAUSED;
     } else if (mState == STATE_STOPPING) {
         mState = STATE_PAUSED_STOPPING;
     } else {
-        return;
+        return false;
     }
     mProxy->interrupt();
-    mAudioTrack->pause();
+    return true;
+}
 
+void AudioTrack::pauseEnd_l()
+{
     if (isOffloaded_l()) {
         if (mOutput != AUDIO_IO_HANDLE_NONE) {
             // An offload output can be re-used between two audio tracks having
@@ -935,6 +975,157 @@ void AudioTrack::pause()
     }
 }
 
+/* static */
+status_t AudioTrack::startTracks(
+        const std::vector<sp<AudioTrack>>& tracks, std::vector<status_t> *statuses)
+{
+    return controlTracks(IAudioFlinger::TRACK_CONTROL_START, tracks, statuses);
+}
+
+/* static */
+status_t AudioTrack::stopTracks(
+        const std::vector<sp<AudioTrack>>& tracks, std::vector<status_t> *statuses)
+{
+    return controlTracks(IAudioFlinger::TRACK_CONTROL_STOP, tracks, statuses);
+}
+
+/* static */
+status_t AudioTrack::pauseTracks(
+        const std::vector<sp<AudioTrack>>& tracks, std::vector<status_t> *statuses)
+{
+    return controlTracks(IAudioFlinger::TRACK_CONTROL_PAUSE, tracks, statuses);
+}
+
+/* static */
+status_t AudioTrack::controlTracks(int32_t control,
+        const std::vector<sp<AudioTrack>>& tracks, std::vector<status_t> *statuses)
+{
+    if (statuses == nullptr) {
+        return BAD_VALUE;
+    }
+    statuses->assign(tracks.size(), NO_ERROR);
+
+    // Lock every track in address order, so that concurrent batches cannot deadlock.
+    std::vector<AudioTrack *> locked;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        if (tracks[i] == nullptr) {
+            (*statuses)[i] = BAD_VALUE;
+        } else {
+            locked.push_back(tracks[i].get());
+        }
+    }
+    std::sort(locked.begin(), locked.end());
+    locked.erase(std::unique(locked.begin(), locked.end()), locked.end());
+    for (AudioTrack *track : locked) {
+        track->mLock.lock();
+    }
+
+    // Client side state changes, collecting the tracks the server must control.
+    struct Pending {
+        size_t  index;          // in tracks
+        ssize_t portIndex;      // in portIds, or -1 if the server track is invalid
+        State   previousState;
+        int32_t flags;
+    };
+    std::vector<Pending> pending;
+    std::vector<audio_port_handle_t> portIds;
+    const int64_t beginNs = systemTime();
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        AudioTrack * const track = tracks[i].get();
+        if (track == nullptr) {
+            continue;
+        }
+        Pending p{i, -1 /* portIndex */, track->mState, 0 /* flags */};
+        switch (control) {
+        case IAudioFlinger::TRACK_CONTROL_START:
+            if (track->mState == STATE_ACTIVE) {
+                (*statuses)[i] = INVALID_OPERATION;
+                continue;
+            }
+            p.flags = track->startBegin_l();
+            break;
+        case IAudioFlinger::TRACK_CONTROL_STOP:
+            if (!track->stopBegin_l()) continue;
+            break;
+        case IAudioFlinger::TRACK_CONTROL_PAUSE:
+            if (!track->pauseBegin_l()) continue;
+            break;
+        }
+        if (!(p.flags & CBLK_INVALID)) {
+            p.portIndex = portIds.size();
+            portIds.push_back(track->mPortId);
+        }
+        pending.push_back(p);
+    }
+
+    // One transaction for the whole batch.
+    std::vector<status_t> serverStatuses;
+    status_t status = NO_ERROR;
+    if (!portIds.empty()) {
+        const sp<IAudioFlinger>& audioFlinger = AudioSystem::get_audio_flinger();
+        status = audioFlinger != nullptr
+                ? audioFlinger->controlTracks(
+                        (IAudioFlinger::track_control_t)control, portIds, &serverStatuses)
+                : NO_INIT;
+    }
+
+    for (const Pending& p : pending) {
+        AudioTrack * const track = tracks[p.index].get();
+        status_t trackStatus = NO_ERROR;
+        if (p.portIndex >= 0) {
+            if (status == NO_ERROR) {
+                trackStatus = serverStatuses[p.portIndex];
+            } else {
+                // the batch transaction failed, control this track individually.
+                switch (control) {
+                case IAudioFlinger::TRACK_CONTROL_START:
+                    trackStatus = track->mAudioTrack->start();
+                    break;
+                case IAudioFlinger::TRACK_CONTROL_STOP:
+                    track->mAudioTrack->stop();
+                    break;
+                case IAudioFlinger::TRACK_CONTROL_PAUSE:
+                    track->mAudioTrack->pause();
+                    break;
+                }
+            }
+        }
+        const char *event = "";
+        switch (control) {
+        case IAudioFlinger::TRACK_CONTROL_START: {
+            int32_t flags = p.flags;
+            if (trackStatus == DEAD_OBJECT) {
+                flags |= CBLK_INVALID;
+            }
+            trackStatus = track->startEnd_l(trackStatus, flags, p.previousState);
+            event = AMEDIAMETRICS_PROP_EVENT_VALUE_START;
+        } break;
+        case IAudioFlinger::TRACK_CONTROL_STOP:
+            track->stopEnd_l();
+            trackStatus = NO_ERROR; // as stop()
+            event = AMEDIAMETRICS_PROP_EVENT_VALUE_STOP;
+            break;
+        case IAudioFlinger::TRACK_CONTROL_PAUSE:
+            track->pauseEnd_l();
+            trackStatus = NO_ERROR; // as pause()
+            event = AMEDIAMETRICS_PROP_EVENT_VALUE_PAUSE;
+            break;
+        }
+        (*statuses)[p.index] = trackStatus;
+        mediametrics::LogItem(track->mMetricsId)
+            .set(AMEDIAMETRICS_PROP_EVENT, event)
+            .set(AMEDIAMETRICS_PROP_EXECUTIONTIMENS, (int64_t)(systemTime() - beginNs))
+            .set(AMEDIAMETRICS_PROP_STATE, stateToString(track->mState))
+            .set(AMEDIAMETRICS_PROP_STATUS, (int32_t)trackStatus)
+            .record();
+    }
+
+    for (AudioTrack *track : locked) {
+        track->mLock.unlock();
+    }
+    return NO_ERROR;
+}
+
 status_t AudioTrack::setVolume(float left, float right)
 {
     // This duplicates a test by AudioTrack JNI, but that is not the only caller
@@ -1162,6 +1353,7 @@ ssize_t AudioTrack::setBufferSizeInFrames(size_t bufferSizeInFrames)
         return INVALID_OPERATION;
     }
 
+    mAutoBufferSize = false;
     ssize_t originalBufferSize = mProxy->getBufferSizeInFrames();
     ssize_t finalBufferSize  = mProxy->setBufferSizeInFrames((uint32_t) bufferSizeInFrames);
     if (originalBufferSize != finalBufferSize) {
@@ -1174,6 +1366,29 @@ ssize_t AudioTrack::setBufferSizeInFrames(size_t bufferSizeInFrames)
     return finalBufferSize;
 }
 
+status_t AudioTrack::setAutoBufferSize(bool enabled)
+{
+    AutoMutex lock(mLock);
+    if (mOutput == AUDIO_IO_HANDLE_NONE || mProxy.get() == 0) {
+        return NO_INIT;
+    }
+    // Reject if compressed audio or static track, as for setBufferSizeInFrames().
+    if (!audio_is_linear_pcm(mFormat) || mSharedBuffer != 0) {
+        return INVALID_OPERATION;
+    }
+    if (enabled == mAutoBufferSize) {
+        return NO_ERROR;
+    }
+    mAutoBufferSize = enabled;
+    mProxy->setBufferSizeAuto(enabled);
+    android::mediametrics::LogItem(mMetricsId)
+            .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_SETBUFFERSIZE)
+            .set(AMEDIAMETRICS_PROP_BUFFERSIZEFRAMES, (int32_t)mProxy->getBufferSizeInFrames())
+            .set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)getUnderrunCount_l())
+            .record();
+    return NO_ERROR;
+}
+
 status_t AudioTrack::setLoop(uint32_t loopStart, uint32_t loopEnd, int loopCount)
 {
     if (mSharedBuffer == 0 || isOffloadedOrDirect()) {
@@ -1714,6 +1929,9 @@ status_t AudioTrack::createTrack_l()
     playbackRateTemp.mPitch = effectivePitch;
     mProxy->setPlaybackRate(playbackRateTemp);
     mProxy->setMinimum(mNotificationFramesAct);
+    if (mAutoBufferSize) {
+        mProxy->setBufferSizeAuto(true);
+    }
 
     mDeathNotifier = new DeathNotifier(this);
     IInterface::asBinder(mAudioTrack)->linkToDeath(mDeathNotifier, this);
@@ -20,8 +20,10 @@
 #include <android-base/macros.h>
 #include <private/media/AudioTrackShared.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <audio_utils/safe_math.h>
 
+#include <algorithm>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 
@@ -102,6 +104,11 @@ uint32_t ClientProxy::setBufferSizeInFrames(uint32_t size)
     } else if (clippedSize > maximum) {
         clippedSize = maximum;
     }
+    // an explicit size leaves auto mode.
+    if (mBufferSizeAuto) {
+        mBufferSizeAuto = false;
+        (void) android_atomic_and(~CBLK_BUFFER_SIZE_AUTO, &mCblk->mFlags);
+    }
     // for server to read
     android_atomic_release_store(clippedSize, (int32_t *)&mCblk->mBufferSizeInFrames);
     // for client to read
@@ -109,6 +116,22 @@ uint32_t ClientProxy::setBufferSizeInFrames(uint32_t size)
     return clippedSize;
 }
 
+void ClientProxy::setBufferSizeAuto(bool enabled)
+{
+    if (enabled == mBufferSizeAuto) {
+        return;
+    }
+    if (enabled) {
+        mBufferSizeAuto = true;
+        (void) android_atomic_or(CBLK_BUFFER_SIZE_AUTO, &mCblk->mFlags);
+    } else {
+        (void) android_atomic_and(~CBLK_BUFFER_SIZE_AUTO, &mCblk->mFlags);
+        // keep the size last chosen by the server.
+        mBufferSizeInFrames = android_atomic_acquire_load((int32_t *)&mCblk->mBufferSizeInFrames);
+        mBufferSizeAuto = false;
+    }
+}
+
 __attribute__((no_sanitize("integer")))
 status_t ClientProxy::obtainBuffer(Buffer* buffer, const struct timespec *requested,
         struct timespec *elapsed)
@@ -975,6 +998,49 @@ void AudioTrackServerProxy::tallyUnderrunFrames(uint32_t frameCount)
     }
 }
 
+// Auto buffer size: after an underrun the size is held for a while,
+// then lowered by one step per period while no underrun occurs.
+static constexpr int64_t kAutoBufferSizeHoldNs = 10 * 1000000000LL;
+static constexpr int64_t kAutoBufferSizeShrinkPeriodNs = 1000000000LL;
+
+void AudioTrackServerProxy::autoTuneBufferSize(size_t desiredFrames, bool underrun)
+{
+    audio_track_cblk_t* cblk = mCblk;
+    if (!(android_atomic_acquire_load(&cblk->mFlags) & CBLK_BUFFER_SIZE_AUTO)) {
+        mAutoUnderrunning = false;
+        return;
+    }
+    // A step is the largest request seen, which is about one server period.
+    mAutoStepFrames = std::min(std::max(mAutoStepFrames, desiredFrames), mFrameCount);
+    if (mAutoStepFrames == 0) {
+        return;
+    }
+    const int64_t nowNs = systemTime();
+    const uint32_t size = getBufferSizeInFrames();
+    uint32_t newSize = size;
+    if (underrun) {
+        if (!mAutoUnderrunning) { // raise once per underrun sequence.
+            newSize = (uint32_t)std::min(size + mAutoStepFrames, mFrameCount);
+        }
+        mAutoNextShrinkNs = nowNs + kAutoBufferSizeHoldNs;
+    } else if (nowNs >= mAutoNextShrinkNs) {
+        // two steps leave room for the client to write while the server reads.
+        const uint32_t minimum = (uint32_t)std::min(2 * mAutoStepFrames, mFrameCount);
+        if (size > minimum) {
+            newSize = std::max(size - (uint32_t)mAutoStepFrames, minimum);
+        }
+        mAutoNextShrinkNs = nowNs + kAutoBufferSizeShrinkPeriodNs;
+    }
+    mAutoUnderrunning = underrun;
+    if (newSize != size) {
+        // the client may concurrently set an explicit size, which must win.
+        if (android_atomic_cmpxchg((int32_t)size, (int32_t)newSize,
+                (volatile int32_t *)&cblk->mBufferSizeInFrames) == 0) {
+            ALOGV("%s: buffer size %u -> %u", __func__, size, newSize);
+        }
+    }
+}
+
 AudioPlaybackRate AudioTrackServerProxy::getPlaybackRate()
 {   // do not call from multiple threads without holding lock
     mPlaybackRateObserver.poll(mPlaybackRate);
@@ -91,7 +91,8 @@ enum {
     SET_MASTER_BALANCE,
     GET_MASTER_BALANCE,
     SET_EFFECT_SUSPENDED,
-    SET_AUDIO_HAL_PIDS
+    SET_AUDIO_HAL_PIDS,
+    CONTROL_TRACKS,
 };
 
 #define MAX_ITEMS_PER_LIST 1024
@@ -926,6 +927,35 @@ public:
         }
         return static_cast <status_t> (reply.readInt32());
     }
+    virtual status_t controlTracks(track_control_t control,
+                                   const std::vector<audio_port_handle_t>& portIds,
+                                   std::vector<status_t> *statuses)
+    {
+        if (statuses == nullptr || portIds.size() > MAX_ITEMS_PER_LIST) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(IAudioFlinger::getInterfaceDescriptor());
+        data.writeInt32(control);
+        data.writeInt32(portIds.size());
+        for (auto portId : portIds) {
+            data.writeInt32(portId);
+        }
+        status_t status = remote()->transact(CONTROL_TRACKS, data, &reply);
+        if (status != NO_ERROR ||
+                (status = (status_t)reply.readInt32()) != NO_ERROR) {
+            return status;
+        }
+        const int32_t size = reply.readInt32();
+        if (size != (int32_t)portIds.size()) {
+            return BAD_VALUE;
+        }
+        statuses->resize(size);
+        for (auto& trackStatus : *statuses) {
+            trackStatus = (status_t)reply.readInt32();
+        }
+        return NO_ERROR;
+    }
 };
 
 IMPLEMENT_META_INTERFACE(AudioFlinger, "android.media.IAudioFlinger");
@@ -1621,6 +1651,39 @@ status_t BnAudioFlinger::onTransact(
             reply->writeInt32(setAudioHalPids(pids));
             return NO_ERROR;
         }
+        case CONTROL_TRACKS: {
+            CHECK_INTERFACE(IAudioFlinger, data, reply);
+            track_control_t control;
+            int32_t size;
+            status_t status = data.readInt32((int32_t *)&control);
+            if (status == NO_ERROR) {
+                status = data.readInt32(&size);
+            }
+            if (status != NO_ERROR) {
+                return status;
+            }
+            if (size < 0 || size > MAX_ITEMS_PER_LIST) {
+                reply->writeInt32(BAD_VALUE);
+                return NO_ERROR;
+            }
+            std::vector<audio_port_handle_t> portIds(size);
+            for (auto& portId : portIds) {
+                status = data.readInt32((int32_t *)&portId);
+                if (status != NO_ERROR) {
+                    return status;
+                }
+            }
+            std::vector<status_t> statuses;
+            status = controlTracks(control, portIds, &statuses);
+            reply->writeInt32(status);
+            if (status == NO_ERROR) {
+                reply->writeInt32(statuses.size());
+                for (auto trackStatus : statuses) {
+                    reply->writeInt32(trackStatus);
+                }
+            }
+            return NO_ERROR;
+        }
         default:
             return BBinder::onTransact(code, data, reply, flags);
     }
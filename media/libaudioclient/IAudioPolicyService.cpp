@@ -120,6 +120,7 @@ enum {
     AUDIO_MODULES_UPDATED,  // oneway
     SET_CURRENT_IME_UID,
     REGISTER_SOUNDTRIGGER_CAPTURE_STATE_LISTENER,
+    GET_DEVICES_FOR_STREAMS,
 };
 
 #define MAX_ITEMS_PER_LIST 1024
@@ -519,6 +520,36 @@ public:
         return (audio_devices_t) reply.readInt32();
     }
 
+    virtual status_t getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                          std::vector<audio_devices_t> *devices)
+    {
+        if (devices == nullptr || streams.size() > AUDIO_STREAM_CNT) {
+            return BAD_VALUE;
+        }
+        Parcel data, reply;
+        data.writeInterfaceToken(IAudioPolicyService::getInterfaceDescriptor());
+        data.writeInt32(streams.size());
+        for (audio_stream_type_t stream : streams) {
+            data.writeInt32(static_cast <int32_t>(stream));
+        }
+        status_t status = remote()->transact(GET_DEVICES_FOR_STREAMS, data, &reply);
+        if (status != NO_ERROR) {
+            return status;
+        }
+        status = static_cast <status_t>(reply.readInt32());
+        if (status != NO_ERROR) {
+            return status;
+        }
+        if ((size_t) reply.readInt32() != streams.size()) {
+            return FAILED_TRANSACTION;
+        }
+        devices->resize(streams.size());
+        for (size_t i = 0; i < streams.size(); i++) {
+            (*devices)[i] = static_cast <audio_devices_t>(reply.readInt32());
+        }
+        return NO_ERROR;
+    }
+
     virtual audio_io_handle_t getOutputForEffect(const effect_descriptor_t *desc)
     {
         Parcel data, reply;
@@ -1934,6 +1965,34 @@ status_t BnAudioPolicyService::onTransact(
             return NO_ERROR;
         } break;
 
+        case GET_DEVICES_FOR_STREAMS: {
+            CHECK_INTERFACE(IAudioPolicyService, data, reply);
+            const int32_t count = data.readInt32();
+            if (count < 0 || count > AUDIO_STREAM_CNT) {
+                reply->writeInt32(static_cast <int32_t>(BAD_VALUE));
+                return NO_ERROR;
+            }
+            std::vector<audio_stream_type_t> streams(count);
+            for (auto& stream : streams) {
+                stream = static_cast <audio_stream_type_t>(data.readInt32());
+            }
+            std::vector<audio_devices_t> devices;
+            status_t status = getDevicesForStreams(streams, &devices);
+            // reply data formatted as:
+            //  - (int32) method call result
+            //  - (int32) number of devices (n) if method call returned NO_ERROR
+            //  - n (int32) devices, one per stream, if method call returned NO_ERROR
+            reply->writeInt32(status);
+            if (status != NO_ERROR) {
+                return NO_ERROR;
+            }
+            reply->writeInt32(devices.size());
+            for (audio_devices_t device : devices) {
+                reply->writeInt32(static_cast <int32_t>(device));
+            }
+            return NO_ERROR;
+        } break;
+
         case GET_OUTPUT_FOR_EFFECT: {
             CHECK_INTERFACE(IAudioPolicyService, data, reply);
             effect_descriptor_t desc = {};
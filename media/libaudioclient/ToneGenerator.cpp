@@ -17,7 +17,9 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "ToneGenerator"
 
+#include <algorithm>
 #include <math.h>
+#include <numeric>
 #include <utils/Log.h>
 #include <cutils/properties.h>
 #include "media/ToneGenerator.h"
@@ -1734,8 +1736,23 @@ ToneGenerator::WaveGenerator::WaveGenerator(uint32_t samplingRate,
         d0 = 32767;
     mA1_Q14 = (int16_t) d0;
 
-    ALOGV("WaveGenerator init, mA1_Q14: %d, mS2_0: %d, mAmplitude_Q15: %d",
-            mA1_Q14, mS2_0, mAmplitude_Q15);
+    // The wave repeats exactly every samplingRate / gcd(frequency, samplingRate) samples.
+    // When that period is short enough, as for call progress tones, render it once so that
+    // getSamples() only adds the table to the output instead of running the oscillator.
+    mTableIdx = 0;
+    const unsigned int period = frequency == 0 ? 0 :
+            samplingRate / std::gcd((uint32_t)frequency, samplingRate);
+    if (period != 0 && period <= MAX_TABLE_SIZE) {
+        const double amplitude = ((long)GEN_AMP * mAmplitude_Q15) >> S_Q15;
+        mTable.resize(period);
+        for (unsigned int i = 0; i < period; i++) {
+            // Same phase as the oscillator, whose first sample is sin(2 * pi * F_div_Fs).
+            mTable[i] = (int16_t)lround(amplitude * sin(2 * M_PI * F_div_Fs * (i + 1)));
+        }
+    }
+
+    ALOGV("WaveGenerator init, mA1_Q14: %d, mS2_0: %d, mAmplitude_Q15: %d, table size: %zu",
+            mA1_Q14, mS2_0, mAmplitude_Q15, mTable.size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1772,6 +1789,11 @@ ToneGenerator::WaveGenerator::~WaveGenerator() {
 ////////////////////////////////////////////////////////////////////////////////
 void ToneGenerator::WaveGenerator::getSamples(int16_t *outBuffer,
         unsigned int count, unsigned int command) {
+    if (!mTable.empty()) {
+        getTableSamples(outBuffer, count, command);
+        return;
+    }
+
     long lS1, lS2;
     long lA1, lAmplitude;
     long Sample;  // current sample
@@ -1822,4 +1844,62 @@ void ToneGenerator::WaveGenerator::getSamples(int16_t *outBuffer,
     mS2 = lS2;
 }
 
+//---------------------------------- private methods ---------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Method:        WaveGenerator::getTableSamples()
+//
+//    Description:    Same as getSamples(), reading the wave from mTable.
+//        Each run of samples up to the end of the table is a plain vector add.
+//
+//    Input:
+//        outBuffer:      Output buffer where to accumulate samples.
+//        count:          number of samples to produce.
+//        command:        special action requested (see enum gen_command).
+//
+//    Output:
+//        none
+//
+////////////////////////////////////////////////////////////////////////////////
+void ToneGenerator::WaveGenerator::getTableSamples(int16_t *outBuffer,
+        unsigned int count, unsigned int command) {
+    const int16_t *table = mTable.data();
+    const unsigned int size = mTable.size();
+    unsigned int idx = command == WAVEGEN_START ? 0 : mTableIdx;
+
+    if (command == WAVEGEN_STOP) {
+        if (count == 0) {
+            return;
+        }
+        // ramp down to 0 over count samples, in Q16
+        long lAmplitude = 1L << 16;
+        long dec = lAmplitude / count;
+        while (count) {
+            count--;
+            *(outBuffer++) += (int16_t)((table[idx] * lAmplitude) >> 16);
+            if (++idx == size) {
+                idx = 0;
+            }
+            lAmplitude -= dec;
+        }
+    } else {
+        while (count) {
+            const unsigned int run = std::min(count, size - idx);
+            const int16_t *in = table + idx;
+            for (unsigned int i = 0; i < run; i++) {
+                outBuffer[i] += in[i];
+            }
+            outBuffer += run;
+            count -= run;
+            idx += run;
+            if (idx == size) {
+                idx = 0;
+            }
+        }
+    }
+
+    mTableIdx = idx;
+}
+
 }  // end namespace android
@@ -290,6 +290,10 @@ public:
 
     static uint32_t getStrategyForStream(audio_stream_type_t stream);
     static audio_devices_t getDevicesForStream(audio_stream_type_t stream);
+    // Same as getDevicesForStream() for several streams, in a single binder call.
+    // devices is in the same order as streams.
+    static status_t getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                         std::vector<audio_devices_t> *devices);
     static status_t getDevicesForAttributes(const AudioAttributes &aa,
                                             AudioDeviceTypeAddrVector *devices);
 
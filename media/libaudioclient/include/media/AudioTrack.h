@@ -27,6 +27,7 @@
 #include <utils/threads.h>
 
 #include <string>
+#include <vector>
 
 #include "android/media/BnAudioTrackCallback.h"
 #include "android/media/IAudioTrackCallback.h"
@@ -408,6 +409,18 @@ public:
      */
             ssize_t     setBufferSizeInFrames(size_t size);
 
+    /* Let the server choose the effective buffer size, see setBufferSizeInFrames().
+     * The size is raised by about one server period on each underrun,
+     * and lowered again slowly, to no less than two periods, while there are none.
+     * This trades latency for glitch resistance under the scheduling jitter
+     * actually observed on the device.
+     * A later setBufferSizeInFrames() disables auto mode.
+     *
+     * Return NO_ERROR, NO_INIT if the track is uninitialized, or INVALID_OPERATION
+     * for compressed audio or static tracks.
+     */
+            status_t    setAutoBufferSize(bool enabled);
+
     /* Return the static buffer specified in constructor or set(), or 0 for streaming mode */
             sp<IMemory> sharedBuffer() const { return mSharedBuffer; }
 
@@ -460,6 +473,28 @@ public:
      */
             void        pause();
 
+    /* Start, stop or pause a set of tracks together, as if start(), stop() or pause()
+     * was called on each track in order, but with a single call to the server.
+     * On the server, each output thread is locked once for all of its tracks in the set,
+     * so that tracks meant to begin together start in the same mix cycle.
+     * There is no batch setVolume(), as volume changes do not call the server.
+     *
+     * Parameters:
+     *  tracks:     the tracks to control, all must be initialized (initCheck() == NO_ERROR).
+     *  statuses:   receives the status of each track, as returned by start(), or NO_ERROR
+     *              for stop() and pause().
+     *
+     * Returned status (from utils/Errors.h) can be:
+     *  - NO_ERROR: the statuses are valid
+     *  - BAD_VALUE: statuses is null
+     */
+    static  status_t    startTracks(const std::vector<sp<AudioTrack>>& tracks,
+                                    std::vector<status_t> *statuses);
+    static  status_t    stopTracks(const std::vector<sp<AudioTrack>>& tracks,
+                                   std::vector<status_t> *statuses);
+    static  status_t    pauseTracks(const std::vector<sp<AudioTrack>>& tracks,
+                                    std::vector<status_t> *statuses);
+
     /* Set volume for this track, mostly used for games' sound effects
      * left and right volumes. Levels must be >= 0.0 and <= 1.0.
      * This is the older API.  New applications should use setVolume(float) when possible.
@@ -1121,6 +1156,20 @@ public:
         }
     }
 
+            // start(), stop() and pause() are split around the IAudioTrack call
+            // so that a batch of tracks can be controlled with one IAudioFlinger call.
+            int32_t  startBegin_l();
+            status_t startEnd_l(status_t status, int32_t flags, State previousState);
+            bool     stopBegin_l();
+            void     stopEnd_l();
+            bool     pauseBegin_l();
+            void     pauseEnd_l();
+
+            // control is an IAudioFlinger::track_control_t.
+    static  status_t controlTracks(int32_t control,
+                                   const std::vector<sp<AudioTrack>>& tracks,
+                                   std::vector<status_t> *statuses);
+
     // for client callback handler
     callback_t              mCbf;                   // callback handler for events, or NULL
     void*                   mUserData;
@@ -1192,6 +1241,7 @@ public:
     ExtendedTimestamp::Location mPreviousLocation;  // location used for previous timestamp
 
     uint32_t                mUnderrunCountOffset;   // updated when restoring tracks
+    bool                    mAutoBufferSize = false; // setAutoBufferSize(), kept on restore
 
     int64_t                 mFramesWritten;         // total frames written. reset to zero after
                                                     // the start() following stop(). It is not
@@ -540,6 +540,22 @@ public:
     virtual status_t getMicrophones(std::vector<media::MicrophoneInfo> *microphones) = 0;
 
     virtual status_t setAudioHalPids(const std::vector<pid_t>& pids) = 0;
+
+    enum track_control_t : int32_t {
+        TRACK_CONTROL_START,
+        TRACK_CONTROL_STOP,
+        TRACK_CONTROL_PAUSE,
+    };
+
+    /* Apply the same control to a batch of playback tracks given by port id, as if
+     * IAudioTrack::start(), stop() or pause() was called on each of them, in order.
+     * Each playback thread lock is taken once for all of its tracks in the batch,
+     * so the tracks of a thread change state in the same mix cycle.
+     * statuses receives one status per port id.
+     */
+    virtual status_t controlTracks(track_control_t control,
+                                   const std::vector<audio_port_handle_t>& portIds,
+                                   std::vector<status_t> *statuses) = 0;
 };
 
 
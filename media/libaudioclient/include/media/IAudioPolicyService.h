@@ -114,6 +114,10 @@ public:
 
     virtual uint32_t getStrategyForStream(audio_stream_type_t stream) = 0;
     virtual audio_devices_t getDevicesForStream(audio_stream_type_t stream) = 0;
+    // Same as getDevicesForStream() for several streams in one call.
+    // devices is resized to the size of streams, in the same order.
+    virtual status_t getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                          std::vector<audio_devices_t> *devices) = 0;
     virtual status_t getDevicesForAttributes(const AudioAttributes &aa,
             AudioDeviceTypeAddrVector *devices) const = 0;
     virtual audio_io_handle_t getOutputForEffect(const effect_descriptor_t *desc) = 0;
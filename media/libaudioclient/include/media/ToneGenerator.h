@@ -17,6 +17,8 @@
 #ifndef ANDROID_TONEGENERATOR_H_
 #define ANDROID_TONEGENERATOR_H_
 
+#include <vector>
+
 #include <media/AudioSystem.h>
 #include <media/AudioTrack.h>
 #include <utils/Compat.h>
@@ -334,12 +336,21 @@ private:
         static const int16_t GEN_AMP = 32000;  // amplitude of generator
         static const int16_t S_Q14 = 14;  // shift for Q14
         static const int16_t S_Q15 = 15;  // shift for Q15
+        // Longest exact period rendered into mTable: 100 ms at 48 kHz.
+        static const unsigned int MAX_TABLE_SIZE = 4800;
+
+        void getTableSamples(int16_t *outBuffer, unsigned int count, unsigned int command);
 
         int16_t mA1_Q14;  // Q14 coefficient
         // delay line of full amplitude generator
         long mS1, mS2;  // delay line S2 oldest
         int16_t mS2_0;  // saved value for reinitialisation
         int16_t mAmplitude_Q15;  // Q15 amplitude
+
+        // One exact period of the output wave, empty if the period is longer than
+        // MAX_TABLE_SIZE samples, in which case the recursive oscillator is used.
+        std::vector<int16_t> mTable;
+        unsigned int mTableIdx;  // index in mTable of the next sample
     };
 
     KeyedVector<uint16_t, WaveGenerator *> mWaveGens;  // list of active wave generators.
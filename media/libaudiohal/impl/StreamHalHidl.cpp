@@ -396,6 +396,65 @@ status_t StreamOutHalHidl::write(const void *buffer, size_t bytes, size_t *writt
     return status;
 }
 
+status_t StreamOutHalHidl::obtainWriteBuffer(size_t bytes, void **buffer) {
+    *buffer = nullptr;
+    if (mStream == 0) return NO_INIT;
+    // Non-blocking writes complete through the callback, possibly partially,
+    // so they always copy from the client buffer.
+    if (mCallback.unsafe_get() != nullptr) return INVALID_OPERATION;
+    if (bytes == 0) return WOULD_BLOCK;
+
+    status_t status;
+    if (!mDataMQ) {
+        size_t bufferSize;
+        if ((status = getCachedBufferSize(&bufferSize)) != OK) {
+            return status;
+        }
+        if (bytes > bufferSize) bufferSize = bytes;
+        if ((status = prepareForWriting(bufferSize)) != OK) {
+            return status;
+        }
+    }
+
+    // The data MQ is the shared memory ring the HAL reads from. It is only usable in place
+    // if the whole request fits in its first region, i.e. does not wrap around the end of
+    // the ring. This is always the case when every write has the same size as the ring.
+    DataMQ::MemTransaction tx;
+    if (!mDataMQ->beginWrite(bytes, &tx) || tx.getFirstRegion().getLength() < bytes) {
+        return WOULD_BLOCK;
+    }
+    mObtainedWriteBuffer = tx.getFirstRegion().getAddress();
+    *buffer = mObtainedWriteBuffer;
+    return OK;
+}
+
+status_t StreamOutHalHidl::commitWriteBuffer(size_t bytes, size_t *written) {
+    *written = 0;
+    if (mStream == 0 || !mDataMQ) return NO_INIT;
+
+    const uint8_t *data = mObtainedWriteBuffer;
+    mObtainedWriteBuffer = nullptr;
+    if (data == nullptr) {
+        ALOGE("%s without a buffer obtained", __func__);
+        return INVALID_OPERATION;
+    }
+    // Only the write index is published; the data is already in place.
+    if (!mDataMQ->commitWrite(bytes)) {
+        ALOGE("data message queue commit failed for \"write\"");
+        return INVALID_OPERATION;
+    }
+    status_t status = callWriterThread(
+            WriteCommand::WRITE, "write", nullptr /* data */, 0,
+            [&] (const WriteStatus& writeStatus) {
+                *written = writeStatus.reply.written;
+                ALOGE_IF(*written > bytes,
+                        "hal reports more bytes written than asked for: %lld > %lld",
+                        (long long)*written, (long long)bytes);
+            });
+    mStreamPowerLog.log(data, *written);
+    return status;
+}
+
 status_t StreamOutHalHidl::callWriterThread(
         WriteCommand cmd, const char* cmdName,
         const uint8_t* data, size_t dataSize, StreamOutHalHidl::WriterCallback callback) {
@@ -134,6 +134,10 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written);
 
+    // Zero-copy write through a buffer of the driver.
+    virtual status_t obtainWriteBuffer(size_t bytes, void **buffer);
+    virtual status_t commitWriteBuffer(size_t bytes, size_t *written);
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint32_t *dspFrames);
@@ -190,6 +194,7 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     std::unique_ptr<CommandMQ> mCommandMQ;
     std::unique_ptr<DataMQ> mDataMQ;
     std::unique_ptr<StatusMQ> mStatusMQ;
+    uint8_t* mObtainedWriteBuffer = nullptr;  // region of mDataMQ from obtainWriteBuffer()
     std::atomic<pid_t> mWriterClient;
     EventFlag* mEfGroup;
 
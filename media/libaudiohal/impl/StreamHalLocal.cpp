@@ -158,6 +158,17 @@ status_t StreamOutHalLocal::write(const void *buffer, size_t bytes, size_t *writ
     }
 }
 
+status_t StreamOutHalLocal::obtainWriteBuffer(size_t bytes __unused, void **buffer) {
+    // The legacy HAL owns no buffer that it could expose.
+    *buffer = nullptr;
+    return INVALID_OPERATION;
+}
+
+status_t StreamOutHalLocal::commitWriteBuffer(size_t bytes __unused, size_t *written) {
+    *written = 0;
+    return INVALID_OPERATION;
+}
+
 status_t StreamOutHalLocal::getRenderPosition(uint32_t *dspFrames) {
     return mStream->get_render_position(mStream, dspFrames);
 }
@@ -109,6 +109,10 @@ class StreamOutHalLocal : public StreamOutHalInterface, public StreamHalLocal {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written);
 
+    // Zero-copy write through a buffer of the driver.
+    virtual status_t obtainWriteBuffer(size_t bytes, void **buffer);
+    virtual status_t commitWriteBuffer(size_t bytes, size_t *written);
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint32_t *dspFrames);
@@ -124,6 +124,17 @@ class StreamOutHalInterface : public virtual StreamHalInterface {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written) = 0;
 
+    // Optional zero-copy alternative to write() for blocking streams: obtains a pointer to
+    // 'bytes' of contiguous memory that the driver reads from directly, so that the caller can
+    // render the audio in place. The data is then handed to the driver with commitWriteBuffer(),
+    // which behaves like write() of the same data. Returns INVALID_OPERATION if unsupported,
+    // or WOULD_BLOCK if not possible for this call, in which case write() must be used.
+    virtual status_t obtainWriteBuffer(size_t bytes, void **buffer) = 0;
+
+    // Completes a successful obtainWriteBuffer() of 'bytes'. The buffer content remains valid
+    // until the next write to the stream, even when fewer bytes than requested were written.
+    virtual status_t commitWriteBuffer(size_t bytes, size_t *written) = 0;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint32_t *dspFrames) = 0;
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_CONVERT_OPS_H
+#define ANDROID_AUDIO_CONVERT_OPS_H
+
+#include <string.h>
+
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+#include <system/audio.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)  // Should be supported in x86 ABI for both 32 & 64-bit.
+#include <tmmintrin.h>
+#endif
+
+namespace android {
+
+/*
+ * Vectorized sample format conversions and mono/stereo remixing used on the capture path
+ * by RecordBufferConverter and ReformatBufferProvider.
+ *
+ * Each function produces the same samples as its audio_utils counterpart, which also handles
+ * the tail that does not fill a whole vector and all targets without NEON or SSSE3.
+ * Conversions to integer round to nearest even and saturate, as clamp16_from_float() and
+ * clamp24_from_float() do; on 32-bit ARM, which has no vector round to nearest, they are
+ * left entirely to audio_utils.
+ *
+ * As with audio_utils, dst may be the same as src when the destination sample is no larger
+ * than the source sample, otherwise the buffers must not overlap.
+ */
+
+// Same as memcpy_to_float_from_i16().
+static inline void convertToFloatFromI16(float *dst, const int16_t *src, size_t count)
+{
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(s)), 15));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(s)), 15));
+    }
+#elif defined(__SSSE3__)
+    const __m128 scale = _mm_set1_ps(1.f / (1 << 15));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        // sign extend by placing each sample in the upper half of a 32 bit lane
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    memcpy_to_float_from_i16(dst + i, src + i, count - i);
+}
+
+// Same as memcpy_to_i16_from_float().
+static inline void convertToI16FromFloat(int16_t *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 8 <= count; i += 8) {
+        // all loads precede the stores, which allows dst == src
+        const int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i), 32768.f));
+        const int32x4_t hi = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(src + i + 4), 32768.f));
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#elif defined(__SSSE3__)
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 limpos = _mm_set1_ps(32767.f);  // _mm_cvtps_epi32() does not saturate
+    for (; i + 8 <= count; i += 8) {
+        const __m128 lo = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), limpos);
+        const __m128 hi = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), limpos);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+#endif
+    memcpy_to_i16_from_float(dst + i, src + i, count - i);
+}
+
+// Same as memcpy_to_float_from_p24().
+static inline void convertToFloatFromP24(float *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; i + 16 <= count; i += 16) {
+        // deinterleave into low, middle and high bytes, then zip them back into
+        // the three upper bytes of each 32 bit lane.
+        const uint8x16x3_t p = vld3q_u8(src + 3 * i);
+        const uint8x16x2_t low = vzipq_u8(vdupq_n_u8(0), p.val[0]);
+        const uint8x16x2_t high = vzipq_u8(p.val[1], p.val[2]);
+        const uint16x8x2_t w0 = vzipq_u16(
+                vreinterpretq_u16_u8(low.val[0]), vreinterpretq_u16_u8(high.val[0]));
+        const uint16x8x2_t w1 = vzipq_u16(
+                vreinterpretq_u16_u8(low.val[1]), vreinterpretq_u16_u8(high.val[1]));
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(vreinterpretq_s32_u16(w0.val[0]), 31));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(vreinterpretq_s32_u16(w0.val[1]), 31));
+        vst1q_f32(dst + i + 8, vcvtq_n_f32_s32(vreinterpretq_s32_u16(w1.val[0]), 31));
+        vst1q_f32(dst + i + 12, vcvtq_n_f32_s32(vreinterpretq_s32_u16(w1.val[1]), 31));
+    }
+#elif defined(__SSSE3__)
+    const __m128i unpack = _mm_setr_epi8(
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 scale = _mm_set1_ps(1.f / (1U << 31));
+    // each load reads 16 bytes for 4 samples, so stop 2 samples short of the end
+    for (; i + 6 <= count; i += 4) {
+        const __m128i p = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+        _mm_storeu_ps(dst + i,
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_shuffle_epi8(p, unpack)), scale));
+    }
+#endif
+    memcpy_to_float_from_p24(dst + i, src + 3 * i, count - i);
+}
+
+#if defined(__aarch64__)
+// Returns one byte of each of the 16 samples in a..d, the byte at SHIFT bits.
+template <int SHIFT>
+static inline uint8x16_t narrowToBytes(int32x4_t a, int32x4_t b, int32x4_t c, int32x4_t d)
+{
+    if constexpr (SHIFT > 0) {
+        a = vshrq_n_s32(a, SHIFT);
+        b = vshrq_n_s32(b, SHIFT);
+        c = vshrq_n_s32(c, SHIFT);
+        d = vshrq_n_s32(d, SHIFT);
+    }
+    const uint16x8_t ab = vcombine_u16(
+            vmovn_u32(vreinterpretq_u32_s32(a)), vmovn_u32(vreinterpretq_u32_s32(b)));
+    const uint16x8_t cd = vcombine_u16(
+            vmovn_u32(vreinterpretq_u32_s32(c)), vmovn_u32(vreinterpretq_u32_s32(d)));
+    return vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+}
+#endif
+
+// Same as memcpy_to_p24_from_float().
+static inline void convertToP24FromFloat(uint8_t *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+#if defined(__aarch64__)
+    const int32x4_t limneg = vdupq_n_s32(-(1 << 23));
+    const int32x4_t limpos = vdupq_n_s32((1 << 23) - 1);
+    for (; i + 16 <= count; i += 16) {
+        int32x4_t q[4];
+        for (int j = 0; j < 4; ++j) {
+            q[j] = vminq_s32(vmaxq_s32(vcvtnq_s32_f32(
+                    vmulq_n_f32(vld1q_f32(src + i + 4 * j), 8388608.f)), limneg), limpos);
+        }
+        // all loads precede the stores, which allows dst == src
+        uint8x16x3_t p;
+        p.val[0] = narrowToBytes<0>(q[0], q[1], q[2], q[3]);
+        p.val[1] = narrowToBytes<8>(q[0], q[1], q[2], q[3]);
+        p.val[2] = narrowToBytes<16>(q[0], q[1], q[2], q[3]);
+        vst3q_u8(dst + 3 * i, p);
+    }
+#elif defined(__SSSE3__)
+    const __m128i pack = _mm_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m128 scale = _mm_set1_ps(8388608.f);
+    const __m128 limneg = _mm_set1_ps(-8388608.f);
+    const __m128 limpos = _mm_set1_ps(8388607.f);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 f = _mm_max_ps(_mm_min_ps(
+                _mm_mul_ps(_mm_loadu_ps(src + i), scale), limpos), limneg);
+        const __m128i p = _mm_shuffle_epi8(_mm_cvtps_epi32(f), pack);
+        _mm_storel_epi64((__m128i *)(dst + 3 * i), p);
+        const int32_t last = _mm_cvtsi128_si32(_mm_srli_si128(p, 8));
+        memcpy(dst + 3 * i + 8, &last, sizeof(last));
+    }
+#endif
+    memcpy_to_p24_from_float(dst + 3 * i, src + i, count - i);
+}
+
+// Same as downmix_to_mono_float_from_stereo_float().
+static inline void downmixToMonoFromStereo(float *dst, const float *src, size_t frames)
+{
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t s = vld2q_f32(src + 2 * i);
+        vst1q_f32(dst + i, vmulq_n_f32(vaddq_f32(s.val[0], s.val[1]), 0.5f));
+    }
+#elif defined(__SSSE3__)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(src + 2 * i);
+        const __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+#endif
+    downmix_to_mono_float_from_stereo_float(dst + i, src + 2 * i, frames - i);
+}
+
+// Same as upmix_to_stereo_float_from_mono_float().
+static inline void upmixToStereoFromMono(float *dst, const float *src, size_t frames)
+{
+    if (dst == src) {  // audio_utils expands in place from the end
+        upmix_to_stereo_float_from_mono_float(dst, src, frames);
+        return;
+    }
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t s;
+        s.val[0] = s.val[1] = vld1q_f32(src + i);
+        vst2q_f32(dst + 2 * i, s);
+    }
+#elif defined(__SSSE3__)
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 s = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(s, s));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(s, s));
+    }
+#endif
+    upmix_to_stereo_float_from_mono_float(dst + 2 * i, src + i, frames - i);
+}
+
+// Same as memcpy_by_audio_format(), with the conversions above for PCM float
+// to and from 16 bit and packed 24 bit.
+static inline void convertByAudioFormat(void *dst, audio_format_t dstFormat,
+        const void *src, audio_format_t srcFormat, size_t count)
+{
+    if (dst != src
+            || audio_bytes_per_sample(dstFormat) <= audio_bytes_per_sample(srcFormat)) {
+        if (dstFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            switch (srcFormat) {
+            case AUDIO_FORMAT_PCM_16_BIT:
+                convertToFloatFromI16((float *)dst, (const int16_t *)src, count);
+                return;
+            case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+                convertToFloatFromP24((float *)dst, (const uint8_t *)src, count);
+                return;
+            default:
+                break;
+            }
+        } else if (srcFormat == AUDIO_FORMAT_PCM_FLOAT) {
+            switch (dstFormat) {
+            case AUDIO_FORMAT_PCM_16_BIT:
+                convertToI16FromFloat((int16_t *)dst, (const float *)src, count);
+                return;
+            case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+                convertToP24FromFloat((uint8_t *)dst, (const float *)src, count);
+                return;
+            default:
+                break;
+            }
+        }
+    }
+    memcpy_by_audio_format(dst, dstFormat, src, srcFormat, count);
+}
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_CONVERT_OPS_H
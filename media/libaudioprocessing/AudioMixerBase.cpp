@@ -27,6 +27,7 @@
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
+#include "AudioMixerWorkerPool.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -51,6 +52,9 @@
 // TODO: remove BLOCKSIZE unit of processing - it isn't needed anymore.
 static constexpr int BLOCKSIZE = 16;
 
+// Maximum number of tracks accumulated in one pass by process__batchNoResampling().
+static constexpr size_t kMaxBatchTracks = 8;
+
 namespace android {
 
 // ----------------------------------------------------------------------------
@@ -589,6 +593,29 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+void AudioMixerBase::setResampleWorkers(size_t workerCount,
+        const std::function<void(pid_t, size_t)>& init)
+{
+    if (workerCount == getResampleWorkerCount()) return;
+    mResampleWorkers.reset(); // joins any previous workers
+    if (workerCount > 0) {
+        mResampleWorkers = std::make_shared<AudioMixerWorkerPool>(workerCount, init);
+        mWorkerTask = [this](size_t index) {
+            TrackBase * const t = mWorkerTracks[index];
+            memset(t->mWorkerOut.get(), 0,
+                    mWorkerFrameCount * t->mMixerChannelCount * sizeof(int32_t));
+            (t->*t->hook)(t->mWorkerOut.get(), mWorkerFrameCount, t->mWorkerTemp.get(),
+                    nullptr /* aux */);
+        };
+    }
+    invalidate();
+}
+
+size_t AudioMixerBase::getResampleWorkerCount() const
+{
+    return mResampleWorkers != nullptr ? mResampleWorkers->getWorkerCount() : 0;
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -598,6 +625,10 @@ std::string AudioMixerBase::trackNames() const
     return ss.str();
 }
 
+// Defined below with the other multi-format helpers.
+template <int MIXTYPE, typename TV>
+static void channelVolumes(uint32_t channels, TV *chvol, const TV *vol);
+
 void AudioMixerBase::process__validate()
 {
     // TODO: fix all16BitsStereNoResample logic to
@@ -633,6 +664,7 @@ void AudioMixerBase::process__validate()
             n |= NEEDS_MUTE;
         }
         t->needs = n;
+        t->mBatchMix = false;
 
         if (n & NEEDS_MUTE) {
             t->hook = &TrackBase::track__nop;
@@ -662,11 +694,12 @@ void AudioMixerBase::process__validate()
                 ALOGV_IF((n & NEEDS_CHANNEL_COUNT__MASK) > NEEDS_CHANNEL_2,
                         "Track %d needs downmix + resample", name);
             } else {
+                const bool monoExpand = (n & NEEDS_CHANNEL_COUNT__MASK) == NEEDS_CHANNEL_1
+                        && isAudioChannelPositionMask(t->mMixerChannelMask) // TODO: MONO_HACK
+                        && t->channelMask == AUDIO_CHANNEL_OUT_MONO;
                 if ((n & NEEDS_CHANNEL_COUNT__MASK) == NEEDS_CHANNEL_1){
                     t->hook = TrackBase::getTrackHook(
-                            (isAudioChannelPositionMask(t->mMixerChannelMask)  // TODO: MONO_HACK
-                                    && t->channelMask == AUDIO_CHANNEL_OUT_MONO)
-                                ? TRACKTYPE_NORESAMPLEMONO : TRACKTYPE_NORESAMPLE,
+                            monoExpand ? TRACKTYPE_NORESAMPLEMONO : TRACKTYPE_NORESAMPLE,
                             t->mMixerChannelCount,
                             t->mMixerInFormat, t->mMixerFormat);
                     all16BitsStereoNoResample = false;
@@ -680,6 +713,20 @@ void AudioMixerBase::process__validate()
                     ALOGV_IF((n & NEEDS_CHANNEL_COUNT__MASK) > NEEDS_CHANNEL_2,
                             "Track %d needs downmix", name);
                 }
+                // Tracks whose input has the mixer channel layout and no aux send can
+                // also be accumulated with other tracks by process__batchNoResampling().
+                if (kUseNewMixer && t->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+                        && (n & NEEDS_AUX) == 0 && !monoExpand) {
+                    if ((n & NEEDS_CHANNEL_COUNT__MASK) >= NEEDS_CHANNEL_2
+                            && t->useStereoVolume()) {
+                        channelVolumes<MIXTYPE_MULTI_STEREOVOL>(
+                                t->mMixerChannelCount, t->mChannelVolume, t->mVolume);
+                    } else {
+                        channelVolumes<MIXTYPE_MULTI>(
+                                t->mMixerChannelCount, t->mChannelVolume, t->mVolume);
+                    }
+                    t->mBatchMix = true;
+                }
             }
         }
     }
@@ -694,6 +741,17 @@ void AudioMixerBase::process__validate()
             if (mResampleTemp.get() == nullptr) {
                 mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
             }
+            if (mResampleWorkers != nullptr) {
+                for (const int name : mEnabled) {
+                    const std::shared_ptr<TrackBase> &t = mTracks[name];
+                    if ((t->needs & NEEDS_RESAMPLE) && (t->needs & NEEDS_AUX) == 0
+                            && t->mWorkerOut.get() == nullptr) {
+                        t->mWorkerOut.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                        t->mWorkerTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+                    }
+                }
+                mWorkerTracks.reserve(mEnabled.size());
+            }
             mHook = &AudioMixerBase::process__genericResampling;
         } else {
             // we keep temp arrays around.
@@ -1092,12 +1150,28 @@ void AudioMixerBase::process__genericNoResampling()
         }
 
         int32_t *out = (int *)pair.first;
+        const uint32_t groupChannelCount = mTracks[group[0]]->mMixerChannelCount;
         size_t numFrames = 0;
         do {
             const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
             memset(outTemp, 0, sizeof(outTemp));
+            // Tracks that can be mixed with a constant per-channel volume and have the
+            // whole block available are deferred and accumulated several at a time.
+            TrackBase *batch[kMaxBatchTracks];
+            size_t batchCount = 0;
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if (t->mBatchMix && (t->needs & NEEDS_MUTE) == 0 && !t->needsRamp()
+                        && t->mIn != nullptr && t->frameCount >= frameCount
+                        && t->mMixerChannelCount == groupChannelCount) {
+                    batch[batchCount++] = t.get();
+                    if (batchCount == kMaxBatchTracks) {
+                        process__batchNoResampling<kMaxBatchTracks>(
+                                batch, reinterpret_cast<float *>(outTemp), frameCount);
+                        batchCount = 0;
+                    }
+                    continue;
+                }
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1132,6 +1206,22 @@ void AudioMixerBase::process__genericNoResampling()
                     }
                 }
             }
+            // Flush the remaining deferred tracks, largest kernels first.
+            size_t batched = 0;
+            if (batchCount - batched >= 4) {
+                process__batchNoResampling<4>(
+                        batch + batched, reinterpret_cast<float *>(outTemp), frameCount);
+                batched += 4;
+            }
+            if (batchCount - batched >= 2) {
+                process__batchNoResampling<2>(
+                        batch + batched, reinterpret_cast<float *>(outTemp), frameCount);
+                batched += 2;
+            }
+            if (batchCount - batched >= 1) {
+                process__batchNoResampling<1>(
+                        batch + batched, reinterpret_cast<float *>(outTemp), frameCount);
+            }
 
             const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
             convertMixerFormat(out, t1->mMixerFormat, outTemp, t1->mMixerInFormat,
@@ -1151,6 +1241,57 @@ void AudioMixerBase::process__genericNoResampling()
     }
 }
 
+/* Accumulates NTRACKS tracks selected by process__genericNoResampling() into the
+ * float mix buffer out, then advances each track's input by frameCount frames.
+ * All tracks must have the same mixer channel count and at least frameCount
+ * frames available.
+ */
+template <int NTRACKS>
+void AudioMixerBase::process__batchNoResampling(
+        TrackBase * const *tracks, float *out, size_t frameCount)
+{
+    ALOGVV("process__batchNoResampling NTRACKS:%d\n", NTRACKS);
+    const float *in[NTRACKS];
+    const float *chvol[NTRACKS];
+    for (int i = 0; i < NTRACKS; ++i) {
+        in[i] = static_cast<const float *>(tracks[i]->mIn);
+        chvol[i] = tracks[i]->mChannelVolume;
+    }
+    const uint32_t channels = tracks[0]->mMixerChannelCount;
+    switch (channels) {
+    case 1:
+        volumeMultiAccumTracks<NTRACKS, 1>(out, frameCount, in, chvol);
+        break;
+    case 2:
+        volumeMultiAccumTracks<NTRACKS, 2>(out, frameCount, in, chvol);
+        break;
+    case 3:
+        volumeMultiAccumTracks<NTRACKS, 3>(out, frameCount, in, chvol);
+        break;
+    case 4:
+        volumeMultiAccumTracks<NTRACKS, 4>(out, frameCount, in, chvol);
+        break;
+    case 5:
+        volumeMultiAccumTracks<NTRACKS, 5>(out, frameCount, in, chvol);
+        break;
+    case 6:
+        volumeMultiAccumTracks<NTRACKS, 6>(out, frameCount, in, chvol);
+        break;
+    case 7:
+        volumeMultiAccumTracks<NTRACKS, 7>(out, frameCount, in, chvol);
+        break;
+    case 8:
+        volumeMultiAccumTracks<NTRACKS, 8>(out, frameCount, in, chvol);
+        break;
+    default:
+        LOG_ALWAYS_FATAL("bad channel count: %u", channels);
+    }
+    for (int i = 0; i < NTRACKS; ++i) {
+        tracks[i]->mIn = in[i] + frameCount * channels;
+        tracks[i]->frameCount -= frameCount;
+    }
+}
+
 // generic code with resampling
 void AudioMixerBase::process__genericResampling()
 {
@@ -1162,10 +1303,28 @@ void AudioMixerBase::process__genericResampling()
         const auto &group = pair.second;
         const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
 
+        // Resampling tracks without aux send are handed to the workers, if any, into
+        // their private buffers, while the other tracks are mixed here.
+        mWorkerTracks.clear();
+        if (mResampleWorkers != nullptr) {
+            for (const int name : group) {
+                const std::shared_ptr<TrackBase> &t = mTracks[name];
+                if ((t->needs & NEEDS_RESAMPLE) && (t->needs & NEEDS_AUX) == 0) {
+                    mWorkerTracks.push_back(t.get());
+                }
+            }
+            mWorkerFrameCount = numFrames;
+            mResampleWorkers->start(mWorkerTracks.size(), &mWorkerTask);
+        }
+
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
+            if (mResampleWorkers != nullptr && (t->needs & NEEDS_RESAMPLE)
+                    && (t->needs & NEEDS_AUX) == 0) {
+                continue; // on a worker
+            }
             int32_t *aux = NULL;
             if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                 aux = t->auxBuffer;
@@ -1198,6 +1357,25 @@ void AudioMixerBase::process__genericResampling()
                 }
             }
         }
+        if (mResampleWorkers != nullptr) {
+            // barrier: all worker tracks of this group are done.
+            mResampleWorkers->wait();
+            const size_t sampleCount = numFrames * t1->mMixerChannelCount;
+            for (TrackBase * const t : mWorkerTracks) {
+                if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    float * const out = reinterpret_cast<float *>(outTemp);
+                    const float * const in = reinterpret_cast<const float *>(t->mWorkerOut.get());
+                    for (size_t i = 0; i < sampleCount; ++i) {
+                        out[i] += in[i];
+                    }
+                } else {
+                    const int32_t * const in = t->mWorkerOut.get();
+                    for (size_t i = 0; i < sampleCount; ++i) {
+                        outTemp[i] += in[i];
+                    }
+                }
+            }
+        }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
                 outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
     }
@@ -1429,6 +1607,40 @@ void AudioMixerBase::TrackBase::volumeMix(TO *out, size_t outFrames,
     }
 }
 
+/* MIXTYPE     (see AudioMixerOps.h MIXTYPE_* enumeration)
+ * TV: float
+ */
+template <int MIXTYPE, typename TV>
+static void channelVolumes(uint32_t channels, TV *chvol, const TV *vol)
+{
+    switch (channels) {
+    case 1:
+        channelVolumes<MIXTYPE, 1>(chvol, vol);
+        break;
+    case 2:
+        channelVolumes<MIXTYPE, 2>(chvol, vol);
+        break;
+    case 3:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 3>(chvol, vol);
+        break;
+    case 4:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 4>(chvol, vol);
+        break;
+    case 5:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 5>(chvol, vol);
+        break;
+    case 6:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 6>(chvol, vol);
+        break;
+    case 7:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 7>(chvol, vol);
+        break;
+    case 8:
+        channelVolumes<MIXTYPE_MONOVOL(MIXTYPE), 8>(chvol, vol);
+        break;
+    }
+}
+
 /* This process hook is called when there is a single track without
  * aux buffer, volume ramp, or resampling.
  * TODO: Update the hook selection: this can properly handle aux and ramp.
@@ -17,6 +17,12 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -525,6 +531,105 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * channelVolumes expands the track volume array vol into a per-channel
+ * volume array chvol of NCHAN entries, following the same channel to
+ * volume assignment as volumeMulti for the given MIXTYPE.
+ *
+ * Only the non-expanding multichannel MIXTYPEs are supported, i.e. those
+ * where the input and output channel counts are both NCHAN.
+ */
+template <int MIXTYPE, int NCHAN, typename TV>
+inline void channelVolumes(TV *chvol, const TV *vol)
+{
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        static_assert(NCHAN <= 2);
+        for (int i = 0; i < NCHAN; ++i) {
+            chvol[i] = vol[i];
+        }
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        for (int i = 0; i < NCHAN; ++i) {
+            chvol[i] = vol[0];
+        }
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        // Use the helper on a unity input so the channel layout stays in one place.
+        TV unity[NCHAN];
+        for (int i = 0; i < NCHAN; ++i) {
+            unity[i] = 1;
+        }
+        const TV *in = unity;
+        stereoVolumeHelper<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>(
+                chvol, in, vol, [] (const auto &a, const auto &b) {
+            return a * b;
+        });
+    } else /* constexpr */ {
+        static_assert(dependent_false<MIXTYPE>, "invalid mixtype");
+    }
+}
+
+/*
+ * volumeMultiAccumTracks accumulates NTRACKS float input streams of NCHAN
+ * interleaved channels into out, each stream scaled by its own constant
+ * per-channel volume chvol[track][channel] (see channelVolumes above).
+ *
+ * The result is the same as NTRACKS successive calls to volumeMulti with
+ * an accumulating MIXTYPE and no aux buffer, but the output is loaded and
+ * stored only once per sample instead of once per track.
+ *
+ * On NEON and SSE capable targets the inner loop works on 4-sample vectors.
+ * The per-channel volumes are replicated to PERIOD samples, the smallest
+ * multiple of the vector width holding a whole number of frames, so the
+ * volume vectors stay loop invariant for any channel count.
+ */
+template <int NTRACKS, int NCHAN>
+inline void volumeMultiAccumTracks(float* out, size_t frameCount,
+        const float* const* in, const float* const* chvol)
+{
+    static_assert(NTRACKS > 0 && NCHAN > 0 && NCHAN <= 8);
+    const size_t sampleCount = frameCount * NCHAN;
+    size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON__) || defined(__SSE__)
+    constexpr int GCD4 = (NCHAN % 4 == 0) ? 4 : (NCHAN % 2 == 0) ? 2 : 1;
+    constexpr int PERIOD = NCHAN * 4 / GCD4; // lcm(NCHAN, 4)
+    float vol[NTRACKS][PERIOD] __attribute__((aligned(16)));
+    for (int t = 0; t < NTRACKS; ++t) {
+        for (int k = 0; k < PERIOD; ++k) {
+            vol[t][k] = chvol[t][k % NCHAN];
+        }
+    }
+    for (; i + PERIOD <= sampleCount; i += PERIOD) {
+        for (int k = 0; k < PERIOD; k += 4) {
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+            float32x4_t acc = vld1q_f32(out + i + k);
+            for (int t = 0; t < NTRACKS; ++t) {
+                acc = vmlaq_f32(acc, vld1q_f32(in[t] + i + k), vld1q_f32(&vol[t][k]));
+            }
+            vst1q_f32(out + i + k, acc);
+#else
+            __m128 acc = _mm_loadu_ps(out + i + k);
+            for (int t = 0; t < NTRACKS; ++t) {
+                acc = _mm_add_ps(acc,
+                        _mm_mul_ps(_mm_loadu_ps(in[t] + i + k), _mm_load_ps(&vol[t][k])));
+            }
+            _mm_storeu_ps(out + i + k, acc);
+#endif
+        }
+    }
+#endif
+    // Remaining frames, i is always at a frame boundary here.
+    for (; i < sampleCount; i += NCHAN) {
+        for (int c = 0; c < NCHAN; ++c) {
+            float acc = out[i + c];
+            for (int t = 0; t < NTRACKS; ++t) {
+                acc += in[t][i + c] * chvol[t][c];
+            }
+            out[i + c] = acc;
+        }
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
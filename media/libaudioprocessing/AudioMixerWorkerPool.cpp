@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioMixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+#include <string>
+#include <unistd.h>
+
+#include <utils/Log.h>
+
+#include "AudioMixerWorkerPool.h"
+
+namespace android {
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(size_t workerCount, const init_t& init)
+{
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        mWorkers.emplace_back(&AudioMixerWorkerPool::threadLoop, this, i, init);
+    }
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool()
+{
+    {
+        std::lock_guard l(mLock);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    for (auto &worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void AudioMixerWorkerPool::start(size_t taskCount, const task_t *task)
+{
+    LOG_ALWAYS_FATAL_IF(mPendingTasks.load() != 0, "start() called with a cycle in progress");
+    {
+        std::lock_guard l(mLock);
+        ++mGeneration;
+        mTaskCount = taskCount;
+        mTask = task;
+        mPendingTasks.store(taskCount);
+        mNextTask.store((uint64_t)mGeneration << 32);
+    }
+    if (taskCount > 0) {
+        mWorkCv.notify_all();
+    }
+}
+
+void AudioMixerWorkerPool::wait()
+{
+    // Only the caller of start() modifies these fields, so no lock is needed to read them.
+    runTasks(mGeneration, mTaskCount, mTask);
+
+    std::unique_lock l(mLock);
+    mDoneCv.wait(l, [this] { return mPendingTasks.load() == 0; });
+}
+
+void AudioMixerWorkerPool::runTasks(uint32_t generation, size_t taskCount, const task_t *task)
+{
+    uint64_t next = mNextTask.load();
+    while (true) {
+        if ((uint32_t)(next >> 32) != generation || (uint32_t)next >= taskCount) {
+            return;
+        }
+        if (!mNextTask.compare_exchange_weak(next, next + 1)) {
+            continue; // next was reloaded.
+        }
+        (*task)((uint32_t)next);
+        if (mPendingTasks.fetch_sub(1) == 1) {
+            std::lock_guard l(mLock);
+            mDoneCv.notify_one();
+        }
+        next = mNextTask.load();
+    }
+}
+
+void AudioMixerWorkerPool::threadLoop(size_t workerIndex, init_t init)
+{
+    const std::string name = "AudioMixWorker" + std::to_string(workerIndex);
+    (void)pthread_setname_np(pthread_self(), name.c_str());
+    if (init) {
+        init(gettid(), workerIndex);
+    }
+
+    uint32_t generation = 0;
+    while (true) {
+        size_t taskCount;
+        const task_t *task;
+        {
+            std::unique_lock l(mLock);
+            mWorkCv.wait(l, [&] { return mExit || mGeneration != generation; });
+            if (mExit) break;
+            generation = mGeneration;
+            taskCount = mTaskCount;
+            task = mTask;
+        }
+        runTasks(generation, taskCount, task);
+    }
+    ALOGV("%s exiting", name.c_str());
+}
+
+}  // namespace android
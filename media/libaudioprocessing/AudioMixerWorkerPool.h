@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace android {
+
+/* AudioMixerWorkerPool
+ *
+ * A small, fixed set of threads used by AudioMixerBase to run independent
+ * per-track work in parallel within one mixer cycle.
+ *
+ * A cycle is started with start(), which publishes taskCount tasks.
+ * The workers and the thread that calls wait() claim tasks one at a time,
+ * wait() returns once every task of the cycle has completed (the barrier).
+ * Only one cycle may be in progress at a time, and start() and wait() must
+ * be called from the same thread. No memory is allocated after construction.
+ */
+class AudioMixerWorkerPool {
+public:
+    using task_t = std::function<void(size_t /* index */)>;
+
+    // Called once on each worker thread before it takes any task, for example to
+    // set the scheduling policy and the CPU affinity of the thread.
+    using init_t = std::function<void(pid_t /* tid */, size_t /* workerIndex */)>;
+
+    AudioMixerWorkerPool(size_t workerCount, const init_t& init);
+    ~AudioMixerWorkerPool();
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+    // Publishes tasks [0, taskCount) of task to the workers. The task object must
+    // remain valid until wait() returns.
+    void start(size_t taskCount, const task_t *task);
+
+    // Runs any unclaimed tasks on the calling thread, then blocks until all tasks
+    // published by the last start() have completed.
+    void wait();
+
+private:
+    void threadLoop(size_t workerIndex, init_t init);
+
+    // Claims and runs tasks of generation until there are none left.
+    void runTasks(uint32_t generation, size_t taskCount, const task_t *task);
+
+    std::mutex              mLock;
+    std::condition_variable mWorkCv;     // workers wait here for a new cycle
+    std::condition_variable mDoneCv;     // wait() waits here for the barrier
+    bool                    mExit = false;     // guarded by mLock
+    uint32_t                mGeneration = 0;   // guarded by mLock
+    size_t                  mTaskCount = 0;    // guarded by mLock
+    const task_t           *mTask = nullptr;   // guarded by mLock
+
+    // Upper 32 bits are the generation, lower 32 bits the next unclaimed task index.
+    // Tagging the index with the generation prevents a late worker of a finished
+    // cycle from claiming a task of the following one.
+    std::atomic<uint64_t>   mNextTask{0};
+    std::atomic<size_t>     mPendingTasks{0};  // tasks not yet completed in this cycle
+
+    std::vector<std::thread> mWorkers;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_AUDIO_MIXER_WORKER_POOL_H
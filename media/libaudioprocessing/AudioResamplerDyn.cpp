@@ -17,8 +17,12 @@
 #define LOG_TAG "AudioResamplerDyn"
 //#define LOG_NDEBUG 0
 
+#include <list>
 #include <malloc.h>
+#include <map>
+#include <mutex>
 #include <string.h>
+#include <tuple>
 #include <stdlib.h>
 #include <dlfcn.h>
 #include <math.h>
@@ -182,8 +186,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -208,7 +211,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -257,23 +259,51 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 }
 
 template<typename TC, typename TI, typename TO>
-void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
-        double stopBandAtten, double fcr) {
-    // compute the normalized transition bandwidth
-    const double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
-    const int phases = c.mL;
-    const int halfLength = c.mHalfNumCoefs;
+std::shared_ptr<const typename AudioResamplerDyn<TC, TI, TO>::FilterBank>
+AudioResamplerDyn<TC, TI, TO>::getFilterBank(
+        int phases, int halfLength, double stopBandAtten, double fcr)
+{
+    // Number of filter banks kept alive after their last resampler is gone, so that
+    // short-lived tracks and rate changes back and forth do not redesign the filter.
+    static constexpr size_t kRetainedFilterBanks = 8;
+
+    using Key = std::tuple<int /* phases */, int /* halfLength */,
+            double /* stopBandAtten */, double /* fcr */>;
+    struct Cache {
+        std::mutex lock;
+        std::map<Key, std::weak_ptr<const FilterBank>> banks;     // GUARDED_BY(lock)
+        std::list<std::shared_ptr<const FilterBank>> retained;   // GUARDED_BY(lock), MRU first
+    };
+    // Never destroyed, as resamplers may still be in use during static destruction.
+    static Cache * const sCache = new Cache;
+    auto &cache = sCache->banks;
+    auto &retained = sCache->retained;
+
+    const Key key{phases, halfLength, stopBandAtten, fcr};
+    std::lock_guard l(sCache->lock);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        std::shared_ptr<const FilterBank> bank = it->second.lock();
+        if (bank != nullptr) {
+            for (auto rit = retained.begin(); rit != retained.end(); ++rit) {
+                if (*rit == bank) {
+                    retained.splice(retained.begin(), retained, rit);
+                    break;
+                }
+            }
+            return bank;
+        }
+    }
 
-    // create buffer
+    // Not cached: design a new filter bank.
+    auto bank = std::make_shared<FilterBank>();
     TC *coefs = nullptr;
     int ret = posix_memalign(
             reinterpret_cast<void **>(&coefs),
             CACHE_LINE_SIZE /* alignment */,
             (phases + 1) * halfLength * sizeof(TC));
     LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
+    bank->mCoefs = coefs;
 
     // square the computed minimum passband value (extra safety).
     double attenuation =
@@ -283,31 +313,57 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     // design filter
     firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
 
+    // record the design criteria
+    bank->mNormalizedCutoffFrequency = fcr;
+    bank->mNormalizedTransitionBandwidth = firKaiserTbw(halfLength, stopBandAtten);
+    bank->mFilterAttenuation = attenuation;
+    bank->mStopbandAttenuationDb = stopBandAtten;
+    bank->mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+
+    // drop expired entries, then cache the new bank.
+    for (auto cit = cache.begin(); cit != cache.end(); ) {
+        cit = cit->second.expired() ? cache.erase(cit) : std::next(cit);
+    }
+    cache[key] = bank;
+    retained.push_front(bank);
+    if (retained.size() > kRetainedFilterBanks) {
+        retained.pop_back();
+    }
+    return bank;
+}
+
+template<typename TC, typename TI, typename TO>
+void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
+        double stopBandAtten, double fcr) {
+    mFilterBank = getFilterBank(c.mL, c.mHalfNumCoefs, stopBandAtten, fcr);
+    c.mFirCoefs = mFilterBank->mCoefs;
+
     // update the design criteria
-    mNormalizedCutoffFrequency = fcr;
-    mNormalizedTransitionBandwidth = tbw;
-    mFilterAttenuation = attenuation;
-    mStopbandAttenuationDb = stopBandAtten;
-    mPassbandRippleDb = computeWindowedSincPassbandRippleDb(stopBandAtten);
+    mNormalizedCutoffFrequency = mFilterBank->mNormalizedCutoffFrequency;
+    mNormalizedTransitionBandwidth = mFilterBank->mNormalizedTransitionBandwidth;
+    mFilterAttenuation = mFilterBank->mFilterAttenuation;
+    mStopbandAttenuationDb = mFilterBank->mStopbandAttenuationDb;
+    mPassbandRippleDb = mFilterBank->mPassbandRippleDb;
 
 #if 0
     // Keep this debug code in case an app causes resampler design issues.
-    const double halfbw = tbw * 0.5;
+    const double halfbw = mNormalizedTransitionBandwidth * 0.5;
     // print basic filter stats
     ALOGD("L:%d  hnc:%d  stopBandAtten:%lf  fcr:%lf  atten:%lf  tbw:%lf\n",
-            c.mL, c.mHalfNumCoefs, stopBandAtten, fcr, attenuation, tbw);
+            c.mL, c.mHalfNumCoefs, stopBandAtten, fcr, mFilterAttenuation,
+            mNormalizedTransitionBandwidth);
 
     // test the filter and report results.
     // Since this is a polyphase filter, normalized fp and fs must be scaled.
-    const double fp = (fcr - halfbw) / phases;
-    const double fs = (fcr + halfbw) / phases;
+    const double fp = (fcr - halfbw) / c.mL;
+    const double fs = (fcr + halfbw) / c.mL;
 
     double passMin, passMax, passRipple;
     double stopMax, stopRipple;
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
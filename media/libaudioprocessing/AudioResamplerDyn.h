@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_DYN_H
 #define ANDROID_AUDIO_RESAMPLER_DYN_H
 
+#include <memory>
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
@@ -152,6 +153,28 @@ private:
 
     void createKaiserFir(Constants &c, double stopBandAtten, double fcr);
 
+    // An immutable polyphase filter bank and its design criteria.
+    // Filter banks are shared by all resamplers of the process with the same
+    // coefficient type and design parameters, see getFilterBank().
+    struct FilterBank {
+        FilterBank() = default;
+        FilterBank(const FilterBank&) = delete;
+        FilterBank& operator=(const FilterBank&) = delete;
+        ~FilterBank() { free(mCoefs); }
+
+        TC*    mCoefs = nullptr;   // (phases + 1) * halfLength coefficients
+        double mNormalizedCutoffFrequency = 0.;
+        double mNormalizedTransitionBandwidth = 0.;
+        double mFilterAttenuation = 0.;
+        double mStopbandAttenuationDb = 0.;
+        double mPassbandRippleDb = 0.;
+    };
+
+    // Returns the filter bank for the design parameters from the process-wide cache,
+    // designing it only if no resampler uses it and it is not recently used.
+    static std::shared_ptr<const FilterBank> getFilterBank(
+            int phases, int halfLength, double stopBandAtten, double fcr);
+
     template<int CHANNELS, bool LOCKED, int STRIDE>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
@@ -166,7 +189,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const FilterBank> mFilterBank; // if a filter is created, this is not null
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
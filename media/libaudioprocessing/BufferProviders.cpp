@@ -31,6 +31,8 @@
 #include <system/audio_effects/effect_downmix.h>
 #include <utils/Log.h>
 
+#include "AudioConvertOps.h"
+
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 #endif
@@ -381,7 +383,7 @@ ReformatBufferProvider::ReformatBufferProvider(int32_t channelCount,
 
 void ReformatBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
 {
-    memcpy_by_audio_format(dst, mOutputFormat, src, mInputFormat, frames * mChannelCount);
+    convertByAudioFormat(dst, mOutputFormat, src, mInputFormat, frames * mChannelCount);
 }
 
 ClampFloatBufferProvider::ClampFloatBufferProvider(int32_t channelCount, size_t bufferFrameCount) :
@@ -25,6 +25,8 @@
 #include <media/RecordBufferConverter.h>
 #include <utils/Log.h>
 
+#include "AudioConvertOps.h"
+
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 #endif
@@ -234,14 +236,14 @@ void RecordBufferConverter::convertNoResampler(
     if (mIsLegacyUpmix || mIsLegacyDownmix) {
         void *dstBuf = mBuf != NULL ? mBuf : dst;
         if (mIsLegacyUpmix) {
-            upmix_to_stereo_float_from_mono_float((float *)dstBuf,
+            upmixToStereoFromMono((float *)dstBuf,
                     (const float *)src, frames);
         } else /*mIsLegacyDownmix */ {
-            downmix_to_mono_float_from_stereo_float((float *)dstBuf,
+            downmixToMonoFromStereo((float *)dstBuf,
                     (const float *)src, frames);
         }
         if (mBuf != NULL) {
-            memcpy_by_audio_format(dst, mDstFormat, mBuf, AUDIO_FORMAT_PCM_FLOAT,
+            convertByAudioFormat(dst, mDstFormat, mBuf, AUDIO_FORMAT_PCM_FLOAT,
                     frames * mDstChannelCount);
         }
         return;
@@ -257,7 +259,7 @@ void RecordBufferConverter::convertNoResampler(
     }
     // convert to destination buffer
     const void *convertBuf = mBuf != NULL ? mBuf : src;
-    memcpy_by_audio_format(dst, mDstFormat, convertBuf, mSrcFormat,
+    convertByAudioFormat(dst, mDstFormat, convertBuf, mSrcFormat,
             frames * mDstChannelCount);
 }
 
@@ -271,18 +273,18 @@ void RecordBufferConverter::convertResampler(
             || (mSrcChannelMask == mDstChannelMask && mSrcChannelCount == 1)) {
         // the resampler outputs stereo for mono input channel (a feature?)
         // must convert to mono
-        downmix_to_mono_float_from_stereo_float((float *)src,
+        downmixToMonoFromStereo((float *)src,
                 (const float *)src, frames);
     } else if (mSrcChannelMask != mDstChannelMask) {
         // convert to mono channel again for channel mask conversion (could be skipped
         // with further optimization).
         if (mSrcChannelCount == 1) {
-            downmix_to_mono_float_from_stereo_float((float *)src,
+            downmixToMonoFromStereo((float *)src,
                 (const float *)src, frames);
         }
         // convert to destination format (in place, OK as float is larger than other types)
         if (mDstFormat != AUDIO_FORMAT_PCM_FLOAT) {
-            memcpy_by_audio_format(src, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
+            convertByAudioFormat(src, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
                     frames * mSrcChannelCount);
         }
         // channel convert and save to dst
@@ -291,7 +293,7 @@ void RecordBufferConverter::convertResampler(
         return;
     }
     // convert to destination format and save to dst
-    memcpy_by_audio_format(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
+    convertByAudioFormat(dst, mDstFormat, src, AUDIO_FORMAT_PCM_FLOAT,
             frames * mDstChannelCount);
 }
 
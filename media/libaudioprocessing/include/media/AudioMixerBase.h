@@ -18,6 +18,7 @@
 #ifndef ANDROID_AUDIO_MIXER_BASE_H
 #define ANDROID_AUDIO_MIXER_BASE_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -36,6 +37,8 @@
 
 namespace android {
 
+class AudioMixerWorkerPool;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -134,6 +137,18 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Enable parallel resampling on workerCount worker threads, or disable it if 0.
+    // When enabled, resampling tracks without an aux send are resampled and volume
+    // scaled on the workers, and summed on the thread calling process() once all of
+    // them have completed. The track buffer providers are then called from the workers.
+    //
+    // \param init  called on each worker thread when it starts, e.g. to set its
+    //               scheduling priority and CPU affinity.
+    void        setResampleWorkers(size_t workerCount,
+                        const std::function<void(pid_t /* tid */, size_t /* index */)>& init
+                                = nullptr);
+    size_t      getResampleWorkerCount() const;
+
     std::string trackNames() const;
 
   protected:
@@ -291,6 +306,17 @@ public:
         audio_channel_mask_t mMixerChannelMask;
         uint32_t             mMixerChannelCount;
 
+        // Set by process__validate() for float tracks without resampling, mono expansion
+        // or aux send, which may be accumulated together with other such tracks in a
+        // single pass by process__genericNoResampling() while they are not ramping.
+        bool           mBatchMix = false;
+        float          mChannelVolume[MAX_NUM_CHANNELS]; // per-channel mVolume when mBatchMix
+
+        // Private output and temp buffers of mFrameCount frames, allocated by
+        // process__validate() when the track is resampled on a worker thread.
+        std::unique_ptr<int32_t[]> mWorkerOut;
+        std::unique_ptr<int32_t[]> mWorkerTemp;
+
       protected:
 
         // hooks
@@ -331,6 +357,9 @@ public:
     void process__validate();
     void process__nop();
     void process__genericNoResampling();
+    template <int NTRACKS>
+    static void process__batchNoResampling(
+            TrackBase * const *tracks, float *out, size_t frameCount);
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
 
@@ -355,6 +384,13 @@ public:
     std::unique_ptr<int32_t[]> mOutputTemp;
     std::unique_ptr<int32_t[]> mResampleTemp;
 
+    // worker threads for parallel resampling, nullptr if disabled.
+    std::shared_ptr<AudioMixerWorkerPool> mResampleWorkers;
+    // tracks of the current group resampled on the workers by process__genericResampling().
+    std::vector<TrackBase *> mWorkerTracks;
+    size_t                   mWorkerFrameCount = 0;
+    std::function<void(size_t)> mWorkerTask;
+
     // track names grouped by main buffer, in no particular order of main buffer.
     // however names for a particular main buffer are in order (by construction).
     std::unordered_map<void * /* mainBuffer */, std::vector<int /* name */>> mGroups;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <../AudioConvertOps.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace android;
+
+// Capture sized buffer: 20 ms at 48 kHz of a 4 channel microphone array.
+static constexpr size_t FRAME_COUNT = 960;
+static constexpr size_t CHANNEL_COUNT = 4;
+static constexpr size_t SAMPLE_COUNT = FRAME_COUNT * CHANNEL_COUNT;
+
+static void fillFloat(float *data, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = (float)rand() / RAND_MAX * 2.f - 1.f;
+    }
+}
+
+// Converts SAMPLE_COUNT samples with audio_utils, or the vectorized path if VECTOR.
+template <audio_format_t DST, audio_format_t SRC, bool VECTOR>
+static void BM_Convert(benchmark::State& state) {
+    static float reference[SAMPLE_COUNT];
+    static uint8_t in[SAMPLE_COUNT * sizeof(float)];
+    static uint8_t out[SAMPLE_COUNT * sizeof(float)];
+
+    fillFloat(reference, SAMPLE_COUNT);
+    memcpy_by_audio_format(in, SRC, reference, AUDIO_FORMAT_PCM_FLOAT, SAMPLE_COUNT);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(in);
+        if (VECTOR) {
+            convertByAudioFormat(out, DST, in, SRC, SAMPLE_COUNT);
+        } else {
+            memcpy_by_audio_format(out, DST, in, SRC, SAMPLE_COUNT);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * SAMPLE_COUNT);
+}
+
+template <bool VECTOR>
+static void BM_DownmixToMonoFromStereo(benchmark::State& state) {
+    static float in[FRAME_COUNT * 2];
+    static float out[FRAME_COUNT];
+    fillFloat(in, FRAME_COUNT * 2);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(in);
+        if (VECTOR) {
+            downmixToMonoFromStereo(out, in, FRAME_COUNT);
+        } else {
+            downmix_to_mono_float_from_stereo_float(out, in, FRAME_COUNT);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+}
+
+template <bool VECTOR>
+static void BM_UpmixToStereoFromMono(benchmark::State& state) {
+    static float in[FRAME_COUNT];
+    static float out[FRAME_COUNT * 2];
+    fillFloat(in, FRAME_COUNT);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(in);
+        if (VECTOR) {
+            upmixToStereoFromMono(out, in, FRAME_COUNT);
+        } else {
+            upmix_to_stereo_float_from_mono_float(out, in, FRAME_COUNT);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
+}
+
+// Each scalar audio_utils benchmark is followed by its vectorized counterpart.
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT, false);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT, true);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, false);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, true);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_24_BIT_PACKED, false);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_24_BIT_PACKED, true);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_24_BIT_PACKED, AUDIO_FORMAT_PCM_FLOAT, false);
+BENCHMARK_TEMPLATE(BM_Convert, AUDIO_FORMAT_PCM_24_BIT_PACKED, AUDIO_FORMAT_PCM_FLOAT, true);
+
+BENCHMARK_TEMPLATE(BM_DownmixToMonoFromStereo, false);
+BENCHMARK_TEMPLATE(BM_DownmixToMonoFromStereo, true);
+BENCHMARK_TEMPLATE(BM_UpmixToStereoFromMono, false);
+BENCHMARK_TEMPLATE(BM_UpmixToStereoFromMono, true);
+
+BENCHMARK_MAIN();
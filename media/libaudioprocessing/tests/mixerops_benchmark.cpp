@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <inttypes.h>
 #include <type_traits>
 #include "../../../../system/media/audio_utils/include/audio_utils/primitives.h"
@@ -74,6 +75,67 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Reports the cost of a mix of NTRACKS tracks in CPU cycles per output frame.
+// The cycle count is derived from the elapsed time and the CPU frequency
+// measured by the benchmark library, so it is an estimate on DVFS systems.
+static void setCyclesPerFrame(benchmark::State& state,
+        std::chrono::duration<double> elapsed, size_t frameCount) {
+    const double frames = static_cast<double>(state.iterations()) * frameCount;
+    state.counters["cycles/frame"] =
+            elapsed.count() * benchmark::CPUInfo::Get().cycles_per_second / frames;
+}
+
+// Mixes NTRACKS tracks one pass per track, as volumeMulti is called by
+// the track hooks of AudioMixerBase::process__genericNoResampling.
+template <int MIXTYPE, int NCHAN, int NTRACKS>
+static void BM_VolumeMultiTracks(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    float out[SAMPLE_COUNT]{};
+    static float in[NTRACKS][SAMPLE_COUNT]{};
+    float vol[NTRACKS][2]{};
+
+    const auto start = std::chrono::steady_clock::now();
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        for (int t = 0; t < NTRACKS; ++t) {
+            volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in[t], (float *)nullptr, vol[t], 0.f);
+        }
+        benchmark::ClobberMemory();
+    }
+    setCyclesPerFrame(state, std::chrono::steady_clock::now() - start, FRAME_COUNT);
+}
+
+// Mixes NTRACKS tracks in a single pass with volumeMultiAccumTracks.
+template <int MIXTYPE, int NCHAN, int NTRACKS>
+static void BM_VolumeMultiAccumTracks(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    float out[SAMPLE_COUNT]{};
+    static float in[NTRACKS][SAMPLE_COUNT]{};
+    float vol[NTRACKS][2]{};
+    float chvol[NTRACKS][NCHAN];
+    const float *inp[NTRACKS];
+    const float *chvolp[NTRACKS];
+    for (int t = 0; t < NTRACKS; ++t) {
+        channelVolumes<MIXTYPE, NCHAN>(chvol[t], vol[t]);
+        inp[t] = in[t];
+        chvolp[t] = chvol[t];
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        volumeMultiAccumTracks<NTRACKS, NCHAN>(out, FRAME_COUNT, inp, chvolp);
+        benchmark::ClobberMemory();
+    }
+    setCyclesPerFrame(state, std::chrono::steady_clock::now() - start, FRAME_COUNT);
+}
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -103,4 +165,14 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// Multi-track mixing, per-track passes compared with one accumulating pass.
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracks, MIXTYPE_MULTI_STEREOVOL, 2, 4);
+BENCHMARK_TEMPLATE(BM_VolumeMultiAccumTracks, MIXTYPE_MULTI_STEREOVOL, 2, 4);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracks, MIXTYPE_MULTI_STEREOVOL, 2, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiAccumTracks, MIXTYPE_MULTI_STEREOVOL, 2, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracks, MIXTYPE_MULTI_MONOVOL, 6, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiAccumTracks, MIXTYPE_MULTI_MONOVOL, 6, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiTracks, MIXTYPE_MULTI_STEREOVOL, 8, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMultiAccumTracks, MIXTYPE_MULTI_STEREOVOL, 8, 8);
+
 BENCHMARK_MAIN();
@@ -601,3 +601,39 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same design share one filter bank, which stays alive
+// after its resampler is deleted and is reused when the rate is set again.
+TEST(audioflinger_resampler, sharedfilterbank) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto createResampler = [](unsigned inputFreq) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                2 /* channels */,
+                                48000 /* outputFreq */,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inputFreq);
+        return rdyn;
+    };
+
+    auto first = createResampler(44100);
+    auto second = createResampler(44100);
+    const float *coefs = first->getFilterCoefs();
+    ASSERT_EQ(coefs, second->getFilterCoefs());
+
+    auto other = createResampler(96000);
+    ASSERT_NE(coefs, other->getFilterCoefs());
+
+    // rate change back and forth reuses the cached filter bank.
+    other->setSampleRate(44100);
+    ASSERT_EQ(coefs, other->getFilterCoefs());
+    ASSERT_EQ(first->getStopbandAttenuationDb(), other->getStopbandAttenuationDb());
+
+    first.reset();
+    second.reset();
+    other.reset();
+    auto recreated = createResampler(44100);
+    ASSERT_EQ(coefs, recreated->getFilterCoefs());
+}
@@ -17,6 +17,7 @@
 #define LOG_TAG "DataSource"
 
 
+#include <cutils/properties.h>
 #include <datasource/DataSourceFactory.h>
 #include <datasource/DataURISource.h>
 #include <datasource/HTTPBase.h>
@@ -87,10 +88,25 @@ sp<DataSource> DataSourceFactory::CreateFromURI(
             *contentType = mediaHTTP->getMIMEType();
         }
 
+        // A second connection lets the cache fetch ahead in parallel. Connecting
+        // does not send a request, that only happens once it is read from. The
+        // cache disconnects it along with mediaHTTP, so this also applies when the
+        // caller passes in its own httpSource to be able to disconnect early.
+        sp<HTTPBase> aheadHTTP;
+        if (!disconnectAtHighwatermark
+                && property_get_bool("media.stagefright.cache-fetch-ahead", true)) {
+            aheadHTTP = static_cast<HTTPBase *>(CreateMediaHTTP(httpService).get());
+            if (aheadHTTP != NULL
+                    && aheadHTTP->connect(uri, &nonCacheSpecificHeaders) != OK) {
+                aheadHTTP.clear();
+            }
+        }
+
         source = NuCachedSource2::Create(
                 mediaHTTP,
                 cacheConfig.isEmpty() ? NULL : cacheConfig.string(),
-                disconnectAtHighwatermark);
+                disconnectAtHighwatermark,
+                aheadHTTP);
     } else if (!strncasecmp("data:", uri, 5)) {
         source = DataURISource::Create(uri);
     } else {
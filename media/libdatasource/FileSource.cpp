@@ -27,12 +27,20 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <algorithm>
+
 namespace android {
 
+// Size of the window of the file that the kernel is asked to read ahead
+// when a read falls outside of the previous one.
+static const int64_t kReadAheadSize = 512 * 1024;
+
 FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
+      mReadAheadStart(0),
+      mReadAheadEnd(0),
       mName("<null>") {
 
     if (filename) {
@@ -52,6 +60,8 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
+      mReadAheadStart(0),
+      mReadAheadEnd(0),
       mName("<null>") {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
@@ -105,7 +115,8 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
         return NO_INIT;
     }
 
-    Mutex::Autolock autoLock(mLock);
+    // mLength does not change after construction and readAt_l() reads at an
+    // explicit position, so concurrent reads do not need mLock.
     if (mLength >= 0) {
         if (offset < 0) {
             return UNKNOWN_ERROR;
@@ -122,13 +133,34 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
-    if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
+    if (offset < 0 || offset > INT64_MAX - mOffset) {
         return UNKNOWN_ERROR;
     }
+    readAhead(offset + mOffset, size);
+
+    ssize_t result = pread64(mFd, data, size, offset + mOffset);
+    if (result == -1) {
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
+    }
+    return result;
+}
 
-    return ::read(mFd, data, size);
+void FileSource::readAhead(int64_t position, size_t size) {
+    // Extractors make many small reads around the same position, hint the
+    // kernel once per window instead of once per read.
+    int64_t start = mReadAheadStart.load(std::memory_order_relaxed);
+    int64_t end = mReadAheadEnd.load(std::memory_order_relaxed);
+    if (position >= start && (uint64_t)position + size <= (uint64_t)end) {
+        return;
+    }
+    int64_t readAheadSize = std::max<int64_t>(kReadAheadSize, size);
+    end = position > INT64_MAX - readAheadSize ? INT64_MAX : position + readAheadSize;
+    if (mLength >= 0 && end > mOffset + mLength) {
+        end = mOffset + mLength;
+    }
+    mReadAheadStart.store(position, std::memory_order_relaxed);
+    mReadAheadEnd.store(end, std::memory_order_relaxed);
+    posix_fadvise(mFd, position, end - position, POSIX_FADV_WILLNEED);
 }
 
 status_t FileSource::getSize(off64_t *size) {
@@ -28,6 +28,8 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/MediaErrors.h>
 
+#include <algorithm>
+
 namespace android {
 
 struct PageCache {
@@ -43,6 +45,8 @@ struct PageCache {
     void releasePage(Page *page);
 
     void appendPage(Page *page);
+    // Moves all the pages of other to the end of this cache.
+    void appendPages(PageCache *other);
     size_t releaseFromStart(size_t maxBytes);
 
     size_t totalSize() const {
@@ -112,6 +116,12 @@ void PageCache::appendPage(Page *page) {
     mActivePages.push_back(page);
 }
 
+void PageCache::appendPages(PageCache *other) {
+    mActivePages.splice(mActivePages.end(), other->mActivePages);
+    mTotalSize += other->mTotalSize;
+    other->mTotalSize = 0;
+}
+
 size_t PageCache::releaseFromStart(size_t maxBytes) {
     size_t bytesReleased = 0;
 
@@ -182,12 +192,20 @@ void PageCache::copy(size_t from, void *data, size_t size) {
 NuCachedSource2::NuCachedSource2(
         const sp<DataSource> &source,
         const char *cacheConfig,
-        bool disconnectAtHighwatermark)
+        bool disconnectAtHighwatermark,
+        const sp<DataSource> &aheadSource)
     : mSource(source),
       mReflector(new AHandlerReflector<NuCachedSource2>(this)),
       mLooper(new ALooper),
       mCache(new PageCache(kPageSize)),
       mCacheOffset(0),
+      mAheadSource(aheadSource),
+      mAheadCache(new PageCache(kPageSize)),
+      mAheadOffset(-1),
+      mAheadSize(0),
+      mAheadSourceSize(-1),
+      mAheadGeneration(0),
+      mAheadFailed(false),
       mFinalStatus(OK),
       mLastAccessPos(0),
       mFetching(true),
@@ -212,6 +230,9 @@ NuCachedSource2::NuCachedSource2(
     if (mDisconnectAtHighwatermark) {
         // Makes no sense to disconnect and do keep-alives...
         mKeepAliveIntervalUs = 0;
+
+        // ...or to keep a second connection busy.
+        mAheadSource.clear();
     }
 
     mLooper->setName("NuCachedSource2");
@@ -225,26 +246,50 @@ NuCachedSource2::NuCachedSource2(
     // IMediaHTTPConnection::readAt and therefore call back into JAVA.
     mLooper->start(false /* runOnCallingThread */, true /* canCallJava */);
 
+    if (mAheadSource != NULL) {
+        mAheadReflector = new AHandlerReflector<NuCachedSource2>(this);
+        mAheadLooper = new ALooper;
+        mAheadLooper->setName("NuCachedSource2Ahead");
+        mAheadLooper->registerHandler(mAheadReflector);
+        mAheadLooper->start(false /* runOnCallingThread */, true /* canCallJava */);
+    }
+
     mName = String8::format("NuCachedSource2(%s)", mSource->toString().string());
 }
 
 NuCachedSource2::~NuCachedSource2() {
+    if (mAheadLooper != NULL) {
+        mAheadLooper->stop();
+        mAheadLooper->unregisterHandler(mAheadReflector->id());
+    }
     mLooper->stop();
     mLooper->unregisterHandler(mReflector->id());
 
     delete mCache;
     mCache = NULL;
+
+    delete mAheadCache;
+    mAheadCache = NULL;
+
+    for (const RetainedRange &range : mRetainedRanges) {
+        delete range.mCache;
+    }
+    mRetainedRanges.clear();
 }
 
 // static
 sp<NuCachedSource2> NuCachedSource2::Create(
         const sp<DataSource> &source,
         const char *cacheConfig,
-        bool disconnectAtHighwatermark) {
+        bool disconnectAtHighwatermark,
+        const sp<DataSource> &aheadSource) {
     sp<NuCachedSource2> instance = new NuCachedSource2(
-            source, cacheConfig, disconnectAtHighwatermark);
+            source, cacheConfig, disconnectAtHighwatermark, aheadSource);
     Mutex::Autolock autoLock(instance->mLock);
     (new AMessage(kWhatFetchMore, instance->mReflector))->post();
+    if (instance->mAheadReflector != NULL) {
+        (new AMessage(kWhatFetchAhead, instance->mAheadReflector))->post();
+    }
     return instance;
 }
 
@@ -278,6 +323,9 @@ void NuCachedSource2::disconnect() {
         // explicitly disconnect from the source, to allow any
         // pending reads to return more promptly
         static_cast<HTTPBase *>(mSource.get())->disconnect();
+        if (mAheadSource != NULL) {
+            static_cast<HTTPBase *>(mAheadSource.get())->disconnect();
+        }
     }
 }
 
@@ -311,6 +359,12 @@ void NuCachedSource2::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatFetchAhead:
+        {
+            onFetchAhead();
+            break;
+        }
+
         case kWhatRead:
         {
             onRead(msg);
@@ -326,6 +380,7 @@ void NuCachedSource2::fetchInternal() {
     ALOGV("fetchInternal");
 
     bool reconnect = false;
+    size_t readSize = kPageSize;
 
     {
         Mutex::Autolock autoLock(mLock);
@@ -336,6 +391,16 @@ void NuCachedSource2::fetchInternal() {
 
             reconnect = true;
         }
+
+        // Stop at the range fetched ahead, and take it over once we get there.
+        if (mAheadOffset >= 0) {
+            off64_t position = mCacheOffset + mCache->totalSize();
+            if (position >= mAheadOffset) {
+                mergeAhead_l();
+            } else if (mAheadOffset - position < (off64_t)readSize) {
+                readSize = mAheadOffset - position;
+            }
+        }
     }
 
     if (reconnect) {
@@ -364,7 +429,7 @@ void NuCachedSource2::fetchInternal() {
     PageCache::Page *page = mCache->acquirePage();
 
     ssize_t n = mSource->readAt(
-            mCacheOffset + mCache->totalSize(), page->mData, kPageSize);
+            mCacheOffset + mCache->totalSize(), page->mData, readSize);
 
     Mutex::Autolock autoLock(mLock);
 
@@ -394,6 +459,7 @@ void NuCachedSource2::fetchInternal() {
 
         page->mSize = n;
         mCache->appendPage(page);
+        trimRetained_l();
     }
 }
 
@@ -420,7 +486,12 @@ void NuCachedSource2::onFetch() {
 
         mLastFetchTimeUs = ALooper::GetNowUs();
 
-        if (mFetching && mCache->totalSize() >= mHighwaterThresholdBytes) {
+        bool cacheFull;
+        {
+            Mutex::Autolock autoLock(mLock);
+            cacheFull = mCache->totalSize() + pinnedSize_l() >= mHighwaterThresholdBytes;
+        }
+        if (mFetching && cacheFull) {
             ALOGI("Cache full, done prefetching for now");
             mFetching = false;
 
@@ -451,6 +522,120 @@ void NuCachedSource2::onFetch() {
     (new AMessage(kWhatFetchMore, mReflector))->post(delayUs);
 }
 
+void NuCachedSource2::onFetchAhead() {
+    if (mAheadSourceSize < 0) {
+        // The main connection learns the size from the response to its first read.
+        // Asking either connection before that would cost a request of its own.
+        bool fetched;
+        {
+            Mutex::Autolock autoLock(mLock);
+            if (mDisconnecting || mAheadFailed) {
+                return;
+            }
+            fetched = mCacheOffset > 0 || mCache->totalSize() > 0;
+        }
+        if (!fetched) {
+            (new AMessage(kWhatFetchAhead, mAheadReflector))->post(100000LL);
+            return;
+        }
+        if (mSource->getSize(&mAheadSourceSize) != OK) {
+            ALOGV("unknown size, not fetching ahead");
+            return;
+        }
+    }
+
+    PageCache::Page *page = NULL;
+    off64_t offset = 0;
+    int32_t generation = 0;
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (mDisconnecting || mAheadFailed) {
+            return;
+        }
+        if (startAhead_l()) {
+            offset = mAheadOffset + mAheadCache->totalSize();
+            page = mAheadCache->acquirePage();
+            generation = mAheadGeneration;
+        }
+    }
+
+    int64_t delayUs = 100000LL;
+    if (page != NULL) {
+        ssize_t n = mAheadSource->readAt(offset, page->mData, kPageSize);
+
+        Mutex::Autolock autoLock(mLock);
+        if (generation != mAheadGeneration) {
+            // mCache took over or dropped the range while we were reading.
+            mAheadCache->releasePage(page);
+            delayUs = 0;
+        } else if (n <= 0) {
+            mAheadCache->releasePage(page);
+            if (n < 0) {
+                // Leave the content to the main connection from now on.
+                ALOGW("fetching ahead failed (%zd), stopping", n);
+                mAheadFailed = true;
+                resetAhead_l();
+                return;
+            }
+            mAheadSize = mAheadCache->totalSize();
+        } else {
+            page->mSize = n;
+            mAheadCache->appendPage(page);
+            trimRetained_l();
+            delayUs = 0;
+        }
+    }
+
+    (new AMessage(kWhatFetchAhead, mAheadReflector))->post(delayUs);
+}
+
+// Returns true if there is a range ahead to fetch more data of.
+bool NuCachedSource2::startAhead_l() {
+    if (mAheadOffset >= 0) {
+        return mAheadCache->totalSize() < mAheadSize;
+    }
+    if (!mFetching || mFinalStatus != OK) {
+        return false;
+    }
+
+    // Fetch about as much ahead as the main connection is fetching in the
+    // meantime, one second worth of data at the measured bandwidth.
+    size_t aheadSize = 1024 * 1024;
+    int32_t bandwidthBps;
+    if (static_cast<HTTPBase *>(mSource.get())->estimateBandwidth(&bandwidthBps)) {
+        aheadSize = bandwidthBps / 8;
+    }
+    aheadSize = std::min(std::max(aheadSize, (size_t)kMinAheadSize), (size_t)kMaxAheadSize);
+
+    if (mCache->totalSize() + 2 * aheadSize > mHighwaterThresholdBytes) {
+        return false;
+    }
+    off64_t offset = mCacheOffset + mCache->totalSize() + aheadSize;
+    if (offset + (off64_t)aheadSize > mAheadSourceSize) {
+        return false;
+    }
+
+    ALOGV("fetching ahead %zu bytes at %lld", aheadSize, (long long)offset);
+    mAheadOffset = offset;
+    mAheadSize = aheadSize;
+    return true;
+}
+
+void NuCachedSource2::mergeAhead_l() {
+    if (mAheadOffset == (off64_t)(mCacheOffset + mCache->totalSize())) {
+        ALOGV("merging %zu bytes fetched ahead", mAheadCache->totalSize());
+        mCache->appendPages(mAheadCache);
+    }
+    resetAhead_l();
+}
+
+void NuCachedSource2::resetAhead_l() {
+    ++mAheadGeneration;
+    mAheadCache->releaseFromStart(mAheadCache->totalSize());
+    mAheadOffset = -1;
+    mAheadSize = 0;
+}
+
 void NuCachedSource2::onRead(const sp<AMessage> &msg) {
     ALOGV("onRead");
 
@@ -537,6 +722,10 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         return size;
     }
 
+    if (readRetained_l(offset, data, size)) {
+        return size;
+    }
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -620,6 +809,26 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
                 true); // force
     }
 
+    if (offset < mCacheOffset
+            || offset >= (off64_t)(mCacheOffset + mCache->totalSize())) {
+        auto it = findRetained_l(offset);
+        if (it != mRetainedRanges.end()) {
+            // Continue caching from the end of the range we already have.
+            RetainedRange range = *it;
+            mRetainedRanges.erase(it);
+            retainCache_l();
+
+            ALOGI("resuming range: offset= %lld", (long long)range.mOffset);
+            delete mCache;
+            mCache = range.mCache;
+            mCacheOffset = range.mOffset;
+            resetAhead_l();
+            mLastAccessPos = offset;
+            mNumRetriesLeft = kMaxNumRetries;
+            mFetching = true;
+        }
+    }
+
     if (offset < mCacheOffset
             || offset >= (off64_t)(mCacheOffset + mCache->totalSize())) {
         static const off64_t kPadding = 256 * 1024;
@@ -672,10 +881,9 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
 
     ALOGI("new range: offset= %lld", (long long)offset);
 
+    retainCache_l();
     mCacheOffset = offset;
-
-    size_t totalSize = mCache->totalSize();
-    CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
+    resetAhead_l();
 
     mNumRetriesLeft = kMaxNumRetries;
     mFetching = true;
@@ -683,6 +891,92 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     return OK;
 }
 
+bool NuCachedSource2::readRetained_l(off64_t offset, void *data, size_t size) {
+    auto it = findRetained_l(offset);
+    if (it == mRetainedRanges.end()
+            || offset + size > it->mOffset + it->mCache->totalSize()) {
+        return false;
+    }
+    it->mCache->copy(offset - it->mOffset, data, size);
+    mRetainedRanges.splice(mRetainedRanges.begin(), mRetainedRanges, it);
+    return true;
+}
+
+std::list<NuCachedSource2::RetainedRange>::iterator NuCachedSource2::findRetained_l(
+        off64_t offset) {
+    for (auto it = mRetainedRanges.begin(); it != mRetainedRanges.end(); ++it) {
+        if (offset >= it->mOffset
+                && offset < (off64_t)(it->mOffset + it->mCache->totalSize())) {
+            return it;
+        }
+    }
+    return mRetainedRanges.end();
+}
+
+// Keeps the contents of mCache as a retained range and starts an empty one.
+void NuCachedSource2::retainCache_l() {
+    if (mCache->totalSize() == 0) {
+        return;
+    }
+    RetainedRange range;
+    range.mOffset = mCacheOffset;
+    range.mCache = mCache;
+    range.mPinned = mCacheOffset == 0 || mFinalStatus == ERROR_END_OF_STREAM;
+    mRetainedRanges.push_front(range);
+
+    mCache = new PageCache(kPageSize);
+    trimRetained_l();
+}
+
+void NuCachedSource2::trimRetained_l() {
+    size_t totalSize = mCache->totalSize() + mAheadCache->totalSize();
+    for (auto it = mRetainedRanges.begin(); it != mRetainedRanges.end();) {
+        // Drop the ranges that the current cache has caught up with.
+        if (it->mOffset >= mCacheOffset
+                && it->mOffset + it->mCache->totalSize()
+                        <= mCacheOffset + mCache->totalSize()) {
+            delete it->mCache;
+            it = mRetainedRanges.erase(it);
+            continue;
+        }
+        totalSize += it->mCache->totalSize();
+        ++it;
+    }
+
+    // Evict the least recently used ranges, the pinned ones only once they
+    // take more than their share of the budget.
+    size_t pinnedSize = pinnedSize_l();
+    for (bool pinned : { false, true }) {
+        auto it = mRetainedRanges.end();
+        while (totalSize > mHighwaterThresholdBytes && it != mRetainedRanges.begin()) {
+            if (pinned && pinnedSize <= mHighwaterThresholdBytes / kPinnedShare) {
+                break;
+            }
+            --it;
+            if (it->mPinned != pinned) {
+                continue;
+            }
+            ALOGV("evicting range: offset= %lld", (long long)it->mOffset);
+            totalSize -= it->mCache->totalSize();
+            if (pinned) {
+                pinnedSize -= it->mCache->totalSize();
+            }
+            delete it->mCache;
+            it = mRetainedRanges.erase(it);
+        }
+    }
+}
+
+size_t NuCachedSource2::pinnedSize_l() const {
+    size_t size = 0;
+    for (const RetainedRange &range : mRetainedRanges) {
+        if (range.mPinned) {
+            size += range.mCache->totalSize();
+        }
+    }
+    return size;
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
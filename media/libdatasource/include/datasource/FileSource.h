@@ -20,6 +20,8 @@
 
 #include <stdio.h>
 
+#include <atomic>
+
 #include <media/DataSource.h>
 #include <media/stagefright/MediaErrors.h>
 #include <utils/threads.h>
@@ -56,8 +58,13 @@ protected:
     Mutex mLock;
 
 private:
+    // Window of the file, including mOffset, that was last hinted for read ahead.
+    std::atomic<int64_t> mReadAheadStart;
+    std::atomic<int64_t> mReadAheadEnd;
     String8 mName;
 
+    void readAhead(int64_t position, size_t size);
+
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
 };
@@ -18,6 +18,8 @@
 
 #define NU_CACHED_SOURCE_2_H_
 
+#include <list>
+
 #include <media/DataSource.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
@@ -28,10 +30,13 @@ struct ALooper;
 struct PageCache;
 
 struct NuCachedSource2 : public DataSource {
+    // If aheadSource is not NULL, it is a second connection to the same
+    // content, used to fetch a range ahead of source in parallel.
     static sp<NuCachedSource2> Create(
             const sp<DataSource> &source,
             const char *cacheConfig = NULL,
-            bool disconnectAtHighwatermark = false);
+            bool disconnectAtHighwatermark = false,
+            const sp<DataSource> &aheadSource = NULL);
 
     virtual status_t initCheck() const;
 
@@ -81,13 +86,22 @@ private:
     NuCachedSource2(
             const sp<DataSource> &source,
             const char *cacheConfig,
-            bool disconnectAtHighwatermark);
+            bool disconnectAtHighwatermark,
+            const sp<DataSource> &aheadSource);
 
     enum {
         kPageSize                       = 65536,
         kDefaultHighWaterThreshold      = 20 * 1024 * 1024,
         kDefaultLowWaterThreshold       = 4 * 1024 * 1024,
 
+        // Pinned retained ranges may keep up to this fraction of the
+        // high water threshold.
+        kPinnedShare                    = 4,
+
+        // Bounds of the range fetched ahead on the second connection.
+        kMinAheadSize                   = 512 * 1024,
+        kMaxAheadSize                   = 4 * 1024 * 1024,
+
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
@@ -95,6 +109,7 @@ private:
 
     enum {
         kWhatFetchMore  = 'fetc',
+        kWhatFetchAhead = 'fahd',
         kWhatRead       = 'read',
     };
 
@@ -113,6 +128,31 @@ private:
 
     PageCache *mCache;
     off64_t mCacheOffset;
+
+    // Ranges that were cached before a seek moved the cache elsewhere, most
+    // recently used first. They share mHighwaterThresholdBytes with mCache,
+    // which evicts them as it grows, except for the pinned ones.
+    struct RetainedRange {
+        off64_t mOffset;
+        PageCache *mCache;
+        // The start and the end of the file usually hold the index of the
+        // container, these are evicted last.
+        bool mPinned;
+    };
+    std::list<RetainedRange> mRetainedRanges;
+
+    // The range that mAheadSource fetches on mAheadLooper, starting at
+    // mAheadOffset, or -1 if there is none. mCache takes it over when it
+    // reaches mAheadOffset.
+    sp<DataSource> mAheadSource;
+    sp<AHandlerReflector<NuCachedSource2> > mAheadReflector;
+    sp<ALooper> mAheadLooper;
+    PageCache *mAheadCache;
+    off64_t mAheadOffset;
+    size_t mAheadSize;
+    off64_t mAheadSourceSize;
+    int32_t mAheadGeneration;
+    bool mAheadFailed;
     status_t mFinalStatus;
     off64_t mLastAccessPos;
     sp<AMessage> mAsyncResult;
@@ -132,12 +172,23 @@ private:
 
     void onMessageReceived(const sp<AMessage> &msg);
     void onFetch();
+    void onFetchAhead();
     void onRead(const sp<AMessage> &msg);
 
     void fetchInternal();
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
 
+    bool readRetained_l(off64_t offset, void *data, size_t size);
+    std::list<RetainedRange>::iterator findRetained_l(off64_t offset);
+    void retainCache_l();
+    void trimRetained_l();
+    size_t pinnedSize_l() const;
+
+    bool startAhead_l();
+    void mergeAhead_l();
+    void resetAhead_l();
+
     size_t approxDataRemaining_l(off64_t offset, status_t *finalStatus) const;
 
     void restartPrefetcherIfNecessary_l(
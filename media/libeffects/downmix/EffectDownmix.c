@@ -24,6 +24,14 @@
 
 #include <log/log.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DOWNMIX_USE_NEON
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define DOWNMIX_USE_SSE
+#endif
+
 #include "EffectDownmix.h"
 
 // Do not submit with DOWNMIX_TEST_CHANNEL_INDEX defined, strictly for testing
@@ -166,6 +174,21 @@ static bool Downmix_validChannelMask(uint32_t mask)
     if (!mask) {
         return false;
     }
+#ifdef BUILD_FLOAT
+    // the fold matrix handles any positional layout, see Downmix_computeMatrix()
+    if (audio_channel_mask_get_representation(mask) != AUDIO_CHANNEL_REPRESENTATION_POSITION
+            || (mask & ~AUDIO_CHANNEL_OUT_ALL & ~AUDIO_CHANNEL_HAPTIC_ALL) != 0
+            || (mask & AUDIO_CHANNEL_HAPTIC_ALL) != 0) {
+        ALOGE("Unsupported channels (not positional, or haptic)");
+        return false;
+    }
+    // verify has FL/FR
+    if ((mask & AUDIO_CHANNEL_OUT_STEREO) != AUDIO_CHANNEL_OUT_STEREO) {
+        ALOGE("Front channels must be present");
+        return false;
+    }
+    return true;
+#else
     // check against unsupported channels
     if (mask & kUnsupported) {
         ALOGE("Unsupported channels (top or front left/right of center)");
@@ -191,6 +214,7 @@ static bool Downmix_validChannelMask(uint32_t mask)
         }
     }
     return true;
+#endif
 }
 
 /*----------------------------------------------------------------------------
@@ -438,7 +462,6 @@ static int Downmix_Process(effect_handle_t self,
 
     const bool accumulate =
             (pDwmModule->config.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE);
-    const uint32_t downmixInputChannelMask = pDwmModule->config.inputCfg.channels;
 
     switch(pDownmixer->type) {
 
@@ -463,38 +486,8 @@ static int Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD:
-#ifdef DOWNMIX_ALWAYS_USE_GENERIC_DOWNMIXER
-          // bypass the optimized downmix routines for the common formats
-          if (!Downmix_foldGeneric(
-                  downmixInputChannelMask, pSrc, pDst, numFrames, accumulate)) {
-              ALOGE("Multichannel configuration 0x%" PRIx32 " is not supported",
-                    downmixInputChannelMask);
-              return -EINVAL;
-          }
-          break;
-#endif
-        // optimize for the common formats
-        switch((downmix_input_channel_mask_t)downmixInputChannelMask) {
-        case CHANNEL_MASK_QUAD_BACK:
-        case CHANNEL_MASK_QUAD_SIDE:
-            Downmix_foldFromQuad(pSrc, pDst, numFrames, accumulate);
-            break;
-        case CHANNEL_MASK_5POINT1_BACK:
-        case CHANNEL_MASK_5POINT1_SIDE:
-            Downmix_foldFrom5Point1(pSrc, pDst, numFrames, accumulate);
-            break;
-        case CHANNEL_MASK_7POINT1:
-            Downmix_foldFrom7Point1(pSrc, pDst, numFrames, accumulate);
-            break;
-        default:
-            if (!Downmix_foldGeneric(
-                    downmixInputChannelMask, pSrc, pDst, numFrames, accumulate)) {
-                ALOGE("Multichannel configuration 0x%" PRIx32 " is not supported",
-                      downmixInputChannelMask);
-                return -EINVAL;
-            }
-            break;
-        }
+        // the coefficients for the input channel mask were computed on configuration
+        Downmix_foldMatrix(pDownmixer, pSrc, pDst, numFrames, accumulate);
         break;
 
       default:
@@ -788,6 +781,9 @@ int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pConfig, bo
         pDownmixer->input_channel_count =
                 audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
     }
+#ifdef BUILD_FLOAT
+    Downmix_computeMatrix(pDownmixer, pConfig->inputCfg.channels);
+#endif
 
     Downmix_Reset(pDownmixer, init);
 
@@ -1430,3 +1426,152 @@ bool Downmix_foldGeneric(
     return true;
 }
 #endif
+
+#ifdef BUILD_FLOAT
+/*----------------------------------------------------------------------------
+ * Downmix_computeMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ * compute the coefficients folding each channel of a positional layout into stereo.
+ * Left and right channels go to their side, center and LFE channels to both at -3dB,
+ * top channels are attenuated by a further 3dB; the sum is halved to limit clipping.
+ * These match the coefficients of the Downmix_fold*() functions for their layouts.
+ *
+ * Inputs:
+ *  pDownmixer downmixer whose coefficients are computed
+ *  mask       the channel mask of the input, channels are interleaved in bit order
+ *
+ *----------------------------------------------------------------------------
+ */
+void Downmix_computeMatrix(downmix_object_t *pDownmixer, uint32_t mask) {
+    static const LVM_FLOAT kSide = 0.5f;
+    static const LVM_FLOAT kCenter = 0.5f * MINUS_3_DB_IN_FLOAT;
+    static const LVM_FLOAT kTopSide = 0.5f * MINUS_3_DB_IN_FLOAT;
+    static const LVM_FLOAT kTopCenter = 0.25f;
+
+    size_t index = 0;
+    for (uint32_t remaining = mask;
+            remaining != 0 && index < AUDIO_CHANNEL_COUNT_MAX; remaining &= remaining - 1) {
+        LVM_FLOAT left = 0.f;
+        LVM_FLOAT right = 0.f;
+        switch (remaining & -remaining) {
+        case AUDIO_CHANNEL_OUT_FRONT_LEFT:
+        case AUDIO_CHANNEL_OUT_BACK_LEFT:
+        case AUDIO_CHANNEL_OUT_SIDE_LEFT:
+        case AUDIO_CHANNEL_OUT_FRONT_LEFT_OF_CENTER:
+            left = kSide;
+            break;
+        case AUDIO_CHANNEL_OUT_FRONT_RIGHT:
+        case AUDIO_CHANNEL_OUT_BACK_RIGHT:
+        case AUDIO_CHANNEL_OUT_SIDE_RIGHT:
+        case AUDIO_CHANNEL_OUT_FRONT_RIGHT_OF_CENTER:
+            right = kSide;
+            break;
+        case AUDIO_CHANNEL_OUT_FRONT_CENTER:
+        case AUDIO_CHANNEL_OUT_LOW_FREQUENCY:
+        case AUDIO_CHANNEL_OUT_BACK_CENTER:
+            left = right = kCenter;
+            break;
+        case AUDIO_CHANNEL_OUT_TOP_FRONT_LEFT:
+        case AUDIO_CHANNEL_OUT_TOP_BACK_LEFT:
+        case AUDIO_CHANNEL_OUT_TOP_SIDE_LEFT:
+            left = kTopSide;
+            break;
+        case AUDIO_CHANNEL_OUT_TOP_FRONT_RIGHT:
+        case AUDIO_CHANNEL_OUT_TOP_BACK_RIGHT:
+        case AUDIO_CHANNEL_OUT_TOP_SIDE_RIGHT:
+            right = kTopSide;
+            break;
+        case AUDIO_CHANNEL_OUT_TOP_CENTER:
+        case AUDIO_CHANNEL_OUT_TOP_FRONT_CENTER:
+        case AUDIO_CHANNEL_OUT_TOP_BACK_CENTER:
+            left = right = kTopCenter;
+            break;
+        default: // rejected by Downmix_validChannelMask(), dropped
+            break;
+        }
+        pDownmixer->left_coefs[index] = left;
+        pDownmixer->right_coefs[index] = right;
+        ++index;
+    }
+    for (; index < AUDIO_CHANNEL_COUNT_MAX; ++index) {
+        pDownmixer->left_coefs[index] = 0.f;
+        pDownmixer->right_coefs[index] = 0.f;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Downmix_foldMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ * downmix to stereo a multichannel signal with the coefficients of Downmix_computeMatrix().
+ * Each frame is a dot product of the input channels with the left and right coefficients,
+ * computed 4 channels at a time with NEON or SSE when available.
+ *
+ * Inputs:
+ *  pDownmixer downmixer configured for the input layout
+ *  pSrc       multichannel audio buffer to downmix
+ *  numFrames  the number of multichannel frames to downmix
+ *  accumulate whether to mix (when true) the result of the downmix with the contents of pDst,
+ *               or overwrite pDst (when false)
+ *
+ * Outputs:
+ *  pDst       downmixed stereo audio samples
+ *
+ *----------------------------------------------------------------------------
+ */
+void Downmix_foldMatrix(const downmix_object_t *pDownmixer,
+        const LVM_FLOAT *pSrc, LVM_FLOAT *pDst, size_t numFrames, bool accumulate) {
+    const size_t numChan = pDownmixer->input_channel_count;
+    const LVM_FLOAT *leftCoefs = pDownmixer->left_coefs;
+    const LVM_FLOAT *rightCoefs = pDownmixer->right_coefs;
+
+    while (numFrames) {
+        LVM_FLOAT lt = 0.f;
+        LVM_FLOAT rt = 0.f;
+        size_t i = 0;
+#if defined(DOWNMIX_USE_NEON)
+        float32x4_t accLeft = vdupq_n_f32(0.f);
+        float32x4_t accRight = vdupq_n_f32(0.f);
+        for (; i + 4 <= numChan; i += 4) {
+            const float32x4_t in = vld1q_f32(pSrc + i);
+            accLeft = vmlaq_f32(accLeft, in, vld1q_f32(leftCoefs + i));
+            accRight = vmlaq_f32(accRight, in, vld1q_f32(rightCoefs + i));
+        }
+        const float32x2_t sums = vpadd_f32(
+                vadd_f32(vget_low_f32(accLeft), vget_high_f32(accLeft)),
+                vadd_f32(vget_low_f32(accRight), vget_high_f32(accRight)));
+        lt = vget_lane_f32(sums, 0);
+        rt = vget_lane_f32(sums, 1);
+#elif defined(DOWNMIX_USE_SSE)
+        __m128 accLeft = _mm_setzero_ps();
+        __m128 accRight = _mm_setzero_ps();
+        for (; i + 4 <= numChan; i += 4) {
+            const __m128 in = _mm_loadu_ps(pSrc + i);
+            accLeft = _mm_add_ps(accLeft, _mm_mul_ps(in, _mm_loadu_ps(leftCoefs + i)));
+            accRight = _mm_add_ps(accRight, _mm_mul_ps(in, _mm_loadu_ps(rightCoefs + i)));
+        }
+        // (l0 + l2, l1 + l3, r0 + r2, r1 + r3) then l in lane 0 and r in lane 2
+        const __m128 pairs = _mm_add_ps(
+                _mm_shuffle_ps(accLeft, accRight, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm_shuffle_ps(accLeft, accRight, _MM_SHUFFLE(3, 2, 3, 2)));
+        const __m128 sums = _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(2, 3, 0, 1)));
+        lt = _mm_cvtss_f32(sums);
+        rt = _mm_cvtss_f32(_mm_movehl_ps(sums, sums));
+#endif
+        for (; i < numChan; ++i) {
+            lt += pSrc[i] * leftCoefs[i];
+            rt += pSrc[i] * rightCoefs[i];
+        }
+        if (accumulate) {
+            lt += pDst[0];
+            rt += pDst[1];
+        }
+        pDst[0] = clamp_float(lt);
+        pDst[1] = clamp_float(rt);
+        pSrc += numChan;
+        pDst += 2;
+        numFrames--;
+    }
+}
+#endif
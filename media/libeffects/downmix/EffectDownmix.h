@@ -42,6 +42,12 @@ typedef struct {
     downmix_type_t type;
     bool apply_volume_correction;
     uint8_t input_channel_count;
+#ifdef BUILD_FLOAT
+    // fold coefficients of each input channel into the left and right outputs,
+    // computed by Downmix_Configure() for the input channel mask
+    LVM_FLOAT left_coefs[AUDIO_CHANNEL_COUNT_MAX];
+    LVM_FLOAT right_coefs[AUDIO_CHANNEL_COUNT_MAX];
+#endif
 } downmix_object_t;
 
 
@@ -98,6 +104,9 @@ int Downmix_Reset(downmix_object_t *pDownmixer, bool init);
 int Downmix_setParameter(downmix_object_t *pDownmixer, int32_t param, uint32_t size, void *pValue);
 int Downmix_getParameter(downmix_object_t *pDownmixer, int32_t param, uint32_t *pSize, void *pValue);
 #ifdef BUILD_FLOAT
+void Downmix_computeMatrix(downmix_object_t *pDownmixer, uint32_t mask);
+void Downmix_foldMatrix(const downmix_object_t *pDownmixer,
+        const LVM_FLOAT *pSrc, LVM_FLOAT *pDst, size_t numFrames, bool accumulate);
 void Downmix_foldFromQuad(LVM_FLOAT *pSrc, LVM_FLOAT *pDst, size_t numFrames, bool accumulate);
 void Downmix_foldFrom5Point1(LVM_FLOAT *pSrc, LVM_FLOAT *pDst, size_t numFrames, bool accumulate);
 void Downmix_foldFrom7Point1(LVM_FLOAT *pSrc, LVM_FLOAT *pDst, size_t numFrames, bool accumulate);
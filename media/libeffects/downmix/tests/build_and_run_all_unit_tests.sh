@@ -48,7 +48,7 @@ for fs in ${fs_arr[*]}
 do
     for f_ch in {1..8}
     do
-        for ch_fmt in {0..4}
+        for ch_fmt in {0..6}
         do
             adb shell  LD_LIBRARY_PATH=/vendor/lib64/soundfx \
             $testdir/downmixtest $testdir/sinesweepraw.raw \
@@ -26,7 +26,7 @@
 
 #include "EffectDownmix.h"
 #define FRAME_LENGTH 256
-#define MAX_NUM_CHANNELS 8
+#define MAX_NUM_CHANNELS 12
 
 struct downmix_cntxt_s {
   effect_descriptor_t desc;
@@ -57,6 +57,8 @@ void printUsage() {
   printf("\n         2:AUDIO_CHANNEL_OUT_5POINT1_BACK");
   printf("\n         3:AUDIO_CHANNEL_OUT_QUAD_SIDE");
   printf("\n         4:AUDIO_CHANNEL_OUT_QUAD_BACK");
+  printf("\n         5:AUDIO_CHANNEL_OUT_5POINT1POINT2");
+  printf("\n         6:AUDIO_CHANNEL_OUT_7POINT1POINT4");
   printf("\n");
   printf("\n     -fch:<file_channels> (1 through 8)");
   printf("\n");
@@ -256,6 +258,12 @@ int main(int argc, const char *argv[]) {
         case 4:
           *audioType = AUDIO_CHANNEL_OUT_QUAD_BACK;
           break;
+        case 5:
+          *audioType = AUDIO_CHANNEL_OUT_5POINT1POINT2;
+          break;
+        case 6:
+          *audioType = AUDIO_CHANNEL_OUT_7POINT1POINT4;
+          break;
         default:
           *audioType = AUDIO_CHANNEL_OUT_7POINT1;
           break;
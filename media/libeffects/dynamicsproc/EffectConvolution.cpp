@@ -0,0 +1,711 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "EffectConvolution"
+//#define LOG_NDEBUG 0
+
+#include <stdlib.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <log/log.h>
+
+#include "EffectConvolution.h"
+#include <dsp/DPConvolver.h>
+
+//#define VERY_VERY_VERBOSE_LOGGING
+#ifdef VERY_VERY_VERBOSE_LOGGING
+#define ALOGVV ALOGV
+#else
+#define ALOGVV(a...) do { } while (false)
+#endif
+
+// effect_handle_t interface implementation for convolution effect
+extern const struct effect_interface_s gConvolutionInterface;
+
+// AOSP Convolution UUID: 5c8a0f2e-3b71-4e9d-a64c-1f2e8d7b9a30
+const effect_descriptor_t gConvolutionDescriptor = {
+        {0x2b9e4458, 0x6c1f, 0x4d0e, 0x8f61, {0x7a, 0x4c, 0x3e, 0x0b, 0xd1, 0xa5}}, // type
+        {0x5c8a0f2e, 0x3b71, 0x4e9d, 0xa64c, {0x1f, 0x2e, 0x8d, 0x7b, 0x9a, 0x30}}, // uuid
+        EFFECT_CONTROL_API_VERSION,
+        EFFECT_FLAG_TYPE_INSERT,
+        0, // TODO
+        1,
+        "Convolution",
+        "The Android Open Source Project",
+};
+
+enum convolution_state_e {
+    CONVOLUTION_STATE_UNINITIALIZED,
+    CONVOLUTION_STATE_INITIALIZED,
+    CONVOLUTION_STATE_ACTIVE,
+};
+
+// default block size, about 10 ms at 48 kHz.
+static constexpr int32_t kDefaultBlockSize = 512;
+
+// an impulse response being received in chunks.
+struct PendingImpulseResponse {
+    std::vector<float> samples;
+    size_t fill = 0;
+};
+
+// a complete impulse response, transformed by the worker then swapped in.
+struct ImpulseResponseUpdate {
+    uint32_t generation;
+    size_t channel;
+    size_t blockSize;
+    std::vector<float> samples;
+    dp_fx::DPConvolver::ImpulseResponse prepared;
+};
+
+struct ConvolutionContext {
+    ~ConvolutionContext();
+
+    const struct effect_interface_s *mItfe;
+    effect_config_t mConfig;
+    uint8_t mState;
+
+    dp_fx::DPConvolver mConvolver;
+    int32_t mBlockSize;
+    std::vector<PendingImpulseResponse> mPending; // one per channel
+
+    // Transforming an impulse response takes one FFT per partition, too long for the
+    // command path, which holds the effect lock that process() also needs.
+    // Complete uploads are prepared by mWorker, then swapped in by process(),
+    // which never waits for mLock, or by the next command.
+    std::mutex mLock;
+    std::condition_variable mCond;
+    bool mExiting = false;                          // guarded by mLock
+    uint32_t mGeneration = 0;                       // guarded by mLock, bumped by configure
+    std::deque<ImpulseResponseUpdate> mRequests;    // guarded by mLock, to be prepared
+    std::vector<ImpulseResponseUpdate> mReady;      // guarded by mLock, to be swapped in
+    std::vector<ImpulseResponseUpdate> mRetired;    // guarded by mLock, swapped out
+    std::thread mWorker;
+};
+
+ConvolutionContext::~ConvolutionContext() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExiting = true;
+    }
+    mCond.notify_one();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+// The value offset of an effect parameter is computed by rounding up
+// the parameter size to the next 32 bit alignment.
+static inline uint32_t computeParamVOffset(const effect_param_t *p) {
+    return ((p->psize + sizeof(int32_t) - 1) / sizeof(int32_t)) *
+            sizeof(int32_t);
+}
+
+//
+//--- Local functions (not directly used by effect interface)
+//
+
+static void Convolution_workerLoop(ConvolutionContext *pContext)
+{
+    std::unique_lock<std::mutex> lock(pContext->mLock);
+    for (;;) {
+        pContext->mCond.wait(lock, [pContext] {
+            return pContext->mExiting || !pContext->mRequests.empty()
+                    || !pContext->mRetired.empty();
+        });
+        if (pContext->mExiting) {
+            break;
+        }
+        // the swapped out impulse responses are released here rather than in process().
+        std::vector<ImpulseResponseUpdate> retired;
+        retired.swap(pContext->mRetired);
+        if (pContext->mRequests.empty()) {
+            lock.unlock();
+            retired.clear();
+            lock.lock();
+            continue;
+        }
+        ImpulseResponseUpdate update = std::move(pContext->mRequests.front());
+        pContext->mRequests.pop_front();
+        lock.unlock();
+
+        retired.clear();
+        const size_t length = update.samples.size();
+        const bool ok = dp_fx::DPConvolver::prepareImpulseResponse(update.prepared,
+                update.blockSize, update.samples.data(), length);
+        std::vector<float>().swap(update.samples);
+
+        lock.lock();
+        if (!ok) {
+            ALOGE("%s channel %zu, length %zu failed", __func__, update.channel, length);
+        } else if (update.generation != pContext->mGeneration) {
+            ALOGV("%s channel %zu dropped, configuration changed", __func__, update.channel);
+        } else {
+            pContext->mReady.push_back(std::move(update));
+        }
+    }
+}
+
+// Swaps the prepared impulse responses into the convolver. Without wait, returns
+// at once if the worker holds the lock, and does not allocate.
+static void Convolution_applyImpulseResponses(ConvolutionContext *pContext, bool wait)
+{
+    std::unique_lock<std::mutex> lock(pContext->mLock, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+    if (pContext->mReady.empty() || (!wait && !pContext->mRetired.empty())) {
+        return;
+    }
+    for (auto &update : pContext->mReady) {
+        // cannot fail: configure drops the updates prepared for another configuration.
+        pContext->mConvolver.setImpulseResponse(update.channel, update.prepared);
+    }
+    if (pContext->mRetired.empty()) {
+        pContext->mRetired.swap(pContext->mReady);
+    } else {
+        std::move(pContext->mReady.begin(), pContext->mReady.end(),
+                std::back_inserter(pContext->mRetired));
+        pContext->mReady.clear();
+    }
+    pContext->mCond.notify_one();
+}
+
+static void Convolution_configure(ConvolutionContext *pContext)
+{
+    const size_t channelCount = audio_channel_count_from_out_mask(
+            pContext->mConfig.inputCfg.channels);
+    ALOGV("Convolution_configure(%p) channels %zu, block size %d",
+            pContext, channelCount, pContext->mBlockSize);
+    pContext->mConvolver.configure(channelCount, pContext->mBlockSize);
+    pContext->mPending.clear();
+    pContext->mPending.resize(channelCount);
+
+    std::lock_guard<std::mutex> lock(pContext->mLock);
+    pContext->mGeneration++;
+    pContext->mRequests.clear();
+    pContext->mReady.clear();
+}
+
+void Convolution_reset(ConvolutionContext *pContext)
+{
+    ALOGV("> Convolution_reset(%p)", pContext);
+    pContext->mConvolver.reset();
+}
+
+//----------------------------------------------------------------------------
+// Convolution_setConfig()
+//----------------------------------------------------------------------------
+// Purpose: Set input and output audio configuration.
+//  A change of channel count clears the impulse responses.
+//
+// Inputs:
+//  pContext:   effect engine context
+//  pConfig:    pointer to effect_config_t structure holding input and output
+//      configuration parameters
+//
+// Outputs:
+//
+//----------------------------------------------------------------------------
+
+int Convolution_setConfig(ConvolutionContext *pContext, effect_config_t *pConfig)
+{
+    ALOGV("Convolution_setConfig(%p)", pContext);
+
+    if (pConfig->inputCfg.samplingRate != pConfig->outputCfg.samplingRate) return -EINVAL;
+    if (pConfig->inputCfg.channels != pConfig->outputCfg.channels) return -EINVAL;
+    if (pConfig->inputCfg.format != pConfig->outputCfg.format) return -EINVAL;
+    if (pConfig->outputCfg.accessMode != EFFECT_BUFFER_ACCESS_WRITE &&
+            pConfig->outputCfg.accessMode != EFFECT_BUFFER_ACCESS_ACCUMULATE) return -EINVAL;
+    if (pConfig->inputCfg.format != AUDIO_FORMAT_PCM_FLOAT) return -EINVAL;
+    const size_t channelCount = audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
+    if (channelCount == 0) return -EINVAL;
+
+    pContext->mConfig = *pConfig;
+
+    if (channelCount != pContext->mConvolver.getChannelCount()) {
+        Convolution_configure(pContext);
+    } else {
+        Convolution_reset(pContext);
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Convolution_init()
+//----------------------------------------------------------------------------
+// Purpose: Initialize engine with default configuration.
+//
+// Inputs:
+//  pContext:   effect engine context
+//
+// Outputs:
+//
+//----------------------------------------------------------------------------
+
+int Convolution_init(ConvolutionContext *pContext)
+{
+    ALOGV("Convolution_init(%p)", pContext);
+
+    pContext->mItfe = &gConvolutionInterface;
+    pContext->mState = CONVOLUTION_STATE_UNINITIALIZED;
+    pContext->mBlockSize = kDefaultBlockSize;
+
+    pContext->mConfig.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    pContext->mConfig.inputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+    pContext->mConfig.inputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    pContext->mConfig.inputCfg.samplingRate = 48000;
+    pContext->mConfig.inputCfg.bufferProvider.getBuffer = NULL;
+    pContext->mConfig.inputCfg.bufferProvider.releaseBuffer = NULL;
+    pContext->mConfig.inputCfg.bufferProvider.cookie = NULL;
+    pContext->mConfig.inputCfg.mask = EFFECT_CONFIG_ALL;
+    pContext->mConfig.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_ACCUMULATE;
+    pContext->mConfig.outputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+    pContext->mConfig.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    pContext->mConfig.outputCfg.samplingRate = 48000;
+    pContext->mConfig.outputCfg.bufferProvider.getBuffer = NULL;
+    pContext->mConfig.outputCfg.bufferProvider.releaseBuffer = NULL;
+    pContext->mConfig.outputCfg.bufferProvider.cookie = NULL;
+    pContext->mConfig.outputCfg.mask = EFFECT_CONFIG_ALL;
+
+    Convolution_configure(pContext);
+    Convolution_setConfig(pContext, &pContext->mConfig);
+    if (!pContext->mWorker.joinable()) {
+        pContext->mWorker = std::thread(Convolution_workerLoop, pContext);
+    }
+    pContext->mState = CONVOLUTION_STATE_INITIALIZED;
+    return 0;
+}
+
+//
+//--- Effect Library Interface Implementation
+//
+
+int ConvolutionLib_Release(effect_handle_t handle) {
+    ConvolutionContext * pContext = (ConvolutionContext *)handle;
+
+    ALOGV("ConvolutionLib_Release %p", handle);
+    if (pContext == NULL) {
+        return -EINVAL;
+    }
+    delete pContext;
+
+    return 0;
+}
+
+int ConvolutionLib_Create(const effect_uuid_t *uuid,
+                         int32_t sessionId __unused,
+                         int32_t ioId __unused,
+                         effect_handle_t *pHandle) {
+    ALOGV("ConvolutionLib_Create()");
+
+    if (pHandle == NULL || uuid == NULL) {
+        return -EINVAL;
+    }
+
+    if (memcmp(uuid, &gConvolutionDescriptor.uuid, sizeof(*uuid)) != 0) {
+        return -EINVAL;
+    }
+
+    ConvolutionContext *pContext = new ConvolutionContext;
+    *pHandle = (effect_handle_t)pContext;
+    int ret = Convolution_init(pContext);
+    if (ret < 0) {
+        ALOGW("ConvolutionLib_Create() init failed");
+        ConvolutionLib_Release(*pHandle);
+        return ret;
+    }
+
+    ALOGV("ConvolutionLib_Create context is %p", pContext);
+    return 0;
+}
+
+int ConvolutionLib_GetDescriptor(const effect_uuid_t *uuid,
+                                effect_descriptor_t *pDescriptor) {
+
+    if (pDescriptor == NULL || uuid == NULL){
+        ALOGE("ConvolutionLib_GetDescriptor() called with NULL pointer");
+        return -EINVAL;
+    }
+
+    if (memcmp(uuid, &gConvolutionDescriptor.uuid, sizeof(*uuid)) == 0) {
+        *pDescriptor = gConvolutionDescriptor;
+        return 0;
+    }
+
+    return -EINVAL;
+} /* end ConvolutionLib_GetDescriptor */
+
+//
+//--- Effect Control Interface Implementation
+//
+int Convolution_process(effect_handle_t self, audio_buffer_t *inBuffer,
+        audio_buffer_t *outBuffer) {
+    ConvolutionContext * pContext = (ConvolutionContext *)self;
+
+    if (pContext == NULL) {
+        ALOGE("Convolution_process() called with NULL context");
+        return -EINVAL;
+    }
+
+    if (inBuffer == NULL || inBuffer->raw == NULL ||
+        outBuffer == NULL || outBuffer->raw == NULL ||
+        inBuffer->frameCount != outBuffer->frameCount ||
+        inBuffer->frameCount == 0) {
+        ALOGE("inBuffer or outBuffer are NULL or have problems with frame count");
+        return -EINVAL;
+    }
+    if (pContext->mState != CONVOLUTION_STATE_ACTIVE) {
+        ALOGE("mState is not CONVOLUTION_STATE_ACTIVE. Current mState %d",
+                pContext->mState);
+        return -ENODATA;
+    }
+
+    Convolution_applyImpulseResponses(pContext, false /* wait */);
+    const size_t sampleCount = inBuffer->frameCount * pContext->mConvolver.getChannelCount();
+    pContext->mConvolver.processSamples(inBuffer->f32, inBuffer->f32, sampleCount);
+
+    if (inBuffer->raw != outBuffer->raw) {
+        if (pContext->mConfig.outputCfg.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE) {
+            for (size_t i = 0; i < sampleCount; i++) {
+                outBuffer->f32[i] += inBuffer->f32[i];
+            }
+        } else {
+            memcpy(outBuffer->raw, inBuffer->raw, sampleCount * sizeof(float));
+        }
+    }
+    return 0;
+}
+
+//register expected cmd size
+int Convolution_getParameterCmdSize(uint32_t paramSize,
+        void *pParam) {
+    if (paramSize < sizeof(int32_t)) {
+        return 0;
+    }
+    int32_t param = *(int32_t*)pParam;
+    switch(param) {
+    case CONVOLUTION_PARAM_BLOCK_SIZE:
+        //effect + param
+        return (int)(sizeof(effect_param_t) + sizeof(uint32_t));
+    case CONVOLUTION_PARAM_IMPULSE_RESPONSE:
+        //effect + param + channel
+        return (int)(sizeof(effect_param_t) + 2 * sizeof(uint32_t));
+    }
+    return 0;
+}
+
+int Convolution_getParameter(ConvolutionContext *pContext,
+                           uint32_t paramSize,
+                           void *pParam,
+                           uint32_t *pValueSize,
+                           void *pValue) {
+    int32_t *params = (int32_t *)pParam;
+
+    if (paramSize < sizeof(int32_t) || *pValueSize < sizeof(int32_t)) {
+        ALOGE("%s invalid paramSize: %u or valueSize: %u", __func__, paramSize, *pValueSize);
+        return -EINVAL;
+    }
+    const int32_t command = params[0];
+    switch (command) {
+    case CONVOLUTION_PARAM_BLOCK_SIZE:
+        *(int32_t *)pValue = (int32_t)pContext->mConvolver.getBlockSize();
+        break;
+    case CONVOLUTION_PARAM_IMPULSE_RESPONSE: {
+        if (paramSize < 2 * sizeof(int32_t)) {
+            ALOGE("%s get CONVOLUTION_PARAM_IMPULSE_RESPONSE invalid paramSize %u",
+                    __func__, paramSize);
+            return -EINVAL;
+        }
+        const int32_t channel = params[1];
+        if (channel < 0 || (size_t)channel >= pContext->mConvolver.getChannelCount()) {
+            ALOGE("%s get CONVOLUTION_PARAM_IMPULSE_RESPONSE invalid channel %d",
+                    __func__, channel);
+            return -EINVAL;
+        }
+        Convolution_applyImpulseResponses(pContext, true /* wait */);
+        *(int32_t *)pValue = (int32_t)pContext->mConvolver.getImpulseResponseLength(channel);
+        break;
+    }
+    default:
+        ALOGE("%s invalid param %d", __func__, command);
+        return -EINVAL;
+    }
+    *pValueSize = sizeof(int32_t);
+    ALOGVV("%s param %d value %d", __func__, command, *(int32_t *)pValue);
+    return 0;
+} /* end Convolution_getParameter */
+
+int Convolution_setParameter(ConvolutionContext *pContext,
+                           uint32_t paramSize,
+                           void *pParam,
+                           uint32_t valueSize,
+                           void *pValue) {
+    int32_t *params = (int32_t *)pParam;
+
+    if (paramSize < sizeof(int32_t)) {
+        ALOGE("%s invalid paramSize: %u", __func__, paramSize);
+        return -EINVAL;
+    }
+    const int32_t command = params[0];
+    switch (command) {
+    case CONVOLUTION_PARAM_BLOCK_SIZE: {
+        if (valueSize < sizeof(int32_t)) {
+            ALOGE("%s CONVOLUTION_PARAM_BLOCK_SIZE invalid valueSize %u", __func__, valueSize);
+            return -EINVAL;
+        }
+        const int32_t blockSize = *(int32_t *)pValue;
+        if (blockSize <= 0 || (size_t)blockSize > dp_fx::DPConvolver::getMaxBlockSize()) {
+            ALOGE("%s CONVOLUTION_PARAM_BLOCK_SIZE invalid block size %d", __func__, blockSize);
+            return -EINVAL;
+        }
+        pContext->mBlockSize = blockSize;
+        Convolution_configure(pContext);
+        break;
+    }
+    case CONVOLUTION_PARAM_IMPULSE_RESPONSE: {
+        if (paramSize < 4 * sizeof(int32_t)) {
+            ALOGE("%s CONVOLUTION_PARAM_IMPULSE_RESPONSE invalid paramSize %u",
+                    __func__, paramSize);
+            return -EINVAL;
+        }
+        const int32_t channel = params[1];
+        const int32_t offset = params[2];
+        const int32_t length = params[3];
+        const size_t count = valueSize / sizeof(float);
+        if (channel < 0 || (size_t)channel >= pContext->mPending.size()) {
+            ALOGE("%s CONVOLUTION_PARAM_IMPULSE_RESPONSE invalid channel %d", __func__, channel);
+            return -EINVAL;
+        }
+        if (length < 0 || (size_t)length > dp_fx::DPConvolver::getMaxImpulseResponseLength()
+                || offset < 0 || (size_t)offset + count > (size_t)length) {
+            ALOGE("%s CONVOLUTION_PARAM_IMPULSE_RESPONSE invalid offset %d, count %zu"
+                    " or length %d", __func__, offset, count, length);
+            return -EINVAL;
+        }
+        PendingImpulseResponse &pending = pContext->mPending[channel];
+        if (offset == 0) {
+            // first chunk, restarts any upload in progress.
+            pending.samples.resize(length);
+            pending.fill = 0;
+        } else if ((size_t)offset != pending.fill || (size_t)length != pending.samples.size()) {
+            ALOGE("%s CONVOLUTION_PARAM_IMPULSE_RESPONSE channel %d offset %d out of order,"
+                    " expected %zu", __func__, channel, offset, pending.fill);
+            return -EINVAL;
+        }
+        memcpy(pending.samples.data() + offset, pValue, count * sizeof(float));
+        pending.fill += count;
+        ALOGVV("%s channel %d, %zu of %d samples", __func__, channel, pending.fill, length);
+
+        if (pending.fill == pending.samples.size()) {
+            std::lock_guard<std::mutex> lock(pContext->mLock);
+            pContext->mRequests.push_back({pContext->mGeneration, (size_t)channel,
+                    pContext->mConvolver.getBlockSize(), std::move(pending.samples), {}});
+            pending.samples.clear();
+            pending.fill = 0;
+            pContext->mCond.notify_one();
+        }
+        break;
+    }
+    default:
+        ALOGE("%s invalid param %d", __func__, command);
+        return -EINVAL;
+    }
+    return 0;
+} /* end Convolution_setParameter */
+
+int Convolution_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
+        void *pCmdData, uint32_t *replySize, void *pReplyData) {
+
+    ConvolutionContext * pContext = (ConvolutionContext *)self;
+
+    if (pContext == NULL || pContext->mState == CONVOLUTION_STATE_UNINITIALIZED) {
+        ALOGE("Convolution_command() called with NULL context or uninitialized state.");
+        return -EINVAL;
+    }
+
+    ALOGV("Convolution_command command %d cmdSize %d",cmdCode, cmdSize);
+    switch (cmdCode) {
+    case EFFECT_CMD_INIT:
+        if (pReplyData == NULL || *replySize != sizeof(int)) {
+            ALOGE("EFFECT_CMD_INIT wrong replyData or repySize");
+            return -EINVAL;
+        }
+        *(int *) pReplyData = Convolution_init(pContext);
+        break;
+    case EFFECT_CMD_SET_CONFIG:
+        if (pCmdData == NULL || cmdSize != sizeof(effect_config_t)
+                || pReplyData == NULL || replySize == NULL || *replySize != sizeof(int)) {
+            ALOGE("EFFECT_CMD_SET_CONFIG error with pCmdData, cmdSize, pReplyData or replySize");
+            return -EINVAL;
+        }
+        *(int *) pReplyData = Convolution_setConfig(pContext,
+                (effect_config_t *) pCmdData);
+        break;
+    case EFFECT_CMD_GET_CONFIG:
+        if (pReplyData == NULL ||
+            *replySize != sizeof(effect_config_t)) {
+            ALOGE("EFFECT_CMD_GET_CONFIG wrong replyData or repySize");
+            return -EINVAL;
+        }
+        *(effect_config_t *)pReplyData = pContext->mConfig;
+        break;
+    case EFFECT_CMD_RESET:
+        Convolution_reset(pContext);
+        break;
+    case EFFECT_CMD_ENABLE:
+        if (pReplyData == NULL || replySize == NULL || *replySize != sizeof(int)) {
+            ALOGE("EFFECT_CMD_ENABLE wrong replyData or repySize");
+            return -EINVAL;
+        }
+        if (pContext->mState != CONVOLUTION_STATE_INITIALIZED) {
+            ALOGE("EFFECT_CMD_ENABLE state not initialized");
+            *(int *)pReplyData = -ENOSYS;
+        } else {
+            pContext->mState = CONVOLUTION_STATE_ACTIVE;
+            ALOGV("EFFECT_CMD_ENABLE() OK");
+            *(int *)pReplyData = 0;
+        }
+        break;
+    case EFFECT_CMD_DISABLE:
+        if (pReplyData == NULL || replySize == NULL || *replySize != sizeof(int)) {
+            ALOGE("EFFECT_CMD_DISABLE wrong replyData or repySize");
+            return -EINVAL;
+        }
+        if (pContext->mState != CONVOLUTION_STATE_ACTIVE) {
+            ALOGE("EFFECT_CMD_DISABLE state not active");
+            *(int *)pReplyData = -ENOSYS;
+        } else {
+            pContext->mState = CONVOLUTION_STATE_INITIALIZED;
+            ALOGV("EFFECT_CMD_DISABLE() OK");
+            *(int *)pReplyData = 0;
+        }
+        break;
+    case EFFECT_CMD_GET_PARAM: {
+        if (pCmdData == NULL || pReplyData == NULL || replySize == NULL) {
+            ALOGE("null pCmdData or pReplyData or replySize");
+            return -EINVAL;
+        }
+        effect_param_t *pEffectParam = (effect_param_t *) pCmdData;
+        uint32_t expectedCmdSize = Convolution_getParameterCmdSize(pEffectParam->psize,
+                pEffectParam->data);
+        if (expectedCmdSize == 0 || cmdSize != expectedCmdSize
+                || *replySize < expectedCmdSize + sizeof(int32_t)) {
+            ALOGE("error cmdSize: %d, expetedCmdSize: %d, replySize: %d",
+                    cmdSize, expectedCmdSize, *replySize);
+            return -EINVAL;
+        }
+
+        memcpy(pReplyData, pCmdData, expectedCmdSize);
+        effect_param_t *p = (effect_param_t *)pReplyData;
+
+        uint32_t voffset = computeParamVOffset(p);
+
+        p->vsize = sizeof(int32_t);
+        p->status = Convolution_getParameter(pContext,
+                p->psize,
+                p->data,
+                &p->vsize,
+                p->data + voffset);
+        *replySize = sizeof(effect_param_t) + voffset + p->vsize;
+        break;
+    }
+    case EFFECT_CMD_SET_PARAM: {
+        if (pCmdData == NULL ||
+                cmdSize < (sizeof(effect_param_t) + sizeof(int32_t) + sizeof(int32_t)) ||
+                pReplyData == NULL || replySize == NULL || *replySize != sizeof(int32_t)) {
+            ALOGE("Convolution EFFECT_CMD_SET_PARAM: ERROR");
+            return -EINVAL;
+        }
+
+        effect_param_t * const p = (effect_param_t *) pCmdData;
+        const uint32_t voffset = computeParamVOffset(p);
+        if (voffset > cmdSize - sizeof(effect_param_t)
+                || p->vsize > cmdSize - sizeof(effect_param_t) - voffset) {
+            ALOGE("Convolution EFFECT_CMD_SET_PARAM: psize %u or vsize %u exceed cmdSize %u",
+                    p->psize, p->vsize, cmdSize);
+            return -EINVAL;
+        }
+
+        *(int *)pReplyData = Convolution_setParameter(pContext,
+                p->psize,
+                (void *)p->data,
+                p->vsize,
+                p->data + voffset);
+        break;
+    }
+    case EFFECT_CMD_SET_DEVICE:
+    case EFFECT_CMD_SET_VOLUME:
+    case EFFECT_CMD_SET_AUDIO_MODE:
+        break;
+
+    default:
+        ALOGW("Convolution_command invalid command %d",cmdCode);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+/* Effect Control Interface Implementation: get_descriptor */
+int Convolution_getDescriptor(effect_handle_t self,
+        effect_descriptor_t *pDescriptor)
+{
+    ConvolutionContext * pContext = (ConvolutionContext *) self;
+
+    if (pContext == NULL || pDescriptor == NULL) {
+        ALOGE("Convolution_getDescriptor() invalid param");
+        return -EINVAL;
+    }
+
+    *pDescriptor = gConvolutionDescriptor;
+
+    return 0;
+} /* end Convolution_getDescriptor */
+
+
+// effect_handle_t interface implementation for convolution effect
+const struct effect_interface_s gConvolutionInterface = {
+        Convolution_process,
+        Convolution_command,
+        Convolution_getDescriptor,
+        NULL,
+};
+
+extern "C" {
+// This is the only symbol that needs to be exported
+__attribute__ ((visibility ("default")))
+audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM = {
+    .tag = AUDIO_EFFECT_LIBRARY_TAG,
+    .version = EFFECT_LIBRARY_API_VERSION,
+    .name = "Convolution Library",
+    .implementor = "The Android Open Source Project",
+    .create_effect = ConvolutionLib_Create,
+    .release_effect = ConvolutionLib_Release,
+    .get_descriptor = ConvolutionLib_GetDescriptor,
+};
+
+}; // extern "C"
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECTCONVOLUTION_H_
+#define ANDROID_EFFECTCONVOLUTION_H_
+
+#include <hardware/audio_effect.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+// Convolution effect type UUID: 2b9e4458-6c1f-4d0e-8f61-7a4c3e0bd1a5
+static const effect_uuid_t FX_IID_CONVOLUTION_ =
+        {0x2b9e4458, 0x6c1f, 0x4d0e, 0x8f61, {0x7a, 0x4c, 0x3e, 0x0b, 0xd1, 0xa5}};
+const effect_uuid_t * const FX_IID_CONVOLUTION = &FX_IID_CONVOLUTION_;
+
+/* enumerated parameter settings for the convolution effect */
+typedef enum
+{
+    // int32_t block size in frames, rounded up to a power of 2, which is also the latency.
+    // Setting it clears all impulse responses.
+    CONVOLUTION_PARAM_BLOCK_SIZE = 0,
+    // Impulse response of one channel, which may be sent in several consecutive chunks.
+    // set: param int32_t[4] {CONVOLUTION_PARAM_IMPULSE_RESPONSE, channel, offset, length},
+    //      value float[count], samples [offset, offset + count) of a response of length samples.
+    //      Once its last sample is set, the response is transformed in the background and
+    //      used from a following process() call; length 0 restores pass through.
+    // get: param int32_t[2] {CONVOLUTION_PARAM_IMPULSE_RESPONSE, channel},
+    //      value int32_t, the length of the response in use.
+    CONVOLUTION_PARAM_IMPULSE_RESPONSE = 1,
+} t_convolution_params;
+
+#if __cplusplus
+}  // extern "C"
+#endif
+
+#endif /*ANDROID_EFFECTCONVOLUTION_H_*/
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DPConvolver"
+//#define LOG_NDEBUG 0
+
+#include <log/log.h>
+#include "DPConvolver.h"
+#include <algorithm>
+#include <sys/param.h>
+
+namespace dp_fx {
+
+#define MAX_BLOCKSIZE 8192 //For this implementation
+#define MIN_BLOCKSIZE 32
+#define MAX_IMPULSE_RESPONSE_LENGTH (1 << 19) //about 10 s at 48 kHz
+
+size_t DPConvolver::getMinBlockSize() {
+    return MIN_BLOCKSIZE;
+}
+
+size_t DPConvolver::getMaxBlockSize() {
+    return MAX_BLOCKSIZE;
+}
+
+size_t DPConvolver::getMaxImpulseResponseLength() {
+    return MAX_IMPULSE_RESPONSE_LENGTH;
+}
+
+void DPConvolver::configure(size_t channelCount, size_t blockSize) {
+    ALOGV("configure channels %zu, blockSize %zu", channelCount, blockSize);
+    mBlockSize = blockSize;
+    if (mBlockSize > MAX_BLOCKSIZE) {
+        mBlockSize = MAX_BLOCKSIZE;
+    } else if (mBlockSize < MIN_BLOCKSIZE) {
+        mBlockSize = MIN_BLOCKSIZE;
+    } else if (!powerof2(mBlockSize)) {
+        //find next highest power of 2.
+        mBlockSize = 1 << (32 - __builtin_clz(mBlockSize));
+    }
+    mFftSize = 2 * mBlockSize;
+
+    // real input: only keep bins 0 to N (Nyquist), the rest are conjugates.
+    mFftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+
+    mChannels.clear();
+    mChannels.resize(channelCount);
+    for (auto &cs : mChannels) {
+        cs.input.assign(mFftSize, 0.f);
+        cs.output.assign(mBlockSize, 0.f);
+    }
+    mTimeTemp.resize(mFftSize);
+    mSpectrumTemp.resize(mBlockSize + 1);
+    mBlockFill = 0;
+}
+
+bool DPConvolver::prepareImpulseResponse(ImpulseResponse &prepared, size_t blockSize,
+        const float *ir, size_t length) {
+    if (blockSize < MIN_BLOCKSIZE || blockSize > MAX_BLOCKSIZE || !powerof2(blockSize)
+            || length > MAX_IMPULSE_RESPONSE_LENGTH || (length > 0 && ir == nullptr)) {
+        ALOGE("prepareImpulseResponse invalid block size %zu or length %zu",
+                blockSize, length);
+        return false;
+    }
+    const size_t fftSize = 2 * blockSize;
+    const size_t partitions = (length + blockSize - 1) / blockSize;
+    prepared.blockSize = blockSize;
+    prepared.length = length;
+    prepared.spectra.resize(partitions);
+    prepared.delayLine.assign(partitions, Eigen::VectorXcf::Zero(blockSize + 1));
+
+    // own FFT and temporary: the convolver may be processing meanwhile.
+    Eigen::FFT<float> fftServer;
+    fftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    Eigen::VectorXf timeTemp(fftSize);
+
+    // each partition is zero padded to the FFT size: the second half of every
+    // circular convolution is then linear, see processBlock().
+    for (size_t p = 0; p < partitions; p++) {
+        const size_t start = p * blockSize;
+        const size_t count = std::min(blockSize, length - start);
+        timeTemp.setZero();
+        std::copy(ir + start, ir + start + count, timeTemp.data());
+        fftServer.fwd(prepared.spectra[p], timeTemp);
+    }
+    ALOGV("prepareImpulseResponse length %zu, %zu partitions", length, partitions);
+    return true;
+}
+
+bool DPConvolver::setImpulseResponse(size_t channel, ImpulseResponse &prepared) {
+    if (channel >= mChannels.size() || prepared.blockSize != mBlockSize) {
+        ALOGE("setImpulseResponse invalid channel %zu or block size %zu",
+                channel, prepared.blockSize);
+        return false;
+    }
+    ChannelState &cs = mChannels[channel];
+    std::swap(cs.ir, prepared);
+    cs.delayLineHead = 0;
+    ALOGV("setImpulseResponse channel %zu, length %zu", channel, cs.ir.length);
+    return true;
+}
+
+bool DPConvolver::setImpulseResponse(size_t channel, const float *ir, size_t length) {
+    if (channel >= mChannels.size()) {
+        ALOGE("setImpulseResponse invalid channel %zu", channel);
+        return false;
+    }
+    ImpulseResponse prepared;
+    return prepareImpulseResponse(prepared, mBlockSize, ir, length)
+            && setImpulseResponse(channel, prepared);
+}
+
+size_t DPConvolver::getImpulseResponseLength(size_t channel) const {
+    return channel < mChannels.size() ? mChannels[channel].ir.length : 0;
+}
+
+void DPConvolver::reset() {
+    for (auto &cs : mChannels) {
+        std::fill(cs.input.begin(), cs.input.end(), 0.f);
+        std::fill(cs.output.begin(), cs.output.end(), 0.f);
+        for (auto &spectrum : cs.ir.delayLine) {
+            spectrum.setZero();
+        }
+        cs.delayLineHead = 0;
+    }
+    mBlockFill = 0;
+}
+
+size_t DPConvolver::processSamples(const float *in, float *out, size_t samples) {
+    const size_t channelCount = mChannels.size();
+    if (channelCount == 0) {
+        return 0;
+    }
+    const size_t frames = samples / channelCount;
+    size_t frame = 0;
+    while (frame < frames) {
+        // exchange samples up to the end of the current block.
+        const size_t count = std::min(frames - frame, mBlockSize - mBlockFill);
+        for (size_t ch = 0; ch < channelCount; ch++) {
+            ChannelState &cs = mChannels[ch];
+            const float *pIn = in + frame * channelCount + ch;
+            float *pOut = out + frame * channelCount + ch;
+            float *blockIn = &cs.input[mBlockSize + mBlockFill];
+            const float *blockOut = &cs.output[mBlockFill];
+            for (size_t k = 0; k < count; k++) {
+                const float sample = *pIn; // read before write for in place processing
+                *pOut = blockOut[k];
+                blockIn[k] = sample;
+                pIn += channelCount;
+                pOut += channelCount;
+            }
+        }
+        mBlockFill += count;
+        frame += count;
+        if (mBlockFill == mBlockSize) {
+            for (auto &cs : mChannels) {
+                processBlock(cs);
+            }
+            mBlockFill = 0;
+        }
+    }
+    return frames * channelCount;
+}
+
+void DPConvolver::processBlock(ChannelState &cs) {
+    if (cs.ir.spectra.empty()) {
+        // pass through, with the same latency.
+        std::copy(cs.input.begin() + mBlockSize, cs.input.end(), cs.output.begin());
+    } else {
+        //##fft of previous + current block, as the newest delay line entry
+        const size_t partitions = cs.ir.spectra.size();
+        cs.delayLineHead = (cs.delayLineHead + 1) % partitions;
+        Eigen::Map<Eigen::VectorXf> eInput(cs.input.data(), mFftSize);
+        mFftServer.fwd(cs.ir.delayLine[cs.delayLineHead], eInput);
+
+        //##sum of the partition products, the input of partition p blocks ago
+        //  meets the p-th partition of the impulse response.
+        mSpectrumTemp.setZero();
+        size_t index = cs.delayLineHead;
+        for (size_t p = 0; p < partitions; p++) {
+            mSpectrumTemp.array() += cs.ir.spectra[p].array() * cs.ir.delayLine[index].array();
+            index = (index == 0) ? partitions - 1 : index - 1;
+        }
+
+        //##ifft, only the second half is free of circular aliasing.
+        mFftServer.inv(mTimeTemp, mSpectrumTemp, mFftSize);
+        std::copy(mTimeTemp.data() + mBlockSize, mTimeTemp.data() + mFftSize,
+                cs.output.begin());
+    }
+    // the current block becomes the previous one.
+    std::copy(cs.input.begin() + mBlockSize, cs.input.end(), cs.input.begin());
+}
+
+} //namespace dp_fx
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DPCONVOLVER_H_
+#define DPCONVOLVER_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
+
+#include "RDsp.h"
+
+namespace dp_fx {
+
+// Uniformly partitioned overlap-save convolution of each channel with its own
+// impulse response.
+//
+// The impulse response is split into partitions of the block size N, each
+// transformed once with a 2N point FFT. Every input block is transformed once and
+// kept in a frequency domain delay line; the output block is the inverse FFT of the
+// sum of the delay line spectra multiplied by the partition spectra. The cost per
+// sample is then two FFTs of 2N points plus one complex multiply-add per partition
+// and bin, instead of one multiply-add per impulse response tap.
+//
+// Processing has a latency of N frames. A channel without an impulse response
+// is passed through with the same latency.
+class DPConvolver {
+public:
+    // Sets the channel count and block size (rounded up to a power of 2
+    // within [getMinBlockSize(), getMaxBlockSize()]), and clears all impulse responses.
+    void configure(size_t channelCount, size_t blockSize);
+
+    // The partition spectra of an impulse response, for one block size.
+    struct ImpulseResponse {
+        size_t blockSize = 0;
+        size_t length = 0;
+        std::vector<Eigen::VectorXcf> spectra;    // one per partition
+        std::vector<Eigen::VectorXcf> delayLine;  // zeroed, as many as partitions
+    };
+
+    // Transforms an impulse response for a block size as returned by getBlockSize(),
+    // length 0 restores pass through. Uses no convolver state, so it may run on
+    // another thread while the convolver is processing.
+    // Returns false if the block size or length is invalid.
+    static bool prepareImpulseResponse(ImpulseResponse &prepared, size_t blockSize,
+            const float *ir, size_t length);
+
+    // Swaps a prepared impulse response into a channel, without allocating or
+    // transforming anything. On success prepared holds the previous impulse response
+    // of the channel, to be released by the caller.
+    // Returns false if the channel is invalid or the block size does not match.
+    bool setImpulseResponse(size_t channel, ImpulseResponse &prepared);
+
+    // Prepares and sets the impulse response of a channel in one call.
+    bool setImpulseResponse(size_t channel, const float *ir, size_t length);
+    size_t getImpulseResponseLength(size_t channel) const;
+
+    // Processes interleaved samples, in may be equal to out.
+    size_t processSamples(const float *in, float *out, size_t samples);
+
+    // Clears the signal history, keeps the impulse responses.
+    void reset();
+
+    size_t getChannelCount() const { return mChannels.size(); }
+    size_t getBlockSize() const { return mBlockSize; }
+    size_t getLatency() const { return mBlockSize; }
+
+    static size_t getMinBlockSize();
+    static size_t getMaxBlockSize();
+    static size_t getMaxImpulseResponseLength();
+
+private:
+    struct ChannelState {
+        ImpulseResponse ir;         // partition spectra and input spectra delay line
+        size_t delayLineHead = 0;   // index of the newest input spectrum
+        FloatVec input;             // previous and current input blocks, 2N
+        FloatVec output;            // current output block, N
+    };
+
+    void processBlock(ChannelState &cs);
+
+    size_t mBlockSize = 0;
+    size_t mFftSize = 0;
+    size_t mBlockFill = 0;  // frames of the current block already exchanged
+
+    std::vector<ChannelState> mChannels;
+
+    // temporaries
+    Eigen::VectorXf mTimeTemp;
+    Eigen::VectorXcf mSpectrumTemp;
+    Eigen::FFT<float> mFftServer;
+};
+
+} //namespace dp_fx
+
+#endif  // DPCONVOLVER_H_
@@ -92,6 +92,8 @@ void ChannelBuffer::computeBinStartStop(BandParams &bp, size_t binStart) {
 
     bp.binStart = binStart;
     bp.binStop = (int)(0.5 + bp.freqCutoffHz * mBlockSize / mSamplingRate);
+    //only the half spectrum is kept, up to Nyquist.
+    bp.binStop = std::min(bp.binStop, (size_t)mBlockSize / 2);
 }
 
 //== LinkedLimiters Helper
@@ -152,6 +154,11 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     mHalfFFTSize = 1 + mBlockSize / 2; //including Nyquist bin
     mOverlapSize = std::min(overlapSize, mBlockSize/2);
 
+    //real input: only bins 0 to Nyquist are computed and processed, the rest
+    //are their conjugates.
+    mFftServer.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+    mWindowedTemp.resize(mBlockSize);
+
     int channelcount = getChannelCount();
     mSamplingRate = samplingRate;
     mChannelBuffers.resize(channelcount);
@@ -386,10 +393,9 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**separate into channels
-       for (size_t k = 0; k < samples; k += channelCount) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               mChannelBuffers[ch].cBInput.write(*pIn++);
-           }
+       const size_t frames = samples / channelCount;
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBInput.write(pIn + ch, frames, channelCount);
        }
 
        //**process all channelBuffers
@@ -402,8 +408,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //** make sure to output just what the buffer can handle
-       if (available > samples/channelCount) {
-           available = samples/channelCount;
+       if (available > frames) {
+           available = frames;
        }
 
        //**Prepend zeroes if necessary
@@ -413,10 +419,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**interleave channels
-       for (size_t k = 0; k < available; k++) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               *pOut++ = mChannelBuffers[ch].cBOutput.read();
-           }
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBOutput.read(pOut + ch, available, channelCount);
        }
 
        return samples;
@@ -442,9 +446,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
                     pCb->input.begin());
 
             //read new available data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->input[mOverlapSize + k] = pCb->cBInput.read();
-            }
+            pCb->cBInput.read(&pCb->input[mOverlapSize], processFrames);
             //first stages: fft, preEq, mbc, postEq and start of Limiter
             processedSamples += processFirstStages(*pCb);
         }
@@ -466,9 +468,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             }
 
             //output data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->cBOutput.write(pCb->output[k]);
-            }
+            pCb->cBOutput.write(&pCb->output[0], processFrames);
         }
         available -= processFrames;
     }
@@ -480,21 +480,21 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
     Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
 
-    Eigen::VectorXf eWin = eInput.cwiseProduct(eWindow); //apply window
+    mWindowedTemp = eInput.cwiseProduct(eWindow); //apply window
 
     //##fft
     //Note: we are using eigen with the default scaling, which ensures that
     //  IFFT( FFT(x) ) = x.
     // TODO: optimize by using the noscale option, and compensate with dB scale offsets
-    mFftServer.fwd(cb.complexTemp, eWin);
+    mFftServer.fwd(cb.complexTemp, mWindowedTemp);
 
-    size_t cSize = cb.complexTemp.size();
-    size_t maxBin = std::min(cSize/2, mHalfFFTSize);
+    //The stages below are written as Eigen array expressions over contiguous bins,
+    //which Eigen vectorizes (NEON, SSE) for complex by real products and norms.
+    const size_t maxBin = getProcessedBinCount();
 
     //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
-    }
+    Eigen::Map<Eigen::ArrayXf> ePreEq(&cb.mPreEqFactorVector[0], maxBin);
+    cb.complexTemp.head(maxBin).array() *= ePreEq;
 
     //== MBC
     if (cb.mMbcInUse && cb.mMbcEnabled) {
@@ -506,8 +506,10 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
             float preGainSquared = preGainFactor * preGainFactor;
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
+            const size_t binCount = getBinCount(*pMbcBandParams);
+            if (binCount > 0) {
+                fEnergySum = cb.complexTemp.segment(pMbcBandParams->binStart,
+                        binCount).squaredNorm() * preGainSquared; //mag squared
             }
 
             //Eigen FFT is full spectrum, even if the source was real data.
@@ -517,7 +519,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             // in here, the fEnergySum is duplicated to account for the second half spectrum,
             // and the windowRms is used to normalize by the expected energy reduction
             // caused by the window used (expected for steady state signals)
-            fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
+            fEnergySum = std::sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
 
             // updates computed per frame advance.
             float fTheta = 0.0;
@@ -525,12 +527,12 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             float fFRelSec = pMbcBandParams->releaseTimeMs / 1000; //in seconds
 
             if (fEnergySum > pMbcBandParams->previousEnvelope) {
-                fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+                fTheta = std::exp(-1.0f / (fFAttSec * mBlocksPerSecond));
             } else {
-                fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+                fTheta = std::exp(-1.0f / (fFRelSec * mBlocksPerSecond));
             }
 
-            float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
+            float fEnv = (1.0f - fTheta) * fEnergySum + fTheta * pMbcBandParams->previousEnvelope;
             //preserve for next iteration
             pMbcBandParams->previousEnvelope = fEnv;
 
@@ -567,8 +569,8 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
 
             //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
+            if (binCount > 0) {
+                cb.complexTemp.segment(pMbcBandParams->binStart, binCount) *= newFactor;
             }
 
         } //end per band process
@@ -577,31 +579,27 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //== EqPost
     if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
-        }
+        Eigen::Map<Eigen::ArrayXf> ePostEq(&cb.mPostEqFactorVector[0], maxBin);
+        cb.complexTemp.head(maxBin).array() *= ePostEq;
     }
 
     //== Limiter. First Pass
     if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+        float fEnergySum = cb.complexTemp.head(maxBin).squaredNorm();
 
         //see explanation above for energy computation logic
-        fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
+        fEnergySum = std::sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
         float fTheta = 0.0;
         float fFAttSec = cb.mLimiterParams.attackTimeMs / 1000; //in seconds
         float fFRelSec = cb.mLimiterParams.releaseTimeMs / 1000; //in seconds
 
         if (fEnergySum > cb.mLimiterParams.previousEnvelope) {
-            fTheta = exp(-1.0 / (fFAttSec * mBlocksPerSecond));
+            fTheta = std::exp(-1.0f / (fFAttSec * mBlocksPerSecond));
         } else {
-            fTheta = exp(-1.0 / (fFRelSec * mBlocksPerSecond));
+            fTheta = std::exp(-1.0f / (fFRelSec * mBlocksPerSecond));
         }
 
-        float fEnv = (1.0 - fTheta) * fEnergySum + fTheta * cb.mLimiterParams.previousEnvelope;
+        float fEnv = (1.0f - fTheta) * fEnergySum + fTheta * cb.mLimiterParams.previousEnvelope;
         //preserve for next iteration
         cb.mLimiterParams.previousEnvelope = fEnv;
 
@@ -656,20 +654,16 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
 
     //apply to all if != 1.0
     if (!compareEquality(outputGainFactor, 1.0f)) {
-        size_t cSize = cb.complexTemp.size();
-        size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= outputGainFactor;
-        }
+        cb.complexTemp.head(getProcessedBinCount()) *= outputGainFactor;
     }
 
     //##ifft directly to output.
     Eigen::Map<Eigen::VectorXf> eOutput(&cb.output[0], cb.output.size());
-    mFftServer.inv(eOutput, cb.complexTemp);
+    mFftServer.inv(eOutput, cb.complexTemp, mBlockSize);
 
     //apply rest of window for resynthesis
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    eOutput = eOutput.cwiseProduct(eWindow);
+    eOutput.array() *= eWindow.array();
 
     return mBlockSize;
 }
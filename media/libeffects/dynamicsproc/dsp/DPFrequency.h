@@ -138,6 +138,14 @@ private:
     size_t processLastStages(ChannelBuffer &cb);
     void processLinkedLimiters(CBufferVector &channelBuffers);
 
+    //bins below Nyquist, to which the gain stages are applied.
+    size_t getProcessedBinCount() const {
+        return mHalfFFTSize - 1;
+    }
+    static size_t getBinCount(const ChannelBuffer::BandParams &bp) {
+        return bp.binStop >= bp.binStart ? bp.binStop - bp.binStart + 1 : 0;
+    }
+
     size_t mBlockSize;
     size_t mHalfFFTSize;
     size_t mOverlapSize;
@@ -152,6 +160,7 @@ private:
     //dsp
     FloatVec mVWindow;  //window class.
     float mWindowRms;
+    Eigen::VectorXf mWindowedTemp; //windowed input block
     Eigen::FFT<float> mFftServer;
 };
 
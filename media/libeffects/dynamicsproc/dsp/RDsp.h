@@ -17,6 +17,7 @@
 #ifndef RDSP_H
 #define RDSP_H
 
+#include <cmath>
 #include <complex>
 #include <log/log.h>
 #include <vector>
@@ -28,14 +29,15 @@ using ComplexVec  = std::vector<std::complex<float>>;
 // =======
 // Helper Functions
 // =======
+// Evaluated in the precision of T, float arguments use the single precision functions.
 template <class T>
 static T dBtoLinear(T valueDb) {
-    return pow (10, valueDb / 20.0);
+    return std::pow((T)10, valueDb / (T)20);
 }
 
 template <class T>
 static T linearToDb(T value) {
-    return 20 * log10(value);
+    return (T)20 * std::log10(value);
 }
 
 // =======
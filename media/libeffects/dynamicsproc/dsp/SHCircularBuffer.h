@@ -17,6 +17,7 @@
 #ifndef SHCIRCULARBUFFER_H
 #define SHCIRCULARBUFFER_H
 
+#include <algorithm>
 #include <log/log.h>
 #include <vector>
 
@@ -60,6 +61,54 @@ public:
         }
         return value;
     }
+    // Writes count values taken every stride elements of src, e.g. one channel
+    // of interleaved data. Returns the number of values written.
+    size_t write(const T *src, size_t count, size_t stride = 1) {
+        if (count > availableToWrite()) {
+            ALOGE("Error: SHCircularBuffer no space to write %zu. allocated size %zu ",
+                    count, getSize());
+            count = availableToWrite();
+        }
+        for (size_t done = 0; done < count; ) {
+            const size_t chunk = std::min(count - done, getSize() - mWriteIndex);
+            T *dst = &mBuffer[mWriteIndex];
+            for (size_t k = 0; k < chunk; k++) {
+                dst[k] = *src;
+                src += stride;
+            }
+            mWriteIndex += chunk;
+            if (mWriteIndex >= getSize()) {
+                mWriteIndex = 0;
+            }
+            done += chunk;
+        }
+        mReadAvailable += count;
+        return count;
+    }
+    // Reads count values into every stride elements of dst.
+    // Returns the number of values read.
+    size_t read(T *dst, size_t count, size_t stride = 1) {
+        if (count > availableToRead()) {
+            ALOGW("Warning: SHCircularBuffer only %zu of %zu values available to read",
+                    availableToRead(), count);
+            count = availableToRead();
+        }
+        for (size_t done = 0; done < count; ) {
+            const size_t chunk = std::min(count - done, getSize() - mReadIndex);
+            const T *src = &mBuffer[mReadIndex];
+            for (size_t k = 0; k < chunk; k++) {
+                *dst = src[k];
+                dst += stride;
+            }
+            mReadIndex += chunk;
+            if (mReadIndex >= getSize()) {
+                mReadIndex = 0;
+            }
+            done += chunk;
+        }
+        mReadAvailable -= count;
+        return count;
+    }
     inline size_t availableToRead() const {
         return mReadAvailable;
     }
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <dsp/DPConvolver.h>
+
+#include <gtest/gtest.h>
+
+using namespace dp_fx;
+
+static constexpr size_t kBlockSize = 64;
+static constexpr float kTolerance = 1e-4f;
+
+static std::vector<float> randomSignal(size_t samples, unsigned seed) {
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> signal(samples);
+    for (auto &sample : signal) {
+        sample = dis(gen);
+    }
+    return signal;
+}
+
+// Processes interleaved input in chunks that do not line up with the block size.
+static std::vector<float> process(DPConvolver &convolver, const std::vector<float> &in,
+        size_t channelCount) {
+    std::vector<float> out(in.size());
+    const size_t frames = in.size() / channelCount;
+    for (size_t frame = 0; frame < frames; ) {
+        const size_t count = std::min<size_t>(37, frames - frame);
+        convolver.processSamples(&in[frame * channelCount], &out[frame * channelCount],
+                count * channelCount);
+        frame += count;
+    }
+    return out;
+}
+
+// Direct form convolution of one channel, delayed by the convolver latency.
+static std::vector<float> convolve(const std::vector<float> &in, size_t channelCount,
+        size_t channel, const std::vector<float> &ir, size_t latency) {
+    const size_t frames = in.size() / channelCount;
+    std::vector<float> out(frames, 0.f);
+    for (size_t n = latency; n < frames; n++) {
+        const size_t t = n - latency;
+        double sum = 0.;
+        for (size_t k = 0; k < ir.size() && k <= t; k++) {
+            sum += (double)ir[k] * in[(t - k) * channelCount + channel];
+        }
+        out[n] = (float)sum;
+    }
+    return out;
+}
+
+TEST(DPConvolverTest, PassThroughWithoutImpulseResponse) {
+    DPConvolver convolver;
+    convolver.configure(1, kBlockSize);
+    const std::vector<float> in = randomSignal(10 * kBlockSize, 1);
+    const std::vector<float> out = process(convolver, in, 1);
+    for (size_t n = 0; n < out.size(); n++) {
+        const float expected = n < kBlockSize ? 0.f : in[n - kBlockSize];
+        ASSERT_EQ(expected, out[n]) << "frame " << n;
+    }
+}
+
+TEST(DPConvolverTest, UnitImpulse) {
+    constexpr size_t channelCount = 2;
+    DPConvolver convolver;
+    convolver.configure(channelCount, kBlockSize);
+    const float impulse = 1.f;
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        ASSERT_TRUE(convolver.setImpulseResponse(ch, &impulse, 1));
+    }
+    ASSERT_EQ(kBlockSize, convolver.getLatency());
+
+    const std::vector<float> in = randomSignal(10 * kBlockSize * channelCount, 2);
+    const std::vector<float> out = process(convolver, in, channelCount);
+    const size_t delay = kBlockSize * channelCount;
+    for (size_t i = 0; i < out.size(); i++) {
+        const float expected = i < delay ? 0.f : in[i - delay];
+        ASSERT_NEAR(expected, out[i], kTolerance) << "sample " << i;
+    }
+}
+
+TEST(DPConvolverTest, KnownFir) {
+    constexpr size_t channelCount = 2;
+    DPConvolver convolver;
+    convolver.configure(channelCount, kBlockSize);
+
+    // a 5 tap moving average on one channel, and a response of several partitions
+    // whose length is not a multiple of the block size on the other.
+    const std::vector<float> irs[channelCount] = {
+        std::vector<float>(5, 0.2f),
+        randomSignal(3 * kBlockSize + 17, 3),
+    };
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        ASSERT_TRUE(convolver.setImpulseResponse(ch, irs[ch].data(), irs[ch].size()));
+        EXPECT_EQ(irs[ch].size(), convolver.getImpulseResponseLength(ch));
+    }
+
+    const std::vector<float> in = randomSignal(20 * kBlockSize * channelCount, 4);
+    const std::vector<float> out = process(convolver, in, channelCount);
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        const std::vector<float> expected =
+                convolve(in, channelCount, ch, irs[ch], convolver.getLatency());
+        for (size_t n = 0; n < expected.size(); n++) {
+            ASSERT_NEAR(expected[n], out[n * channelCount + ch], kTolerance)
+                    << "channel " << ch << " frame " << n;
+        }
+    }
+}
+
+TEST(DPConvolverTest, PreparedImpulseResponse) {
+    DPConvolver convolver;
+    convolver.configure(1, kBlockSize);
+    const std::vector<float> ir = randomSignal(2 * kBlockSize + 1, 5);
+
+    DPConvolver::ImpulseResponse prepared;
+    EXPECT_FALSE(DPConvolver::prepareImpulseResponse(
+            prepared, kBlockSize + 1, ir.data(), ir.size()));
+    ASSERT_TRUE(DPConvolver::prepareImpulseResponse(
+            prepared, 2 * kBlockSize, ir.data(), ir.size()));
+    // prepared for another block size.
+    EXPECT_FALSE(convolver.setImpulseResponse(0, prepared));
+    EXPECT_EQ(0u, convolver.getImpulseResponseLength(0));
+
+    ASSERT_TRUE(DPConvolver::prepareImpulseResponse(
+            prepared, convolver.getBlockSize(), ir.data(), ir.size()));
+    EXPECT_FALSE(convolver.setImpulseResponse(1, prepared));
+    ASSERT_TRUE(convolver.setImpulseResponse(0, prepared));
+    EXPECT_EQ(ir.size(), convolver.getImpulseResponseLength(0));
+    // the previous, empty, response is handed back.
+    EXPECT_EQ(0u, prepared.length);
+    EXPECT_TRUE(prepared.spectra.empty());
+
+    const std::vector<float> in = randomSignal(10 * kBlockSize, 6);
+    const std::vector<float> out = process(convolver, in, 1);
+    const std::vector<float> expected = convolve(in, 1, 0, ir, convolver.getLatency());
+    for (size_t n = 0; n < expected.size(); n++) {
+        ASSERT_NEAR(expected[n], out[n], kTolerance) << "frame " << n;
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <EffectConvolution.h>
+
+#include <gtest/gtest.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+static constexpr effect_uuid_t kConvolutionUuid =
+        {0x5c8a0f2e, 0x3b71, 0x4e9d, 0xa64c, {0x1f, 0x2e, 0x8d, 0x7b, 0x9a, 0x30}};
+static constexpr size_t kChannelCount = 2;
+static constexpr int32_t kBlockSize = 64;
+static constexpr float kTolerance = 1e-4f;
+
+class EffectConvolutionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(0, AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+                &kConvolutionUuid, 0 /* sessionId */, 0 /* ioId */, &mHandle));
+
+        effect_config_t config = {};
+        config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+        config.inputCfg.channels = AUDIO_CHANNEL_OUT_STEREO;
+        config.inputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+        config.inputCfg.samplingRate = 48000;
+        config.inputCfg.mask = EFFECT_CONFIG_ALL;
+        config.outputCfg = config.inputCfg;
+        config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+        ASSERT_EQ(0, command(EFFECT_CMD_SET_CONFIG, &config, sizeof(config)));
+        ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_BLOCK_SIZE}, &kBlockSize,
+                sizeof(kBlockSize)));
+        ASSERT_EQ(0, command(EFFECT_CMD_ENABLE, nullptr, 0));
+    }
+
+    void TearDown() override {
+        if (mHandle != nullptr) {
+            EXPECT_EQ(0, AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(mHandle));
+        }
+    }
+
+    int command(uint32_t cmdCode, void *pCmdData, uint32_t cmdSize) {
+        int reply = 0;
+        uint32_t replySize = sizeof(reply);
+        const int status = (*mHandle)->command(mHandle, cmdCode, cmdSize, pCmdData,
+                &replySize, &reply);
+        return status != 0 ? status : reply;
+    }
+
+    int setParameter(const std::vector<int32_t> &params, const void *value,
+            uint32_t valueSize) {
+        const uint32_t psize = params.size() * sizeof(int32_t);
+        std::vector<uint8_t> cmd(sizeof(effect_param_t) + psize + valueSize);
+        effect_param_t *p = (effect_param_t *)cmd.data();
+        p->psize = psize;
+        p->vsize = valueSize;
+        memcpy(p->data, params.data(), psize);
+        memcpy(p->data + psize, value, valueSize);
+        return command(EFFECT_CMD_SET_PARAM, cmd.data(), cmd.size());
+    }
+
+    int32_t getImpulseResponseLength(int32_t channel) {
+        const int32_t params[] = {CONVOLUTION_PARAM_IMPULSE_RESPONSE, channel};
+        std::vector<uint8_t> cmd(sizeof(effect_param_t) + sizeof(params));
+        effect_param_t *p = (effect_param_t *)cmd.data();
+        p->psize = sizeof(params);
+        p->vsize = sizeof(int32_t);
+        memcpy(p->data, params, sizeof(params));
+
+        std::vector<uint8_t> reply(cmd.size() + sizeof(int32_t));
+        uint32_t replySize = reply.size();
+        if ((*mHandle)->command(mHandle, EFFECT_CMD_GET_PARAM, cmd.size(), cmd.data(),
+                &replySize, reply.data()) != 0) {
+            return -1;
+        }
+        const effect_param_t *r = (const effect_param_t *)reply.data();
+        return r->status == 0 ? *(const int32_t *)(r->data + sizeof(params)) : -1;
+    }
+
+    // impulse responses are swapped in asynchronously, once transformed.
+    bool waitForImpulseResponseLength(int32_t channel, int32_t length) {
+        for (int i = 0; i < 1000; i++) {
+            if (getImpulseResponseLength(channel) == length) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    effect_handle_t mHandle = nullptr;
+};
+
+TEST_F(EffectConvolutionTest, ImpulseResponseInChunks) {
+    // channel 0: a known FIR sent in two chunks, channel 1: a unit impulse.
+    std::minstd_rand gen(7);
+    std::uniform_real_distribution<float> dis(-1.f, 1.f);
+    std::vector<float> fir(2 * kBlockSize + 5);
+    for (auto &tap : fir) {
+        tap = dis(gen);
+    }
+    const int32_t firLength = fir.size();
+    const int32_t split = kBlockSize + 3;
+    ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_IMPULSE_RESPONSE, 0, 0, firLength},
+            fir.data(), split * sizeof(float)));
+    ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_IMPULSE_RESPONSE, 0, split, firLength},
+            fir.data() + split, (firLength - split) * sizeof(float)));
+    const float impulse = 1.f;
+    ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_IMPULSE_RESPONSE, 1, 0, 1},
+            &impulse, sizeof(impulse)));
+    // a chunk out of order is rejected.
+    EXPECT_NE(0, setParameter({CONVOLUTION_PARAM_IMPULSE_RESPONSE, 0, 1, firLength},
+            fir.data(), sizeof(float)));
+
+    ASSERT_TRUE(waitForImpulseResponseLength(0, firLength));
+    ASSERT_TRUE(waitForImpulseResponseLength(1, 1));
+    ASSERT_EQ(0, command(EFFECT_CMD_RESET, nullptr, 0));
+
+    constexpr size_t frameCount = 20 * kBlockSize;
+    std::vector<float> in(frameCount * kChannelCount);
+    for (auto &sample : in) {
+        sample = dis(gen);
+    }
+    // processed in place, in chunks that do not line up with the block size.
+    std::vector<float> out(in);
+    for (size_t frame = 0; frame < frameCount; frame += 48) {
+        const size_t count = std::min<size_t>(48, frameCount - frame);
+        audio_buffer_t buffer = {.frameCount = count, .f32 = &out[frame * kChannelCount]};
+        ASSERT_EQ(0, (*mHandle)->process(mHandle, &buffer, &buffer));
+    }
+
+    for (size_t n = kBlockSize; n < frameCount; n++) {
+        const size_t t = n - kBlockSize;
+        double expected = 0.;
+        for (size_t k = 0; k < fir.size() && k <= t; k++) {
+            expected += (double)fir[k] * in[(t - k) * kChannelCount];
+        }
+        ASSERT_NEAR(expected, out[n * kChannelCount], kTolerance) << "frame " << n;
+        ASSERT_NEAR(in[t * kChannelCount + 1], out[n * kChannelCount + 1], kTolerance)
+                << "frame " << n;
+    }
+}
+
+TEST_F(EffectConvolutionTest, BlockSizeClearsImpulseResponses) {
+    const float impulse = 1.f;
+    ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_IMPULSE_RESPONSE, 0, 0, 1},
+            &impulse, sizeof(impulse)));
+    ASSERT_TRUE(waitForImpulseResponseLength(0, 1));
+    ASSERT_EQ(0, setParameter({CONVOLUTION_PARAM_BLOCK_SIZE}, &kBlockSize,
+            sizeof(kBlockSize)));
+    EXPECT_EQ(0, getImpulseResponseLength(0));
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <stdlib.h>
+#include <vector>
+
+#include <dsp/DPFrequency.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace dp_fx;
+
+// 10 ms at 48 kHz, the usual block of a fast mixer or offload effect chain.
+static constexpr size_t SAMPLE_RATE = 48000;
+static constexpr size_t FRAME_COUNT = 480;
+
+// Engine block as configured by DynamicsProcessing for a 20 ms preferred frame duration.
+static constexpr size_t BLOCK_SIZE = 1024;
+
+// Configures every stage in use and enabled, all bands enabled and spread up to 20 kHz.
+static void initEngine(DPFrequency &dp, size_t channelCount, size_t bandCount) {
+    dp.init(channelCount, true /*preEqInUse*/, bandCount, true /*mbcInUse*/, bandCount,
+            true /*postEqInUse*/, bandCount, true /*limiterInUse*/);
+    for (size_t ch = 0; ch < channelCount; ch++) {
+        DPChannel *pChannel = dp.getChannel(ch);
+        pChannel->getPreEq()->setEnabled(true);
+        pChannel->getMbc()->setEnabled(true);
+        pChannel->getPostEq()->setEnabled(true);
+        for (size_t b = 0; b < bandCount; b++) {
+            const float cutoffHz = 20000.f * (b + 1) / bandCount;
+            DPEqBand eqBand;
+            eqBand.init(true, cutoffHz, (b % 2) ? -3.f : 3.f);
+            pChannel->getPreEq()->setBand(b, eqBand);
+            pChannel->getPostEq()->setBand(b, eqBand);
+            DPMbcBand mbcBand;
+            mbcBand.init(true, cutoffHz, 3 /*attackTime*/, 80 /*releaseTime*/, 4 /*ratio*/,
+                    -30 /*threshold*/, 3 /*kneeWidth*/, -90 /*noiseGateThreshold*/,
+                    1 /*expanderRatio*/, 0 /*preGain*/, 0 /*postGain*/);
+            pChannel->getMbc()->setBand(b, mbcBand);
+        }
+        DPLimiter limiter;
+        limiter.init(true, true, 0 /*linkGroup*/, 1 /*attackTime*/, 60 /*releaseTime*/,
+                10 /*ratio*/, -10 /*threshold*/, 0 /*postGain*/);
+        pChannel->setLimiter(limiter);
+    }
+    dp.configure(BLOCK_SIZE, BLOCK_SIZE / 2, SAMPLE_RATE);
+}
+
+// Reports the cost of processing one 10 ms block in microseconds.
+// Args: channel count, band count of each of the preEq, mbc and postEq stages.
+static void BM_DPFrequency(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const size_t bandCount = state.range(1);
+    DPFrequency dp;
+    initEngine(dp, channelCount, bandCount);
+
+    std::vector<float> input(FRAME_COUNT * channelCount);
+    for (float &sample : input) {
+        sample = (float)rand() / RAND_MAX * 2.f - 1.f;
+    }
+    std::vector<float> output(input.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(input.data());
+        dp.processSamples(input.data(), output.data(), input.size());
+        benchmark::ClobberMemory();
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+    state.counters["us/10ms"] = elapsed.count() / state.iterations();
+}
+
+static void DPFrequencyArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 8}) {
+        for (int bandCount : {1, 4, 8, 16, 32}) {
+            b->Args({channelCount, bandCount});
+        }
+    }
+}
+
+BENCHMARK(BM_DPFrequency)->Apply(DPFrequencyArgs);
+
+BENCHMARK_MAIN();
@@ -1240,7 +1240,7 @@ int PreProcessingFx_Process(effect_handle_t     self,
             memcpy(outBuffer->s16,
                   session->outBuf,
                   fr * session->outChannelCount * sizeof(int16_t));
-            memcpy(session->outBuf,
+            memmove(session->outBuf,
                   session->outBuf + fr * session->outChannelCount,
                   (session->framesOut - fr) * session->outChannelCount * sizeof(int16_t));
             session->framesOut -= fr;
@@ -1303,7 +1303,7 @@ int PreProcessingFx_Process(effect_handle_t     self,
                                                         session->procFrame->data_,
                                                         &frOut);
             }
-            memcpy(session->inBuf,
+            memmove(session->inBuf,
                    session->inBuf + frIn * session->inChannelCount,
                    (session->framesIn - frIn) * session->inChannelCount * sizeof(int16_t));
             session->framesIn -= frIn;
@@ -1381,7 +1381,7 @@ int PreProcessingFx_Process(effect_handle_t     self,
         memcpy(outBuffer->s16 + framesWr * session->outChannelCount,
               session->outBuf,
               fr * session->outChannelCount * sizeof(int16_t));
-        memcpy(session->outBuf,
+        memmove(session->outBuf,
               session->outBuf + fr * session->outChannelCount,
               (session->framesOut - fr) * session->outChannelCount * sizeof(int16_t));
         session->framesOut -= fr;
@@ -1837,7 +1837,7 @@ int PreProcessingFx_ProcessReverse(effect_handle_t     self,
                                                         session->revFrame->data_,
                                                         &frOut);
             }
-            memcpy(session->revBuf,
+            memmove(session->revBuf,
                    session->revBuf + frIn * session->inChannelCount,
                    (session->framesRev - frIn) * session->inChannelCount * sizeof(int16_t));
             session->framesRev -= frIn;
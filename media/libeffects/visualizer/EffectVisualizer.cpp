@@ -318,6 +318,17 @@ int VisualizerLib_GetDescriptor(const effect_uuid_t *uuid,
 //--- Effect Control Interface Implementation
 //
 
+// Stores the peak and RMS squared of the last processed buffer in the measurement window.
+static void storeMeasurement(VisualizerContext *pContext, uint16_t peakU16, float rmsSquared)
+{
+    pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mPeakU16 = peakU16;
+    pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mRmsSquared = rmsSquared;
+    pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mIsValid = true;
+    if (++pContext->mMeasurementBufferIdx >= pContext->mMeasurementWindowSizeInBuffers) {
+        pContext->mMeasurementBufferIdx = 0;
+    }
+}
+
 int Visualizer_process(
         effect_handle_t self, audio_buffer_t *inBuffer, audio_buffer_t *outBuffer)
 {
@@ -337,34 +348,24 @@ int Visualizer_process(
     const size_t sampleLen = inBuffer->frameCount * pContext->mChannelCount;
 
     // perform measurements if needed
-    if (pContext->mMeasurementMode & MEASUREMENT_MODE_PEAK_RMS) {
-        // find the peak and RMS squared for the new buffer
-        float rmsSqAcc = 0;
-
+    const bool measurePeakRms = (pContext->mMeasurementMode & MEASUREMENT_MODE_PEAK_RMS) != 0;
 #ifdef BUILD_FLOAT
-        float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ++inIdx) {
-            maxSample = fmax(maxSample, fabs(inBuffer->f32[inIdx]));
-            rmsSqAcc += inBuffer->f32[inIdx] * inBuffer->f32[inIdx];
-        }
-        maxSample *= 1 << 15; // scale to int16_t, with exactly 1 << 15 representing positive num.
-        rmsSqAcc *= 1 << 30; // scale to int16_t * 2
+    // In float, the peak and RMS squared are accumulated by the first of the passes below
+    // that reads every sample, instead of by a pass of their own.
+    float maxAbsSample = 0.f;
+    float rmsSqAcc = 0.f;
 #else
+    if (measurePeakRms) {
+        // find the peak and RMS squared for the new buffer
+        float rmsSqAcc = 0;
         int maxSample = 0;
         for (size_t inIdx = 0; inIdx < sampleLen; ++inIdx) {
             maxSample = std::max(maxSample, std::abs(int32_t(inBuffer->s16[inIdx])));
             rmsSqAcc += inBuffer->s16[inIdx] * inBuffer->s16[inIdx];
         }
-#endif
-        // store the measurement
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mPeakU16 = (uint16_t)maxSample;
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mRmsSquared =
-                rmsSqAcc / sampleLen;
-        pContext->mPastMeasurements[pContext->mMeasurementBufferIdx].mIsValid = true;
-        if (++pContext->mMeasurementBufferIdx >= pContext->mMeasurementWindowSizeInBuffers) {
-            pContext->mMeasurementBufferIdx = 0;
-        }
+        storeMeasurement(pContext, (uint16_t)maxSample, rmsSqAcc / sampleLen);
     }
+#endif
 
 #ifdef BUILD_FLOAT
     float fscale; // multiplicative scale
@@ -383,7 +384,12 @@ int Visualizer_process(
             // for multichannel outputs (channels > 2 may often be 0).
             float smp = 0.f;
             for (int i = 0; i < pContext->mChannelCount; ++i) {
-                smp += inBuffer->f32[inIdx++];
+                const float sample = inBuffer->f32[inIdx++];
+                if (measurePeakRms) {
+                    maxAbsSample = fmax(maxAbsSample, fabs(sample));
+                    rmsSqAcc += sample * sample;
+                }
+                smp += sample;
             }
             maxSample = fmax(maxSample, fabs(smp));
         }
@@ -427,6 +433,10 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+#ifdef BUILD_FLOAT
+    const bool measureInCapture = measurePeakRms
+            && pContext->mScalingMode != VISUALIZER_SCALING_MODE_NORMALIZED;
+#endif // BUILD_FLOAT
     uint32_t captIdx;
     uint32_t inIdx;
     uint8_t *buf = pContext->mCaptureBuf;
@@ -438,7 +448,12 @@ int Visualizer_process(
 #ifdef BUILD_FLOAT
         float smp = 0.f;
         for (uint32_t i = 0; i < pContext->mChannelCount; ++i) {
-            smp += inBuffer->f32[inIdx++];
+            const float sample = inBuffer->f32[inIdx++];
+            if (measureInCapture) {
+                maxAbsSample = fmax(maxAbsSample, fabs(sample));
+                rmsSqAcc += sample * sample;
+            }
+            smp += sample;
         }
         buf[captIdx] = clamp8_from_float(smp * fscale);
 #else
@@ -448,6 +463,14 @@ int Visualizer_process(
 #endif // BUILD_FLOAT
     }
 
+#ifdef BUILD_FLOAT
+    if (measurePeakRms) {
+        // scale to int16_t, with exactly 1 << 15 representing positive num.
+        storeMeasurement(pContext, (uint16_t)(maxAbsSample * (1 << 15)),
+                rmsSqAcc * (1 << 30) / sampleLen); // scale to int16_t * 2
+    }
+#endif // BUILD_FLOAT
+
     // XXX the following two should really be atomic, though it probably doesn't
     // matter much for visualization purposes
     pContext->mCaptureIdx = captIdx;
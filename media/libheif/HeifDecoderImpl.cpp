@@ -24,6 +24,7 @@
 #include <android/IDataSource.h>
 #include <binder/IMemory.h>
 #include <binder/MemoryDealer.h>
+#include <cutils/properties.h>
 #include <drm/drm_framework_common.h>
 #include <media/mediametadataretriever.h>
 #include <media/stagefright/MediaSource.h>
@@ -302,6 +303,23 @@ bool HeifDecoderImpl::DecodeThread::threadLoop() {
 
 /////////////////////////////////////////////////////////////////////////
 
+struct HeifDecoderImpl::PrefetchThread : public Thread {
+    explicit PrefetchThread(HeifDecoderImpl *decoder) : mDecoder(decoder) {}
+
+private:
+    HeifDecoderImpl* mDecoder;
+
+    bool threadLoop();
+
+    DISALLOW_EVIL_CONSTRUCTORS(PrefetchThread);
+};
+
+bool HeifDecoderImpl::PrefetchThread::threadLoop() {
+    return mDecoder->prefetchAsync();
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 HeifDecoderImpl::HeifDecoderImpl() :
     // output color format should always be set via setOutputColor(), in case
     // it's not, default to HAL_PIXEL_FORMAT_RGB_565.
@@ -312,16 +330,20 @@ HeifDecoderImpl::HeifDecoderImpl() :
     mHasImage(false),
     mHasVideo(false),
     mSequenceLength(0),
+    mRegionLeft(0),
+    mRegionWidth(0),
     mAvailableLines(0),
     mNumSlices(1),
     mSliceHeight(0),
-    mAsyncDecodeDone(false) {
+    mAsyncDecodeDone(false),
+    mPrefetchIndex(-1) {
 }
 
 HeifDecoderImpl::~HeifDecoderImpl() {
     if (mThread != nullptr) {
         mThread->join();
     }
+    cancelPrefetch();
 }
 
 bool HeifDecoderImpl::init(HeifStream* stream, HeifFrameInfo* frameInfo) {
@@ -338,6 +360,7 @@ bool HeifDecoderImpl::init(HeifStream* stream, HeifFrameInfo* frameInfo) {
 }
 
 bool HeifDecoderImpl::reinit(HeifFrameInfo* frameInfo) {
+    cancelPrefetch();
     mFrameDecoded = false;
     mFrameMemory.clear();
 
@@ -489,6 +512,8 @@ bool HeifDecoderImpl::setOutputColor(HeifColorFormat heifColor) {
             return false;
     }
 
+    // a prefetched frame has the previous color format
+    cancelPrefetch();
     if (mFrameDecoded) {
         return reinit(nullptr);
     }
@@ -527,8 +552,13 @@ bool HeifDecoderImpl::decodeAsync() {
 }
 
 bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
-    // reset scanline pointer
+    cancelPrefetch();
+
+    // reset scanline pointer, which decodeRegion() or decodeSampled() may have moved
     mCurScanline = 0;
+    mTotalScanline = mHasImage ? mImageInfo.mHeight : mSequenceInfo.mHeight;
+    mRegionLeft = 0;
+    mRegionWidth = 0;
 
     if (mFrameDecoded) {
         return true;
@@ -536,9 +566,13 @@ bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
 
     // See if we want to decode in slices to allow client to start
     // scanline processing in parallel with decode. If this fails
-    // we fallback to decoding the full frame.
+    // we fallback to decoding the full frame. Slicing is skipped when the
+    // tiles of the full frame may be decoded on several codec instances,
+    // which finishes the whole grid sooner than one row at a time.
     if (mHasImage) {
-        if (mSliceHeight >= 512 &&
+        bool gridParallel = property_get_int32(
+                "media.stagefright.thumbnail.grid_codecs", 1) > 1;
+        if (!gridParallel && mSliceHeight >= 512 &&
                 mImageInfo.mWidth >= 3000 &&
                 mImageInfo.mHeight >= 2000 ) {
             // Try decoding in slices only if the image has tiles and is big enough.
@@ -638,12 +672,33 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
         return false;
     }
 
+    if (mRetriever == nullptr) {
+        ALOGE("decodeSequence: retriever was released");
+        return false;
+    }
+
     mCurScanline = 0;
+    mRegionLeft = 0;
+    mRegionWidth = 0;
 
     // set total scanline to sequence height now
     mTotalScanline = mSequenceInfo.mHeight;
 
-    mFrameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
+    // The retriever keeps the codec of the sequence open and continues from
+    // the previous frame, so a prefetch of the next frame is usually a hit.
+    if (mPrefetchThread != nullptr) {
+        mPrefetchThread->join();
+        mPrefetchThread.clear();
+    }
+    if (mPrefetchIndex == frameIndex && mPrefetchMemory != nullptr) {
+        ALOGV("decodeSequence: prefetched frame %d", frameIndex);
+        mFrameMemory = mPrefetchMemory;
+    } else {
+        mFrameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
+    }
+    mPrefetchIndex = -1;
+    mPrefetchMemory.clear();
+
     if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
         ALOGE("decode: videoFrame is a nullptr");
         return false;
@@ -672,9 +727,144 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
     if (frameInfo != nullptr) {
         initFrameInfo(frameInfo, videoFrame);
     }
+
+    if (frameIndex + 1 < (int)mSequenceLength) {
+        mPrefetchIndex = frameIndex + 1;
+        mPrefetchThread = new PrefetchThread(this);
+        if (mPrefetchThread->run("HeifPrefetch", ANDROID_PRIORITY_FOREGROUND) != OK) {
+            mPrefetchThread.clear();
+            mPrefetchIndex = -1;
+        }
+    }
     return true;
 }
 
+bool HeifDecoderImpl::prefetchAsync() {
+    ALOGV("prefetchAsync(): decoding frame %d", mPrefetchIndex);
+    // The frame decoder alternates between two output frames, so this doesn't
+    // overwrite the frame the client is reading.
+    mPrefetchMemory = mRetriever->getFrameAtIndex(mPrefetchIndex, mOutputColor);
+    return false;
+}
+
+void HeifDecoderImpl::cancelPrefetch() {
+    if (mPrefetchThread != nullptr) {
+        mPrefetchThread->join();
+        mPrefetchThread.clear();
+    }
+    mPrefetchIndex = -1;
+    mPrefetchMemory.clear();
+}
+
+bool HeifDecoderImpl::prepareRedecode() {
+    cancelPrefetch();
+    // A sliced decode() may still be running, and releases the retriever when done.
+    if (mThread != nullptr) {
+        mThread->join();
+        mThread.clear();
+    }
+    mNumSlices = 1;
+    mAvailableLines = 0;
+    mAsyncDecodeDone = false;
+    mFrameDecoded = false;
+
+    if (mRetriever == nullptr) {
+        return reinit(nullptr);
+    }
+    return true;
+}
+
+bool HeifDecoderImpl::decodeRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom,
+        HeifFrameInfo* frameInfo) {
+    ALOGV("%s: {%u, %u, %u, %u}", __FUNCTION__, left, top, right, bottom);
+    if (!mHasImage || left >= right || top >= bottom
+            || right > mImageInfo.mWidth || bottom > mImageInfo.mHeight) {
+        return false;
+    }
+
+    if (!prepareRedecode()) {
+        return false;
+    }
+
+    sp<IMemory> frameMemory = mRetriever->getImageRectAtIndex(
+            -1, mOutputColor, left, top, right, bottom);
+    if (frameMemory == nullptr || frameMemory->unsecurePointer() == nullptr) {
+        // Not a grid picture, decode it whole and return the region of it.
+        ALOGV("decodeRegion: falling back to full decode");
+        frameMemory = mRetriever->getImageAtIndex(-1, mOutputColor);
+    }
+    if (frameMemory == nullptr || frameMemory->unsecurePointer() == nullptr) {
+        ALOGE("decodeRegion: videoFrame is a nullptr");
+        return false;
+    }
+
+    VideoFrame* videoFrame = static_cast<VideoFrame*>(frameMemory->unsecurePointer());
+    if (videoFrame->mSize == 0 ||
+            frameMemory->size() < videoFrame->getFlattenedSize() ||
+            videoFrame->mWidth < right || videoFrame->mHeight < bottom) {
+        ALOGE("decodeRegion: videoFrame size is invalid");
+        return false;
+    }
+
+    // The frame has the size of the picture, with at least the region decoded.
+    mFrameMemory = frameMemory;
+    mCurScanline = top;
+    mTotalScanline = bottom;
+    mRegionLeft = left;
+    mRegionWidth = right - left;
+
+    if (frameInfo != nullptr) {
+        initFrameInfo(frameInfo, videoFrame);
+        frameInfo->mWidth = right - left;
+        frameInfo->mHeight = bottom - top;
+    }
+    return true;
+}
+
+bool HeifDecoderImpl::decodeSampled(uint32_t sampleSize, HeifFrameInfo* frameInfo) {
+    ALOGV("%s: sample size %u", __FUNCTION__, sampleSize);
+    if (!mHasImage || sampleSize == 0) {
+        return false;
+    }
+
+    if (sampleSize > 1) {
+        if (!prepareRedecode()) {
+            return false;
+        }
+        sp<IMemory> sharedMem = mRetriever->getImageAtIndex(
+                -1, mOutputColor, true /*metaOnly*/, true /*thumbnail*/);
+        const VideoFrame* thumbnail = sharedMem == nullptr ? nullptr
+                : static_cast<VideoFrame*>(sharedMem->unsecurePointer());
+
+        if (thumbnail != nullptr
+                && thumbnail->mWidth * sampleSize >= mImageInfo.mWidth
+                && thumbnail->mHeight * sampleSize >= mImageInfo.mHeight) {
+            sp<IMemory> frameMemory = mRetriever->getImageAtIndex(
+                    -1, mOutputColor, false /*metaOnly*/, true /*thumbnail*/);
+            VideoFrame* videoFrame = frameMemory == nullptr ? nullptr
+                    : static_cast<VideoFrame*>(frameMemory->unsecurePointer());
+            if (videoFrame != nullptr && videoFrame->mSize != 0 &&
+                    frameMemory->size() >= videoFrame->getFlattenedSize()) {
+                ALOGV("decodeSampled: using %ux%u thumbnail",
+                        videoFrame->mWidth, videoFrame->mHeight);
+                mFrameMemory = frameMemory;
+                mCurScanline = 0;
+                mTotalScanline = videoFrame->mHeight;
+                mRegionLeft = 0;
+                mRegionWidth = 0;
+
+                if (frameInfo != nullptr) {
+                    initFrameInfo(frameInfo, videoFrame);
+                }
+                return true;
+            }
+            ALOGW("decodeSampled: failed to decode thumbnail");
+        }
+    }
+
+    return decode(frameInfo);
+}
+
 bool HeifDecoderImpl::getScanlineInner(uint8_t* dst) {
     if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
         return false;
@@ -684,8 +874,10 @@ bool HeifDecoderImpl::getScanlineInner(uint8_t* dst) {
     //       Either document why it is safe in this case or address the
     //       issue (e.g. by copying).
     VideoFrame* videoFrame = static_cast<VideoFrame*>(mFrameMemory->unsecurePointer());
-    uint8_t* src = videoFrame->getFlattenedData() + videoFrame->mRowBytes * mCurScanline++;
-    memcpy(dst, src, videoFrame->mBytesPerPixel * videoFrame->mWidth);
+    uint8_t* src = videoFrame->getFlattenedData() + videoFrame->mRowBytes * mCurScanline++
+            + videoFrame->mBytesPerPixel * mRegionLeft;
+    uint32_t width = mRegionWidth > 0 ? mRegionWidth : videoFrame->mWidth;
+    memcpy(dst, src, videoFrame->mBytesPerPixel * width);
     return true;
 }
 
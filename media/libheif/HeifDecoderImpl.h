@@ -50,12 +50,18 @@ public:
 
     bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) override;
 
+    bool decodeRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom,
+            HeifFrameInfo* frameInfo) override;
+
+    bool decodeSampled(uint32_t sampleSize, HeifFrameInfo* frameInfo) override;
+
     bool getScanline(uint8_t* dst) override;
 
     size_t skipScanlines(size_t count) override;
 
 private:
     struct DecodeThread;
+    struct PrefetchThread;
 
     sp<IDataSource> mDataSource;
     sp<MediaMetadataRetriever> mRetriever;
@@ -69,6 +75,9 @@ private:
     bool mHasImage;
     bool mHasVideo;
     size_t mSequenceLength;
+    // Columns of the frame returned by getScanline, all of them if mRegionWidth is 0
+    uint32_t mRegionLeft;
+    uint32_t mRegionWidth;
 
     // Slice decoding only
     Mutex mLock;
@@ -79,9 +88,18 @@ private:
     uint32_t mSliceHeight;
     bool mAsyncDecodeDone;
 
+    // Sequence decoding only, the frame after the last one decoded is
+    // prefetched while the client reads the scanlines of the current one.
+    sp<PrefetchThread> mPrefetchThread;
+    int mPrefetchIndex;
+    sp<IMemory> mPrefetchMemory;
+
     bool decodeAsync();
+    bool prefetchAsync();
+    void cancelPrefetch();
     bool getScanlineInner(uint8_t* dst);
     bool reinit(HeifFrameInfo* frameInfo);
+    bool prepareRedecode();
 };
 
 } // namespace android
@@ -149,6 +149,31 @@ struct HeifDecoder {
      */
     virtual bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) = 0;
 
+    /*
+     * Decode the region [left, right) x [top, bottom) of the primary picture,
+     * in the coordinates of the picture before rotation, returning whether it
+     * succeeded. For a grid picture only the tiles that intersect the region
+     * are decoded. |frameInfo| will be filled with information of the region
+     * upon success and unmodified upon failure.
+     *
+     * After this succeeded, getScanline can be called to read the scanlines
+     * of the region. A later decode() decodes the whole picture again.
+     */
+    virtual bool decodeRegion(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom,
+            HeifFrameInfo* frameInfo) = 0;
+
+    /*
+     * Decode the primary picture for display at 1/|sampleSize| of its size,
+     * returning whether it succeeded. If the file embeds a thumbnail that is
+     * at least that big, the thumbnail is decoded instead of the picture.
+     * |frameInfo| will be filled with information of the decoded picture, which
+     * may be larger than requested, upon success and unmodified upon failure.
+     *
+     * After this succeeded, getScanline can be called to read the scanlines
+     * that were decoded.
+     */
+    virtual bool decodeSampled(uint32_t sampleSize, HeifFrameInfo* frameInfo) = 0;
+
     /*
      * Read the next scanline (in top-down order), returns true upon success
      * and false otherwise.
@@ -74,6 +74,7 @@ enum {
     GET_FRAME_AT_INDEX,
     EXTRACT_ALBUM_ART,
     EXTRACT_METADATA,
+    EXTRACT_METADATA_BATCH,
 };
 
 class BpMediaMetadataRetriever: public BpInterface<IMediaMetadataRetriever>
@@ -127,6 +128,9 @@ public:
         data.writeFileDescriptor(fd);
         data.writeInt64(offset);
         data.writeInt64(length);
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+        sendSchedPolicy(data);
+#endif
         remote()->transact(SET_DATA_SOURCE_FD, data, &reply);
         return reply.readInt32();
     }
@@ -143,6 +147,9 @@ public:
         } else {
             data.writeInt32(0);
         }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+        sendSchedPolicy(data);
+#endif
         remote()->transact(SET_DATA_SOURCE_CALLBACK, data, &reply);
         return reply.readInt32();
     }
@@ -276,6 +283,37 @@ public:
         }
     }
 
+    status_t extractMetadataBatch(
+            const Vector<int> &keyCodes, KeyedVector<int, String8> *values)
+    {
+        Parcel data, reply;
+        data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+        sendSchedPolicy(data);
+#endif
+        data.writeInt32(keyCodes.size());
+        for (size_t i = 0; i < keyCodes.size(); ++i) {
+            data.writeInt32(keyCodes[i]);
+        }
+        remote()->transact(EXTRACT_METADATA_BATCH, data, &reply);
+        status_t ret = reply.readInt32();
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        values->clear();
+        int32_t numValues = reply.readInt32();
+        for (int32_t i = 0; i < numValues; ++i) {
+            int32_t keyCode = reply.readInt32();
+            String8 value;
+            ret = reply.readString8(&value);
+            if (ret != OK) {
+                return ret;
+            }
+            values->add(keyCode, value);
+        }
+        return NO_ERROR;
+    }
+
 private:
     KeyedVector<int, String8> mMetadata;
 };
@@ -339,7 +377,13 @@ status_t BnMediaMetadataRetriever::onTransact(
             int fd = data.readFileDescriptor();
             int64_t offset = data.readInt64();
             int64_t length = data.readInt64();
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            setSchedPolicy(data);
+#endif
             reply->writeInt32(setDataSource(fd, offset, length));
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            restoreSchedPolicy();
+#endif
             return NO_ERROR;
         } break;
         case SET_DATA_SOURCE_CALLBACK: {
@@ -354,7 +398,13 @@ status_t BnMediaMetadataRetriever::onTransact(
                 if (hasMime) {
                     mime = data.readCString();
                 }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+                setSchedPolicy(data);
+#endif
                 reply->writeInt32(setDataSource(source, mime));
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+                restoreSchedPolicy();
+#endif
             }
             return NO_ERROR;
         } break;
@@ -486,6 +536,31 @@ status_t BnMediaMetadataRetriever::onTransact(
             }
 #ifndef DISABLE_GROUP_SCHEDULE_HACK
             restoreSchedPolicy();
+#endif
+            return NO_ERROR;
+        } break;
+        case EXTRACT_METADATA_BATCH: {
+            CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            setSchedPolicy(data);
+#endif
+            Vector<int> keyCodes;
+            int32_t numKeys = data.readInt32();
+            for (int32_t i = 0; i < numKeys && data.dataAvail() > 0; ++i) {
+                keyCodes.push_back(data.readInt32());
+            }
+            KeyedVector<int, String8> values;
+            status_t ret = extractMetadataBatch(keyCodes, &values);
+            reply->writeInt32(ret);
+            if (ret == NO_ERROR) {
+                reply->writeInt32(values.size());
+                for (size_t i = 0; i < values.size(); ++i) {
+                    reply->writeInt32(values.keyAt(i));
+                    reply->writeString8(values.valueAt(i));
+                }
+            }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            restoreSchedPolicy();
 #endif
             return NO_ERROR;
         } break;
@@ -23,6 +23,7 @@
 #include <sys/types.h>
 
 #include <binder/Parcel.h>
+#include <utils/List.h>
 #include <media/IMediaSource.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaBufferGroup.h>
@@ -68,10 +69,15 @@ protected:
 class BpMediaSource : public BpInterface<IMediaSource> {
 public:
     explicit BpMediaSource(const sp<IBinder>& impl)
-        : BpInterface<IMediaSource>(impl), mBuffersSinceStop(0)
+        : BpInterface<IMediaSource>(impl), mBuffersSinceStop(0),
+          mSupportsNonblockingRead(-1), mReadAheadStatus(OK)
     {
     }
 
+    virtual ~BpMediaSource() {
+        clearReadAhead();
+    }
+
     virtual status_t start(MetaData *params) {
         ALOGV("start");
         Parcel data, reply;
@@ -95,6 +101,7 @@ public:
         ALOGV("stop");
         Parcel data, reply;
         data.writeInterfaceToken(BpMediaSource::getInterfaceDescriptor());
+        clearReadAhead();
         status_t status = remote()->transact(STOP, data, &reply);
         mMemoryCache.reset();
         mBuffersSinceStop = 0;
@@ -127,10 +134,66 @@ public:
     virtual status_t readMultiple(
             Vector<MediaBufferBase *> *buffers, uint32_t maxNumBuffers,
             const MediaSource::ReadOptions *options) {
-        ALOGV("readMultiple");
         if (buffers == NULL || !buffers->isEmpty()) {
             return BAD_VALUE;
         }
+        if (isSeeking(options)) {
+            clearReadAhead();
+        } else if (!mReadAheadBuffers.empty() || mReadAheadStatus != OK) {
+            while (buffers->size() < maxNumBuffers && !mReadAheadBuffers.empty()) {
+                buffers->push_back(*mReadAheadBuffers.begin());
+                mReadAheadBuffers.erase(mReadAheadBuffers.begin());
+            }
+            if (!buffers->isEmpty()) {
+                return OK;
+            }
+            status_t ret = mReadAheadStatus;
+            mReadAheadStatus = OK;
+            return ret;
+        }
+
+        if (maxNumBuffers >= kReadAheadBuffers
+                || isSeeking(options)
+                || (options != nullptr && options->getNonBlocking())
+                || !supportsReadAhead()) {
+            return readMultipleRemote(buffers, maxNumBuffers, options);
+        }
+
+        // Read ahead without blocking; extra buffers only come back when they
+        // are already available, so this never waits longer than the plain
+        // read would.
+        MediaSource::ReadOptions readAheadOptions;
+        if (options != nullptr) {
+            readAheadOptions = *options;
+        }
+        readAheadOptions.setNonBlocking();
+        Vector<MediaBufferBase *> readAhead;
+        status_t ret = readMultipleRemote(&readAhead, kReadAheadBuffers, &readAheadOptions);
+        if (readAhead.isEmpty()) {
+            if (ret != WOULD_BLOCK) {
+                return ret;
+            }
+            // Nothing was ready; do the read the caller asked for.
+            return readMultipleRemote(buffers, maxNumBuffers, options);
+        }
+        for (size_t i = 0; i < readAhead.size(); ++i) {
+            if (i < maxNumBuffers) {
+                buffers->push_back(readAhead[i]);
+            } else {
+                mReadAheadBuffers.push_back(readAhead[i]);
+            }
+        }
+        if (ret != OK) {
+            // Report the error after the buffers read before it.
+            mReadAheadStatus = ret;
+        }
+        return OK;
+    }
+
+    status_t readMultipleRemote(
+            Vector<MediaBufferBase *> *buffers, uint32_t maxNumBuffers,
+            const MediaSource::ReadOptions *options) {
+        ALOGV("readMultiple");
         Parcel data, reply;
         data.writeInterfaceToken(BpMediaSource::getInterfaceDescriptor());
         data.writeUint32(maxNumBuffers);
@@ -217,8 +280,35 @@ public:
     }
 
 private:
+    // Buffers fetched ahead of small reads so that callers reading one buffer
+    // at a time, e.g. NuMediaExtractor, don't pay a transaction per sample.
+    static const uint32_t kReadAheadBuffers = 8;
+
+    bool supportsReadAhead() {
+        if (mSupportsNonblockingRead < 0) {
+            mSupportsNonblockingRead = supportNonblockingRead() ? 1 : 0;
+        }
+        return mSupportsNonblockingRead > 0;
+    }
+
+    static bool isSeeking(const MediaSource::ReadOptions *options) {
+        int64_t seekTimeUs;
+        MediaSource::ReadOptions::SeekMode mode;
+        return options != nullptr && options->getSeekTo(&seekTimeUs, &mode);
+    }
+
+    void clearReadAhead() {
+        for (MediaBufferBase *buffer : mReadAheadBuffers) {
+            buffer->release();
+        }
+        mReadAheadBuffers.clear();
+        mReadAheadStatus = OK;
+    }
 
     uint32_t mBuffersSinceStop; // Buffer tracking variable
+    int32_t mSupportsNonblockingRead; // -1 until queried
+    List<MediaBufferBase *> mReadAheadBuffers;
+    status_t mReadAheadStatus; // returned once mReadAheadBuffers drains
 
     // NuPlayer passes pointers-to-metadata around, so we use this to keep the metadata alive
     // XXX: could we use this for caching, or does metadata change on the fly?
@@ -20,6 +20,8 @@
 
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <media/MidiIoWrapper.h>
 #include <media/MediaExtractorPluginApi.h>
@@ -106,9 +108,48 @@ MidiIoWrapper::~MidiIoWrapper() {
     delete mDataSource;
 }
 
+// Sonivox reads most of the file a byte at a time through readAt(), so files up to this
+// size are read into memory once instead of costing a read per byte.
+static const int64_t kMaxCachedSize = 1024 * 1024;
+
+void MidiIoWrapper::fillCache() {
+    mCacheFilled = true;
+    if (mLength <= 0 || mLength > kMaxCachedSize) {
+        return;
+    }
+    std::vector<uint8_t> cache(mLength);
+    int filled = 0;
+    while (filled < mLength) {
+        int n = readAtUncached(cache.data() + filled, filled, mLength - filled);
+        if (n <= 0) {
+            ALOGW("couldn't cache midi file, read %d of %d bytes", filled, int(mLength));
+            return;
+        }
+        filled += n;
+    }
+    mCache.swap(cache);
+}
+
 int MidiIoWrapper::readAt(void *buffer, int offset, int size) {
     ALOGV("readAt(%p, %d, %d)", buffer, offset, size);
 
+    if (!mCacheFilled) {
+        fillCache();
+    }
+    if (!mCache.empty() && offset >= 0 && size >= 0) {
+        if (offset >= mLength) {
+            return 0;
+        }
+        if (size > mLength - offset) {
+            size = mLength - offset;
+        }
+        memcpy(buffer, mCache.data() + offset, size);
+        return size;
+    }
+    return readAtUncached(buffer, offset, size);
+}
+
+int MidiIoWrapper::readAtUncached(void *buffer, int offset, int size) {
     if (mDataSource != NULL) {
         return mDataSource->readAt(offset, buffer, size);
     }
@@ -116,11 +157,10 @@ int MidiIoWrapper::readAt(void *buffer, int offset, int size) {
         errno = EBADF;
         return -1; // as per failed read.
     }
-    lseek(mFd, mBase + offset, SEEK_SET);
     if (offset + size > mLength) {
         size = mLength - offset;
     }
-    return read(mFd, buffer, size);
+    return pread64(mFd, buffer, size, mBase + offset);
 }
 
 int MidiIoWrapper::size() {
@@ -52,6 +52,10 @@ public:
             int index, int colorFormat, bool metaOnly) = 0;
     virtual sp<IMemory>     extractAlbumArt() = 0;
     virtual const char*     extractMetadata(int keyCode) = 0;
+    // Extracts several metadata keys in one call. Keys without a value are
+    // left out of |values|.
+    virtual status_t        extractMetadataBatch(
+            const Vector<int> &keyCodes, KeyedVector<int, String8> *values) = 0;
 };
 
 // ----------------------------------------------------------------------------
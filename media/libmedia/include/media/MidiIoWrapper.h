@@ -19,6 +19,8 @@
 
 #include <libsonivox/eas_types.h>
 
+#include <vector>
+
 namespace android {
 
 struct CDataSource;
@@ -37,12 +39,18 @@ public:
     EAS_FILE_LOCATOR getLocator();
 
 private:
+    int readAtUncached(void *buffer, int offset, int size);
+    void fillCache();
+
     int mFd;
     off64_t mBase;
     int64_t  mLength;
     class DataSourceUnwrapper;
     DataSourceUnwrapper *mDataSource;
     EAS_FILE mEasFile;
+    // Whole file contents, read on first access when the file is small enough.
+    std::vector<uint8_t> mCache;
+    bool mCacheFilled = false;
 };
 
 
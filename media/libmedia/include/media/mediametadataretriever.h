@@ -102,6 +102,8 @@ public:
             int index, int colorFormat = HAL_PIXEL_FORMAT_RGB_565, bool metaOnly = false);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
+    // Extracts |keyCodes| in a single call to the service.
+    status_t extractMetadata(const Vector<int> &keyCodes, KeyedVector<int, String8> *values);
 
 private:
     static const sp<IMediaPlayerService> getService();
@@ -179,7 +179,11 @@ enum media_parameter_keys {
     KEY_PARAMETER_PLAYBACK_RATE_PERMILLE = 1300,                // set only
 
     // Set a Parcel containing the value of a parcelled Java AudioAttribute instance
-    KEY_PARAMETER_AUDIO_ATTRIBUTES = 1400                       // set only
+    KEY_PARAMETER_AUDIO_ATTRIBUTES = 1400,                      // set only
+
+    // Set a Parcel containing a single int, 1 if the player is expected to be started soon
+    // and should decode its first frame as soon as it is prepared, 0 otherwise.
+    KEY_PARAMETER_PRELOAD = 1500                                // set only
 };
 
 // Keep INVOKE_ID_* in sync with MediaPlayer.java.
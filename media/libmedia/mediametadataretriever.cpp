@@ -202,6 +202,18 @@ const char* MediaMetadataRetriever::extractMetadata(int keyCode)
     return mRetriever->extractMetadata(keyCode);
 }
 
+status_t MediaMetadataRetriever::extractMetadata(
+        const Vector<int> &keyCodes, KeyedVector<int, String8> *values)
+{
+    ALOGV("extractMetadata(%zu keys)", keyCodes.size());
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->extractMetadataBatch(keyCodes, values);
+}
+
 sp<IMemory> MediaMetadataRetriever::extractAlbumArt()
 {
     ALOGV("extractAlbumArt");
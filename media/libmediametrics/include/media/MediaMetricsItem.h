@@ -852,7 +852,8 @@ public:
     // Iteration of props within item
     class iterator {
     public:
-        explicit iterator(const std::map<std::string, Prop>::const_iterator &_it) : it(_it) { }
+        explicit iterator(const std::map<std::string, Prop, std::less<>>::const_iterator &_it)
+            : it(_it) { }
         iterator &operator++() {
             ++it;
             return *this;
@@ -865,7 +866,7 @@ public:
         }
 
     private:
-        std::map<std::string, Prop>::const_iterator it;
+        std::map<std::string, Prop, std::less<>>::const_iterator it;
     };
 
     iterator begin() const {
@@ -1160,11 +1161,11 @@ private:
     }
 
     Prop &findOrAllocateProp(const char *key) {
-        auto it = mProps.find(key);
-        if (it != mProps.end()) return it->second;
-        Prop &prop = mProps[key];
-        prop.setName(key);
-        return prop;
+        auto it = mProps.lower_bound(key);
+        if (it != mProps.end() && it->first == key) return it->second;
+        it = mProps.emplace_hint(it, key, Prop());
+        it->second.setName(key);
+        return it->second;
     }
 
     // Changes to member variables below require changes to clear().
@@ -1174,7 +1175,8 @@ private:
     int64_t       mPkgVersionCode = 0;
     std::string   mKey;
     nsecs_t       mTimestamp = 0;
-    std::map<std::string, Prop> mProps;
+    // Transparent comparator, so props can be looked up by C string without a temporary
+    std::map<std::string, Prop, std::less<>> mProps;
 };
 
 } // namespace mediametrics
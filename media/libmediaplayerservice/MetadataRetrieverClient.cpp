@@ -310,4 +310,23 @@ const char* MetadataRetrieverClient::extractMetadata(int keyCode)
     return mRetriever->extractMetadata(keyCode);
 }
 
+status_t MetadataRetrieverClient::extractMetadataBatch(
+        const Vector<int> &keyCodes, KeyedVector<int, String8> *values)
+{
+    ALOGV("extractMetadataBatch(%zu keys)", keyCodes.size());
+    Mutex::Autolock lock(mLock);
+    if (mRetriever == NULL) {
+        ALOGE("retriever is not initialized");
+        return NO_INIT;
+    }
+    values->clear();
+    for (size_t i = 0; i < keyCodes.size(); ++i) {
+        const char *value = mRetriever->extractMetadata(keyCodes[i]);
+        if (value != NULL) {
+            values->add(keyCodes[i], String8(value));
+        }
+    }
+    return NO_ERROR;
+}
+
 }; // namespace android
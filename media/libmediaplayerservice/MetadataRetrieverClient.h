@@ -60,6 +60,8 @@ public:
             int index, int colorFormat, bool metaOnly);
     virtual sp<IMemory>             extractAlbumArt();
     virtual const char*             extractMetadata(int keyCode);
+    virtual status_t                extractMetadataBatch(
+            const Vector<int> &keyCodes, KeyedVector<int, String8> *values);
 
     virtual status_t                dump(int fd, const Vector<String16>& args);
 
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "StagefrightMetadataRetriever"
 
+#include <algorithm>
 #include <inttypes.h>
 
 #include <utils/Log.h>
@@ -44,7 +45,10 @@ namespace android {
 StagefrightMetadataRetriever::StagefrightMetadataRetriever()
     : mParsedMetaData(false),
       mAlbumArt(NULL),
-      mLastDecodedIndex(-1) {
+      mLastDecodedIndex(-1),
+      mDecoderSeekable(false),
+      mDecoderColorFormat(0),
+      mInFrameBatch(false) {
     ALOGV("StagefrightMetadataRetriever()");
 }
 
@@ -63,6 +67,7 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(%s)", uri);
 
     clearMetadata();
+    releaseDecoder();
     mSource = PlayerServiceDataSourceFactory::getInstance()->CreateFromURI(
             httpService, uri, headers);
 
@@ -92,6 +97,7 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(%d, %" PRId64 ", %" PRId64 ")", fd, offset, length);
 
     clearMetadata();
+    releaseDecoder();
     mSource = new PlayerServiceFileSource(fd, offset, length);
 
     status_t err;
@@ -117,6 +123,7 @@ status_t StagefrightMetadataRetriever::setDataSource(
     ALOGV("setDataSource(DataSource)");
 
     clearMetadata();
+    releaseDecoder();
     mSource = source;
     mExtractor = MediaExtractorFactory::Create(mSource, mime);
 
@@ -144,8 +151,12 @@ sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
 
     FrameRect rect = {left, top, right, bottom};
 
-    if (mDecoder != NULL && index == mLastDecodedIndex) {
-        return mDecoder->extractFrame(&rect);
+    if (mDecoder != NULL && !mDecoderSeekable && index == mLastDecodedIndex) {
+        sp<IMemory> frame = mDecoder->extractFrame(&rect);
+        if (frame != NULL) {
+            return frame;
+        }
+        // not the next slice of the previous rect, decode it on its own
     }
 
     return getImageInternal(
@@ -154,8 +165,7 @@ sp<IMemory> StagefrightMetadataRetriever::getImageRectAtIndex(
 
 sp<IMemory> StagefrightMetadataRetriever::getImageInternal(
         int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect) {
-    mDecoder.clear();
-    mLastDecodedIndex = -1;
+    releaseDecoder();
 
     if (mExtractor.get() == NULL) {
         ALOGE("no extractor.");
@@ -261,7 +271,8 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
         int frameIndex, int colorFormat, bool metaOnly) {
     ALOGV("getFrameAtIndex: frameIndex %d, colorFormat: %d, metaOnly: %d",
             frameIndex, colorFormat, metaOnly);
-    if (mDecoder != NULL && frameIndex == mLastDecodedIndex + 1) {
+    if (mDecoder != NULL && mDecoderSeekable
+            && mLastDecodedIndex >= 0 && frameIndex == mLastDecodedIndex + 1) {
         sp<IMemory> frame = mDecoder->extractFrame();
         if (frame != nullptr) {
             mLastDecodedIndex = frameIndex;
@@ -273,10 +284,75 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
             MediaSource::ReadOptions::SEEK_FRAME_INDEX, colorFormat, metaOnly);
 }
 
-sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+status_t StagefrightMetadataRetriever::getFramesAtTime(
+        const std::vector<int64_t> &timesUs, int option, int colorFormat,
+        std::vector<sp<IMemory> > *frames) {
+    ALOGV("getFramesAtTime: %zu frames option: %d colorFormat: %d",
+            timesUs.size(), option, colorFormat);
+
+    if (mExtractor.get() == NULL) {
+        ALOGE("no extractor.");
+        return NO_INIT;
+    }
+
+    // Visit the requests in presentation order so that every seek moves the
+    // source forward and sync samples shared by neighbouring requests stay
+    // close to each other.
+    std::vector<size_t> order(timesUs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&timesUs](size_t a, size_t b) {
+        return timesUs[a] < timesUs[b];
+    });
+
+    // The decoder is only kept across the requests of the batch, a codec
+    // must not stay allocated while the client is idle.
+    releaseDecoder();
+    mInFrameBatch = true;
+    frames->clear();
+    frames->resize(timesUs.size());
+    for (size_t i : order) {
+        (*frames)[i] = getFrameInternal(timesUs[i], option, colorFormat, false /* metaOnly */);
+    }
+    mInFrameBatch = false;
+    releaseDecoder();
+    return OK;
+}
+
+void StagefrightMetadataRetriever::releaseDecoder() {
     mDecoder.clear();
     mLastDecodedIndex = -1;
+    mDecoderSeekable = false;
+}
+
+sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
+        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+    // keep the decoder for sequential frame index requests, and to seek it
+    // for the next request of a batch
+    const bool keepDecoder =
+            mInFrameBatch || option == MediaSource::ReadOptions::SEEK_FRAME_INDEX;
+
+    if (!metaOnly && mDecoder != NULL && mDecoderSeekable
+            && colorFormat == mDecoderColorFormat) {
+        // Retarget the codec of the previous request rather than
+        // instantiating a new one.
+        if (mDecoder->seek(timeUs, option) == OK) {
+            sp<IMemory> frame = mDecoder->extractFrame();
+            if (frame != nullptr) {
+                if (keepDecoder) {
+                    mLastDecodedIndex =
+                            (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) ? timeUs : -1;
+                } else {
+                    releaseDecoder();
+                }
+                return frame;
+            }
+        }
+        ALOGV("failed to reuse decoder, instantiating a new one.");
+    }
+
+    releaseDecoder();
 
     if (mExtractor.get() == NULL) {
         ALOGE("no extractor.");
@@ -355,10 +431,13 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
         if (decoder->init(timeUs, option, colorFormat) == OK) {
             sp<IMemory> frame = decoder->extractFrame();
             if (frame != nullptr) {
-                // keep the decoder if seeking by frame index
-                if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+                if (keepDecoder) {
                     mDecoder = decoder;
-                    mLastDecodedIndex = timeUs;
+                    mDecoderSeekable = true;
+                    mDecoderColorFormat = colorFormat;
+                    if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+                        mLastDecodedIndex = timeUs;
+                    }
                 }
                 return frame;
             }
@@ -18,6 +18,8 @@
 
 #define STAGEFRIGHT_METADATA_RETRIEVER_H_
 
+#include <vector>
+
 #include <android/IMediaExtractor.h>
 #include <media/MediaMetadataRetrieverInterface.h>
 
@@ -53,6 +55,15 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
     virtual MediaAlbumArt *extractAlbumArt();
     virtual const char *extractMetadata(int keyCode);
 
+    // Extracts the frames at timesUs into frames, in request order. The
+    // requests are decoded in presentation order on one codec, so a batch of
+    // thumbnails costs one codec instantiation instead of one per frame, and
+    // the codec is released once the batch completes. Frames that could not
+    // be extracted are returned as NULL.
+    status_t getFramesAtTime(
+            const std::vector<int64_t> &timesUs, int option, int colorFormat,
+            std::vector<sp<IMemory> > *frames);
+
 private:
     sp<DataSource> mSource;
     sp<IMediaExtractor> mExtractor;
@@ -63,6 +74,12 @@ private:
 
     sp<FrameDecoder> mDecoder;
     int mLastDecodedIndex;
+    // True if mDecoder is a video decoder that can be retargeted with seek().
+    bool mDecoderSeekable;
+    int mDecoderColorFormat;
+    // True while getFramesAtTime() extracts its frames.
+    bool mInFrameBatch;
+    void releaseDecoder();
     void parseMetaData();
     void parseColorAspects(const sp<MetaData>& meta);
     // Delete album art and clear metadata.
@@ -23,6 +23,7 @@
 #include "StagefrightRecorder.h"
 
 #include <algorithm>
+#include <thread>
 
 #include <android-base/properties.h>
 #include <android/hardware/ICamera.h>
@@ -676,6 +677,20 @@ status_t StagefrightRecorder::setParamTrackTimeStatus(int64_t timeDurationUs) {
     return OK;
 }
 
+status_t StagefrightRecorder::setParamFragmentDuration(int64_t durationUs) {
+    ALOGV("setParamFragmentDuration: %lld us", (long long)durationUs);
+    if (durationUs < 0) {
+        ALOGE("Fragment duration is negative: %lld us", (long long)durationUs);
+        return BAD_VALUE;
+    }
+    if (durationUs > 0 && durationUs < 100000LL) {  // Mostly moof overhead if shorter than 100 ms
+        ALOGE("Fragment duration too short: %lld us", (long long)durationUs);
+        return BAD_VALUE;
+    }
+    mFragmentDurationUs = durationUs;
+    return OK;
+}
+
 status_t StagefrightRecorder::setParamVideoEncoderProfile(int32_t profile) {
     ALOGV("setParamVideoEncoderProfile: %d", profile);
 
@@ -745,6 +760,19 @@ status_t StagefrightRecorder::setParamCaptureFpsEnable(int32_t captureFpsEnable)
     return OK;
 }
 
+status_t StagefrightRecorder::setParamPrepareAhead(int32_t prepareAhead) {
+    ALOGV("setParamPrepareAhead: %d", prepareAhead);
+
+    if (prepareAhead == 0) {
+        mPrepareAhead = false;
+    } else if (prepareAhead == 1) {
+        mPrepareAhead = true;
+    } else {
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
 status_t StagefrightRecorder::setParamCaptureFps(double fps) {
     ALOGV("setParamCaptureFps: %.2f", fps);
 
@@ -819,6 +847,11 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi64(value.string(), &timeDurationUs)) {
             return setParamTrackTimeStatus(timeDurationUs);
         }
+    } else if (key == "param-fragment-duration-us") {
+        int64_t durationUs;
+        if (safe_strtoi64(value.string(), &durationUs)) {
+            return setParamFragmentDuration(durationUs);
+        }
     } else if (key == "audio-param-sampling-rate") {
         int32_t sampling_rate;
         if (safe_strtoi32(value.string(), &sampling_rate)) {
@@ -874,6 +907,11 @@ status_t StagefrightRecorder::setParameter(
         if (safe_strtoi32(value.string(), &timeScale)) {
             return setParamVideoTimeScale(timeScale);
         }
+    } else if (key == "prepare-ahead") {
+        int32_t prepareAhead;
+        if (safe_strtoi32(value.string(), &prepareAhead)) {
+            return setParamPrepareAhead(prepareAhead);
+        }
     } else if (key == "time-lapse-enable") {
         int32_t captureFpsEnable;
         if (safe_strtoi32(value.string(), &captureFpsEnable)) {
@@ -998,6 +1036,13 @@ status_t StagefrightRecorder::prepare() {
     if (mVideoSource == VIDEO_SOURCE_SURFACE) {
         return prepareInternal();
     }
+    if (mPrepareAhead) {
+        // Set up the sources, encoders and writer now rather than in start(),
+        // so that recording starts as soon as it is requested.
+        status_t status = prepareInternal();
+        mPreparedAhead = (status == OK);
+        return status;
+    }
     return OK;
 }
 
@@ -1011,12 +1056,13 @@ status_t StagefrightRecorder::start() {
 
     status_t status = OK;
 
-    if (mVideoSource != VIDEO_SOURCE_SURFACE) {
+    if (mVideoSource != VIDEO_SOURCE_SURFACE && !mPreparedAhead) {
         status = prepareInternal();
         if (status != OK) {
             return status;
         }
     }
+    mPreparedAhead = false;
 
     if (mWriter == NULL) {
         ALOGE("File writer is not avaialble");
@@ -1187,6 +1233,7 @@ sp<MediaCodecSource> StagefrightRecorder::createAudioSource() {
     if (mMetricsItem != NULL) {
         AString audiomime;
         if (format->findString("mime", &audiomime)) {
+            Mutex::Autolock autoLock(mMetricsLock);
             mMetricsItem->setCString(kRecorderAudioMime, audiomime.c_str());
         }
     }
@@ -1708,6 +1755,11 @@ status_t StagefrightRecorder::setupCameraSource(
     mMetaDataStoredInVideoBuffers =
         (*cameraSource)->metaDataStoredInVideoBuffers();
 
+    // Time lapse and slow motion recordings keep using CameraSourceTimeLapse.
+    mCameraToEncoderSurface = (*cameraSource).get() != mCameraSourceTimeLapse.get()
+            && (*cameraSource)->canUseEncoderInputSurface()
+            && ::android::base::GetBoolProperty("media.recorder.camera-to-encoder-surface", true);
+
     return OK;
 }
 
@@ -1748,11 +1800,24 @@ status_t StagefrightRecorder::setupVideoEncoder(
     if (mMetricsItem != NULL) {
         AString videomime;
         if (format->findString("mime", &videomime)) {
+            Mutex::Autolock autoLock(mMetricsLock);
             mMetricsItem->setCString(kRecorderVideoMime, videomime.c_str());
         }
     }
 
-    if (cameraSource != NULL) {
+    if (cameraSource != NULL && mCameraToEncoderSurface) {
+        sp<MetaData> meta = cameraSource->getFormat();
+
+        int32_t width, height;
+        CHECK(meta->findInt32(kKeyWidth, &width));
+        CHECK(meta->findInt32(kKeyHeight, &height));
+
+        format->setInt32("width", width);
+        format->setInt32("height", height);
+        format->setInt32("stride", width);
+        format->setInt32("slice-height", height);
+        format->setInt32("color-format", OMX_COLOR_FormatAndroidOpaque);
+    } else if (cameraSource != NULL) {
         sp<MetaData> meta = cameraSource->getFormat();
 
         int32_t width, height, stride, sliceHeight, colorFormat;
@@ -1852,12 +1917,13 @@ status_t StagefrightRecorder::setupVideoEncoder(
         format->setInt32("android._prefer-b-frames", preferBFrames);
     }
 
-    if (mMetaDataStoredInVideoBuffers != kMetadataBufferTypeInvalid) {
+    if (mMetaDataStoredInVideoBuffers != kMetadataBufferTypeInvalid && !mCameraToEncoderSurface) {
         format->setInt32("android._input-metadata-buffer-type", mMetaDataStoredInVideoBuffers);
     }
 
     uint32_t flags = 0;
-    if (cameraSource == NULL) {
+    if (cameraSource == NULL || mCameraToEncoderSurface) {
+        // The encoder starts and stops a camera source that renders into its surface.
         flags |= MediaCodecSource::FLAG_USE_SURFACE_INPUT;
     } else {
         // require dataspace setup even if not using surface input
@@ -1879,6 +1945,15 @@ status_t StagefrightRecorder::setupVideoEncoder(
 
     if (cameraSource == NULL) {
         mGraphicBufferProducer = encoder->getGraphicBufferProducer();
+    } else if (mCameraToEncoderSurface) {
+        // mCameraToEncoderSurface is only set for a CameraSource.
+        status_t err = static_cast<CameraSource *>(cameraSource.get())->setEncoderInputSurface(
+                encoder->getGraphicBufferProducer());
+        if (err != OK) {
+            cameraSource->stop();
+            return err;
+        }
+        ALOGI("Camera frames are sent to the encoder input surface");
     }
 
     *source = encoder;
@@ -1886,7 +1961,7 @@ status_t StagefrightRecorder::setupVideoEncoder(
     return OK;
 }
 
-status_t StagefrightRecorder::setupAudioEncoder(const sp<MediaWriter>& writer) {
+status_t StagefrightRecorder::checkAudioEncoder() {
     status_t status = BAD_VALUE;
     if (OK != (status = checkAudioEncoderCapabilities())) {
         return status;
@@ -1905,6 +1980,14 @@ status_t StagefrightRecorder::setupAudioEncoder(const sp<MediaWriter>& writer) {
             ALOGE("Unsupported audio encoder: %d", mAudioEncoder);
             return UNKNOWN_ERROR;
     }
+    return OK;
+}
+
+status_t StagefrightRecorder::setupAudioEncoder(const sp<MediaWriter>& writer) {
+    status_t status = checkAudioEncoder();
+    if (status != OK) {
+        return status;
+    }
 
     sp<MediaCodecSource> audioEncoder = createAudioSource();
     if (audioEncoder == NULL) {
@@ -1929,18 +2012,44 @@ status_t StagefrightRecorder::setupMPEG4orWEBMRecording() {
         writer = mp4writer = new MPEG4Writer(mOutputFd);
     }
 
+    // Unless the capture rate changes its sample rate or disables it, the audio
+    // encoder does not depend on the video source. Allocating and configuring it
+    // on another thread, while the camera and the video encoder are set up,
+    // hides most of its setup time.
+    sp<MediaCodecSource> audioEncoder;
+    std::thread audioThread;
+    if (mVideoSource < VIDEO_SOURCE_LIST_END && mAudioSource != AUDIO_SOURCE_CNT
+            && !mCaptureFpsEnable
+            && ::android::base::GetBoolProperty("media.recorder.parallel-setup", true)) {
+        // The audio parameters are final before the video setup, which reads them.
+        err = checkAudioEncoder();
+        if (err != OK) {
+            return err;
+        }
+        audioThread = std::thread([this, &audioEncoder] {
+            audioEncoder = createAudioSource();
+        });
+    }
+    auto joinAudioThread = [&audioThread] {
+        if (audioThread.joinable()) {
+            audioThread.join();
+        }
+    };
+
     if (mVideoSource < VIDEO_SOURCE_LIST_END) {
         setDefaultVideoEncoderIfNecessary();
 
         sp<MediaSource> mediaSource;
         err = setupMediaSource(&mediaSource);
         if (err != OK) {
+            joinAudioThread();
             return err;
         }
 
         sp<MediaCodecSource> encoder;
         err = setupVideoEncoder(mediaSource, &encoder);
         if (err != OK) {
+            joinAudioThread();
             return err;
         }
 
@@ -1954,7 +2063,15 @@ status_t StagefrightRecorder::setupMPEG4orWEBMRecording() {
     // camcorder applications in the recorded files.
     // disable audio for time lapse recording
     const bool disableAudio = mCaptureFpsEnable && mCaptureFps < mFrameRate;
-    if (!disableAudio && mAudioSource != AUDIO_SOURCE_CNT) {
+    if (audioThread.joinable()) {
+        joinAudioThread();
+        if (audioEncoder == NULL) {
+            return UNKNOWN_ERROR;
+        }
+        writer->addSource(audioEncoder);
+        mAudioEncoderSource = audioEncoder;
+        mTotalBitRate += mAudioBitRate;
+    } else if (!disableAudio && mAudioSource != AUDIO_SOURCE_CNT) {
         err = setupAudioEncoder(writer);
         if (err != OK) return err;
         mTotalBitRate += mAudioBitRate;
@@ -2013,6 +2130,9 @@ void StagefrightRecorder::setupMPEG4orWEBMMetaData(sp<MetaData> *meta) {
     if (mOutputFormat == OUTPUT_FORMAT_MPEG_4 || mOutputFormat == OUTPUT_FORMAT_THREE_GPP) {
         (*meta)->setInt32(kKeyEmptyTrackMalFormed, true);
         (*meta)->setInt32(kKey4BitTrackIds, true);
+        if (mFragmentDurationUs > 0) {
+            (*meta)->setInt64(kKeyFragmentDurationUs, mFragmentDurationUs);
+        }
     }
 }
 
@@ -2224,10 +2344,14 @@ status_t StagefrightRecorder::reset() {
     mMaxFileDurationUs = 0;
     mMaxFileSizeBytes = 0;
     mTrackEveryTimeDurationUs = 0;
+    mFragmentDurationUs = 0;
     mCaptureFpsEnable = false;
     mCaptureFps = -1.0;
     mCameraSourceTimeLapse = NULL;
     mMetaDataStoredInVideoBuffers = kMetadataBufferTypeInvalid;
+    mCameraToEncoderSurface = false;
+    mPrepareAhead = false;
+    mPreparedAhead = false;
     mEncoderProfiles = MediaProfiles::getInstance();
     mRotationDegrees = 0;
     mLatitudex10000 = -3600000;
@@ -2380,6 +2504,8 @@ status_t StagefrightRecorder::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     Progress notification: %" PRId64 " us\n", mTrackEveryTimeDurationUs);
     result.append(buffer);
+    snprintf(buffer, SIZE, "     Fragment duration: %" PRId64 " us\n", mFragmentDurationUs);
+    result.append(buffer);
     snprintf(buffer, SIZE, "   Audio\n");
     result.append(buffer);
     snprintf(buffer, SIZE, "     Source: %d\n", mAudioSource);
@@ -92,6 +92,8 @@ private:
     };
 
     mutable Mutex mLock;
+    // Guards mMetricsItem while the audio encoder is created on another thread.
+    Mutex mMetricsLock;
     sp<hardware::ICamera> mCamera;
     sp<ICameraRecordingProxy> mCameraProxy;
     sp<IGraphicBufferProducer> mPreviewSurface;
@@ -133,6 +135,7 @@ private:
     int64_t mMaxFileSizeBytes;
     int64_t mMaxFileDurationUs;
     int64_t mTrackEveryTimeDurationUs;
+    int64_t mFragmentDurationUs;
     int32_t mRotationDegrees;  // Clockwise
     int32_t mLatitudex10000;
     int32_t mLongitudex10000;
@@ -152,6 +155,11 @@ private:
     String8 mParams;
 
     MetadataBufferType mMetaDataStoredInVideoBuffers;
+    // The camera sends its frames straight to the input surface of the encoder.
+    bool mCameraToEncoderSurface;
+    // prepare() sets up camera recordings too, and did so successfully.
+    bool mPrepareAhead;
+    bool mPreparedAhead;
     MediaProfiles *mEncoderProfiles;
 
     int64_t mPauseStartTimeUs;
@@ -193,6 +201,7 @@ private:
     // depending on the videosource type
     status_t setupMediaSource(sp<MediaSource> *mediaSource);
     status_t setupCameraSource(sp<CameraSource> *cameraSource);
+    status_t checkAudioEncoder();
     status_t setupAudioEncoder(const sp<MediaWriter>& writer);
     status_t setupVideoEncoder(const sp<MediaSource>& cameraSource, sp<MediaCodecSource> *source);
 
@@ -204,6 +213,7 @@ private:
     status_t setParamAudioTimeScale(int32_t timeScale);
     status_t setParamCaptureFpsEnable(int32_t timeLapseEnable);
     status_t setParamCaptureFps(double fps);
+    status_t setParamPrepareAhead(int32_t prepareAhead);
     status_t setParamVideoEncodingBitRate(int32_t bitRate);
     status_t setParamVideoIFramesInterval(int32_t seconds);
     status_t setParamVideoEncoderProfile(int32_t profile);
@@ -212,6 +222,7 @@ private:
     status_t setParamVideoTimeScale(int32_t timeScale);
     status_t setParamVideoRotation(int32_t degrees);
     status_t setParamTrackTimeStatus(int64_t timeDurationUs);
+    status_t setParamFragmentDuration(int64_t durationUs);
     status_t setParamInterleaveDuration(int32_t durationUs);
     status_t setParam64BitFileOffset(bool use64BitFileOffset);
     status_t setParamMaxFileDurationUs(int64_t timeUs);
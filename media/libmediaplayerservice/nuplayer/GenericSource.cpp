@@ -21,7 +21,6 @@
 #include "NuPlayerDrm.h"
 
 #include "AnotherPacketSource.h"
-#include <binder/IServiceManager.h>
 #include <cutils/properties.h>
 #include <datasource/PlayerServiceDataSourceFactory.h>
 #include <datasource/PlayerServiceFileSource.h>
@@ -52,6 +51,31 @@ static const int kInitialMarkMs        = 5000;  // 5secs
 //static const int kPausePlaybackMarkMs  = 2000;  // 2secs
 static const int kResumePlaybackMarkMs = 15000;  // 15secs
 
+// Runs the periodic reads of one audio/video track on the track's own looper.
+struct NuPlayer::GenericSource::ReadHandler : public AHandler {
+    explicit ReadHandler(GenericSource *source)
+        : mSource(source) {
+    }
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        Mutex::Autolock _l(mSource->mLock);
+        switch (msg->what()) {
+            case kWhatReadBuffer:
+                mSource->onReadBuffer(msg);
+                break;
+            default:
+                TRESPASS();
+        }
+    }
+
+private:
+    // The source stops this handler's looper before it goes away.
+    GenericSource *mSource;
+
+    DISALLOW_EVIL_CONSTRUCTORS(ReadHandler);
+};
+
 NuPlayer::GenericSource::GenericSource(
         const sp<AMessage> &notify,
         bool uidValid,
@@ -342,6 +366,8 @@ bool NuPlayer::GenericSource::isStreaming() const {
 
 NuPlayer::GenericSource::~GenericSource() {
     ALOGV("~GenericSource");
+    stopReader(&mAudioTrack);
+    stopReader(&mVideoTrack);
     if (mLooper != NULL) {
         mLooper->unregisterHandler(id());
         mLooper->stop();
@@ -359,12 +385,33 @@ void NuPlayer::GenericSource::prepareAsync() {
         mLooper->start();
 
         mLooper->registerHandler(this);
+
+        startReader(&mAudioTrack, "generic-audio");
+        startReader(&mVideoTrack, "generic-video");
     }
 
     sp<AMessage> msg = new AMessage(kWhatPrepareAsync, this);
     msg->post();
 }
 
+void NuPlayer::GenericSource::startReader(Track *track, const char *name) {
+    track->mReadLooper = new ALooper;
+    track->mReadLooper->setName(name);
+    track->mReadLooper->start();
+
+    track->mReadHandler = new ReadHandler(this);
+    track->mReadLooper->registerHandler(track->mReadHandler);
+}
+
+void NuPlayer::GenericSource::stopReader(Track *track) {
+    if (track->mReadLooper != NULL) {
+        track->mReadLooper->unregisterHandler(track->mReadHandler->id());
+        track->mReadLooper->stop();
+        track->mReadLooper.clear();
+        track->mReadHandler.clear();
+    }
+}
+
 void NuPlayer::GenericSource::onPrepareAsync() {
     mDisconnectLock.lock();
     ALOGV("onPrepareAsync: mDataSource: %d", (mDataSource != NULL));
@@ -411,12 +458,10 @@ void NuPlayer::GenericSource::onPrepareAsync() {
             if (property_get_bool("media.stagefright.extractremote", true) &&
                     !PlayerServiceFileSource::requiresDrm(
                             mFd.get(), mOffset, mLength, nullptr /* mime */)) {
-                sp<IBinder> binder =
-                        defaultServiceManager()->getService(String16("media.extractor"));
-                if (binder != nullptr) {
+                sp<IMediaExtractorService> mediaExService =
+                        MediaExtractorFactory::GetExtractorService();
+                if (mediaExService != nullptr) {
                     ALOGD("FileSource remote");
-                    sp<IMediaExtractorService> mediaExService(
-                            interface_cast<IMediaExtractorService>(binder));
                     sp<IDataSource> source;
                     mediaExService->makeIDataSource(base::unique_fd(dup(mFd.get())), mOffset, mLength, &source);
                     ALOGV("IDataSource(FileSource): %p %d %lld %lld",
@@ -664,11 +709,14 @@ void NuPlayer::GenericSource::onMessageReceived(const sp<AMessage> &msg) {
           }
 
 
-          if (track->mSource != NULL) {
-              track->mSource->stop();
+          {
+              Mutex::Autolock _rl(mSourceReadLock);
+              if (track->mSource != NULL) {
+                  track->mSource->stop();
+              }
+              track->mSource = source;
+              track->mSource->start();
           }
-          track->mSource = source;
-          track->mSource->start();
           track->mIndex = trackIndex;
           ++mAudioDataGeneration;
           ++mVideoDataGeneration;
@@ -1044,6 +1092,7 @@ status_t NuPlayer::GenericSource::selectTrack(size_t trackIndex, bool select, in
         if (track == NULL) {
             return INVALID_OPERATION;
         }
+        Mutex::Autolock _rl(mSourceReadLock);
         track->mSource->stop();
         track->mSource = NULL;
         track->mPackets->clear();
@@ -1061,11 +1110,14 @@ status_t NuPlayer::GenericSource::selectTrack(size_t trackIndex, bool select, in
             return OK;
         }
         track->mIndex = trackIndex;
-        if (track->mSource != NULL) {
-            track->mSource->stop();
+        {
+            Mutex::Autolock _rl(mSourceReadLock);
+            if (track->mSource != NULL) {
+                track->mSource->stop();
+            }
+            track->mSource = mSources.itemAt(trackIndex);
+            track->mSource->start();
         }
-        track->mSource = mSources.itemAt(trackIndex);
-        track->mSource->start();
         if (track->mPackets == NULL) {
             track->mPackets = new AnotherPacketSource(track->mSource->getFormat());
         } else {
@@ -1124,9 +1176,11 @@ status_t NuPlayer::GenericSource::seekTo(int64_t seekTimeUs, MediaPlayerSeekMode
     msg->setInt64("seekTimeUs", seekTimeUs);
     msg->setInt32("mode", mode);
 
-    // Need to call readBuffer on |mLooper| to ensure the calls to
-    // IMediaSource::read* are serialized. Note that IMediaSource::read*
-    // is called without |mLock| acquired and MediaSource is not thread safe.
+    // Seeks are performed on |mLooper|. Audio and video are also read on
+    // their own loopers, so calls to IMediaSource::read* are serialized by
+    // |mSourceReadLock| rather than by the looper. Note that
+    // IMediaSource::read* is called without |mLock| acquired and MediaSource
+    // is not thread safe.
     sp<AMessage> response;
     status_t err = msg->postAndAwaitResponse(&response);
     if (err == OK && response != NULL) {
@@ -1307,7 +1361,13 @@ int32_t NuPlayer::GenericSource::getDataGeneration(media_track_type type) const
 void NuPlayer::GenericSource::postReadBuffer(media_track_type trackType) {
     if ((mPendingReadBufferTypes & (1 << trackType)) == 0) {
         mPendingReadBufferTypes |= (1 << trackType);
-        sp<AMessage> msg = new AMessage(kWhatReadBuffer, this);
+        sp<AHandler> handler = this;
+        if (trackType == MEDIA_TRACK_TYPE_AUDIO && mAudioTrack.mReadHandler != NULL) {
+            handler = mAudioTrack.mReadHandler;
+        } else if (trackType == MEDIA_TRACK_TYPE_VIDEO && mVideoTrack.mReadHandler != NULL) {
+            handler = mVideoTrack.mReadHandler;
+        }
+        sp<AMessage> msg = new AMessage(kWhatReadBuffer, handler);
         msg->setInt32("trackType", trackType);
         msg->post();
     }
@@ -1373,6 +1433,10 @@ void NuPlayer::GenericSource::readBuffer(
         status_t err = NO_ERROR;
 
         sp<IMediaSource> source = track->mSource;
+        // Take |mSourceReadLock| before releasing |mLock|, so no seek can bump the
+        // generation and read in between: this read would then take the samples
+        // following the seek target, only to drop them below.
+        mSourceReadLock.lock();
         mLock.unlock();
         if (couldReadMultiple) {
             err = source->readMultiple(
@@ -1384,6 +1448,7 @@ void NuPlayer::GenericSource::readBuffer(
                 mediaBuffers.push_back(mbuf);
             }
         }
+        mSourceReadLock.unlock();
         mLock.lock();
 
         options.clearNonPersistent();
@@ -119,10 +119,18 @@ private:
         kWhatSecureDecodersInstantiated,
     };
 
+    struct ReadHandler;
+
     struct Track {
         size_t mIndex;
         sp<IMediaSource> mSource;
         sp<AnotherPacketSource> mPackets;
+        // Audio and video are read on their own loopers, so the reads of one
+        // track interleave with those of the other rather than waiting for a
+        // whole batch of them. The reads themselves are still serialized by
+        // |mSourceReadLock|.
+        sp<ALooper> mReadLooper;
+        sp<AHandler> mReadHandler;
     };
 
     Vector<sp<IMediaSource> > mSources;
@@ -172,11 +180,18 @@ private:
 
     mutable Mutex mLock;
     mutable Mutex mDisconnectLock; // Protects mDataSource, mHttpSource and mDisconnected
+    // Serializes IMediaSource::read* / start / stop on all tracks. The tracks
+    // are called from |mLooper| and from the read loopers, and share the
+    // extractor and its data source, which are not thread safe.
+    Mutex mSourceReadLock;
 
     sp<ALooper> mLooper;
 
     void resetDataSource();
 
+    void startReader(Track *track, const char *name);
+    void stopReader(Track *track);
+
     status_t initFromDataSource();
     int64_t getLastReadPosition();
 
@@ -137,6 +137,13 @@ sp<MetaData> NuPlayer::HTTPLiveSource::getFormatMeta(bool audio) {
     return meta;
 }
 
+sp<AMessage> NuPlayer::HTTPLiveSource::getStats() const {
+    if (mLiveSession == NULL) {
+        return NULL;
+    }
+    return mLiveSession->getAdaptationStats();
+}
+
 sp<AMessage> NuPlayer::HTTPLiveSource::getFormat(bool audio) {
     sp<MetaData> meta;
     status_t err = -EWOULDBLOCK;
@@ -43,6 +43,7 @@ struct NuPlayer::HTTPLiveSource : public NuPlayer::Source {
 
     virtual status_t dequeueAccessUnit(bool audio, sp<ABuffer> *accessUnit);
     virtual sp<MetaData> getFormatMeta(bool audio);
+    virtual sp<AMessage> getStats() const;
     virtual sp<AMessage> getFormat(bool audio);
 
     virtual status_t feedMoreTSData();
@@ -254,6 +254,13 @@ static bool IsHTTPLiveURL(const char *url) {
     return false;
 }
 
+// Whether video of |format| should be decoded and rendered with the lowest latency,
+// e.g. for game streaming. The source asks for it with "low-latency" in its video format.
+static bool IsLowLatencyVideo(const sp<AMessage> &format) {
+    int32_t lowLatency;
+    return format != NULL && format->findInt32("low-latency", &lowLatency) && lowLatency != 0;
+}
+
 void NuPlayer::setDataSourceAsync(
         const sp<IMediaHTTPService> &httpService,
         const char *url,
@@ -1547,6 +1554,10 @@ void NuPlayer::onStart(int64_t startPositionUs, MediaPlayerSeekMode mode) {
         flags |= Renderer::FLAG_REAL_TIME;
     }
 
+    if (IsLowLatencyVideo(mSource->getFormat(false /* audio */))) {
+        flags |= Renderer::FLAG_LOW_LATENCY;
+    }
+
     bool hasAudio = (mSource->getFormat(true /* audio */) != NULL);
     bool hasVideo = (mSource->getFormat(false /* audio */) != NULL);
     if (!hasAudio && !hasVideo) {
@@ -1936,6 +1947,11 @@ status_t NuPlayer::instantiateDecoder(
         if (rate > 0) {
             format->setFloat("operating-rate", rate * mPlaybackSettings.mSpeed);
         }
+
+        if (IsLowLatencyVideo(format)) {
+            // ask the codec for its low latency mode, see also Renderer::FLAG_LOW_LATENCY
+            format->setInt32("low-latency", 1);
+        }
     }
 
     Mutex::Autolock autoLock(mDecoderLock);
@@ -2250,6 +2266,21 @@ void NuPlayer::getStats(Vector<sp<AMessage> > *trackStats) {
     if (mAudioDecoder != NULL) {
         trackStats->push_back(mAudioDecoder->getStats());
     }
+
+    if (mSource != NULL) {
+        sp<AMessage> sourceStats = mSource->getStats();
+        if (sourceStats != NULL) {
+            trackStats->push_back(sourceStats);
+        }
+    }
+
+    sp<Renderer> renderer = mRenderer;
+    if (renderer != NULL) {
+        sp<AMessage> pacingStats = renderer->getVideoPacingStats();
+        if (pacingStats != NULL) {
+            trackStats->push_back(pacingStats);
+        }
+    }
 }
 
 sp<MetaData> NuPlayer::getFileMeta() {
@@ -33,6 +33,12 @@ namespace android {
 // In CEA-708B, the maximum bandwidth of CC is set to 9600bps.
 static const size_t kMaxBandwithSizeBytes = 9600 / 8;
 
+// While no CC track is selected, access units are parsed only to discover
+// tracks. After this many access units without a new track, only one in
+// kTrackDiscoveryInterval is parsed.
+static const size_t kTrackDiscoveryAccessUnits = 300;
+static const size_t kTrackDiscoveryInterval = 30;
+
 struct CCData {
     CCData(uint8_t type, uint8_t data1, uint8_t data2)
         : mType(type), mData1(data1), mData2(data2) {
@@ -120,7 +126,9 @@ static void dumpBytePair(const sp<ABuffer> &ccBuf) {
 NuPlayer::CCDecoder::CCDecoder(const sp<AMessage> &notify)
     : mNotify(notify),
       mSelectedTrack(-1),
-      mDTVCCPacket(new ABuffer(kMaxBandwithSizeBytes)) {
+      mDTVCCPacket(new ABuffer(kMaxBandwithSizeBytes)),
+      mAccessUnitsWithoutNewTrack(0),
+      mSkippedAccessUnits(0) {
     mDTVCCPacket->setRange(0, 0);
 
     // In CEA-608, streams from packets which have the value 0 of cc_type contain CC1 and CC2, and
@@ -185,6 +193,8 @@ status_t NuPlayer::CCDecoder::selectTrack(size_t index, bool select) {
         }
         ALOGV("selected track %zu", index);
         mSelectedTrack = index;
+        // Start from a clean DTVCC packet in case access units were skipped.
+        mDTVCCPacket->setRange(0, 0);
     } else {
         if (mSelectedTrack != (ssize_t)index) {
             ALOGE("track %zu is not selected", index);
@@ -529,10 +539,22 @@ size_t NuPlayer::CCDecoder::getTrackIndex(
 }
 
 void NuPlayer::CCDecoder::decode(const sp<ABuffer> &accessUnit) {
+    if (!isSelected() && mAccessUnitsWithoutNewTrack >= kTrackDiscoveryAccessUnits) {
+        if (++mSkippedAccessUnits < kTrackDiscoveryInterval) {
+            return;
+        }
+        mSkippedAccessUnits = 0;
+        // A DTVCC packet spans access units; drop what was collected before the gap.
+        mDTVCCPacket->setRange(0, 0);
+    }
+
     if (extractFromMPEGUserData(accessUnit) || extractFromSEI(accessUnit)) {
+        mAccessUnitsWithoutNewTrack = 0;
         sp<AMessage> msg = mNotify->dup();
         msg->setInt32("what", kWhatTrackAdded);
         msg->post();
+    } else if (mAccessUnitsWithoutNewTrack < kTrackDiscoveryAccessUnits) {
+        ++mAccessUnitsWithoutNewTrack;
     }
     // TODO: extract CC from other sources
 }
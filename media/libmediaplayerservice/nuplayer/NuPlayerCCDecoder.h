@@ -75,6 +75,10 @@ private:
     // CEA-708 closed caption
     sp<ABuffer> mDTVCCPacket;
 
+    // Track discovery while no CC track is selected
+    size_t mAccessUnitsWithoutNewTrack;
+    size_t mSkippedAccessUnits;
+
     bool isTrackValid(size_t index) const;
     size_t getTrackIndex(int32_t trackType, size_t channel, bool *trackAdded);
 
@@ -52,6 +52,9 @@ static float kDisplayRefreshingRate = 60.f; // TODO: get this from the display
 // the source.
 static float kDefaultVideoFrameRateTotal = 30.f;
 
+// The most input frames whose queue time is kept to measure the render latency.
+static const size_t kMaxTrackedRenderLatencyFrames = 64;
+
 static inline bool getAudioDeepBufferSetting() {
     return property_get_bool("media.stagefright.audio.deep", false /* default_value */);
 }
@@ -90,7 +93,14 @@ NuPlayer::Decoder::Decoder(
       mNumVideoTemporalLayerAllowed(1),
       mCurrentMaxVideoTemporalLayerId(0),
       mResumePending(false),
-      mComponentName("decoder") {
+      mComponentName("decoder"),
+      mMaxAccessUnitsPerBuffer(1),
+      mHasHeldAccessUnit(false),
+      mHeldAccessUnitStatus(OK),
+      mTrackRenderLatency(false),
+      mNumRenderLatencySamples(0LL),
+      mRenderLatencyTotalUs(0LL),
+      mRenderLatencyMaxUs(0LL) {
     mCodecLooper = new ALooper;
     mCodecLooper->setName("NPDecoder-CL");
     mCodecLooper->start(false, false, ANDROID_PRIORITY_AUDIO);
@@ -113,6 +123,11 @@ sp<AMessage> NuPlayer::Decoder::getStats() {
     mStats->setInt64("frames-dropped-input", mNumInputFramesDropped);
     mStats->setInt64("frames-dropped-output", mNumOutputFramesDropped);
     mStats->setFloat("frame-rate-total", mFrameRateTotal);
+    if (mNumRenderLatencySamples > 0) {
+        mStats->setInt64("render-latency-avg-us",
+                mRenderLatencyTotalUs / mNumRenderLatencySamples);
+        mStats->setInt64("render-latency-max-us", mRenderLatencyMaxUs);
+    }
 
     // make our own copy, so we aren't victim to any later changes.
     sp<AMessage> copiedStats = mStats->dup();
@@ -277,6 +292,12 @@ void NuPlayer::Decoder::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatFramesRendered:
+        {
+            onFramesRendered(msg);
+            break;
+        }
+
         default:
             DecoderBase::onMessageReceived(msg);
             break;
@@ -359,10 +380,21 @@ void NuPlayer::Decoder::onConfigure(const sp<AMessage> &format) {
     }
     rememberCodecSpecificData(format);
 
+    int32_t lowLatency;
+    if (!mIsAudio && format->findInt32("low-latency", &lowLatency) && lowLatency) {
+        mTrackRenderLatency =
+            mCodec->setOnFrameRenderedNotification(new AMessage(kWhatFramesRendered, this)) == OK;
+    }
+
     // the following should work in configured state
     CHECK_EQ((status_t)OK, mCodec->getOutputFormat(&mOutputFormat));
     CHECK_EQ((status_t)OK, mCodec->getInputFormat(&mInputFormat));
 
+    mMaxAccessUnitsPerBuffer = 1;
+    if (mIsAudio && !mIsEncrypted) {
+        mInputFormat->findInt32("max-access-units", &mMaxAccessUnitsPerBuffer);
+    }
+
     {
         Mutex::Autolock autolock(mStatsLock);
         mStats->setString("mime", mime.c_str());
@@ -505,6 +537,7 @@ void NuPlayer::Decoder::doFlush(bool notifyComplete) {
         // we attempt to release the buffers even if flush fails.
     }
     releaseAndResetMediaBuffers();
+    mInputQueuedAtUs.clear();
     mPaused = true;
 }
 
@@ -852,6 +885,8 @@ void NuPlayer::Decoder::releaseAndResetMediaBuffers() {
     mPendingInputMessages.clear();
     mDequeuedInputBuffers.clear();
     mSkipRenderingUntilMediaTimeUs = -1;
+    mHasHeldAccessUnit = false;
+    mHeldAccessUnit.clear();
 }
 
 void NuPlayer::Decoder::requestCodecNotification() {
@@ -872,7 +907,7 @@ status_t NuPlayer::Decoder::fetchInputData(sp<AMessage> &reply) {
     sp<ABuffer> accessUnit;
     bool dropAccessUnit = true;
     do {
-        status_t err = mSource->dequeueAccessUnit(mIsAudio, &accessUnit);
+        status_t err = dequeueAccessUnit(&accessUnit);
 
         if (err == -EWOULDBLOCK) {
             return err;
@@ -949,6 +984,10 @@ status_t NuPlayer::Decoder::fetchInputData(sp<AMessage> &reply) {
                     && mIsVideoAVC
                     && !IsAVCReferenceFrame(accessUnit)) {
                 dropAccessUnit = true;
+            } else if (isSeekPrerollNonReferenceFrame(accessUnit)) {
+                // Nothing depends on this frame and its output would be
+                // discarded anyway, so don't decode it at all.
+                dropAccessUnit = true;
             } else if (haveLayerId && mNumVideoTemporalLayerTotal > 1) {
                 // Add only one layer each time.
                 if (layerId > mCurrentMaxVideoTemporalLayerId + 1
@@ -982,6 +1021,12 @@ status_t NuPlayer::Decoder::fetchInputData(sp<AMessage> &reply) {
          mediaTimeUs / 1E6);
 #endif
 
+    if (mMaxAccessUnitsPerBuffer > 1 && !mIsEncrypted) {
+        size_t bufferIx;
+        CHECK(reply->findSize("buffer-ix", &bufferIx));
+        accessUnit = packAccessUnits(accessUnit, mInputBuffers[bufferIx]->capacity());
+    }
+
     if (mCCDecoder != NULL) {
         mCCDecoder->decode(accessUnit);
     }
@@ -991,6 +1036,87 @@ status_t NuPlayer::Decoder::fetchInputData(sp<AMessage> &reply) {
     return OK;
 }
 
+status_t NuPlayer::Decoder::dequeueAccessUnit(sp<ABuffer> *accessUnit) {
+    if (mHasHeldAccessUnit) {
+        mHasHeldAccessUnit = false;
+        *accessUnit = mHeldAccessUnit;
+        mHeldAccessUnit.clear();
+        return mHeldAccessUnitStatus;
+    }
+    return mSource->dequeueAccessUnit(mIsAudio, accessUnit);
+}
+
+static bool isPackableAccessUnit(const sp<ABuffer> &accessUnit) {
+    int32_t tmp;
+    sp<AMessage> extra;
+    return accessUnit->data() != NULL
+            && !(accessUnit->meta()->findInt32("eos", &tmp) && tmp)
+            && !(accessUnit->meta()->findInt32("csd", &tmp) && tmp)
+            && !accessUnit->meta()->findMessage("extra", &extra);
+}
+
+// Appends the access units that are already available from the source to |first|, up to
+// the number the codec accepts in one buffer and the capacity of that buffer. The first
+// access unit or error that does not fit is held for the next fetch.
+sp<ABuffer> NuPlayer::Decoder::packAccessUnits(const sp<ABuffer> &first, size_t capacity) {
+    if (!isPackableAccessUnit(first)) {
+        return first;
+    }
+
+    std::vector<sp<ABuffer>> accessUnits = { first };
+    size_t size = first->size();
+    while (accessUnits.size() < (size_t)mMaxAccessUnitsPerBuffer) {
+        sp<ABuffer> accessUnit;
+        status_t err = mSource->dequeueAccessUnit(mIsAudio, &accessUnit);
+        if (err == -EWOULDBLOCK) {
+            break;
+        }
+        if (err != OK || !isPackableAccessUnit(accessUnit)
+                || size + accessUnit->size() > capacity) {
+            mHasHeldAccessUnit = true;
+            mHeldAccessUnitStatus = err;
+            mHeldAccessUnit = accessUnit;
+            break;
+        }
+        accessUnits.push_back(accessUnit);
+        size += accessUnit->size();
+    }
+    if (accessUnits.size() == 1) {
+        return first;
+    }
+
+    sp<ABuffer> packed = new ABuffer(size);
+    sp<ABuffer> infos = new ABuffer(accessUnits.size() * sizeof(MediaCodec::AccessUnitInfo));
+    MediaCodec::AccessUnitInfo *info = (MediaCodec::AccessUnitInfo *)infos->data();
+    size_t offset = 0;
+    for (const sp<ABuffer> &accessUnit : accessUnits) {
+        int64_t timeUs;
+        CHECK(accessUnit->meta()->findInt64("timeUs", &timeUs));
+        *info++ = { 0 /* flags */, (uint32_t)accessUnit->size(), timeUs };
+        memcpy(packed->data() + offset, accessUnit->data(), accessUnit->size());
+        offset += accessUnit->size();
+    }
+    int64_t timeUs;
+    CHECK(first->meta()->findInt64("timeUs", &timeUs));
+    packed->meta()->setInt64("timeUs", timeUs);
+    packed->meta()->setBuffer("access-unit-infos", infos);
+    return packed;
+}
+
+bool NuPlayer::Decoder::isSeekPrerollNonReferenceFrame(const sp<ABuffer> &accessUnit) const {
+    if (mSkipRenderingUntilMediaTimeUs < 0 || !mIsVideoAVC) {
+        return false;
+    }
+
+    int64_t timeUs;
+    if (!accessUnit->meta()->findInt64("timeUs", &timeUs)
+            || timeUs >= mSkipRenderingUntilMediaTimeUs) {
+        return false;
+    }
+
+    return !IsAVCReferenceFrame(accessUnit);
+}
+
 bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
     if (mCodec == NULL) {
         ALOGE("[%s] onInputBufferFetched without a valid codec", mComponentName.c_str());
@@ -1073,6 +1199,10 @@ bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
             if (buffer->data() != NULL) {
                 codecBuffer->setRange(0, buffer->size());
                 memcpy(codecBuffer->data(), buffer->data(), buffer->size());
+                sp<ABuffer> accessUnitInfos;
+                if (buffer->meta()->findBuffer("access-unit-infos", &accessUnitInfos)) {
+                    codecBuffer->meta()->setBuffer("access-unit-infos", accessUnitInfos);
+                }
             } else { // No buffer->data()
                 //Modular DRM
                 sp<RefBase> holder;
@@ -1135,12 +1265,48 @@ bool NuPlayer::Decoder::onInputBufferFetched(const sp<AMessage> &msg) {
             handleError(err);
         } else {
             mInputBufferIsDequeued.editItemAt(bufferIx) = false;
+            if (mTrackRenderLatency) {
+                // frames that were never rendered are dropped from the front
+                if (mInputQueuedAtUs.size() >= kMaxTrackedRenderLatencyFrames) {
+                    mInputQueuedAtUs.erase(mInputQueuedAtUs.begin());
+                }
+                mInputQueuedAtUs[timeUs] = ALooper::GetNowUs();
+            }
         }
 
     }   // buffer != NULL
     return true;
 }
 
+void NuPlayer::Decoder::onFramesRendered(const sp<AMessage> &msg) {
+    sp<AMessage> data;
+    CHECK(msg->findMessage("data", &data));
+
+    for (size_t index = 0; ; ++index) {
+        int64_t mediaTimeUs;
+        int64_t systemNano;
+        if (!data->findInt64(AStringPrintf("%zu-media-time-us", index).c_str(), &mediaTimeUs)
+                || !data->findInt64(AStringPrintf("%zu-system-nano", index).c_str(),
+                        &systemNano)) {
+            break;
+        }
+        auto it = mInputQueuedAtUs.find(mediaTimeUs);
+        if (it == mInputQueuedAtUs.end()) {
+            continue;
+        }
+        int64_t latencyUs = systemNano / 1000 - it->second;
+        // earlier frames will not be rendered anymore
+        mInputQueuedAtUs.erase(mInputQueuedAtUs.begin(), ++it);
+        ALOGV("[%s] frame %lld rendered %lld us after queueing",
+                mComponentName.c_str(), (long long)mediaTimeUs, (long long)latencyUs);
+
+        Mutex::Autolock autolock(mStatsLock);
+        ++mNumRenderLatencySamples;
+        mRenderLatencyTotalUs += latencyUs;
+        mRenderLatencyMaxUs = std::max(mRenderLatencyMaxUs, latencyUs);
+    }
+}
+
 void NuPlayer::Decoder::onRenderBuffer(const sp<AMessage> &msg) {
     status_t err;
     int32_t render;
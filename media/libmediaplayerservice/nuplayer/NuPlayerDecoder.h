@@ -17,6 +17,9 @@
 #ifndef NUPLAYER_DECODER_H_
 #define NUPLAYER_DECODER_H_
 
+#include <map>
+#include <vector>
+
 #include "NuPlayer.h"
 
 #include "NuPlayerDecoderBase.h"
@@ -61,6 +64,7 @@ private:
         kWhatSetVideoSurface     = 'sSur',
         kWhatAudioOutputFormatChanged = 'aofc',
         kWhatDrmReleaseCrypto    = 'rDrm',
+        kWhatFramesRendered      = 'frRn',
     };
 
     enum {
@@ -113,6 +117,21 @@ private:
     bool mResumePending;
     AString mComponentName;
 
+    // Audio access units packed into one input buffer, as advertised by the codec.
+    int32_t mMaxAccessUnitsPerBuffer;
+    // The access unit, or error, dequeued from the source that ended the last packed buffer.
+    bool mHasHeldAccessUnit;
+    status_t mHeldAccessUnitStatus;
+    sp<ABuffer> mHeldAccessUnit;
+
+    // In low latency mode, time from queueing an input buffer to the rendering of its frame,
+    // as reported by the codec's FrameRenderTracker.
+    bool mTrackRenderLatency;
+    std::map<int64_t, int64_t> mInputQueuedAtUs;  // media time -> queue time
+    int64_t mNumRenderLatencySamples;
+    int64_t mRenderLatencyTotalUs;
+    int64_t mRenderLatencyMaxUs;
+
     void handleError(int32_t err);
     bool handleAnInputBuffer(size_t index);
     bool handleAnOutputBuffer(
@@ -129,8 +148,13 @@ private:
 
     void doFlush(bool notifyComplete);
     status_t fetchInputData(sp<AMessage> &reply);
+    status_t dequeueAccessUnit(sp<ABuffer> *accessUnit);
+    sp<ABuffer> packAccessUnits(const sp<ABuffer> &first, size_t capacity);
+    // True for a non-reference AVC frame that precedes the accurate-seek target.
+    bool isSeekPrerollNonReferenceFrame(const sp<ABuffer> &accessUnit) const;
     bool onInputBufferFetched(const sp<AMessage> &msg);
     void onRenderBuffer(const sp<AMessage> &msg);
+    void onFramesRendered(const sp<AMessage> &msg);
 
     bool supportsSeamlessFormatChange(const sp<AMessage> &to) const;
     bool supportsSeamlessAudioFormatChange(const sp<AMessage> &targetFormat) const;
@@ -40,6 +40,12 @@ static const int kDumpLockSleepUs = 20000;
 
 namespace android {
 
+// Number of players in the process that decoded their first frame ahead of start(),
+// see KEY_PARAMETER_PRELOAD, and the default limit on it.
+static Mutex sPreloadLock;
+static int32_t sNumPreloadedPlayers = 0;
+static const int32_t kDefaultMaxPreloadedPlayers = 2;
+
 // key for media statistics
 static const char *kKeyPlayer = "nuplayer";
 // attrs for media statistics
@@ -67,6 +73,22 @@ static const char *kPlayerDataSourceType = "android.media.mediaplayer.dataSource
 static const char *kPlayerRebuffering = "android.media.mediaplayer.rebufferingMs";
 static const char *kPlayerRebufferingCount = "android.media.mediaplayer.rebuffers";
 static const char *kPlayerRebufferingAtExit = "android.media.mediaplayer.rebufferExit";
+static const char *kPlayerAbrMode = "android.media.mediaplayer.abr.mode";
+static const char *kPlayerAbrBandwidth = "android.media.mediaplayer.abr.bandwidthKbps";
+static const char *kPlayerAbrVariant = "android.media.mediaplayer.abr.variantKbps";
+static const char *kPlayerAbrUpSwitches = "android.media.mediaplayer.abr.upswitches";
+static const char *kPlayerAbrDownSwitches = "android.media.mediaplayer.abr.downswitches";
+static const char *kPlayerRtspLowLatency = "android.media.mediaplayer.rtsp.lowLatency";
+static const char *kPlayerRtspJitter = "android.media.mediaplayer.rtsp.jitterUs";
+static const char *kPlayerRtspJitterBuffer = "android.media.mediaplayer.rtsp.jitterBufferMs";
+static const char *kPlayerPacingFrames = "android.media.mediaplayer.pacing.frames";
+static const char *kPlayerPacingJudder = "android.media.mediaplayer.pacing.judderFrames";
+static const char *kPlayerPacingPulldown = "android.media.mediaplayer.pacing.pulldownFrames";
+static const char *kPlayerPacingMissed = "android.media.mediaplayer.pacing.missedFrames";
+static const char *kPlayerPacingHistogram = "android.media.mediaplayer.pacing.vsyncsHistogram";
+static const char *kPlayerPacingRefreshRate = "android.media.mediaplayer.pacing.refreshRate";
+static const char *kPlayerPacingPreferredRefreshRate =
+        "android.media.mediaplayer.pacing.preferredRefreshRate";
 
 
 NuPlayerDriver::NuPlayerDriver(pid_t pid)
@@ -89,7 +111,9 @@ NuPlayerDriver::NuPlayerDriver(pid_t pid)
       mClientUid(-1),
       mAtEOS(false),
       mLooping(false),
-      mAutoLoop(false) {
+      mAutoLoop(false),
+      mPreload(false),
+      mPreloaded(false) {
     ALOGD("NuPlayerDriver(%p) created, clientPid(%d)", this, pid);
     mLooper->setName("NuPlayerDriver Looper");
 
@@ -111,6 +135,7 @@ NuPlayerDriver::NuPlayerDriver(pid_t pid)
 NuPlayerDriver::~NuPlayerDriver() {
     ALOGV("~NuPlayerDriver(%p)", this);
     mLooper->stop();
+    releasePreload_l();
 
     // finalize any pending metrics, usually a no-op.
     updateMetrics("destructor");
@@ -337,6 +362,8 @@ status_t NuPlayerDriver::start() {
 }
 
 status_t NuPlayerDriver::start_l() {
+    releasePreload_l();
+
     switch (mState) {
         case STATE_UNPREPARED:
         {
@@ -599,6 +626,62 @@ void NuPlayerDriver::updateMetrics(const char *where) {
             AString name;
             stats->findString("component-name", &name);
 
+            AString abrMode;
+            if (stats->findString("abr-mode", &abrMode)) {
+                int32_t bandwidthBps = -1, variantBps = -1, upSwitches = 0, downSwitches = 0;
+                stats->findInt32("abr-bandwidth-bps", &bandwidthBps);
+                stats->findInt32("abr-variant-bps", &variantBps);
+                stats->findInt32("abr-up-switches", &upSwitches);
+                stats->findInt32("abr-down-switches", &downSwitches);
+
+                mMetricsItem->setCString(kPlayerAbrMode, abrMode.c_str());
+                if (bandwidthBps >= 0) {
+                    mMetricsItem->setInt32(kPlayerAbrBandwidth, bandwidthBps / 1000);
+                }
+                if (variantBps >= 0) {
+                    mMetricsItem->setInt32(kPlayerAbrVariant, variantBps / 1000);
+                }
+                mMetricsItem->setInt32(kPlayerAbrUpSwitches, upSwitches);
+                mMetricsItem->setInt32(kPlayerAbrDownSwitches, downSwitches);
+                continue;
+            }
+
+            int64_t jitterUs;
+            if (stats->findInt64("rtsp-jitter-us", &jitterUs)) {
+                int32_t lowLatency = 0;
+                int64_t jitterBufferUs = 0;
+                stats->findInt32("rtsp-low-latency", &lowLatency);
+                stats->findInt64("rtsp-jitter-buffer-us", &jitterBufferUs);
+
+                mMetricsItem->setInt32(kPlayerRtspLowLatency, lowLatency);
+                mMetricsItem->setInt64(kPlayerRtspJitter, jitterUs);
+                mMetricsItem->setInt64(kPlayerRtspJitterBuffer, (jitterBufferUs + 500) / 1000);
+                continue;
+            }
+
+            int64_t pacingFrames;
+            if (stats->findInt64("pacing-frames", &pacingFrames)) {
+                int64_t judderFrames = 0, pulldownFrames = 0, missedFrames = 0;
+                float refreshRate = 0, preferredRefreshRate = 0;
+                AString histogram;
+                stats->findInt64("pacing-judder-frames", &judderFrames);
+                stats->findInt64("pacing-pulldown-frames", &pulldownFrames);
+                stats->findInt64("pacing-missed-frames", &missedFrames);
+                stats->findString("pacing-vsyncs-histogram", &histogram);
+                stats->findFloat("pacing-refresh-rate", &refreshRate);
+                stats->findFloat("pacing-preferred-refresh-rate", &preferredRefreshRate);
+
+                mMetricsItem->setInt64(kPlayerPacingFrames, pacingFrames);
+                mMetricsItem->setInt64(kPlayerPacingJudder, judderFrames);
+                mMetricsItem->setInt64(kPlayerPacingPulldown, pulldownFrames);
+                mMetricsItem->setInt64(kPlayerPacingMissed, missedFrames);
+                mMetricsItem->setCString(kPlayerPacingHistogram, histogram.c_str());
+                mMetricsItem->setDouble(kPlayerPacingRefreshRate, (double) refreshRate);
+                mMetricsItem->setDouble(
+                        kPlayerPacingPreferredRefreshRate, (double) preferredRefreshRate);
+                continue;
+            }
+
             if (mime.startsWith("video/")) {
                 int32_t width, height;
                 mMetricsItem->setCString(kPlayerVMime, mime.c_str());
@@ -706,6 +789,9 @@ status_t NuPlayerDriver::reset() {
         dump(-1, args);
     }
 
+    mPreload = false;
+    releasePreload_l();
+
     mState = STATE_RESET_IN_PROGRESS;
     mPlayer->resetAsync();
 
@@ -796,11 +882,55 @@ void NuPlayerDriver::setAudioSink(const sp<AudioSink> &audioSink) {
     mAudioSink = audioSink;
 }
 
-status_t NuPlayerDriver::setParameter(
-        int /* key */, const Parcel & /* request */) {
+status_t NuPlayerDriver::setParameter(int key, const Parcel &request) {
+    if (key == KEY_PARAMETER_PRELOAD) {
+        int32_t preload;
+        status_t err = request.readInt32(&preload);
+        if (err != OK) {
+            return err;
+        }
+        Mutex::Autolock autoLock(mLock);
+        mPreload = (preload != 0);
+        if (mPreload && mState == STATE_PREPARED) {
+            preload_l();
+        }
+        return OK;
+    }
     return INVALID_OPERATION;
 }
 
+void NuPlayerDriver::preload_l() {
+    // Nothing to do once the player is started or seeked, which decodes the first frame.
+    if (mPreloaded || mPositionUs >= 0) {
+        return;
+    }
+    {
+        Mutex::Autolock autoLock(sPreloadLock);
+        int32_t maxPreloadedPlayers = property_get_int32(
+                "media.player.max-preloaded", kDefaultMaxPreloadedPlayers);
+        if (sNumPreloadedPlayers >= maxPreloadedPlayers) {
+            ALOGV("preload(%p) skipped, %d players are preloaded", this, sNumPreloadedPlayers);
+            return;
+        }
+        ++sNumPreloadedPlayers;
+    }
+    ALOGV("preload(%p)", this);
+    mPreloaded = true;
+
+    // Like a seek before start(), this instantiates the decoders and decodes up to
+    // the first frame, then pauses.
+    mPlayer->seekToAsync(0, MediaPlayerSeekMode::SEEK_PREVIOUS_SYNC, false /* needNotify */);
+}
+
+void NuPlayerDriver::releasePreload_l() {
+    if (!mPreloaded) {
+        return;
+    }
+    mPreloaded = false;
+    Mutex::Autolock autoLock(sPreloadLock);
+    --sNumPreloadedPlayers;
+}
+
 status_t NuPlayerDriver::getParameter(int key, Parcel *reply) {
 
     if (key == FOURCC('m','t','r','X')) {
@@ -952,6 +1082,37 @@ status_t NuPlayerDriver::dump(
             logString.append(buf);
         }
 
+        AString abrMode;
+        if (stats->findString("abr-mode", &abrMode)) {
+            int32_t bandwidthBps = -1, variantBps = -1, upSwitches = 0, downSwitches = 0;
+            int64_t bufferedUs = -1;
+            stats->findInt32("abr-bandwidth-bps", &bandwidthBps);
+            stats->findInt32("abr-variant-bps", &variantBps);
+            stats->findInt64("abr-buffered-us", &bufferedUs);
+            stats->findInt32("abr-up-switches", &upSwitches);
+            stats->findInt32("abr-down-switches", &downSwitches);
+            snprintf(buf, sizeof(buf), "  abr(%s)\n", abrMode.c_str());
+            logString.append(buf);
+            snprintf(buf, sizeof(buf), "    bandwidthBps(%d), variantBps(%d), bufferedUs(%lld)\n",
+                     bandwidthBps, variantBps, (long long)bufferedUs);
+            logString.append(buf);
+            snprintf(buf, sizeof(buf), "    upSwitches(%d), downSwitches(%d)\n",
+                     upSwitches, downSwitches);
+            logString.append(buf);
+        }
+
+        int64_t jitterUs;
+        if (stats->findInt64("rtsp-jitter-us", &jitterUs)) {
+            int32_t lowLatency = 0;
+            int64_t jitterBufferUs = 0;
+            stats->findInt32("rtsp-low-latency", &lowLatency);
+            stats->findInt64("rtsp-jitter-buffer-us", &jitterBufferUs);
+            snprintf(buf, sizeof(buf), "  rtsp lowLatency(%d), jitterUs(%lld), "
+                     "jitterBufferUs(%lld)\n",
+                     lowLatency, (long long)jitterUs, (long long)jitterBufferUs);
+            logString.append(buf);
+        }
+
         if (mime.startsWith("video/")) {
             int32_t width, height;
             if (stats->findInt32("width", &width)
@@ -972,6 +1133,16 @@ status_t NuPlayerDriver::dump(
                      numFramesTotal == 0
                             ? 0.0 : (double)(numFramesDropped * 100) / numFramesTotal);
             logString.append(buf);
+
+            int64_t renderLatencyAvgUs;
+            int64_t renderLatencyMaxUs;
+            if (stats->findInt64("render-latency-avg-us", &renderLatencyAvgUs)
+                    && stats->findInt64("render-latency-max-us", &renderLatencyMaxUs)) {
+                snprintf(buf, sizeof(buf),
+                         "    renderLatencyAvgUs(%lld), renderLatencyMaxUs(%lld)\n",
+                         (long long)renderLatencyAvgUs, (long long)renderLatencyMaxUs);
+                logString.append(buf);
+            }
         }
     }
 
@@ -1090,6 +1261,9 @@ void NuPlayerDriver::notifyPrepareCompleted(status_t err) {
         // update state before notifying client, so that if client calls back into NuPlayerDriver
         // in response, NuPlayerDriver has the right state
         mState = STATE_PREPARED;
+        if (mPreload) {
+            preload_l();
+        }
         if (mIsAsyncPrepare) {
             notifyListener_l(MEDIA_PREPARED);
         }
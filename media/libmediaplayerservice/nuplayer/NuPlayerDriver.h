@@ -149,12 +149,19 @@ private:
     bool mLooping;
     bool mAutoLoop;
 
+    // KEY_PARAMETER_PRELOAD was set, and the first frame was decoded ahead of start(),
+    // counting against the preloaded players of the process until start() or reset().
+    bool mPreload;
+    bool mPreloaded;
+
 
     void updateMetrics(const char *where);
     void logMetrics(const char *where);
 
     status_t prepare_l();
     status_t start_l();
+    void preload_l();
+    void releasePreload_l();
     void notifyListener_l(int msg, int ext1 = 0, int ext2 = 0, const Parcel *in = NULL);
 
     DISALLOW_EVIL_CONSTRUCTORS(NuPlayerDriver);
@@ -301,6 +301,44 @@ status_t NuPlayer::Renderer::getSyncSettings(AVSyncSettings *sync, float *videoF
     return err;
 }
 
+sp<AMessage> NuPlayer::Renderer::getVideoPacingStats() {
+    sp<AMessage> msg = new AMessage(kWhatGetVideoPacingStats, this);
+    sp<AMessage> response;
+    status_t err = msg->postAndAwaitResponse(&response);
+    if (err != OK || response == NULL) {
+        return NULL;
+    }
+    sp<AMessage> stats;
+    response->findMessage("stats", &stats);
+    return stats;
+}
+
+sp<AMessage> NuPlayer::Renderer::onGetVideoPacingStats() {
+    if (mVideoScheduler == NULL) {
+        return NULL;
+    }
+
+    const VideoFrameSchedulerBase::JudderStats &judder = mVideoScheduler->getJudderStats();
+    if (judder.mFrames == 0) {
+        return NULL;
+    }
+
+    sp<AMessage> stats = new AMessage;
+    stats->setInt64("pacing-frames", judder.mFrames);
+    stats->setInt64("pacing-judder-frames", judder.mJudderFrames);
+    stats->setInt64("pacing-pulldown-frames", judder.mPulldownFrames);
+    stats->setInt64("pacing-missed-frames", judder.mMissedFrames);
+    AString histogram;
+    for (size_t i = 0; i < VideoFrameSchedulerBase::kVsyncHistogramSize; ++i) {
+        histogram.append(i == 0 ? "" : ",");
+        histogram.append((long long)judder.mVsyncsPerFrame[i]);
+    }
+    stats->setString("pacing-vsyncs-histogram", histogram);
+    stats->setFloat("pacing-refresh-rate", 1e9 / mVideoScheduler->getVsyncPeriod());
+    stats->setFloat("pacing-preferred-refresh-rate", mVideoScheduler->getPreferredRefreshRate());
+    return stats;
+}
+
 status_t NuPlayer::Renderer::onGetSyncSettings(
         AVSyncSettings *sync /* nonnull */, float *videoFps /* nonnull */) {
     *sync = mSyncSettings;
@@ -737,6 +775,19 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatGetVideoPacingStats:
+        {
+            sp<AReplyToken> replyID;
+            CHECK(msg->senderAwaitsResponse(&replyID));
+            sp<AMessage> response = new AMessage;
+            sp<AMessage> stats = onGetVideoPacingStats();
+            if (stats != NULL) {
+                response->setMessage("stats", stats);
+            }
+            response->postReply(replyID);
+            break;
+        }
+
         case kWhatFlush:
         {
             onFlush(msg);
@@ -898,7 +949,35 @@ void NuPlayer::Renderer::notifyEOSCallback() {
 }
 
 size_t NuPlayer::Renderer::fillAudioBuffer(void *buffer, size_t size) {
+    int64_t firstAnchorTimeMediaUs;
+    int32_t drainGeneration;
+    size_t sizeCopied = drainAudioQueueToBuffer(
+            buffer, size, &firstAnchorTimeMediaUs, &drainGeneration);
+
+    // Query the sink without |mLock|: this runs on the AudioSink callback thread, and
+    // getPlayedOutDurationUs() may call into the AudioTrack, which would otherwise hold
+    // up the renderer looper.
+    if (firstAnchorTimeMediaUs >= 0) {
+        int64_t nowUs = ALooper::GetNowUs();
+        int64_t playedOutDurationUs = mAudioSink->getPlayedOutDurationUs(nowUs);
+
+        Mutex::Autolock autoLock(mLock);
+        // A flush or seek meanwhile cleared the anchor, don't restore the previous one.
+        if (drainGeneration == mAudioDrainGeneration
+                && firstAnchorTimeMediaUs == mAudioFirstAnchorTimeMediaUs) {
+            // we don't know how much data we are queueing for offloaded tracks.
+            mMediaClock->updateAnchor(
+                    firstAnchorTimeMediaUs + playedOutDurationUs, nowUs, INT64_MAX);
+        }
+    }
+    return sizeCopied;
+}
+
+size_t NuPlayer::Renderer::drainAudioQueueToBuffer(
+        void *buffer, size_t size, int64_t *firstAnchorTimeMediaUs, int32_t *drainGeneration) {
     Mutex::Autolock autoLock(mLock);
+    *firstAnchorTimeMediaUs = -1;
+    *drainGeneration = mAudioDrainGeneration;
 
     if (!mUseAudioCallback) {
         return 0;
@@ -952,13 +1031,7 @@ size_t NuPlayer::Renderer::fillAudioBuffer(void *buffer, size_t size) {
         notifyIfMediaRenderingStarted_l();
     }
 
-    if (mAudioFirstAnchorTimeMediaUs >= 0) {
-        int64_t nowUs = ALooper::GetNowUs();
-        int64_t nowMediaUs =
-            mAudioFirstAnchorTimeMediaUs + mAudioSink->getPlayedOutDurationUs(nowUs);
-        // we don't know how much data we are queueing for offloaded tracks.
-        mMediaClock->updateAnchor(nowMediaUs, nowUs, INT64_MAX);
-    }
+    *firstAnchorTimeMediaUs = mAudioFirstAnchorTimeMediaUs;
 
     // for non-offloaded audio, we need to compute the frames written because
     // there is no EVENT_STREAM_END notification. The frames written gives
@@ -1304,6 +1377,13 @@ void NuPlayer::Renderer::postDrainVideoQueue() {
         return;
     }
 
+    if (mFlags & FLAG_LOW_LATENCY) {
+        // Do not wait for the media clock; onDrainVideoQueue() renders the frame right away.
+        msg->post();
+        mDrainVideoQueuePending = true;
+        return;
+    }
+
     int64_t nowUs = ALooper::GetNowUs();
     if (mFlags & FLAG_REAL_TIME) {
         int64_t realTimeUs;
@@ -1416,7 +1496,8 @@ void NuPlayer::Renderer::onDrainVideoQueue() {
     }
 
     // Always render the first video frame while keeping stats on A/V sync.
-    if (!mVideoSampleReceived) {
+    // In low latency mode, render every frame now and never drop late ones.
+    if (!mVideoSampleReceived || (mFlags & FLAG_LOW_LATENCY)) {
         realTimeUs = nowUs;
         tooLate = false;
     }
@@ -36,6 +36,8 @@ struct NuPlayer::Renderer : public AHandler {
     enum Flags {
         FLAG_REAL_TIME = 1,
         FLAG_OFFLOAD_AUDIO = 2,
+        // render each video frame as soon as it is decoded, without A/V sync
+        FLAG_LOW_LATENCY = 4,
     };
     Renderer(const sp<MediaPlayerBase::AudioSink> &sink,
              const sp<MediaClock> &mediaClock,
@@ -74,6 +76,9 @@ struct NuPlayer::Renderer : public AHandler {
     status_t getCurrentPosition(int64_t *mediaUs);
     int64_t getVideoLateByUs();
 
+    // Returns video frame pacing statistics, or NULL if there is no video.
+    sp<AMessage> getVideoPacingStats();
+
     status_t openAudioSink(
             const sp<AMessage> &format,
             bool offloadOnly,
@@ -134,6 +139,7 @@ private:
         kWhatDisableOffloadAudio = 'noOA',
         kWhatEnableOffloadAudio  = 'enOA',
         kWhatSetVideoFrameRate   = 'sVFR',
+        kWhatGetVideoPacingStats = 'gVPS',
     };
 
     // if mBuffer != nullptr, it's a buffer containing real data.
@@ -236,6 +242,10 @@ private:
 
     void notifyEOSCallback();
     size_t fillAudioBuffer(void *buffer, size_t size);
+    // Copies queued audio into |buffer| under |mLock|; returns the anchor media
+    // time and the drain generation for the clock update done by fillAudioBuffer().
+    size_t drainAudioQueueToBuffer(void *buffer, size_t size,
+            int64_t *firstAnchorTimeMediaUs, int32_t *drainGeneration);
 
     bool onDrainAudioQueue();
     void drainAudioQueueUntilLastEOS();
@@ -270,6 +280,7 @@ private:
     void onPause();
     void onResume();
     void onSetVideoFrameRate(float fps);
+    sp<AMessage> onGetVideoPacingStats();
     int32_t getQueueGeneration(bool audio);
     int32_t getDrainGeneration(bool audio);
     bool getSyncQueues();
@@ -92,6 +92,9 @@ struct NuPlayer::Source : public AHandler {
     virtual sp<MetaData> getFormatMeta(bool /* audio */) { return NULL; }
     virtual sp<MetaData> getFileFormatMeta() const { return NULL; }
 
+    // Source specific statistics for dumpsys and metrics, or NULL.
+    virtual sp<AMessage> getStats() const { return NULL; }
+
     virtual status_t dequeueAccessUnit(
             bool audio, sp<ABuffer> *accessUnit) = 0;
 
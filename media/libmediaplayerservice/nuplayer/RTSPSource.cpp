@@ -27,6 +27,7 @@
 #include <media/IMediaHTTPService.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaData.h>
+#include <media/stagefright/foundation/AUtils.h>
 
 namespace android {
 
@@ -38,6 +39,11 @@ static const int kPrepareMarkMs     =  3000;  // 3 seconds
 //static const int kStartServerMarkMs =  5000;
 static const int kOverflowMarkMs    = 10000;  // 10 seconds
 
+// In low latency mode, the data buffered before playback starts or resumes
+// covers this many times the measured jitter, plus a minimum.
+static const int64_t kJitterBufferFactor = 4;
+static const int64_t kMinJitterBufferUs = 100000LL;  // 100 ms
+
 NuPlayer::RTSPSource::RTSPSource(
         const sp<AMessage> &notify,
         const sp<IMediaHTTPService> &httpService,
@@ -59,6 +65,7 @@ NuPlayer::RTSPSource::RTSPSource(
       mBuffering(false),
       mInPreparationPhase(true),
       mEOSPending(false),
+      mJitterUs(0),
       mSeekGeneration(0),
       mEOSTimeoutAudio(0),
       mEOSTimeoutVideo(0) {
@@ -175,6 +182,15 @@ bool NuPlayer::RTSPSource::haveSufficientDataOnAllTracks() {
 
     static const int64_t kMinDurationUs = 2000000LL;
 
+    // unless the initial mark asks for low latency, then only enough to
+    // absorb the jitter.
+    int64_t minDurationUs = kMinDurationUs;
+    if (isLowLatency()) {
+        Mutex::Autolock _l(mBufferingSettingsLock);
+        minDurationUs = max((int64_t)mBufferingSettings.mInitialMarkMs * 1000,
+                getJitterBufferUs());
+    }
+
     int64_t mediaDurationUs = 0;
     getDuration(&mediaDurationUs);
     if ((mAudioTrack != NULL && mAudioTrack->isFinished(mediaDurationUs))
@@ -186,7 +202,7 @@ bool NuPlayer::RTSPSource::haveSufficientDataOnAllTracks() {
     int64_t durationUs;
     if (mAudioTrack != NULL
             && (durationUs = mAudioTrack->getBufferedDurationUs(&err))
-                    < kMinDurationUs
+                    < minDurationUs
             && err == OK) {
         ALOGV("audio track doesn't have enough data yet. (%.2f secs buffered)",
               durationUs / 1E6);
@@ -195,7 +211,7 @@ bool NuPlayer::RTSPSource::haveSufficientDataOnAllTracks() {
 
     if (mVideoTrack != NULL
             && (durationUs = mVideoTrack->getBufferedDurationUs(&err))
-                    < kMinDurationUs
+                    < minDurationUs
             && err == OK) {
         ALOGV("video track doesn't have enough data yet. (%.2f secs buffered)",
               durationUs / 1E6);
@@ -205,6 +221,29 @@ bool NuPlayer::RTSPSource::haveSufficientDataOnAllTracks() {
     return true;
 }
 
+bool NuPlayer::RTSPSource::isLowLatency() const {
+    // An initial mark below the underflow mark cannot be honored with the
+    // default marks, it asks for a live view with as little delay as possible.
+    Mutex::Autolock _l(mBufferingSettingsLock);
+    return mBufferingSettings.mInitialMarkMs < kUnderflowMarkMs;
+}
+
+int64_t NuPlayer::RTSPSource::getJitterBufferUs() const {
+    Mutex::Autolock _l(mJitterLock);
+    return min(kJitterBufferFactor * mJitterUs + kMinJitterBufferUs,
+            (int64_t)kUnderflowMarkMs * 1000);
+}
+
+sp<AMessage> NuPlayer::RTSPSource::getStats() const {
+    sp<AMessage> stats = new AMessage;
+    stats->setInt32("rtsp-low-latency", isLowLatency());
+    stats->setInt64("rtsp-jitter-buffer-us", getJitterBufferUs());
+
+    Mutex::Autolock _l(mJitterLock);
+    stats->setInt64("rtsp-jitter-us", mJitterUs);
+    return stats;
+}
+
 status_t NuPlayer::RTSPSource::dequeueAccessUnit(
         bool audio, sp<ABuffer> *accessUnit) {
     if (!stopBufferingIfNecessary()) {
@@ -335,6 +374,11 @@ void NuPlayer::RTSPSource::checkBuffering(
     size_t preparedCount, underflowCount, overflowCount, startCount, finishedCount;
     preparedCount = underflowCount = overflowCount = startCount = finishedCount = 0;
 
+    int64_t underflowMarkUs = kUnderflowMarkMs * 1000LL;
+    if (isLowLatency()) {
+        underflowMarkUs = getJitterBufferUs() / 2;
+    }
+
     size_t count = numTracks;
     for (size_t i = 0; i < count; ++i) {
         status_t finalResult;
@@ -366,7 +410,7 @@ void NuPlayer::RTSPSource::checkBuffering(
             ++finishedCount;
         } else {
             // TODO: redefine kUnderflowMarkMs to a fair value,
-            if (bufferedDurationUs < kUnderflowMarkMs * 1000) {
+            if (bufferedDurationUs < underflowMarkUs) {
                 ++underflowCount;
             }
             if (bufferedDurationUs > maxRebufferingMarkUs) {
@@ -715,6 +759,30 @@ void NuPlayer::RTSPSource::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case MyHandler::kWhatJitterUpdate:
+        {
+            size_t trackIndex;
+            CHECK(msg->findSize("trackIndex", &trackIndex));
+
+            int64_t jitterUs;
+            CHECK(msg->findInt64("jitterUs", &jitterUs));
+
+            if (trackIndex >= mTracks.size()) {
+                break;
+            }
+            mTracks.editItemAt(trackIndex).mJitterUs = jitterUs;
+
+            int64_t maxJitterUs = 0;
+            for (size_t i = 0; i < mTracks.size(); ++i) {
+                maxJitterUs = max(maxJitterUs, mTracks[i].mJitterUs);
+            }
+            ALOGV("track %zu jitter %lld us", trackIndex, (long long)jitterUs);
+
+            Mutex::Autolock _l(mJitterLock);
+            mJitterUs = maxJitterUs;
+            break;
+        }
+
         case SDPLoader::kWhatSDPLoaded:
         {
             onSDPLoaded(msg);
@@ -754,6 +822,7 @@ void NuPlayer::RTSPSource::onConnected() {
         info.mRTPTime = 0;
         info.mNormalPlaytimeUs = 0LL;
         info.mNPTMappingValid = false;
+        info.mJitterUs = 0;
 
         if ((isAudio && mAudioTrack == NULL)
                 || (isVideo && mVideoTrack == NULL)) {
@@ -57,6 +57,8 @@ struct NuPlayer::RTSPSource : public NuPlayer::Source {
             int64_t seekTimeUs,
             MediaPlayerSeekMode mode = MediaPlayerSeekMode::SEEK_PREVIOUS_SYNC) override;
 
+    virtual sp<AMessage> getStats() const;
+
     void onMessageReceived(const sp<AMessage> &msg);
 
 protected:
@@ -92,6 +94,7 @@ private:
         uint32_t mRTPTime;
         int64_t mNormalPlaytimeUs;
         bool mNPTMappingValid;
+        int64_t mJitterUs;
     };
 
     sp<IMediaHTTPService> mHTTPService;
@@ -109,9 +112,13 @@ private:
     bool mInPreparationPhase;
     bool mEOSPending;
 
-    Mutex mBufferingSettingsLock;
+    mutable Mutex mBufferingSettingsLock;
     BufferingSettings mBufferingSettings;
 
+    // Largest RTP interarrival jitter of the tracks.
+    mutable Mutex mJitterLock;
+    int64_t mJitterUs;
+
     sp<ALooper> mLooper;
     sp<MyHandler> mHandler;
     sp<SDPLoader> mSDPLoader;
@@ -147,6 +154,8 @@ private:
     void onPollBuffering();
 
     bool haveSufficientDataOnAllTracks();
+    bool isLowLatency() const;
+    int64_t getJitterBufferUs() const;
 
     void setEOSTimeout(bool audio, int64_t timeout);
     void setError(status_t err);
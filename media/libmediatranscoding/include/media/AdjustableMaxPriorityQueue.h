@@ -19,6 +19,7 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <vector>
@@ -32,8 +33,8 @@ namespace android {
  * AdjustableMaxPriorityQueue is a wrapper template around the STL's *_heap() functions.
  * - Internally, it uses a std::vector<T> to store elements in a heap order.
  * - Support adjusting item's priority while maintaining the heap property.
- * - Support removing any item in the heap while maintaining the heap property. Note that the
- *   removal complexity will be O(n) in worst case.
+ * - Support removing any item in the heap while maintaining the heap property. The removal
+ *   complexity is O(log n).
  * - AdjustableMaxPriorityQueue needs T::operator<() at instantiation time
  */
 template <class T, class Comparator = std::less<T>>
@@ -86,6 +87,13 @@ class AdjustableMaxPriorityQueue {
      */
     void rebuild();
 
+    /*
+     * Restore the heap property after changing the value of the single item at pos. This is
+     * cheaper than rebuild() when only one item's priority has been adjusted.
+     * NOTE: The iterator pos will change after calling adjust().
+     */
+    void adjust(iterator pos);
+
     /*
      * Iterators used for accessing and changing the priority.
      * If you change the value of items through these access iterators BE SURE to call rebuild() to
@@ -110,6 +118,9 @@ class AdjustableMaxPriorityQueue {
     /* Implementation shared by both public push() methods. */
     template <class Arg>
     bool pushInternal(Arg&& item);
+
+    /* Moves the item at index up or down until the heap property is restored. */
+    void siftInternal(size_t index);
 };
 
 template <class T, class Comparator>
@@ -204,12 +215,47 @@ void AdjustableMaxPriorityQueue<T, Comparator>::rebuild() {
     std::make_heap(mHeap.begin(), mHeap.end(), Comparator());
 }
 
-// Remove a random element from a AdjustableMaxPriorityQueue.
+// Complexity of this: Up to twice logarithmic in the size of the heap.
+template <class T, class Comparator>
+void AdjustableMaxPriorityQueue<T, Comparator>::siftInternal(size_t index) {
+    Comparator comp;
+    if (index > 0 && comp(mHeap[(index - 1) / 2], mHeap[index])) {
+        // Larger than the parent, the prefix up to index is still a heap so push_heap sifts up.
+        std::push_heap(mHeap.begin(), mHeap.begin() + index + 1, comp);
+        return;
+    }
+    const size_t size = mHeap.size();
+    for (size_t child = 2 * index + 1; child < size; child = 2 * index + 1) {
+        if (child + 1 < size && comp(mHeap[child], mHeap[child + 1])) {
+            ++child;
+        }
+        if (!comp(mHeap[index], mHeap[child])) {
+            break;
+        }
+        std::swap(mHeap[index], mHeap[child]);
+        index = child;
+    }
+}
+
+template <class T, class Comparator>
+void AdjustableMaxPriorityQueue<T, Comparator>::adjust(iterator pos) {
+    DCHECK(!mHeap.empty());
+    siftInternal(pos - mHeap.begin());
+}
+
+// Remove a random element from a AdjustableMaxPriorityQueue by moving the last element into its
+// slot and sifting it, instead of shifting the storage and rebuilding the whole heap.
 template <class T, class Comparator>
 void AdjustableMaxPriorityQueue<T, Comparator>::erase(iterator pos) {
     DCHECK(!mHeap.empty());
-    mHeap.erase(pos);
-    rebuild();
+    const size_t index = pos - mHeap.begin();
+    if (index + 1 != mHeap.size()) {
+        *pos = std::move(mHeap.back());
+        mHeap.pop_back();
+        siftInternal(index);
+    } else {
+        mHeap.pop_back();
+    }
 }
 
 }  // namespace android
@@ -222,6 +222,31 @@ TEST(AdjustableMaxPriorityQueueTest, TestErasingItem) {
     EXPECT_TRUE(heap.empty());
 }
 
+TEST(AdjustableMaxPriorityQueueTest, TestAdjustingItem) {
+    AdjustableMaxPriorityQueue<int> heap;
+    for (int value = 0; value < 10; ++value) {
+        EXPECT_TRUE(heap.push(value));
+    }
+
+    // Lower the top item, then raise an item from the bottom of the heap.
+    auto top = heap.begin();
+    *top = -1;
+    heap.adjust(top);
+    EXPECT_EQ(8, heap.top());
+
+    auto last = heap.end() - 1;
+    *last = 20;
+    heap.adjust(last);
+    EXPECT_EQ(20, heap.top());
+
+    // The heap must pop in non-increasing order.
+    int previous = heap.top();
+    while (!heap.empty()) {
+        EXPECT_GE(previous, heap.top());
+        previous = heap.consume_top();
+    }
+}
+
 // Test the heap property and make sure it is the same as std::priority_queue.
 TEST(AdjustableMaxPriorityQueueTest, TranscodingJobTest) {
     // Test data structure that mimics the Transcoding job.
@@ -75,6 +75,30 @@ ssize_t AudioStreamOutSink::write(const void *buffer, size_t count)
     }
 }
 
+status_t AudioStreamOutSink::obtainWriteBuffer(size_t count, void **buffer)
+{
+    if (!mNegotiated) {
+        *buffer = nullptr;
+        return NEGOTIATE;
+    }
+    return mStream->obtainWriteBuffer(count * mFrameSize, buffer);
+}
+
+ssize_t AudioStreamOutSink::commitWriteBuffer(size_t count)
+{
+    ALOG_ASSERT(mNegotiated);
+    size_t written;
+    status_t ret = mStream->commitWriteBuffer(count * mFrameSize, &written);
+    if (ret == OK && written > 0) {
+        written /= mFrameSize;
+        mFramesWritten += written;
+        return written;
+    } else {
+        ALOGE_IF(ret != OK, "Error while committing data to HAL: %d", ret);
+        return ret;
+    }
+}
+
 status_t AudioStreamOutSink::getTimestamp(ExtendedTimestamp &timestamp)
 {
     uint64_t position64;
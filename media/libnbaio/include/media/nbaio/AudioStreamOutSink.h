@@ -48,6 +48,11 @@ public:
 
     virtual ssize_t write(const void *buffer, size_t count);
 
+    // Zero-copy alternative to write(), see StreamOutHalInterface::obtainWriteBuffer().
+    // The count is in frames and commitWriteBuffer() returns frames written or an error.
+    status_t obtainWriteBuffer(size_t count, void **buffer);
+    ssize_t commitWriteBuffer(size_t count);
+
     virtual status_t getTimestamp(ExtendedTimestamp &timestamp);
 
     // NBAIO_Sink end
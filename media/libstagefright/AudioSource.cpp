@@ -17,6 +17,8 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
+#include <algorithm>
+
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AudioSource"
 #include <utils/Log.h>
@@ -58,6 +60,7 @@ AudioSource::AudioSource(
     : mStarted(false),
       mSampleRate(sampleRate),
       mOutSampleRate(outSampleRate > 0 ? outSampleRate : sampleRate),
+      mBufferGroup(NULL),
       mTrackMaxAmplitude(false),
       mStartTimeUs(0),
       mStopSystemTimeUs(-1),
@@ -69,12 +72,20 @@ AudioSource::AudioSource(
       mNumFramesSkipped(0),
       mNumFramesLost(0),
       mNumClientOwnedBuffers(0),
-      mNoMoreFramesToRead(false) {
+      mNoMoreFramesToRead(false),
+      mPendingBuffer(NULL),
+      mPendingTimeUs(0),
+      mPendingStartFrame(0) {
     ALOGV("sampleRate: %u, outSampleRate: %u, channelCount: %u",
             sampleRate, outSampleRate, channelCount);
     CHECK(channelCount == 1 || channelCount == 2);
     CHECK(sampleRate > 0);
 
+    size_t bufferFrames =
+            ((int64_t)sampleRate * kMinBufferDurationUs / 1000000LL + kBufferFrameAlignment - 1)
+            / kBufferFrameAlignment * kBufferFrameAlignment;
+    mBufferSize = bufferFrames * sizeof(int16_t) * channelCount;
+
     size_t minFrameCount;
     status_t status = AudioRecord::getMinFrameCount(&minFrameCount,
                                            sampleRate,
@@ -114,6 +125,8 @@ AudioSource::AudioSource(
         mInitCheck = mRecord->initCheck();
         if (mInitCheck != OK) {
             mRecord.clear();
+        } else {
+            mBufferGroup = new MediaBufferGroup(kMinBufferCount, mBufferSize, kMaxBufferCount);
         }
     } else {
         mInitCheck = status;
@@ -124,6 +137,8 @@ AudioSource::~AudioSource() {
     if (mStarted) {
         reset();
     }
+    delete mBufferGroup;
+    mBufferGroup = NULL;
 }
 
 status_t AudioSource::initCheck() const {
@@ -161,7 +176,7 @@ status_t AudioSource::start(MetaData *params) {
 
 void AudioSource::releaseQueuedFrames_l() {
     ALOGV("releaseQueuedFrames_l");
-    List<MediaBuffer *>::iterator it;
+    List<MediaBufferBase *>::iterator it;
     while (!mBuffersReceived.empty()) {
         it = mBuffersReceived.begin();
         (*it)->release();
@@ -194,6 +209,10 @@ status_t AudioSource::reset() {
     mRecord->stop();
     waitOutstandingEncodingFrames_l();
     releaseQueuedFrames_l();
+    if (mPendingBuffer != NULL) {
+        mPendingBuffer->release();
+        mPendingBuffer = NULL;
+    }
 
     return OK;
 }
@@ -208,7 +227,7 @@ sp<MetaData> AudioSource::getFormat() {
     meta->setCString(kKeyMIMEType, MEDIA_MIMETYPE_AUDIO_RAW);
     meta->setInt32(kKeySampleRate, mSampleRate);
     meta->setInt32(kKeyChannelCount, mRecord->channelCount());
-    meta->setInt32(kKeyMaxInputSize, kMaxBufferSize);
+    meta->setInt32(kKeyMaxInputSize, mBufferSize);
     meta->setInt32(kKeyPcmEncoding, kAudioEncodingPcm16bit);
 
     return meta;
@@ -264,11 +283,12 @@ status_t AudioSource::read(
     if (!mStarted) {
         return OK;
     }
-    MediaBuffer *buffer = *mBuffersReceived.begin();
+    MediaBufferBase *buffer = *mBuffersReceived.begin();
     mBuffersReceived.erase(mBuffersReceived.begin());
     ++mNumClientOwnedBuffers;
+    // The buffer goes back to mBufferGroup in signalBufferReturned().
+    buffer->setObserver(NULL);
     buffer->setObserver(this);
-    buffer->add_ref();
 
     // Mute/suppress the recording sound
     int64_t timeUs;
@@ -322,8 +342,9 @@ void AudioSource::signalBufferReturned(MediaBufferBase *buffer) {
     ALOGV("signalBufferReturned: %p", buffer->data());
     Mutex::Autolock autoLock(mLock);
     --mNumClientOwnedBuffers;
-    buffer->setObserver(0);
-    buffer->release();
+    buffer->setObserver(NULL);
+    buffer->setObserver(mBufferGroup);
+    mBufferGroup->signalBufferReturned(buffer);
     mFrameEncodingCompletionCondition.signal();
     return;
 }
@@ -334,7 +355,21 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
     ExtendedTimestamp::Location location;
     const int32_t usPerSec = 1000000;
 
-    if (mRecord->getTimestamp(&ts) == OK &&
+    Mutex::Autolock autoLock(mLock);
+    if (!mStarted) {
+        ALOGW("Spurious callback from AudioRecord. Drop the audio data.");
+        return OK;
+    }
+
+    const size_t bufferSize = audioBuffer.size;
+    const size_t frameSize = mRecord->frameSize();
+
+    if (mPendingBuffer != NULL) {
+        // Only the period that starts a buffer reads the audio timestamp and the
+        // lost frames, the time of the next ones follows from the frames since then.
+        timeUs = mPendingTimeUs +
+                (mNumFramesReceived - mPendingStartFrame) * usPerSec / mSampleRate;
+    } else if (mRecord->getTimestamp(&ts) == OK &&
             ts.getBestTimestamp(&position, &timeNs, ExtendedTimestamp::TIMEBASE_MONOTONIC,
             &location) == OK) {
         // Use audio timestamp.
@@ -352,18 +387,11 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
     }
 
     ALOGV("dataCallbackTimestamp: %" PRId64 " us", timeUs);
-    Mutex::Autolock autoLock(mLock);
-    if (!mStarted) {
-        ALOGW("Spurious callback from AudioRecord. Drop the audio data.");
-        return OK;
-    }
-
-    const size_t bufferSize = audioBuffer.size;
 
     // Drop retrieved and previously lost audio data.
     if (mNumFramesReceived == 0 && timeUs < mStartTimeUs) {
         (void) mRecord->getInputFramesLost();
-        int64_t receievedFrames = bufferSize / mRecord->frameSize();
+        int64_t receievedFrames = bufferSize / frameSize;
         ALOGV("Drop audio data(%" PRId64 " frames) at %" PRId64 "/%" PRId64 " us",
                 receievedFrames, timeUs, mStartTimeUs);
         mNumFramesSkipped += receievedFrames;
@@ -373,6 +401,9 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
     if (mStopSystemTimeUs != -1 && timeUs >= mStopSystemTimeUs) {
         ALOGV("Drop Audio frame at %lld  stop time: %lld us",
                 (long long)timeUs, (long long)mStopSystemTimeUs);
+        if (mPendingBuffer != NULL) {
+            queuePendingBuffer_l();
+        }
         mNoMoreFramesToRead = true;
         mFrameAvailableCondition.signal();
         return OK;
@@ -389,10 +420,10 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
     mLastFrameTimestampUs = timeUs;
 
     uint64_t numLostBytes = 0; // AudioRecord::getInputFramesLost() returns uint32_t
-    if (mNumFramesReceived > 0) {  // Ignore earlier frame lost
+    if (mNumFramesReceived > 0 && mPendingBuffer == NULL) {  // Ignore earlier frame lost
         // getInputFramesLost() returns the number of lost frames.
         // Convert number of frames lost to number of bytes lost.
-        numLostBytes = (uint64_t)mRecord->getInputFramesLost() * mRecord->frameSize();
+        numLostBytes = (uint64_t)mRecord->getInputFramesLost() * frameSize;
     }
 
     CHECK_EQ(numLostBytes & 1, 0u);
@@ -401,21 +432,8 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
         // Loss of audio frames should happen rarely; thus the LOGW should
         // not cause a logging spam
         ALOGW("Lost audio record data: %" PRIu64 " bytes", numLostBytes);
-    }
-
-    while (numLostBytes > 0) {
-        uint64_t bufferSize = numLostBytes;
-        if (numLostBytes > kMaxBufferSize) {
-            numLostBytes -= kMaxBufferSize;
-            bufferSize = kMaxBufferSize;
-        } else {
-            numLostBytes = 0;
-        }
-        MediaBuffer *lostAudioBuffer = new MediaBuffer(bufferSize);
-        memset(lostAudioBuffer->data(), 0, bufferSize);
-        lostAudioBuffer->set_range(0, bufferSize);
-        mNumFramesLost += bufferSize / mRecord->frameSize();
-        queueInputBuffer_l(lostAudioBuffer, timeUs);
+        mNumFramesLost += numLostBytes / frameSize;
+        appendFrames_l(NULL, numLostBytes, timeUs);
     }
 
     if (audioBuffer.size == 0) {
@@ -423,27 +441,58 @@ status_t AudioSource::dataCallback(const AudioRecord::Buffer& audioBuffer) {
         return OK;
     }
 
-    MediaBuffer *buffer = new MediaBuffer(bufferSize);
-    memcpy((uint8_t *) buffer->data(),
-            audioBuffer.i16, audioBuffer.size);
-    buffer->set_range(0, bufferSize);
-    queueInputBuffer_l(buffer, timeUs);
+    appendFrames_l((const uint8_t *) audioBuffer.i16, bufferSize, timeUs);
     return OK;
 }
 
-void AudioSource::queueInputBuffer_l(MediaBuffer *buffer, int64_t timeUs) {
-    const size_t bufferSize = buffer->range_length();
+void AudioSource::appendFrames_l(const uint8_t *data, size_t size, int64_t timeUs) {
     const size_t frameSize = mRecord->frameSize();
-    if (mNumFramesReceived == 0) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (mPendingBuffer == NULL) {
+            if (mBufferGroup->acquire_buffer(
+                    &mPendingBuffer, true /* nonBlocking */, mBufferSize) != OK) {
+                // The encoder is behind, grow the group rather than drop audio.
+                ALOGW("All %zu audio buffers are in use, adding one", mBufferGroup->buffers());
+                mPendingBuffer = new MediaBuffer(mBufferSize);
+                mBufferGroup->add_buffer(mPendingBuffer);
+                mPendingBuffer->add_ref();
+            }
+            mPendingBuffer->set_range(0, 0);
+            mPendingTimeUs = timeUs + (int64_t)(offset / frameSize) * 1000000LL / mSampleRate;
+            mPendingStartFrame = mNumFramesReceived;
+        }
+
+        const size_t length = mPendingBuffer->range_length();
+        const size_t copySize = std::min(size - offset, mBufferSize - length);
+        uint8_t *dst = (uint8_t *) mPendingBuffer->data() + length;
+        if (data != NULL) {
+            memcpy(dst, data + offset, copySize);
+        } else {
+            memset(dst, 0, copySize);
+        }
+        mPendingBuffer->set_range(0, length + copySize);
+        mNumFramesReceived += copySize / frameSize;
+        offset += copySize;
+
+        if (length + copySize == mBufferSize) {
+            queuePendingBuffer_l();
+        }
+    }
+}
+
+void AudioSource::queuePendingBuffer_l() {
+    MediaBufferBase *buffer = mPendingBuffer;
+    mPendingBuffer = NULL;
+    if (mPendingStartFrame == 0) {
         buffer->meta_data().setInt64(kKeyAnchorTime, mStartTimeUs);
     }
-    mNumFramesReceived += bufferSize / frameSize;
     const int64_t timestampUs =
                 mStartTimeUs +
                     ((1000000LL * mNumFramesReceived) +
                         (mSampleRate >> 1)) / mSampleRate;
     buffer->meta_data().setInt64(kKeyTime, mPrevSampleTimeUs);
-    buffer->meta_data().setInt64(kKeyDriftTime, timeUs - mInitialReadTimeUs);
+    buffer->meta_data().setInt64(kKeyDriftTime, mPendingTimeUs - mInitialReadTimeUs);
     mPrevSampleTimeUs = timestampUs;
     mBuffersReceived.push_back(buffer);
     mFrameAvailableCondition.signal();
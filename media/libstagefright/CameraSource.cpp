@@ -740,7 +740,14 @@ status_t CameraSource::startCameraRecording() {
     int64_t token = IPCThreadState::self()->clearCallingIdentity();
     status_t err;
 
-    if (mVideoBufferMode == hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE) {
+    if (mEncoderInputSurface != nullptr) {
+        err = mCamera->setVideoTarget(mEncoderInputSurface);
+        if (err != OK) {
+            ALOGE("%s: Failed to set encoder input surface as video target: %s (err=%d)",
+                    __FUNCTION__, strerror(-err), err);
+            return err;
+        }
+    } else if (mVideoBufferMode == hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE) {
         // Initialize buffer queue.
         err = initBufferQueue(mVideoSize.width, mVideoSize.height, mEncoderFormat,
                 (android_dataspace_t)mEncoderDataSpace,
@@ -942,6 +949,7 @@ status_t CameraSource::reset() {
 
     mVideoBufferConsumer.clear();
     mVideoBufferProducer.clear();
+    mEncoderInputSurface.clear();
     releaseCamera();
 
     ALOGD("reset: X");
@@ -1445,6 +1453,21 @@ MetadataBufferType CameraSource::metaDataStoredInVideoBuffers() const {
     }
 }
 
+bool CameraSource::canUseEncoderInputSurface() const {
+    return mVideoBufferMode == hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE;
+}
+
+status_t CameraSource::setEncoderInputSurface(const sp<IGraphicBufferProducer>& surface) {
+    ALOGV("setEncoderInputSurface");
+    if (mStarted || !canUseEncoderInputSurface() || surface == nullptr) {
+        ALOGE("%s: Cannot use encoder input surface (started %d, buffer mode %d)",
+                __FUNCTION__, mStarted, mVideoBufferMode);
+        return INVALID_OPERATION;
+    }
+    mEncoderInputSurface = surface;
+    return OK;
+}
+
 CameraSource::ProxyListener::ProxyListener(const sp<CameraSource>& source) {
     mSource = source;
 }
@@ -15,6 +15,8 @@
  */
 
 #include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
 
 //#define LOG_NDEBUG 0
 #define LOG_TAG "CameraSourceTimeLapse"
@@ -29,6 +31,7 @@
 #include <media/stagefright/MetaData.h>
 #include <camera/Camera.h>
 #include <camera/CameraParameters.h>
+#include <cutils/properties.h>
 #include <utils/String8.h>
 #include <utils/Vector.h>
 
@@ -81,6 +84,7 @@ CameraSourceTimeLapse::CameraSourceTimeLapse(
                 storeMetaDataInVideoBuffers),
       mTimeBetweenTimeLapseVideoFramesUs(1E6/videoFrameRate),
       mLastTimeLapseFrameRealTimestampUs(0),
+      mCaptureIntervalToleranceUs(0),
       mSkipCurrentFrame(false) {
 
     mTimeBetweenFrameCaptureUs = timeBetweenFrameCaptureUs;
@@ -169,6 +173,78 @@ bool CameraSourceTimeLapse::trySettingVideoSize(
     return isSuccessful;
 }
 
+void CameraSourceTimeLapse::trySettingCaptureFpsRange() {
+    ALOGV("trySettingCaptureFpsRange");
+    mCaptureIntervalToleranceUs = 0;
+    if (mTimeBetweenFrameCaptureUs <= mTimeBetweenTimeLapseVideoFramesUs + 1
+            || !property_get_bool("media.camera.timelapse.hw-paced", true)) {
+        return;
+    }
+
+    int64_t token = IPCThreadState::self()->clearCallingIdentity();
+    CameraParameters params(mCamera->getParameters());
+    const char *supportedRanges = params.get(CameraParameters::KEY_SUPPORTED_PREVIEW_FPS_RANGE);
+    int currentMin = -1, currentMax = -1;
+    params.getPreviewFpsRange(&currentMin, &currentMax);
+
+    // The ranges are in frames per 1000 seconds, as "(min,max),(min,max)".
+    const int64_t captureFps1000 = (1000000000LL + mTimeBetweenFrameCaptureUs - 1)
+            / mTimeBetweenFrameCaptureUs;
+    int bestMin = -1, bestMax = -1;
+    for (const char *p = supportedRanges; p != NULL && (p = strchr(p, '(')) != NULL; ++p) {
+        int min, max;
+        if (sscanf(p, "(%d,%d)", &min, &max) != 2 || min > max || max < captureFps1000) {
+            continue;
+        }
+        // Prefer a fixed range among those with the same maximum.
+        if (bestMax < 0 || max < bestMax || (max == bestMax && min > bestMin)) {
+            bestMin = min;
+            bestMax = max;
+        }
+    }
+
+    const char *range = params.get(CameraParameters::KEY_PREVIEW_FPS_RANGE);
+    if (range != NULL && bestMax > 0 && bestMax < currentMax) {
+        String8 originalRange(range);
+        params.set(CameraParameters::KEY_PREVIEW_FPS_RANGE,
+                String8::format("%d,%d", bestMin, bestMax).string());
+        if (mCamera->setParameters(params.flatten()) == OK) {
+            ALOGI("time lapse capture paced by the camera at %d-%d fps/1000 (was %d-%d)",
+                    bestMin, bestMax, currentMin, currentMax);
+            mOriginalFpsRange = originalRange;
+            mCaptureIntervalToleranceUs = 500000000LL / bestMax;
+        } else {
+            ALOGW("Failed to set preview fps range %d,%d, skipping frames instead",
+                    bestMin, bestMax);
+        }
+    }
+    IPCThreadState::self()->restoreCallingIdentity(token);
+}
+
+status_t CameraSourceTimeLapse::startCameraRecording() {
+    ALOGV("startCameraRecording");
+    trySettingCaptureFpsRange();
+    return CameraSource::startCameraRecording();
+}
+
+void CameraSourceTimeLapse::stopCameraRecording() {
+    ALOGV("stopCameraRecording");
+    CameraSource::stopCameraRecording();
+    if (mOriginalFpsRange.isEmpty() || mCamera == 0) {
+        return;
+    }
+
+    int64_t token = IPCThreadState::self()->clearCallingIdentity();
+    CameraParameters params(mCamera->getParameters());
+    params.set(CameraParameters::KEY_PREVIEW_FPS_RANGE, mOriginalFpsRange.string());
+    if (mCamera->setParameters(params.flatten()) != OK) {
+        ALOGW("Failed to restore preview fps range %s", mOriginalFpsRange.string());
+    }
+    IPCThreadState::self()->restoreCallingIdentity(token);
+    mOriginalFpsRange.clear();
+    mCaptureIntervalToleranceUs = 0;
+}
+
 void CameraSourceTimeLapse::signalBufferReturned(MediaBufferBase* buffer) {
     ALOGV("signalBufferReturned");
     Mutex::Autolock autoLock(mQuickStopLock);
@@ -298,7 +374,8 @@ bool CameraSourceTimeLapse::skipFrameAndModifyTimeStamp(int64_t *timestampUs) {
     // The first 2 output frames from the encoder are: decoder specific info and
     // the compressed video frame data for the first input video frame.
     if (mNumFramesEncoded >= 1 && *timestampUs <
-        (mLastTimeLapseFrameRealTimestampUs + mTimeBetweenFrameCaptureUs) &&
+        (mLastTimeLapseFrameRealTimestampUs + mTimeBetweenFrameCaptureUs
+                - mCaptureIntervalToleranceUs) &&
         (mTimeBetweenFrameCaptureUs > mTimeBetweenTimeLapseVideoFramesUs + 1)) {
         // Skip all frames from last encoded frame until
         // sufficient time (mTimeBetweenFrameCaptureUs) has passed.
@@ -19,14 +19,19 @@
 
 #include "include/FrameDecoder.h"
 #include "include/FrameCaptureLayer.h"
+#include <algorithm>
+#include <thread>
+
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
+#include <cutils/properties.h>
 #include <mediadrm/ICrypto.h>
 #include <media/IMediaSource.h>
 #include <media/MediaCodecBuffer.h>
 #include <media/stagefright/foundation/avc_utils.h>
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/ColorUtils.h>
@@ -298,6 +303,7 @@ status_t FrameDecoder::init(
         return err;
     }
     mDecoder = decoder;
+    mCodecFormat = videoFormat;
 
     return OK;
 }
@@ -314,9 +320,51 @@ sp<IMemory> FrameDecoder::extractFrame(FrameRect *rect) {
     return mFrameMemory;
 }
 
+status_t FrameDecoder::seek(int64_t frameTimeUs, int option) {
+    if (mDecoder == NULL) {
+        return NO_INIT;
+    }
+
+    status_t err = onSeek(frameTimeUs, option, &mReadOptions);
+    if (err != OK) {
+        return err;
+    }
+
+    // The codec may have consumed an EOS for the previous frame, flush so that
+    // it accepts the samples of the new target.
+    err = mDecoder->flush();
+    if (err != OK) {
+        ALOGW("flush returned error %d (%s)", err, asString(err));
+        return err;
+    }
+    mHaveMoreInputs = true;
+    mFirstSample = true;
+    mFrameMemory.clear();
+
+    return OK;
+}
+
+status_t FrameDecoder::readSample(MediaBufferBase **buffer) {
+    status_t err = mSource->read(buffer, &mReadOptions);
+    mReadOptions.clearSeekTo();
+    return err;
+}
+
 status_t FrameDecoder::extractInternal() {
     status_t err = OK;
     bool done = false;
+    if (mFirstSample && mHaveMoreInputs) {
+        err = onDecodeAllSamples(&done);
+        if (err != OK || done) {
+            mHaveMoreInputs = false;
+            mFirstSample = false;
+            if (err != OK) {
+                ALOGE("failed to decode samples (err %d)", err);
+            }
+            return err;
+        }
+    }
+
     size_t retriesLeft = kRetryCount;
     do {
         size_t index;
@@ -344,8 +392,7 @@ status_t FrameDecoder::extractInternal() {
 
             MediaBufferBase *mediaBuffer = NULL;
 
-            err = mSource->read(&mediaBuffer, &mReadOptions);
-            mReadOptions.clearSeekTo();
+            err = readSample(&mediaBuffer);
             if (err != OK) {
                 mHaveMoreInputs = false;
                 if (!mFirstSample && err == ERROR_END_OF_STREAM) {
@@ -456,6 +503,7 @@ VideoFrameDecoder::VideoFrameDecoder(
         const sp<IMediaSource> &source)
     : FrameDecoder(componentName, trackMeta, source),
       mFrame(NULL),
+      mNextFrameMemory(0),
       mIsAvcOrHevc(false),
       mSeekMode(MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC),
       mTargetTimeUs(-1LL),
@@ -482,16 +530,7 @@ sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
     mIsAvcOrHevc = !strcasecmp(mime, MEDIA_MIMETYPE_VIDEO_AVC)
             || !strcasecmp(mime, MEDIA_MIMETYPE_VIDEO_HEVC);
 
-    if (frameTimeUs < 0) {
-        int64_t thumbNailTime = -1ll;
-        if (!trackMeta()->findInt64(kKeyThumbnailTime, &thumbNailTime)
-                || thumbNailTime < 0) {
-            thumbNailTime = 0;
-        }
-        options->setSeekTo(thumbNailTime, mSeekMode);
-    } else {
-        options->setSeekTo(frameTimeUs, mSeekMode);
-    }
+    setSeekTo(frameTimeUs, options);
 
     sp<AMessage> videoFormat;
     if (convertMetaDataToMessage(trackMeta(), &videoFormat) != OK) {
@@ -506,9 +545,7 @@ sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
     // For the thumbnail extraction case, try to allocate single buffer in both
     // input and output ports, if seeking to a sync frame. NOTE: This request may
     // fail if component requires more than that for decoding.
-    bool isSeekingClosest = (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST)
-            || (mSeekMode == MediaSource::ReadOptions::SEEK_FRAME_INDEX);
-    if (!isSeekingClosest) {
+    if (!isSeekingClosest()) {
         videoFormat->setInt32("android._num-input-buffers", 1);
         videoFormat->setInt32("android._num-output-buffers", 1);
     }
@@ -532,18 +569,65 @@ sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
     return videoFormat;
 }
 
+status_t VideoFrameDecoder::onSeek(
+        int64_t frameTimeUs, int seekMode,
+        MediaSource::ReadOptions *options) {
+    MediaSource::ReadOptions::SeekMode mode =
+            static_cast<MediaSource::ReadOptions::SeekMode>(seekMode);
+    if (mode < MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC ||
+            mode > MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+        ALOGE("Unknown seek mode: %d", mode);
+        return ERROR_UNSUPPORTED;
+    }
+
+    // Buffer counts were negotiated for the seek mode given to init(), moving
+    // between sync and closest seeking needs a newly configured codec.
+    bool wasSeekingClosest = isSeekingClosest();
+    mSeekMode = mode;
+    if (isSeekingClosest() != wasSeekingClosest) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    mTargetTimeUs = -1LL;
+    mSampleDurations.clear();
+    // Leave the previous frames to the caller, they may still be in use.
+    mFrame = NULL;
+    for (size_t i = 0; i < kFrameMemoryCount; ++i) {
+        mFrameMemories[i].clear();
+    }
+    mNextFrameMemory = 0;
+    setSeekTo(frameTimeUs, options);
+    return OK;
+}
+
+bool VideoFrameDecoder::isSeekingClosest() const {
+    return (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST)
+            || (mSeekMode == MediaSource::ReadOptions::SEEK_FRAME_INDEX);
+}
+
+void VideoFrameDecoder::setSeekTo(
+        int64_t frameTimeUs, MediaSource::ReadOptions *options) {
+    if (frameTimeUs < 0) {
+        int64_t thumbNailTime = -1ll;
+        if (!trackMeta()->findInt64(kKeyThumbnailTime, &thumbNailTime)
+                || thumbNailTime < 0) {
+            thumbNailTime = 0;
+        }
+        options->setSeekTo(thumbNailTime, mSeekMode);
+    } else {
+        options->setSeekTo(frameTimeUs, mSeekMode);
+    }
+}
+
 status_t VideoFrameDecoder::onInputReceived(
         const sp<MediaCodecBuffer> &codecBuffer,
         MetaDataBase &sampleMeta, bool firstSample, uint32_t *flags) {
-    bool isSeekingClosest = (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST)
-            || (mSeekMode == MediaSource::ReadOptions::SEEK_FRAME_INDEX);
-
-    if (firstSample && isSeekingClosest) {
+    if (firstSample && isSeekingClosest()) {
         sampleMeta.findInt64(kKeyTargetTime, &mTargetTimeUs);
         ALOGV("Seeking closest: targetTimeUs=%lld", (long long)mTargetTimeUs);
     }
 
-    if (mIsAvcOrHevc && !isSeekingClosest
+    if (mIsAvcOrHevc && !isSeekingClosest()
             && IsIDR(codecBuffer->data(), codecBuffer->size())) {
         // Only need to decode one IDR frame, unless we're seeking with CLOSEST
         // option, in which case we need to actually decode to targetTimeUs.
@@ -607,8 +691,10 @@ status_t VideoFrameDecoder::onOutputReceived(
         crop_bottom = height - 1;
     }
 
-    if (mFrame == NULL) {
-        sp<IMemory> frameMem = allocVideoFrame(
+    sp<IMemory> &frameMem = mFrameMemories[mNextFrameMemory];
+    mNextFrameMemory = (mNextFrameMemory + 1) % kFrameMemoryCount;
+    if (frameMem == NULL) {
+        frameMem = allocVideoFrame(
                 trackMeta(),
                 (crop_right - crop_left + 1),
                 (crop_bottom - crop_top + 1),
@@ -616,10 +702,9 @@ status_t VideoFrameDecoder::onOutputReceived(
                 0,
                 dstBpp(),
                 mCaptureLayer != nullptr /*allocRotated*/);
-        mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
-
-        setFrame(frameMem);
     }
+    mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+    setFrame(frameMem);
 
     mFrame->mDurationUs = durationUs;
 
@@ -725,7 +810,9 @@ ImageDecoder::ImageDecoder(
       mTileWidth(0),
       mTileHeight(0),
       mTilesDecoded(0),
-      mTargetTiles(0) {
+      mTargetTiles(0),
+      mDecodeRegion(false),
+      mRegion{0, 0, 0, 0} {
 }
 
 sp<AMessage> ImageDecoder::onGetFormatAndSeekOptions(
@@ -831,8 +918,27 @@ status_t ImageDecoder::onExtractRect(FrameRect *rect) {
     }
     if (rect->left != 0 || rect->top != expectedTop
             || rect->right != mWidth || rect->bottom != expectedBot) {
-        ALOGE("currently only support sequential decoding of slices");
-        return ERROR_UNSUPPORTED;
+        // Any other rect is decoded at once, from the tiles it intersects.
+        if (mTilesDecoded > 0 || mDecodeRegion) {
+            ALOGE("currently only support sequential decoding of slices");
+            return ERROR_UNSUPPORTED;
+        }
+        if (rect->left < 0 || rect->top < 0 || rect->left >= rect->right
+                || rect->top >= rect->bottom
+                || rect->right > mWidth || rect->bottom > mHeight) {
+            ALOGE("region {%d, %d, %d, %d} out of %dx%d picture",
+                    rect->left, rect->top, rect->right, rect->bottom, mWidth, mHeight);
+            return ERROR_UNSUPPORTED;
+        }
+        mDecodeRegion = true;
+        mRegion = *rect;
+        mTargetTiles = 0;
+        for (int32_t i = 0; i < mGridRows * mGridCols; ++i) {
+            if (tileInRegion(i)) {
+                ++mTargetTiles;
+            }
+        }
+        return OK;
     }
 
     // advance one row
@@ -847,11 +953,226 @@ status_t ImageDecoder::onOutputReceived(
         return ERROR_MALFORMED;
     }
 
-    int32_t width, height, stride;
-    CHECK(outputFormat->findInt32("width", &width));
-    CHECK(outputFormat->findInt32("height", &height));
-    CHECK(outputFormat->findInt32("stride", &stride));
+    allocFrame();
+
+    int32_t tileIndex = mTilesDecoded;
+    *done = (++mTilesDecoded >= mTargetTiles);
+
+    return convertTile(videoFrameBuffer, outputFormat, tileIndex);
+}
+
+status_t ImageDecoder::onDecodeAllSamples(bool *done) {
+    *done = false;
+
+    // Slices are decoded one row of tiles at a time on the primary codec.
+    const int32_t tiles = mGridRows * mGridCols;
+    if (tiles <= 1 || (!mDecodeRegion && mTargetTiles < tiles)) {
+        return OK;
+    }
+    std::vector<int32_t> tileIndices;
+    for (int32_t i = 0; i < tiles; ++i) {
+        if (!mDecodeRegion || tileInRegion(i)) {
+            tileIndices.push_back(i);
+        }
+    }
+    if (tileIndices.empty()) {
+        return OK;
+    }
+    int32_t maxCodecs = property_get_int32("media.stagefright.thumbnail.grid_codecs", 1);
+    size_t codecCount = std::min((size_t)std::max(maxCodecs, 1), tileIndices.size());
+    // A region skips the tiles outside of it even on the primary codec alone.
+    if (codecCount <= 1 && !mDecodeRegion) {
+        return OK;
+    }
+
+    // The tiles are independent pictures of the same size, so every extra
+    // instance of the component takes a share of them. The component may not
+    // have the resources for all the instances we ask for, use what we get.
+    std::vector<sp<ALooper> > loopers;
+    std::vector<sp<MediaCodec> > codecs{decoder()};
+    while (codecs.size() < codecCount) {
+        status_t err;
+        sp<ALooper> looper = new ALooper;
+        looper->start();
+        sp<MediaCodec> codec = MediaCodec::CreateByComponentName(
+                looper, componentName(), &err);
+        if (codec == NULL || err != OK) {
+            break;
+        }
+        err = codec->configure(codecFormat(), NULL /* surface */, NULL /* crypto */, 0);
+        if (err == OK) {
+            err = codec->start();
+        }
+        if (err != OK) {
+            codec->release();
+            break;
+        }
+        loopers.push_back(looper);
+        codecs.push_back(codec);
+    }
+    ALOGV("decoding %zu of %d tiles on %zu instances of %s",
+            tileIndices.size(), tiles, codecs.size(), componentName().c_str());
+    if (codecs.size() <= 1 && !mDecodeRegion) {
+        return OK;
+    }
+
+    status_t err = OK;
+    std::vector<sp<ABuffer> > samples;
+    // The image track can't seek by tile, but there is no need to read past
+    // the last tile we decode.
+    while (samples.size() <= (size_t)tileIndices.back()) {
+        MediaBufferBase *mediaBuffer = NULL;
+        err = readSample(&mediaBuffer);
+        if (err != OK) {
+            break;
+        }
+        sp<ABuffer> sample = new ABuffer(mediaBuffer->range_length());
+        memcpy(sample->data(),
+                (const uint8_t*)mediaBuffer->data() + mediaBuffer->range_offset(),
+                mediaBuffer->range_length());
+        mediaBuffer->release();
+        samples.push_back(sample);
+    }
+    if (err == ERROR_END_OF_STREAM && !samples.empty()) {
+        err = OK;
+    }
+
+    if (err == OK) {
+        allocFrame();
+
+        // Tiles are written to disjoint rects of the frame, the instances
+        // don't need to synchronize with each other.
+        std::vector<status_t> results(codecs.size(), OK);
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < codecs.size(); ++i) {
+            workers.emplace_back([this, &codecs, &samples, &tileIndices, &results, i] {
+                results[i] = decodeTiles(codecs[i], samples, tileIndices, i, codecs.size());
+            });
+        }
+        results[0] = decodeTiles(codecs[0], samples, tileIndices, 0, codecs.size());
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        for (status_t result : results) {
+            if (result != OK) {
+                err = result;
+            }
+        }
+    }
+
+    for (size_t i = 1; i < codecs.size(); ++i) {
+        codecs[i]->release();
+    }
+
+    if (err == OK) {
+        mTilesDecoded = samples.size();
+        *done = true;
+    }
+    return err;
+}
+
+bool ImageDecoder::tileInRegion(int32_t tileIndex) const {
+    int32_t left = tileIndex % mGridCols * mTileWidth;
+    int32_t top = tileIndex / mGridCols * mTileHeight;
+    return left < mRegion.right && left + mTileWidth > mRegion.left
+            && top < mRegion.bottom && top + mTileHeight > mRegion.top;
+}
+
+status_t ImageDecoder::decodeTiles(
+        const sp<MediaCodec> &codec, const std::vector<sp<ABuffer> > &tiles,
+        const std::vector<int32_t> &tileIndices, size_t first, size_t step) {
+    size_t pending = 0;
+    for (size_t i = first; i < tileIndices.size(); i += step) {
+        if ((size_t)tileIndices[i] < tiles.size()) {
+            ++pending;
+        }
+    }
 
+    sp<AMessage> outputFormat;
+    size_t next = first;
+    bool eosQueued = false;
+    size_t retriesLeft = kRetryCount;
+    while (pending > 0) {
+        size_t index;
+        while (!eosQueued && codec->dequeueInputBuffer(&index, 0) == OK) {
+            if (next >= tileIndices.size() || (size_t)tileIndices[next] >= tiles.size()) {
+                // flush out the last tiles of a reordering decoder
+                codec->queueInputBuffer(index, 0, 0, 0, MediaCodec::BUFFER_FLAG_EOS);
+                eosQueued = true;
+                break;
+            }
+            sp<MediaCodecBuffer> codecBuffer;
+            status_t err = codec->getInputBuffer(index, &codecBuffer);
+            if (err != OK) {
+                ALOGE("failed to get input buffer %zu", index);
+                return err;
+            }
+            const int32_t tileIndex = tileIndices[next];
+            const sp<ABuffer> &tile = tiles[tileIndex];
+            if (tile->size() > codecBuffer->capacity()) {
+                ALOGE("buffer size (%zu) too large for codec input size (%zu)",
+                        tile->size(), codecBuffer->capacity());
+                return BAD_VALUE;
+            }
+            memcpy(codecBuffer->data(), tile->data(), tile->size());
+            codecBuffer->setRange(0, tile->size());
+            // the tile index is the timestamp, to place the output in the frame
+            err = codec->queueInputBuffer(index, 0, tile->size(), tileIndex, 0);
+            if (err != OK) {
+                return err;
+            }
+            next += step;
+        }
+
+        size_t offset, size;
+        int64_t ptsUs;
+        uint32_t flags;
+        status_t err = codec->dequeueOutputBuffer(
+                &index, &offset, &size, &ptsUs, &flags, kBufferTimeOutUs);
+        if (err == INFO_FORMAT_CHANGED) {
+            err = codec->getOutputFormat(&outputFormat);
+            if (err != OK) {
+                return err;
+            }
+            continue;
+        } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            continue;
+        } else if (err == -EAGAIN /* INFO_TRY_AGAIN_LATER */) {
+            if (--retriesLeft == 0) {
+                ALOGE("timed out waiting for tiles, %zu left", pending);
+                return TIMED_OUT;
+            }
+            continue;
+        } else if (err != OK) {
+            ALOGW("Received error %d (%s) instead of output", err, asString(err));
+            return err;
+        }
+        retriesLeft = kRetryCount;
+
+        if (size > 0 && ptsUs >= 0 && (size_t)ptsUs < tiles.size()) {
+            sp<MediaCodecBuffer> tileBuffer;
+            err = codec->getOutputBuffer(index, &tileBuffer);
+            if (err == OK) {
+                err = outputFormat == NULL ? ERROR_MALFORMED
+                        : convertTile(tileBuffer, outputFormat, (int32_t)ptsUs);
+            } else {
+                ALOGE("failed to get output buffer %zu", index);
+            }
+            --pending;
+        }
+        codec->releaseOutputBuffer(index);
+        if (err != OK) {
+            return err;
+        }
+        if ((flags & MediaCodec::BUFFER_FLAG_EOS) && pending > 0) {
+            ALOGE("decoder reached EOS with %zu tiles left", pending);
+            return ERROR_MALFORMED;
+        }
+    }
+    return OK;
+}
+
+void ImageDecoder::allocFrame() {
     if (mFrame == NULL) {
         sp<IMemory> frameMem = allocVideoFrame(
                 trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp());
@@ -859,6 +1180,15 @@ status_t ImageDecoder::onOutputReceived(
 
         setFrame(frameMem);
     }
+}
+
+status_t ImageDecoder::convertTile(
+        const sp<MediaCodecBuffer> &tileBuffer,
+        const sp<AMessage> &outputFormat, int32_t tileIndex) {
+    int32_t width, height, stride;
+    CHECK(outputFormat->findInt32("width", &width));
+    CHECK(outputFormat->findInt32("height", &height));
+    CHECK(outputFormat->findInt32("stride", &stride));
 
     int32_t srcFormat;
     CHECK(outputFormat->findInt32("color-format", &srcFormat));
@@ -889,8 +1219,8 @@ status_t ImageDecoder::onOutputReceived(
     crop_height = crop_bottom - crop_top + 1;
 
     int32_t dstLeft, dstTop, dstRight, dstBottom;
-    dstLeft = mTilesDecoded % mGridCols * crop_width;
-    dstTop = mTilesDecoded / mGridCols * crop_height;
+    dstLeft = tileIndex % mGridCols * crop_width;
+    dstTop = tileIndex / mGridCols * crop_height;
     dstRight = dstLeft + crop_width - 1;
     dstBottom = dstTop + crop_height - 1;
 
@@ -905,11 +1235,9 @@ status_t ImageDecoder::onOutputReceived(
         dstBottom = mHeight - 1;
     }
 
-    *done = (++mTilesDecoded >= mTargetTiles);
-
     if (converter.isValid()) {
         converter.convert(
-                (const uint8_t *)videoFrameBuffer->data(),
+                (const uint8_t *)tileBuffer->data(),
                 width, height, stride,
                 crop_left, crop_top, crop_right, crop_bottom,
                 mFrame->getFlattenedData(),
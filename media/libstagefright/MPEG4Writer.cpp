@@ -71,6 +71,17 @@ static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
+// sample_flags of track fragment runs, ISO/IEC 14496-12 8.8.3.1
+static const uint32_t kSyncSampleFlags = 0x02000000;     // sample_depends_on = 2
+static const uint32_t kNonSyncSampleFlags = 0x01010000;  // sample_depends_on = 1, non sync
+// Write combining, see MPEG4Writer::queueWrite().
+static const size_t kWriteBufferSize = 256 * 1024;
+static const size_t kWriteBufferAlignment = 4096;
+static const size_t kMinInPlaceWriteSize = 4096;
+static const size_t kMaxPendingWrites = 256;  // at most IOV_MAX
+// Number of chunks the writer thread takes from the tracks at a time, see threadFunc().
+static const int32_t kDefaultWriteQueueDepth = 16;
+static const int32_t kMaxWriteQueueDepth = 256;
 
 static const char kMetaKey_Version[]    = "com.android.version";
 static const char kMetaKey_Manufacturer[]      = "com.android.manufacturer";
@@ -167,6 +178,9 @@ public:
     const char *getTrackType() const;
     void resetInternal();
     int64_t trackMetaDataSize();
+    // Whether the track can be described by the moov box of a fragmented file.
+    bool readyForFragments() const { return mHasSamples || mReachedEOS; }
+    void writeLastFragment();
 
 private:
     // A helper class to handle faster write box with table entries
@@ -334,6 +348,23 @@ private:
 
     List<MediaBuffer *> mChunkSamples;
 
+    // Samples of the current fragment, in decoding order.
+    struct FragmentSample {
+        MediaBuffer *mBuffer;
+        bool mUsePrefix;
+        uint32_t mSize;                   // including the NAL length prefixes
+        int64_t mDecodingTimeTicks;
+        int32_t mCompositionOffsetTicks;  // composition time - decoding time
+        bool mIsSync;
+    };
+    std::vector<FragmentSample> mFragmentSamples;
+    int64_t mFragmentStartTimeUs;
+    int64_t mLastSampleDurationTicks;
+
+    uint32_t mNumSamples;
+    uint32_t mNumSyncSamples;
+    volatile bool mHasSamples;
+
     bool mSamplesHaveSameSize;
     ListTableEntries<uint32_t, 1> *mStszTableEntries;
     ListTableEntries<off64_t, 1> *mCo64TableEntries;
@@ -448,6 +479,11 @@ private:
     bool isTrackMalFormed();
     void sendTrackSummary(bool hasMultipleTracks);
 
+    void addFragmentSample(MediaBuffer *buffer, bool usePrefix, size_t size,
+            int64_t decodingTimeUs, int64_t compositionOffsetUs, bool isSync);
+    void writeFragment_l(int64_t nextDecodingTimeTicks);
+    void releaseFragmentSamples();
+
     // Write the boxes
     void writeCo64Box();
     void writeStscBox();
@@ -500,6 +536,9 @@ MPEG4Writer::~MPEG4Writer() {
     if (mNextFd != -1) {
         close(mNextFd);
     }
+
+    free(mWriteBuffer);
+    mWriteBuffer = NULL;
 }
 
 void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
@@ -531,7 +570,10 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mInMemoryCache = NULL;
     mInMemoryCacheOffset = 0;
     mInMemoryCacheSize = 0;
+    mInMemoryCacheCapacity = 0;
     mWriteBoxToMemory = false;
+    mRelocateMdat = false;
+    mMoovChunkOffsetTables.clear();
     mFreeBoxOffset = 0;
     mStreamableFile = false;
     mTimeScale = -1;
@@ -545,9 +587,16 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mPreAllocFirstTime = true;
     mPrevAllTracksTotalMetaDataSizeEstimate = 0;
 
+    mWriteBufferOffset = 0;
+    mPendingWrites.clear();
+    mFragmentDurationUs = 0;
+    mWroteFragmentedMoov = false;
+    mFragmentSequenceNumber = 0;
+
     // Following variables only need to be set for the first recording session.
     // And they will stay the same for all the recording sessions.
     if (isFirstSession) {
+        mWriteBuffer = NULL;
         mMoovExtraSize = 0;
         mHasMoovBox = false;
         mMetaKeys = new AMessage();
@@ -607,7 +656,7 @@ status_t MPEG4Writer::Track::dump(
     snprintf(buffer, SIZE, "       reached EOS: %s\n",
             mReachedEOS? "true": "false");
     result.append(buffer);
-    snprintf(buffer, SIZE, "       frames encoded : %d\n", mStszTableEntries->count());
+    snprintf(buffer, SIZE, "       frames encoded : %d\n", mNumSamples);
     result.append(buffer);
     snprintf(buffer, SIZE, "       duration encoded : %" PRId64 " us\n", mTrackDurationUs);
     result.append(buffer);
@@ -896,6 +945,17 @@ status_t MPEG4Writer::start(MetaData *param) {
     CHECK_GT(mTimeScale, 0);
     ALOGV("movie time scale: %d", mTimeScale);
 
+    int64_t fragmentDurationUs;
+    if (param && param->findInt64(kKeyFragmentDurationUs, &fragmentDurationUs)
+            && fragmentDurationUs > 0) {
+        if (mHasFileLevelMeta) {
+            ALOGW("Images can not be fragmented, writing a regular file");
+        } else {
+            mFragmentDurationUs = fragmentDurationUs;
+            ALOGI("fragment duration: %" PRId64 " us", mFragmentDurationUs);
+        }
+    }
+
     /*
      * When the requested file size limit is small, the priority
      * is to meet the file size limit requirement, rather than
@@ -903,7 +963,8 @@ status_t MPEG4Writer::start(MetaData *param) {
      * whether the actual recorded file is streamable or not.
      */
     mStreamableFile =
-        (mMaxFileSizeLimitBytes != 0 &&
+        (!isFragmented() &&
+         mMaxFileSizeLimitBytes != 0 &&
          mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
 
     /*
@@ -973,7 +1034,7 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mFreeBoxOffset = mOffset;
 
-    if (mInMemoryCacheSize == 0) {
+    if (mInMemoryCacheSize == 0 && !isFragmented()) {
         int32_t bitRate = -1;
         if (mHasFileLevelMeta) {
             mFileLevelMetaDataSize = estimateFileLevelMetaSize(param);
@@ -998,7 +1059,11 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!isFragmented()) {
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
+    // Otherwise, the moov box follows once the codec specific data of all
+    // tracks is known, and each fragment has its own mdat box.
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1128,6 +1193,7 @@ void MPEG4Writer::printWriteDurations() {
 status_t MPEG4Writer::release() {
     ALOGD("release()");
     status_t err = OK;
+    flushWrites();
     if (!truncatePreAllocation()) {
         if (err == OK) { err = ERROR_IO; }
     }
@@ -1248,6 +1314,25 @@ status_t MPEG4Writer::reset(bool stopSource) {
         return err;
     }
 
+    if (isFragmented()) {
+        // The track threads are done, write what is left of the fragments.
+        for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+            (*it)->writeLastFragment();
+        }
+        if (!mWroteFragmentedMoov) {
+            writeMoovBox(0);
+            mWroteFragmentedMoov = true;
+        }
+        mMdatEndOffset = mOffset;
+        CHECK(mBoxes.empty());
+
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        return err;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1265,7 +1350,11 @@ status_t MPEG4Writer::reset(bool stopSource) {
 
         mInMemoryCache = (uint8_t *) malloc(mInMemoryCacheSize);
         CHECK(mInMemoryCache != NULL);
+        mInMemoryCacheCapacity = mInMemoryCacheSize;
     }
+    // A moov box that is larger than the reserved space is kept in memory,
+    // and the mdat box is moved to make room for it, see relocateMdat().
+    mRelocateMdat = mWriteBoxToMemory && mHasMoovBox && !mHasFileLevelMeta;
 
     if (mHasFileLevelMeta) {
         writeFileLevelMetaBox();
@@ -1278,6 +1367,15 @@ status_t MPEG4Writer::reset(bool stopSource) {
 
     if (mHasMoovBox) {
         writeMoovBox(maxDurationUs);
+        if (mRelocateMdat && mInMemoryCacheOffset + 8 > mInMemoryCacheSize
+                && !relocateMdat()) {
+            // Write the moov box at the end of the file instead.
+            seekOrPostError(mFd, mOffset, SEEK_SET);
+            writeOrPostError(mFd, mInMemoryCache, mInMemoryCacheOffset);
+            mOffset += mInMemoryCacheOffset;
+            mWriteBoxToMemory = false;
+        }
+        mRelocateMdat = false;
         // mWriteBoxToMemory could be set to false in
         // MPEG4Writer::write() method
         if (mWriteBoxToMemory) {
@@ -1306,6 +1404,91 @@ status_t MPEG4Writer::reset(bool stopSource) {
     return err;
 }
 
+/*
+ * Moves the mdat box towards the end of the file, so that the moov box in the
+ * in-memory cache fits in the reserved space before it, and patches the chunk
+ * offsets of the moov box accordingly.
+ *
+ * The mdat box is copied in place backwards, one staging buffer at a time, at
+ * offsets aligned to the staging buffer size. The distance it is moved is a
+ * multiple of kWriteBufferAlignment, so the writes are aligned as well.
+ *
+ * Returns false if the file cannot be read, in which case nothing has been
+ * moved and the moov box has to be written at the end of the file.
+ */
+bool MPEG4Writer::relocateMdat() {
+    CHECK(mWriteBoxToMemory);
+    flushWrites();
+    if (mWriteSeekErr || mWriteBuffer == NULL) {
+        return false;
+    }
+
+    off64_t shift = mInMemoryCacheOffset + 8 - mInMemoryCacheSize;
+    shift = (shift + kWriteBufferAlignment - 1) / kWriteBufferAlignment * kWriteBufferAlignment;
+    ALOGI("Moving %" PRId64 " bytes of mdat by %" PRId64 " bytes for a %" PRId64
+          " bytes moov box", mMdatEndOffset - mMdatOffset, shift, mInMemoryCacheOffset);
+
+    auto beforeTP = std::chrono::high_resolution_clock::now();
+    off64_t end = mMdatEndOffset;
+    while (end > mMdatOffset) {
+        off64_t start = std::max(mMdatOffset, (end - 1) / (off64_t)kWriteBufferSize
+                * (off64_t)kWriteBufferSize);
+        size_t count = end - start;
+        ssize_t bytesRead = pread64(mFd, mWriteBuffer, count, start);
+        if (bytesRead != (ssize_t)count) {
+            ALOGW("relocateMdat bytesRead:%zd, count:%zu, error:%s(%d)", bytesRead, count,
+                  std::strerror(errno), errno);
+            if (end == mMdatEndOffset) {
+                // Nothing has been moved yet, e.g. the file is write only.
+                return false;
+            }
+            break;
+        }
+        ssize_t bytesWritten = pwrite64(mFd, mWriteBuffer, count, start + shift);
+        if (bytesWritten != (ssize_t)count) {
+            ALOGE("relocateMdat bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
+                  std::strerror(errno), errno);
+            break;
+        }
+        end = start;
+    }
+    if (end > mMdatOffset) {
+        // The file is left partially moved and cannot be used.
+        mWriteSeekErr = true;
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "relocateMdat:error posting ERROR_IO");
+        return false;
+    }
+    auto afterTP = std::chrono::high_resolution_clock::now();
+    ALOGD("mdat moved in %lld us", (long long)std::chrono::duration_cast<
+            std::chrono::microseconds>(afterTP - beforeTP).count());
+
+    mMdatOffset += shift;
+    mMdatEndOffset += shift;
+    mOffset += shift;
+    mInMemoryCacheSize += shift;
+    for (const ChunkOffsetTable &table : mMoovChunkOffsetTables) {
+        uint8_t *entry = mInMemoryCache + table.mOffset;
+        for (size_t i = 0; i < table.mNumEntries; ++i, entry += 8) {
+            uint64_t offset = hton64(U64_AT(entry) + shift);
+            memcpy(entry, &offset, 8);
+        }
+    }
+    mMoovChunkOffsetTables.clear();
+    return true;
+}
+
+void MPEG4Writer::addMoovChunkOffsetTable(size_t numEntries) {
+    if (mRelocateMdat && mWriteBoxToMemory) {
+        // The entries follow the entry count.
+        ChunkOffsetTable table;
+        table.mOffset = mInMemoryCacheOffset + 4;
+        table.mNumEntries = numEntries;
+        mMoovChunkOffsetTables.push_back(table);
+    }
+}
+
 /*
  * Writes currently cached box into file.
  *
@@ -1397,14 +1580,17 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
                 std::min(minCttsOffsetTimeUs, (*it)->getMinCttsOffsetTimeUs());
         }
     }
-    ALOGI("Adjust the moov start time from %lld us -> %lld us", (long long)mStartTimestampUs,
-          (long long)(mStartTimestampUs + minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs));
-    // Adjust movie start time.
-    mStartTimestampUs += minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
+    // Fragments carry signed composition offsets instead of an edit list.
+    if (!isFragmented()) {
+        ALOGI("Adjust the moov start time from %lld us -> %lld us", (long long)mStartTimestampUs,
+              (long long)(mStartTimestampUs + minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs));
+        // Adjust movie start time.
+        mStartTimestampUs += minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
 
-    // Add mStartTimeOffsetBFramesUs(-ve or zero) to the start offset of tracks.
-    mStartTimeOffsetBFramesUs = minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
-    ALOGV("mStartTimeOffsetBFramesUs :%" PRId32, mStartTimeOffsetBFramesUs);
+        // Add mStartTimeOffsetBFramesUs(-ve or zero) to the start offset of tracks.
+        mStartTimeOffsetBFramesUs = minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
+        ALOGV("mStartTimeOffsetBFramesUs :%" PRId32, mStartTimeOffsetBFramesUs);
+    }
 
     for (List<Track *>::iterator it = mTracks.begin();
         it != mTracks.end(); ++it) {
@@ -1412,9 +1598,44 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
             (*it)->writeTrackHeader();
         }
     }
+    if (isFragmented()) {
+        writeMvexBox();
+    }
     endBox();  // moov
 }
 
+void MPEG4Writer::writeMvexBox() {
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if ((*it)->isHeic()) {
+            continue;
+        }
+        beginBox("trex");
+        writeInt32(0);                             // version=0, flags=0
+        writeInt32((*it)->getTrackId().getId());   // track id
+        writeInt32(1);                             // default sample description index
+        writeInt32(0);                             // default sample duration
+        writeInt32(0);                             // default sample size
+        writeInt32(0);                             // default sample flags
+        endBox();  // trex
+    }
+    endBox();  // mvex
+}
+
+// The moov box of a fragmented file describes the codecs of all tracks, so it can
+// only be written once all of them have received their first sample.
+bool MPEG4Writer::fragmentsReady_l() {
+    if (mWroteFragmentedMoov) {
+        return true;
+    }
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if (!(*it)->isHeic() && !(*it)->readyForFragments()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void MPEG4Writer::writeFtypBox(MetaData *param) {
     beginBox("ftyp");
 
@@ -1504,8 +1725,8 @@ off64_t MPEG4Writer::addSample_l(
             mOffset += 4;
         }
 
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(),
-                         buffer->range_length());
+        writeSampleDataOrPostError((const uint8_t*)buffer->data() + buffer->range_offset(),
+                                   buffer->range_length());
 
         mOffset += buffer->range_length();
     }
@@ -1560,7 +1781,8 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         x[2] = (length >> 8) & 0xff;
         x[3] = length & 0xff;
         writeOrPostError(mFd, &x, 4);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
+        writeSampleDataOrPostError(
+                (const uint8_t*)buffer->data() + buffer->range_offset(), length);
         mOffset += length + 4;
     } else {
         CHECK_LT(length, 65536u);
@@ -1569,7 +1791,8 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         x[0] = length >> 8;
         x[1] = length & 0xff;
         writeOrPostError(mFd, &x, 2);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
+        writeSampleDataOrPostError(
+                (const uint8_t*)buffer->data() + buffer->range_offset(), length);
         mOffset += length + 2;
     }
 }
@@ -1581,7 +1804,7 @@ size_t MPEG4Writer::write(
     if (mWriteBoxToMemory) {
 
         off64_t boxSize = 8 + mInMemoryCacheOffset + bytes;
-        if (boxSize > mInMemoryCacheSize) {
+        if (boxSize > mInMemoryCacheSize && !mRelocateMdat) {
             // The reserved free space at the beginning of the file is not big
             // enough. Boxes should be written to the end of the file from now
             // on, but not to the in-memory cache.
@@ -1599,6 +1822,12 @@ size_t MPEG4Writer::write(
             // All subsequent boxes will be written to the end of the file.
             mWriteBoxToMemory = false;
         } else {
+            if (mInMemoryCacheOffset + (off64_t)bytes > mInMemoryCacheCapacity) {
+                mInMemoryCacheCapacity = std::max(
+                        2 * mInMemoryCacheCapacity, mInMemoryCacheOffset + (off64_t)bytes);
+                mInMemoryCache = (uint8_t *)realloc(mInMemoryCache, mInMemoryCacheCapacity);
+                CHECK(mInMemoryCache != NULL);
+            }
             memcpy(mInMemoryCache + mInMemoryCacheOffset, ptr, bytes);
             mInMemoryCacheOffset += bytes;
         }
@@ -1610,12 +1839,81 @@ size_t MPEG4Writer::write(
 }
 
 void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
-    if (mWriteSeekErr == true)
+    // Writes are only combined for the output file.
+    CHECK_EQ(fd, mFd);
+    queueWrite(buf, count, true /* copy */);
+}
+
+void MPEG4Writer::writeSampleDataOrPostError(const void* buf, size_t count) {
+    queueWrite(buf, count, false /* copy */);
+}
+
+void MPEG4Writer::queueWrite(const void* buf, size_t count, bool copy) {
+    if (mWriteSeekErr == true || count == 0)
+        return;
+
+    if (mWriteBuffer == NULL) {
+        void *writeBuffer;
+        CHECK_EQ(posix_memalign(&writeBuffer, kWriteBufferAlignment, kWriteBufferSize), 0);
+        mWriteBuffer = (uint8_t *)writeBuffer;
+    }
+
+    // Small samples, such as audio frames, are cheaper to copy than to write on their own.
+    if (count < kMinInPlaceWriteSize) {
+        copy = true;
+    }
+
+    if (copy && count > kWriteBufferSize / 4) {
+        // Too large to stage, but the caller may reuse buf once this returns.
+        mPendingWrites.push_back({const_cast<void *>(buf), count});
+        flushWrites();
+        return;
+    }
+
+    if (copy) {
+        if (mWriteBufferOffset + count > kWriteBufferSize) {
+            flushWrites();
+        }
+        uint8_t *staged = mWriteBuffer + mWriteBufferOffset;
+        memcpy(staged, buf, count);
+        mWriteBufferOffset += count;
+
+        if (!mPendingWrites.empty()
+                && (uint8_t *)mPendingWrites.back().iov_base + mPendingWrites.back().iov_len
+                        == staged) {
+            mPendingWrites.back().iov_len += count;
+        } else {
+            mPendingWrites.push_back({staged, count});
+        }
+    } else {
+        mPendingWrites.push_back({const_cast<void *>(buf), count});
+    }
+
+    if (mPendingWrites.size() >= kMaxPendingWrites) {
+        flushWrites();
+    }
+}
+
+void MPEG4Writer::flushWrites() {
+    if (mPendingWrites.empty()) {
+        return;
+    }
+    if (mWriteSeekErr == true) {
+        mPendingWrites.clear();
+        mWriteBufferOffset = 0;
         return;
+    }
+
+    size_t count = 0;
+    for (const struct iovec &iov : mPendingWrites) {
+        count += iov.iov_len;
+    }
 
     auto beforeTP = std::chrono::high_resolution_clock::now();
-    ssize_t bytesWritten = ::write(fd, buf, count);
+    ssize_t bytesWritten = ::writev(mFd, mPendingWrites.data(), mPendingWrites.size());
     auto afterTP = std::chrono::high_resolution_clock::now();
+    mPendingWrites.clear();
+    mWriteBufferOffset = 0;
     auto writeDuration =
             std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP).count();
     mWriteDurationPQ.emplace(writeDuration);
@@ -1630,16 +1928,17 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
         return;
     mWriteSeekErr = true;
     // Note that errno is not changed even when bytesWritten < count.
-    ALOGE("writeOrPostError bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
+    ALOGE("flushWrites bytesWritten:%zd, count:%zu, error:%s(%d)", bytesWritten, count,
           std::strerror(errno), errno);
 
     // Can't guarantee that file is usable or write would succeed anymore, hence signal to stop.
     sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
     msg->setInt32("err", ERROR_IO);
-    WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
+    WARN_UNLESS(msg->post() == OK, "flushWrites:error posting ERROR_IO");
 }
 
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
+    flushWrites();
     if (mWriteSeekErr == true)
         return;
     off64_t resOffset = lseek64(fd, offset, whence);
@@ -2042,6 +2341,11 @@ MPEG4Writer::Track::Track(
       mTrackId(aTrackId),
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
+      mFragmentStartTimeUs(0),
+      mLastSampleDurationTicks(0),
+      mNumSamples(0),
+      mNumSyncSamples(0),
+      mHasSamples(false),
       mSamplesHaveSameSize(true),
       mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
@@ -2127,6 +2431,11 @@ void MPEG4Writer::Track::resetInternal() {
     mTrackDurationUs = 0;
     mEstimatedTrackSizeBytes = 0;
     mSamplesHaveSameSize = false;
+    releaseFragmentSamples();
+    mLastSampleDurationTicks = 0;
+    mNumSamples = 0;
+    mNumSyncSamples = 0;
+    mHasSamples = false;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
         mStszTableEntries = new ListTableEntries<uint32_t, 1>(1000);
@@ -2534,6 +2843,8 @@ void MPEG4Writer::Track::getCodecSpecificDataFromInputFormatIfPossible() {
 MPEG4Writer::Track::~Track() {
     stop();
 
+    releaseFragmentSamples();
+
     delete mStszTableEntries;
     delete mCo64TableEntries;
     delete mStscTableEntries;
@@ -2602,9 +2913,8 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
     int32_t isFirstSample = true;
-    while (!chunk->mSamples.empty()) {
-        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
-
+    for (List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+         it != chunk->mSamples.end(); ++it) {
         uint32_t tiffHdrOffset;
         if (!(*it)->meta_data().findInt32(
                 kKeyExifTiffOffset, (int32_t*)&tiffHdrOffset)) {
@@ -2622,22 +2932,39 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
             chunk->mTrack->addChunkOffset(offset);
             isFirstSample = false;
         }
+    }
+}
 
-        (*it)->release();
-        (*it) = NULL;
-        chunk->mSamples.erase(it);
+void MPEG4Writer::writeChunksToFile(List<Chunk> *chunks) {
+    for (List<Chunk>::iterator it = chunks->begin(); it != chunks->end(); ++it) {
+        writeChunkToFile(&*it);
     }
-    chunk->mSamples.clear();
+
+    // The samples are written in place, so they are released once all the
+    // chunks have been written.
+    flushWrites();
+    for (List<Chunk>::iterator it = chunks->begin(); it != chunks->end(); ++it) {
+        List<MediaBuffer *> &samples = it->mSamples;
+        while (!samples.empty()) {
+            List<MediaBuffer *>::iterator sampleIt = samples.begin();
+            (*sampleIt)->release();
+            (*sampleIt) = NULL;
+            samples.erase(sampleIt);
+        }
+    }
+    chunks->clear();
 }
 
 void MPEG4Writer::writeAllChunks() {
     ALOGV("writeAllChunks");
     size_t outstandingChunks = 0;
+    List<Chunk> chunks;
     Chunk chunk;
     while (findChunkToWrite(&chunk)) {
-        writeChunkToFile(&chunk);
+        chunks.push_back(chunk);
         ++outstandingChunks;
     }
+    writeChunksToFile(&chunks);
 
     sendSessionSummary();
 
@@ -2695,26 +3022,34 @@ void MPEG4Writer::threadFunc() {
     prctl(PR_SET_NAME, (unsigned long)"MPEG4Writer", 0, 0, 0);
 
     Mutex::Autolock autoLock(mLock);
+    List<Chunk> chunks;
     while (!mDone) {
+        // Take the chunks that are ready, up to the queue depth, in the order
+        // they are interleaved in the file, so that the lock is acquired once
+        // for all of them and they are written together.
         Chunk chunk;
-        bool chunkFound = false;
-
-        while (!mDone && !(chunkFound = findChunkToWrite(&chunk))) {
-            mChunkReadyCondition.wait(mLock);
+        int32_t numChunks = 0;
+        while (numChunks < mWriteQueueDepth && findChunkToWrite(&chunk)) {
+            chunks.push_back(chunk);
+            ++numChunks;
+        }
+        if (numChunks == 0) {
+            if (!mDone) {
+                mChunkReadyCondition.wait(mLock);
+            }
+            continue;
         }
 
         // In real time recording mode, write without holding the lock in order
         // to reduce the blocking time for media track threads.
         // Otherwise, hold the lock until the existing chunks get written to the
         // file.
-        if (chunkFound) {
-            if (mIsRealTimeRecording) {
-                mLock.unlock();
-            }
-            writeChunkToFile(&chunk);
-            if (mIsRealTimeRecording) {
-                mLock.lock();
-            }
+        if (mIsRealTimeRecording) {
+            mLock.unlock();
+        }
+        writeChunksToFile(&chunks);
+        if (mIsRealTimeRecording) {
+            mLock.lock();
         }
     }
 
@@ -2727,6 +3062,12 @@ status_t MPEG4Writer::startWriterThread() {
     mDone = false;
     mIsFirstChunk = true;
     mDriftTimeUs = 0;
+    mWriteQueueDepth = property_get_int32(
+            "media.recorder.mp4.write-queue-depth", kDefaultWriteQueueDepth);
+    if (mWriteQueueDepth < 1 || mWriteQueueDepth > kMaxWriteQueueDepth) {
+        ALOGW("Ignoring write queue depth %d", mWriteQueueDepth);
+        mWriteQueueDepth = kDefaultWriteQueueDepth;
+    }
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
         ChunkInfo info;
@@ -3260,6 +3601,8 @@ status_t MPEG4Writer::Track::threadEntry() {
     int32_t count = 0;
     const int64_t interleaveDurationUs = mOwner->interleaveDuration();
     const bool hasMultipleTracks = (mOwner->numTracks() > 1);
+    // In a fragmented file the sample tables are in the fragments, not in the moov box.
+    const bool isFragmented = mOwner->isFragmented();
     int64_t chunkTimestampUs = 0;
     int32_t nChunks = 0;
     int32_t nActualFrames = 0;        // frames containing non-CSD data (non-0 length)
@@ -3492,7 +3835,7 @@ status_t MPEG4Writer::Track::threadEntry() {
         }
 ////////////////////////////////////////////////////////////////////////////////
         if (!mIsHeic) {
-            if (mStszTableEntries->count() == 0) {
+            if (mNumSamples == 0) {
                 mFirstSampleTimeRealUs = systemTime() / 1000;
                 if (timestampUs < 0 && mFirstSampleStartOffsetUs == 0) {
                     mFirstSampleStartOffsetUs = -timestampUs;
@@ -3586,7 +3929,9 @@ status_t MPEG4Writer::Track::threadEntry() {
                     break;
                 }
 
-                if (mStszTableEntries->count() == 0) {
+                if (isFragmented) {
+                    // Composition offsets are in the fragments.
+                } else if (mNumSamples == 0) {
                     // Force the first ctts table entry to have one single entry
                     // so that we can do adjustment for the initial track start
                     // time offset easily in writeCttsBox().
@@ -3604,7 +3949,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
 
                 // Update ctts time offset range
-                if (mStszTableEntries->count() == 0) {
+                if (mNumSamples == 0) {
                     mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
                     mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
                 } else {
@@ -3670,9 +4015,12 @@ status_t MPEG4Writer::Track::threadEntry() {
                     timestampUs += deltaUs;
                 }
             }
-            mStszTableEntries->add(htonl(sampleSize));
+            ++mNumSamples;
+            if (!isFragmented) {
+                mStszTableEntries->add(htonl(sampleSize));
+            }
 
-            if (mStszTableEntries->count() > 2) {
+            if (!isFragmented && mStszTableEntries->count() > 2) {
 
                 // Force the first sample to have its own stts entry so that
                 // we can adjust its value later to maintain the A/V sync.
@@ -3696,7 +4044,10 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastTimestampUs = timestampUs;
 
             if (isSync != 0) {
-                addOneStssTableEntry(mStszTableEntries->count());
+                ++mNumSyncSamples;
+                if (!isFragmented) {
+                    addOneStssTableEntry(mStszTableEntries->count());
+                }
             }
 
             if (mTrackingProgressStatus) {
@@ -3706,10 +4057,17 @@ status_t MPEG4Writer::Track::threadEntry() {
                 trackProgressStatus(timestampUs);
             }
         }
+        if (isFragmented && !mIsHeic) {
+            addFragmentSample(copy, usePrefix, sampleSize, timestampUs,
+                    mIsVideo ? cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : 0, isSync);
+            continue;
+        }
+
         if (!hasMultipleTracks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
                     copy, usePrefix, tiffHdrOffset, &bytesWritten);
+            mOwner->flushWrites();
 
             if (mIsHeic) {
                 addItemOffsetAndSize(offset, bytesWritten, isExif);
@@ -3807,13 +4165,23 @@ status_t MPEG4Writer::Track::threadEntry() {
                 mTrackDurationUs += lastDurationUs;
             }
         }
+    } else if (isFragmented && mNumSamples > 0) {
+        // As above, the last sample lasts as long as the previous one if the
+        // EOS buffer does not tell. The last fragment is written by reset().
+        if (lastSampleDurationUs >= 0) {
+            mLastSampleDurationTicks = lastSampleDurationTicks;
+            mTrackDurationUs += lastSampleDurationUs;
+        } else {
+            mLastSampleDurationTicks = lastDurationTicks;
+            mTrackDurationUs += lastDurationUs;
+        }
     }
     mReachedEOS = true;
 
     sendTrackSummary(hasMultipleTracks);
 
     ALOGI("Received total/0-length (%d/%d) buffers and encoded %d frames. - %s",
-            count, nZeroLengthFrames, mStszTableEntries->count(), trackName);
+            count, nZeroLengthFrames, mNumSamples, trackName);
     if (mIsAudio) {
         ALOGI("Audio track drift time: %" PRId64 " us", mOwner->getDriftTimeUs());
     }
@@ -3834,26 +4202,26 @@ bool MPEG4Writer::Track::isTrackMalFormed() {
         mOwner->mStartMeta->findInt32(kKeyEmptyTrackMalFormed, &emptyTrackMalformed) &&
         emptyTrackMalformed) {
         // MediaRecorder(sets kKeyEmptyTrackMalFormed by default) report empty tracks as malformed.
-        if (!mIsHeic && mStszTableEntries->count() == 0) {  // no samples written
+        if (!mIsHeic && mNumSamples == 0) {  // no samples written
             ALOGE("The number of recorded samples is 0");
             mIsMalformed = true;
             return true;
         }
-        if (mIsVideo && mStssTableEntries->count() == 0) {  // no sync frames for video
+        if (mIsVideo && mNumSyncSamples == 0) {  // no sync frames for video
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     } else {
         // Through MediaMuxer, empty tracks can be added. No sync frames for video.
-        if (mIsVideo && mStszTableEntries->count() > 0 && mStssTableEntries->count() == 0) {
+        if (mIsVideo && mNumSamples > 0 && mNumSyncSamples == 0) {
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     }
     // Don't check for CodecSpecificData when track is empty.
-    if (mStszTableEntries->count() > 0 && OK != checkCodecSpecificData()) {
+    if (mNumSamples > 0 && OK != checkCodecSpecificData()) {
         // No codec specific data.
         mIsMalformed = true;
         return true;
@@ -3881,7 +4249,7 @@ void MPEG4Writer::Track::sendTrackSummary(bool hasMultipleTracks) {
 
     mOwner->notify(MEDIA_RECORDER_TRACK_EVENT_INFO,
                     trackNum | MEDIA_RECORDER_TRACK_INFO_ENCODED_FRAMES,
-                    mStszTableEntries->count());
+                    mNumSamples);
 
     {
         // The system delay time excluding the requested initial delay that
@@ -3957,14 +4325,13 @@ void MPEG4Writer::trackProgressStatus(
 
 void MPEG4Writer::setDriftTimeUs(int64_t driftTimeUs) {
     ALOGV("setDriftTimeUs: %" PRId64 " us", driftTimeUs);
-    Mutex::Autolock autolock(mLock);
-    mDriftTimeUs = driftTimeUs;
+    mDriftTimeUs.store(driftTimeUs, std::memory_order_relaxed);
 }
 
 int64_t MPEG4Writer::getDriftTimeUs() {
-    ALOGV("getDriftTimeUs: %" PRId64 " us", mDriftTimeUs);
-    Mutex::Autolock autolock(mLock);
-    return mDriftTimeUs;
+    int64_t driftTimeUs = mDriftTimeUs.load(std::memory_order_relaxed);
+    ALOGV("getDriftTimeUs: %" PRId64 " us", driftTimeUs);
+    return driftTimeUs;
 }
 
 bool MPEG4Writer::isRealTimeRecording() const {
@@ -4066,11 +4433,143 @@ const char *MPEG4Writer::Track::getTrackType() const {
                       "Metadata";
 }
 
+void MPEG4Writer::Track::addFragmentSample(
+        MediaBuffer *buffer, bool usePrefix, size_t size,
+        int64_t decodingTimeUs, int64_t compositionOffsetUs, bool isSync) {
+    FragmentSample sample;
+    sample.mBuffer = buffer;
+    sample.mUsePrefix = usePrefix;
+    sample.mSize = size;
+    sample.mDecodingTimeTicks = (decodingTimeUs * mTimeScale + 500000LL) / 1000000LL;
+    sample.mCompositionOffsetTicks =
+            (compositionOffsetUs * mTimeScale + (compositionOffsetUs < 0 ? -500000LL : 500000LL))
+            / 1000000LL;
+    sample.mIsSync = isSync;
+
+    // Video fragments start with a sync sample, so that each one can be decoded on its own.
+    if (!mFragmentSamples.empty() && (!mIsVideo || isSync)
+            && decodingTimeUs - mFragmentStartTimeUs >= mOwner->mFragmentDurationUs) {
+        Mutex::Autolock autoLock(mOwner->mLock);
+        if (mOwner->fragmentsReady_l()) {
+            writeFragment_l(sample.mDecodingTimeTicks);
+        }
+    }
+
+    if (mFragmentSamples.empty()) {
+        mFragmentStartTimeUs = decodingTimeUs;
+    }
+    mFragmentSamples.push_back(sample);
+    mHasSamples = true;
+}
+
+void MPEG4Writer::Track::writeLastFragment() {
+    if (mFragmentSamples.empty()) {
+        return;
+    }
+    writeFragment_l(mFragmentSamples.back().mDecodingTimeTicks + mLastSampleDurationTicks);
+}
+
+// Writes the samples of the current fragment as a moof box followed by an mdat box.
+// The sizes of the boxes are known up front, so nothing is written twice and the
+// fragment is complete in the file as soon as it is written.
+void MPEG4Writer::Track::writeFragment_l(int64_t nextDecodingTimeTicks) {
+    if (!mOwner->mWroteFragmentedMoov) {
+        mOwner->writeMoovBox(0);
+        mOwner->mWroteFragmentedMoov = true;
+    }
+
+    const uint32_t sampleCount = mFragmentSamples.size();
+    // data-offset, sample-duration, sample-size and sample-flags are present,
+    // and signed sample-composition-time-offsets for video.
+    const uint32_t trunFlags = 0x000001 | 0x000100 | 0x000200 | 0x000400
+            | (mIsVideo ? 0x000800 : 0);
+    const uint32_t trunVersion = mIsVideo ? 1 : 0;
+    const uint32_t trunSize = 20 + sampleCount * (mIsVideo ? 16 : 12);
+    const uint32_t trafSize = 8 + 16 /* tfhd */ + 20 /* tfdt */ + trunSize;
+    const uint32_t moofSize = 8 + 16 /* mfhd */ + trafSize;
+
+    uint64_t dataSize = 0;
+    for (const FragmentSample &sample : mFragmentSamples) {
+        dataSize += sample.mSize;
+    }
+    const bool largeMdat = (dataSize + 8 > UINT32_MAX);
+    const uint32_t mdatHeaderSize = largeMdat ? 16 : 8;
+
+    off64_t moofOffset = mOwner->mOffset;
+    mOwner->writeInt32(moofSize);
+    mOwner->writeFourcc("moof");
+        mOwner->writeInt32(16);
+        mOwner->writeFourcc("mfhd");
+        mOwner->writeInt32(0);             // version=0, flags=0
+        mOwner->writeInt32(++mOwner->mFragmentSequenceNumber);
+
+        mOwner->writeInt32(trafSize);
+        mOwner->writeFourcc("traf");
+            mOwner->writeInt32(16);
+            mOwner->writeFourcc("tfhd");
+            mOwner->writeInt32(0x020000);  // version=0, flags=default-base-is-moof
+            mOwner->writeInt32(mTrackId.getId());
+
+            mOwner->writeInt32(20);
+            mOwner->writeFourcc("tfdt");
+            mOwner->writeInt32(1 << 24);   // version=1, flags=0
+            mOwner->writeInt64(getStartTimeOffsetScaledTime()
+                    + mFragmentSamples[0].mDecodingTimeTicks);
+
+            mOwner->writeInt32(trunSize);
+            mOwner->writeFourcc("trun");
+            mOwner->writeInt32((trunVersion << 24) | trunFlags);
+            mOwner->writeInt32(sampleCount);
+            mOwner->writeInt32(moofSize + mdatHeaderSize);  // data offset
+            for (size_t i = 0; i < sampleCount; ++i) {
+                const FragmentSample &sample = mFragmentSamples[i];
+                int64_t nextTicks = (i + 1 < sampleCount)
+                        ? mFragmentSamples[i + 1].mDecodingTimeTicks : nextDecodingTimeTicks;
+                mOwner->writeInt32(std::max((int64_t)0, nextTicks - sample.mDecodingTimeTicks));
+                mOwner->writeInt32(sample.mSize);
+                mOwner->writeInt32(sample.mIsSync ? kSyncSampleFlags : kNonSyncSampleFlags);
+                if (mIsVideo) {
+                    mOwner->writeInt32(sample.mCompositionOffsetTicks);
+                }
+            }
+    CHECK_EQ(mOwner->mOffset - moofOffset, (off64_t)moofSize);
+
+    if (largeMdat) {
+        mOwner->writeInt32(1);
+        mOwner->writeFourcc("mdat");
+        mOwner->writeInt64(dataSize + mdatHeaderSize);
+    } else {
+        mOwner->writeInt32(dataSize + mdatHeaderSize);
+        mOwner->writeFourcc("mdat");
+    }
+    for (const FragmentSample &sample : mFragmentSamples) {
+        size_t bytesWritten;
+        mOwner->addSample_l(sample.mBuffer, sample.mUsePrefix, 0 /* tiffHdrOffset */,
+                &bytesWritten);
+    }
+    // The samples are written in place, release them once they are in the file.
+    mOwner->flushWrites();
+    mOwner->mMdatEndOffset = mOwner->mOffset;
+
+    ALOGV("%s fragment %u of %u samples, %" PRIu64 " bytes", getTrackType(),
+            mOwner->mFragmentSequenceNumber, sampleCount, dataSize);
+    releaseFragmentSamples();
+}
+
+void MPEG4Writer::Track::releaseFragmentSamples() {
+    for (const FragmentSample &sample : mFragmentSamples) {
+        sample.mBuffer->release();
+    }
+    mFragmentSamples.clear();
+}
+
 void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4102,7 +4601,7 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
     // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
+    if (mNumSamples > 0 && !isTrackMalFormed()) {
         mOwner->beginBox("stsd");
         mOwner->writeInt32(0);               // version=0, flags=0
         mOwner->writeInt32(1);               // entry count
@@ -4115,7 +4614,7 @@ void MPEG4Writer::Track::writeStblBox() {
         }
         mOwner->endBox();  // stsd
         writeSttsBox();
-        if (mIsVideo) {
+        if (mIsVideo && !mOwner->isFragmented()) {
             writeCttsBox();
             writeStssBox();
         }
@@ -4409,7 +4908,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The duration of a fragmented track is the sum of its fragments.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -4612,7 +5112,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -4804,6 +5304,7 @@ void MPEG4Writer::Track::writeStscBox() {
 void MPEG4Writer::Track::writeCo64Box() {
     mOwner->beginBox("co64");
     mOwner->writeInt32(0);  // version=0, flags=0
+    mOwner->addMoovChunkOffsetTable(mCo64TableEntries->count());
     mCo64TableEntries->write(mOwner);
     mOwner->endBox();  // stco or co64
 }
@@ -638,6 +638,8 @@ MediaCodec::MediaCodec(
       mDequeueInputReplyID(0),
       mDequeueOutputTimeoutGeneration(0),
       mDequeueOutputReplyID(0),
+      mDequeueOutputBatch(nullptr),
+      mDequeueOutputBatchMax(0),
       mHaveInputSurface(false),
       mHavePendingInputBuffers(false),
       mCpuBoostRequested(false),
@@ -1578,6 +1580,31 @@ status_t MediaCodec::queueInputBuffer(
     return PostAndAwaitResponse(msg, &response);
 }
 
+status_t MediaCodec::queueInputBuffers(
+        const std::vector<BatchBufferInfo> &buffers,
+        size_t *numQueued,
+        AString *errorDetailMsg) {
+    if (errorDetailMsg != NULL) {
+        errorDetailMsg->clear();
+    }
+    *numQueued = 0;
+    if (buffers.empty()) {
+        return OK;
+    }
+
+    // buffers stays valid until the looper replies
+    sp<AMessage> msg = new AMessage(kWhatQueueInputBuffers, this);
+    msg->setPointer("buffers", (void *)&buffers);
+    msg->setPointer("errorDetailMsg", errorDetailMsg);
+
+    sp<AMessage> response;
+    status_t err = PostAndAwaitResponse(msg, &response);
+    if (response != NULL) {
+        response->findSize("numQueued", numQueued);
+    }
+    return err;
+}
+
 status_t MediaCodec::queueSecureInputBuffer(
         size_t index,
         size_t offset,
@@ -1723,6 +1750,30 @@ status_t MediaCodec::dequeueOutputBuffer(
     return OK;
 }
 
+status_t MediaCodec::dequeueOutputBuffers(
+        std::vector<BatchBufferInfo> *buffers,
+        size_t maxBuffers,
+        int64_t timeoutUs) {
+    buffers->clear();
+    if (maxBuffers == 0) {
+        return BAD_VALUE;
+    }
+
+    // buffers is filled in by the looper before it replies
+    sp<AMessage> msg = new AMessage(kWhatDequeueOutputBuffer, this);
+    msg->setInt64("timeoutUs", timeoutUs);
+    msg->setPointer("batch", buffers);
+    msg->setSize("maxBuffers", maxBuffers);
+
+    sp<AMessage> response;
+    status_t err;
+    if ((err = PostAndAwaitResponse(msg, &response)) != OK) {
+        buffers->clear();
+        return err;
+    }
+    return OK;
+}
+
 status_t MediaCodec::renderOutputBufferAndRelease(size_t index) {
     sp<AMessage> msg = new AMessage(kWhatReleaseOutputBuffer, this);
     msg->setSize("index", index);
@@ -2037,6 +2088,7 @@ void MediaCodec::cancelPendingDequeueOperations() {
 
         ++mDequeueOutputTimeoutGeneration;
         mDequeueOutputReplyID = 0;
+        mDequeueOutputBatch = nullptr;
         mFlags &= ~kFlagDequeueOutputPending;
     }
 }
@@ -2109,6 +2161,32 @@ bool MediaCodec::handleDequeueOutputBuffer(const sp<AReplyToken> &replyID, bool
         CHECK(buffer->meta()->findInt32("flags", &flags));
 
         response->setInt32("flags", flags);
+
+        if (mDequeueOutputBatch != nullptr) {
+            std::vector<BatchBufferInfo> *batch = mDequeueOutputBatch;
+            mDequeueOutputBatch = nullptr;
+            batch->push_back({(size_t)index, buffer->offset(), buffer->size(), timeUs,
+                    (uint32_t)flags});
+            while (batch->size() < mDequeueOutputBatchMax && !(flags & BUFFER_FLAG_EOS)) {
+                BufferInfo *nextInfo = peekNextPortBuffer(kPortIndexOutput);
+                if (!nextInfo) {
+                    break;
+                }
+                const sp<MediaCodecBuffer> &nextBuffer = nextInfo->mData;
+                handleOutputFormatChangeIfNeeded(nextBuffer);
+                if (mFlags & kFlagOutputFormatChanged) {
+                    // leave the flag set, the next dequeue reports INFO_FORMAT_CHANGED
+                    break;
+                }
+                index = dequeuePortBuffer(kPortIndexOutput);
+                CHECK(nextBuffer->meta()->findInt64("timeUs", &timeUs));
+                CHECK(nextBuffer->meta()->findInt32("flags", &flags));
+                statsBufferReceived(timeUs);
+                batch->push_back({(size_t)index, nextBuffer->offset(), nextBuffer->size(),
+                        timeUs, (uint32_t)flags});
+            }
+        }
+
         response->postReply(replyID);
     }
 
@@ -2618,6 +2696,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                         ++mDequeueOutputTimeoutGeneration;
                         mFlags &= ~kFlagDequeueOutputPending;
                         mDequeueOutputReplyID = 0;
+                        mDequeueOutputBatch = nullptr;
                     } else {
                         postActivityNotificationIfPossible();
                     }
@@ -3249,6 +3328,54 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatQueueInputBuffers:
+        {
+            sp<AReplyToken> replyID;
+            CHECK(msg->senderAwaitsResponse(&replyID));
+
+            if (!isExecuting()) {
+                PostReplyWithError(replyID, INVALID_OPERATION);
+                break;
+            } else if (mFlags & kFlagStickyError) {
+                PostReplyWithError(replyID, getStickyError());
+                break;
+            }
+
+            const std::vector<BatchBufferInfo> *buffers;
+            AString *errorDetailMsg;
+            CHECK(msg->findPointer("buffers", (void **)&buffers));
+            CHECK(msg->findPointer("errorDetailMsg", (void **)&errorDetailMsg));
+
+            // queue each buffer exactly as kWhatQueueInputBuffer does
+            status_t err = OK;
+            size_t numQueued = 0;
+            for (const BatchBufferInfo &buffer : *buffers) {
+                sp<AMessage> bufferMsg = new AMessage(kWhatQueueInputBuffer, this);
+                bufferMsg->setSize("index", buffer.index);
+                bufferMsg->setSize("offset", buffer.offset);
+                bufferMsg->setSize("size", buffer.size);
+                bufferMsg->setInt64("timeUs", buffer.presentationTimeUs);
+                bufferMsg->setInt32("flags", buffer.flags);
+                bufferMsg->setPointer("errorDetailMsg", errorDetailMsg);
+                if (!mLeftover.empty()) {
+                    mLeftover.push_back(bufferMsg);
+                    err = handleLeftover(buffer.index);
+                } else {
+                    err = onQueueInputBuffer(bufferMsg);
+                }
+                if (err != OK) {
+                    break;
+                }
+                ++numQueued;
+            }
+
+            sp<AMessage> response = new AMessage;
+            response->setInt32("err", err);
+            response->setSize("numQueued", numQueued);
+            response->postReply(replyID);
+            break;
+        }
+
         case kWhatDequeueOutputBuffer:
         {
             sp<AReplyToken> replyID;
@@ -3260,7 +3387,20 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
+            if (!(mFlags & kFlagDequeueOutputPending)) {
+                // a request made while another is pending is rejected below
+                void *batch = nullptr;
+                mDequeueOutputBatchMax = 1;
+                if (msg->findPointer("batch", &batch)) {
+                    CHECK(msg->findSize("maxBuffers", &mDequeueOutputBatchMax));
+                }
+                mDequeueOutputBatch = static_cast<std::vector<BatchBufferInfo> *>(batch);
+            }
+
             if (handleDequeueOutputBuffer(replyID, true /* new request */)) {
+                if (!(mFlags & kFlagDequeueOutputPending)) {
+                    mDequeueOutputBatch = nullptr;
+                }
                 break;
             }
 
@@ -3268,6 +3408,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
             CHECK(msg->findInt64("timeoutUs", &timeoutUs));
 
             if (timeoutUs == 0LL) {
+                mDequeueOutputBatch = nullptr;
                 PostReplyWithError(replyID, -EAGAIN);
                 break;
             }
@@ -3301,6 +3442,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
             mFlags &= ~kFlagDequeueOutputPending;
             mDequeueOutputReplyID = 0;
+            mDequeueOutputBatch = nullptr;
             break;
         }
 
@@ -21,6 +21,7 @@
 #include "MediaCodecListOverrides.h"
 
 #include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
 
 #include <media/IMediaCodecList.h>
 #include <media/IMediaPlayerService.h>
@@ -38,12 +39,18 @@
 #include <media/stagefright/OmxInfoBuilder.h>
 #include <media/stagefright/PersistentSurface.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utils/threads.h>
 
 #include <cutils/properties.h>
 
 #include <algorithm>
+#include <inttypes.h>
 
 namespace android {
 
@@ -79,6 +86,95 @@ bool isProfilingNeeded() {
     return profilingNeeded;
 }
 
+// Binary form of the built codec list, so that a process doesn't parse the XML
+// files and query every component again as long as none of them changed.
+constexpr const char* kCodecListCache = "/data/misc/media/media_codecs_cache.bin";
+constexpr int32_t kCodecListCacheMagic = 0x4d434c43; // 'MCLC'
+constexpr int32_t kCodecListCacheVersion = 1;
+
+const char *getCodecListCachePath() {
+    if (!property_get_bool("debug.stagefright.codec_list_cache", true)) {
+        return nullptr;
+    }
+    return kCodecListCache;
+}
+
+// Hashes the name and contents of the codec list XML files, including the
+// profiling results, and of the manifests of the media modules, with 64-bit
+// FNV-1a. A module update changes its manifest version without necessarily
+// changing the build fingerprints.
+uint64_t hashCodecListFiles() {
+    uint64_t hash = 14695981039346656037ULL;
+    auto hashBytes = [&hash](const void *data, size_t size) {
+        const uint8_t *bytes = (const uint8_t *)data;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    auto hashFile = [&hashBytes](const std::string &path) {
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return;
+        }
+        hashBytes(path.c_str(), path.size() + 1);
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            hashBytes(buffer, read);
+        }
+        fclose(file);
+    };
+
+    // Included files share the prefix of the files that include them.
+    std::vector<std::string> dirs = MediaCodecsXmlParser::getDefaultSearchDirs();
+    dirs.push_back("/apex/com.android.media.swcodec/etc");
+    for (const std::string &dir : dirs) {
+        DIR *d = opendir(dir.c_str());
+        if (d == nullptr) {
+            continue;
+        }
+        std::vector<std::string> names;
+        while (struct dirent *entry = readdir(d)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, strlen("media_codecs"), "media_codecs") == 0
+                    && name.size() > strlen(".xml")
+                    && name.compare(name.size() - strlen(".xml"), strlen(".xml"), ".xml") == 0) {
+                names.push_back(name);
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        for (const std::string &name : names) {
+            hashFile(dir + "/" + name);
+        }
+    }
+    hashFile(kProfilingResults);
+    hashFile("/apex/com.android.media.swcodec/apex_manifest.pb");
+    hashFile("/apex/com.android.media/apex_manifest.pb");
+    return hash;
+}
+
+// The build fingerprints cover the components behind the builders, the
+// properties cover the options that change what the builders list.
+std::string getCodecListCacheKey() {
+    std::string key = AStringPrintf("v%d", kCodecListCacheVersion).c_str();
+    for (const char *name : {
+            "ro.build.fingerprint",
+            "ro.vendor.build.fingerprint",
+            "ro.media.xml_variant.codecs",
+            "ro.media.xml_variant.codecs_performance",
+            "debug.stagefright.ccodec",
+            "debug.stagefright.omx_default_rank",
+            "debug.stagefright.omx_default_rank.sw-audio",
+            "debug.stagefright.omx_default_rank.sw-other" }) {
+        char value[PROPERTY_VALUE_MAX];
+        property_get(name, value, "");
+        key.append("|").append(value);
+    }
+    key.append(AStringPrintf("|%016" PRIx64, hashCodecListFiles()).c_str());
+    return key;
+}
+
 OmxInfoBuilder sOmxInfoBuilder{true /* allowSurfaceEncoders */};
 OmxInfoBuilder sOmxNoSurfaceEncoderInfoBuilder{false /* allowSurfaceEncoders */};
 
@@ -129,7 +225,8 @@ void *MediaCodecList::profilerThreadWrapper(void * /*arg*/) {
     ALOGV("Codec profiling started.");
     profileCodecs(infos, kProfilingResults);
     ALOGV("Codec profiling completed.");
-    codecList = new MediaCodecList(GetBuilders());
+    // the new profiling results invalidate the cache
+    codecList = new MediaCodecList(GetBuilders(), getCodecListCachePath());
     if (codecList->initCheck() != OK) {
         ALOGW("Failed to parse profiling results.");
         return nullptr;
@@ -147,7 +244,7 @@ sp<IMediaCodecList> MediaCodecList::getLocalInstance() {
     Mutex::Autolock autoLock(sInitMutex);
 
     if (sCodecList == nullptr) {
-        MediaCodecList *codecList = new MediaCodecList(GetBuilders());
+        MediaCodecList *codecList = new MediaCodecList(GetBuilders(), getCodecListCachePath());
         if (codecList->initCheck() == OK) {
             sCodecList = codecList;
 
@@ -200,18 +297,31 @@ sp<IMediaCodecList> MediaCodecList::getInstance() {
     return sRemoteList;
 }
 
-MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders) {
+MediaCodecList::MediaCodecList(
+        std::vector<MediaCodecListBuilderBase*> builders, const char *cachePath) {
     mGlobalSettings = new AMessage();
     mCodecInfos.clear();
     MediaCodecListWriter writer;
-    for (MediaCodecListBuilderBase *builder : builders) {
-        if (builder == nullptr) {
-            ALOGD("ignored a null builder");
-            continue;
+    std::string cacheKey;
+    if (cachePath != nullptr) {
+        cacheKey = getCodecListCacheKey();
+    }
+    if (cachePath != nullptr && LoadCache(cachePath, cacheKey, &writer)) {
+        ALOGV("loaded codec list from %s", cachePath);
+        mInitCheck = OK;
+    } else {
+        for (MediaCodecListBuilderBase *builder : builders) {
+            if (builder == nullptr) {
+                ALOGD("ignored a null builder");
+                continue;
+            }
+            mInitCheck = builder->buildMediaCodecList(&writer);
+            if (mInitCheck != OK) {
+                break;
+            }
         }
-        mInitCheck = builder->buildMediaCodecList(&writer);
-        if (mInitCheck != OK) {
-            break;
+        if (cachePath != nullptr && mInitCheck == OK) {
+            SaveCache(cachePath, cacheKey, writer);
         }
     }
     writer.writeGlobalSettings(mGlobalSettings);
@@ -244,6 +354,104 @@ MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders)
 MediaCodecList::~MediaCodecList() {
 }
 
+// static
+bool MediaCodecList::LoadCache(
+        const char *path, const std::string &key, MediaCodecListWriter *writer) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    Parcel parcel;
+    status_t err = parcel.setData((const uint8_t *)data, st.st_size);
+    munmap(data, st.st_size);
+    if (err != OK) {
+        return false;
+    }
+
+    if (parcel.readInt32() != kCodecListCacheMagic) {
+        ALOGW("ignoring malformed codec list cache %s", path);
+        return false;
+    }
+    const char *cachedKey = parcel.readCString();
+    if (cachedKey == nullptr || key != cachedKey) {
+        ALOGV("codec list cache %s is out of date", path);
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> settings;
+    int32_t count = parcel.readInt32();
+    for (int32_t i = 0; i < count; ++i) {
+        const char *settingKey = parcel.readCString();
+        const char *settingValue = parcel.readCString();
+        if (settingKey == nullptr || settingValue == nullptr) {
+            ALOGW("ignoring truncated codec list cache %s", path);
+            return false;
+        }
+        settings.emplace_back(settingKey, settingValue);
+    }
+    std::vector<sp<MediaCodecInfo>> infos;
+    count = parcel.readInt32();
+    for (int32_t i = 0; i < count; ++i) {
+        sp<MediaCodecInfo> info =
+                parcel.dataAvail() > 0 ? MediaCodecInfo::FromParcel(parcel) : nullptr;
+        if (info == nullptr) {
+            ALOGW("ignoring truncated codec list cache %s", path);
+            return false;
+        }
+        infos.push_back(info);
+    }
+    writer->mGlobalSettings.insert(
+            writer->mGlobalSettings.end(), settings.begin(), settings.end());
+    writer->mCodecInfos.insert(writer->mCodecInfos.end(), infos.begin(), infos.end());
+    return true;
+}
+
+// static
+void MediaCodecList::SaveCache(
+        const char *path, const std::string &key, const MediaCodecListWriter &writer) {
+    Parcel parcel;
+    parcel.writeInt32(kCodecListCacheMagic);
+    parcel.writeCString(key.c_str());
+    parcel.writeInt32(writer.mGlobalSettings.size());
+    for (const std::pair<std::string, std::string> &setting : writer.mGlobalSettings) {
+        parcel.writeCString(setting.first.c_str());
+        parcel.writeCString(setting.second.c_str());
+    }
+    parcel.writeInt32(writer.mCodecInfos.size());
+    for (const sp<MediaCodecInfo> &info : writer.mCodecInfos) {
+        if (info->writeToParcel(&parcel) != OK) {
+            return;
+        }
+    }
+
+    // Write a new file and rename it, readers in other processes only ever
+    // map a complete cache. The file name is unique so that processes saving
+    // the cache concurrently do not write into each other's file.
+    std::string tmpPath = std::string(path) + ".XXXXXX";
+    int fd = mkostemp(&tmpPath[0], O_CLOEXEC);
+    if (fd < 0) {
+        ALOGV("cannot write codec list cache %s", tmpPath.c_str());
+        return;
+    }
+    bool written = fchmod(fd, 0644) == 0
+            && write(fd, parcel.data(), parcel.dataSize()) == (ssize_t)parcel.dataSize()
+            && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(tmpPath.c_str(), path) != 0) {
+        ALOGW("failed to save codec list cache %s", path);
+        unlink(tmpPath.c_str());
+    }
+}
+
 status_t MediaCodecList::initCheck() const {
     return mInitCheck;
 }
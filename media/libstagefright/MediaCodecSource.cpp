@@ -444,6 +444,7 @@ MediaCodecSource::MediaCodecSource(
     : mLooper(looper),
       mOutputFormat(outputFormat),
       mMeta(new MetaData),
+      mSurfaceSourceStarted(false),
       mFlags(flags),
       mIsVideo(false),
       mStarted(false),
@@ -462,6 +463,8 @@ MediaCodecSource::MediaCodecSource(
 
     if (!(mFlags & FLAG_USE_SURFACE_INPUT)) {
         mPuller = new Puller(source);
+    } else {
+        mSurfaceSource = source;
     }
 }
 
@@ -675,6 +678,14 @@ void MediaCodecSource::signalEOS(status_t err) {
     }
 }
 
+void MediaCodecSource::stopSurfaceSource() {
+    if (mSurfaceSourceStarted) {
+        ALOGV("surface source (%s) stopping", mIsVideo ? "video" : "audio");
+        mSurfaceSource->stop();
+        mSurfaceSourceStarted = false;
+    }
+}
+
 void MediaCodecSource::resume(int64_t resumeStartTimeUs) {
     CHECK(mFlags & FLAG_USE_SURFACE_INPUT);
     if (mEncoder != NULL) {
@@ -733,15 +744,18 @@ status_t MediaCodecSource::feedEncoderInputBuffers() {
             status_t err = mEncoder->getInputBuffer(bufferIndex, &inbuf);
 
             if (err != OK || inbuf == NULL || inbuf->data() == NULL
-                    || mbuf->data() == NULL || mbuf->size() == 0) {
+                    || mbuf->data() == NULL || mbuf->range_length() == 0
+                    || mbuf->range_length() > inbuf->capacity()) {
                 mbuf->release();
                 signalEOS();
                 break;
             }
 
-            size = mbuf->size();
+            // Sources such as AudioSource hand out pooled buffers that may be
+            // larger than the data they hold.
+            size = mbuf->range_length();
 
-            memcpy(inbuf->data(), mbuf->data(), size);
+            memcpy(inbuf->data(), (const uint8_t *)mbuf->data() + mbuf->range_offset(), size);
 
             if (mIsVideo) {
                 // video encoder will release MediaBuffer when done
@@ -807,6 +821,13 @@ status_t MediaCodecSource::onStart(MetaData *params) {
             }
             mEncoder->setParameters(params);
         }
+        if (mSurfaceSource != NULL) {
+            err = mSurfaceSource->start(params);
+            if (err != OK) {
+                return err;
+            }
+            mSurfaceSourceStarted = true;
+        }
     } else {
         CHECK(mPuller != NULL);
         sp<MetaData> meta = params;
@@ -1015,6 +1036,7 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
             // if we already reached EOS, reply and return now
             ALOGI("encoder (%s) already stopped",
                     mIsVideo ? "video" : "audio");
+            stopSurfaceSource();
             (new AMessage)->postReply(replyID);
             break;
         }
@@ -1034,6 +1056,8 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
         // and wait for the EOS message. We cannot call source->stop() because
         // the encoder may still be processing input buffers.
         if (mFlags & FLAG_USE_SURFACE_INPUT) {
+            // No more frames are rendered after those that are already queued.
+            stopSurfaceSource();
             mEncoder->signalEndOfInputStream();
             // Increase the timeout if there is delay in the GraphicBufferSource
             sp<AMessage> inputFormat;
@@ -36,6 +36,9 @@
 
 #include <dirent.h>
 #include <dlfcn.h>
+#include <string.h>
+
+#include <vector>
 
 namespace android {
 
@@ -50,12 +53,9 @@ sp<IMediaExtractor> MediaExtractorFactory::Create(
         return CreateFromService(source, mime);
     } else {
         // remote extractor
-        ALOGV("get service manager");
-        sp<IBinder> binder = defaultServiceManager()->getService(String16("media.extractor"));
+        sp<IMediaExtractorService> mediaExService = GetExtractorService();
 
-        if (binder != 0) {
-            sp<IMediaExtractorService> mediaExService(
-                    interface_cast<IMediaExtractorService>(binder));
+        if (mediaExService != nullptr) {
             sp<IMediaExtractor> ex;
             mediaExService->makeExtractor(
                     CreateIDataSourceFromDataSource(source),
@@ -70,6 +70,36 @@ sp<IMediaExtractor> MediaExtractorFactory::Create(
     return NULL;
 }
 
+static Mutex gExtractorServiceLock;
+static sp<IMediaExtractorService> gExtractorService;
+
+struct ExtractorServiceDeathRecipient : public IBinder::DeathRecipient {
+    void binderDied(const wp<IBinder> &who) override {
+        Mutex::Autolock autoLock(gExtractorServiceLock);
+        if (gExtractorService != nullptr
+                && IInterface::asBinder(gExtractorService) == who.promote()) {
+            ALOGW("media.extractor died, reconnecting on next use");
+            gExtractorService.clear();
+        }
+    }
+};
+
+// static
+sp<IMediaExtractorService> MediaExtractorFactory::GetExtractorService() {
+    Mutex::Autolock autoLock(gExtractorServiceLock);
+    if (gExtractorService == nullptr) {
+        ALOGV("get service manager");
+        sp<IBinder> binder = defaultServiceManager()->getService(String16("media.extractor"));
+        if (binder == nullptr) {
+            return nullptr;
+        }
+        static sp<IBinder::DeathRecipient> sDeathRecipient = new ExtractorServiceDeathRecipient;
+        binder->linkToDeath(sDeathRecipient);
+        gExtractorService = interface_cast<IMediaExtractorService>(binder);
+    }
+    return gExtractorService;
+}
+
 sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
         const sp<DataSource> &source, const char *mime) {
 
@@ -128,6 +158,101 @@ std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
 bool MediaExtractorFactory::gIgnoreVersion = false;
 
+// Serves the reads of the sniffers from the start of the file from one buffer,
+// so that the header is read from the source once instead of once per plugin.
+struct SniffBufferSource : public DataSource {
+    static const size_t kBufferSize = 64 * 1024;
+
+    explicit SniffBufferSource(const sp<DataSource> &source)
+        : mSource(source), mFilled(false) {
+    }
+
+    virtual status_t initCheck() const {
+        return mSource->initCheck();
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        if (offset < 0) {
+            return mSource->readAt(offset, data, size);
+        }
+        fill();
+        if ((uint64_t)offset + size <= mBuffer.size()) {
+            memcpy(data, mBuffer.data() + offset, size);
+            return size;
+        }
+        return mSource->readAt(offset, data, size);
+    }
+
+    virtual status_t getSize(off64_t *size) {
+        return mSource->getSize(size);
+    }
+
+    virtual uint32_t flags() {
+        return mSource->flags();
+    }
+
+    virtual String8 toString() {
+        return mSource->toString();
+    }
+
+    virtual String8 getUri() {
+        return mSource->getUri();
+    }
+
+    virtual String8 getMIMEType() const {
+        return mSource->getMIMEType();
+    }
+
+    // The header, empty if it could not be read.
+    const std::vector<uint8_t> &header() {
+        fill();
+        return mBuffer;
+    }
+
+private:
+    sp<DataSource> mSource;
+    bool mFilled;
+    std::vector<uint8_t> mBuffer;
+
+    void fill() {
+        if (mFilled) {
+            return;
+        }
+        mFilled = true;
+        mBuffer.resize(kBufferSize);
+        ssize_t n = mSource->readAt(0, mBuffer.data(), mBuffer.size());
+        mBuffer.resize(n > 0 ? n : 0);
+    }
+};
+
+// Plugins that are sniffed first for files that start with their signature.
+// If that plugin accepts the file, the other plugins are not sniffed.
+static const struct {
+    size_t mOffset;
+    const char *mMagic;
+    size_t mMagicSize;
+    const char *mUuid;
+} kSignatures[] = {
+    { 4, "ftyp", 4, "27575c6744174c548d3d8e626985a164" },               // MPEG4
+    { 0, "\x1a\x45\xdf\xa3", 4, "abbedd9238c44904a4c1b3f45f899980" },   // Matroska
+    { 0, "fLaC", 4, "1364b048cc454fda9934327d0ebf9829" },               // FLAC
+    { 0, "OggS", 4, "8cc5cd06f772495e8a62cba9649374e9" },               // Ogg
+    { 8, "WAVE", 4, "7d61385858374a3884c5332d1cddee27" },               // WAV
+    { 0, "#!AMR", 5, "c86639c92f3140aca715fa01b4493aaf" },              // AMR
+    { 0, "MThd", 4, "ef6cca0af8a243e6ba5fdfcd7c9a7ef2" },               // MIDI
+};
+
+static const char *findSignature(const std::vector<uint8_t> &header) {
+    for (const auto &signature : kSignatures) {
+        if (header.size() >= signature.mOffset + signature.mMagicSize
+                && !memcmp(header.data() + signature.mOffset,
+                        signature.mMagic, signature.mMagicSize)) {
+            return signature.mUuid;
+        }
+    }
+    return nullptr;
+}
+
 // static
 void *MediaExtractorFactory::sniff(
         const sp<DataSource> &source, float *confidence, void **meta,
@@ -144,20 +269,22 @@ void *MediaExtractorFactory::sniff(
         plugins = gPlugins;
     }
 
+    sp<SniffBufferSource> sniffSource = new SniffBufferSource(source);
+
     void *bestCreator = NULL;
-    for (auto it = plugins->begin(); it != plugins->end(); ++it) {
-        ALOGV("sniffing %s", (*it)->def.extractor_name);
+    auto sniffPlugin = [&](const sp<ExtractorPlugin> &candidate) {
+        ALOGV("sniffing %s", candidate->def.extractor_name);
         float newConfidence;
         void *newMeta = nullptr;
         FreeMetaFunc newFreeMeta = nullptr;
 
         void *curCreator = NULL;
-        if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
-            curCreator = (void*) (*it)->def.u.v2.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        } else if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
-            curCreator = (void*) (*it)->def.u.v3.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+        if (candidate->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
+            curCreator = (void*) candidate->def.u.v2.sniff(
+                    sniffSource->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+        } else if (candidate->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
+            curCreator = (void*) candidate->def.u.v3.sniff(
+                    sniffSource->wrap(), &newConfidence, &newMeta, &newFreeMeta);
         }
 
         if (curCreator) {
@@ -168,15 +295,35 @@ void *MediaExtractorFactory::sniff(
                 }
                 *meta = newMeta;
                 *freeMeta = newFreeMeta;
-                plugin = *it;
+                plugin = candidate;
                 bestCreator = curCreator;
-                *creatorVersion = (*it)->def.def_version;
+                *creatorVersion = candidate->def.def_version;
             } else {
                 if (newMeta != nullptr && newFreeMeta != nullptr) {
                     newFreeMeta(newMeta);
                 }
             }
         }
+    };
+
+    sp<ExtractorPlugin> likelyPlugin;
+    const char *uuid = findSignature(sniffSource->header());
+    if (uuid != nullptr) {
+        for (auto it = plugins->begin(); it != plugins->end(); ++it) {
+            if ((*it)->uuidString == uuid) {
+                likelyPlugin = *it;
+                sniffPlugin(likelyPlugin);
+                break;
+            }
+        }
+    }
+
+    if (bestCreator == NULL) {
+        for (auto it = plugins->begin(); it != plugins->end(); ++it) {
+            if (*it != likelyPlugin) {
+                sniffPlugin(*it);
+            }
+        }
     }
 
     return bestCreator;
@@ -331,11 +478,9 @@ std::vector<std::string> MediaExtractorFactory::getSupportedTypes() {
     if (getuid() == AID_MEDIA_EX) {
         return gSupportedExtensions;
     }
-    ALOGV("get service manager");
-    sp<IBinder> binder = defaultServiceManager()->getService(String16("media.extractor"));
+    sp<IMediaExtractorService> mediaExService = GetExtractorService();
 
-    if (binder != 0) {
-        sp<IMediaExtractorService> mediaExService(interface_cast<IMediaExtractorService>(binder));
+    if (mediaExService != nullptr) {
         std::vector<std::string> supportedTypes;
         mediaExService->getSupportedTypes(&supportedTypes);
         return supportedTypes;
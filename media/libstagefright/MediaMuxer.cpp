@@ -21,6 +21,10 @@
 
 #include <utils/Log.h>
 
+#include <inttypes.h>
+
+#include <algorithm>
+
 #include <media/stagefright/MediaMuxer.h>
 
 #include <media/mediarecorder.h>
@@ -40,6 +44,9 @@
 
 namespace android {
 
+static const int64_t kDefaultMaxInterleaveDelayUs = 1000000LL;
+static const size_t kDefaultMaxInterleaveBytes = 8 * 1024 * 1024;
+
 static bool isMp4Format(MediaMuxer::OutputFormat format) {
     return format == MediaMuxer::OUTPUT_FORMAT_MPEG_4 ||
            format == MediaMuxer::OUTPUT_FORMAT_THREE_GPP ||
@@ -48,6 +55,14 @@ static bool isMp4Format(MediaMuxer::OutputFormat format) {
 
 MediaMuxer::MediaMuxer(int fd, OutputFormat format)
     : mFormat(format),
+      mMaxInterleaveDelayUs(kDefaultMaxInterleaveDelayUs),
+      mMaxInterleaveBytes(kDefaultMaxInterleaveBytes),
+      mPendingBytes(0),
+      mLastTimeUs(INT64_MIN),
+      mNumHeldSamples(0),
+      mMaxPendingBytes(0),
+      mNumDelayLimitedSamples(0),
+      mNumSizeLimitedSamples(0),
       mState(UNINITIALIZED) {
     if (isMp4Format(format)) {
         mWriter = new MPEG4Writer(fd);
@@ -76,6 +91,7 @@ MediaMuxer::~MediaMuxer() {
     mFileMeta.clear();
     mWriter.clear();
     mTrackList.clear();
+    mTrackSamples.clear();
 }
 
 ssize_t MediaMuxer::addTrack(const sp<AMessage> &format) {
@@ -109,6 +125,10 @@ ssize_t MediaMuxer::addTrack(const sp<AMessage> &format) {
             ALOGW("addTrack() setCaptureRate failed :%d", result);
         }
     }
+    TrackSamples samples;
+    samples.mLastTimeUs = INT64_MIN;
+    samples.mEos = false;
+    mTrackSamples.push_back(samples);
     return mTrackList.add(newTrack);
 }
 
@@ -143,6 +163,27 @@ status_t MediaMuxer::setLocation(int latitude, int longitude) {
     return static_cast<MPEG4Writer*>(mWriter.get())->setGeoData(latitude, longitude);
 }
 
+status_t MediaMuxer::setInterleaving(int64_t maxDelayUs, size_t maxBytes) {
+    Mutex::Autolock autoLock(mMuxerLock);
+    if (mState != INITIALIZED) {
+        ALOGE("setInterleaving() must be called before start().");
+        return INVALID_OPERATION;
+    }
+    if (maxDelayUs < 0) {
+        ALOGE("setInterleaving() get invalid delay %" PRId64, maxDelayUs);
+        return -EINVAL;
+    }
+
+    mMaxInterleaveDelayUs = maxDelayUs;
+    mMaxInterleaveBytes = maxBytes;
+    return OK;
+}
+
+bool MediaMuxer::isInterleaving() const {
+    return mMaxInterleaveDelayUs > 0 && mMaxInterleaveBytes > 0
+            && mFormat != OUTPUT_FORMAT_HEIF && mTrackList.size() > 1;
+}
+
 status_t MediaMuxer::start() {
     Mutex::Autolock autoLock(mMuxerLock);
     if (mState == INITIALIZED) {
@@ -159,6 +200,14 @@ status_t MediaMuxer::stop() {
     Mutex::Autolock autoLock(mMuxerLock);
     if (mState == STARTED) {
         mState = STOPPED;
+        if (drainPendingSamples_l(true /* all */) != OK) {
+            ALOGW("stop() failed to write held samples");
+        }
+        if (isInterleaving()) {
+            ALOGI("Interleaving held %zu samples, up to %zu bytes; %zu released by the delay"
+                  " limit and %zu by the size limit", mNumHeldSamples, mMaxPendingBytes,
+                  mNumDelayLimitedSamples, mNumSizeLimitedSamples);
+        }
         for (size_t i = 0; i < mTrackList.size(); i++) {
             if (mTrackList[i]->stop() != OK) {
                 return INVALID_OPERATION;
@@ -194,6 +243,85 @@ status_t MediaMuxer::writeSampleData(const sp<ABuffer> &buffer, size_t trackInde
         return -EINVAL;
     }
 
+    if (!isInterleaving()) {
+        return pushSample_l(buffer, trackIndex, timeUs, flags);
+    }
+
+    TrackSamples &track = mTrackSamples[trackIndex];
+    track.mPending.push_back({buffer, timeUs, flags});
+    track.mLastTimeUs = std::max(track.mLastTimeUs, timeUs);
+    mLastTimeUs = std::max(mLastTimeUs, timeUs);
+    if (flags & MediaCodec::BUFFER_FLAG_EOS) {
+        track.mEos = true;
+    }
+    mPendingBytes += buffer->size();
+    mMaxPendingBytes = std::max(mMaxPendingBytes, mPendingBytes);
+
+    status_t err = drainPendingSamples_l(false /* all */);
+
+    // The buffer can be reused once this method returns, so a sample that is
+    // still held has to be copied.
+    if (!track.mPending.empty() && track.mPending.back().mBuffer == buffer) {
+        track.mPending.back().mBuffer = ABuffer::CreateAsCopy(buffer->data(), buffer->size());
+        ++mNumHeldSamples;
+    }
+    return err;
+}
+
+status_t MediaMuxer::drainPendingSamples_l(bool all) {
+    status_t err = OK;
+    for (;;) {
+        // The held sample with the earliest timestamp.
+        size_t trackIndex = mTrackSamples.size();
+        for (size_t i = 0; i < mTrackSamples.size(); i++) {
+            const std::deque<PendingSample> &pending = mTrackSamples[i].mPending;
+            if (!pending.empty() && (trackIndex == mTrackSamples.size()
+                    || pending.front().mTimeUs
+                            < mTrackSamples[trackIndex].mPending.front().mTimeUs)) {
+                trackIndex = i;
+            }
+        }
+        if (trackIndex == mTrackSamples.size()) {
+            break;
+        }
+        const PendingSample &sample = mTrackSamples[trackIndex].mPending.front();
+
+        // It is due once every other track has been written up to its timestamp,
+        // so that no earlier sample can come after it.
+        bool due = true;
+        for (size_t i = 0; !all && i < mTrackSamples.size(); i++) {
+            if (i != trackIndex && !mTrackSamples[i].mEos
+                    && mTrackSamples[i].mLastTimeUs < sample.mTimeUs) {
+                due = false;
+                break;
+            }
+        }
+        if (!due && mLastTimeUs - sample.mTimeUs > mMaxInterleaveDelayUs) {
+            ++mNumDelayLimitedSamples;
+            due = true;
+        }
+        if (!due && mPendingBytes > mMaxInterleaveBytes) {
+            ++mNumSizeLimitedSamples;
+            due = true;
+        }
+        if (!due) {
+            break;
+        }
+
+        PendingSample released = sample;
+        mTrackSamples[trackIndex].mPending.pop_front();
+        mPendingBytes -= released.mBuffer->size();
+        status_t pushErr = pushSample_l(
+                released.mBuffer, trackIndex, released.mTimeUs, released.mFlags);
+        if (err == OK) {
+            err = pushErr;
+        }
+    }
+    return err;
+}
+
+status_t MediaMuxer::pushSample_l(const sp<ABuffer> &buffer, size_t trackIndex,
+                                  int64_t timeUs, uint32_t flags) {
     MediaBuffer* mediaBuffer = new MediaBuffer(buffer);
 
     mediaBuffer->add_ref(); // Released in MediaAdapter::signalBufferReturned().
@@ -788,12 +788,18 @@ void MediaSync::onMessageReceived(const sp<AMessage> &msg) {
                 int64_t nowUs = ALooper::GetNowUs();
                 int64_t itemRealUs = getRealTime(mNextBufferItemMediaUs, nowUs);
 
-                // The message could arrive earlier than expected due to
-                // various reasons, e.g., media clock has been changed because
-                // of new anchor time or playback rate. In such cases, the
-                // message needs to be re-posted.
-                if (itemRealUs > nowUs) {
-                    msg->post(itemRealUs - nowUs);
+                // onDrainVideo_l() releases frames 2 display refreshes before
+                // they are due, and the message is posted for that time. Only
+                // re-post if it arrives earlier than that, e.g., media clock
+                // has been changed because of new anchor time or playback rate.
+                // Waiting for the render time itself would cost a second looper
+                // hop per frame and release frames too late to make their vsync.
+                int64_t twoVsyncsUs = 0;
+                if (mFrameScheduler != NULL) {
+                    twoVsyncsUs = 2 * (mFrameScheduler->getVsyncPeriod() / 1000);
+                }
+                if (itemRealUs > nowUs + twoVsyncsUs) {
+                    msg->post(itemRealUs - nowUs - twoVsyncsUs);
                     break;
                 }
             }
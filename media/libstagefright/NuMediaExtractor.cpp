@@ -620,21 +620,21 @@ status_t NuMediaExtractor::advance() {
 }
 
 status_t NuMediaExtractor::appendVorbisNumPageSamples(
-        MediaBufferBase *mbuf, const sp<ABuffer> &buffer) {
+        MediaBufferBase *mbuf, uint8_t *data) {
     int32_t numPageSamples;
     if (!mbuf->meta_data().findInt32(
             kKeyValidSamples, &numPageSamples)) {
         numPageSamples = -1;
     }
 
-    memcpy((uint8_t *)buffer->data() + mbuf->range_length(),
+    memcpy(data + mbuf->range_length(),
            &numPageSamples,
            sizeof(numPageSamples));
 
     uint32_t type;
-    const void *data;
+    const void *sizesData;
     size_t size, size2;
-    if (mbuf->meta_data().findData(kKeyEncryptedSizes, &type, &data, &size)) {
+    if (mbuf->meta_data().findData(kKeyEncryptedSizes, &type, &sizesData, &size)) {
         // Signal numPageSamples (a plain int32_t) is appended at the end,
         // i.e. sizeof(numPageSamples) plain bytes + 0 encrypted bytes
         if (SIZE_MAX - size < sizeof(int32_t)) {
@@ -650,15 +650,15 @@ status_t NuMediaExtractor::appendVorbisNumPageSamples(
 
         // append 0 to encrypted sizes
         int32_t zero = 0;
-        memcpy(adata, data, size);
+        memcpy(adata, sizesData, size);
         memcpy(adata + size, &zero, sizeof(zero));
         mbuf->meta_data().setData(kKeyEncryptedSizes, type, adata, newSize);
 
-        if (mbuf->meta_data().findData(kKeyPlainSizes, &type, &data, &size2)) {
+        if (mbuf->meta_data().findData(kKeyPlainSizes, &type, &sizesData, &size2)) {
             if (size2 != size) {
                 return ERROR_MALFORMED;
             }
-            memcpy(adata, data, size);
+            memcpy(adata, sizesData, size);
         } else {
             // if sample meta data does not include plain size array, assume filled with zeros,
             // i.e. entire buffer is encrypted
@@ -674,6 +674,15 @@ status_t NuMediaExtractor::appendVorbisNumPageSamples(
 }
 
 status_t NuMediaExtractor::readSampleData(const sp<ABuffer> &buffer) {
+    size_t sampleSize;
+    status_t err = readSampleData(buffer->data(), buffer->capacity(), &sampleSize);
+    if (err == OK) {
+        buffer->setRange(0, sampleSize);
+    }
+    return err;
+}
+
+status_t NuMediaExtractor::readSampleData(uint8_t *data, size_t capacity, size_t *size) {
     Mutex::Autolock autoLock(mLock);
 
     ssize_t minIndex = fetchAllTrackSamples();
@@ -693,7 +702,7 @@ status_t NuMediaExtractor::readSampleData(const sp<ABuffer> &buffer) {
         sampleSize += sizeof(int32_t);
     }
 
-    if (buffer->capacity() < sampleSize) {
+    if (capacity < sampleSize) {
         return -ENOMEM;
     }
 
@@ -701,15 +710,15 @@ status_t NuMediaExtractor::readSampleData(const sp<ABuffer> &buffer) {
         (const uint8_t *)it->mBuffer->data()
             + it->mBuffer->range_offset();
 
-    memcpy((uint8_t *)buffer->data(), src, it->mBuffer->range_length());
+    memcpy(data, src, it->mBuffer->range_length());
 
     status_t err = OK;
     if (info->mTrackFlags & kIsVorbis) {
-        err = appendVorbisNumPageSamples(it->mBuffer, buffer);
+        err = appendVorbisNumPageSamples(it->mBuffer, data);
     }
 
     if (err == OK) {
-        buffer->setRange(0, sampleSize);
+        *size = sampleSize;
     }
 
     return err;
@@ -331,7 +331,16 @@ VideoFrameSchedulerBase::VideoFrameSchedulerBase()
       mVsyncPeriod(0),
       mVsyncRefreshAt(0),
       mLastVsyncTime(-1),
-      mTimeCorrection(0) {
+      mTimeCorrection(0),
+      mVsyncsForPrevFrames{-1, -1} {
+}
+
+VideoFrameSchedulerBase::JudderStats::JudderStats()
+    : mFrames(0),
+      mJudderFrames(0),
+      mPulldownFrames(0),
+      mMissedFrames(0),
+      mVsyncsPerFrame{} {
 }
 
 void VideoFrameSchedulerBase::init(float videoFps) {
@@ -339,6 +348,8 @@ void VideoFrameSchedulerBase::init(float videoFps) {
 
     mLastVsyncTime = -1;
     mTimeCorrection = 0;
+    mJudderStats = JudderStats();
+    mVsyncsForPrevFrames[0] = mVsyncsForPrevFrames[1] = -1;
 
     mPll.reset(videoFps);
 }
@@ -346,6 +357,7 @@ void VideoFrameSchedulerBase::init(float videoFps) {
 void VideoFrameSchedulerBase::restart() {
     mLastVsyncTime = -1;
     mTimeCorrection = 0;
+    mVsyncsForPrevFrames[0] = mVsyncsForPrevFrames[1] = -1;
 
     mPll.restart();
 }
@@ -365,6 +377,36 @@ float VideoFrameSchedulerBase::getFrameRate() {
     return 0.f;
 }
 
+float VideoFrameSchedulerBase::getPreferredRefreshRate() {
+    nsecs_t videoPeriod = mPll.getPeriod();
+    if (videoPeriod <= 0) {
+        return 0.f;
+    }
+
+    // pick the multiple of the frame rate nearest to the current refresh rate
+    nsecs_t multiple = max(divRound(videoPeriod, getVsyncPeriod()), (nsecs_t)1);
+    return 1e9 * multiple / videoPeriod;
+}
+
+void VideoFrameSchedulerBase::updateJudderStats(size_t vsyncsForLastFrame) {
+    ++mJudderStats.mFrames;
+    ++mJudderStats.mVsyncsPerFrame[min(vsyncsForLastFrame, kVsyncHistogramSize - 1)];
+    if (vsyncsForLastFrame == 0) {
+        ++mJudderStats.mMissedFrames;
+    }
+
+    ssize_t vsyncs = (ssize_t)vsyncsForLastFrame;
+    if (mVsyncsForPrevFrames[1] >= 0 && vsyncs != mVsyncsForPrevFrames[1]) {
+        ++mJudderStats.mJudderFrames;
+        // alternating between two cadences, e.g. 3, 2, 3, 2...
+        if (vsyncs == mVsyncsForPrevFrames[0] && abs(vsyncs - mVsyncsForPrevFrames[1]) == 1) {
+            ++mJudderStats.mPulldownFrames;
+        }
+    }
+    mVsyncsForPrevFrames[0] = mVsyncsForPrevFrames[1];
+    mVsyncsForPrevFrames[1] = vsyncs;
+}
+
 nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
     nsecs_t origRenderTime = renderTime;
 
@@ -452,6 +494,7 @@ nsecs_t VideoFrameSchedulerBase::schedule(nsecs_t renderTime) {
             }
 
             ATRACE_INT("FRAME_VSYNCS", vsyncsForLastFrame);
+            updateJudderStats(vsyncsForLastFrame);
         }
         mLastVsyncTime = nextVsyncTime;
     }
@@ -42,6 +42,7 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <cmath>
@@ -330,6 +331,9 @@ GraphicBufferSource::GraphicBufferSource() :
     mExecuting(false),
     mSuspended(false),
     mLastFrameTimestampUs(-1),
+    mNumFramesSubmitted(0),
+    mNumFramesDroppedForMaxFps(0),
+    mMaxFrameBacklog(0),
     mStopTimeUs(-1),
     mLastActionTimeUs(-1LL),
     mSkipFramesBeforeNs(-1LL),
@@ -471,6 +475,13 @@ status_t GraphicBufferSource::stop() {
         // We are only interested in the transition from executing->idle,
         // not loaded->idle.
         mExecuting = false;
+
+        ALOGD("stop: submitted %lld frames, dropped %lld for max fps, max backlog %zu",
+                (long long)mNumFramesSubmitted, (long long)mNumFramesDroppedForMaxFps,
+                mMaxFrameBacklog);
+        mNumFramesSubmitted = 0;
+        mNumFramesDroppedForMaxFps = 0;
+        mMaxFrameBacklog = 0;
     }
     return OK;
 }
@@ -719,10 +730,16 @@ bool GraphicBufferSource::fillCodecBuffer_l() {
         int64_t timeUs = item.mTimestampNs / 1000;
         if (mFrameDropper != NULL && mFrameDropper->shouldDrop(timeUs)) {
             ALOGV("skipping frame (%lld) to meet max framerate", static_cast<long long>(timeUs));
+            ++mNumFramesDroppedForMaxFps;
             // set err to OK so that the skipped frame can still be saved as the lastest frame
             err = OK;
         } else {
             err = submitBuffer_l(item); // this takes shared ownership of the acquired buffer on succeess
+            if (err == OK) {
+                ++mNumFramesSubmitted;
+                mMaxFrameBacklog = std::max(mMaxFrameBacklog,
+                        mAvailableBuffers.size() + (size_t)mNumAvailableUnacquiredBuffers);
+            }
         }
     }
 
@@ -367,6 +367,12 @@ private:
 
     int64_t mLastFrameTimestampUs;
 
+    // Input pacing statistics for the current executing session, logged on stop(). The
+    // backlog is the number of frames still waiting behind a frame when it is submitted.
+    int64_t mNumFramesSubmitted;
+    int64_t mNumFramesDroppedForMaxFps;
+    size_t mMaxFrameBacklog;
+
     // Our BufferQueue interfaces. mProducer is passed to the producer through
     // getIGraphicBufferProducer, and mConsumer is used internally to retrieve
     // the buffers queued by the producer.
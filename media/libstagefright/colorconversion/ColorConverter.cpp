@@ -27,10 +27,15 @@
 
 #include "libyuv/convert_from.h"
 #include "libyuv/convert_argb.h"
+#include "libyuv/convert_from_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
 #include <functional>
 #include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 #define USE_LIBYUV
 #define PERF_PROFILING 0
@@ -54,6 +59,31 @@ static bool isRGB(OMX_COLOR_FORMATTYPE colorFormat) {
             || colorFormat == OMX_COLOR_Format32bitBGRA8888;
 }
 
+// Frames larger than this are converted with one thread per band of rows.
+static const size_t kMinPixelsForThreads = 3840 * 2160;
+static const size_t kMaxThreads = 4;
+
+// Calls convertRows(top, numRows) over the rows of a frame of width x height pixels, in
+// bands of an even number of rows on multiple threads if the frame is large enough.
+static void forEachRowBand(
+        size_t width, size_t height, const std::function<void(size_t, size_t)> &convertRows) {
+    size_t numThreads = 1;
+    if (width * height > kMinPixelsForThreads) {
+        long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        numThreads = std::min(kMaxThreads, (size_t)std::max(1L, numCpus));
+    }
+    size_t bandRows = ((height + numThreads - 1) / numThreads + 1) & ~(size_t)1;
+    std::vector<std::thread> threads;
+    size_t top = 0;
+    for (; top + bandRows < height; top += bandRows) {
+        threads.emplace_back(convertRows, top, bandRows);
+    }
+    convertRows(top, height - top);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
 bool ColorConverter::ColorSpace::isBt709() {
     return (mStandard == ColorUtils::kColorStandardBT709);
 }
@@ -236,11 +266,19 @@ status_t ColorConverter::convert(
         }
 
         case OMX_COLOR_FormatCbYCrY:
+#ifdef USE_LIBYUV
+            err = convertCbYCrYUseLibYUV(src, dst);
+#else
             err = convertCbYCrY(src, dst);
+#endif
             break;
 
         case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+#ifdef USE_LIBYUV
+            err = convertQCOMYUV420SemiPlanarUseLibYUV(src, dst);
+#else
             err = convertQCOMYUV420SemiPlanar(src, dst);
+#endif
             break;
 
         case OMX_COLOR_FormatYUV420SemiPlanar:
@@ -345,28 +383,27 @@ status_t ColorConverter::convertYUV420PlanarUseLibYUV(
     const uint8_t *src_v =
         src_u + (src.mStride / 2) * (src.mHeight / 2);
 
+    int (*func)(const uint8_t*, int, const uint8_t*, int,
+                const uint8_t*, int, uint8_t*, int, int, int);
     switch (mDstFormat) {
     case OMX_COLOR_Format16bitRGB565:
     {
-        DECLARE_YUV2RGBFUNC(func, RGB565);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        DECLARE_YUV2RGBFUNC(rgb565Func, RGB565);
+        func = rgb565Func;
         break;
     }
 
     case OMX_COLOR_Format32BitRGBA8888:
     {
-        DECLARE_YUV2RGBFUNC(func, ABGR);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        DECLARE_YUV2RGBFUNC(abgrFunc, ABGR);
+        func = abgrFunc;
         break;
     }
 
     case OMX_COLOR_Format32bitBGRA8888:
     {
-        DECLARE_YUV2RGBFUNC(func, ARGB);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        DECLARE_YUV2RGBFUNC(argbFunc, ARGB);
+        func = argbFunc;
         break;
     }
 
@@ -374,6 +411,13 @@ status_t ColorConverter::convertYUV420PlanarUseLibYUV(
         return ERROR_UNSUPPORTED;
     }
 
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t top, size_t rows) {
+        (*func)(src_y + top * src.mStride, src.mStride,
+                src_u + (top / 2) * (src.mStride / 2), src.mStride / 2,
+                src_v + (top / 2) * (src.mStride / 2), src.mStride / 2,
+                dst_ptr + top * dst.mStride, dst.mStride, src.cropWidth(), rows);
+    });
+
     return OK;
 }
 
@@ -389,27 +433,88 @@ status_t ColorConverter::convertYUV420SemiPlanarUseLibYUV(
         (const uint8_t *)src.mBits + src.mStride * src.mHeight
         + (src.mCropTop / 2) * src.mStride + src.mCropLeft;
 
+    int (*func)(const uint8_t*, int, const uint8_t*, int, uint8_t*, int, int, int);
     switch (mDstFormat) {
     case OMX_COLOR_Format16bitRGB565:
-        libyuv::NV12ToRGB565(src_y, src.mStride, src_u, src.mStride, (uint8_t *)dst_ptr,
-                dst.mStride, src.cropWidth(), src.cropHeight());
+        func = libyuv::NV12ToRGB565;
         break;
 
     case OMX_COLOR_Format32bitBGRA8888:
-        libyuv::NV12ToARGB(src_y, src.mStride, src_u, src.mStride, (uint8_t *)dst_ptr,
-                dst.mStride, src.cropWidth(), src.cropHeight());
+        func = libyuv::NV12ToARGB;
         break;
 
     case OMX_COLOR_Format32BitRGBA8888:
-        libyuv::NV12ToABGR(src_y, src.mStride, src_u, src.mStride, (uint8_t *)dst_ptr,
-                dst.mStride, src.cropWidth(), src.cropHeight());
+        func = libyuv::NV12ToABGR;
         break;
 
     default:
         return ERROR_UNSUPPORTED;
-   }
+    }
+
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t top, size_t rows) {
+        (*func)(src_y + top * src.mStride, src.mStride,
+                src_u + (top / 2) * src.mStride, src.mStride,
+                dst_ptr + top * dst.mStride, dst.mStride, src.cropWidth(), rows);
+    });
+
+    return OK;
+}
+
+status_t ColorConverter::convertCbYCrYUseLibYUV(
+        const BitmapParams &src, const BitmapParams &dst) {
+    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+
+    const uint8_t *src_ptr = (const uint8_t *)src.mBits
+        + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp;
+
+    // libyuv has no direct UYVY to RGB565 conversion, so go through an ARGB row.
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t top, size_t rows) {
+        std::vector<uint8_t> argb(src.cropWidth() * 4);
+        for (size_t y = top; y < top + rows; ++y) {
+            libyuv::UYVYToARGB(src_ptr + y * src.mStride, src.mStride,
+                    argb.data(), argb.size(), src.cropWidth(), 1);
+            libyuv::ARGBToRGB565(argb.data(), argb.size(),
+                    dst_ptr + y * dst.mStride, dst.mStride, src.cropWidth(), 1);
+        }
+    });
+
+    return OK;
+}
+
+status_t ColorConverter::convertQCOMYUV420SemiPlanarUseLibYUV(
+        const BitmapParams &src, const BitmapParams &dst) {
+    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+
+    const uint8_t *src_y =
+        (const uint8_t *)src.mBits + src.mCropTop * src.mStride + src.mCropLeft;
+
+    const uint8_t *src_vu =
+        (const uint8_t *)src.mBits + src.mStride * src.mHeight
+        + (src.mCropTop / 2) * src.mStride + src.mCropLeft;
 
-   return OK;
+    // libyuv has no direct NV21 to RGB565 conversion, so go through an ARGB row.
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t top, size_t rows) {
+        std::vector<uint8_t> argb(src.cropWidth() * 4);
+        for (size_t y = top; y < top + rows; ++y) {
+            libyuv::NV21ToARGB(src_y + y * src.mStride, src.mStride,
+                    src_vu + (y / 2) * src.mStride, src.mStride,
+                    argb.data(), argb.size(), src.cropWidth(), 1);
+            libyuv::ARGBToRGB565(argb.data(), argb.size(),
+                    dst_ptr + y * dst.mStride, dst.mStride, src.cropWidth(), 1);
+        }
+    });
+
+    return OK;
 }
 
 std::function<void (void *, void *, void *, size_t,
@@ -588,9 +693,75 @@ status_t ColorConverter::convertYUV420Planar16(
         return convertYUV420Planar16ToY410(src, dst);
     }
 
+#ifdef USE_LIBYUV
+    if (convertYUV420Planar16ToRGB(src, dst) == OK) {
+        return OK;
+    }
+#endif
     return convertYUV420Planar(src, dst);
 }
 
+#define DECLARE_YUV10TORGBFUNC(func, rgb) int (*func)(           \
+        const uint16_t*, int, const uint16_t*, int,                 \
+        const uint16_t*, int, uint8_t*, int, int, int)              \
+        = mSrcColorSpace.isBt709() ? libyuv::H010To##rgb           \
+        : libyuv::I010To##rgb
+
+// Converts 10-bit limited range YUV with libyuv, or returns ERROR_UNSUPPORTED
+// for full range sources and RGB565 destinations.
+status_t ColorConverter::convertYUV420Planar16ToRGB(
+        const BitmapParams &src, const BitmapParams &dst) {
+    if (mSrcColorSpace.mRange == ColorUtils::kColorRangeFull) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    int (*func)(const uint16_t*, int, const uint16_t*, int,
+                const uint16_t*, int, uint8_t*, int, int, int);
+    switch (mDstFormat) {
+    case OMX_COLOR_Format32BitRGBA8888:
+    {
+        DECLARE_YUV10TORGBFUNC(abgrFunc, ABGR);
+        func = abgrFunc;
+        break;
+    }
+
+    case OMX_COLOR_Format32bitBGRA8888:
+    {
+        DECLARE_YUV10TORGBFUNC(argbFunc, ARGB);
+        func = argbFunc;
+        break;
+    }
+
+    default:
+        return ERROR_UNSUPPORTED;
+    }
+
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+
+    const uint8_t *src_y =
+        (const uint8_t *)src.mBits + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp;
+
+    const uint8_t *src_u =
+        (const uint8_t *)src.mBits + src.mStride * src.mHeight
+        + (src.mCropTop / 2) * (src.mStride / 2) + (src.mCropLeft / 2) * src.mBpp;
+
+    const uint8_t *src_v =
+        src_u + (src.mStride / 2) * (src.mHeight / 2);
+
+    // libyuv strides of 16-bit planes are in samples
+    const int strideY = src.mStride / 2;
+    const int strideUV = src.mStride / 4;
+    forEachRowBand(src.cropWidth(), src.cropHeight(), [&](size_t top, size_t rows) {
+        (*func)((const uint16_t *)(src_y + top * src.mStride), strideY,
+                (const uint16_t *)(src_u + (top / 2) * (src.mStride / 2)), strideUV,
+                (const uint16_t *)(src_v + (top / 2) * (src.mStride / 2)), strideUV,
+                dst_ptr + top * dst.mStride, dst.mStride, src.cropWidth(), rows);
+    });
+
+    return OK;
+}
+
 /*
  * Pack 10-bit YUV into RGBA_1010102.
  *
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <media/stagefright/ColorConverter.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace android;
+
+// Converts a state.range(0) x state.range(1) frame from state.range(2) to state.range(3),
+// as done for software rendering and thumbnail extraction.
+static void BM_ColorConverter(benchmark::State& state) {
+    const size_t width = state.range(0);
+    const size_t height = state.range(1);
+    const OMX_COLOR_FORMATTYPE srcFormat = (OMX_COLOR_FORMATTYPE)state.range(2);
+    const OMX_COLOR_FORMATTYPE dstFormat = (OMX_COLOR_FORMATTYPE)state.range(3);
+
+    ColorConverter converter(srcFormat, dstFormat);
+    if (!converter.isValid()) {
+        state.SkipWithError("unsupported conversion");
+        return;
+    }
+
+    const size_t srcBpp = srcFormat == OMX_COLOR_FormatYUV420Planar16 ? 2 : 1;
+    const size_t dstBpp = dstFormat == OMX_COLOR_Format16bitRGB565 ? 2 : 4;
+    // Mid-grey luma and neutral chroma, so every format converts the same picture.
+    std::vector<uint8_t> src(width * height * 3 / 2 * srcBpp, 0x80);
+    std::vector<uint8_t> dst(width * height * dstBpp);
+
+    while (state.KeepRunning()) {
+        status_t err = converter.convert(
+                src.data(), width, height, width,
+                0, 0, width - 1, height - 1,
+                dst.data(), width, height, width * dstBpp,
+                0, 0, width - 1, height - 1);
+        benchmark::DoNotOptimize(err);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+static void ColorConverterArgs(benchmark::internal::Benchmark* b) {
+    static constexpr int64_t kSizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}};
+    static constexpr int64_t kConversions[][2] = {
+        {OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format16bitRGB565},
+        {OMX_COLOR_FormatYUV420Planar, OMX_COLOR_Format32BitRGBA8888},
+        {OMX_COLOR_FormatYUV420SemiPlanar, OMX_COLOR_Format16bitRGB565},
+        {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410},
+    };
+    for (const auto &size : kSizes) {
+        for (const auto &conversion : kConversions) {
+            b->Args({size[0], size[1], conversion[0], conversion[1]});
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(ColorConverterArgs);
+
+BENCHMARK_MAIN();
@@ -129,6 +129,23 @@ static void copyTo16Signed(
         unsigned nChannels,
         unsigned bitsPerSample) {
     const int leftShift = 16 - (int)bitsPerSample; // cast to int to prevent unsigned overflow.
+    if (nChannels == 2) {
+        // Stereo is by far the most common layout; interleave both channels in one pass.
+        const int *const left = src[0];
+        const int *const right = src[1];
+        if (leftShift >= 0) {
+            for (unsigned i = 0; i < nSamples; ++i) {
+                *dst++ = left[i] << leftShift;
+                *dst++ = right[i] << leftShift;
+            }
+        } else {
+            for (unsigned i = 0; i < nSamples; ++i) {
+                *dst++ = left[i] >> -leftShift;
+                *dst++ = right[i] >> -leftShift;
+            }
+        }
+        return;
+    }
     if (leftShift >= 0) {
         for (unsigned i = 0; i < nSamples; ++i) {
             for (unsigned c = 0; c < nChannels; ++c) {
@@ -152,6 +169,15 @@ static void copyToFloat(
         unsigned nChannels,
         unsigned bitsPerSample) {
     const unsigned leftShift = 32 - bitsPerSample;
+    if (nChannels == 2) {
+        const int *const left = src[0];
+        const int *const right = src[1];
+        for (unsigned i = 0; i < nSamples; ++i) {
+            *dst++ = float_from_i32(left[i] << leftShift);
+            *dst++ = float_from_i32(right[i] << leftShift);
+        }
+        return;
+    }
     for (unsigned i = 0; i < nSamples; ++i) {
         for (unsigned c = 0; c < nChannels; ++c) {
             *dst++ = float_from_i32(src[c][i] << leftShift);
@@ -17,6 +17,7 @@
 #include "ABitReader.h"
 
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ByteUtils.h>
 
 namespace android {
 
@@ -37,6 +38,15 @@ bool ABitReader::fillReservoir() {
         return false;
     }
 
+    if (mSize >= 4) {
+        // Common case: refill the whole reservoir with a single big-endian word.
+        mReservoir = U32_AT(mData);
+        mData += 4;
+        mSize -= 4;
+        mNumBitsLeft = 32;
+        return true;
+    }
+
     mReservoir = 0;
     size_t i;
     for (i = 0; mSize > 0 && i < 4; ++i) {
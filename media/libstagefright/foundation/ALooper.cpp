@@ -21,6 +21,7 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <sys/time.h>
 
 #include "ALooper.h"
@@ -69,8 +70,22 @@ int64_t ALooper::GetNowUs() {
     return systemTime(SYSTEM_TIME_MONOTONIC) / 1000LL;
 }
 
+namespace {
+
+// std heaps are max-heaps, so order by "comes after" to keep the earliest event on top
+template <typename T>
+struct EventAfter {
+    bool operator()(const T &a, const T &b) const {
+        return b.isBefore(a);
+    }
+};
+
+}  // namespace
+
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextSequence(0),
+      mContendedPosts(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -165,32 +180,53 @@ status_t ALooper::stop() {
     return OK;
 }
 
-void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
+void ALooper::getQueueStats(size_t *pendingEvents, uint64_t *contendedPosts) {
     Mutex::Autolock autoLock(mLock);
+    *pendingEvents = mImmediateQueue.size() + mDelayedQueue.size();
+    *contendedPosts = mContendedPosts;
+}
 
-    int64_t whenUs;
-    if (delayUs > 0) {
-        int64_t nowUs = GetNowUs();
-        whenUs = (delayUs > INT64_MAX - nowUs ? INT64_MAX : nowUs + delayUs);
-
-    } else {
-        whenUs = GetNowUs();
+const ALooper::Event *ALooper::nextEvent_l() const {
+    if (mImmediateQueue.empty()) {
+        return mDelayedQueue.empty() ? nullptr : &mDelayedQueue.front();
     }
+    if (mDelayedQueue.empty() || mImmediateQueue.front().isBefore(mDelayedQueue.front())) {
+        return &mImmediateQueue.front();
+    }
+    return &mDelayedQueue.front();
+}
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
+void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
+    // lock explicitly to count the posts that find the lock taken
+    if (mLock.tryLock() != NO_ERROR) {
+        mLock.lock();
+        ++mContendedPosts;
     }
 
+    const int64_t nowUs = GetNowUs();
     Event event;
-    event.mWhenUs = whenUs;
+    event.mWhenUs = nowUs;
+    event.mSequence = mNextSequence++;
     event.mMessage = msg;
 
-    if (it == mEventQueue.begin()) {
+    if (delayUs > 0) {
+        event.mWhenUs = (delayUs > INT64_MAX - nowUs ? INT64_MAX : nowUs + delayUs);
+    }
+
+    const Event *next = nextEvent_l();
+    if (next == nullptr || event.isBefore(*next)) {
         mQueueChangedCondition.signal();
     }
 
-    mEventQueue.insert(it, event);
+    if (delayUs > 0) {
+        mDelayedQueue.push_back(std::move(event));
+        std::push_heap(mDelayedQueue.begin(), mDelayedQueue.end(), EventAfter<Event>());
+    } else {
+        // GetNowUs() is monotonic and read under mLock, so this queue stays sorted
+        mImmediateQueue.push_back(std::move(event));
+    }
+
+    mLock.unlock();
 }
 
 bool ALooper::loop() {
@@ -201,11 +237,12 @@ bool ALooper::loop() {
         if (mThread == NULL && !mRunningLocally) {
             return false;
         }
-        if (mEventQueue.empty()) {
+        const Event *next = nextEvent_l();
+        if (next == nullptr) {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = next->mWhenUs;
         int64_t nowUs = GetNowUs();
 
         if (whenUs > nowUs) {
@@ -218,8 +255,14 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        if (!mDelayedQueue.empty() && next == &mDelayedQueue.front()) {
+            std::pop_heap(mDelayedQueue.begin(), mDelayedQueue.end(), EventAfter<Event>());
+            event = std::move(mDelayedQueue.back());
+            mDelayedQueue.pop_back();
+        } else {
+            event = std::move(mImmediateQueue.front());
+            mImmediateQueue.pop_front();
+        }
     }
 
     event.mMessage->deliver();
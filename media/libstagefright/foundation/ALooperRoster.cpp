@@ -139,6 +139,11 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         sp<ALooper> looper = info.mLooper.promote();
         if (looper != NULL) {
             s.append(looper->getName());
+            size_t pendingEvents;
+            uint64_t contendedPosts;
+            looper->getQueueStats(&pendingEvents, &contendedPosts);
+            s.appendFormat(" (%zu pending, %llu contended posts)",
+                    pendingEvents, (unsigned long long)contendedPosts);
             sp<AHandler> handler = info.mHandler.promote();
             if (handler != NULL) {
                 handler->mVerboseStats = verboseStats;
@@ -55,12 +55,14 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
 AMessage::AMessage(void)
     : mWhat(0),
       mTarget(0),
-      mNumItems(0) {
+      mNumItems(0),
+      mNameArenaUsed(0) {
 }
 
 AMessage::AMessage(uint32_t what, const sp<const AHandler> &handler)
     : mWhat(what),
-      mNumItems(0) {
+      mNumItems(0),
+      mNameArenaUsed(0) {
     setTarget(handler);
 }
 
@@ -91,11 +93,11 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     for (size_t i = 0; i < mNumItems; ++i) {
         Item *item = &mItems[i];
-        delete[] item->mName;
-        item->mName = NULL;
+        freeItemName(item);
         freeItemValue(item);
     }
     mNumItems = 0;
+    mNameArenaUsed = 0;
 }
 
 void AMessage::freeItemValue(Item *item) {
@@ -181,11 +183,26 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
-// assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
-    mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+void AMessage::setItemName(Item *item, const char *name, size_t len) {
+    item->mNameLength = len;
+    char *storage;
+    if (len + 1 <= kNameArenaSize - mNameArenaUsed) {
+        storage = mNameArena + mNameArenaUsed;
+        mNameArenaUsed += len + 1;
+    } else {
+        storage = new char[len + 1];
+    }
+    memcpy(storage, name, len);
+    storage[len] = '\0';
+    item->mName = storage;
+}
+
+void AMessage::freeItemName(Item *item) {
+    // names in the arena are only reclaimed by clear()
+    if (item->mName < mNameArena || item->mName >= mNameArena + kNameArenaSize) {
+        delete[] item->mName;
+    }
+    item->mName = NULL;
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
@@ -201,7 +218,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         i = mNumItems++;
         item = &mItems[i];
         item->mType = kTypeInt32;
-        item->setName(name, len);
+        setItemName(item, name, len);
     }
 
     return item;
@@ -481,7 +498,7 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        msg->setItemName(to, from->mName, from->mNameLength);
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -746,7 +763,7 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        msg->setItemName(item, name, strlen(name));
     }
 
     return msg;
@@ -999,9 +1016,8 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mNumItems) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    freeItemName(&mItems[index]);
+    setItemName(&mItems[index], name, len);
     return OK;
 }
 
@@ -1065,8 +1081,7 @@ status_t AMessage::removeEntryAt(size_t index) {
     }
     // delete entry data and objects
     --mNumItems;
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    freeItemName(&mItems[index]);
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
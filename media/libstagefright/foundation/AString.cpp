@@ -80,6 +80,15 @@ AString::AString(const AString &from)
     setTo(from, 0, from.size());
 }
 
+AString::AString(AString &&from) noexcept
+    : mData(from.mData),
+      mSize(from.mSize),
+      mAllocSize(from.mAllocSize) {
+    from.mData = (char *)kEmptyString;
+    from.mSize = 0;
+    from.mAllocSize = 1;
+}
+
 AString::AString(const AString &from, size_t offset, size_t n)
     : mData(NULL),
       mSize(0),
@@ -99,6 +108,20 @@ AString &AString::operator=(const AString &from) {
     return *this;
 }
 
+AString &AString::operator=(AString &&from) noexcept {
+    if (&from != this) {
+        clear();
+        mData = from.mData;
+        mSize = from.mSize;
+        mAllocSize = from.mAllocSize;
+        from.mData = (char *)kEmptyString;
+        from.mSize = 0;
+        from.mAllocSize = 1;
+    }
+
+    return *this;
+}
+
 size_t AString::size() const {
     return mSize;
 }
@@ -383,7 +406,18 @@ status_t AString::writeToParcel(Parcel *parcel) const {
 #endif
 
 AString AStringPrintf(const char *format, ...) {
+    // Most results are short; format those on the stack so that the only allocation
+    // is the one made by the returned string.
+    char stackBuffer[256];
     va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(stackBuffer, sizeof(stackBuffer), format, ap);
+    va_end(ap);
+
+    if (n >= 0 && (size_t)n < sizeof(stackBuffer)) {
+        return AString(stackBuffer, n);
+    }
+
     va_start(ap, format);
 
     char *buffer;
@@ -40,7 +40,12 @@ struct MediaBufferGroup::InternalData {
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
+    // Ordered from least to most recently acquired, so that the buffer found first when
+    // scanning is the one most likely to have been returned already.
     std::list<MediaBufferBase *> mBuffers;
+    size_t mAcquireCount = 0;  // Statistics, logged when the group is destroyed.
+    size_t mAllocateCount = 0;
+    size_t mWaitCount = 0;
 };
 
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
@@ -102,6 +107,9 @@ void MediaBufferGroup::init(size_t buffers, size_t buffer_size, size_t growthLim
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
+    ALOGV("%zu buffers: %zu acquires, %zu allocations, %zu waits",
+            mInternal->mBuffers.size(), mInternal->mAcquireCount,
+            mInternal->mAllocateCount, mInternal->mWaitCount);
     for (MediaBufferBase *buffer : mInternal->mBuffers) {
         if (buffer->refcount() != 0) {
             const int localRefcount = buffer->localRefcount();
@@ -168,6 +176,7 @@ status_t MediaBufferGroup::acquire_buffer(
         size_t smallest = requestedSize;
         size_t biggest = requestedSize;
         MediaBufferBase *buffer = nullptr;
+        auto bufferIt = mInternal->mBuffers.end();
         auto free = mInternal->mBuffers.end();
         for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
             const size_t size = (*it)->size();
@@ -177,6 +186,7 @@ status_t MediaBufferGroup::acquire_buffer(
             if ((*it)->refcount() == 0) {
                 if (size >= requestedSize) {
                     buffer = *it;
+                    bufferIt = it;
                     break;
                 }
                 if (size < smallest) {
@@ -199,12 +209,14 @@ status_t MediaBufferGroup::acquire_buffer(
                 buffer = nullptr;
             } else {
                 buffer->setObserver(this);
+                ++mInternal->mAllocateCount;
                 if (free != mInternal->mBuffers.end()) {
                     ALOGV("reallocate buffer, requested size %zu vs available %zu",
                             requestedSize, (*free)->size());
                     (*free)->setObserver(nullptr);
                     (*free)->release();
                     *free = buffer; // in-place replace
+                    bufferIt = free;
                 } else {
                     ALOGV("allocate buffer, requested size %zu", requestedSize);
                     mInternal->mBuffers.emplace_back(buffer);
@@ -212,6 +224,12 @@ status_t MediaBufferGroup::acquire_buffer(
             }
         }
         if (buffer != nullptr) {
+            if (bufferIt != mInternal->mBuffers.end()) {
+                // Move to the most recently acquired end; splice does not invalidate iterators.
+                mInternal->mBuffers.splice(
+                        mInternal->mBuffers.end(), mInternal->mBuffers, bufferIt);
+            }
+            ++mInternal->mAcquireCount;
             buffer->add_ref();
             buffer->reset();
             *out = buffer;
@@ -222,6 +240,7 @@ status_t MediaBufferGroup::acquire_buffer(
             return WOULD_BLOCK;
         }
         // All buffers are in use, block until one of them is returned.
+        ++mInternal->mWaitCount;
         mInternal->mCondition.wait(mInternal->mLock);
     }
     // Never gets here.
@@ -23,6 +23,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+#include <cstddef>
+#include <new>
+
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -60,7 +64,24 @@ private:
         return mSize <= sizeof(u.reservoir);
     }
 
+    // Values too large for the reservoir live in a reference counted block that is shared,
+    // not duplicated, when an item is copied. This keeps copies of MetaData that carry codec
+    // specific data or ICC profiles cheap. Shared blocks are never modified; setData()
+    // always allocates a new one.
+    struct ExtStorage {
+        std::atomic<int32_t> mRefCount;
+    };
+    static constexpr size_t kExtStorageHeaderSize =
+            (sizeof(ExtStorage) + alignof(std::max_align_t) - 1)
+                    / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    ExtStorage *extStorage() const {
+        return reinterpret_cast<ExtStorage *>(
+                static_cast<uint8_t *>(u.ext_data) - kExtStorageHeaderSize);
+    }
+
     void *allocateStorage(size_t size);
+    void shareStorage(const typed_data &from);
     void freeStorage();
 
     void *storage() {
@@ -304,11 +325,7 @@ MetaDataBase::typed_data::~typed_data() {
 MetaDataBase::typed_data::typed_data(const typed_data &from)
     : mType(from.mType),
       mSize(0) {
-
-    void *dst = allocateStorage(from.mSize);
-    if (dst) {
-        memcpy(dst, from.storage(), mSize);
-    }
+    shareStorage(from);
 }
 
 MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
@@ -316,10 +333,7 @@ MetaDataBase::typed_data &MetaDataBase::typed_data::operator=(
     if (this != &from) {
         clear();
         mType = from.mType;
-        void *dst = allocateStorage(from.mSize);
-        if (dst) {
-            memcpy(dst, from.storage(), mSize);
-        }
+        shareStorage(from);
     }
 
     return *this;
@@ -357,18 +371,40 @@ void *MetaDataBase::typed_data::allocateStorage(size_t size) {
         return &u.reservoir;
     }
 
-    u.ext_data = malloc(mSize);
-    if (u.ext_data == NULL) {
+    u.ext_data = NULL;
+    void *block = mSize <= SIZE_MAX - kExtStorageHeaderSize
+            ? malloc(kExtStorageHeaderSize + mSize) : NULL;
+    if (block == NULL) {
         ALOGE("Couldn't allocate %zu bytes for item", size);
         mSize = 0;
+        return NULL;
     }
+    new (block) ExtStorage{1};
+    u.ext_data = static_cast<uint8_t *>(block) + kExtStorageHeaderSize;
     return u.ext_data;
 }
 
+void MetaDataBase::typed_data::shareStorage(const typed_data &from) {
+    if (from.usesReservoir()) {
+        mSize = from.mSize;
+        memcpy(&u.reservoir, &from.u.reservoir, sizeof(u.reservoir));
+        return;
+    }
+    mSize = from.mSize;
+    u.ext_data = from.u.ext_data;
+    if (u.ext_data) {
+        extStorage()->mRefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 void MetaDataBase::typed_data::freeStorage() {
     if (!usesReservoir()) {
         if (u.ext_data) {
-            free(u.ext_data);
+            ExtStorage *ext = extStorage();
+            if (ext->mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ext->~ExtStorage();
+                free(ext);
+            }
             u.ext_data = NULL;
         }
     }
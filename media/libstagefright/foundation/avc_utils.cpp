@@ -305,11 +305,19 @@ status_t getNextNALUnit(
     size_t offset = 0;
 
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
+    // Look for the 0x01 bytes with memchr(), which is vectorized.
+    while (offset + 2 < size) {
+        const uint8_t *one = (const uint8_t *)memchr(
+                &data[offset + 2], 0x01, size - offset - 2);
+        if (one == NULL) {
+            offset = size - 2;
             break;
         }
+        offset = one - data - 2;
+        if (data[offset] == 0x00 && data[offset + 1] == 0x00) {
+            break;
+        }
+        ++offset;
     }
     if (offset + 2 >= size) {
         *_data = &data[offset];
@@ -321,9 +329,8 @@ status_t getNextNALUnit(
     size_t startOffset = offset;
 
     for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
+        const uint8_t *one = (const uint8_t *)memchr(&data[offset], 0x01, size - offset);
+        offset = one != NULL ? one - data : size;
 
         if (offset == size) {
             if (startCodeFollows) {
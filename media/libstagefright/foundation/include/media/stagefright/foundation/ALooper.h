@@ -18,6 +18,9 @@
 
 #define A_LOOPER_H_
 
+#include <deque>
+#include <vector>
+
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AString.h>
 #include <utils/Errors.h>
@@ -58,6 +61,10 @@ struct ALooper : public RefBase {
         return mName.c_str();
     }
 
+    // For dumpsys: number of events waiting to be delivered, and number of posts
+    // that had to wait for the looper lock.
+    void getQueueStats(size_t *pendingEvents, uint64_t *contendedPosts);
+
 protected:
     virtual ~ALooper();
 
@@ -66,7 +73,13 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        uint64_t mSequence;     // events due at the same time are delivered in post order
         sp<AMessage> mMessage;
+
+        bool isBefore(const Event &other) const {
+            return mWhenUs < other.mWhenUs
+                    || (mWhenUs == other.mWhenUs && mSequence < other.mSequence);
+        }
     };
 
     Mutex mLock;
@@ -74,7 +87,17 @@ private:
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // Messages posted without delay are due in post order, so they are simply appended to
+    // mImmediateQueue. Delayed messages go to mDelayedQueue, a min-heap on (mWhenUs, mSequence),
+    // so that posting stays O(log n) however many delayed messages are pending.
+    // The next event is the earlier of the two queue fronts.
+    std::deque<Event> mImmediateQueue;
+    std::vector<Event> mDelayedQueue;
+    uint64_t mNextSequence;
+    uint64_t mContendedPosts;
+
+    // returns nullptr if there is no event, must be called with mLock held
+    const Event *nextEvent_l() const;
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -290,14 +290,22 @@ private:
         const char *mName;
         size_t      mNameLength;
         Type mType;
-        void setName(const char *name, size_t len);
     };
 
     enum {
-        kMaxNumItems = 64
+        kMaxNumItems = 64,
+        // Item names are copied into mNameArena, so that setting an item does not allocate.
+        // Names that do not fit are allocated on the heap.
+        kNameArenaSize = 512,
     };
     Item mItems[kMaxNumItems];
     size_t mNumItems;
+    char mNameArena[kNameArenaSize];
+    size_t mNameArenaUsed;
+
+    // assumes item's name was uninitialized or NULL
+    void setItemName(Item *item, const char *name, size_t len);
+    void freeItemName(Item *item);
 
     Item *allocateItem(const char *name);
     void freeItemValue(Item *item);
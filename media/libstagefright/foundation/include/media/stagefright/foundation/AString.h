@@ -32,10 +32,12 @@ struct AString {
     AString(const char *s, size_t size);
     AString(const String8 &from);  // NOLINT, implicit conversion
     AString(const AString &from);
+    AString(AString &&from) noexcept;
     AString(const AString &from, size_t offset, size_t n);
     ~AString();
 
     AString &operator=(const AString &from);
+    AString &operator=(AString &&from) noexcept;
     void setTo(const char *s);
     void setTo(const char *s, size_t size);
     void setTo(const AString &from, size_t offset, size_t n);
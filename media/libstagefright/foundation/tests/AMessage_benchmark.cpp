@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <media/stagefright/foundation/AMessage.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace android;
+
+// Item names like those of MediaCodec and NuPlayer messages.
+static constexpr const char *kNames[] = {
+    "what", "err", "generation", "index", "offset", "size", "timeUs", "flags",
+    "buffer-id", "portIndex", "audio", "reason", "mime", "width", "height", "stride",
+};
+static constexpr size_t kNumNames = sizeof(kNames) / sizeof(kNames[0]);
+
+// Builds a message with state.range(0) items, looks every item up and releases it,
+// as a sender and handler do for every posted message.
+static void BM_AMessageBuildAndFind(benchmark::State& state) {
+    const size_t numItems = state.range(0);
+    while (state.KeepRunning()) {
+        sp<AMessage> msg = new AMessage('test', nullptr);
+        for (size_t i = 0; i < numItems; i++) {
+            msg->setInt32(kNames[i % kNumNames], i);
+        }
+        int32_t sum = 0;
+        for (size_t i = 0; i < numItems; i++) {
+            int32_t value;
+            if (msg->findInt32(kNames[i % kNumNames], &value)) {
+                sum += value;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Same with a string value and a dup(), as done for format changes.
+static void BM_AMessageDup(benchmark::State& state) {
+    const size_t numItems = state.range(0);
+    sp<AMessage> msg = new AMessage('test', nullptr);
+    msg->setString("mime", "audio/mp4a-latm");
+    for (size_t i = 1; i < numItems; i++) {
+        msg->setInt32(kNames[i % kNumNames], i);
+    }
+    while (state.KeepRunning()) {
+        sp<AMessage> copy = msg->dup();
+        benchmark::DoNotOptimize(copy.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AMessageBuildAndFind)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK(BM_AMessageDup)->Arg(1)->Arg(4)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -67,8 +67,10 @@ struct HTTPDownloader : public RefBase {
             String8 *actualUrl = NULL);
 
     // fetch a playlist file
+    // previous is the current version of the playlist, see M3UParser.
     sp<M3UParser> fetchPlaylist(
-            const char *url, uint8_t *curPlaylistHash, bool *unchanged);
+            const char *url, uint8_t *curPlaylistHash, bool *unchanged,
+            const sp<M3UParser> &previous = NULL);
 
 private:
     sp<HTTPBase> mHTTPDataSource;
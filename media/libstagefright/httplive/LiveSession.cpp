@@ -40,6 +40,7 @@
 
 #include <ctype.h>
 #include <inttypes.h>
+#include <math.h>
 
 namespace android {
 
@@ -49,6 +50,7 @@ const int64_t LiveSession::kUpSwitchMarkUs = 15000000LL;
 const int64_t LiveSession::kDownSwitchMarkUs = 20000000LL;
 const int64_t LiveSession::kUpSwitchMarginUs = 5000000LL;
 const int64_t LiveSession::kResumeThresholdUs = 100000LL;
+const int64_t LiveSession::kMinUpSwitchIntervalUs = 10000000LL;
 
 //TODO: redefine this mark to a fair value
 // default buffer underflow mark
@@ -62,6 +64,9 @@ struct LiveSession::BandwidthEstimator : public RefBase {
             int32_t *bandwidth,
             bool *isStable = NULL,
             int32_t *shortTermBps = NULL);
+    // Exponentially weighted averages of the samples, weighted by their transfer
+    // time. The fast one follows throughput drops within a couple of segments.
+    bool getWeightedBandwidth(int32_t *fastBps, int32_t *slowBps);
 
 private:
     // Bandwidth estimation parameters
@@ -70,6 +75,8 @@ private:
     static const int64_t kMinBandwidthHistoryWindowUs = 5000000LL; // 5 sec
     static const int64_t kMaxBandwidthHistoryWindowUs = 30000000LL; // 30 sec
     static const int64_t kMaxBandwidthHistoryAgeUs = 60000000LL; // 60 sec
+    static const int64_t kFastHalfLifeUs = 2000000LL; // 2 sec of transfer time
+    static const int64_t kSlowHalfLifeUs = 8000000LL; // 8 sec of transfer time
 
     struct BandwidthEntry {
         int64_t mTimestampUs;
@@ -85,6 +92,13 @@ private:
     bool mIsStable;
     int64_t mTotalTransferTimeUs;
     size_t mTotalTransferBytes;
+    double mFastAverageBps;
+    double mSlowAverageBps;
+    int64_t mTotalWeightUs;
+
+    static void updateAverage(
+            double *averageBps, double sampleBps, int64_t delayUs, int64_t halfLifeUs);
+    double unbiasedAverage(double averageBps, int64_t halfLifeUs) const;
 
     DISALLOW_EVIL_CONSTRUCTORS(BandwidthEstimator);
 };
@@ -94,7 +108,24 @@ LiveSession::BandwidthEstimator::BandwidthEstimator() :
     mHasNewSample(false),
     mIsStable(true),
     mTotalTransferTimeUs(0),
-    mTotalTransferBytes(0) {
+    mTotalTransferBytes(0),
+    mFastAverageBps(0),
+    mSlowAverageBps(0),
+    mTotalWeightUs(0) {
+}
+
+// static
+void LiveSession::BandwidthEstimator::updateAverage(
+        double *averageBps, double sampleBps, int64_t delayUs, int64_t halfLifeUs) {
+    double alpha = pow(0.5, (double)delayUs / halfLifeUs);
+    *averageBps = alpha * *averageBps + (1 - alpha) * sampleBps;
+}
+
+double LiveSession::BandwidthEstimator::unbiasedAverage(
+        double averageBps, int64_t halfLifeUs) const {
+    // the averages start at 0, scale up by the weight they have accumulated so far
+    double weight = 1 - pow(0.5, (double)mTotalWeightUs / halfLifeUs);
+    return weight > 0 ? averageBps / weight : 0;
 }
 
 void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
@@ -111,6 +142,13 @@ void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
     mBandwidthHistory.push_back(entry);
     mHasNewSample = true;
 
+    if (delayUs > 0) {
+        double sampleBps = numBytes * 8E6 / delayUs;
+        updateAverage(&mFastAverageBps, sampleBps, delayUs, kFastHalfLifeUs);
+        updateAverage(&mSlowAverageBps, sampleBps, delayUs, kSlowHalfLifeUs);
+        mTotalWeightUs += delayUs;
+    }
+
     // Remove no more than 10% of total transfer time at a time
     // to avoid sudden jump on bandwidth estimation. There might
     // be long blocking reads that takes up signification time,
@@ -223,6 +261,18 @@ bool LiveSession::BandwidthEstimator::estimateBandwidth(
     return true;
 }
 
+bool LiveSession::BandwidthEstimator::getWeightedBandwidth(
+        int32_t *fastBps, int32_t *slowBps) {
+    AutoMutex autoLock(mLock);
+
+    if (mBandwidthHistory.size() < 2 || mTotalWeightUs <= 0) {
+        return false;
+    }
+    *fastBps = (int32_t)min(unbiasedAverage(mFastAverageBps, kFastHalfLifeUs), (double)INT32_MAX);
+    *slowBps = (int32_t)min(unbiasedAverage(mSlowAverageBps, kSlowHalfLifeUs), (double)INT32_MAX);
+    return true;
+}
+
 //static
 const char *LiveSession::getKeyForStream(StreamType type) {
     switch (type) {
@@ -288,6 +338,14 @@ LiveSession::LiveSession(
       mLastBandwidthBps(-1LL),
       mLastBandwidthStable(false),
       mBandwidthEstimator(new BandwidthEstimator()),
+      mAdaptationMode(kAdaptationHybrid),
+      mMinBufferedDurationUs(-1LL),
+      mLastSwitchTimeUs(-1LL),
+      mStatsBandwidthBps(-1),
+      mStatsVariantBps(-1),
+      mStatsBufferedDurationUs(-1LL),
+      mStatsUpSwitches(0),
+      mStatsDownSwitches(0),
       mMaxWidth(720),
       mMaxHeight(480),
       mStreamMask(0),
@@ -314,6 +372,11 @@ LiveSession::LiveSession(
         mPacketSources.add(indexToType(i), new AnotherPacketSource(NULL /* meta */));
         mPacketSources2.add(indexToType(i), new AnotherPacketSource(NULL /* meta */));
     }
+
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get("media.httplive.abr", value, NULL) && !strcmp(value, "throughput")) {
+        mAdaptationMode = kAdaptationThroughput;
+    }
 }
 
 LiveSession::~LiveSession() {
@@ -1343,7 +1406,7 @@ ssize_t LiveSession::getLowestValidBandwidthIndex() const {
     return 0;
 }
 
-size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps) {
+size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps, float safetyFactor) {
     if (mBandwidthItems.size() < 2) {
         // shouldn't be here if we only have 1 bandwidth, check
         // logic to get rid of redundant bandwidth polling
@@ -1383,9 +1446,9 @@ size_t LiveSession::getBandwidthIndex(int32_t bandwidthBps) {
         index = mBandwidthItems.size() - 1;
         ssize_t lowestBandwidth = getLowestValidBandwidthIndex();
         while (index > lowestBandwidth) {
-            // be conservative (70%) to avoid overestimating and immediately
-            // switching down again.
-            size_t adjustedBandwidthBps = bandwidthBps * .7f;
+            // be conservative (70% by default) to avoid overestimating and
+            // immediately switching down again.
+            size_t adjustedBandwidthBps = bandwidthBps * safetyFactor;
             const BandwidthItem &item = mBandwidthItems[index];
             if (item.mBandwidth <= adjustedBandwidthBps
                     && isBandwidthValid(item)) {
@@ -2169,6 +2232,7 @@ bool LiveSession::checkBuffering(
     size_t activeCount, underflowCount, readyCount, downCount, upCount;
     activeCount = underflowCount = readyCount = downCount = upCount =0;
     int32_t minBufferPercent = -1;
+    int64_t minBufferedDurationUs = -1;
     int64_t durationUs;
     if (getDuration(&durationUs) != OK) {
         durationUs = -1;
@@ -2215,6 +2279,9 @@ bool LiveSession::checkBuffering(
             ++readyCount;
         }
         if (!mPacketSources[i]->isFinished(0)) {
+            if (minBufferedDurationUs < 0 || bufferedDurationUs < minBufferedDurationUs) {
+                minBufferedDurationUs = bufferedDurationUs;
+            }
             if (bufferedDurationUs < kUnderflowMarkMs * 1000LL) {
                 ++underflowCount;
             }
@@ -2230,6 +2297,7 @@ bool LiveSession::checkBuffering(
     if (minBufferPercent >= 0) {
         notifyBufferingUpdate(minBufferPercent);
     }
+    mMinBufferedDurationUs = minBufferedDurationUs;
 
     if (activeCount > 0) {
         up        = (upCount == activeCount);
@@ -2340,6 +2408,48 @@ bool LiveSession::switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow) {
         return false;
     }
 
+    int32_t curBandwidth = mBandwidthItems.itemAt(mCurBandwidthIndex).mBandwidth;
+    {
+        Mutex::Autolock autoLock(mStatsLock);
+        mStatsBandwidthBps = bandwidthBps;
+        mStatsVariantBps = curBandwidth;
+        mStatsBufferedDurationUs = mMinBufferedDurationUs;
+    }
+
+    ssize_t bandwidthIndex = (mAdaptationMode == kAdaptationHybrid)
+            ? selectHybridBandwidthIndex(
+                    bandwidthBps, isStable, shortTermBps, bufferHigh, bufferLow)
+            : selectThroughputBandwidthIndex(
+                    bandwidthBps, isStable, shortTermBps, bufferHigh, bufferLow);
+    if (bandwidthIndex < 0 || bandwidthIndex == mCurBandwidthIndex) {
+        return false;
+    }
+
+    ALOGV("switching %s from %zd to %zd, buffered %lld us",
+            bandwidthIndex > mCurBandwidthIndex ? "up" : "down",
+            mCurBandwidthIndex, bandwidthIndex, (long long)mMinBufferedDurationUs);
+    {
+        Mutex::Autolock autoLock(mStatsLock);
+        if (bandwidthIndex > mCurBandwidthIndex) {
+            ++mStatsUpSwitches;
+        } else {
+            ++mStatsDownSwitches;
+        }
+    }
+    mLastSwitchTimeUs = ALooper::GetNowUs();
+
+    // if not yet prepared, just restart again with new bw index.
+    // this is faster and playback experience is cleaner.
+    changeConfiguration(mInPreparationPhase ? 0 : -1LL, bandwidthIndex);
+    return true;
+}
+
+/*
+ * the original throughput rule: returns the variant to switch to, or -1
+ */
+ssize_t LiveSession::selectThroughputBandwidthIndex(
+        int32_t bandwidthBps, bool isStable, int32_t shortTermBps,
+        bool bufferHigh, bool bufferLow) {
     int32_t curBandwidth = mBandwidthItems.itemAt(mCurBandwidthIndex).mBandwidth;
     // canSwithDown and canSwitchUp can't both be true.
     // we only want to switch up when measured bw is 120% higher than current variant,
@@ -2368,14 +2478,66 @@ bool LiveSession::switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow) {
         // both enough buffer and enough bw.
         if ((canSwitchUp && bandwidthIndex > mCurBandwidthIndex)
          || (canSwitchDown && bandwidthIndex < mCurBandwidthIndex)) {
-            // if not yet prepared, just restart again with new bw index.
-            // this is faster and playback experience is cleaner.
-            changeConfiguration(
-                    mInPreparationPhase ? 0 : -1LL, bandwidthIndex);
-            return true;
+            return bandwidthIndex;
         }
     }
-    return false;
+    return -1;
+}
+
+/*
+ * the buffer and throughput hybrid rule: returns the variant to switch to, or -1
+ */
+ssize_t LiveSession::selectHybridBandwidthIndex(
+        int32_t bandwidthBps, bool isStable, int32_t shortTermBps,
+        bool bufferHigh, bool bufferLow) {
+    // the lower of the two weighted averages drops as fast as the fast one
+    // but only rises as slowly as the slow one.
+    int32_t fastBps, slowBps;
+    if (mBandwidthEstimator->getWeightedBandwidth(&fastBps, &slowBps)) {
+        bandwidthBps = min(fastBps, slowBps);
+    }
+    if (!isStable && shortTermBps < bandwidthBps) {
+        bandwidthBps = shortTermBps;
+    }
+
+    // the buffer absorbs the error of the estimate, so spend a larger share
+    // of it the more is buffered: from 50% near underflow up to 90% once
+    // the buffer is past both switch marks.
+    int64_t bufferedUs = mMinBufferedDurationUs;
+    float safetyFactor = .7f;
+    if (bufferedUs >= 0) {
+        int64_t lowUs = kUnderflowMarkMs * 1000LL;
+        int64_t highUs = max(max(mUpSwitchMark, mDownSwitchMark), lowUs + 1);
+        float level = (float)(bufferedUs - lowUs) / (highUs - lowUs);
+        safetyFactor = .5f + .4f * min(max(level, 0.f), 1.f);
+    }
+
+    ssize_t bandwidthIndex = getBandwidthIndex(bandwidthBps, safetyFactor);
+    if (bandwidthIndex > mCurBandwidthIndex) {
+        // only go up with enough buffer to ride out a wrong guess, and
+        // not right after the previous switch, to avoid oscillating.
+        if (!bufferHigh || (mLastSwitchTimeUs >= 0
+                && ALooper::GetNowUs() - mLastSwitchTimeUs < kMinUpSwitchIntervalUs)) {
+            return -1;
+        }
+    } else if (bandwidthIndex < mCurBandwidthIndex && !bufferLow) {
+        return -1;
+    }
+    return bandwidthIndex;
+}
+
+sp<AMessage> LiveSession::getAdaptationStats() const {
+    sp<AMessage> stats = new AMessage;
+    stats->setString("abr-mode",
+            mAdaptationMode == kAdaptationHybrid ? "hybrid" : "throughput");
+
+    Mutex::Autolock autoLock(mStatsLock);
+    stats->setInt32("abr-bandwidth-bps", mStatsBandwidthBps);
+    stats->setInt32("abr-variant-bps", mStatsVariantBps);
+    stats->setInt64("abr-buffered-us", mStatsBufferedDurationUs);
+    stats->setInt32("abr-up-switches", mStatsUpSwitches);
+    stats->setInt32("abr-down-switches", mStatsDownSwitches);
+    return stats;
 }
 
 void LiveSession::postError(status_t err) {
@@ -100,6 +100,9 @@ struct LiveSession : public AHandler {
     bool isSeekable() const;
     bool hasDynamicDuration() const;
 
+    // Snapshot of the bandwidth adaptation state, for dumpsys and metrics.
+    sp<AMessage> getAdaptationStats() const;
+
     static const char *getKeyForStream(StreamType type);
     static const char *getNameForStream(StreamType type);
     static ATSParser::SourceType getSourceTypeForStream(StreamType type);
@@ -140,6 +143,14 @@ private:
     static const int64_t kDownSwitchMarkUs;
     static const int64_t kUpSwitchMarginUs;
     static const int64_t kResumeThresholdUs;
+    static const int64_t kMinUpSwitchIntervalUs;
+
+    enum AdaptationMode {
+        // switch on the throughput estimate alone, when the buffer crosses a mark
+        kAdaptationThroughput,
+        // pick the variant from the throughput estimate, scaled by the buffer level
+        kAdaptationHybrid,
+    };
 
     // Buffer Prepare/Ready/Underflow Marks
     BufferingSettings mBufferingSettings;
@@ -204,6 +215,17 @@ private:
     int32_t mLastBandwidthBps;
     bool mLastBandwidthStable;
     sp<BandwidthEstimator> mBandwidthEstimator;
+    AdaptationMode mAdaptationMode;
+    int64_t mMinBufferedDurationUs;
+    int64_t mLastSwitchTimeUs;
+
+    // read by getAdaptationStats() from other threads
+    mutable Mutex mStatsLock;
+    int32_t mStatsBandwidthBps;
+    int32_t mStatsVariantBps;
+    int64_t mStatsBufferedDurationUs;
+    int32_t mStatsUpSwitches;
+    int32_t mStatsDownSwitches;
 
     sp<M3UParser> mPlaylist;
     int32_t mMaxWidth;
@@ -271,7 +293,7 @@ private:
     float getAbortThreshold(
             ssize_t currentBWIndex, ssize_t targetBWIndex) const;
     void addBandwidthMeasurement(size_t numBytes, int64_t delayUs);
-    size_t getBandwidthIndex(int32_t bandwidthBps);
+    size_t getBandwidthIndex(int32_t bandwidthBps, float safetyFactor = .7f);
     ssize_t getLowestValidBandwidthIndex() const;
     HLSTime latestMediaSegmentStartTime() const;
 
@@ -293,6 +315,12 @@ private:
             sp<AMessage> &msg, int64_t delayUs, bool *needResumeUntil);
 
     bool switchBandwidthIfNeeded(bool bufferHigh, bool bufferLow);
+    ssize_t selectThroughputBandwidthIndex(
+            int32_t bandwidthBps, bool isStable, int32_t shortTermBps,
+            bool bufferHigh, bool bufferLow);
+    ssize_t selectHybridBandwidthIndex(
+            int32_t bandwidthBps, bool isStable, int32_t shortTermBps,
+            bool bufferHigh, bool bufferLow);
     bool tryBandwidthFallback();
 
     void schedulePollBuffering();
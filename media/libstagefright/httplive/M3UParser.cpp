@@ -250,7 +250,8 @@ bool M3UParser::MediaGroup::getActiveURI(AString *uri, const char *baseURL) cons
 ////////////////////////////////////////////////////////////////////////////////
 
 M3UParser::M3UParser(
-        const char *baseURI, const void *data, size_t size)
+        const char *baseURI, const void *data, size_t size,
+        const sp<M3UParser> &previous)
     : mInitCheck(NO_INIT),
       mBaseURI(baseURI),
       mIsExtM3U(false),
@@ -263,7 +264,33 @@ M3UParser::M3UParser(
       mDiscontinuitySeq(0),
       mDiscontinuityCount(0),
       mSelectedIndex(-1) {
-    mInitCheck = parse(data, size);
+    mInitCheck = parse(data, size, previous);
+    if (mInitCheck == -EAGAIN) {
+        // a segment does not match the previous playlist, it was rewritten.
+        ALOGV("playlist changed, parsing it again");
+        reset();
+        mInitCheck = parse(data, size, NULL);
+    }
+}
+
+void M3UParser::reset() {
+    mIsExtM3U = false;
+    mIsVariantPlaylist = false;
+    mIsComplete = false;
+    mIsEvent = false;
+    mDiscontinuitySeq = 0;
+    mDiscontinuityCount = 0;
+    mMeta.clear();
+    mItems.clear();
+    mMediaGroups.clear();
+}
+
+const M3UParser::Item *M3UParser::findItemForSeq(int64_t seq) const {
+    if (mIsVariantPlaylist || seq < mFirstSeqNumber
+            || seq >= (int64_t)mFirstSeqNumber + (int64_t)mItems.size()) {
+        return NULL;
+    }
+    return &mItems.itemAt(seq - mFirstSeqNumber);
 }
 
 M3UParser::~M3UParser() {
@@ -566,11 +593,35 @@ AString M3UParser::MediaGroup::Media::makeURL(const char *baseURL) const {
     return out;
 }
 
-status_t M3UParser::parse(const void *_data, size_t size) {
+static bool lineStartsWith(const char *line, size_t length, const char *prefix) {
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && !memcmp(line, prefix, prefixLength);
+}
+
+// Tags that only describe the next segment, and may be skipped for the segments
+// that are taken from the previous playlist.
+static bool isSegmentTag(const char *line, size_t length) {
+    if (!lineStartsWith(line, length, "#EXT")) {
+        return true;  // comment
+    }
+    return lineStartsWith(line, length, "#EXTINF")
+            || lineStartsWith(line, length, "#EXT-X-KEY")
+            || lineStartsWith(line, length, "#EXT-X-BYTERANGE")
+            || lineStartsWith(line, length, "#EXT-X-PROGRAM-DATE-TIME")
+            || (lineStartsWith(line, length, "#EXT-X-DISCONTINUITY")
+                    && !lineStartsWith(line, length, "#EXT-X-DISCONTINUITY-SEQUENCE"));
+}
+
+status_t M3UParser::parse(
+        const void *_data, size_t size, const sp<M3UParser> &previous) {
     int32_t lineNo = 0;
 
     sp<AMessage> itemMeta;
 
+    // Live playlists mostly repeat the segments of their previous version,
+    // which are found by media sequence number.
+    bool canReuse = previous != NULL && !previous->mIsVariantPlaylist;
+
     const char *data = (const char *)_data;
     size_t offset = 0;
     uint64_t segmentRangeOffset = 0;
@@ -580,20 +631,64 @@ status_t M3UParser::parse(const void *_data, size_t size) {
             ++offsetLF;
         }
 
-        AString line;
-        if (offsetLF > offset && data[offsetLF - 1] == '\r') {
-            line.setTo(&data[offset], offsetLF - offset - 1);
-        } else {
-            line.setTo(&data[offset], offsetLF - offset);
+        const char *lineData = &data[offset];
+        size_t lineLength = offsetLF - offset;
+        if (lineLength > 0 && data[offsetLF - 1] == '\r') {
+            --lineLength;
         }
 
-        // ALOGI("#%s#", line.c_str());
-
-        if (line.empty()) {
+        if (lineLength == 0) {
             offset = offsetLF + 1;
             continue;
         }
 
+        // The first segment number is only known after #EXT-X-MEDIA-SEQUENCE,
+        // or once a segment was added without it.
+        const Item *previousItem = NULL;
+        if (canReuse && mIsExtM3U && !mIsVariantPlaylist && itemMeta == NULL
+                && ((mMeta != NULL && mMeta->contains("media-sequence")) || mItems.size() > 0)) {
+            int32_t firstSeq = 0;
+            if (mMeta != NULL) {
+                mMeta->findInt32("media-sequence", &firstSeq);
+            }
+            previousItem = previous->findItemForSeq((int64_t)firstSeq + mItems.size());
+        }
+
+        if (previousItem != NULL) {
+            if (lineData[0] == '#') {
+                if (isSegmentTag(lineData, lineLength)) {
+                    offset = offsetLF + 1;
+                    ++lineNo;
+                    continue;
+                }
+            } else {
+                if (previousItem->mURI.size() != lineLength
+                        || memcmp(previousItem->mURI.c_str(), lineData, lineLength)) {
+                    return -EAGAIN;
+                }
+                mItems.push(*previousItem);
+
+                const sp<AMessage> &meta = previousItem->mMeta;
+                int32_t discontinuitySeq;
+                if (meta->findInt32("discontinuity-sequence", &discontinuitySeq)) {
+                    mDiscontinuityCount = discontinuitySeq - (int32_t)mDiscontinuitySeq;
+                }
+                int64_t rangeOffset, rangeLength;
+                if (meta->findInt64("range-offset", &rangeOffset)
+                        && meta->findInt64("range-length", &rangeLength)) {
+                    segmentRangeOffset = rangeOffset + rangeLength;
+                }
+
+                offset = offsetLF + 1;
+                ++lineNo;
+                continue;
+            }
+        }
+
+        AString line(lineData, lineLength);
+
+        // ALOGI("#%s#", line.c_str());
+
         if (lineNo == 0 && line == "#EXTM3U") {
             mIsExtM3U = true;
         }
@@ -732,7 +827,8 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         mLastSeqNumber = mFirstSeqNumber + mItems.size() - 1;
     }
 
-    for (size_t i = 0; i < mItems.size(); ++i) {
+    // only the stream info of variant playlists refers to media groups
+    for (size_t i = 0; mIsVariantPlaylist && i < mItems.size(); ++i) {
         sp<AMessage> meta = mItems.itemAt(i).mMeta;
         const char *keys[] = {"audio", "video", "subtitles"};
         for (size_t j = 0; j < sizeof(keys) / sizeof(const char *); ++j) {
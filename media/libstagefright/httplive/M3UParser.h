@@ -27,7 +27,10 @@
 namespace android {
 
 struct M3UParser : public RefBase {
-    M3UParser(const char *baseURI, const void *data, size_t size);
+    // previous is the last version of the same media playlist, if any. The segments
+    // it shares with this one are taken from it instead of being parsed again.
+    M3UParser(const char *baseURI, const void *data, size_t size,
+            const sp<M3UParser> &previous = NULL);
 
     status_t initCheck() const;
 
@@ -89,7 +92,9 @@ private:
     // Media groups keyed by group ID.
     KeyedVector<AString, sp<MediaGroup> > mMediaGroups;
 
-    status_t parse(const void *data, size_t size);
+    status_t parse(const void *data, size_t size, const sp<M3UParser> &previous);
+    void reset();
+    const Item *findItemForSeq(int64_t seq) const;
 
     static status_t parseMetaData(
             const AString &line, sp<AMessage> *meta, const char *key);
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PlaylistFetcher"
 #include <android-base/macros.h>
+#include <utils/Condition.h>
 #include <utils/Log.h>
 #include <utils/misc.h>
 
@@ -32,6 +33,7 @@
 #include <media/stagefright/foundation/ABitReader.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 #include <media/stagefright/foundation/MediaKeys.h>
 #include <media/stagefright/foundation/avc_utils.h>
@@ -44,6 +46,8 @@
 #include <ctype.h>
 #include <inttypes.h>
 
+#include <algorithm>
+
 #define FLOGV(fmt, ...) ALOGV("[fetcher-%d] " fmt, mFetcherID, ##__VA_ARGS__)
 #define FSLOGV(stream, fmt, ...) ALOGV("[fetcher-%d] [%s] " fmt, mFetcherID, \
          LiveSession::getNameForStream(stream), ##__VA_ARGS__)
@@ -89,6 +93,218 @@ PlaylistFetcher::DownloadState::DownloadState() {
     resetState();
 }
 
+// Downloads one segment ahead of the fetcher with its own HTTPDownloader, so
+// that the download overlaps with the parsing of the current segment, the
+// playlist refresh, and the other fetchers that share the fetcher looper.
+// The fetcher then reads the segment from here block by block, as it would
+// from HTTPDownloader::fetchBlock.
+struct PlaylistFetcher::SegmentPrefetcher : public AHandler {
+    explicit SegmentPrefetcher(const sp<LiveSession> &session);
+
+    void start(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+    void cancel();
+
+    // While interrupted, read() returns ERROR_NOT_CONNECTED instead of waiting,
+    // the download itself goes on.
+    void setInterrupted(bool interrupted);
+
+    // Returns true if this segment is prefetched, and rewinds it for read().
+    bool take(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+
+    // Appends at most blockSize bytes to *out. Same return values as fetchBlock.
+    ssize_t read(sp<ABuffer> *out, size_t blockSize);
+
+protected:
+    virtual ~SegmentPrefetcher() {}
+    virtual void onMessageReceived(const sp<AMessage> &msg);
+
+private:
+    enum {
+        kWhatFetch = 'ftch',
+    };
+
+    sp<LiveSession> mSession;
+    sp<HTTPDownloader> mHTTPDownloader;
+
+    Mutex mLock;
+    Condition mCondition;
+    int32_t mGeneration;
+    bool mActive;
+    bool mInterrupted;
+    AString mURI;
+    int64_t mRangeOffset;
+    int64_t mRangeLength;
+    sp<ABuffer> mBuffer;
+    size_t mConsumed;
+    status_t mStatus;
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+PlaylistFetcher::SegmentPrefetcher::SegmentPrefetcher(const sp<LiveSession> &session)
+    : mSession(session),
+      mHTTPDownloader(session->getHTTPDownloader()),
+      mGeneration(0),
+      mActive(false),
+      mInterrupted(false),
+      mRangeOffset(0),
+      mRangeLength(-1),
+      mConsumed(0),
+      mStatus(OK) {
+}
+
+void PlaylistFetcher::SegmentPrefetcher::start(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    cancel();
+
+    Mutex::Autolock autoLock(mLock);
+    mActive = true;
+    mURI = uri;
+    mRangeOffset = rangeOffset;
+    mRangeLength = rangeLength;
+    mConsumed = 0;
+    mStatus = OK;
+
+    sp<AMessage> msg = new AMessage(kWhatFetch, this);
+    msg->setInt32("generation", mGeneration);
+    msg->post();
+}
+
+void PlaylistFetcher::SegmentPrefetcher::cancel() {
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (!mActive) {
+            return;
+        }
+        ++mGeneration;
+        mActive = false;
+        mBuffer.clear();
+        mCondition.broadcast();
+    }
+    mHTTPDownloader->disconnect();
+}
+
+void PlaylistFetcher::SegmentPrefetcher::setInterrupted(bool interrupted) {
+    Mutex::Autolock autoLock(mLock);
+    mInterrupted = interrupted;
+    mCondition.broadcast();
+}
+
+bool PlaylistFetcher::SegmentPrefetcher::take(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    Mutex::Autolock autoLock(mLock);
+    if (!mActive || (mStatus != OK && mStatus != ERROR_END_OF_STREAM) || mURI != uri
+            || mRangeOffset != rangeOffset || mRangeLength != rangeLength) {
+        return false;
+    }
+    mConsumed = 0;
+    return true;
+}
+
+ssize_t PlaylistFetcher::SegmentPrefetcher::read(sp<ABuffer> *out, size_t blockSize) {
+    Mutex::Autolock autoLock(mLock);
+
+    size_t available;
+    for (;;) {
+        if (!mActive || mInterrupted) {
+            return ERROR_NOT_CONNECTED;
+        }
+        available = (mBuffer != NULL ? mBuffer->size() : 0) - mConsumed;
+        if (available > 0 || mStatus != OK) {
+            break;
+        }
+        mCondition.wait(mLock);
+    }
+
+    if (available == 0) {
+        if (mStatus != ERROR_END_OF_STREAM) {
+            return mStatus;
+        }
+        if (*out == NULL) {
+            *out = new ABuffer(0);
+        }
+        return 0;
+    }
+
+    size_t n = std::min(available, blockSize);
+    sp<ABuffer> buffer = *out;
+    if (buffer == NULL || buffer->capacity() - buffer->size() < n) {
+        // Grow to the size of the whole segment if known, as fetchBlock does.
+        sp<ABuffer> copy = new ABuffer(std::max(mBuffer->capacity(),
+                (buffer != NULL ? buffer->size() : 0) + n));
+        copy->setRange(0, 0);
+        if (buffer != NULL) {
+            memcpy(copy->data(), buffer->data(), buffer->size());
+            copy->setRange(0, buffer->size());
+        }
+        buffer = copy;
+    }
+    memcpy(buffer->data() + buffer->size(), mBuffer->data() + mConsumed, n);
+    buffer->setRange(0, buffer->size() + n);
+    mConsumed += n;
+
+    *out = buffer;
+    return n;
+}
+
+void PlaylistFetcher::SegmentPrefetcher::onMessageReceived(const sp<AMessage> &msg) {
+    CHECK_EQ(msg->what(), (uint32_t)kWhatFetch);
+
+    int32_t generation;
+    CHECK(msg->findInt32("generation", &generation));
+
+    AString uri;
+    int64_t rangeOffset, rangeLength;
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (generation != mGeneration) {
+            return;
+        }
+        uri = mURI;
+        rangeOffset = mRangeOffset;
+        rangeLength = mRangeLength;
+    }
+
+    mHTTPDownloader->reconnect();
+
+    sp<ABuffer> buffer;
+    bool connect = true;
+    for (;;) {
+        int64_t startUs = ALooper::GetNowUs();
+        ssize_t n = mHTTPDownloader->fetchBlock(
+                uri.c_str(), &buffer, rangeOffset, rangeLength, kDownloadBlockSize,
+                NULL /* actualURL */, connect);
+        int64_t delayUs = ALooper::GetNowUs() - startUs;
+        connect = false;
+
+        if (n > 0) {
+            mSession->addBandwidthMeasurement(n, delayUs);
+        }
+
+        Mutex::Autolock autoLock(mLock);
+        if (generation != mGeneration) {
+            break;
+        }
+        if (n < 0) {
+            ALOGW("prefetching '%s' failed (%zd)", uriDebugString(uri).c_str(), n);
+            mStatus = n;
+        } else {
+            mBuffer = buffer;
+            if (n == 0) {
+                mStatus = ERROR_END_OF_STREAM;
+            }
+        }
+        mCondition.broadcast();
+        if (n <= 0) {
+            break;
+        }
+    }
+
+    mHTTPDownloader->disconnect();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool PlaylistFetcher::DownloadState::hasSavedState() const {
     return mHasSavedState;
 }
@@ -177,6 +393,7 @@ PlaylistFetcher::PlaylistFetcher(
       mSampleAesKeyItemChanged(false),
       mThresholdRatio(-1.0f),
       mDownloadState(new DownloadState()),
+      mSegmentPrefetched(false),
       mHasMetadata(false) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
@@ -186,6 +403,11 @@ PlaylistFetcher::PlaylistFetcher(
 }
 
 PlaylistFetcher::~PlaylistFetcher() {
+    if (mPrefetcherLooper != NULL) {
+        mPrefetcher->cancel();
+        mPrefetcherLooper->stop();
+        mPrefetcherLooper->unregisterHandler(mPrefetcher->id());
+    }
 }
 
 int32_t PlaylistFetcher::getFetcherID() const {
@@ -525,6 +747,9 @@ void PlaylistFetcher::setStoppingThreshold(float thresholdRatio, bool disconnect
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        if (mPrefetcher != NULL) {
+            mPrefetcher->setInterrupted(true);
+        }
     }
 }
 
@@ -535,10 +760,16 @@ void PlaylistFetcher::resetStoppingThreshold(bool disconnect) {
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        if (mPrefetcher != NULL) {
+            mPrefetcher->cancel();
+        }
     } else {
         // allow reconnect
         mHTTPDownloader->reconnect();
     }
+    if (mPrefetcher != NULL) {
+        mPrefetcher->setInterrupted(false);
+    }
 }
 
 float PlaylistFetcher::getStoppingThreshold() {
@@ -937,7 +1168,7 @@ status_t PlaylistFetcher::refreshPlaylist() {
     if (delayUsToRefreshPlaylist() <= 0) {
         bool unchanged;
         sp<M3UParser> playlist = mHTTPDownloader->fetchPlaylist(
-                mURI.c_str(), mPlaylistHash, &unchanged);
+                mURI.c_str(), mPlaylistHash, &unchanged, mPlaylist);
 
         if (playlist == NULL) {
             if (unchanged) {
@@ -1364,14 +1595,26 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    if (connectHTTP) {
+        mSegmentPrefetched = mPrefetcher != NULL
+                && mPrefetcher->take(uri, range_offset, range_length);
+        if (!mSegmentPrefetched && mPrefetcher != NULL) {
+            mPrefetcher->cancel();
+        }
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     do {
         int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
+        if (mSegmentPrefetched) {
+            bytesRead = mPrefetcher->read(&buffer, kDownloadBlockSize);
+        } else {
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+        }
         int64_t delayUs = ALooper::GetNowUs() - startUs;
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
@@ -1386,8 +1629,8 @@ void PlaylistFetcher::onDownloadNext() {
 
         // add sample for bandwidth estimation, excluding samples from subtitles (as
         // its too small), or during startup/resumeUntil (when we could have more than
-        // one connection open which affects bandwidth)
-        if (!mStartup && mStopParams == NULL && bytesRead > 0
+        // one connection open which affects bandwidth). The prefetcher adds its own.
+        if (!mStartup && mStopParams == NULL && bytesRead > 0 && !mSegmentPrefetched
                 && (mStreamTypeMask
                         & (LiveSession::STREAMTYPE_AUDIO
                         | LiveSession::STREAMTYPE_VIDEO))) {
@@ -1541,6 +1784,8 @@ void PlaylistFetcher::onDownloadNext() {
     }
 
     ++mSeqNumber;
+    mSegmentPrefetched = false;
+    prefetchNextSegment(firstSeqNumberInPlaylist);
 
     // if adapting, pause after found the next starting point
     if (mSeekMode != LiveSession::kSeekModeExactPosition && startUp != mStartup) {
@@ -1555,6 +1800,41 @@ void PlaylistFetcher::onDownloadNext() {
     }
 }
 
+void PlaylistFetcher::prefetchNextSegment(int32_t firstSeqNumberInPlaylist) {
+    // Only in steady playback of audio and video, when the next segment is
+    // known and the fetcher is not about to stop.
+    if (mPlaylist == NULL || mStartup || mStopParams != NULL
+            || getStoppingThreshold() >= 0.0f
+            || !(mStreamTypeMask
+                    & (LiveSession::STREAMTYPE_AUDIO | LiveSession::STREAMTYPE_VIDEO))) {
+        return;
+    }
+    int32_t index = mSeqNumber - firstSeqNumberInPlaylist;
+    if (index < 0 || (size_t)index >= mPlaylist->size()) {
+        return;
+    }
+
+    AString uri;
+    sp<AMessage> itemMeta;
+    CHECK(mPlaylist->itemAt(index, &uri, &itemMeta));
+    int64_t rangeOffset, rangeLength;
+    if (!itemMeta->findInt64("range-offset", &rangeOffset)
+            || !itemMeta->findInt64("range-length", &rangeLength)) {
+        rangeOffset = 0;
+        rangeLength = -1;
+    }
+
+    if (mPrefetcher == NULL) {
+        mPrefetcher = new SegmentPrefetcher(mSession);
+        mPrefetcherLooper = new ALooper;
+        mPrefetcherLooper->setName("SegmentPrefetcher");
+        mPrefetcherLooper->start(false /* runOnCallingThread */, true /* canCallJava */);
+        mPrefetcherLooper->registerHandler(mPrefetcher);
+    }
+    FLOGV("prefetching segment %d", mSeqNumber);
+    mPrefetcher->start(uri, rangeOffset, rangeLength);
+}
+
 /*
  * returns true if we need to adjust mSeqNumber
  */
@@ -106,6 +106,7 @@ private:
     };
 
     struct DownloadState;
+    struct SegmentPrefetcher;
 
     static const int64_t kMaxMonitorDelayUs;
     static const int32_t kNumSkipFrames;
@@ -187,6 +188,12 @@ private:
 
     sp<DownloadState> mDownloadState;
 
+    // Downloads the segment after the current one on its own looper, and
+    // whether the segment in progress is read from it.
+    sp<SegmentPrefetcher> mPrefetcher;
+    sp<ALooper> mPrefetcherLooper;
+    bool mSegmentPrefetched;
+
     bool mHasMetadata;
 
     // Set first to true if decrypting the first segment of a playlist segment. When
@@ -223,6 +230,7 @@ private:
     void onStop(const sp<AMessage> &msg);
     void onMonitorQueue();
     void onDownloadNext();
+    void prefetchNextSegment(int32_t firstSeqNumberInPlaylist);
     void initSeqNumberForLiveStream(
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
@@ -383,15 +383,26 @@ void ID3::removeUnsynchronization() {
     // This file has "unsynchronization", so we have to replace occurrences
     // of 0xff 0x00 with just 0xff in order to get the real data.
 
+    // Look for the 0xff bytes with memchr() and move the runs between them in bulk,
+    // rather than copying the (possibly multi-megabyte) tag a byte at a time.
     size_t writeOffset = 1;
-    for (size_t readOffset = 1; readOffset < mSize; ++readOffset) {
-        if (mData[readOffset - 1] == 0xff && mData[readOffset] == 0x00) {
-            continue;
+    size_t readOffset = 1;
+    while (readOffset < mSize) {
+        const uint8_t *ff = (const uint8_t *)memchr(
+                &mData[readOffset - 1], 0xff, mSize - readOffset);
+        size_t runEnd = mSize;
+        size_t nextReadOffset = mSize;
+        if (ff != NULL) {
+            const size_t ffOffset = ff - mData;
+            // Keep the 0xff and drop a following 0x00; otherwise keep the following byte too.
+            runEnd = mData[ffOffset + 1] == 0x00 ? ffOffset + 1 : ffOffset + 2;
+            nextReadOffset = ffOffset + 2;
         }
-        // Only move data if there's actually something to move.
-        // This handles the special case of the data being only [0xff, 0x00]
-        // which should be converted to just 0xff if unsynchronization is on.
-        mData[writeOffset++] = mData[readOffset];
+        if (runEnd > readOffset) {
+            memmove(&mData[writeOffset], &mData[readOffset], runEnd - readOffset);
+            writeOffset += runEnd - readOffset;
+        }
+        readOffset = nextReadOffset;
     }
 
     if (writeOffset < mSize) {
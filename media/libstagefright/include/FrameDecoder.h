@@ -22,12 +22,14 @@
 
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/MediaSource.h>
 #include <media/openmax/OMX_Video.h>
 #include <ui/GraphicTypes.h>
 
 namespace android {
 
+struct ABuffer;
 struct AMessage;
 struct MediaCodec;
 class IMediaSource;
@@ -49,6 +51,12 @@ struct FrameDecoder : public RefBase {
 
     sp<IMemory> extractFrame(FrameRect *rect = NULL);
 
+    // Retargets an initialized decoder at another frame, flushing the codec
+    // instead of instantiating a new one. The next extractFrame() returns the
+    // new frame in its own memory. Returns ERROR_UNSUPPORTED if the decoder
+    // cannot seek with this option, in which case it must not be used further.
+    status_t seek(int64_t frameTimeUs, int option);
+
     static sp<IMemory> getMetadataOnly(
             const sp<MetaData> &trackMeta, int colorFormat, bool thumbnail = false);
 
@@ -63,6 +71,15 @@ protected:
 
     virtual status_t onExtractRect(FrameRect *rect) = 0;
 
+    virtual status_t onSeek(
+            int64_t frameTimeUs __unused,
+            int seekMode __unused,
+            MediaSource::ReadOptions *options __unused) { return ERROR_UNSUPPORTED; }
+
+    // Called before the first sample is read. A subclass that decodes all
+    // samples without the loop of extractFrame() does so here and sets *done.
+    virtual status_t onDecodeAllSamples(bool *done) { *done = false; return OK; }
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer,
             MetaDataBase &sampleMeta,
@@ -75,12 +92,18 @@ protected:
             int64_t timeUs,
             bool *done) = 0;
 
+    const AString &componentName() const    { return mComponentName; }
     sp<MetaData> trackMeta()     const      { return mTrackMeta; }
+    sp<AMessage> codecFormat()   const      { return mCodecFormat; }
+    sp<MediaCodec> decoder()     const      { return mDecoder; }
     OMX_COLOR_FORMATTYPE dstFormat() const  { return mDstFormat; }
     ui::PixelFormat captureFormat() const   { return mCaptureFormat; }
     int32_t dstBpp()             const      { return mDstBpp; }
     void setFrame(const sp<IMemory> &frameMem) { mFrameMemory = frameMem; }
 
+    // Reads the next sample of the source, applying the pending seek.
+    status_t readSample(MediaBufferBase **buffer);
+
 private:
     AString mComponentName;
     sp<MetaData> mTrackMeta;
@@ -91,6 +114,7 @@ private:
     sp<IMemory> mFrameMemory;
     MediaSource::ReadOptions mReadOptions;
     sp<MediaCodec> mDecoder;
+    sp<AMessage> mCodecFormat;
     sp<AMessage> mOutputFormat;
     bool mHaveMoreInputs;
     bool mFirstSample;
@@ -120,6 +144,11 @@ protected:
         return (rect == NULL) ? OK : ERROR_UNSUPPORTED;
     }
 
+    virtual status_t onSeek(
+            int64_t frameTimeUs,
+            int seekMode,
+            MediaSource::ReadOptions *options) override;
+
     virtual status_t onInputReceived(
             const sp<MediaCodecBuffer> &codecBuffer,
             MetaDataBase &sampleMeta,
@@ -133,14 +162,22 @@ protected:
             bool *done) override;
 
 private:
+    // Consecutive frames are output in alternate memory, so that a client
+    // streaming the sequence can read a frame while the next one is decoded.
+    static const size_t kFrameMemoryCount = 2;
+
     sp<FrameCaptureLayer> mCaptureLayer;
     VideoFrame *mFrame;
+    sp<IMemory> mFrameMemories[kFrameMemoryCount];
+    size_t mNextFrameMemory;
     bool mIsAvcOrHevc;
     MediaSource::ReadOptions::SeekMode mSeekMode;
     int64_t mTargetTimeUs;
     List<int64_t> mSampleDurations;
     int64_t mDefaultSampleDurationUs;
 
+    bool isSeekingClosest() const;
+    void setSeekTo(int64_t frameTimeUs, MediaSource::ReadOptions *options);
     sp<Surface> initSurface();
     status_t captureSurface();
 };
@@ -172,6 +209,8 @@ protected:
             int64_t timeUs,
             bool *done) override;
 
+    virtual status_t onDecodeAllSamples(bool *done) override;
+
 private:
     VideoFrame *mFrame;
     int32_t mWidth;
@@ -182,6 +221,21 @@ private:
     int32_t mTileHeight;
     int32_t mTilesDecoded;
     int32_t mTargetTiles;
+    // Only the tiles intersecting mRegion are decoded if mDecodeRegion.
+    bool mDecodeRegion;
+    FrameRect mRegion;
+
+    bool tileInRegion(int32_t tileIndex) const;
+    void allocFrame();
+    status_t convertTile(
+            const sp<MediaCodecBuffer> &tileBuffer,
+            const sp<AMessage> &outputFormat,
+            int32_t tileIndex);
+    status_t decodeTiles(
+            const sp<MediaCodec> &codec,
+            const std::vector<sp<ABuffer> > &tiles,
+            const std::vector<int32_t> &tileIndices,
+            size_t first, size_t step);
 };
 
 }  // namespace android
@@ -23,6 +23,7 @@
 #include <media/stagefright/MediaSource.h>
 #include <media/MicrophoneInfo.h>
 #include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaBufferGroup.h>
 #include <utils/List.h>
 
 #include <system/audio.h>
@@ -80,8 +81,19 @@ protected:
 
 private:
     enum {
+        // Size of the periods of the AudioRecord callback.
         kMaxBufferSize = 2048,
 
+        // Periods are aggregated into buffers of a multiple of this many frames,
+        // lasting at least kMinBufferDurationUs, so that the encoder is fed
+        // whole frames at a lower rate than the AudioRecord callback runs.
+        kBufferFrameAlignment = 1024,
+        kMinBufferDurationUs = 40000,
+
+        // Buffers preallocated in, and the usual limit of, mBufferGroup.
+        kMinBufferCount = 4,
+        kMaxBufferCount = 32,
+
         // After the initial mute, we raise the volume linearly
         // over kAutoRampDurationUs.
         kAutoRampDurationUs = 300000,
@@ -100,6 +112,8 @@ private:
     bool mStarted;
     int32_t mSampleRate;
     int32_t mOutSampleRate;
+    size_t mBufferSize;
+    MediaBufferGroup *mBufferGroup;
 
     bool mTrackMaxAmplitude;
     int64_t mStartTimeUs;
@@ -114,7 +128,13 @@ private:
     int64_t mNumClientOwnedBuffers;
     bool mNoMoreFramesToRead;
 
-    List<MediaBuffer * > mBuffersReceived;
+    List<MediaBufferBase * > mBuffersReceived;
+
+    // Buffer that the AudioRecord periods are copied to until it is full,
+    // the time of its first frame and mNumFramesReceived before it.
+    MediaBufferBase *mPendingBuffer;
+    int64_t mPendingTimeUs;
+    int64_t mPendingStartFrame;
 
     void trackMaxAmplitude(int16_t *data, int nSamples);
 
@@ -124,7 +144,11 @@ private:
         int32_t startFrame, int32_t rampDurationFrames,
         uint8_t *data,   size_t bytes);
 
-    void queueInputBuffer_l(MediaBuffer *buffer, int64_t timeUs);
+    // Copies size bytes of data, or of silence if data is NULL, to the pending
+    // buffer, queueing each buffer that is filled. timeUs is the time of the
+    // first frame.
+    void appendFrames_l(const uint8_t *data, size_t size, int64_t timeUs);
+    void queuePendingBuffer_l();
     void releaseQueuedFrames_l();
     void waitOutstandingEncodingFrames_l();
     status_t reset();
@@ -127,6 +127,22 @@ public:
      */
     MetadataBufferType metaDataStoredInVideoBuffers() const;
 
+    /**
+     * Tell whether the camera can send its video buffers to the input surface
+     * of an encoder, see setEncoderInputSurface().
+     */
+    bool canUseEncoderInputSurface() const;
+
+    /**
+     * Have the camera send its video buffers straight to the input surface of
+     * an encoder, rather than through this source. This must be called before
+     * start(), and read() returns no frames afterwards. The encoder is then
+     * responsible for frame timestamps and dropping.
+     *
+     * @return OK if no error.
+     */
+    status_t setEncoderInputSurface(const sp<IGraphicBufferProducer>& surface);
+
     virtual void signalBufferReturned(MediaBufferBase* buffer);
 
 protected:
@@ -217,6 +233,7 @@ protected:
                  bool storeMetaDataInVideoBuffers);
 
     virtual status_t startCameraRecording();
+    virtual void stopCameraRecording();
     virtual void releaseRecordingFrame(const sp<IMemory>& frame);
     virtual void releaseRecordingFrameHandle(native_handle_t* handle);
     // stagefright recorder not using this for now
@@ -274,6 +291,8 @@ private:
     // Consumer and producer of the buffer queue between this class and camera.
     sp<BufferItemConsumer> mVideoBufferConsumer;
     sp<IGraphicBufferProducer> mVideoBufferProducer;
+    // Input surface of the encoder that the camera sends video buffers to, if any.
+    sp<IGraphicBufferProducer> mEncoderInputSurface;
     // Memory used to send the buffers to encoder, where sp<IMemory> stores VideoNativeMetadata.
     sp<IMemoryHeap> mMemoryHeapBase;
     List<sp<IMemory>> mMemoryBases;
@@ -330,7 +349,6 @@ private:
     // mLock must be locked before calling this function.
     bool shouldSkipFrameLocked(int64_t timestampUs);
 
-    void stopCameraRecording();
     status_t reset();
 
     CameraSource(const CameraSource &);
@@ -71,6 +71,14 @@ private:
     // Real timestamp of the last encoded time lapse frame
     int64_t mLastTimeLapseFrameRealTimestampUs;
 
+    // Preview fps range of the camera before it was lowered to pace the
+    // capture, empty if it was not.
+    String8 mOriginalFpsRange;
+
+    // How much earlier than mTimeBetweenFrameCaptureUs a frame may arrive and
+    // still be encoded, half a frame time when the camera paces the capture.
+    int64_t mCaptureIntervalToleranceUs;
+
     // Variable set in dataCallbackTimestamp() to help skipCurrentFrame()
     // to know if current frame needs to be skipped.
     bool mSkipCurrentFrame;
@@ -164,6 +172,13 @@ private:
             const std::vector<int64_t>& timestampsUs,
             const std::vector<native_handle_t*>& handles);
 
+    // Lowers the camera frame rate towards the capture rate before recording starts,
+    // then starts recording.
+    virtual status_t startCameraRecording();
+
+    // Stops recording and restores the camera frame rate.
+    virtual void stopCameraRecording();
+
     // Process a buffer item received in CameraSource::BufferQueueListener.
     // This will be called in VIDEO_BUFFER_MODE_BUFFER_QUEUE mode.
     virtual void processBufferQueueFrame(BufferItem& buffer);
@@ -177,6 +192,12 @@ private:
     // Otherwise returns false.
     bool trySettingVideoSize(int32_t width, int32_t height);
 
+    // Sets the supported preview fps range whose maximum is the lowest one that
+    // is at least the capture rate, so that the camera does not produce frames
+    // at the full rate only for most of them to be skipped. The skipping in
+    // skipFrameAndModifyTimeStamp() still applies to the frames it produces.
+    void trySettingCaptureFpsRange();
+
     // When video camera is used for time lapse capture, returns true
     // until enough time has passed for the next time lapse frame. When
     // the frame needs to be encoded, it returns false and also modifies
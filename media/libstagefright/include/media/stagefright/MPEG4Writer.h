@@ -19,15 +19,18 @@
 #define MPEG4_WRITER_H_
 
 #include <stdio.h>
+#include <sys/uio.h>
 
 #include <media/stagefright/MediaWriter.h>
 #include <utils/List.h>
 #include <utils/threads.h>
+#include <atomic>
 #include <map>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace android {
 
@@ -61,8 +64,15 @@ public:
     void writeFourcc(const char *fourcc);
     void write(const void *data, size_t size);
     inline size_t write(const void *ptr, size_t size, size_t nmemb);
-    // Write to file system by calling ::write() or post error message to looper on failure.
+    // Queue a write to the file system, see flushWrites().
     void writeOrPostError(int fd, const void *buf, size_t count);
+    // Queue a write of sample data, which is written in place rather than copied and
+    // must stay valid until the next flushWrites().
+    void writeSampleDataOrPostError(const void *buf, size_t count);
+    void queueWrite(const void *buf, size_t count, bool copy);
+    // Write the queued writes by calling ::writev() or post error message to looper
+    // on failure.
+    void flushWrites();
     // Seek in the file by calling ::lseek64() or post error message to looper on failure.
     void seekOrPostError(int fd, off64_t offset, int whence);
     void endBox();
@@ -110,10 +120,26 @@ private:
     uint8_t *mInMemoryCache;
     off64_t mInMemoryCacheOffset;
     off64_t mInMemoryCacheSize;
+    off64_t mInMemoryCacheCapacity;  // Allocated size of mInMemoryCache
     bool  mWriteBoxToMemory;
     off64_t mFreeBoxOffset;
     bool mStreamableFile;
     off64_t mMoovExtraSize;
+
+    // Chunk offset tables of the moov box in the in-memory cache, which are
+    // patched if the mdat box is moved by relocateMdat().
+    struct ChunkOffsetTable {
+        off64_t mOffset;
+        size_t mNumEntries;
+    };
+    bool mRelocateMdat;
+    std::vector<ChunkOffsetTable> mMoovChunkOffsetTables;
+
+    // Fragmented MP4: each track is written in fragments of about
+    // mFragmentDurationUs, after a moov box without samples.
+    int64_t mFragmentDurationUs;
+    bool mWroteFragmentedMoov;
+    uint32_t mFragmentSequenceNumber;
     uint32_t mInterleaveDurationUs;
     int32_t mTimeScale;
     int64_t mStartTimestampUs;
@@ -131,6 +157,12 @@ private:
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
 
+    // Small writes are combined in an aligned staging buffer, and written along with
+    // the sample data that is referenced in place by a single ::writev().
+    uint8_t *mWriteBuffer;
+    size_t mWriteBufferOffset;
+    std::vector<struct iovec> mPendingWrites;
+
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
 
@@ -154,6 +186,8 @@ private:
     int64_t estimateMoovBoxSize(int32_t bitRate);
     int64_t estimateFileLevelMetaSize(MetaData *params);
     void writeCachedBoxToFile(const char *type);
+    bool relocateMdat();
+    void addMoovChunkOffsetTable(size_t numEntries);
     void printWriteDurations();
 
     struct Chunk {
@@ -186,6 +220,7 @@ private:
     pthread_t       mThread;                // Thread id for the writer
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
+    int32_t         mWriteQueueDepth;       // Max chunks written at a time
 
     // HEIF writing
     typedef key_value_pair_t< const char *, Vector<uint16_t> > ItemRefs;
@@ -251,12 +286,17 @@ private:
     // Return true if a chunk is found; otherwise, return false.
     bool findChunkToWrite(Chunk *chunk);
 
-    // Actually write the given chunk to the file.
+    // Actually write the given chunk to the file. Its samples may be referenced
+    // by queued writes, and must not be released until the next flushWrites().
     void writeChunkToFile(Chunk* chunk);
 
+    // Write the given chunks to the file, then release their samples.
+    void writeChunksToFile(List<Chunk> *chunks);
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
-    int64_t mDriftTimeUs;
+    // Updated by the audio track for every sample, so it does not take mLock.
+    std::atomic<int64_t> mDriftTimeUs;
     void setDriftTimeUs(int64_t driftTimeUs);
     int64_t getDriftTimeUs();
 
@@ -294,11 +334,14 @@ private:
     bool exceedsFileDurationLimit();
     bool approachingFileSizeLimit();
     bool isFileStreamable() const;
+    bool isFragmented() const { return mFragmentDurationUs > 0; }
+    bool fragmentsReady_l();
     void trackProgressStatus(uint32_t trackId, int64_t timeUs, status_t err = OK);
     status_t validateAllTracksId(bool akKey4BitTrackIds);
     void writeCompositionMatrix(int32_t degrees);
     void writeMvhdBox(int64_t durationUs);
     void writeMoovBox(int64_t durationUs);
+    void writeMvexBox();
     void writeFtypBox(MetaData *param);
     void writeUdtaBox();
     void writeGeoDataBox();
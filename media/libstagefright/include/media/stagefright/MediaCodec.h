@@ -92,6 +92,24 @@ struct MediaCodec : public AHandler {
     static const pid_t kNoPid = -1;
     static const uid_t kNoUid = -1;
 
+    // One buffer of queueInputBuffers() or dequeueOutputBuffers().
+    struct BatchBufferInfo {
+        size_t index;
+        size_t offset;
+        size_t size;
+        int64_t presentationTimeUs;
+        uint32_t flags;
+    };
+
+    // One entry of the "access-unit-infos" buffer in the meta of an input buffer that holds
+    // several access units back to back. Only decoders whose input format has a
+    // "max-access-units" greater than 1 accept such buffers.
+    struct AccessUnitInfo {
+        uint32_t flags;     // BUFFER_FLAG_* of the access unit
+        uint32_t size;      // size of the access unit in bytes
+        int64_t timeUs;     // presentation time of the access unit
+    };
+
     static sp<MediaCodec> CreateByType(
             const sp<ALooper> &looper, const AString &mime, bool encoder, status_t *err = NULL,
             pid_t pid = kNoPid, uid_t uid = kNoUid);
@@ -151,6 +169,14 @@ struct MediaCodec : public AHandler {
             uint32_t flags,
             AString *errorDetailMsg = NULL);
 
+    // Queues the buffers in order, with a single round trip to the codec looper.
+    // The first buffer that fails stops the batch and its error is returned.
+    // numQueued is set to the number of buffers queued before that, or to all of them on OK.
+    status_t queueInputBuffers(
+            const std::vector<BatchBufferInfo> &buffers,
+            size_t *numQueued,
+            AString *errorDetailMsg = NULL);
+
     status_t queueSecureInputBuffer(
             size_t index,
             size_t offset,
@@ -206,6 +232,16 @@ struct MediaCodec : public AHandler {
             uint32_t *flags,
             int64_t timeoutUs = 0ll);
 
+    // Same as dequeueOutputBuffer() for the first buffer, then also dequeues the output
+    // buffers that are already available, up to maxBuffers buffers in total.
+    // A format change after the first buffer ends the batch, and is returned by the next
+    // dequeue so that it stays in order. buffers is cleared first, and is empty if an
+    // error or an INFO_ code is returned.
+    status_t dequeueOutputBuffers(
+            std::vector<BatchBufferInfo> *buffers,
+            size_t maxBuffers,
+            int64_t timeoutUs = 0ll);
+
     status_t renderOutputBufferAndRelease(size_t index, int64_t timestampNs);
     status_t renderOutputBufferAndRelease(size_t index);
     status_t releaseOutputBuffer(size_t index);
@@ -309,6 +345,7 @@ private:
         kWhatRelease                        = 'rele',
         kWhatDequeueInputBuffer             = 'deqI',
         kWhatQueueInputBuffer               = 'queI',
+        kWhatQueueInputBuffers              = 'qInB',
         kWhatDequeueOutputBuffer            = 'deqO',
         kWhatReleaseOutputBuffer            = 'relO',
         kWhatSignalEndOfInputStream         = 'eois',
@@ -415,6 +452,9 @@ private:
 
     int32_t mDequeueOutputTimeoutGeneration;
     sp<AReplyToken> mDequeueOutputReplyID;
+    // caller's vector for a pending dequeueOutputBuffers(), nullptr for dequeueOutputBuffer()
+    std::vector<BatchBufferInfo> *mDequeueOutputBatch;
+    size_t mDequeueOutputBatchMax;
 
     sp<ICrypto> mCrypto;
 
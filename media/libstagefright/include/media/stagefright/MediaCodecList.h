@@ -18,6 +18,7 @@
 
 #define MEDIA_CODEC_LIST_H_
 
+#include <string>
 #include <vector>
 
 #include <media/stagefright/foundation/ABase.h>
@@ -96,8 +97,19 @@ private:
     /**
      * This constructor will call `buildMediaCodecList()` from the given
      * `MediaCodecListBuilderBase` objects.
+     *
+     * If `cachePath` is not null, the built list is loaded from the binary
+     * cache at that path when the cache is still valid, instead of calling the
+     * builders, and is saved there otherwise. Only use this with the default
+     * builders, as the cache is keyed by the inputs of those.
      */
-    MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders);
+    MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders,
+                   const char *cachePath = nullptr);
+
+    static bool LoadCache(
+            const char *path, const std::string &key, MediaCodecListWriter *writer);
+    static void SaveCache(
+            const char *path, const std::string &key, const MediaCodecListWriter &writer);
 
     ~MediaCodecList();
 
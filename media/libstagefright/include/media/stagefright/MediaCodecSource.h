@@ -116,6 +116,7 @@ private:
     void signalEOS(status_t err = ERROR_END_OF_STREAM);
     bool reachedEOS();
     status_t postSynchronouslyAndReturnError(const sp<AMessage> &msg);
+    void stopSurfaceSource();
 
     sp<ALooper> mLooper;
     sp<ALooper> mCodecLooper;
@@ -123,6 +124,10 @@ private:
     sp<AMessage> mOutputFormat;
     Mutexed<sp<MetaData>> mMeta;
     sp<Puller> mPuller;
+    // With FLAG_USE_SURFACE_INPUT, a source that renders into the input surface
+    // by itself, such as a camera, which is started and stopped with the encoder.
+    sp<MediaSource> mSurfaceSource;
+    bool mSurfaceSourceStarted;
     sp<MediaCodec> mEncoder;
     uint32_t mFlags;
     List<sp<AReplyToken>> mStopReplyIDQueue;
@@ -28,6 +28,7 @@ namespace android {
 
 class DataSource;
 struct ExtractorPlugin;
+class IMediaExtractorService;
 
 class MediaExtractorFactory {
 public:
@@ -38,6 +39,10 @@ public:
     static status_t dump(int fd, const Vector<String16>& args);
     static std::vector<std::string> getSupportedTypes();
     static void LoadExtractors();
+    // Returns the media.extractor service, or NULL if it is not running. The
+    // connection is kept for the life of the process and dropped when the
+    // service dies, so repeated opens skip the service manager lookup.
+    static sp<IMediaExtractorService> GetExtractorService();
 
 private:
     static Mutex gPluginMutex;
@@ -22,6 +22,9 @@
 #include <utils/Vector.h>
 #include <utils/threads.h>
 
+#include <deque>
+#include <vector>
+
 #include "media/stagefright/foundation/ABase.h"
 
 namespace android {
@@ -91,6 +94,18 @@ public:
      */
     status_t setLocation(int latitude, int longitude);
 
+    /**
+     * Set how samples of different tracks are interleaved. This should be
+     * called before start().
+     * Samples are held back and passed to the writer in timestamp order, as long
+     * as no sample is held behind a sample that is more than maxDelayUs later,
+     * and the held samples take at most maxBytes. Interleaving is disabled if
+     * either is 0. By default samples are held for up to 1 second and 8MB.
+     * HEIF output is not interleaved.
+     * @return OK if no error.
+     */
+    status_t setInterleaving(int64_t maxDelayUs, size_t maxBytes);
+
     /**
      * Stop muxing.
      * This method is a blocking call. Depending on how
@@ -124,6 +139,35 @@ private:
     sp<MetaData> mFileMeta;  // Metadata for the whole file.
     Mutex mMuxerLock;
 
+    // Samples held back for interleaving, see setInterleaving().
+    struct PendingSample {
+        sp<ABuffer> mBuffer;
+        int64_t mTimeUs;
+        uint32_t mFlags;
+    };
+    struct TrackSamples {
+        std::deque<PendingSample> mPending;
+        int64_t mLastTimeUs;  // Latest timestamp written for the track.
+        bool mEos;
+    };
+    std::vector<TrackSamples> mTrackSamples;  // Indexed like mTrackList.
+    int64_t mMaxInterleaveDelayUs;
+    size_t mMaxInterleaveBytes;
+    size_t mPendingBytes;
+    int64_t mLastTimeUs;  // Latest timestamp written for any track.
+
+    // Interleaving statistics, logged at stop().
+    size_t mNumHeldSamples;
+    size_t mMaxPendingBytes;
+    size_t mNumDelayLimitedSamples;
+    size_t mNumSizeLimitedSamples;
+
+    bool isInterleaving() const;
+    status_t pushSample_l(const sp<ABuffer> &buffer, size_t trackIndex,
+                          int64_t timeUs, uint32_t flags);
+    // Passes the held samples that are due to the writer, or all of them.
+    status_t drainPendingSamples_l(bool all);
+
     enum State {
         UNINITIALIZED,
         INITIALIZED,
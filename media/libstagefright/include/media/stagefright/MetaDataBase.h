@@ -247,6 +247,9 @@ enum {
 
     // Treat empty track as malformed for MediaRecorder.
     kKeyEmptyTrackMalFormed = 'nemt', // bool (int32_t)
+
+    // Write a fragmented MP4 file with fragments of this duration.
+    kKeyFragmentDurationUs = 'frdu', // int64_t
 };
 
 enum {
@@ -89,6 +89,9 @@ struct NuMediaExtractor : public RefBase {
     status_t advance();
     // readSampleData() reads the sample with the lowest timestamp.
     status_t readSampleData(const sp<ABuffer> &buffer);
+    // Same as above, but copies into |data| of |capacity| bytes and returns the sample size
+    // in |size|, saving callers that own a plain buffer an ABuffer wrapper per sample.
+    status_t readSampleData(uint8_t *data, size_t capacity, size_t *size);
 
     status_t getSampleSize(size_t *sampleSize);
     status_t getSampleTrackIndex(size_t *trackIndex);
@@ -160,7 +163,7 @@ private:
 
     bool getTotalBitrate(int64_t *bitRate) const;
     status_t updateDurationAndBitrate();
-    status_t appendVorbisNumPageSamples(MediaBufferBase *mbuf, const sp<ABuffer> &buffer);
+    status_t appendVorbisNumPageSamples(MediaBufferBase *mbuf, uint8_t *data);
 
     DISALLOW_EVIL_CONSTRUCTORS(NuMediaExtractor);
 };
@@ -20,9 +20,12 @@
 
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/ProcessInfoInterface.h>
+#include <utils/Mutex.h>
 
 namespace android {
 
+class IProcessInfoService;
+
 struct ProcessInfo : public ProcessInfoInterface {
     ProcessInfo();
 
@@ -33,6 +36,12 @@ protected:
     virtual ~ProcessInfo();
 
 private:
+    // Returns the cached processinfo service, looking it up again only if it has died.
+    sp<IProcessInfoService> getProcessInfoService();
+
+    Mutex mLock;
+    sp<IProcessInfoService> mProcessInfoService;
+
     DISALLOW_EVIL_CONSTRUCTORS(ProcessInfo);
 };
 
@@ -40,6 +40,27 @@ struct VideoFrameSchedulerBase : public RefBase {
     // returns the current frames-per-second, or 0.f if not primed
     float getFrameRate();
 
+    // returns the display refresh rate closest to the current one that is an
+    // integer multiple of the video frame rate, i.e. one on which every frame
+    // stays on screen for the same number of vsyncs. Returns 0.f if not primed.
+    float getPreferredRefreshRate();
+
+    static const size_t kVsyncHistogramSize = 6;  // last bucket holds 5 or more vsyncs
+
+    // frame pacing statistics since the last init()
+    struct JudderStats {
+        JudderStats();
+
+        int64_t mFrames;            // frames with a vsync estimate
+        int64_t mJudderFrames;      // frames held for a different number of vsyncs than
+                                    // the previous frame
+        int64_t mPulldownFrames;    // judder frames following a regular alternating
+                                    // cadence, e.g. 3:2 pulldown of 24p on 60Hz
+        int64_t mMissedFrames;      // frames that would not get a vsync of their own
+        int64_t mVsyncsPerFrame[kVsyncHistogramSize];
+    };
+    const JudderStats &getJudderStats() const { return mJudderStats; }
+
     virtual void release() = 0;
 
     static const size_t kHistorySize = 8;
@@ -88,10 +109,15 @@ private:
 
     virtual void updateVsync() = 0;
 
+    void updateJudderStats(size_t vsyncsForLastFrame);
+
     nsecs_t mLastVsyncTime;    // estimated vsync time for last frame
     nsecs_t mTimeCorrection;   // running adjustment
     PLL mPll;                  // PLL for video frame rate based on render time
 
+    JudderStats mJudderStats;
+    ssize_t mVsyncsForPrevFrames[2];  // vsyncs of the two frames before the last, or -1
+
     DISALLOW_EVIL_CONSTRUCTORS(VideoFrameSchedulerBase);
 };
 
@@ -2204,34 +2204,44 @@ status_t ATSParser::parseAdaptationField(
 status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
     ALOGV("---");
 
-    unsigned sync_byte = br->getBits(8);
+    // The 4 byte packet header is decoded directly, rather than with a dozen
+    // of getBits() calls, since it is parsed for every packet of the stream.
+    if (br->numBitsLeft() < 32) {
+        ALOGE("[error] parseTS: return error as packet is too short");
+        return BAD_VALUE;
+    }
+    const uint8_t *header = br->data();
+
+    unsigned sync_byte = header[0];
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if (header[1] & 0x80) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    unsigned payload_unit_start_indicator = (header[1] >> 6) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (header[1] >> 5) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = ((header[1] & 0x1f) << 8) | header[2];
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = header[3] >> 6;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (header[3] >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = header[3] & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
+    br->skipBits(32);
+
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     status_t err = OK;
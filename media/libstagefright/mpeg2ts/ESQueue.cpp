@@ -685,10 +685,14 @@ status_t ElementaryStreamQueue::appendData(
         }
 
         mBuffer = buffer;
+    } else if (mBuffer->offset() + neededSize > mBuffer->capacity()) {
+        // Reclaim the space of the consumed data, at most once per buffer's worth.
+        memmove(mBuffer->base(), mBuffer->data(), mBuffer->size());
+        mBuffer->setRange(0, mBuffer->size());
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -790,7 +794,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
+        mBuffer->setRange(mBuffer->offset(), leadingClearBytes - pesOffset);
     } else {
         mBuffer->setRange(0, 0);
     }
@@ -897,11 +901,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
+        consumeBuffer(info.mLength);
 
         if (mFormat == NULL) {
             mFormat = new MetaData;
@@ -1002,12 +1002,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1066,12 +1061,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    consumeBuffer(syncStartPos + payloadSize);
     return accessUnit;
 }
 
@@ -1133,12 +1123,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeBuffer(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1282,9 +1267,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     sp<ABuffer> accessUnit = new ABuffer(offset);
     memcpy(accessUnit->data(), mBuffer->data(), offset);
 
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    consumeBuffer(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1292,6 +1275,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     return accessUnit;
 }
 
+void ElementaryStreamQueue::consumeBuffer(size_t size) {
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
 int64_t ElementaryStreamQueue::fetchTimestamp(
         size_t size, int32_t *pesOffset, int32_t *pesScramblingControl) {
     int64_t timeUs = -1;
@@ -1469,11 +1456,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeBuffer(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -1555,11 +1538,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
     sp<ABuffer> accessUnit = new ABuffer(frameSize);
     memcpy(accessUnit->data(), data, frameSize);
 
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    consumeBuffer(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -1656,6 +1635,25 @@ static sp<ABuffer> MakeMPEGVideoESDS(const sp<ABuffer> &csd) {
     return esds;
 }
 
+// Returns the offset of the first 0x00 0x00 0x01 start code at or after offset,
+// or size if there is none. The 0x01 bytes are looked for with memchr(), which
+// is vectorized.
+static size_t findStartCode(const uint8_t *data, size_t size, size_t offset) {
+    while (offset + 2 < size) {
+        const uint8_t *one = (const uint8_t *)memchr(
+                &data[offset + 2], 0x01, size - offset - 2);
+        if (one == NULL) {
+            break;
+        }
+        offset = one - data - 2;
+        if (data[offset] == 0x00 && data[offset + 1] == 0x00) {
+            return offset;
+        }
+        ++offset;
+    }
+    return size;
+}
+
 sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
     const uint8_t *data = mBuffer->data();
     size_t size = mBuffer->size();
@@ -1671,22 +1669,18 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
     bool brokenLink = false;
 
     size_t offset = 0;
-    while (offset + 3 < size) {
-        if (memcmp(&data[offset], "\x00\x00\x01", 3)) {
-            ++offset;
-            continue;
-        }
+    while ((offset = findStartCode(data, size, offset)) + 3 < size) {
 
         pprevStartCode = prevStartCode;
         prevStartCode = currentStartCode;
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            consumeBuffer(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -1715,11 +1709,8 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> csd = new ABuffer(offset);
                 memcpy(csd->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
+                data = mBuffer->data();
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -1758,11 +1749,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> accessUnit = new ABuffer(offset);
                 memcpy(accessUnit->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeBuffer(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -1819,13 +1806,9 @@ static ssize_t getNextChunkSize(
         return -EAGAIN;
     }
 
-    size_t offset = 4;
-    while (offset + 2 < size) {
-        if (!memcmp(&data[offset], kStartCode, 3)) {
-            return offset;
-        }
-
-        ++offset;
+    size_t offset = findStartCode(data, size, 4);
+    if (offset < size) {
+        return offset;
     }
 
     return -EAGAIN;
@@ -1957,9 +1940,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
                     sp<ABuffer> accessUnit = new ABuffer(offset);
                     memcpy(accessUnit->data(), data, offset);
 
-                    memmove(data, &data[offset], size - offset);
+                    consumeBuffer(offset);
+                    data = mBuffer->data();
                     size -= offset;
-                    mBuffer->setRange(0, size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -1995,10 +1978,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            consumeBuffer(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
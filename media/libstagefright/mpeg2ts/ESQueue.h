@@ -132,6 +132,10 @@ private:
             int32_t *pesOffset = NULL,
             int32_t *pesScramblingControl = NULL);
 
+    // drops the first "size" bytes of mBuffer. The bytes are not moved,
+    // the start of the range moves and appendData() reclaims the space.
+    void consumeBuffer(size_t size);
+
     sp<ABuffer> dequeueScrambledAccessUnit();
 
     DISALLOW_EVIL_CONSTRUCTORS(ElementaryStreamQueue);
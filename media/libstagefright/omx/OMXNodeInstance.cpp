@@ -2544,9 +2544,9 @@ IOMX::buffer_id OMXNodeInstance::makeBufferID(OMX_BUFFERHEADERTYPE *bufferHeader
             ++mBufferIDCount;
         }
         buffer = (IOMX::buffer_id)mBufferIDCount;
-    } while (mBufferIDToBufferHeader.indexOfKey(buffer) >= 0);
-    mBufferIDToBufferHeader.add(buffer, bufferHeader);
-    mBufferHeaderToBufferID.add(bufferHeader, buffer);
+    } while (mBufferIDToBufferHeader.count(buffer) != 0);
+    mBufferIDToBufferHeader.emplace(buffer, bufferHeader);
+    mBufferHeaderToBufferID.emplace(bufferHeader, buffer);
     return buffer;
 }
 
@@ -2556,12 +2556,12 @@ OMX_BUFFERHEADERTYPE *OMXNodeInstance::findBufferHeader(
         return NULL;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    auto it = mBufferIDToBufferHeader.find(buffer);
+    if (it == mBufferIDToBufferHeader.end()) {
         CLOGW("findBufferHeader: buffer %u not found", buffer);
         return NULL;
     }
-    OMX_BUFFERHEADERTYPE *header = mBufferIDToBufferHeader.valueAt(index);
+    OMX_BUFFERHEADERTYPE *header = it->second;
     BufferMeta *buffer_meta =
         static_cast<BufferMeta *>(header->pAppPrivate);
     if (buffer_meta->getPortIndex() != portIndex) {
@@ -2577,12 +2577,12 @@ IOMX::buffer_id OMXNodeInstance::findBufferID(OMX_BUFFERHEADERTYPE *bufferHeader
         return 0;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferHeaderToBufferID.indexOfKey(bufferHeader);
-    if (index < 0) {
+    auto it = mBufferHeaderToBufferID.find(bufferHeader);
+    if (it == mBufferHeaderToBufferID.end()) {
         CLOGW("findBufferID: bufferHeader %p not found", bufferHeader);
         return 0;
     }
-    return mBufferHeaderToBufferID.valueAt(index);
+    return it->second;
 }
 
 void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
@@ -2590,13 +2590,13 @@ void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
         return;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    auto it = mBufferIDToBufferHeader.find(buffer);
+    if (it == mBufferIDToBufferHeader.end()) {
         CLOGW("invalidateBufferID: buffer %u not found", buffer);
         return;
     }
-    mBufferHeaderToBufferID.removeItem(mBufferIDToBufferHeader.valueAt(index));
-    mBufferIDToBufferHeader.removeItemsAt(index);
+    mBufferHeaderToBufferID.erase(it->second);
+    mBufferIDToBufferHeader.erase(it);
 }
 
 }  // namespace android
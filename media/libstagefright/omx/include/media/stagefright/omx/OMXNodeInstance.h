@@ -19,6 +19,7 @@
 #define OMX_NODE_INSTANCE_H_
 
 #include <atomic>
+#include <unordered_map>
 
 #include <media/IOMX.h>
 #include <utils/RefBase.h>
@@ -148,8 +149,9 @@ private:
     // for buffer ptr to buffer id translation
     Mutex mBufferIDLock;
     uint32_t mBufferIDCount;
-    KeyedVector<IOMX::buffer_id, OMX_BUFFERHEADERTYPE *> mBufferIDToBufferHeader;
-    KeyedVector<OMX_BUFFERHEADERTYPE *, IOMX::buffer_id> mBufferHeaderToBufferID;
+    // Hashed, as both maps are consulted on every empty/fill buffer call and callback.
+    std::unordered_map<IOMX::buffer_id, OMX_BUFFERHEADERTYPE *> mBufferIDToBufferHeader;
+    std::unordered_map<OMX_BUFFERHEADERTYPE *, IOMX::buffer_id> mBufferHeaderToBufferID;
 
     bool mLegacyAdaptiveExperiment;
     IOMX::PortMode mPortMode[2];
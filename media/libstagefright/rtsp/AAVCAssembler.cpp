@@ -92,7 +92,7 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addNALUnit(
 
     unsigned nalType = data[0] & 0x1f;
     if (nalType >= 1 && nalType <= 23) {
-        addSingleNALUnit(buffer);
+        addSingleNALUnit(buffer, 0, buffer->size());
         queue->erase(queue->begin());
         ++mNextExpectedSeqNo;
         return OK;
@@ -123,21 +123,27 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addNALUnit(
     }
 }
 
-void AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
-    ALOGV("addSingleNALUnit of size %zu", buffer->size());
+void AAVCAssembler::addSingleNALUnit(
+        const sp<ABuffer> &buffer, size_t offset, size_t size) {
+    ALOGV("addSingleNALUnit of size %zu", size);
 #if !LOG_NDEBUG
-    hexdump(buffer->data(), buffer->size());
+    hexdump(buffer->data() + offset, size);
 #endif
 
     uint32_t rtpTime;
     CHECK(buffer->meta()->findInt32("rtp-time", (int32_t *)&rtpTime));
 
-    if (!mNALUnits.empty() && rtpTime != mAccessUnitRTPTime) {
+    if (!mNALPieces.empty() && rtpTime != mAccessUnitRTPTime) {
         submitAccessUnit();
     }
     mAccessUnitRTPTime = rtpTime;
 
-    mNALUnits.push_back(buffer);
+    NALPiece piece;
+    piece.mBuffer = buffer;
+    piece.mOffset = offset;
+    piece.mSize = size;
+    piece.mContinuesNALUnit = false;
+    mNALPieces.push_back(piece);
 }
 
 bool AAVCAssembler::addSingleTimeAggregationPacket(const sp<ABuffer> &buffer) {
@@ -159,12 +165,7 @@ bool AAVCAssembler::addSingleTimeAggregationPacket(const sp<ABuffer> &buffer) {
             return false;
         }
 
-        sp<ABuffer> unit = new ABuffer(nalSize);
-        memcpy(unit->data(), &data[2], nalSize);
-
-        CopyTimes(unit, buffer);
-
-        addSingleNALUnit(unit);
+        addSingleNALUnit(buffer, &data[2] - buffer->data(), nalSize);
 
         data += 2 + nalSize;
         size -= 2 + nalSize;
@@ -280,18 +281,14 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
 
     // We found all the fragments that make up the complete NAL unit.
 
-    // Leave room for the header. So far totalSize did not include the
-    // header byte.
-    ++totalSize;
-
-    sp<ABuffer> unit = new ABuffer(totalSize);
-    CopyTimes(unit, *queue->begin());
-
-    unit->data()[0] = (nri << 5) | nalType;
-
-    size_t offset = 1;
+    // The NAL unit header replaces the FU header of the first fragment,
+    // the payloads of the other fragments follow it in the access unit.
     List<sp<ABuffer> >::iterator it = queue->begin();
-    for (size_t i = 0; i < totalCount; ++i) {
+    (*it)->data()[1] = (nri << 5) | nalType;
+    addSingleNALUnit(*it, 1, (*it)->size() - 1);
+    it = queue->erase(it);
+
+    for (size_t i = 1; i < totalCount; ++i) {
         const sp<ABuffer> &buffer = *it;
 
         ALOGV("piece #%zu/%zu", i + 1, totalCount);
@@ -299,45 +296,46 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
         hexdump(buffer->data(), buffer->size());
 #endif
 
-        memcpy(unit->data() + offset, buffer->data() + 2, buffer->size() - 2);
-        offset += buffer->size() - 2;
+        NALPiece piece;
+        piece.mBuffer = buffer;
+        piece.mOffset = 2;
+        piece.mSize = buffer->size() - 2;
+        piece.mContinuesNALUnit = true;
+        mNALPieces.push_back(piece);
 
         it = queue->erase(it);
     }
 
-    unit->setRange(0, totalSize);
-
-    addSingleNALUnit(unit);
-
     ALOGV("successfully assembled a NAL unit from fragments.");
 
     return OK;
 }
 
 void AAVCAssembler::submitAccessUnit() {
-    CHECK(!mNALUnits.empty());
+    CHECK(!mNALPieces.empty());
 
-    ALOGV("Access unit complete (%zu nal units)", mNALUnits.size());
+    ALOGV("Access unit complete (%zu nal unit pieces)", mNALPieces.size());
 
     size_t totalSize = 0;
-    for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
-         it != mNALUnits.end(); ++it) {
-        totalSize += 4 + (*it)->size();
+    for (List<NALPiece>::iterator it = mNALPieces.begin();
+         it != mNALPieces.end(); ++it) {
+        totalSize += (it->mContinuesNALUnit ? 0 : 4) + it->mSize;
     }
 
     sp<ABuffer> accessUnit = new ABuffer(totalSize);
     size_t offset = 0;
-    for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
-         it != mNALUnits.end(); ++it) {
-        memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
-        offset += 4;
-
-        sp<ABuffer> nal = *it;
-        memcpy(accessUnit->data() + offset, nal->data(), nal->size());
-        offset += nal->size();
+    for (List<NALPiece>::iterator it = mNALPieces.begin();
+         it != mNALPieces.end(); ++it) {
+        if (!it->mContinuesNALUnit) {
+            memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
+            offset += 4;
+        }
+
+        memcpy(accessUnit->data() + offset, it->mBuffer->data() + it->mOffset, it->mSize);
+        offset += it->mSize;
     }
 
-    CopyTimes(accessUnit, *mNALUnits.begin());
+    CopyTimes(accessUnit, mNALPieces.begin()->mBuffer);
 
 #if 0
     printf(mAccessUnitDamaged ? "X" : ".");
@@ -348,7 +346,7 @@ void AAVCAssembler::submitAccessUnit() {
         accessUnit->meta()->setInt32("damaged", true);
     }
 
-    mNALUnits.clear();
+    mNALPieces.clear();
     mAccessUnitDamaged = false;
 
     sp<AMessage> msg = mNotifyMsg->dup();
@@ -45,10 +45,19 @@ private:
     bool mNextExpectedSeqNoValid;
     uint32_t mNextExpectedSeqNo;
     bool mAccessUnitDamaged;
-    List<sp<ABuffer> > mNALUnits;
+
+    // A part of a NAL unit of the access unit, left in the packet it arrived in.
+    // The pieces are copied only once, when the access unit is complete.
+    struct NALPiece {
+        sp<ABuffer> mBuffer;
+        size_t mOffset;
+        size_t mSize;
+        bool mContinuesNALUnit;  // a fragment after the first, without a start code
+    };
+    List<NALPiece> mNALPieces;
 
     AssemblyStatus addNALUnit(const sp<ARTPSource> &source);
-    void addSingleNALUnit(const sp<ABuffer> &buffer);
+    void addSingleNALUnit(const sp<ABuffer> &buffer, size_t offset, size_t size);
     AssemblyStatus addFragmentedNALUnit(List<sp<ABuffer> > *queue);
     bool addSingleTimeAggregationPacket(const sp<ABuffer> &buffer);
 
@@ -362,9 +362,9 @@ static status_t parseStreamMuxConfig(
 sp<ABuffer> AMPEG4AudioAssembler::removeLATMFraming(const sp<ABuffer> &buffer) {
     CHECK(!mMuxConfigPresent);  // XXX to be implemented
 
-    sp<ABuffer> out = new ABuffer(buffer->size());
-    out->setRange(0, 0);
-
+    // The payloads are moved to the front of the buffer, they never start
+    // before the position they are moved to.
+    size_t outSize = 0;
     size_t offset = 0;
     uint8_t *ptr = buffer->data();
 
@@ -381,7 +381,8 @@ sp<ABuffer> AMPEG4AudioAssembler::removeLATMFraming(const sp<ABuffer> &buffer) {
                 do {
                     if (offset >= buffer->size()) {
                         ALOGW("Malformed buffer received");
-                        return out;
+                        buffer->setRange(buffer->offset(), outSize);
+                        return buffer;
                     }
                     tmp = ptr[offset++];
                     muxSlotLengthBytes += tmp;
@@ -411,8 +412,8 @@ sp<ABuffer> AMPEG4AudioAssembler::removeLATMFraming(const sp<ABuffer> &buffer) {
         CHECK_LT(offset, buffer->size());
         CHECK_LE(payloadLength, buffer->size() - offset);
 
-        memcpy(out->data() + out->size(), &ptr[offset], payloadLength);
-        out->setRange(0, out->size() + payloadLength);
+        memmove(&ptr[outSize], &ptr[offset], payloadLength);
+        outSize += payloadLength;
 
         offset += payloadLength;
 
@@ -435,7 +436,8 @@ sp<ABuffer> AMPEG4AudioAssembler::removeLATMFraming(const sp<ABuffer> &buffer) {
     }
     CHECK_LE(offset, buffer->size());
 
-    return out;
+    buffer->setRange(buffer->offset(), outSize);
+    return buffer;
 }
 
 AMPEG4AudioAssembler::AMPEG4AudioAssembler(
@@ -37,6 +37,11 @@ namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 
+// Datagrams are received in batches of up to kMaxReceiveBatch, each into its own
+// kMaxDatagramSize slot of the receive buffer, and then copied out at their size.
+static const size_t kMaxReceiveBatch = 8;
+static const size_t kMaxDatagramSize = 65536;
+
 static uint16_t u16at(const uint8_t *data) {
     return data[0] << 8 | data[1];
 }
@@ -375,36 +380,67 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
+    if (mReceiveBuffer == NULL) {
+        mReceiveBuffer = new ABuffer(kMaxReceiveBatch * kMaxDatagramSize);
+    }
 
     socklen_t remoteAddrLen =
         (!receiveRTP && s->mNumRTCPPacketsReceived == 0)
             ? sizeof(s->mRemoteRTCPAddr) : 0;
 
-    ssize_t nbytes;
+    // RTCP packets are few, only drain the RTP socket in batches.
+    size_t batchSize = receiveRTP ? kMaxReceiveBatch : 1;
+
+    struct mmsghdr msgs[kMaxReceiveBatch];
+    struct iovec iovs[kMaxReceiveBatch];
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < batchSize; ++i) {
+        iovs[i].iov_base = mReceiveBuffer->data() + i * kMaxDatagramSize;
+        iovs[i].iov_len = kMaxDatagramSize;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    if (remoteAddrLen > 0) {
+        msgs[0].msg_hdr.msg_name = &s->mRemoteRTCPAddr;
+        msgs[0].msg_hdr.msg_namelen = remoteAddrLen;
+    }
+
+    // The socket is readable, MSG_WAITFORONE only takes the datagrams
+    // that are queued after the first one.
+    int count;
     do {
-        nbytes = recvfrom(
+        count = recvmmsg(
             receiveRTP ? s->mRTPSocket : s->mRTCPSocket,
-            buffer->data(),
-            buffer->capacity(),
-            0,
-            remoteAddrLen > 0 ? (struct sockaddr *)&s->mRemoteRTCPAddr : NULL,
-            remoteAddrLen > 0 ? &remoteAddrLen : NULL);
-    } while (nbytes < 0 && errno == EINTR);
-
-    if (nbytes <= 0) {
+            msgs, batchSize, MSG_WAITFORONE, NULL);
+    } while (count < 0 && errno == EINTR);
+
+    if (count <= 0) {
         return -ECONNRESET;
     }
 
-    buffer->setRange(0, nbytes);
+    status_t err = OK;
+    for (int i = 0; i < count; ++i) {
+        size_t nbytes = msgs[i].msg_len;
+        if (nbytes == 0) {
+            return -ECONNRESET;
+        }
 
-    // ALOGI("received %d bytes.", buffer->size());
+        // ALOGI("received %zu bytes.", nbytes);
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+        // The packets are queued until their access unit is complete,
+        // so each gets a buffer of its own size.
+        sp<ABuffer> buffer = new ABuffer(nbytes);
+        memcpy(buffer->data(), iovs[i].iov_base, nbytes);
+
+        status_t packetErr;
+        if (receiveRTP) {
+            packetErr = parseRTP(s, buffer);
+        } else {
+            packetErr = parseRTCP(s, buffer);
+        }
+        if (err == OK) {
+            err = packetErr;
+        }
     }
 
     return err;
@@ -72,6 +72,9 @@ private:
     bool mPollEventPending;
     int64_t mLastReceiverReportTimeUs;
 
+    // Reused by receive() for every batch of datagrams.
+    sp<ABuffer> mReceiveBuffer;
+
     void onAddStream(const sp<AMessage> &msg);
     void onRemoveStream(const sp<AMessage> &msg);
     void onPollStreams();
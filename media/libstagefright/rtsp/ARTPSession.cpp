@@ -135,6 +135,11 @@ void ARTPSession::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
+            int32_t jitterUpdate;
+            if (msg->findInt32("jitter-update", &jitterUpdate)) {
+                break;
+            }
+
             size_t trackIndex;
             CHECK(msg->findSize("track-index", &trackIndex));
 
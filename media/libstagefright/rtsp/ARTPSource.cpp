@@ -37,6 +37,13 @@ namespace android {
 
 static const uint32_t kSourceID = 0xdeadbeef;
 
+// The jitter is reported to the handler at most this often.
+static const int64_t kJitterNotifyIntervalUs = 1000000LL;
+
+// Bounds of the time to wait for a packet that is missing from the sequence.
+static const int64_t kMinReorderWaitUs = 10000LL;
+static const int64_t kMaxReorderWaitUs = 100000LL;
+
 ARTPSource::ARTPSource(
         uint32_t id,
         const sp<ASessionDescription> &sessionDesc, size_t index,
@@ -52,12 +59,21 @@ ARTPSource::ARTPSource(
       mIssueFIRRequests(false),
       mLastFIRRequestUs(-1),
       mNextFIRSeqNo((rand() * 256.0) / RAND_MAX),
+      mClockRate(0),
+      mJitterValid(false),
+      mPrevRTPTime(0),
+      mPrevTransit(0),
+      mJitter(0),
+      mLastJitterNotifyUs(-1),
       mNotify(notify) {
     unsigned long PT;
     AString desc;
     AString params;
     sessionDesc->getFormatType(index, &PT, &desc, &params);
 
+    int32_t numChannels;
+    ASessionDescription::ParseFormatDesc(desc.c_str(), &mClockRate, &numChannels);
+
     if (!strncmp(desc.c_str(), "H264/", 5)) {
         mAssembler = new AAVCAssembler(notify);
         mIssueFIRRequests = true;
@@ -93,11 +109,65 @@ static uint32_t AbsDiff(uint32_t seq1, uint32_t seq2) {
 }
 
 void ARTPSource::processRTPPacket(const sp<ABuffer> &buffer) {
+    uint32_t rtpTime;
+    if (buffer->meta()->findInt32("rtp-time", (int32_t *)&rtpTime)) {
+        updateJitter(rtpTime, ALooper::GetNowUs());
+    }
+
     if (mAssembler != NULL && queuePacket(buffer)) {
         mAssembler->onPacketReceived(this);
     }
 }
 
+void ARTPSource::updateJitter(uint32_t rtpTime, int64_t arrivalUs) {
+    if (mClockRate <= 0) {
+        return;
+    }
+
+    // The packets of a frame share its timestamp but were not sent at the same
+    // time, only the first one of each frame is measured.
+    if (mJitterValid && rtpTime == mPrevRTPTime) {
+        return;
+    }
+
+    // According to appendix A.8 in RFC 3550, the transit times use the
+    // timestamp units and wrap around the same way.
+    uint32_t arrival = (uint32_t)(arrivalUs * mClockRate / 1000000LL);
+    int32_t transit = (int32_t)(arrival - rtpTime);
+    if (mJitterValid) {
+        int64_t d = (int64_t)transit - mPrevTransit;
+        mJitter += ((d < 0 ? -d : d) - mJitter) / 16.;
+    }
+    mJitterValid = true;
+    mPrevRTPTime = rtpTime;
+    mPrevTransit = transit;
+
+    if (mLastJitterNotifyUs < 0
+            || arrivalUs - mLastJitterNotifyUs >= kJitterNotifyIntervalUs) {
+        mLastJitterNotifyUs = arrivalUs;
+
+        sp<AMessage> notify = mNotify->dup();
+        notify->setInt32("jitter-update", true);
+        notify->setInt64("jitter-us", getJitterUs());
+        notify->post();
+    }
+}
+
+int64_t ARTPSource::getJitterUs() const {
+    if (mClockRate <= 0) {
+        return 0;
+    }
+    return (int64_t)(mJitter * 1E6 / mClockRate);
+}
+
+int64_t ARTPSource::getReorderWaitUs() const {
+    int64_t waitUs = 2 * getJitterUs();
+    if (waitUs < kMinReorderWaitUs) {
+        return kMinReorderWaitUs;
+    }
+    return waitUs > kMaxReorderWaitUs ? kMaxReorderWaitUs : waitUs;
+}
+
 void ARTPSource::timeUpdate(uint32_t rtpTime, uint64_t ntpTime) {
     mLastNTPTime = ntpTime;
     mLastNTPTimeUpdateUs = ALooper::GetNowUs();
@@ -279,10 +349,11 @@ void ARTPSource::addReceiverReport(const sp<ABuffer> &buffer) {
     data[18] = (mHighestSeqNumber >> 8) & 0xff;
     data[19] = mHighestSeqNumber & 0xff;
 
-    data[20] = 0x00;  // Interarrival jitter
-    data[21] = 0x00;
-    data[22] = 0x00;
-    data[23] = 0x00;
+    uint32_t jitter = (uint32_t)mJitter;
+    data[20] = jitter >> 24;  // Interarrival jitter
+    data[21] = (jitter >> 16) & 0xff;
+    data[22] = (jitter >> 8) & 0xff;
+    data[23] = jitter & 0xff;
 
     uint32_t LSR = 0;
     uint32_t DLSR = 0;
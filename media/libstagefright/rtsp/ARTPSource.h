@@ -46,6 +46,12 @@ struct ARTPSource : public RefBase {
     void addReceiverReport(const sp<ABuffer> &buffer);
     void addFIR(const sp<ABuffer> &buffer);
 
+    // Interarrival jitter of RFC 3550, in microseconds.
+    int64_t getJitterUs() const;
+
+    // How long the assembler waits for a missing packet before it is given up.
+    int64_t getReorderWaitUs() const;
+
 private:
     uint32_t mID;
     uint32_t mHighestSeqNumber;
@@ -64,9 +70,17 @@ private:
     int64_t mLastFIRRequestUs;
     uint8_t mNextFIRSeqNo;
 
+    int32_t mClockRate;
+    bool mJitterValid;
+    uint32_t mPrevRTPTime;
+    int32_t mPrevTransit;
+    double mJitter;  // in RTP timestamp units
+    int64_t mLastJitterNotifyUs;
+
     sp<AMessage> mNotify;
 
     bool queuePacket(const sp<ABuffer> &buffer);
+    void updateJitter(uint32_t rtpTime, int64_t arrivalUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(ARTPSource);
 };
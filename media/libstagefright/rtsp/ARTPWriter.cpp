@@ -20,12 +20,15 @@
 
 #include "ARTPWriter.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/hexdump.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaDefs.h>
@@ -40,6 +43,19 @@ namespace android {
 // static const size_t kMaxPacketSize = 65507;  // maximum payload in UDP over IP
 static const size_t kMaxPacketSize = 1500;
 
+// Number of RTP packets handed to the kernel by a single sendmmsg().
+static const size_t kMaxSendBatch = 32;
+
+// The packets of a frame are paced at kPacingFactor times the average rate
+// sent so far, but no slower than kMinPacingRate, so that a key frame does not
+// go out as a single burst that overflows the queues of the network and of
+// the receiver. The pacer bursts up to kPacingBurstBytes, and never delays a
+// frame by more than kMaxPacingDelayUs.
+static const double kPacingFactor = 2.0;
+static const int64_t kMinPacingRate = 1250000;  // bytes per second
+static const int64_t kPacingBurstBytes = 16 * kMaxPacketSize;
+static const int64_t kMaxPacingDelayUs = 20000;
+
 static int UniformRand(int limit) {
     return ((double)rand() * limit) / RAND_MAX;
 }
@@ -48,6 +64,11 @@ ARTPWriter::ARTPWriter(int fd)
     : mFlags(0),
       mFd(dup(fd)),
       mLooper(new ALooper),
+      mNumQueuedPackets(0),
+      mPacingTokens(0),
+      mPacingStartUs(-1),
+      mLastPacingUs(-1),
+      mNumPacedOctets(0),
       mReflector(new AHandlerReflector<ARTPWriter>(this)) {
     CHECK_GE(fd, 0);
 
@@ -129,6 +150,8 @@ status_t ARTPWriter::start(MetaData * /* params */) {
     mLastRTPTime = 0;
     mLastNTPTime = 0;
     mNumSRsSent = 0;
+    mPacingStartUs = -1;
+    mNumPacedOctets = 0;
 
     const char *mime;
     CHECK(mSource->getFormat()->findCString(kKeyMIMEType, &mime));
@@ -316,6 +339,109 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
 
     CHECK_EQ(n, (ssize_t)buffer->size());
 
+    logPacket(buffer, isRTCP);
+}
+
+sp<ABuffer> ARTPWriter::queueRTPPacket() {
+    if (mNumQueuedPackets == mPacketPool.size()) {
+        mPacketPool.push(new ABuffer(kMaxPacketSize));
+    }
+
+    sp<ABuffer> buffer = mPacketPool[mNumQueuedPackets++];
+    buffer->setRange(0, buffer->capacity());
+    return buffer;
+}
+
+void ARTPWriter::flushRTP() {
+    int64_t deadlineUs = ALooper::GetNowUs() + kMaxPacingDelayUs;
+
+    struct mmsghdr msgs[kMaxSendBatch];
+    struct iovec iovs[kMaxSendBatch];
+
+    size_t index = 0;
+    while (index < mNumQueuedPackets) {
+        size_t count = 0;
+        size_t size = 0;
+        while (count < kMaxSendBatch && index + count < mNumQueuedPackets) {
+            const sp<ABuffer> &buffer = mPacketPool[index + count];
+
+            iovs[count].iov_base = buffer->data();
+            iovs[count].iov_len = buffer->size();
+
+            memset(&msgs[count], 0, sizeof(msgs[count]));
+            msgs[count].msg_hdr.msg_name = &mRTPAddr;
+            msgs[count].msg_hdr.msg_namelen = sizeof(mRTPAddr);
+            msgs[count].msg_hdr.msg_iov = &iovs[count];
+            msgs[count].msg_hdr.msg_iovlen = 1;
+
+            size += buffer->size();
+            ++count;
+        }
+
+        pace(size, deadlineUs);
+
+        size_t sent = 0;
+        while (sent < count) {
+            int n = sendmmsg(mSocket, &msgs[sent], count - sent, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            CHECK_GT(n, 0);
+
+            for (int i = 0; i < n; ++i) {
+                CHECK_EQ((size_t)msgs[sent + i].msg_len, iovs[sent + i].iov_len);
+            }
+            sent += n;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            logPacket(mPacketPool[index + i], false /* isRTCP */);
+        }
+
+        index += count;
+    }
+
+    mNumQueuedPackets = 0;
+}
+
+void ARTPWriter::pace(size_t size, int64_t deadlineUs) {
+    int64_t nowUs = ALooper::GetNowUs();
+    if (mPacingStartUs < 0) {
+        mPacingStartUs = nowUs;
+        mLastPacingUs = nowUs;
+        mPacingTokens = kPacingBurstBytes;
+    }
+
+    int64_t rate = kMinPacingRate;
+    int64_t elapsedUs = nowUs - mPacingStartUs;
+    if (elapsedUs >= 1000000ll) {
+        int64_t averageRate =
+            (int64_t)(mNumPacedOctets * kPacingFactor * 1E6 / elapsedUs);
+        rate = max(rate, averageRate);
+    }
+
+    mPacingTokens = min(kPacingBurstBytes,
+            mPacingTokens + (nowUs - mLastPacingUs) * rate / 1000000ll);
+    mLastPacingUs = nowUs;
+
+    if (mPacingTokens < (int64_t)size && nowUs < deadlineUs) {
+        int64_t delayUs = ((int64_t)size - mPacingTokens) * 1000000ll / rate;
+        delayUs = min(delayUs, deadlineUs - nowUs);
+        usleep((useconds_t)delayUs);
+
+        nowUs = ALooper::GetNowUs();
+        mPacingTokens = min(kPacingBurstBytes,
+                mPacingTokens + (nowUs - mLastPacingUs) * rate / 1000000ll);
+        mLastPacingUs = nowUs;
+    }
+
+    // Past the deadline the tokens go negative, which delays the next frame.
+    mPacingTokens -= size;
+    mNumPacedOctets += size;
+}
+
+void ARTPWriter::logPacket(
+        const sp<ABuffer> &buffer __unused, bool isRTCP __unused) {
 #if LOG_TO_FILES
     int fd = isRTCP ? mRTCPFd : mRTPFd;
 
@@ -581,9 +707,9 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
     const uint8_t *mediaData =
         (const uint8_t *)mediaBuf->data() + mediaBuf->range_offset();
 
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
-    if (mediaBuf->range_length() + 12 <= buffer->capacity()) {
+    if (mediaBuf->range_length() + 12 <= kMaxPacketSize) {
         // The data fits into a single packet
+        sp<ABuffer> buffer = queueRTPPacket();
         uint8_t *data = buffer->data();
         data[0] = 0x80;
         data[1] = (1 << 7) | PT;  // M-bit
@@ -603,8 +729,6 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, mediaBuf->range_length() + 12);
 
-        send(buffer, false /* isRTCP */);
-
         ++mSeqNo;
         ++mNumRTPSent;
         mNumRTPOctetsSent += buffer->size() - 12;
@@ -616,6 +740,8 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         bool firstPacket = true;
         while (offset < mediaBuf->range_length()) {
+            sp<ABuffer> buffer = queueRTPPacket();
+
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + 12 + 2 > buffer->capacity()) {
@@ -650,8 +776,6 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 14 + size);
 
-            send(buffer, false /* isRTCP */);
-
             ++mSeqNo;
             ++mNumRTPSent;
             mNumRTPOctetsSent += buffer->size() - 12;
@@ -661,6 +785,8 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
         }
     }
 
+    flushRTP();
+
     mLastRTPTime = rtpTime;
     mLastNTPTime = GetNowNTP();
 }
@@ -685,7 +811,7 @@ void ARTPWriter::sendH263Data(MediaBufferBase *mediaBuf) {
     size_t size = mediaBuf->range_length();
 
     while (offset < size) {
-        sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+        sp<ABuffer> buffer = queueRTPPacket();
         // CHECK_LE(mediaBuf->range_length() -2 + 14, buffer->capacity());
 
         size_t remaining = size - offset;
@@ -716,13 +842,13 @@ void ARTPWriter::sendH263Data(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, remaining + 14);
 
-        send(buffer, false /* isRTCP */);
-
         ++mSeqNo;
         ++mNumRTPSent;
         mNumRTPOctetsSent += buffer->size() - 12;
     }
 
+    flushRTP();
+
     mLastRTPTime = rtpTime;
     mLastNTPTime = GetNowNTP();
 }
@@ -772,7 +898,7 @@ void ARTPWriter::sendAMRData(MediaBufferBase *mediaBuf) {
     }
     CHECK_EQ(srcOffset, mediaLength);
 
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    sp<ABuffer> buffer = queueRTPPacket();
     CHECK_LE(mediaLength + 12 + 1, buffer->capacity());
 
     // The data fits into a single packet
@@ -824,12 +950,12 @@ void ARTPWriter::sendAMRData(MediaBufferBase *mediaBuf) {
 
     buffer->setRange(0, dstOffset);
 
-    send(buffer, false /* isRTCP */);
-
     ++mSeqNo;
     ++mNumRTPSent;
     mNumRTPOctetsSent += buffer->size() - 12;
 
+    flushRTP();
+
     mLastRTPTime = rtpTime;
     mLastNTPTime = GetNowNTP();
 }
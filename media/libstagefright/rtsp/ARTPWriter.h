@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/base64.h>
 #include <media/stagefright/MediaWriter.h>
+#include <utils/Vector.h>
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -94,6 +95,17 @@ private:
 
     int32_t mNumSRsSent;
 
+    // The RTP packets of the frame being sent, taken from a pool that is
+    // reused from frame to frame and sent in batches by flushRTP().
+    Vector<sp<ABuffer> > mPacketPool;
+    size_t mNumQueuedPackets;
+
+    // Token bucket, in bytes, that paces the packets of large frames.
+    int64_t mPacingTokens;
+    int64_t mPacingStartUs;
+    int64_t mLastPacingUs;
+    uint64_t mNumPacedOctets;
+
     enum {
         INVALID,
         H264,
@@ -120,6 +132,11 @@ private:
 
     void send(const sp<ABuffer> &buffer, bool isRTCP);
 
+    sp<ABuffer> queueRTPPacket();
+    void flushRTP();
+    void pace(size_t size, int64_t deadlineUs);
+    void logPacket(const sp<ABuffer> &buffer, bool isRTCP);
+
     DISALLOW_EVIL_CONSTRUCTORS(ARTPWriter);
 };
 
@@ -119,6 +119,7 @@ struct MyHandler : public AHandler {
         kWhatEOS                        = 'eos!',
         kWhatSeekDiscontinuity          = 'seeD',
         kWhatNormalPlayTimeMapping      = 'nptM',
+        kWhatJitterUpdate               = 'jitU',
     };
 
     MyHandler(
@@ -1032,6 +1033,18 @@ struct MyHandler : public AHandler {
                     break;
                 }
 
+                int32_t jitterUpdate;
+                if (msg->findInt32("jitter-update", &jitterUpdate)) {
+                    size_t trackIndex;
+                    CHECK(msg->findSize("track-index", &trackIndex));
+
+                    int64_t jitterUs;
+                    CHECK(msg->findInt64("jitter-us", &jitterUs));
+
+                    postJitterUpdate(trackIndex, jitterUs);
+                    break;
+                }
+
                 ++mNumAccessUnitsReceived;
                 postAccessUnitTimeoutCheck();
 
@@ -1964,6 +1977,14 @@ private:
         msg->post();
     }
 
+    void postJitterUpdate(size_t trackIndex, int64_t jitterUs) {
+        sp<AMessage> msg = mNotify->dup();
+        msg->setInt32("what", kWhatJitterUpdate);
+        msg->setSize("trackIndex", trackIndex);
+        msg->setInt64("jitterUs", jitterUs);
+        msg->post();
+    }
+
     void postNormalPlayTimeMapping(
             size_t trackIndex, uint32_t rtpTime, int64_t nptUs) {
         sp<AMessage> msg = mNotify->dup();
@@ -22,6 +22,7 @@
 #include <iostream>
 
 #include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/foundation/ByteUtils.h>
 #include <media/stagefright/MetaData.h>
 #include <media/stagefright/Utils.h>
 
@@ -321,6 +322,72 @@ TEST_P(WriterTest, WriterTest) {
     close(fd);
 }
 
+TEST_P(WriterTest, FragmentedWriterTest) {
+    if (mDisableTest) return;
+    string writerFormat = GetParam().first;
+    if (writerFormat.compare("mpeg4")) return;
+    ALOGV("Checks that a fragmented MPEG4 file has a moov box followed by fragments");
+
+    string outputFile = OUTPUT_FILE_NAME;
+    int32_t fd =
+            open(outputFile.c_str(), O_CREAT | O_LARGEFILE | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0) << "Failed to open output file to dump writer's data";
+
+    int32_t status = createWriter(fd);
+    ASSERT_EQ((status_t)OK, status) << "Failed to create writer for output format:" << writerFormat;
+    mFileMeta->setInt64(kKeyFragmentDurationUs, 500000);
+
+    string inputFile = gEnv->getRes();
+    string inputInfo = gEnv->getRes();
+    configFormat param;
+    bool isAudio;
+    int32_t inputFileIdx = GetParam().second;
+    getFileDetails(inputFile, inputInfo, param, isAudio, inputFileIdx);
+    ASSERT_NE(inputFile.compare(gEnv->getRes()), 0) << "No input file specified";
+
+    ASSERT_NO_FATAL_FAILURE(getInputBufferInfo(inputFile, inputInfo));
+    status = addWriterSource(isAudio, param);
+    ASSERT_EQ((status_t)OK, status) << "Failed to add source for " << writerFormat << "Writer";
+
+    status = mWriter->start(mFileMeta.get());
+    ASSERT_EQ((status_t)OK, status);
+    status = sendBuffersToWriter(mInputStream, mBufferInfo, mInputFrameId, mCurrentTrack, 0,
+                                 mBufferInfo.size());
+    ASSERT_EQ((status_t)OK, status) << writerFormat << " writer failed";
+    mCurrentTrack->stop();
+
+    status = mWriter->stop();
+    ASSERT_EQ((status_t)OK, status) << "Failed to stop the writer";
+    close(fd);
+
+    // Walk the top level boxes.
+    ifstream output(outputFile, ios::binary);
+    ASSERT_TRUE(output.is_open()) << "Failed to open " << outputFile;
+    vector<string> boxTypes;
+    uint8_t header[8];
+    while (output.read((char *)header, sizeof(header))) {
+        uint64_t size = U32_AT(header);
+        boxTypes.push_back(string((char *)&header[4], 4));
+        if (size == 1) {
+            uint8_t largeSize[8];
+            ASSERT_TRUE(output.read((char *)largeSize, sizeof(largeSize)));
+            size = U64_AT(largeSize);
+            output.seekg(size - 16, ios::cur);
+        } else {
+            ASSERT_GE(size, 8u);
+            output.seekg(size - 8, ios::cur);
+        }
+    }
+    ASSERT_GE(boxTypes.size(), 4u);
+    EXPECT_EQ(boxTypes[0], "ftyp");
+    EXPECT_EQ(boxTypes[1], "moov");
+    for (size_t i = 2; i < boxTypes.size(); i += 2) {
+        EXPECT_EQ(boxTypes[i], "moof");
+        ASSERT_LT(i + 1, boxTypes.size());
+        EXPECT_EQ(boxTypes[i + 1], "mdat");
+    }
+}
+
 TEST_P(WriterTest, PauseWriterTest) {
     if (mDisableTest) return;
     ALOGV("Validates the pause() api of writers");
@@ -68,6 +68,18 @@ public:
         return front(true);
     }
 
+    // Moves all the elements to the end of list, waiting until there is at least one.
+    void takeAll(List<T>& list) {
+        Mutex::Autolock autolock(mLock);
+        while (mList.empty()) {
+            mContentAvailableCondition.wait(mLock);
+        }
+        for (typename List<T>::iterator it = mList.begin(); it != mList.end(); ++it) {
+            list.push_back(*it);
+        }
+        mList.clear();
+    }
+
     void push(T e) {
         Mutex::Autolock autolock(mLock);
         mList.push_back(e);
@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "WebmFrameThread"
 
+#include "EbmlUtil.h"
 #include "WebmConstants.h"
 #include "WebmFrameThread.h"
 
@@ -24,7 +25,9 @@
 #include <media/stagefright/foundation/ADebug.h>
 
 #include <utils/Log.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <sys/uio.h>
 
 using namespace webm;
 
@@ -97,41 +100,73 @@ WebmFrameSinkThread::WebmFrameSinkThread(
       mDone(true) {
 }
 
-// Initializes a webm cluster with its starting timecode.
+// Writes out a webm cluster of frames with a single ::writev().
 //
-// frames:
-//   sequence of input audio/video frames received from the source.
+// The cluster, timecode and simple block headers are serialized into mClusterHeaders,
+// which is reused from one cluster to the next, and the frame data is written from the
+// frame buffers in place.
 //
 // clusterTimecodeL:
 //   the starting timecode of the cluster; this is the timecode of the first
 //   frame since frames are ordered by timestamp.
 //
-// children:
-//   list to hold child elements in a webm cluster (start timecode and
-//   simple blocks).
-//
-// static
-void WebmFrameSinkThread::initCluster(
-    List<const sp<WebmFrame> >& frames,
-    uint64_t& clusterTimecodeL,
-    List<sp<WebmElement> >& children) {
-    CHECK(!frames.empty() && children.empty());
-
-    const sp<WebmFrame> f = *(frames.begin());
-    clusterTimecodeL = f->mAbsTimecode;
-    WebmUnsigned *clusterTimecode = new WebmUnsigned(kMkvTimecode, clusterTimecodeL);
-    children.clear();
-    children.push_back(clusterTimecode);
-}
+// frames:
+//   the frames of the cluster, which is cleared once it has been written.
+void WebmFrameSinkThread::writeCluster(
+        uint64_t clusterTimecodeL, List<const sp<WebmFrame> >& frames) {
+    // a cluster must contain at least one simpleblock
+    CHECK(!frames.empty());
+
+    WebmUnsigned clusterTimecode(kMkvTimecode, clusterTimecodeL);
+    uint64_t size = clusterTimecode.totalSize();
+    for (List<const sp<WebmFrame> >::iterator it = frames.begin(); it != frames.end(); ++it) {
+        // ........ trackNum*1 + timecode*2 + flags*1
+        uint64_t blockSize = (*it)->mData->size() + 4;
+        size += sizeOf(kMkvSimpleBlock) + sizeOf(encodeUnsigned(blockSize)) + blockSize;
+    }
 
-void WebmFrameSinkThread::writeCluster(List<sp<WebmElement> >& children) {
-    // children must contain at least one simpleblock and its timecode
-    CHECK_GE(children.size(), 2u);
+    // ids and sizes are at most 8 bytes each
+    mClusterHeaders.resize(2 * 8 + clusterTimecode.totalSize() + frames.size() * (2 * 8 + 4));
+    mClusterIovecs.clear();
+    uint8_t *cur = mClusterHeaders.data();
+    uint8_t *headerStart = cur;
+    cur += serializeCodedUnsigned(kMkvCluster, cur);
+    cur += serializeCodedUnsigned(encodeUnsigned(size), cur);
+    cur += clusterTimecode.serializeInto(cur);
+    for (List<const sp<WebmFrame> >::iterator it = frames.begin(); it != frames.end(); ++it) {
+        const sp<WebmFrame> &f = *it;
+        int16_t relTimecode = f->mAbsTimecode - clusterTimecodeL;
+        cur += serializeCodedUnsigned(kMkvSimpleBlock, cur);
+        cur += serializeCodedUnsigned(encodeUnsigned(f->mData->size() + 4), cur);
+        cur += serializeCodedUnsigned(
+                encodeUnsigned(f->mType == kVideoType ? kVideoTrackNum : kAudioTrackNum), cur);
+        *cur++ = (relTimecode & 0xff00) >> 8;
+        *cur++ = relTimecode & 0xff;
+        *cur++ = f->mKey ? 0x80 : 0;
+        mClusterIovecs.push_back({headerStart, (size_t)(cur - headerStart)});
+        if (f->mData->size() > 0) {
+            mClusterIovecs.push_back({f->mData->data(), f->mData->size()});
+        }
+        headerStart = cur;
+    }
 
-    uint64_t size;
-    sp<WebmElement> cluster = new WebmMaster(kMkvCluster, children);
-    cluster->write(mFd, size);
-    children.clear();
+    for (size_t i = 0; i < mClusterIovecs.size(); i += kMaxClusterIovecs) {
+        size_t count = mClusterIovecs.size() - i;
+        if (count > kMaxClusterIovecs) {
+            count = kMaxClusterIovecs;
+        }
+        size_t bytesToWrite = 0;
+        for (size_t j = 0; j < count; j++) {
+            bytesToWrite += mClusterIovecs[i + j].iov_len;
+        }
+        ssize_t bytesWritten = ::writev(mFd, &mClusterIovecs[i], count);
+        if (bytesWritten != (ssize_t)bytesToWrite) {
+            ALOGE("writeCluster wrote %zd of %zu bytes; errno = %d",
+                    bytesWritten, bytesToWrite, errno);
+            break;
+        }
+    }
+    frames.clear();
 }
 
 // Write out (possibly multiple) webm cluster(s) from frames split on video key frames.
@@ -143,9 +178,8 @@ void WebmFrameSinkThread::flushFrames(List<const sp<WebmFrame> >& frames, bool l
         return;
     }
 
-    uint64_t clusterTimecodeL;
-    List<sp<WebmElement> > children;
-    initCluster(frames, clusterTimecodeL, children);
+    uint64_t clusterTimecodeL = (*frames.begin())->mAbsTimecode;
+    List<const sp<WebmFrame> > clusterFrames;
 
     uint64_t cueTime = clusterTimecodeL;
     off_t fpos = ::lseek(mFd, 0, SEEK_CUR);
@@ -168,12 +202,12 @@ void WebmFrameSinkThread::flushFrames(List<const sp<WebmFrame> >& frames, bool l
         }
 
         if (f->mAbsTimecode - clusterTimecodeL > INT16_MAX) {
-            writeCluster(children);
-            initCluster(frames, clusterTimecodeL, children);
+            writeCluster(clusterTimecodeL, clusterFrames);
+            clusterTimecodeL = f->mAbsTimecode;
         }
 
         frames.erase(frames.begin());
-        children.push_back(f->SimpleBlock(clusterTimecodeL));
+        clusterFrames.push_back(f);
     }
 
     // equivalent to last==false
@@ -182,15 +216,27 @@ void WebmFrameSinkThread::flushFrames(List<const sp<WebmFrame> >& frames, bool l
         const sp<WebmFrame> secondLastFrame = *(frames.begin());
         if (secondLastFrame->mType == kVideoType) {
             frames.erase(frames.begin());
-            children.push_back(secondLastFrame->SimpleBlock(clusterTimecodeL));
+            clusterFrames.push_back(secondLastFrame);
         }
     }
 
-    writeCluster(children);
+    writeCluster(clusterTimecodeL, clusterFrames);
     sp<WebmElement> cuePoint = WebmElement::CuePointEntry(cueTime, 1, fpos - mSegmentDataStart);
     mCues.push_back(cuePoint);
 }
 
+// Returns the next frame of a source, without removing it. The frames that the source
+// has queued are taken at once, so that its queue is locked once for all of them.
+// static
+const sp<WebmFrame> WebmFrameSinkThread::nextFrame(
+        LinkedBlockingQueue<const sp<WebmFrame> >& source,
+        List<const sp<WebmFrame> >& frames) {
+    if (frames.empty()) {
+        source.takeAll(frames);
+    }
+    return *frames.begin();
+}
+
 status_t WebmFrameSinkThread::start() {
     mDone = false;
     return WebmFrameThread::start();
@@ -206,13 +252,15 @@ status_t WebmFrameSinkThread::stop() {
 void WebmFrameSinkThread::run() {
     int numVideoKeyFrames = 0;
     List<const sp<WebmFrame> > outstandingFrames;
+    List<const sp<WebmFrame> > videoFrames;
+    List<const sp<WebmFrame> > audioFrames;
     while (!mDone) {
         ALOGV("wait v frame");
-        const sp<WebmFrame> videoFrame = mVideoFrames.peek();
+        const sp<WebmFrame> videoFrame = nextFrame(mVideoFrames, videoFrames);
         ALOGV("v frame: %p", videoFrame.get());
 
         ALOGV("wait a frame");
-        const sp<WebmFrame> audioFrame = mAudioFrames.peek();
+        const sp<WebmFrame> audioFrame = nextFrame(mAudioFrames, audioFrames);
         ALOGV("a frame: %p", audioFrame.get());
 
         if (mStartOffsetTimecode == UINT64_MAX) {
@@ -226,12 +274,12 @@ void WebmFrameSinkThread::run() {
 
         if (*audioFrame < *videoFrame) {
             ALOGV("take a frame");
-            mAudioFrames.take();
+            audioFrames.erase(audioFrames.begin());
             audioFrame->updateAbsTimecode(audioFrame->getAbsTimecode() - mStartOffsetTimecode);
             outstandingFrames.push_back(audioFrame);
         } else {
             ALOGV("take v frame");
-            mVideoFrames.take();
+            videoFrames.erase(videoFrames.begin());
             videoFrame->updateAbsTimecode(videoFrame->getAbsTimecode() - mStartOffsetTimecode);
             outstandingFrames.push_back(videoFrame);
             if (videoFrame->mKey)
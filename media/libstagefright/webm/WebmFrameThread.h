@@ -27,6 +27,9 @@
 #include <utils/Errors.h>
 
 #include <pthread.h>
+#include <sys/uio.h>
+
+#include <vector>
 
 namespace android {
 
@@ -87,11 +90,15 @@ private:
 
     volatile bool mDone;
 
-    static void initCluster(
-            List<const sp<WebmFrame> >& frames,
-            uint64_t& clusterTimecodeL,
-            List<sp<WebmElement> >& children);
-    void writeCluster(List<sp<WebmElement> >& children);
+    // Headers and iovecs of the cluster being written, reused for every cluster.
+    static const size_t kMaxClusterIovecs = 1024;  // IOV_MAX
+    std::vector<uint8_t> mClusterHeaders;
+    std::vector<struct iovec> mClusterIovecs;
+
+    static const sp<WebmFrame> nextFrame(
+            LinkedBlockingQueue<const sp<WebmFrame> >& source,
+            List<const sp<WebmFrame> >& frames);
+    void writeCluster(uint64_t clusterTimecodeL, List<const sp<WebmFrame> >& frames);
     void flushFrames(List<const sp<WebmFrame> >& frames, bool last);
 };
 
@@ -112,14 +112,18 @@ bool MtpFfsHandle::openEndpoints(bool ptp) {
 }
 
 void MtpFfsHandle::advise(int fd) {
+    // The advice values are not flags and cannot be or'ed together, and both calls return
+    // the error number rather than setting errno.
     for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
-        if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
-                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED) < 0)
-            PLOG(ERROR) << "Failed to madvise";
+        int err = posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
+                POSIX_MADV_WILLNEED);
+        if (err != 0)
+            LOG(ERROR) << "Failed to madvise: " << strerror(err);
     }
-    if (posix_fadvise(fd, 0, 0,
-                POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE | POSIX_FADV_WILLNEED) < 0)
-        PLOG(ERROR) << "Failed to fadvise";
+    // Sequential access enlarges the kernel readahead window for the file transfer.
+    int err = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (err != 0)
+        LOG(ERROR) << "Failed to fadvise: " << strerror(err);
 }
 
 bool MtpFfsHandle::writeDescriptors(bool ptp) {
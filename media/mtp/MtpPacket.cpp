@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <usbhost/usbhost.h>
 
 namespace android {
@@ -54,7 +56,9 @@ void MtpPacket::reset() {
 
 void MtpPacket::allocate(size_t length) {
     if (length > mBufferSize) {
-        int newLength = length + mAllocationIncrement;
+        // Grow geometrically so building large responses (e.g. object handle and property
+        // lists for big directories) does not realloc and copy once per increment.
+        size_t newLength = std::max(length + mAllocationIncrement, mBufferSize * 2);
         mBuffer = (uint8_t *)realloc(mBuffer, newLength);
         if (!mBuffer) {
             ALOGE("out of memory!");
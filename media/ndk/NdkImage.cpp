@@ -33,7 +33,7 @@ using namespace android;
 
 AImage::AImage(AImageReader* reader, int32_t format, uint64_t usage, BufferItem* buffer,
         int64_t timestamp, int32_t width, int32_t height, int32_t numPlanes) :
-        mReader(reader), mFormat(format), mUsage(usage), mBuffer(buffer), mLockedBuffer(nullptr),
+        mReader(reader), mFormat(format), mUsage(usage), mBuffer(buffer),
         mTimestamp(timestamp), mWidth(width), mHeight(height), mNumPlanes(numPlanes) {
     LOG_FATAL_IF(reader == nullptr, "AImageReader shouldn't be null while creating AImage");
 }
@@ -64,7 +64,7 @@ AImage::close(int releaseFenceFd) {
     // Should have been set to nullptr in releaseImageLocked
     // Set to nullptr here for extra safety only
     mBuffer = nullptr;
-    mLockedBuffer = nullptr;
+    mIsLocked = false;
     mIsClosed = true;
 }
 
@@ -169,24 +169,22 @@ media_status_t AImage::lockImage() {
         return AMEDIA_IMGREADER_CANNOT_LOCK_IMAGE;
     }
 
-    if (mLockedBuffer != nullptr) {
+    if (mIsLocked) {
         // Return immediately if the image has already been locked.
         return AMEDIA_OK;
     }
 
-    auto lockedBuffer = std::make_unique<CpuConsumer::LockedBuffer>();
-
     uint64_t grallocUsage = AHardwareBuffer_convertToGrallocUsageBits(mUsage);
 
     status_t ret =
-            lockImageFromBuffer(mBuffer, grallocUsage, mBuffer->mFence->dup(), lockedBuffer.get());
+            lockImageFromBuffer(mBuffer, grallocUsage, mBuffer->mFence->dup(), &mLockedBuffer);
     if (ret != OK) {
         ALOGE("%s: AImage %p failed to lock, error=%d", __FUNCTION__, this, ret);
         return AMEDIA_IMGREADER_CANNOT_LOCK_IMAGE;
     }
 
     ALOGV("%s: Successfully locked the image %p.", __FUNCTION__, this);
-    mLockedBuffer = std::move(lockedBuffer);
+    mIsLocked = true;
 
     return AMEDIA_OK;
 }
@@ -202,7 +200,7 @@ media_status_t AImage::unlockImageIfLocked(int* fenceFd) {
         return AMEDIA_ERROR_INVALID_OBJECT;
     }
 
-    if (mLockedBuffer == nullptr) {
+    if (!mIsLocked) {
         // This image hasn't been locked yet, no need to unlock.
         *fenceFd = -1;
         return AMEDIA_OK;
@@ -223,7 +221,7 @@ media_status_t AImage::unlockImageIfLocked(int* fenceFd) {
 
 media_status_t
 AImage::getPlanePixelStride(int planeIdx, /*out*/int32_t* pixelStride) const {
-    if (mLockedBuffer == nullptr) {
+    if (!mIsLocked) {
         ALOGE("%s: buffer not locked.", __FUNCTION__);
         return AMEDIA_IMGREADER_IMAGE_NOT_LOCKED;
     }
@@ -240,10 +238,10 @@ AImage::getPlanePixelStride(int planeIdx, /*out*/int32_t* pixelStride) const {
         ALOGE("%s: image %p has been closed!", __FUNCTION__, this);
         return AMEDIA_ERROR_INVALID_OBJECT;
     }
-    int32_t fmt = mLockedBuffer->flexFormat;
+    int32_t fmt = mLockedBuffer.flexFormat;
     switch (fmt) {
         case HAL_PIXEL_FORMAT_YCbCr_420_888:
-            *pixelStride = (planeIdx == 0) ? 1 : mLockedBuffer->chromaStep;
+            *pixelStride = (planeIdx == 0) ? 1 : mLockedBuffer.chromaStep;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_YCrCb_420_SP:
             *pixelStride = (planeIdx == 0) ? 1 : 2;
@@ -283,7 +281,7 @@ AImage::getPlanePixelStride(int planeIdx, /*out*/int32_t* pixelStride) const {
 
 media_status_t
 AImage::getPlaneRowStride(int planeIdx, /*out*/int32_t* rowStride) const {
-    if (mLockedBuffer == nullptr) {
+    if (!mIsLocked) {
         ALOGE("%s: buffer not locked.", __FUNCTION__);
         return AMEDIA_IMGREADER_IMAGE_NOT_LOCKED;
     }
@@ -300,58 +298,58 @@ AImage::getPlaneRowStride(int planeIdx, /*out*/int32_t* rowStride) const {
         ALOGE("%s: image %p has been closed!", __FUNCTION__, this);
         return AMEDIA_ERROR_INVALID_OBJECT;
     }
-    int32_t fmt = mLockedBuffer->flexFormat;
+    int32_t fmt = mLockedBuffer.flexFormat;
     switch (fmt) {
         case HAL_PIXEL_FORMAT_YCbCr_420_888:
-            *rowStride = (planeIdx == 0) ? mLockedBuffer->stride
-                                         : mLockedBuffer->chromaStride;
+            *rowStride = (planeIdx == 0) ? mLockedBuffer.stride
+                                         : mLockedBuffer.chromaStride;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_YCrCb_420_SP:
-            *rowStride = mLockedBuffer->width;
+            *rowStride = mLockedBuffer.width;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_YV12:
-            if (mLockedBuffer->stride % 16) {
-                ALOGE("Stride %d is not 16 pixel aligned!", mLockedBuffer->stride);
+            if (mLockedBuffer.stride % 16) {
+                ALOGE("Stride %d is not 16 pixel aligned!", mLockedBuffer.stride);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            *rowStride = (planeIdx == 0) ? mLockedBuffer->stride
-                                         : ALIGN(mLockedBuffer->stride / 2, 16);
+            *rowStride = (planeIdx == 0) ? mLockedBuffer.stride
+                                         : ALIGN(mLockedBuffer.stride / 2, 16);
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_RAW10:
         case HAL_PIXEL_FORMAT_RAW12:
             // RAW10 and RAW12 are used for 10-bit and 12-bit raw data, they are single plane
-            *rowStride = mLockedBuffer->stride;
+            *rowStride = mLockedBuffer.stride;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_Y8:
-            if (mLockedBuffer->stride % 16) {
+            if (mLockedBuffer.stride % 16) {
                 ALOGE("Stride %d is not 16 pixel aligned!",
-                      mLockedBuffer->stride);
+                      mLockedBuffer.stride);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            *rowStride = mLockedBuffer->stride;
+            *rowStride = mLockedBuffer.stride;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_Y16:
         case HAL_PIXEL_FORMAT_RAW16:
             // In native side, strides are specified in pixels, not in bytes.
             // Single plane 16bpp bayer data. even width/height,
             // row stride multiple of 16 pixels (32 bytes)
-            if (mLockedBuffer->stride % 16) {
+            if (mLockedBuffer.stride % 16) {
                 ALOGE("Stride %d is not 16 pixel aligned!",
-                      mLockedBuffer->stride);
+                      mLockedBuffer.stride);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            *rowStride = mLockedBuffer->stride * 2;
+            *rowStride = mLockedBuffer.stride * 2;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_RGB_565:
-            *rowStride = mLockedBuffer->stride * 2;
+            *rowStride = mLockedBuffer.stride * 2;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_RGBA_8888:
         case HAL_PIXEL_FORMAT_RGBX_8888:
-            *rowStride = mLockedBuffer->stride * 4;
+            *rowStride = mLockedBuffer.stride * 4;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_RGB_888:
             // Single plane, 24bpp.
-            *rowStride = mLockedBuffer->stride * 3;
+            *rowStride = mLockedBuffer.stride * 3;
             return AMEDIA_OK;
         case HAL_PIXEL_FORMAT_BLOB:
         case HAL_PIXEL_FORMAT_RAW_OPAQUE:
@@ -366,13 +364,13 @@ AImage::getPlaneRowStride(int planeIdx, /*out*/int32_t* rowStride) const {
 
 uint32_t
 AImage::getJpegSize() const {
-    if (mLockedBuffer == nullptr) {
+    if (!mIsLocked) {
         LOG_ALWAYS_FATAL("Error: buffer is null");
     }
 
     uint32_t size = 0;
-    uint32_t width = mLockedBuffer->width;
-    uint8_t* jpegBuffer = mLockedBuffer->data;
+    uint32_t width = mLockedBuffer.width;
+    uint8_t* jpegBuffer = mLockedBuffer.data;
 
     // First check for JPEG transport header at the end of the buffer
     uint8_t* header = jpegBuffer + (width - sizeof(struct camera3_jpeg_blob));
@@ -400,7 +398,7 @@ AImage::getJpegSize() const {
 
 media_status_t
 AImage::getPlaneData(int planeIdx,/*out*/uint8_t** data, /*out*/int* dataLength) const {
-    if (mLockedBuffer == nullptr) {
+    if (!mIsLocked) {
         ALOGE("%s: buffer not locked.", __FUNCTION__);
         return AMEDIA_IMGREADER_IMAGE_NOT_LOCKED;
     }
@@ -423,154 +421,154 @@ AImage::getPlaneData(int planeIdx,/*out*/uint8_t** data, /*out*/int* dataLength)
     uint8_t* cr = nullptr;
     uint8_t* pData = nullptr;
     int bytesPerPixel = 0;
-    int32_t fmt = mLockedBuffer->flexFormat;
+    int32_t fmt = mLockedBuffer.flexFormat;
 
     switch (fmt) {
         case HAL_PIXEL_FORMAT_YCbCr_420_888:
-            pData = (planeIdx == 0) ? mLockedBuffer->data
-                                    : (planeIdx == 1) ? mLockedBuffer->dataCb
-                                                      : mLockedBuffer->dataCr;
+            pData = (planeIdx == 0) ? mLockedBuffer.data
+                                    : (planeIdx == 1) ? mLockedBuffer.dataCb
+                                                      : mLockedBuffer.dataCr;
             // only map until last pixel
             if (planeIdx == 0) {
-                dataSize = mLockedBuffer->stride * (mLockedBuffer->height - 1) +
-                           mLockedBuffer->width;
+                dataSize = mLockedBuffer.stride * (mLockedBuffer.height - 1) +
+                           mLockedBuffer.width;
             } else {
                 dataSize =
-                    mLockedBuffer->chromaStride *
-                        (mLockedBuffer->height / 2 - 1) +
-                    mLockedBuffer->chromaStep * (mLockedBuffer->width / 2 - 1) +
+                    mLockedBuffer.chromaStride *
+                        (mLockedBuffer.height / 2 - 1) +
+                    mLockedBuffer.chromaStep * (mLockedBuffer.width / 2 - 1) +
                     1;
             }
             break;
         // NV21
         case HAL_PIXEL_FORMAT_YCrCb_420_SP:
-            cr = mLockedBuffer->data +
-                 (mLockedBuffer->stride * mLockedBuffer->height);
+            cr = mLockedBuffer.data +
+                 (mLockedBuffer.stride * mLockedBuffer.height);
             cb = cr + 1;
             // only map until last pixel
-            ySize = mLockedBuffer->width * (mLockedBuffer->height - 1) +
-                    mLockedBuffer->width;
-            cSize = mLockedBuffer->width * (mLockedBuffer->height / 2 - 1) +
-                    mLockedBuffer->width - 1;
-            pData = (planeIdx == 0) ? mLockedBuffer->data
+            ySize = mLockedBuffer.width * (mLockedBuffer.height - 1) +
+                    mLockedBuffer.width;
+            cSize = mLockedBuffer.width * (mLockedBuffer.height / 2 - 1) +
+                    mLockedBuffer.width - 1;
+            pData = (planeIdx == 0) ? mLockedBuffer.data
                                     : (planeIdx == 1) ? cb : cr;
             dataSize = (planeIdx == 0) ? ySize : cSize;
             break;
         case HAL_PIXEL_FORMAT_YV12:
             // Y and C stride need to be 16 pixel aligned.
-            if (mLockedBuffer->stride % 16) {
+            if (mLockedBuffer.stride % 16) {
                 ALOGE("Stride %d is not 16 pixel aligned!",
-                      mLockedBuffer->stride);
+                      mLockedBuffer.stride);
                 return AMEDIA_ERROR_UNKNOWN;
             }
 
-            ySize = mLockedBuffer->stride * mLockedBuffer->height;
-            cStride = ALIGN(mLockedBuffer->stride / 2, 16);
-            cr = mLockedBuffer->data + ySize;
-            cSize = cStride * mLockedBuffer->height / 2;
+            ySize = mLockedBuffer.stride * mLockedBuffer.height;
+            cStride = ALIGN(mLockedBuffer.stride / 2, 16);
+            cr = mLockedBuffer.data + ySize;
+            cSize = cStride * mLockedBuffer.height / 2;
             cb = cr + cSize;
 
-            pData = (planeIdx == 0) ? mLockedBuffer->data
+            pData = (planeIdx == 0) ? mLockedBuffer.data
                                     : (planeIdx == 1) ? cb : cr;
             dataSize = (planeIdx == 0) ? ySize : cSize;
             break;
         case HAL_PIXEL_FORMAT_Y8:
             // Single plane, 8bpp.
 
-            pData = mLockedBuffer->data;
-            dataSize = mLockedBuffer->stride * mLockedBuffer->height;
+            pData = mLockedBuffer.data;
+            dataSize = mLockedBuffer.stride * mLockedBuffer.height;
             break;
         case HAL_PIXEL_FORMAT_Y16:
             bytesPerPixel = 2;
 
-            pData = mLockedBuffer->data;
+            pData = mLockedBuffer.data;
             dataSize =
-                mLockedBuffer->stride * mLockedBuffer->height * bytesPerPixel;
+                mLockedBuffer.stride * mLockedBuffer.height * bytesPerPixel;
             break;
         case HAL_PIXEL_FORMAT_BLOB:
             // Used for JPEG data, height must be 1, width == size, single plane.
-            if (mLockedBuffer->height != 1) {
+            if (mLockedBuffer.height != 1) {
                 ALOGE("Jpeg should have height value one but got %d",
-                      mLockedBuffer->height);
+                      mLockedBuffer.height);
                 return AMEDIA_ERROR_UNKNOWN;
             }
 
-            pData = mLockedBuffer->data;
+            pData = mLockedBuffer.data;
             dataSize = getJpegSize();
             break;
         case HAL_PIXEL_FORMAT_RAW16:
             // Single plane 16bpp bayer data.
             bytesPerPixel = 2;
-            pData = mLockedBuffer->data;
+            pData = mLockedBuffer.data;
             dataSize =
-                mLockedBuffer->stride * mLockedBuffer->height * bytesPerPixel;
+                mLockedBuffer.stride * mLockedBuffer.height * bytesPerPixel;
             break;
         case HAL_PIXEL_FORMAT_RAW_OPAQUE:
             // Used for RAW_OPAQUE data, height must be 1, width == size, single plane.
-            if (mLockedBuffer->height != 1) {
+            if (mLockedBuffer.height != 1) {
                 ALOGE("RAW_OPAQUE should have height value one but got %d",
-                      mLockedBuffer->height);
+                      mLockedBuffer.height);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            pData = mLockedBuffer->data;
-            dataSize = mLockedBuffer->width;
+            pData = mLockedBuffer.data;
+            dataSize = mLockedBuffer.width;
             break;
         case HAL_PIXEL_FORMAT_RAW10:
             // Single plane 10bpp bayer data.
-            if (mLockedBuffer->width % 4) {
-                ALOGE("Width is not multiple of 4 %d", mLockedBuffer->width);
+            if (mLockedBuffer.width % 4) {
+                ALOGE("Width is not multiple of 4 %d", mLockedBuffer.width);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            if (mLockedBuffer->height % 2) {
-                ALOGE("Height is not multiple of 2 %d", mLockedBuffer->height);
+            if (mLockedBuffer.height % 2) {
+                ALOGE("Height is not multiple of 2 %d", mLockedBuffer.height);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            if (mLockedBuffer->stride < (mLockedBuffer->width * 10 / 8)) {
+            if (mLockedBuffer.stride < (mLockedBuffer.width * 10 / 8)) {
                 ALOGE("stride (%d) should be at least %d",
-                        mLockedBuffer->stride, mLockedBuffer->width * 10 / 8);
+                        mLockedBuffer.stride, mLockedBuffer.width * 10 / 8);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            pData = mLockedBuffer->data;
-            dataSize = mLockedBuffer->stride * mLockedBuffer->height;
+            pData = mLockedBuffer.data;
+            dataSize = mLockedBuffer.stride * mLockedBuffer.height;
             break;
         case HAL_PIXEL_FORMAT_RAW12:
             // Single plane 10bpp bayer data.
-            if (mLockedBuffer->width % 4) {
-                ALOGE("Width is not multiple of 4 %d", mLockedBuffer->width);
+            if (mLockedBuffer.width % 4) {
+                ALOGE("Width is not multiple of 4 %d", mLockedBuffer.width);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            if (mLockedBuffer->height % 2) {
-                ALOGE("Height is not multiple of 2 %d", mLockedBuffer->height);
+            if (mLockedBuffer.height % 2) {
+                ALOGE("Height is not multiple of 2 %d", mLockedBuffer.height);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            if (mLockedBuffer->stride < (mLockedBuffer->width * 12 / 8)) {
+            if (mLockedBuffer.stride < (mLockedBuffer.width * 12 / 8)) {
                 ALOGE("stride (%d) should be at least %d",
-                        mLockedBuffer->stride, mLockedBuffer->width * 12 / 8);
+                        mLockedBuffer.stride, mLockedBuffer.width * 12 / 8);
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            pData = mLockedBuffer->data;
-            dataSize = mLockedBuffer->stride * mLockedBuffer->height;
+            pData = mLockedBuffer.data;
+            dataSize = mLockedBuffer.stride * mLockedBuffer.height;
             break;
         case HAL_PIXEL_FORMAT_RGBA_8888:
         case HAL_PIXEL_FORMAT_RGBX_8888:
             // Single plane, 32bpp.
             bytesPerPixel = 4;
-            pData = mLockedBuffer->data;
+            pData = mLockedBuffer.data;
             dataSize =
-                mLockedBuffer->stride * mLockedBuffer->height * bytesPerPixel;
+                mLockedBuffer.stride * mLockedBuffer.height * bytesPerPixel;
             break;
         case HAL_PIXEL_FORMAT_RGB_565:
             // Single plane, 16bpp.
             bytesPerPixel = 2;
-            pData = mLockedBuffer->data;
+            pData = mLockedBuffer.data;
             dataSize =
-                mLockedBuffer->stride * mLockedBuffer->height * bytesPerPixel;
+                mLockedBuffer.stride * mLockedBuffer.height * bytesPerPixel;
             break;
         case HAL_PIXEL_FORMAT_RGB_888:
             // Single plane, 24bpp.
             bytesPerPixel = 3;
-            pData = mLockedBuffer->data;
-            dataSize = mLockedBuffer->stride * mLockedBuffer->height * bytesPerPixel;
+            pData = mLockedBuffer.data;
+            dataSize = mLockedBuffer.stride * mLockedBuffer.height * bytesPerPixel;
             break;
         default:
             ALOGE("Pixel format: 0x%x is unsupported", fmt);
@@ -76,7 +76,9 @@ struct AImage {
     const int32_t              mFormat;
     const uint64_t             mUsage;  // AHARDWAREBUFFER_USAGE_* flags.
     BufferItem*                mBuffer;
-    std::unique_ptr<CpuConsumer::LockedBuffer> mLockedBuffer;
+    // Kept inline so locking an image for plane access doesn't allocate
+    CpuConsumer::LockedBuffer  mLockedBuffer;
+    bool                       mIsLocked = false;
     const int64_t              mTimestamp;
     const int32_t              mWidth;
     const int32_t              mHeight;
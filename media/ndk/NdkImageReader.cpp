@@ -539,7 +539,7 @@ AImageReader::releaseImageLocked(AImage* image, int releaseFenceFd, bool clearCa
     mBufferItemConsumer->releaseBuffer(*buffer, bufferFence);
     returnBufferItemLocked(buffer);
     image->mBuffer = nullptr;
-    image->mLockedBuffer = nullptr;
+    image->mIsLocked = false;
     image->mIsClosed = true;
 
     if (!clearCache) {
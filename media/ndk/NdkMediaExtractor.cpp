@@ -182,9 +182,9 @@ media_status_t AMediaExtractor_seekTo(AMediaExtractor *ex, int64_t seekPosUs, Se
 EXPORT
 ssize_t AMediaExtractor_readSampleData(AMediaExtractor *mData, uint8_t *buffer, size_t capacity) {
     //ALOGV("readSampleData");
-    sp<ABuffer> tmp = new ABuffer(buffer, capacity);
-    if (mData->mImpl->readSampleData(tmp) == OK) {
-        return tmp->size();
+    size_t sampleSize;
+    if (mData->mImpl->readSampleData(buffer, capacity, &sampleSize) == OK) {
+        return sampleSize;
     }
     return -1;
 }
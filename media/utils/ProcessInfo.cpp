@@ -29,9 +29,22 @@ namespace android {
 
 ProcessInfo::ProcessInfo() {}
 
+sp<IProcessInfoService> ProcessInfo::getProcessInfoService() {
+    Mutex::Autolock lock(mLock);
+    if (mProcessInfoService == nullptr
+            || !IInterface::asBinder(mProcessInfoService)->isBinderAlive()) {
+        sp<IBinder> binder = defaultServiceManager()->getService(String16("processinfo"));
+        mProcessInfoService = interface_cast<IProcessInfoService>(binder);
+    }
+    return mProcessInfoService;
+}
+
 bool ProcessInfo::getPriority(int pid, int* priority) {
-    sp<IBinder> binder = defaultServiceManager()->getService(String16("processinfo"));
-    sp<IProcessInfoService> service = interface_cast<IProcessInfoService>(binder);
+    sp<IProcessInfoService> service = getProcessInfoService();
+    if (service == nullptr) {
+        ALOGE("processinfo service is not available");
+        return false;
+    }
 
     size_t length = 1;
     int32_t state;
@@ -59,9 +59,10 @@ std::vector<pid_t> TimeCheck::getAudioHalPids() {
 }
 
 /* static */
-sp<TimeCheck::TimeCheckThread> TimeCheck::getTimeCheckThread()
+const sp<TimeCheck::TimeCheckThread>& TimeCheck::getTimeCheckThread()
 {
-    static sp<TimeCheck::TimeCheckThread> sTimeCheckThread = new TimeCheck::TimeCheckThread();
+    static const sp<TimeCheck::TimeCheckThread> sTimeCheckThread =
+            new TimeCheck::TimeCheckThread();
     return sTimeCheckThread;
 }
 
@@ -86,15 +87,19 @@ nsecs_t TimeCheck::TimeCheckThread::startMonitoring(const char *tag, uint32_t ti
     Mutex::Autolock _l(mMutex);
     nsecs_t endTimeNs = systemTime() + milliseconds(timeoutMs);
     for (; mMonitorRequests.indexOfKey(endTimeNs) >= 0; ++endTimeNs);
-    mMonitorRequests.add(endTimeNs, tag);
-    mCond.signal();
+    // The monitor thread only needs to be woken up if its next timeout has changed.
+    if (mMonitorRequests.add(endTimeNs, tag) == 0) {
+        mCond.signal();
+    }
     return endTimeNs;
 }
 
 void TimeCheck::TimeCheckThread::stopMonitoring(nsecs_t endTimeNs) {
     Mutex::Autolock _l(mMutex);
-    mMonitorRequests.removeItem(endTimeNs);
-    mCond.signal();
+    if (mMonitorRequests.removeItem(endTimeNs) == 0) {
+        // Removed the request the monitor thread is waiting on.
+        mCond.signal();
+    }
 }
 
 bool TimeCheck::TimeCheckThread::threadLoop()
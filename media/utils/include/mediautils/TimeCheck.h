@@ -64,7 +64,7 @@ private:
                 KeyedVector< nsecs_t, const char*>  mMonitorRequests;
     };
 
-    static sp<TimeCheckThread> getTimeCheckThread();
+    static const sp<TimeCheckThread>& getTimeCheckThread();
     static void accessAudioHalPids(std::vector<pid_t>* pids, bool update);
 
     const           nsecs_t mEndTimeNs;
@@ -1254,6 +1254,60 @@ void AudioFlinger::setRecordSilenced(audio_port_handle_t portId, bool silenced)
     }
 }
 
+status_t AudioFlinger::controlTracks(IAudioFlinger::track_control_t control,
+                                     const std::vector<audio_port_handle_t>& portIds,
+                                     std::vector<status_t> *statuses)
+{
+    switch (control) {
+    case TRACK_CONTROL_START:
+    case TRACK_CONTROL_STOP:
+    case TRACK_CONTROL_PAUSE:
+        break;
+    default:
+        return BAD_VALUE;
+    }
+    const uid_t callingUid = IPCThreadState::self()->getCallingUid();
+    statuses->assign(portIds.size(), BAD_VALUE);
+
+    // Group the tracks by thread, keeping the requested order within each thread.
+    std::map<sp<PlaybackThread>, std::vector<std::pair<size_t, sp<PlaybackThread::Track>>>>
+            batches;
+    std::vector<std::pair<size_t, sp<PlaybackThread::Track>>> offloadedStarts;
+    {
+        AutoMutex lock(mLock);
+        for (size_t i = 0; i < portIds.size(); ++i) {
+            for (size_t j = 0; j < mPlaybackThreads.size(); ++j) {
+                sp<PlaybackThread> thread = mPlaybackThreads.valueAt(j);
+                sp<PlaybackThread::Track> track = thread->getExternalTrackByPortId(portIds[i]);
+                if (track == nullptr) {
+                    continue;
+                }
+                // only the owner (or a system component acting for it) may control a track.
+                if (track->uid() != callingUid && !isServiceUid(callingUid)) {
+                    ALOGW("%s: uid %d cannot control track of port %d",
+                            __func__, callingUid, portIds[i]);
+                    (*statuses)[i] = PERMISSION_DENIED;
+                } else if (control == TRACK_CONTROL_START && track->isOffloaded()) {
+                    // Track::start() checks effects under our lock, start it on its own.
+                    offloadedStarts.emplace_back(i, track);
+                } else {
+                    batches[thread].emplace_back(i, track);
+                }
+                break;
+            }
+        }
+    }
+    // PlaybackThread::controlTracks() must not be called with our lock held:
+    // starting a track calls into AudioPolicyService, which may call back into us.
+    for (const auto& [thread, tracks] : batches) {
+        thread->controlTracks(control, tracks, statuses);
+    }
+    for (const auto& [index, track] : offloadedStarts) {
+        (*statuses)[index] = track->start();
+    }
+    return NO_ERROR;
+}
+
 status_t AudioFlinger::setMasterMute(bool muted)
 {
     status_t ret = initCheck();
@@ -2153,12 +2207,40 @@ audio_module_handle_t AudioFlinger::loadHwModule(const char *name)
         return AUDIO_MODULE_HANDLE_NONE;
     }
     Mutex::Autolock _l(mLock);
+    for (;;) {
+        for (size_t i = 0; i < mAudioHwDevs.size(); i++) {
+            if (strncmp(mAudioHwDevs.valueAt(i)->moduleName(), name, strlen(name)) == 0) {
+                ALOGW("loadHwModule() module %s already loaded", name);
+                return mAudioHwDevs.keyAt(i);
+            }
+        }
+        // A module is opened only once: wait for another caller already opening it.
+        if (mHwModulesOpening.count(name) == 0) {
+            break;
+        }
+        mHwModuleOpenedCond.wait(mLock);
+    }
+
+    // Opening the HAL device can take tens of milliseconds per module; do it without
+    // holding mLock so that other AudioFlinger calls are not blocked meanwhile.
+    mHwModulesOpening.insert(name);
+    mLock.unlock();
+    sp<DeviceHalInterface> dev;
+    int rc = mDevicesFactoryHal->openDevice(name, &dev);
+    mLock.lock();
+    mHwModulesOpening.erase(name);
+    mHwModuleOpenedCond.broadcast();
+    if (rc) {
+        ALOGE("loadHwModule() error %d loading module %s", rc, name);
+        return AUDIO_MODULE_HANDLE_NONE;
+    }
+
     AutoMutex lock(mHardwareLock);
-    return loadHwModule_l(name);
+    return loadHwModule_l(name, dev);
 }
 
 // loadHwModule_l() must be called with AudioFlinger::mLock and AudioFlinger::mHardwareLock held
-audio_module_handle_t AudioFlinger::loadHwModule_l(const char *name)
+audio_module_handle_t AudioFlinger::loadHwModule_l(const char *name, sp<DeviceHalInterface> dev)
 {
     for (size_t i = 0; i < mAudioHwDevs.size(); i++) {
         if (strncmp(mAudioHwDevs.valueAt(i)->moduleName(), name, strlen(name)) == 0) {
@@ -2167,12 +2249,20 @@ audio_module_handle_t AudioFlinger::loadHwModule_l(const char *name)
         }
     }
 
-    sp<DeviceHalInterface> dev;
-
-    int rc = mDevicesFactoryHal->openDevice(name, &dev);
-    if (rc) {
-        ALOGE("loadHwModule() error %d loading module %s", rc, name);
-        return AUDIO_MODULE_HANDLE_NONE;
+    int rc;
+    if (dev == nullptr) {
+        // loadHwModule() is opening this module without mLock. Don't open it a second
+        // time: some legacy HALs return a shared device that closing the extra one
+        // would close for both.
+        if (mHwModulesOpening.count(name) != 0) {
+            ALOGW("loadHwModule() module %s is being loaded", name);
+            return AUDIO_MODULE_HANDLE_NONE;
+        }
+        rc = mDevicesFactoryHal->openDevice(name, &dev);
+        if (rc) {
+            ALOGE("loadHwModule() error %d loading module %s", rc, name);
+            return AUDIO_MODULE_HANDLE_NONE;
+        }
     }
 
     mHardwareStatus = AUDIO_HW_INIT;
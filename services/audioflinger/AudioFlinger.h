@@ -290,6 +290,10 @@ public:
 
     virtual status_t setAudioHalPids(const std::vector<pid_t>& pids);
 
+    virtual status_t controlTracks(IAudioFlinger::track_control_t control,
+                                   const std::vector<audio_port_handle_t>& portIds,
+                                   std::vector<status_t> *statuses);
+
     virtual     status_t    onTransact(
                                 uint32_t code,
                                 const Parcel& data,
@@ -837,6 +841,11 @@ using effect_buffer_t = int16_t;
                 // NOTE: If both mLock and mHardwareLock mutexes must be held,
                 // always take mLock before mHardwareLock
 
+                // guarded by mLock: modules loadHwModule() is opening without mLock,
+                // mHwModuleOpenedCond is signaled when one of them is done
+                std::set<std::string>               mHwModulesOpening;
+                Condition                           mHwModuleOpenedCond;
+
                 // guarded by mHardwareLock
                 AudioHwDevice* mPrimaryHardwareDev;
                 DefaultKeyedVector<audio_module_handle_t, AudioHwDevice*>  mAudioHwDevs;
@@ -900,7 +909,9 @@ using effect_buffer_t = int16_t;
                 float       masterVolume_l() const;
                 float       getMasterBalance_l() const;
                 bool        masterMute_l() const;
-                audio_module_handle_t loadHwModule_l(const char *name);
+                // dev, if not null, is the already opened HAL device for the module
+                audio_module_handle_t loadHwModule_l(const char *name,
+                                                     sp<DeviceHalInterface> dev = nullptr);
 
                 Vector < sp<SyncEvent> > mPendingSyncEvents; // sync events awaiting for a session
                                                              // to be created
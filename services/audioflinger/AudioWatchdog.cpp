@@ -34,8 +34,8 @@ void AudioWatchdogDump::dump(int fd)
     } else {
         strcpy(buf, "N/A\n");
     }
-    dprintf(fd, "Watchdog: underruns=%u, logs=%u, most recent underrun log at %s",
-            mUnderruns, mLogs, buf);
+    dprintf(fd, "Watchdog: underruns=%u, logs=%u, worst cycle=%.1f ms, most recent underrun log at %s",
+            mUnderruns, mLogs, mWorstCycleNs * 1e-6, buf);
 }
 
 bool AudioWatchdog::threadLoop()
@@ -87,6 +87,9 @@ bool AudioWatchdog::threadLoop()
     }
     if (cycleNs > mMaxCycleNs) {
         mDump->mUnderruns = ++mUnderruns;
+        if (cycleNs > mDump->mWorstCycleNs) {
+            mDump->mWorstCycleNs = cycleNs;
+        }
         if (mLogTs.tv_sec >= MIN_TIME_BETWEEN_LOGS_SEC) {
             mDump->mLogs = ++mLogs;
             mDump->mMostRecent = time(NULL);
@@ -30,11 +30,12 @@ namespace android {
 // Keeps a cache of AudioWatchdog statistics that can be logged by dumpsys.
 // The usual caveats about atomicity of information apply.
 struct AudioWatchdogDump {
-    AudioWatchdogDump() : mUnderruns(0), mLogs(0), mMostRecent(0) { }
+    AudioWatchdogDump() : mUnderruns(0), mLogs(0), mMostRecent(0), mWorstCycleNs(0) { }
     /*virtual*/ ~AudioWatchdogDump() { }
     uint32_t mUnderruns;    // total number of underruns
     uint32_t mLogs;         // total number of log messages
     time_t   mMostRecent;   // time of most recent log
+    uint32_t mWorstCycleNs; // longest cycle seen, to tell brief stalls from long ones
     void     dump(int fd);  // should only be called on a stable copy, not the original
 };
 
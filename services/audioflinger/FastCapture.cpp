@@ -20,11 +20,13 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <audio_utils/format.h>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <media/AudioBufferProvider.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <utils/Trace.h>
 #include "FastCapture.h"
 
@@ -182,9 +184,18 @@ void FastCapture::onWork()
         ALOG_ASSERT(mInputSource != NULL);
         ALOG_ASSERT(mReadBuffer != NULL);
         dumpState->mReadSequence++;
+#ifdef FAST_THREAD_STATISTICS
+        const nsecs_t readBeginNs = systemTime();
+#endif
         ATRACE_BEGIN("read");
         ssize_t framesRead = mInputSource->read(mReadBuffer, frameCount);
         ATRACE_END();
+#ifdef FAST_THREAD_STATISTICS
+        if (mIsWarm) {
+            dumpState->mIoHistogram.addNs((uint32_t)std::min(
+                    systemTime() - readBeginNs, (nsecs_t)UINT32_MAX));
+        }
+#endif
         dumpState->mReadSequence++;
         if (framesRead >= 0) {
             LOG_ALWAYS_FATAL_IF((size_t) framesRead > frameCount);
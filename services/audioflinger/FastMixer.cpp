@@ -26,9 +26,11 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <time.h>
 #include <utils/Debug.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <utils/Trace.h>
 #include <system/audio.h>
 #ifdef FAST_THREAD_STATISTICS
@@ -203,6 +205,34 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
     }
 }
 
+void FastMixer::applyCommands()
+{
+    mCQ.drain([this](const FastMixerCommand& command) {
+        // A track that is not (yet) in the mixer gets the same value from the
+        // FastMixerState when it is added, so the command can be dropped.
+        // So can a command for an older generation of the slot: the slot may have
+        // been reused by another track, and otherwise the state push that changed
+        // the generation carries the value too.
+        const int name = command.mIndex;
+        if (mMixer == nullptr || !mMixer->exists(name)
+                || mGenerations[name] != command.mGeneration) {
+            return;
+        }
+        switch (command.mKind) {
+        case FastMixerCommand::HAPTIC_ENABLED:
+            mMixer->setParameter(name, AudioMixer::TRACK, AudioMixer::HAPTIC_ENABLED,
+                    (void *)(uintptr_t)command.mValue);
+            break;
+        case FastMixerCommand::HAPTIC_INTENSITY:
+            mMixer->setParameter(name, AudioMixer::TRACK, AudioMixer::HAPTIC_INTENSITY,
+                    (void *)(uintptr_t)command.mValue);
+            break;
+        default:
+            LOG_ALWAYS_FATAL("%s: invalid command kind %d", __func__, command.mKind);
+        }
+    });
+}
+
 void FastMixer::onStateChange()
 {
     const FastMixerState * const current = (const FastMixerState *) mCurrent;
@@ -362,6 +392,9 @@ void FastMixer::onWork()
     const FastMixerState::Command command = mCommand;
     const size_t frameCount = current->mFrameCount;
 
+    // apply the deltas queued since the last cycle in one batch, before mixing
+    applyCommands();
+
     if ((command & FastMixerState::MIX) && (mMixer != NULL) && mIsWarm) {
         ALOG_ASSERT(mMixerBuffer != NULL);
 
@@ -370,6 +403,7 @@ void FastMixer::onWork()
         bool anyEnabledTracks = false;
 
         // for each track, update volume and check for underrun
+        uint32_t underrunTracks = 0;
         unsigned currentTrackMask = current->mTrackMask;
         while (currentTrackMask != 0) {
             int i = __builtin_ctz(currentTrackMask);
@@ -419,6 +453,7 @@ void FastMixer::onWork()
             FastTrackDump *ftDump = &dumpState->mTracks[i];
             FastTrackUnderruns underruns = ftDump->mUnderruns;
             if (framesReady < frameCount) {
+                ++underrunTracks;
                 if (framesReady == 0) {
                     underruns.mBitFields.mEmpty++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_EMPTY;
@@ -441,6 +476,10 @@ void FastMixer::onWork()
             ftDump->mFramesWritten = trackFramesWritten;
         }
 
+#ifdef FAST_THREAD_STATISTICS
+        dumpState->mUnderrunTracksHistogram[underrunTracks]++;
+#endif
+
         if (anyEnabledTracks) {
             // process() is CPU-bound
             mMixer->process();
@@ -489,9 +528,18 @@ void FastMixer::onWork()
         // FIXME write() is non-blocking and lock-free for a properly implemented NBAIO sink,
         //       but this code should be modified to handle both non-blocking and blocking sinks
         dumpState->mWriteSequence++;
+#ifdef FAST_THREAD_STATISTICS
+        const nsecs_t writeBeginNs = systemTime();
+#endif
         ATRACE_BEGIN("write");
         ssize_t framesWritten = mOutputSink->write(buffer, frameCount);
         ATRACE_END();
+#ifdef FAST_THREAD_STATISTICS
+        if (mIsWarm) {
+            dumpState->mIoHistogram.addNs((uint32_t)std::min(
+                    systemTime() - writeBeginNs, (nsecs_t)UINT32_MAX));
+        }
+#endif
         dumpState->mWriteSequence++;
         if (framesWritten >= 0) {
             ALOG_ASSERT((size_t) framesWritten <= frameCount);
@@ -21,6 +21,7 @@
 #include <audio_utils/Balance.h>
 #include "FastThread.h"
 #include "StateQueue.h"
+#include "FastMixerCommandQueue.h"
 #include "FastMixerState.h"
 #include "FastMixerDumpState.h"
 #include "NBAIO_Tee.h"
@@ -40,6 +41,7 @@ public:
     virtual ~FastMixer();
 
             FastMixerStateQueue* sq();
+            FastMixerCommandQueue* cq() { return &mCQ; }
 
     virtual void setMasterMono(bool mono) { mMasterMono.store(mono); /* memory_order_seq_cst */ }
     virtual void setMasterBalance(float balance) { mMasterBalance.store(balance); }
@@ -49,6 +51,7 @@ public:
     }
 private:
             FastMixerStateQueue mSQ;
+            FastMixerCommandQueue mCQ;
 
     // callouts
     virtual const FastThreadState *poll();
@@ -67,6 +70,9 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // applies the per-track deltas queued in mCQ by the normal mixer
+    void applyCommands();
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_FAST_MIXER_COMMAND_QUEUE_H
+#define ANDROID_AUDIO_FAST_MIXER_COMMAND_QUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace android {
+
+// A small per-track update sent from the normal mixer to the fast mixer,
+// outside of the FastMixerState snapshots.
+struct FastMixerCommand {
+    enum Kind : uint8_t {
+        HAPTIC_ENABLED,     // mValue is 0 or 1
+        HAPTIC_INTENSITY,   // mValue is an AudioMixer::haptic_intensity_t
+    };
+
+    Kind     mKind;
+    uint8_t  mIndex;        // fast track index, i.e. the AudioMixer name in the fast mixer
+    int32_t  mValue;
+    int32_t  mGeneration;   // FastTrack::mGeneration of the track at mIndex when sent;
+                            // the command is dropped if the slot has since changed
+};
+
+// FastMixerCommandQueue
+//
+// Single producer (normal mixer thread), single consumer (fast mixer thread)
+// lock-free ring of FastMixerCommand.
+//
+// The StateQueue publishes a complete FastMixerState and the fast mixer then
+// diffs every track, which is needed when the set of tracks changes but is
+// heavyweight for a single field of an existing track.  Such deltas are
+// pushed here instead; the fast mixer drains them all at the top of its next
+// cycle, so they take effect without waiting for a state push.
+//
+// The producer must also write the same value into the FastMixerState it is
+// mutating, so that the state stays authoritative: if the ring is full, push()
+// returns false and the caller falls back to a state push.
+//
+// Neither side blocks, allocates, or makes system calls.
+class FastMixerCommandQueue {
+public:
+    static constexpr uint32_t kCapacity = 64;   // must be a power of 2
+
+    FastMixerCommandQueue() = default;
+
+    // Normal mixer thread only.  Returns false if the ring is full.
+    bool push(const FastMixerCommand& command) {
+        const uint32_t rear = mRear.load(std::memory_order_relaxed);
+        if (rear - mFront.load(std::memory_order_acquire) >= kCapacity) {
+            return false;
+        }
+        mCommands[rear & (kCapacity - 1)] = command;
+        mRear.store(rear + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Fast mixer thread only.  Calls apply(const FastMixerCommand&) for every
+    // queued command in order, then releases them all at once.
+    // Returns the number of commands applied.
+    template <typename F>
+    uint32_t drain(F apply) {
+        const uint32_t front = mFront.load(std::memory_order_relaxed);
+        const uint32_t rear = mRear.load(std::memory_order_acquire);
+        for (uint32_t i = front; i != rear; ++i) {
+            apply(mCommands[i & (kCapacity - 1)]);
+        }
+        mFront.store(rear, std::memory_order_release);
+        return rear - front;
+    }
+
+private:
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of 2");
+
+    FastMixerCommand        mCommands[kCapacity];
+    std::atomic<uint32_t>   mFront{0};  // written by the consumer only
+    std::atomic<uint32_t>   mRear{0};   // written by the producer only
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_FAST_MIXER_COMMAND_QUEUE_H
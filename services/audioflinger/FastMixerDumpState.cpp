@@ -24,6 +24,7 @@
 #include <cpustats/ThreadCpuUsage.h>
 #endif
 #endif
+#include <string.h>
 #include <utils/Debug.h>
 #include <utils/Log.h>
 #include "FastMixerDumpState.h"
@@ -36,6 +37,9 @@ FastMixerDumpState::FastMixerDumpState() : FastThreadDumpState(),
     mSampleRate(0), mFrameCount(0),
     mTrackMask(0)
 {
+#ifdef FAST_THREAD_STATISTICS
+    memset(mUnderrunTracksHistogram, 0, sizeof(mUnderrunTracksHistogram));
+#endif
 }
 
 FastMixerDumpState::~FastMixerDumpState()
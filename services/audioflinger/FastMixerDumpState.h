@@ -76,6 +76,10 @@ struct FastMixerDumpState : FastThreadDumpState {
     size_t   mFrameCount;
     uint32_t mTrackMask;        // mask of active tracks
     FastTrackDump   mTracks[FastMixerState::kMaxFastTracks];
+#ifdef FAST_THREAD_STATISTICS
+    // bin i counts the mix cycles in which exactly i tracks had a partial or empty underrun
+    uint32_t mUnderrunTracksHistogram[FastMixerState::kMaxFastTracks + 1];
+#endif
 
     // For timestamp statistics.
     TimestampVerifier<int64_t /* frame count */, int64_t /* time ns */> mTimestampVerifier;
@@ -345,6 +345,8 @@ bool FastThread::threadLoop()
                     mDumpState->mMonotonicNs[i] = monotonicNs;
                     LOG_WORK_TIME(monotonicNs);
                     mDumpState->mLoadNs[i] = loadNs;
+                    mDumpState->mMonotonicHistogram.addNs(monotonicNs);
+                    mDumpState->mLoadHistogram.addNs(loadNs);
 #ifdef CPU_FREQUENCY_STATISTICS
                     mDumpState->mCpukHz[i] = kHz;
 #endif
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include <audio_utils/roundup.h>
 #include "FastThreadDumpState.h"
 
@@ -30,6 +31,9 @@ FastThreadDumpState::FastThreadDumpState() :
     mMeasuredWarmupTs.tv_sec = 0;
     mMeasuredWarmupTs.tv_nsec = 0;
 #ifdef FAST_THREAD_STATISTICS
+    memset(&mMonotonicHistogram, 0, sizeof(mMonotonicHistogram));
+    memset(&mLoadHistogram, 0, sizeof(mLoadHistogram));
+    memset(&mIoHistogram, 0, sizeof(mIoHistogram));
     increaseSamplingN(1);
 #endif
 }
@@ -54,6 +58,24 @@ void FastThreadDumpState::increaseSamplingN(uint32_t samplingN)
 #endif
     mSamplingN = samplingN;
 }
+
+std::string FastThreadHistogram::toString() const
+{
+    uint32_t bins[kBins];
+    memcpy(bins, mBins, sizeof(bins));   // bins may change while we read
+    uint32_t n = kBins;
+    while (n > 0 && bins[n - 1] == 0) {
+        --n;
+    }
+    std::string s;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (i > 0) {
+            s.append(",");
+        }
+        s.append(std::to_string(bins[i]));
+    }
+    return s;
+}
 #endif
 
 }   // android
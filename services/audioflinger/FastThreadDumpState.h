@@ -17,11 +17,37 @@
 #ifndef ANDROID_AUDIO_FAST_THREAD_DUMP_STATE_H
 #define ANDROID_AUDIO_FAST_THREAD_DUMP_STATE_H
 
+#include <string>
 #include "Configuration.h"
 #include "FastThreadState.h"
 
 namespace android {
 
+#ifdef FAST_THREAD_STATISTICS
+// Cumulative per-cycle histogram of a duration, with log2 bins in microseconds:
+// bin 0 counts durations < 1 us, bin i counts durations in [2^(i-1), 2^i) us,
+// and the last bin also counts everything longer.
+// Bins are only incremented by the fast thread and are never reset while the
+// thread exists, so a reader takes the difference of two snapshots.
+struct FastThreadHistogram {
+    static const uint32_t kBins = 24;   // last bin starts at 2^22 us, about 4.2 s
+
+    uint32_t mBins[kBins];
+
+    void    addNs(uint32_t ns) {
+        const uint32_t us = ns / 1000;
+        uint32_t bin = us == 0 ? 0 : 32 - __builtin_clz(us);
+        if (bin >= kBins) {
+            bin = kBins - 1;
+        }
+        mBins[bin]++;
+    }
+
+    // Comma separated bin counts, without trailing zero bins.
+    std::string toString() const;
+};
+#endif
+
 // The FastThreadDumpState keeps a cache of FastThread statistics that can be logged by dumpsys.
 // Each individual native word-sized field is accessed atomically.  But the
 // overall structure is non-atomic, that is there may be an inconsistency between fields.
@@ -61,6 +87,13 @@ struct FastThreadDumpState {
     uint32_t mCpukHz[kSamplingN];       // absolute CPU clock frequency in kHz, bits 0-3 are CPU#
 #endif
 
+    // Histograms covering every warm cycle since the thread was created, unlike the
+    // sample arrays above which only hold the most recent mSamplingN cycles.
+    // The normal thread reads these for mediametrics without involving the fast thread.
+    FastThreadHistogram mMonotonicHistogram;    // delta monotonic (wall clock) time
+    FastThreadHistogram mLoadHistogram;         // delta CPU load in time
+    FastThreadHistogram mIoHistogram;           // time blocked in the HAL write() or read()
+
     // Increase sampling window after construction, must be a power of 2 <= kSamplingN
     void    increaseSamplingN(uint32_t samplingN);
 #endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_METRICSREPORTER_H
+#define ANDROID_AUDIO_METRICSREPORTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+/**
+ * MetricsReporter is a single background thread which periodically asks each
+ * registered Client to submit whatever its audio thread counters have accumulated.
+ *
+ * This keeps mediametrics item construction (string and map work, binder calls)
+ * off the audio threads: the audio threads only update atomics in a fixed-layout
+ * counter block, see ThreadMetrics::RtCounters and TrackMetrics::RtCounters.
+ *
+ * Clients are held by weak reference and are never explicitly removed.  Each
+ * period the reporter promotes them to strong references under its lock, then
+ * calls report() with the lock released.  Destroying a client therefore never
+ * waits for the reporter; if a report() is in progress, the client is destroyed
+ * on the reporter thread once it returns.
+ */
+class MetricsReporter final {
+public:
+    class Client {
+    public:
+        // Called on the reporter thread, snapshot the counters and submit.
+        virtual void report() = 0;
+    protected:
+        ~Client() = default;
+    };
+
+    static MetricsReporter& getInstance() {
+        // Singleton. Constructed thread-safe on first call, never destroyed.
+        static MetricsReporter* const reporter = new MetricsReporter();
+        return *reporter;
+    }
+
+    void add(const std::weak_ptr<Client>& client) {
+        std::lock_guard l(mLock);
+        mClients.push_back(client);
+        if (!mThread.joinable()) {
+            mThread = std::thread(&MetricsReporter::threadLoop, this);
+        }
+    }
+
+private:
+    // Counters may be up to this stale in mediametrics;
+    // destruction and interval group changes flush immediately.
+    static constexpr std::chrono::milliseconds kReportPeriod{1000};
+
+    MetricsReporter() = default;
+
+    void threadLoop() {
+        std::vector<std::shared_ptr<Client>> clients;
+        for (;;) {
+            {
+                std::unique_lock l(mLock);
+                (void)mCondition.wait_for(l, kReportPeriod);
+                for (auto it = mClients.begin(); it != mClients.end(); ) {
+                    if (std::shared_ptr<Client> client = it->lock()) {
+                        clients.push_back(std::move(client));
+                        ++it;
+                    } else {
+                        it = mClients.erase(it);
+                    }
+                }
+            }
+            for (const auto& client : clients) {
+                client->report();
+            }
+            clients.clear(); // may destroy clients released meanwhile, without mLock.
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<std::weak_ptr<Client>> mClients;   // GUARDED_BY(mLock)
+    std::thread mThread;           // GUARDED_BY(mLock), detached by never being destroyed
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_METRICSREPORTER_H
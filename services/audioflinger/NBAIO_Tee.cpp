@@ -21,8 +21,11 @@
 
 #include <deque>
 #include <dirent.h>
+#include <fcntl.h>
 #include <future>
 #include <list>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <vector>
 
 #include <audio_utils/format.h>
@@ -50,6 +53,12 @@ namespace android {
 
  where Reason = [ DTOR | DUMP | REMOVE ]
 
+ Streaming tees (see NBAIO_Tee.h) are not dated, they use a fixed ring file per thread:
+
+ "aftee_stream_ThreadId_C.raw" RecordThread
+ "aftee_stream_ThreadId_M.raw" MixerThread (Normal)
+ "aftee_stream_ThreadId_F.raw" MixerThread (Fast)
+
  Examples:
   aftee_20180424_153811_038_13_57_2_T_REMOVE.wav
   aftee_20180424_153811_218_13_57_2_T_REMOVE.wav
@@ -250,6 +259,151 @@ exit:
     return {nullptr, nullptr};
 }
 
+/** TeeStream is a fixed size ring of frames in a shared memory-mapped file.
+
+    The file layout is one StreamHeader page followed by frameCapacity frames.
+    The frame written as the Nth frame (counting from 0) is stored at ring index
+    N % frameCapacity, so the valid frames in the ring are the
+    min(framesWritten, frameCapacity) frames ending at framesWritten - 1.
+
+    write() is a memcpy and a release store of framesWritten; the pages are
+    populated on creation so the audio thread does not fault on the first pass.
+    The kernel writes the dirty pages back to the file, and the contents survive
+    the process. */
+class NBAIO_Tee::NBAIO_TeeImpl::TeeStream {
+public:
+    struct StreamHeader {
+        char     magic[8];          // STREAM_MAGIC
+        uint32_t version;           // STREAM_VERSION
+        uint32_t dataOffset;        // byte offset of ring index 0 from the start of file
+        uint32_t sampleRate;
+        uint32_t channelCount;
+        uint32_t format;            // audio_format_t
+        uint32_t frameSize;         // in bytes
+        uint64_t frameCapacity;     // ring size in frames
+        std::atomic<uint64_t> framesWritten; // total frames ever written
+    };
+
+    static constexpr char STREAM_MAGIC[8] = {'A', 'F', 'T', 'E', 'E', 'S', 'T', 'R'};
+    static constexpr uint32_t STREAM_VERSION = 1;
+    static constexpr size_t STREAM_DATA_OFFSET = 4096;
+    static_assert(sizeof(StreamHeader) <= STREAM_DATA_OFFSET, "StreamHeader too large");
+
+    TeeStream(std::string path, void *base, size_t size)
+        : mPath(std::move(path))
+        , mBase(base)
+        , mSize(size)
+        , mHeader(static_cast<StreamHeader *>(base))
+        , mData(static_cast<uint8_t *>(base) + STREAM_DATA_OFFSET)
+        , mFrameSize(mHeader->frameSize)
+        , mFrameCapacity(mHeader->frameCapacity)
+    { }
+
+    ~TeeStream() {
+        (void)msync(mBase, mSize, MS_ASYNC);
+        (void)munmap(mBase, mSize);
+    }
+
+    void write(const void *buffer, size_t frameCount) {
+        uint64_t framesWritten = mHeader->framesWritten.load(std::memory_order_relaxed);
+        const uint8_t *src = static_cast<const uint8_t *>(buffer);
+        if (frameCount > mFrameCapacity) { // only the most recent frames are kept.
+            const size_t skip = frameCount - mFrameCapacity;
+            src += skip * mFrameSize;
+            framesWritten += skip;
+            frameCount = mFrameCapacity;
+        }
+        const size_t index = framesWritten % mFrameCapacity;
+        const size_t part1 = std::min(frameCount, mFrameCapacity - index);
+        memcpy(mData + index * mFrameSize, src, part1 * mFrameSize);
+        if (part1 < frameCount) {
+            memcpy(mData, src + part1 * mFrameSize, (frameCount - part1) * mFrameSize);
+        }
+        mHeader->framesWritten.store(framesWritten + frameCount, std::memory_order_release);
+    }
+
+    const std::string &path() const { return mPath; }
+    uint64_t framesWritten() const {
+        return mHeader->framesWritten.load(std::memory_order_acquire);
+    }
+    void flush() const { (void)msync(mBase, mSize, MS_ASYNC); }
+
+private:
+    const std::string mPath;
+    void * const mBase;
+    const size_t mSize;
+    StreamHeader * const mHeader;
+    uint8_t * const mData;
+    const size_t mFrameSize;
+    const size_t mFrameCapacity;
+};
+
+/* static */
+std::shared_ptr<NBAIO_Tee::NBAIO_TeeImpl::TeeStream> NBAIO_Tee::NBAIO_TeeImpl::makeStream(
+        const NBAIO_Format &format, size_t frames, const std::string &id)
+{
+    const size_t frameSize = Format_frameSize(format);
+    size_t size;
+    if (frameSize == 0 || frames == 0
+            || __builtin_mul_overflow(frames, frameSize, &size)
+            || __builtin_add_overflow(size, TeeStream::STREAM_DATA_OFFSET, &size)) {
+        return nullptr;
+    }
+
+    const std::string base = std::string(DEFAULT_DIRECTORY) + "/" + DEFAULT_PREFIX + "stream" + id;
+    const std::string path = base + ".raw";
+    // keep the previous ring (e.g. from before an audioserver restart) for inspection.
+    (void)rename(path.c_str(), (base + "_prev.raw").c_str());
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        ALOGW("%s: cannot open %s: %s", __func__, path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    }
+    const int error = errno;
+    (void)close(fd); // the mapping holds the file.
+    if (addr == MAP_FAILED) {
+        ALOGW("%s: cannot map %zu bytes for %s: %s",
+                __func__, size, path.c_str(), strerror(error));
+        (void)unlink(path.c_str());
+        return nullptr;
+    }
+
+    auto header = static_cast<TeeStream::StreamHeader *>(addr);
+    memcpy(header->magic, TeeStream::STREAM_MAGIC, sizeof(header->magic));
+    header->version = TeeStream::STREAM_VERSION;
+    header->dataOffset = TeeStream::STREAM_DATA_OFFSET;
+    header->sampleRate = Format_sampleRate(format);
+    header->channelCount = Format_channelCount(format);
+    header->format = format.mFormat;
+    header->frameSize = frameSize;
+    header->frameCapacity = frames;
+    header->framesWritten.store(0, std::memory_order_release);
+    ALOGV("%s: streaming %zu frames to %s", __func__, frames, path.c_str());
+    return std::make_shared<TeeStream>(path, addr, size);
+}
+
+/* static */
+void NBAIO_Tee::NBAIO_TeeImpl::writeStream(
+        TeeStream &stream, const void *buffer, size_t frameCount)
+{
+    stream.write(buffer, frameCount);
+}
+
+/* static */
+void NBAIO_Tee::NBAIO_TeeImpl::dumpStream(int fd, TeeStream &stream)
+{
+    stream.flush();
+    if (fd >= 0) {
+        dprintf(fd, "tee streaming to %s (%llu frames written)\n",
+                stream.path().c_str(), (unsigned long long)stream.framesWritten());
+    }
+}
+
 std::string AudioFileHandler::create(
         std::function<ssize_t /* frames_read */
                     (void * /* buffer */, size_t /* size_in_frames */)> reader,
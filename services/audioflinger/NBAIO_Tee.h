@@ -78,6 +78,17 @@ namespace android {
  * 2) The mechanism is on the AudioBufferProvider release() so large static Track
  *    playback may not show any Tee data depending on when it is released.
  * 3) When a track becomes inactive, the Thread will trigger a dump.
+ *
+ * Streaming:
+ * 1) If af.tee also has TEE_FLAG_STREAM set, Thread tees (not Track tees) write
+ *    continuously into a fixed size memory-mapped ring file instead of a Pipe,
+ *    "aftee_stream_ThreadId_X.raw" in the dump directory. The audio thread only
+ *    does a memcpy; the file always holds the most recent frames, so it can be
+ *    collected after the fact (including after an audioserver crash).
+ * 2) A previous ring file of the same name is kept as "..._prev.raw".
+ * 3) The file starts with a StreamHeader page (see NBAIO_Tee.cpp) giving the format,
+ *    ring capacity and total frames written; the ring data follows it.
+ * 4) dump() does not generate WAV files for streaming tees, it only reports the file.
  */
 
 class NBAIO_Tee {
@@ -90,6 +101,7 @@ public:
         TEE_FLAG_INPUT_THREAD = (1 << 0),  // treat as a Tee for input (Capture) Threads
         TEE_FLAG_OUTPUT_THREAD = (1 << 1), // treat as a Tee for output (Playback) Threads
         TEE_FLAG_TRACK = (1 << 2),         // treat as a Tee for tracks (Record and Playback)
+        TEE_FLAG_STREAM = (1 << 3),        // af.tee only: Thread tees stream to a mapped ring
     };
 
     NBAIO_Tee()
@@ -204,6 +216,25 @@ private:
 
             // TODO: should we check minimum number of frames?
 
+            // Thread tees stream to a file if so configured, the file is created once
+            // the id is known (see setId()).
+            if ((teeConfig & TEE_FLAG_STREAM) != 0
+                    && (type & (TEE_FLAG_INPUT_THREAD | TEE_FLAG_OUTPUT_THREAD)) != 0) {
+                if (!Format_isValid(format) || !audio_is_linear_pcm(format.mFormat)) {
+                    return BAD_VALUE;
+                }
+                std::lock_guard<std::mutex> _l(mLock);
+                if (mStreaming && Format_isEqual(format, mFormat) && frames == mFrames) {
+                    return NO_ERROR;
+                }
+                mStreaming = true;
+                mFlags = flags;
+                mFormat = format;
+                mFrames = frames;
+                mSinkSource = {};
+                return openStream_l();
+            }
+
             // don't do anything if format and frames are the same.
             if (Format_isEqual(format, mFormat) && frames == mFrames) {
                 return NO_ERROR;
@@ -217,6 +248,8 @@ private:
             // ongoing.
             if (enabled) {
                 std::lock_guard<std::mutex> _l(mLock);
+                mStreaming = false;
+                mStream.reset();
                 mFlags = flags;
                 mFormat = format; // could get this from the Sink.
                 mFrames = frames;
@@ -229,24 +262,40 @@ private:
 
         void setId(const std::string &id) {
             std::lock_guard<std::mutex> _l(mLock);
+            if (mId == id) return;
             mId = id;
+            if (mStreaming) {
+                // Note: as with set(), don't call setId() on a streaming Tee while
+                // write() is ongoing.
+                (void)openStream_l();
+            }
         }
 
         void dump(int fd, const std::string &reason) {
             if (!mDataReady.exchange(false)) return;
             std::string suffix;
             NBAIO_SinkSource sinkSource;
+            std::shared_ptr<TeeStream> stream;
             {
                 std::lock_guard<std::mutex> _l(mLock);
                 suffix = mId + reason;
                 sinkSource = mSinkSource;
+                stream = mStream;
+            }
+            if (stream != nullptr) {
+                dumpStream(fd, *stream);
+                return;
             }
             dumpTee(fd, sinkSource, suffix);
         }
 
         void write(const void *buffer, size_t frameCount) {
             if (!mEnabled.load() || frameCount == 0) return;
-            (void)mSinkSource.first->write(buffer, frameCount);
+            if (mStream != nullptr) {
+                writeStream(*mStream, buffer, frameCount);
+            } else {
+                (void)mSinkSource.first->write(buffer, frameCount);
+            }
             mDataReady.store(true);
         }
 
@@ -260,6 +309,26 @@ private:
         static NBAIO_SinkSource makeSinkSource(
                 const NBAIO_Format &format, size_t frames, bool *enabled);
 
+        // Memory-mapped ring file used in streaming mode, defined in NBAIO_Tee.cpp.
+        class TeeStream;
+
+        static std::shared_ptr<TeeStream> makeStream(
+                const NBAIO_Format &format, size_t frames, const std::string &id);
+        static void writeStream(TeeStream &stream, const void *buffer, size_t frameCount);
+        static void dumpStream(int fd, TeeStream &stream);
+
+        // (re)creates the stream file for the current format and id, if the id is set.
+        status_t openStream_l() {
+            mStream.reset(); // unmap any previous ring first.
+            if (mId.empty()) {
+                mEnabled.store(false);
+                return NO_ERROR; // deferred until setId().
+            }
+            mStream = makeStream(mFormat, mFrames, mId);
+            mEnabled.store(mStream != nullptr);
+            return mStream != nullptr ? NO_ERROR : BAD_VALUE;
+        }
+
         // 0x200000 stereo 16-bit PCM frames = 47.5 seconds at 44.1 kHz, 8 megabytes
         static constexpr size_t DEFAULT_TEE_FRAMES = 0x200000;
 
@@ -274,6 +343,8 @@ private:
         NBAIO_Format mFormat = Format_Invalid;                   // GUARDED_BY(mLock)
         size_t mFrames = 0;                                      // GUARDED_BY(mLock)
         NBAIO_SinkSource mSinkSource;                            // GUARDED_BY(mLock)
+        bool mStreaming = false;                                 // GUARDED_BY(mLock)
+        std::shared_ptr<TeeStream> mStream;                      // GUARDED_BY(mLock)
     };
 
     /** RunningTees tracks current running tees for dump purposes.
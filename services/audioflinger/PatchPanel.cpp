@@ -516,13 +516,24 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
                                                  frameCount,
                                                  inputFlags);
     } else {
-        // use a pseudo LCM between input and output framecount
-        int playbackShift = __builtin_ctz(playbackFrameCount);
-        int shift = __builtin_ctz(recordFrameCount);
-        if (playbackShift < shift) {
-            shift = playbackShift;
+        const size_t maxFrameCount = std::max(playbackFrameCount, recordFrameCount);
+        const size_t minFrameCount = std::min(playbackFrameCount, recordFrameCount);
+        if ((inputFlags & AUDIO_INPUT_FLAG_FAST) && (outputFlags & AUDIO_OUTPUT_FLAG_FAST)
+                && minFrameCount != 0 && maxFrameCount % minFrameCount == 0) {
+            // Both ends are fast and their periods are aligned: every period of the slower
+            // thread is a whole number of periods of the faster one. The capture then only
+            // needs room for the period it is writing while the mixer drains the period it
+            // is reading, which avoids the extra latency of the pseudo LCM below.
+            frameCount = recordFrameCount + playbackFrameCount;
+        } else {
+            // use a pseudo LCM between input and output framecount
+            int playbackShift = __builtin_ctz(playbackFrameCount);
+            int shift = __builtin_ctz(recordFrameCount);
+            if (playbackShift < shift) {
+                shift = playbackShift;
+            }
+            frameCount = (playbackFrameCount * recordFrameCount) >> shift;
         }
-        frameCount = (playbackFrameCount * recordFrameCount) >> shift;
         ALOGV("%s() playframeCount %zu recordFrameCount %zu frameCount %zu",
             __func__, playbackFrameCount, recordFrameCount, frameCount);
 
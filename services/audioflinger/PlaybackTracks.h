@@ -179,7 +179,7 @@ public:
            // Fetch absolute numbers from AudioTrackShared as it counts
            // contiguous underruns as a one -- we want a consistent number.
            // TODO: isolate this counting into a class.
-           mTrackMetrics.logUnderruns(mAudioTrackServerProxy->getUnderrunCount(),
+           mTrackMetrics->logUnderruns(mAudioTrackServerProxy->getUnderrunCount(),
                    mAudioTrackServerProxy->getUnderrunFrames());
        }
     }
@@ -192,6 +192,12 @@ protected:
 
     DISALLOW_COPY_AND_ASSIGN(Track);
 
+    // start(), stop() and pause() with the PlaybackThread lock held (not TeePatches),
+    // used to apply a batch of controls under one lock.
+    status_t start_l(PlaybackThread *playbackThread);
+    void stop_l(PlaybackThread *playbackThread);
+    void pause_l(PlaybackThread *playbackThread);
+
     // AudioBufferProvider interface
     status_t getNextBuffer(AudioBufferProvider::Buffer* buffer) override;
     void releaseBuffer(AudioBufferProvider::Buffer* buffer) override;
@@ -326,6 +332,7 @@ public:
                                 audio_format_t format,
                                 audio_channel_mask_t channelMask,
                                 size_t frameCount,
+                                size_t minBufferSizeInFrames,
                                 uid_t uid);
     virtual             ~OutputTrack();
 
@@ -338,6 +345,17 @@ public:
             bool        isActive() const { return mActive; }
     const wp<ThreadBase>& thread() const { return mThread; }
 
+    /** Write-ahead currently allowed in frames, between minBufferSizeInFrames and frameCount. */
+            size_t      bufferSizeInFrames() const { return mClientProxy->getBufferSizeInFrames(); }
+            size_t      capacityInFrames() const { return mFrameCount; }
+    /**
+     * Adapts the write-ahead to the consumption observed since the last call, should be called
+     * before each write(). It grows by stepFrames as soon as the downstream thread underran,
+     * and shrinks by stepFrames after stableWrites writes without underrun during which the
+     * fill level never dropped below stepFrames, i.e. the last step of headroom was unused.
+     */
+            void        adaptBufferSize(size_t stepFrames, uint32_t stableWrites);
+
             void        copyMetadataTo(MetadataInserter& backInserter) const override;
     /** Set the metadatas of the upstream tracks. Thread safe. */
             void        setMetadatas(const SourceMetadatas& metadatas);
@@ -370,6 +388,12 @@ private:
     DuplicatingThread* const    mSourceThread; // for waitTimeMs() in write()
     sp<AudioTrackClientProxy>   mClientProxy;
 
+    // State of adaptBufferSize(), only accessed by the duplicating thread.
+    const size_t                mMinBufferSizeInFrames;
+    uint32_t                    mObservedUnderrunCount = 0;
+    uint32_t                    mStableWrites = 0;
+    size_t                      mMinFramesFilled = SIZE_MAX;  // since mStableWrites was reset
+
     /** Attributes of the source tracks.
      *
      * This member must be accessed with mTrackMetadatasMutex taken.
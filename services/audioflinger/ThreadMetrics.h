@@ -17,8 +17,11 @@
 #ifndef ANDROID_AUDIO_THREADMETRICS_H
 #define ANDROID_AUDIO_THREADMETRICS_H
 
+#include <atomic>
 #include <mutex>
 
+#include "MetricsReporter.h"
+
 namespace android {
 
 /**
@@ -31,22 +34,35 @@ namespace android {
  * as this class only executes external one-way calls in Mediametrics and does not
  * call any other AudioFlinger class.
  *
+ * The per-cycle calls from the audio thread (logUnderrunFrames(), logThrottleMs(),
+ * logLatency()) do not lock, allocate, or build items: they only update
+ * RtCounters, which the MetricsReporter thread submits in report().
+ *
  * Terminology:
  * An AudioInterval is a contiguous playback segment.
  * An AudioIntervalGroup is a group of continuous playback segments on the same device.
  *
  * We currently deliver metrics based on an AudioIntervalGroup.
  */
-class ThreadMetrics final {
+class ThreadMetrics final : public MetricsReporter::Client {
 public:
+    // Creates the metrics and registers them with the MetricsReporter.
+    static std::shared_ptr<ThreadMetrics> create(std::string metricsId, bool isOut) {
+        auto metrics = std::make_shared<ThreadMetrics>(std::move(metricsId), isOut);
+        MetricsReporter::getInstance().add(metrics);
+        return metrics;
+    }
+
     ThreadMetrics(std::string metricsId, bool isOut)
         : mMetricsId(std::move(metricsId))
         , mIsOut(isOut)
         {}
 
+    // May run on the MetricsReporter thread, if a report() was in progress.
     ~ThreadMetrics() {
         logEndInterval(); // close any open interval groups
         std::lock_guard l(mLock);
+        collect_l();
         deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
         mediametrics::LogItem(mMetricsId)
             .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_DTOR)
@@ -61,6 +77,7 @@ public:
         // The devices we look for change depend on whether the Thread is input or output.
         const std::string& patchDevices = mIsOut ? mCreatePatchOutDevices : mCreatePatchInDevices;
         if (mDevices != patchDevices) {
+            collect_l();
             deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
             mDevices = patchDevices; // set after endAudioIntervalGroup
             resetIntervalGroupMetrics();
@@ -104,35 +121,87 @@ public:
         }
     }
 
-    void logThrottleMs(double throttleMs) const {
+    // Number of parallel resampling workers of the mixer, 0 when disabled.
+    void logResampleWorkers(int32_t workers) const {
         mediametrics::LogItem(mMetricsId)
-            // ms units always double
-            .set(AMEDIAMETRICS_PROP_THROTTLEMS, (double)throttleMs)
+            .set(AMEDIAMETRICS_PROP_RESAMPLEWORKERS, workers)
             .record();
     }
 
+    // Audio thread only, lock free.
+    void logThrottleMs(double throttleMs) {
+        mRt.throttleMs.store(throttleMs, std::memory_order_relaxed);
+        mRt.throttleSeq.fetch_add(1, std::memory_order_release);
+    }
+
+    // Audio thread only, lock free.
     void logLatency(double latencyMs) {
-        mediametrics::LogItem(mMetricsId)
-            .set(AMEDIAMETRICS_PROP_LATENCYMS, latencyMs)
-            .record();
-        std::lock_guard l(mLock);
-        mDeviceLatencyMs.add(latencyMs);
+        mRt.latencyMs.store(latencyMs, std::memory_order_relaxed);
+        mRt.latencySeq.fetch_add(1, std::memory_order_release);
     }
 
+    // Audio thread only (single writer), lock free.
     void logUnderrunFrames(size_t frames) {
-        std::lock_guard l(mLock);
-        if (mLastUnderrun == false && frames > 0) {
-            ++mUnderrunCount; // count non-continguous underrun sequences.
+        if (mRtLastUnderrun == false && frames > 0) {
+            // count non-continguous underrun sequences.
+            mRt.underrunCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        mRtLastUnderrun = (frames > 0);
+        if (frames > 0) {
+            mRt.underrunFrames.fetch_add(frames, std::memory_order_relaxed);
         }
-        mLastUnderrun = (frames > 0);
-        mUnderrunFrames += frames;
     }
 
     const std::string& getMetricsId() const {
         return mMetricsId;
     }
 
+    // MetricsReporter::Client
+    void report() override {
+        std::lock_guard l(mLock);
+        collect_l();
+    }
+
 private:
+    /**
+     * Fixed-layout counter block written by the audio thread without locks
+     * and read by collect_l().  Events are sequence numbered, the reporter submits
+     * the most recent value if the sequence advanced (intermediate values may be
+     * coalesced); counts are cumulative over the lifetime of the thread.
+     */
+    struct RtCounters {
+        std::atomic<int64_t>  underrunCount{0};
+        std::atomic<int64_t>  underrunFrames{0};
+        std::atomic<uint32_t> throttleSeq{0};
+        std::atomic<double>   throttleMs{0.};
+        std::atomic<uint32_t> latencySeq{0};
+        std::atomic<double>   latencyMs{0.};
+    };
+
+    // Submits the events and picks up the counters written by the audio thread.
+    void collect_l() REQUIRES(mLock) {
+        const uint32_t throttleSeq = mRt.throttleSeq.load(std::memory_order_acquire);
+        if (throttleSeq != mThrottleSeq) {
+            mThrottleSeq = throttleSeq;
+            mediametrics::LogItem(mMetricsId)
+                // ms units always double
+                .set(AMEDIAMETRICS_PROP_THROTTLEMS,
+                        mRt.throttleMs.load(std::memory_order_relaxed))
+                .record();
+        }
+        const uint32_t latencySeq = mRt.latencySeq.load(std::memory_order_acquire);
+        if (latencySeq != mLatencySeq) {
+            mLatencySeq = latencySeq;
+            const double latencyMs = mRt.latencyMs.load(std::memory_order_relaxed);
+            mediametrics::LogItem(mMetricsId)
+                .set(AMEDIAMETRICS_PROP_LATENCYMS, latencyMs)
+                .record();
+            mDeviceLatencyMs.add(latencyMs);
+        }
+        mUnderrunCount = mRt.underrunCount.load(std::memory_order_relaxed);
+        mUnderrunFrames = mRt.underrunFrames.load(std::memory_order_relaxed);
+    }
+
     // no lock required - all arguments and constants.
     void deliverDeviceMetrics(const char *eventName, const char *devices) const {
         mediametrics::LogItem(mMetricsId)
@@ -152,9 +221,11 @@ private:
             if (mDeviceLatencyMs.getN() > 0) {
                 item.set(AMEDIAMETRICS_PROP_DEVICELATENCYMS, mDeviceLatencyMs.getMean());
             }
-            if (mUnderrunCount > 0) {
-                item.set(AMEDIAMETRICS_PROP_UNDERRUN, (int32_t)mUnderrunCount)
-                    .set(AMEDIAMETRICS_PROP_UNDERRUNFRAMES, (int64_t)mUnderrunFrames);
+            if (mUnderrunCount > mUnderrunCountSinceIntervalGroup) {
+                item.set(AMEDIAMETRICS_PROP_UNDERRUN,
+                        (int32_t)(mUnderrunCount - mUnderrunCountSinceIntervalGroup))
+                    .set(AMEDIAMETRICS_PROP_UNDERRUNFRAMES,
+                        (int64_t)(mUnderrunFrames - mUnderrunFramesSinceIntervalGroup));
             }
             item.record();
         }
@@ -170,9 +241,9 @@ private:
 
         mDeviceLatencyMs.reset();
 
-        mLastUnderrun = false;
-        mUnderrunCount = 0;
-        mUnderrunFrames = 0;
+        // the underrun counters keep running, mLastUnderrun is owned by the audio thread.
+        mUnderrunCountSinceIntervalGroup = mUnderrunCount;
+        mUnderrunFramesSinceIntervalGroup = mUnderrunFrames;
     }
 
     const std::string mMetricsId;
@@ -194,10 +265,19 @@ private:
     // latency and startup for each interval.
     audio_utils::Statistics<double> mDeviceLatencyMs GUARDED_BY(mLock);
 
-    // underrun count and frames
-    bool              mLastUnderrun GUARDED_BY(mLock) = false; // checks consecutive underruns
+    // underrun count and frames, as of the last collect_l()
     int64_t           mUnderrunCount GUARDED_BY(mLock) = 0;    // number of consecutive underruns
     int64_t           mUnderrunFrames GUARDED_BY(mLock) = 0;   // total estimated frames underrun
+    int64_t           mUnderrunCountSinceIntervalGroup GUARDED_BY(mLock) = 0;
+    int64_t           mUnderrunFramesSinceIntervalGroup GUARDED_BY(mLock) = 0;
+
+    // last event sequence numbers submitted by collect_l()
+    uint32_t          mThrottleSeq GUARDED_BY(mLock) = 0;
+    uint32_t          mLatencySeq GUARDED_BY(mLock) = 0;
+
+    // audio thread state
+    RtCounters        mRt;
+    bool              mRtLastUnderrun = false;                 // checks consecutive underruns
 };
 
 } // namespace android
@@ -88,6 +88,7 @@
 #include "AutoPark.h"
 
 #include <pthread.h>
+#include <sched.h>
 #include "TypedLogger.h"
 
 // ----------------------------------------------------------------------------
@@ -153,6 +154,13 @@ static const uint32_t kMinNormalCaptureBufferSizeMs = 12;
 // Offloaded output thread standby delay: allows track transition without going to standby
 static const nsecs_t kOffloadStandbyDelayNs = seconds(1);
 
+// Maximum number of HAL buffers of compressed data an offloaded output thread gathers before
+// writing them at once. The actual count is set by ro.audio.offload_batch_buffers, default 1.
+static const size_t kMaxOffloadBatchBuffers = 16;
+
+// Upper bound of the time gathered compressed data is held back, whatever the HAL latency.
+static const nsecs_t kMaxOffloadBatchHoldNs = milliseconds(500);
+
 // Direct output thread minimum sleep time in idle or active(underrun) state
 static const nsecs_t kDirectMinSleepTimeUs = 10000;
 
@@ -191,6 +199,15 @@ static const enum {
 static const int kPriorityAudioApp = 2;
 static const int kPriorityFastMixer = 3;
 static const int kPriorityFastCapture = 3;
+static const int kPriorityResampleWorker = 2;
+
+// Parallel resampling in the normal mixer is disabled by default. It is configured with
+// af.mixer.resample_workers (number of worker threads) and applies to the outputs whose
+// flags intersect af.mixer.resample_worker_flags. If af.mixer.resample_worker_cpus is a
+// non-zero CPU mask, worker i is pinned to the i-th CPU of the mask (wrapping around).
+static const audio_output_flags_t kDefaultResampleWorkerFlags = (audio_output_flags_t)
+        (AUDIO_OUTPUT_FLAG_PRIMARY | AUDIO_OUTPUT_FLAG_DEEP_BUFFER);
+static const int kMaxResampleWorkers = 4;
 
 // IAudioFlinger::createTrack() has an in/out parameter 'pFrameCount' for the total size of the
 // track buffer in shared memory.  Zero on input means to use a default value.  For fast tracks,
@@ -498,8 +515,8 @@ AudioFlinger::ThreadBase::ThreadBase(const sp<AudioFlinger>& audioFlinger, audio
     :   Thread(false /*canCallJava*/),
         mType(type),
         mAudioFlinger(audioFlinger),
-        mThreadMetrics(std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_THREAD) + std::to_string(id),
-               isOut),
+        mThreadMetrics(ThreadMetrics::create(
+               std::string(AMEDIAMETRICS_KEY_PREFIX_AUDIO_THREAD) + std::to_string(id), isOut)),
         mIsOut(isOut),
         // mSampleRate, mFrameCount, mChannelMask, mChannelCount, mFrameSize, mFormat, mBufferSize
         // are set by PlaybackThread::readOutputParameters_l() or
@@ -512,7 +529,7 @@ AudioFlinger::ThreadBase::ThreadBase(const sp<AudioFlinger>& audioFlinger, audio
         mSystemReady(systemReady),
         mSignalPending(false)
 {
-    mThreadMetrics.logConstructor(getpid(), threadTypeToString(type), id);
+    mThreadMetrics->logConstructor(getpid(), threadTypeToString(type), id);
     memset(&mPatch, 0, sizeof(struct audio_patch));
 }
 
@@ -1818,10 +1835,29 @@ void AudioFlinger::ThreadBase::sendStatistics(bool force)
         item->setDouble(MM_PREFIX "latencyMs.mean", mLatencyMs.getMean());
         item->setDouble(MM_PREFIX "latencyMs.std", mLatencyMs.getStdDev());
     }
+    addFastThreadStatistics(item.get());
 
     item->selfrecord();
 }
 
+// Adds the cumulative per-cycle histograms of a fast thread, read from its dump state
+// without synchronizing with the fast thread. See FastThreadHistogram for the bins.
+static void addFastThreadHistograms(
+        mediametrics::Item *item, const FastThreadDumpState& dumpState)
+{
+#ifdef FAST_THREAD_STATISTICS
+    item->setCString(MM_PREFIX "fast.cycleUs.log2Histogram",
+            dumpState.mMonotonicHistogram.toString().c_str());
+    item->setCString(MM_PREFIX "fast.cpuUs.log2Histogram",
+            dumpState.mLoadHistogram.toString().c_str());
+    item->setCString(MM_PREFIX "fast.ioUs.log2Histogram",
+            dumpState.mIoHistogram.toString().c_str());
+#else
+    (void)item;
+    (void)dumpState;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 //      Playback
 // ----------------------------------------------------------------------------
@@ -1919,7 +1955,19 @@ AudioFlinger::PlaybackThread::~PlaybackThread()
     mAudioFlinger->unregisterWriter(mNBLogWriter);
     free(mSinkBuffer);
     free(mMixerBuffer);
-    free(mEffectBuffer);
+    freeEffectBuffer();
+}
+
+void AudioFlinger::PlaybackThread::freeEffectBuffer()
+{
+    // Effect chains may still reference mEffectBufferHal, which then keeps the memory
+    // valid until they are given a new buffer.
+    if (mEffectBufferHal != 0) {
+        mEffectBufferHal.clear();
+    } else {
+        free(mEffectBuffer);
+    }
+    mEffectBuffer = NULL;
 }
 
 // Thread virtuals
@@ -2846,7 +2894,14 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
     mSinkBuffer = NULL;
     // For sink buffer size, we use the frame size from the downstream sink to avoid problems
     // with non PCM formats for compressed music, e.g. AAC, and Offload threads.
-    const size_t sinkBufferSize = mNormalFrameCount * mFrameSize;
+    // Offloaded compressed data may be gathered over several HAL buffers and written at once,
+    // see OffloadThread::threadLoop_mix().
+    mSinkBufferBatchCount = 1;
+    if (mType == OFFLOAD && !audio_has_proportional_frames(mFormat)) {
+        mSinkBufferBatchCount = std::min(kMaxOffloadBatchBuffers, (size_t)std::max(1,
+                property_get_int32("ro.audio.offload_batch_buffers", 1 /* default_value */)));
+    }
+    const size_t sinkBufferSize = mNormalFrameCount * mFrameSize * mSinkBufferBatchCount;
     (void)posix_memalign(&mSinkBuffer, 32, sinkBufferSize);
 
     // We resize the mMixerBuffer according to the requirements of the sink buffer which
@@ -2859,13 +2914,22 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
                 * audio_bytes_per_sample(mMixerBufferFormat);
         (void)posix_memalign(&mMixerBuffer, 32, mMixerBufferSize);
     }
-    free(mEffectBuffer);
-    mEffectBuffer = NULL;
+    freeEffectBuffer();
     if (mEffectBufferEnabled) {
         mEffectBufferFormat = EFFECT_BUFFER_FORMAT;
         mEffectBufferSize = mNormalFrameCount * mChannelCount
                 * audio_bytes_per_sample(mEffectBufferFormat);
-        (void)posix_memalign(&mEffectBuffer, 32, mEffectBufferSize);
+        // Prefer effect HAL memory, which the global effect chains then process in place.
+        // A heap buffer would have to be mirrored, costing a copy into and out of HAL memory
+        // for every chain on every cycle.
+        if (mAudioFlinger->mEffectsFactoryHal != 0 &&
+                mAudioFlinger->mEffectsFactoryHal->allocateBuffer(
+                        mEffectBufferSize, &mEffectBufferHal) == OK) {
+            mEffectBuffer = mEffectBufferHal->audioBuffer()->raw;
+        } else {
+            mEffectBufferHal.clear();
+            (void)posix_memalign(&mEffectBuffer, 32, mEffectBufferSize);
+        }
     }
 
     mHapticChannelMask = mChannelMask & AUDIO_CHANNEL_HAPTIC_ALL;
@@ -2886,7 +2950,7 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
     }
 
     audio_output_flags_t flags = mOutput->flags;
-    mediametrics::LogItem item(mThreadMetrics.getMetricsId()); // TODO: method in ThreadMetrics?
+    mediametrics::LogItem item(mThreadMetrics->getMetricsId()); // TODO: method in ThreadMetrics?
     item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_READPARAMETERS)
         .set(AMEDIAMETRICS_PROP_ENCODING, formatToString(mFormat).c_str())
         .set(AMEDIAMETRICS_PROP_SAMPLERATE, (int32_t)mSampleRate)
@@ -2982,6 +3046,61 @@ uint32_t AudioFlinger::PlaybackThread::getStrategyForSession_l(audio_session_t s
     return AudioSystem::getStrategyForStream(AUDIO_STREAM_MUSIC);
 }
 
+sp<AudioFlinger::PlaybackThread::Track> AudioFlinger::PlaybackThread::getExternalTrackByPortId(
+        audio_port_handle_t portId)
+{
+    Mutex::Autolock _l(mLock);
+    for (size_t i = 0; i < mTracks.size(); i++) {
+        sp<Track> track = mTracks[i];
+        if (track->portId() == portId && track->isExternalTrack()) {
+            return track;
+        }
+    }
+    return nullptr;
+}
+
+void AudioFlinger::PlaybackThread::controlTracks(IAudioFlinger::track_control_t control,
+        const std::vector<std::pair<size_t, sp<Track>>>& tracks, std::vector<status_t> *statuses)
+{
+    std::vector<sp<Track>> controlled;
+    {
+        // Note: start_l() releases the lock around AudioSystem::startOutput() for tracks
+        // not yet active, so a mix cycle may still run between two such starts.
+        Mutex::Autolock _l(mLock);
+        for (const auto& [index, track] : tracks) {
+            status_t status = NO_ERROR;
+            switch (control) {
+            case IAudioFlinger::TRACK_CONTROL_START:
+                status = track->start_l(this);
+                break;
+            case IAudioFlinger::TRACK_CONTROL_STOP:
+                track->stop_l(this);
+                break;
+            case IAudioFlinger::TRACK_CONTROL_PAUSE:
+                track->pause_l(this);
+                break;
+            }
+            (*statuses)[index] = status;
+            if (status == NO_ERROR) {
+                controlled.push_back(track);
+            }
+        }
+    }
+    // TeePatches are on other threads, as in Track::start(), stop() and pause().
+    for (const auto& track : controlled) {
+        switch (control) {
+        case IAudioFlinger::TRACK_CONTROL_START:
+            track->forEachTeePatchTrack([](auto patchTrack) { patchTrack->start(); });
+            break;
+        case IAudioFlinger::TRACK_CONTROL_STOP:
+            track->forEachTeePatchTrack([](auto patchTrack) { patchTrack->stop(); });
+            break;
+        case IAudioFlinger::TRACK_CONTROL_PAUSE:
+            track->forEachTeePatchTrack([](auto patchTrack) { patchTrack->pause(); });
+            break;
+        }
+    }
+}
 
 AudioStreamOut* AudioFlinger::PlaybackThread::getOutput() const
 {
@@ -3106,12 +3225,29 @@ ssize_t AudioFlinger::PlaybackThread::threadLoop_write()
                         (pipe->maxFrames() * 7) / 8 : mNormalFrameCount * 2);
             }
         }
-        ssize_t framesWritten = mNormalSink->write((char *)mSinkBuffer + offset, count);
+        const char *sinkBuffer = (char *)mSinkBuffer;
+        ssize_t framesWritten;
+        if (mHalSinkBuffer != nullptr) {
+            // the data already is in the HAL buffer, only publish it
+            sinkBuffer = (char *)mHalSinkBuffer;
+            mHalSinkBuffer = nullptr;
+            framesWritten = static_cast<AudioStreamOutSink *>(mOutputSink.get())
+                    ->commitWriteBuffer(count);
+            if (framesWritten >= 0 && (size_t)framesWritten < count) {
+                // The HAL buffer remains valid until our next write, so move what the HAL
+                // did not take to mSinkBuffer for the following write() calls.
+                const size_t writtenBytes = framesWritten * mFrameSize;
+                memcpy((char *)mSinkBuffer + offset + writtenBytes,
+                        sinkBuffer + offset + writtenBytes, mBytesRemaining - writtenBytes);
+            }
+        } else {
+            framesWritten = mNormalSink->write(sinkBuffer + offset, count);
+        }
         ATRACE_END();
         if (framesWritten > 0) {
             bytesWritten = framesWritten * mFrameSize;
 #ifdef TEE_SINK
-            mTee.write((char *)mSinkBuffer + offset, framesWritten);
+            mTee.write(sinkBuffer + offset, framesWritten);
 #endif
         } else {
             bytesWritten = framesWritten;
@@ -3145,12 +3281,35 @@ ssize_t AudioFlinger::PlaybackThread::threadLoop_write()
     mNumWrites++;
     mInWrite = false;
     if (mStandby) {
-        mThreadMetrics.logBeginInterval();
+        mThreadMetrics->logBeginInterval();
         mStandby = false;
     }
     return bytesWritten;
 }
 
+void *AudioFlinger::PlaybackThread::obtainSinkBuffer()
+{
+    mHalSinkBuffer = nullptr;
+    // Only for a blocking write of a whole cycle by the normal mixer straight to the HAL,
+    // i.e. no fast mixer pipe, no partial write pending, and not simulating writes.
+    if (!mHalSinkBufferSupported || mOutputSink == 0 || mNormalSink != mOutputSink
+            || mCurrentWriteLength != mSinkBufferSize || isSuspended()) {
+        return mSinkBuffer;
+    }
+    void *buffer;
+    const status_t status = static_cast<AudioStreamOutSink *>(mOutputSink.get())
+            ->obtainWriteBuffer(mNormalFrameCount, &buffer);
+    if (status == OK) {
+        mHalSinkBuffer = buffer;
+        return buffer;
+    }
+    if (status == INVALID_OPERATION) {
+        ALOGV("%s(%d): zero-copy writes not supported", __func__, mId);
+        mHalSinkBufferSupported = false;
+    }
+    return mSinkBuffer;
+}
+
 void AudioFlinger::PlaybackThread::threadLoop_drain()
 {
     bool supportsDrain = false;
@@ -3245,13 +3404,20 @@ status_t AudioFlinger::PlaybackThread::addEffectChain_l(const sp<EffectChain>& c
 {
     audio_session_t session = chain->sessionId();
     sp<EffectBufferHalInterface> halInBuffer, halOutBuffer;
-    status_t result = mAudioFlinger->mEffectsFactoryHal->mirrorBuffer(
-            mEffectBufferEnabled ? mEffectBuffer : mSinkBuffer,
-            mEffectBufferEnabled ? mEffectBufferSize : mSinkBufferSize,
-            &halInBuffer);
-    if (result != OK) return result;
+    if (mEffectBufferEnabled && mEffectBufferHal != 0) {
+        // mEffectBuffer already is HAL memory: no mirror, update() and commit() are no-ops.
+        halInBuffer = mEffectBufferHal;
+    } else {
+        status_t result = mAudioFlinger->mEffectsFactoryHal->mirrorBuffer(
+                mEffectBufferEnabled ? mEffectBuffer : mSinkBuffer,
+                mEffectBufferEnabled ? mEffectBufferSize : mSinkBufferSize,
+                &halInBuffer);
+        if (result != OK) return result;
+    }
     halOutBuffer = halInBuffer;
-    effect_buffer_t *buffer = reinterpret_cast<effect_buffer_t*>(halInBuffer->externalData());
+    effect_buffer_t *buffer = reinterpret_cast<effect_buffer_t*>(
+            halInBuffer->externalData() != nullptr
+                    ? halInBuffer->externalData() : halInBuffer->audioBuffer()->raw);
     ALOGV("addEffectChain_l() %p on thread %p for session %d", chain.get(), this, session);
     if (!audio_is_global_session(session)) {
         // Only one effect chain can be present in direct output thread and it uses
@@ -3686,7 +3852,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                     // This is where we go into standby
                     if (!mStandby) {
                         LOG_AUDIO_STATE();
-                        mThreadMetrics.logEndInterval();
+                        mThreadMetrics->logEndInterval();
                         mStandby = true;
                     }
                     sendStatistics(false /* force */);
@@ -3756,7 +3922,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             activeTracks.insert(activeTracks.end(), mActiveTracks.begin(), mActiveTracks.end());
         } // mLock scope ends
 
-        if (mBytesRemaining == 0) {
+        // false while the HAL has yet to take the rest of the previous cycle.
+        const bool newCycle = mBytesRemaining == 0;
+        if (newCycle) {
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
                 // threadLoop_mix() sets mCurrentWriteLength
@@ -3793,8 +3961,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             //
             // mMixerBufferValid is only set true by MixerThread::prepareTracks_l().
             // TODO use mSleepTimeUs == 0 as an additional condition.
+            mHalSinkBuffer = nullptr;
             if (mMixerBufferValid) {
-                void *buffer = mEffectBufferValid ? mEffectBuffer : mSinkBuffer;
+                void *buffer = mEffectBufferValid ? mEffectBuffer : obtainSinkBuffer();
                 audio_format_t format = mEffectBufferValid ? mEffectBufferFormat : mFormat;
 
                 // mono blend occurs for mixer threads only (not direct or offloaded)
@@ -3887,15 +4056,21 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                 mBalance.process((float *)mEffectBuffer, mNormalFrameCount);
             }
 
-            memcpy_by_audio_format(mSinkBuffer, mFormat, mEffectBuffer, mEffectBufferFormat,
-                    mNormalFrameCount * (mChannelCount + mHapticChannelCount));
-            // The sample data is partially interleaved when haptic channels exist,
-            // we need to adjust channels here.
-            if (mHapticChannelCount > 0) {
-                adjust_channels_non_destructive(mSinkBuffer, mChannelCount, mSinkBuffer,
-                        mChannelCount + mHapticChannelCount,
-                        audio_bytes_per_sample(mFormat),
-                        audio_bytes_per_frame(mChannelCount, mFormat) * mNormalFrameCount);
+            // After a partial write, threadLoop_write() has moved the rest of the cycle to
+            // mSinkBuffer: converting again, or obtaining another HAL buffer, would replace
+            // frames not yet written. Only a new cycle fills the sink buffer.
+            if (newCycle) {
+                void *sinkBuffer = obtainSinkBuffer();
+                memcpy_by_audio_format(sinkBuffer, mFormat, mEffectBuffer, mEffectBufferFormat,
+                        mNormalFrameCount * (mChannelCount + mHapticChannelCount));
+                // The sample data is partially interleaved when haptic channels exist,
+                // we need to adjust channels here.
+                if (mHapticChannelCount > 0) {
+                    adjust_channels_non_destructive(sinkBuffer, mChannelCount, sinkBuffer,
+                            mChannelCount + mHapticChannelCount,
+                            audio_bytes_per_sample(mFormat),
+                            audio_bytes_per_frame(mChannelCount, mFormat) * mNormalFrameCount);
+                }
             }
         }
 
@@ -3992,7 +4167,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
                         const int32_t throttleMs = (int32_t)mHalfBufferMs - deltaMs;
                         if ((signed)mHalfBufferMs >= throttleMs && throttleMs > 0) {
-                            mThreadMetrics.logThrottleMs((double)throttleMs);
+                            mThreadMetrics->logThrottleMs((double)throttleMs);
 
                             usleep(throttleMs * 1000);
                             // notify of throttle start on verbose log
@@ -4269,9 +4444,9 @@ status_t AudioFlinger::PlaybackThread::createAudioPatch_l(const struct audio_pat
     }
     const std::string patchSinksAsString = patchSinksToString(patch);
 
-    mThreadMetrics.logEndInterval();
-    mThreadMetrics.logCreatePatch(/* inDevices */ {}, patchSinksAsString);
-    mThreadMetrics.logBeginInterval();
+    mThreadMetrics->logEndInterval();
+    mThreadMetrics->logCreatePatch(/* inDevices */ {}, patchSinksAsString);
+    mThreadMetrics->logBeginInterval();
     // also dispatch to active AudioTracks for MediaMetrics
     for (const auto &track : mActiveTracks) {
         track->logEndInterval();
@@ -4360,6 +4535,7 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    configureResampleWorkers();
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -4570,6 +4746,25 @@ uint32_t AudioFlinger::MixerThread::correctLatency_l(uint32_t latency) const
     return latency;
 }
 
+void AudioFlinger::MixerThread::addFastThreadStatistics(mediametrics::Item *item) const
+{
+    if (mFastMixer == 0) {
+        return;
+    }
+    addFastThreadHistograms(item, mFastMixerDumpState);
+#ifdef FAST_THREAD_STATISTICS
+    // bins beyond the configured maximum number of fast tracks are always empty
+    std::string underrunTracks;
+    for (size_t i = 0; i <= FastMixerState::sMaxFastTracks; ++i) {
+        if (i > 0) {
+            underrunTracks.append(",");
+        }
+        underrunTracks.append(std::to_string(mFastMixerDumpState.mUnderrunTracksHistogram[i]));
+    }
+    item->setCString(MM_PREFIX "fast.underrunTracksHistogram", underrunTracks.c_str());
+#endif
+}
+
 ssize_t AudioFlinger::MixerThread::threadLoop_write()
 {
     // FIXME we should only do one push per cycle; confirm this is true
@@ -4696,6 +4891,39 @@ void AudioFlinger::PlaybackThread::onAsyncError()
     }
 }
 
+void AudioFlinger::MixerThread::configureResampleWorkers()
+{
+    if (mType != MIXER) return;
+    const audio_output_flags_t flags = (audio_output_flags_t)property_get_int32(
+            "af.mixer.resample_worker_flags", kDefaultResampleWorkerFlags);
+    const int workers = (mOutput->flags & flags) != 0 ? std::clamp(
+            property_get_int32("af.mixer.resample_workers", 0), 0, kMaxResampleWorkers) : 0;
+    const uint64_t cpus = (uint64_t)property_get_int64("af.mixer.resample_worker_cpus", 0);
+
+    mAudioMixer->setResampleWorkers(workers, [cpus](pid_t tid, size_t index) {
+        const int err = requestPriority(getpid(), tid, kPriorityResampleWorker,
+                false /*isForApp*/, true /*asynchronous*/);
+        ALOGW_IF(err != 0, "Policy SCHED_FIFO priority %d is unavailable for resample worker"
+                " %d; error %d", kPriorityResampleWorker, tid, err);
+        if (cpus == 0) return;
+        const int cpuCount = __builtin_popcountll(cpus);
+        int nth = index % cpuCount;
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if ((cpus & (1ULL << cpu)) != 0 && nth-- == 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                if (sched_setaffinity(tid, sizeof(set), &set) != 0) {
+                    ALOGW("cannot pin resample worker %d to cpu %d: %s",
+                            tid, cpu, strerror(errno));
+                }
+                break;
+            }
+        }
+    });
+    mThreadMetrics->logResampleWorkers(workers);
+}
+
 void AudioFlinger::MixerThread::threadLoop_mix()
 {
     // mix buffers...
@@ -4806,13 +5034,26 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     FastMixerState *state = NULL;
     bool didModify = false;
     FastMixerStateQueue::block_t block = FastMixerStateQueue::BLOCK_UNTIL_PUSHED;
+    FastMixerCommandQueue *cq = NULL;
     bool coldIdle = false;
     if (mFastMixer != 0) {
         sq = mFastMixer->sq();
+        cq = mFastMixer->cq();
         state = sq->begin();
         coldIdle = state->mCommand == FastMixerState::COLD_IDLE;
     }
 
+    // Per-track fields of an already active fast track are sent as deltas through the
+    // command queue, which the fast mixer applies at the top of its next cycle, rather than
+    // by pushing a whole new state.  The mutated state is kept up to date as well, since it
+    // is what a newly added track is configured from; a full queue falls back to a push.
+    auto sendFastTrackCommand = [&](int j, FastMixerCommand::Kind kind, int32_t value) {
+        if (!(state->mTrackMask & (1 << j))
+                || !cq->push({kind, (uint8_t)j, value, state->mFastTracks[j].mGeneration})) {
+            didModify = true;
+        }
+    };
+
     mMixerBufferValid = false;  // mMixerBuffer has no valid data until appropriate tracks found.
     mEffectBufferValid = false; // mEffectBuffer has no valid data until tracks found.
 
@@ -4850,7 +5091,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         const mixer_state * const mMixerStatus;
         ThreadMetrics * const mThreadMetrics;
         std::vector<std::pair<sp<Track>, size_t>> mUnderrunFrames;
-    } deferredOperations(&mixerStatus, &mThreadMetrics);
+    } deferredOperations(&mixerStatus, mThreadMetrics.get());
     // implicit nested scope for variable capture
 
     bool noFastHapticTrack = true;
@@ -5051,7 +5292,13 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             }
             if (fastTrack->mHapticPlaybackEnabled != track->getHapticPlaybackEnabled()) {
                 fastTrack->mHapticPlaybackEnabled = track->getHapticPlaybackEnabled();
-                didModify = true;
+                sendFastTrackCommand(j, FastMixerCommand::HAPTIC_ENABLED,
+                        fastTrack->mHapticPlaybackEnabled);
+            }
+            if (isActive && fastTrack->mHapticIntensity != track->getHapticIntensity()) {
+                fastTrack->mHapticIntensity = track->getHapticIntensity();
+                sendFastTrackCommand(j, FastMixerCommand::HAPTIC_INTENSITY,
+                        fastTrack->mHapticIntensity);
             }
             continue;
         }
@@ -5401,7 +5648,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         FastTrack *fastTrack = &state->mFastTracks[0];
         if (fastTrack->mHapticPlaybackEnabled != noFastHapticTrack) {
             fastTrack->mHapticPlaybackEnabled = noFastHapticTrack;
-            didModify = true;
+            sendFastTrackCommand(0, FastMixerCommand::HAPTIC_ENABLED, noFastHapticTrack);
         }
     }
 
@@ -5590,7 +5837,7 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
         if (!mStandby && status == INVALID_OPERATION) {
             mOutput->standby();
             if (!mStandby) {
-                mThreadMetrics.logEndInterval();
+                mThreadMetrics->logEndInterval();
                 mStandby = true;
             }
             mBytesWritten = 0;
@@ -5600,6 +5847,7 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            configureResampleWorkers();
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 status_t status = mAudioMixer->create(
@@ -5626,6 +5874,7 @@ void AudioFlinger::MixerThread::dumpInternals_l(int fd, const Vector<String16>&
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    dprintf(fd, "  AudioMixer resample workers: %zu\n", mAudioMixer->getResampleWorkerCount());
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6102,7 +6351,7 @@ bool AudioFlinger::DirectOutputThread::checkForNewParameter_l(const String8& key
         if (!mStandby && status == INVALID_OPERATION) {
             mOutput->standby();
             if (!mStandby) {
-                mThreadMetrics.logEndInterval();
+                mThreadMetrics->logEndInterval();
                 mStandby = true;
             }
             mBytesWritten = 0;
@@ -6429,8 +6678,9 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
                 sp<Track> previousTrack = mPreviousTrack.promote();
                 if (previousTrack != 0) {
                     if (track != previousTrack.get()) {
-                        // Flush any data still being written from last track
+                        // Flush any data still being written or gathered from last track
                         mBytesRemaining = 0;
+                        mBatchedBytes = 0;
                         if (mPausedBytesRemaining) {
                             // Last track was paused so we also need to flush saved
                             // mixbuffer state and invalidate track so that it will
@@ -6459,6 +6709,13 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
                 mActiveTrack = t;
                 mixerStatus = MIXER_TRACKS_READY;
             }
+        } else if (last && mBatchedBytes != 0 && !track->isPaused()
+                && !track->isTerminated() && !track->isStopping_2()) {
+            // Frames of this track gathered for a batched write are still in the mixbuffer:
+            // let threadLoop_mix() write them before the track may be drained or disabled.
+            ALOGVV("OffloadThread: track(%d) s=%08x [BATCHED]", track->id(), cblk->mServer);
+            mActiveTrack = t;
+            mixerStatus = MIXER_TRACKS_READY;
         } else {
             ALOGVV("OffloadThread: track(%d) s=%08x [NOT READY]", track->id(), cblk->mServer);
             if (track->isStopping_1()) {
@@ -6576,6 +6833,79 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::OffloadThread::prepareTr
     return mixerStatus;
 }
 
+void AudioFlinger::OffloadThread::threadLoop_mix()
+{
+    if (mSinkBufferBatchCount <= 1) {
+        DirectOutputThread::threadLoop_mix();
+        return;
+    }
+
+    // Gather compressed data behind what is already held in the mixbuffer, so that the
+    // HAL, and the AP with it, can sleep over several of its buffers between writes.
+    const size_t batchBytes = mSinkBufferSize * mSinkBufferBatchCount;
+    if (mBatchedBytes == 0) {
+        uint32_t latencyMs = 0;
+        mBatchStartNs = systemTime();
+        // Never hold more back than half of what the HAL has queued ahead of presentation.
+        mBatchMaxHoldNs = mOutput->stream->getLatency(&latencyMs) == OK
+                ? std::min(kMaxOffloadBatchHoldNs, milliseconds(latencyMs) / 2) : 0;
+    }
+    size_t frameCount = (batchBytes - mBatchedBytes) / mFrameSize;
+    int8_t *curBuf = (int8_t *)mSinkBuffer + mBatchedBytes;
+    bool underrun = false;
+    while (frameCount) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = frameCount;
+        status_t status = mActiveTrack->getNextBuffer(&buffer);
+        if (status != NO_ERROR || buffer.raw == NULL) {
+            underrun = true;
+            break;
+        }
+        memcpy(curBuf, buffer.raw, buffer.frameCount * mFrameSize);
+        frameCount -= buffer.frameCount;
+        curBuf += buffer.frameCount * mFrameSize;
+        mActiveTrack->releaseBuffer(&buffer);
+    }
+    mBatchedBytes = curBuf - (int8_t *)mSinkBuffer;
+
+    if (shouldWriteBatch(mActiveTrack, underrun)) {
+        mCurrentWriteLength = mBatchedBytes;
+        mBatchedBytes = 0;
+        if (mCurrentWriteLength != 0) {
+            mBatchWrites++;
+        }
+        mSleepTimeUs = 0;
+    } else {
+        // keep gathering: nothing to write this cycle
+        mCurrentWriteLength = 0;
+        mSleepTimeUs = mActiveSleepTimeUs;
+    }
+    mStandbyTimeNs = systemTime() + mStandbyDelayNs;
+    mActiveTrack.clear();
+}
+
+bool AudioFlinger::OffloadThread::shouldWriteBatch(const sp<Track>& track, bool underrun)
+{
+    if (!underrun) {
+        return true; // batch is full
+    }
+    // Write what was gathered so far on start, so that playback begins without delay, and
+    // when the track stops, so that it can be drained. Otherwise the client has just not
+    // caught up yet, and the data is held until the HAL could run short of it.
+    return mStandby || mBytesWritten == 0 || track->isStopping_1() || track->isStopped()
+            || systemTime() - mBatchStartNs >= mBatchMaxHoldNs;
+}
+
+void AudioFlinger::OffloadThread::dumpInternals_l(int fd, const Vector<String16>& args)
+{
+    DirectOutputThread::dumpInternals_l(fd, args);
+    if (mSinkBufferBatchCount > 1) {
+        dprintf(fd, "  Offload batch: %zu buffers (%zu bytes)  batched: %zu bytes  writes: %lld\n",
+                mSinkBufferBatchCount, mSinkBufferSize * mSinkBufferBatchCount, mBatchedBytes,
+                (long long)mBatchWrites);
+    }
+}
+
 // must be called with thread mutex locked
 bool AudioFlinger::OffloadThread::waitingAsyncCallback_l()
 {
@@ -6601,6 +6931,7 @@ void AudioFlinger::OffloadThread::flushHw_l()
     mBytesRemaining = 0;
     mPausedWriteLength = 0;
     mPausedBytesRemaining = 0;
+    mBatchedBytes = 0;
     // reset bytes written count to reflect that DSP buffers are empty after flush.
     mBytesWritten = 0;
     mOffloadUnderrunPosition = ~0LL;
@@ -6629,7 +6960,12 @@ AudioFlinger::DuplicatingThread::DuplicatingThread(const sp<AudioFlinger>& audio
         AudioFlinger::MixerThread* mainThread, audio_io_handle_t id, bool systemReady)
     :   MixerThread(audioFlinger, mainThread->getOutput(), id,
                     systemReady, DUPLICATING),
-        mWaitTimeMs(UINT_MAX)
+        mWaitTimeMs(UINT_MAX),
+        mMaxWriteAheadMs((uint32_t)std::max(0, property_get_int32(
+                "af.duplicating.max_write_ahead_ms", kDefaultMaxWriteAheadMs))),
+        // number of our mix periods in kWriteAheadStableMs, at least one
+        mWriteAheadStableWrites((uint32_t)std::max((uint64_t)1,
+                (uint64_t)kWriteAheadStableMs * mSampleRate / (1000 * mNormalFrameCount)))
 {
     addOutputTrack(mainThread);
 }
@@ -6682,6 +7018,11 @@ void AudioFlinger::DuplicatingThread::threadLoop_sleepTime()
 ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 {
     for (size_t i = 0; i < outputTracks.size(); i++) {
+        // Raise the write-ahead of a downstream output that underran and lower it when unused,
+        // so that deep buffer outputs are not kept fuller, nor woken more often, than needed.
+        if (writeFrames != 0) {
+            outputTracks[i]->adaptBufferSize(mNormalFrameCount, mWriteAheadStableWrites);
+        }
         const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
 
         // Consider the first OutputTrack for timestamp and frame counting.
@@ -6700,7 +7041,7 @@ ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
         // TODO: Report correction for the other output tracks and show in the dump.
     }
     if (mStandby) {
-        mThreadMetrics.logBeginInterval();
+        mThreadMetrics->logBeginInterval();
         mStandby = false;
     }
     return (ssize_t)mSinkBufferSize;
@@ -6731,7 +7072,8 @@ void AudioFlinger::DuplicatingThread::dumpInternals_l(int fd, const Vector<Strin
             } else {
                 ss << "null";
             }
-            ss << ")";
+            ss << ", write-ahead " << track->bufferSizeInFrames() << "/" << track->capacityInFrames()
+                    << ")";
         }
     }
     ss << "\n";
@@ -6755,8 +7097,12 @@ void AudioFlinger::DuplicatingThread::addOutputTrack(MixerThread *thread)
     // The downstream MixerThread consumes thread->frameCount() amount of frames per mix pass.
     // Adjust for thread->sampleRate() to determine minimum buffer frame count.
     // Then triple buffer because Threads do not run synchronously and may not be clock locked.
-    const size_t frameCount =
+    const size_t minFrameCount =
             3 * sourceFramesNeeded(mSampleRate, thread->frameCount(), thread->sampleRate());
+    // The write-ahead starts at the minimum and adapts to the observed consumption,
+    // see OutputTrack::adaptBufferSize(), up to the configured latency ceiling.
+    const size_t frameCount = std::max(minFrameCount,
+            (size_t)((uint64_t)mMaxWriteAheadMs * mSampleRate / 1000));
     // TODO: Consider asynchronous sample rate conversion to handle clock disparity
     // from different OutputTracks and their associated MixerThreads (e.g. one may
     // nearly empty and the other may be dropping data).
@@ -6767,6 +7113,7 @@ void AudioFlinger::DuplicatingThread::addOutputTrack(MixerThread *thread)
                                             mFormat,
                                             mChannelMask,
                                             frameCount,
+                                            minFrameCount,
                                             IPCThreadState::self()->getCallingUid());
     status_t status = outputTrack != 0 ? outputTrack->initCheck() : (status_t) NO_MEMORY;
     if (status != NO_ERROR) {
@@ -7155,7 +7502,7 @@ reacquire_wakelock:
                 case TrackBase::STARTING_2:
                     doBroadcast = true;
                     if (mStandby) {
-                        mThreadMetrics.logBeginInterval();
+                        mThreadMetrics->logBeginInterval();
                         mStandby = false;
                     }
                     activeTrack->mState = TrackBase::ACTIVE;
@@ -7292,6 +7639,8 @@ reacquire_wakelock:
         // now run the fast track destructor with thread mutex unlocked
         fastTrackToRemove.clear();
 
+        updateSharedConversions(activeTracks);
+
         // Read from HAL to keep up with fastest client if multiple active tracks, not slowest one.
         // Only the client(s) that are too slow will overrun. But if even the fastest client is too
         // slow, then this RecordThread will overrun by not calling HAL read often enough.
@@ -7436,6 +7785,11 @@ reacquire_wakelock:
         }
         rear = mRsmpInRear += framesRead;
 
+        // convert once for the tracks sharing a conversion
+        for (const auto& conversion : mSharedConversions) {
+            conversion->process();
+        }
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -7450,6 +7804,8 @@ reacquire_wakelock:
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
+            SharedConversion * const sharedConversion = sharedConversionOf(activeTrack.get());
+
             enum {
                 OVERRUN_UNKNOWN,
                 OVERRUN_TRUE,
@@ -7468,7 +7824,14 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                if (sharedConversion != nullptr) {
+                    // frames already converted for this track are copied straight away
+                    hasOverrun = false;
+                    framesIn = framesOut == 0 ? 0 : sharedConversion->read(
+                            activeTrack.get(), activeTrack->mSink.raw, framesOut, &hasOverrun);
+                } else {
+                    activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -7477,14 +7840,19 @@ reacquire_wakelock:
                 }
 
                 // Don't allow framesOut to be larger than what is possible with resampling
-                // from framesIn.
+                // from framesIn. A shared conversion already returns converted frames.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                framesOut = min(framesOut,
-                        destinationFramesPossible(
-                                framesIn, mSampleRate, activeTrack->mSampleRate));
+                if (sharedConversion == nullptr) {
+                    framesOut = min(framesOut,
+                            destinationFramesPossible(
+                                    framesIn, mSampleRate, activeTrack->mSampleRate));
+                }
 
-                if (activeTrack->isDirect()) {
+                if (sharedConversion != nullptr) {
+                    // the shared conversion has already copied framesIn frames to the sink
+                    framesOut = framesIn;
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -7623,7 +7991,7 @@ void AudioFlinger::RecordThread::standbyIfNotAlreadyInStandby()
 {
     if (!mStandby) {
         inputStandBy();
-        mThreadMetrics.logEndInterval();
+        mThreadMetrics->logEndInterval();
         mStandby = true;
     }
 }
@@ -7991,6 +8359,13 @@ bool AudioFlinger::RecordThread::stop(RecordThread::RecordTrack* recordTrack) {
     return false;
 }
 
+void AudioFlinger::RecordThread::addFastThreadStatistics(mediametrics::Item *item) const
+{
+    if (mFastCapture != 0) {
+        addFastThreadHistograms(item, mFastCaptureDumpState);
+    }
+}
+
 bool AudioFlinger::RecordThread::isValidSyncEvent(const sp<SyncEvent>& event __unused) const
 {
     return false;
@@ -8105,6 +8480,7 @@ void AudioFlinger::RecordThread::dumpInternals_l(int fd, const Vector<String16>&
 
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
+    dprintf(fd, "  Tracks sharing a conversion: %zu\n", mSharedConversionTracks.load());
 
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
@@ -8170,9 +8546,16 @@ void AudioFlinger::RecordThread::setRecordSilenced(audio_port_handle_t portId, b
     }
 }
 
+AudioFlinger::RecordThread::ResamplerBufferProvider::ResamplerBufferProvider(
+        RecordTrack* recordTrack) :
+    mThread(recordTrack->mThread),
+    mRsmpInUnrel(0), mRsmpInFront(0)
+{
+}
+
 void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     mRsmpInFront = recordThread->mRsmpInRear;
     mRsmpInUnrel = 0;
@@ -8181,7 +8564,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
         size_t *framesAvailable, bool *hasOverrun)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     const int32_t rear = recordThread->mRsmpInRear;
     const int32_t front = mRsmpInFront;
@@ -8215,7 +8598,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
 status_t AudioFlinger::RecordThread::ResamplerBufferProvider::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     if (threadBase == 0) {
         buffer->frameCount = 0;
         buffer->raw = NULL;
@@ -8268,6 +8651,216 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+AudioFlinger::RecordThread::SharedConversion::SharedConversion(
+        RecordThread* recordThread, RecordTrack* donor) :
+    mRecordThread(recordThread),
+    mFormat(donor->format()),
+    mChannelMask(donor->channelMask()),
+    mSampleRate(donor->sampleRate()),
+    mFrameSize(donor->frameSize()),
+    mRecordBufferConverter(donor->mRecordBufferConverter),
+    mResamplerBufferProvider(recordThread),
+    // hold as much converted data as the RecordThread data buffer holds input.
+    mFramesP2(roundup(destinationFramesPossible(
+            recordThread->mRsmpInFrames, recordThread->mSampleRate, mSampleRate)))
+{
+    // Continue the conversion of the donor where it is, and leave it a spare converter
+    // for when it converts privately again.
+    donor->mRecordBufferConverter = new RecordBufferConverter(
+            recordThread->mChannelMask, recordThread->mFormat, recordThread->mSampleRate,
+            mChannelMask, mFormat, mSampleRate);
+    mResamplerBufferProvider.setPosition(*donor->mResamplerBufferProvider);
+    (void)posix_memalign(&mBuffer, 32, mFramesP2 * mFrameSize);
+    addMember(donor);
+}
+
+AudioFlinger::RecordThread::SharedConversion::~SharedConversion()
+{
+    free(mBuffer);
+    delete mRecordBufferConverter;
+}
+
+bool AudioFlinger::RecordThread::SharedConversion::matches(const RecordTrack* track) const
+{
+    return track->format() == mFormat
+            && track->channelMask() == mChannelMask
+            && track->sampleRate() == mSampleRate;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::retainMembers(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    // compare pointers only: a member which is no longer active may be gone
+    for (auto it = mFronts.begin(); it != mFronts.end(); ) {
+        bool active = false;
+        for (const sp<RecordTrack>& track : activeTracks) {
+            if (track.get() == it->first) {
+                active = true;
+                break;
+            }
+        }
+        it = active ? std::next(it) : mFronts.erase(it);
+    }
+}
+
+bool AudioFlinger::RecordThread::SharedConversion::handOver(bool force)
+{
+    if (mFronts.empty() || (!force && (mFronts.size() != 1 || mFronts.begin()->second != mRear))) {
+        return false; // shared, or converted frames not yet read
+    }
+    RecordTrack* const track = mFronts.begin()->first;
+    std::swap(track->mRecordBufferConverter, mRecordBufferConverter);
+    track->mResamplerBufferProvider->setPosition(mResamplerBufferProvider);
+    mFronts.clear();
+    return true;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::process()
+{
+    for (;;) {
+        // The RecordThread does not overrun itself; if it did, resync like its tracks do.
+        size_t framesIn;
+        mResamplerBufferProvider.sync(&framesIn);
+        if (framesIn == 0) {
+            break;
+        }
+        const size_t rear = mRear & (mFramesP2 - 1);
+        size_t framesOut = min(mFramesP2 - rear, destinationFramesPossible(
+                framesIn, mRecordThread->mSampleRate, mSampleRate));
+        if (framesOut == 0) {
+            break;
+        }
+        framesOut = mRecordBufferConverter->convert(
+                (uint8_t*)mBuffer + rear * mFrameSize, &mResamplerBufferProvider, framesOut);
+        if (framesOut == 0) {
+            break;
+        }
+        mRear = audio_utils::safe_add_overflow(mRear, static_cast<int32_t>(framesOut));
+    }
+}
+
+size_t AudioFlinger::RecordThread::SharedConversion::read(
+        RecordTrack* track, void* dst, size_t frames, bool* overrun)
+{
+    int32_t &front = mFronts[track];
+    const ssize_t filled = audio_utils::safe_sub_overflow(mRear, front);
+    size_t available;
+    *overrun = false;
+    if (filled < 0) {
+        // should not happen, but treat like a massive overrun and re-sync
+        available = 0;
+        front = mRear;
+        *overrun = true;
+    } else if ((size_t) filled <= mFramesP2) {
+        available = (size_t) filled;
+    } else {
+        // track is not keeping up, but give it the latest data
+        available = mFramesP2;
+        front = audio_utils::safe_sub_overflow(mRear, static_cast<int32_t>(mFramesP2));
+        *overrun = true;
+    }
+    frames = min(frames, available);
+    const size_t offset = front & (mFramesP2 - 1);
+    const size_t part1 = min(frames, mFramesP2 - offset);
+    memcpy(dst, (uint8_t*)mBuffer + offset * mFrameSize, part1 * mFrameSize);
+    memcpy((uint8_t*)dst + part1 * mFrameSize, mBuffer, (frames - part1) * mFrameSize);
+    front = audio_utils::safe_add_overflow(front, static_cast<int32_t>(frames));
+    return frames;
+}
+
+bool AudioFlinger::RecordThread::canShareConversion(const sp<RecordTrack>& track) const
+{
+    return !track->isFastTrack() && !track->isDirect()
+            && track->mRecordBufferConverter != nullptr
+            && track->sampleRate() != mSampleRate;
+}
+
+AudioFlinger::RecordThread::SharedConversion *AudioFlinger::RecordThread::sharedConversionOf(
+        const RecordTrack* track) const
+{
+    for (const auto& conversion : mSharedConversions) {
+        if (conversion->hasMember(track)) {
+            return conversion.get();
+        }
+    }
+    return nullptr;
+}
+
+void AudioFlinger::RecordThread::updateSharedConversions(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    for (auto it = mSharedConversions.begin(); it != mSharedConversions.end(); ) {
+        (*it)->retainMembers(activeTracks);
+        if ((*it)->memberCount() == 0 || (*it)->handOver()) {
+            it = mSharedConversions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Tracks join once they have read all the RecordThread data, i.e. between two reads,
+    // so that they continue exactly where their private conversion left off.
+    std::vector<RecordTrack*> candidates;
+    for (const sp<RecordTrack>& track : activeTracks) {
+        if (!canShareConversion(track) || sharedConversionOf(track.get()) != nullptr) {
+            continue;
+        }
+        size_t framesIn;
+        track->mResamplerBufferProvider->sync(&framesIn);
+        if (framesIn != 0) {
+            continue;
+        }
+        bool joined = false;
+        for (const auto& conversion : mSharedConversions) {
+            if (conversion->matches(track.get())) {
+                conversion->addMember(track.get());
+                joined = true;
+                break;
+            }
+        }
+        if (!joined) {
+            candidates.push_back(track.get());
+        }
+    }
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (candidates[i] == nullptr) {
+            continue;
+        }
+        SharedConversion *conversion = nullptr;
+        for (size_t j = i + 1; j < candidates.size(); ++j) {
+            if (candidates[j] == nullptr || candidates[j]->format() != candidates[i]->format()
+                    || candidates[j]->channelMask() != candidates[i]->channelMask()
+                    || candidates[j]->sampleRate() != candidates[i]->sampleRate()) {
+                continue;
+            }
+            if (conversion == nullptr) {
+                mSharedConversions.push_back(
+                        std::make_unique<SharedConversion>(this, candidates[i]));
+                conversion = mSharedConversions.back().get();
+                ALOGV("%s: track(%d) shares its conversion to %u Hz",
+                        __func__, candidates[i]->id(), candidates[i]->sampleRate());
+            }
+            conversion->addMember(candidates[j]);
+            candidates[j] = nullptr;
+        }
+    }
+
+    size_t sharedConversionTracks = 0;
+    for (const auto& conversion : mSharedConversions) {
+        sharedConversionTracks += conversion->memberCount();
+    }
+    mSharedConversionTracks = sharedConversionTracks;
+}
+
+void AudioFlinger::RecordThread::clearSharedConversions()
+{
+    for (const auto& conversion : mSharedConversions) {
+        (void)conversion->handOver(true /* force */);
+    }
+    mSharedConversions.clear();
+    mSharedConversionTracks = 0;
+}
+
 void AudioFlinger::RecordThread::checkBtNrec()
 {
     Mutex::Autolock _l(mLock);
@@ -8421,6 +9014,9 @@ void AudioFlinger::RecordThread::ioConfigChanged(audio_io_config_event event, pi
 
 void AudioFlinger::RecordThread::readInputParameters_l()
 {
+    // the shared conversions read the RecordThread data buffer, which is reallocated below
+    clearSharedConversions();
+
     status_t result = mInput->stream->getAudioProperties(&mSampleRate, &mChannelMask, &mHALFormat);
     LOG_ALWAYS_FATAL_IF(result != OK, "Error retrieving audio properties from HAL: %d", result);
     mFormat = mHALFormat;
@@ -8472,7 +9068,7 @@ void AudioFlinger::RecordThread::readInputParameters_l()
     // But if thread's mSampleRate or mChannelCount changes, how will that affect active tracks?
 
     audio_input_flags_t flags = mInput->flags;
-    mediametrics::LogItem item(mThreadMetrics.getMetricsId());
+    mediametrics::LogItem item(mThreadMetrics->getMetricsId());
     item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_READPARAMETERS)
         .set(AMEDIAMETRICS_PROP_ENCODING, formatToString(mFormat).c_str())
         .set(AMEDIAMETRICS_PROP_FLAGS, toString(flags).c_str())
@@ -8610,9 +9206,9 @@ status_t AudioFlinger::RecordThread::createAudioPatch_l(const struct audio_patch
     }
 
     const std::string pathSourcesAsString = patchSourcesToString(patch);
-    mThreadMetrics.logEndInterval();
-    mThreadMetrics.logCreatePatch(pathSourcesAsString, /* outDevices */ {});
-    mThreadMetrics.logBeginInterval();
+    mThreadMetrics->logEndInterval();
+    mThreadMetrics->logCreatePatch(pathSourcesAsString, /* outDevices */ {});
+    mThreadMetrics->logBeginInterval();
     // also dispatch to active AudioRecords
     for (const auto &track : mActiveTracks) {
         track->logEndInterval();
@@ -8809,7 +9405,7 @@ status_t AudioFlinger::MmapThread::exitStandby()
         return ret;
     }
     if (mStandby) {
-        mThreadMetrics.logBeginInterval();
+        mThreadMetrics->logBeginInterval();
         mStandby = false;
     }
     return NO_ERROR;
@@ -9001,7 +9597,7 @@ status_t AudioFlinger::MmapThread::standby()
     }
     mHalStream->standby();
     if (!mStandby) {
-        mThreadMetrics.logEndInterval();
+        mThreadMetrics->logEndInterval();
         mStandby = true;
     }
     releaseWakeLock();
@@ -9024,7 +9620,7 @@ void AudioFlinger::MmapThread::readHalParameters_l()
     mFrameCount = mBufferSize / mFrameSize;
 
     // TODO: make a readHalParameters call?
-    mediametrics::LogItem item(mThreadMetrics.getMetricsId());
+    mediametrics::LogItem item(mThreadMetrics->getMetricsId());
     item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_READPARAMETERS)
         .set(AMEDIAMETRICS_PROP_ENCODING, formatToString(mFormat).c_str())
         .set(AMEDIAMETRICS_PROP_SAMPLERATE, (int32_t)mSampleRate)
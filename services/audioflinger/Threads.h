@@ -473,6 +473,11 @@ public:
                 // deliver stats to mediametrics.
                 void                sendStatistics(bool force);
 
+                // adds the statistics of the associated fast thread, if any, to the
+                // sendStatistics() item.
+    virtual     void                addFastThreadStatistics(
+                                           mediametrics::Item *item __unused) const { }
+
     mutable     Mutex                   mLock;
 
                 void onEffectEnable(const sp<EffectModule>& effect);
@@ -536,7 +541,7 @@ protected:
                 Condition               mWaitWorkCV;
 
                 const sp<AudioFlinger>  mAudioFlinger;
-                ThreadMetrics           mThreadMetrics;
+                const std::shared_ptr<ThreadMetrics> mThreadMetrics;
                 const bool              mIsOut;
 
                 // updated by PlaybackThread::readOutputParameters_l() or
@@ -867,6 +872,15 @@ public:
                                 const sp<media::IAudioTrackCallback>& callback,
                                 const std::string& opPackageName);
 
+                // returns the client (external) track with the given port id, or nullptr.
+                sp<Track>   getExternalTrackByPortId(audio_port_handle_t portId);
+
+                // applies control to each track (all on this thread) under one thread lock;
+                // the status of tracks[i].second is stored in (*statuses)[tracks[i].first].
+                void        controlTracks(IAudioFlinger::track_control_t control,
+                                const std::vector<std::pair<size_t, sp<Track>>>& tracks,
+                                std::vector<status_t> *statuses);
+
                 AudioStreamOut* getOutput() const;
                 AudioStreamOut* clearOutput();
                 virtual sp<StreamHalInterface> stream() const;
@@ -950,6 +964,19 @@ protected:
     uint32_t                        mHalfBufferMs;       // half the buffer size in milliseconds
 
     void*                           mSinkBuffer;         // frame size aligned sink buffer
+    // Number of mSinkBufferSize chunks mSinkBuffer can hold. Greater than 1 only for offloaded
+    // compressed output, which gathers several HAL buffers per write, see OffloadThread.
+    size_t                          mSinkBufferBatchCount = 1;
+
+    // If non-NULL, the data of the current cycle was rendered into this buffer of the HAL,
+    // obtained by obtainSinkBuffer(), rather than into mSinkBuffer.
+    void*                           mHalSinkBuffer = nullptr;
+    // Cleared once the HAL reports that it does not support zero-copy writes.
+    bool                            mHalSinkBufferSupported = true;
+
+    // Returns the buffer to render a whole cycle of sink data into: a buffer of the HAL which
+    // threadLoop_write() then only has to commit if possible, otherwise mSinkBuffer.
+    void*                           obtainSinkBuffer();
 
     // TODO:
     // Rearrange the buffer info into a struct/class with
@@ -996,6 +1023,10 @@ protected:
     // Due to constraints on mNormalFrameCount, the buffer size is a multiple of 16 frames.
     void*                           mEffectBuffer;
 
+    // If non-0, the effect HAL buffer providing the storage of mEffectBuffer, which is then
+    // shared in place by the global effect chains instead of being mirrored.
+    sp<EffectBufferHalInterface>    mEffectBufferHal;
+
     // Size of mEffectsBuffer in bytes: mNormalFrameCount * #channels * sampsize.
     size_t                          mEffectBufferSize;
 
@@ -1073,6 +1104,7 @@ private:
     void        removeTrack_l(const sp<Track>& track);
 
     void        readOutputParameters_l();
+    void        freeEffectBuffer();  // releases mEffectBuffer and mEffectBufferHal
     void        updateMetadata_l() final;
     virtual void sendMetadataToBackend_l(const StreamOutHalInterface::SourceMetadata& metadata);
 
@@ -1264,8 +1296,13 @@ protected:
                                    audio_patch_handle_t *handle);
     virtual     status_t    releaseAudioPatch_l(const audio_patch_handle_t handle);
 
+                void        addFastThreadStatistics(mediametrics::Item *item) const override;
+
                 AudioMixer* mAudioMixer;    // normal mixer
 private:
+                // sets up parallel resampling in mAudioMixer for this output, if configured
+                void        configureResampleWorkers();
+
                 // one-time initialization, no locks required
                 sp<FastMixer>     mFastMixer;     // non-0 if there is also a fast mixer
                 sp<AudioWatchdog> mAudioWatchdog; // non-0 if there is an audio watchdog thread
@@ -1412,7 +1449,14 @@ protected:
 
     virtual     bool        keepWakeLock() const { return (mKeepWakeLock || (mDrainSequence & 1)); }
 
+    virtual     void        threadLoop_mix();
+                void        dumpInternals_l(int fd, const Vector<String16>& args) override;
+
 private:
+    // Returns true if the frames gathered in the mixbuffer must be written now rather than
+    // waiting for more to complete a batch.
+                bool        shouldWriteBatch(const sp<Track>& track, bool underrun);
+
     size_t      mPausedWriteLength;     // length in bytes of write interrupted by pause
     size_t      mPausedBytesRemaining;  // bytes still waiting in mixbuffer after resume
     bool        mKeepWakeLock;          // keep wake lock while waiting for write callback
@@ -1420,6 +1464,10 @@ private:
                                           // used and valid only during underrun.  ~0 if
                                           // no underrun has occurred during playback and
                                           // is not reset on standby.
+    size_t      mBatchedBytes = 0;      // bytes gathered in the mixbuffer, not yet written
+    nsecs_t     mBatchStartNs = 0;      // when the first of mBatchedBytes was gathered
+    nsecs_t     mBatchMaxHoldNs = 0;    // how long gathered bytes may be held back
+    int64_t     mBatchWrites = 0;       // number of batched writes, for dumpsys
 };
 
 class AsyncCallbackThread : public Thread {
@@ -1493,6 +1541,15 @@ protected:
 private:
 
                 uint32_t    mWaitTimeMs;
+
+    // Latency ceiling for the frames written ahead in each OutputTrack;
+    // the minimum of three downstream periods always applies.
+    static constexpr uint32_t kDefaultMaxWriteAheadMs = 200;
+    // Time without underrun before the write-ahead of an OutputTrack may be lowered.
+    static constexpr uint32_t kWriteAheadStableMs = 10000;
+    const           uint32_t    mMaxWriteAheadMs;
+    const           uint32_t    mWriteAheadStableWrites; // kWriteAheadStableMs in writes
+
     SortedVector < sp<OutputTrack> >  outputTracks;
     SortedVector < sp<OutputTrack> >  mOutputTracks;
 public:
@@ -1529,8 +1586,9 @@ public:
     class ResamplerBufferProvider : public AudioBufferProvider
     {
     public:
-        explicit ResamplerBufferProvider(RecordTrack* recordTrack) :
-            mRecordTrack(recordTrack),
+        explicit ResamplerBufferProvider(RecordTrack* recordTrack);
+        explicit ResamplerBufferProvider(RecordThread* recordThread) :
+            mThread(recordThread),
             mRsmpInUnrel(0), mRsmpInFront(0) { }
         virtual ~ResamplerBufferProvider() { }
 
@@ -1538,6 +1596,13 @@ public:
         // skipping any previous data read from the hal.
         virtual void reset();
 
+        // Takes over the read position of another provider of the same RecordThread,
+        // including frames obtained but not yet released by its resampler.
+        void setPosition(const ResamplerBufferProvider& other) {
+            mRsmpInUnrel = other.mRsmpInUnrel;
+            mRsmpInFront = other.mRsmpInFront;
+        }
+
         /* Synchronizes RecordTrack position with the RecordThread.
          * Calculates available frames and handle overruns if the RecordThread
          * has advanced faster than the ResamplerBufferProvider has retrieved data.
@@ -1555,7 +1620,7 @@ public:
         virtual status_t    getNextBuffer(AudioBufferProvider::Buffer* buffer);
         virtual void        releaseBuffer(AudioBufferProvider::Buffer* buffer);
     private:
-        RecordTrack * const mRecordTrack;
+        const wp<ThreadBase> mThread;
         size_t              mRsmpInUnrel;   // unreleased frames remaining from
                                             // most recent getNextBuffer
                                             // for debug only
@@ -1565,6 +1630,62 @@ public:
 
 #include "RecordTracks.h"
 
+    /* A SharedConversion converts the RecordThread data once for all the normal RecordTracks
+     * which resample it to the same format, channel mask and sample rate, e.g. concurrent
+     * voice recognition and VoIP clients.  The converted frames are kept in a ring from which
+     * each member track reads at its own pace; a member that falls behind by more than the
+     * ring overruns, as it would on the RecordThread data buffer.
+     *
+     * A track joins only once it has read all the RecordThread data, and the first member
+     * lends its own RecordBufferConverter, so that no frame is lost, repeated, or resampled
+     * from a cold filter on the way in and out of the shared conversion.
+     *
+     * Only accessed by the threadLoop(), no locks required.
+     */
+    class SharedConversion
+    {
+    public:
+        SharedConversion(RecordThread* recordThread, RecordTrack* donor);
+        ~SharedConversion();
+
+        bool        matches(const RecordTrack* track) const;
+        bool        hasMember(const RecordTrack* track) const
+                        { return mFronts.count(const_cast<RecordTrack*>(track)) != 0; }
+        size_t      memberCount() const { return mFronts.size(); }
+
+        // track receives the frames converted from now on
+        void        addMember(RecordTrack* track) { mFronts[track] = mRear; }
+        // removes the members which are not in activeTracks
+        void        retainMembers(const Vector< sp<RecordTrack> >& activeTracks);
+        // If the only member has read all the converted frames, or if force, returns the
+        // converter to a member and returns true: it then converts privately from where
+        // this left off.  The other members keep their spare converter.
+        bool        handOver(bool force = false);
+
+        // converts all the RecordThread data read since the last call
+        void        process();
+        // Copies up to frames converted frames which track has not read yet to dst.
+        // Returns the number of frames copied, and sets *overrun if track had fallen behind.
+        size_t      read(RecordTrack* track, void* dst, size_t frames, bool* overrun);
+
+    private:
+        DISALLOW_COPY_AND_ASSIGN(SharedConversion);
+
+        RecordThread * const            mRecordThread;
+        const audio_format_t            mFormat;
+        const audio_channel_mask_t      mChannelMask;
+        const uint32_t                  mSampleRate;
+        const size_t                    mFrameSize;
+        RecordBufferConverter          *mRecordBufferConverter;
+        ResamplerBufferProvider         mResamplerBufferProvider;
+
+        void                           *mBuffer;     // converted frames
+        size_t                          mFramesP2;   // size of mBuffer, a power of 2
+        int32_t                         mRear = 0;   // rolling counter of converted frames
+        // read position of each member, rolling counter like mRear
+        std::map<RecordTrack*, int32_t> mFronts;
+    };
+
             RecordThread(const sp<AudioFlinger>& audioFlinger,
                     AudioStreamIn *input,
                     audio_io_handle_t id,
@@ -1653,6 +1774,7 @@ public:
 
     virtual size_t      frameCount() const { return mFrameCount; }
             bool        hasFastCapture() const { return mFastCapture != 0; }
+            void        addFastThreadStatistics(mediametrics::Item *item) const override;
     virtual void        toAudioPortConfig(struct audio_port_config *config);
 
     virtual status_t    checkEffectCompatibility_l(const effect_descriptor_t *desc,
@@ -1696,6 +1818,16 @@ private:
 
             void    checkBtNrec_l();
 
+            // Returns true if track resamples the RecordThread data and may thus share
+            // its conversion with other tracks.
+            bool    canShareConversion(const sp<RecordTrack>& track) const;
+            // Returns the SharedConversion track is a member of, or nullptr.
+            SharedConversion *sharedConversionOf(const RecordTrack* track) const;
+            // Called by the threadLoop() before each read to group activeTracks.
+            void    updateSharedConversions(const Vector< sp<RecordTrack> >& activeTracks);
+            // Returns the converters to the tracks, when the RecordThread data is reconfigured.
+            void    clearSharedConversions();
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector < sp<RecordTrack> >    mTracks;
@@ -1714,6 +1846,11 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // accessible only within the threadLoop(), no locks required
+            std::vector<std::unique_ptr<SharedConversion>> mSharedConversions;
+            // For dumpsys, number of tracks which are members of mSharedConversions
+            std::atomic<size_t>                 mSharedConversionTracks{0};
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
@@ -97,7 +97,7 @@ public:
 
     virtual void        invalidate() {
                             if (mIsInvalid) return;
-                            mTrackMetrics.logInvalidate();
+                            mTrackMetrics->logInvalidate();
                             mIsInvalid = true;
                         }
             bool        isInvalid() const { return mIsInvalid; }
@@ -242,12 +242,12 @@ public:
     // Called by the PlaybackThread to indicate that the track is becoming active
     // and a new interval should start with a given device list.
     void logBeginInterval(const std::string& devices) {
-        mTrackMetrics.logBeginInterval(devices);
+        mTrackMetrics->logBeginInterval(devices);
     }
 
     // Called by the PlaybackThread to indicate the track is no longer active.
     void logEndInterval() {
-        mTrackMetrics.logEndInterval();
+        mTrackMetrics->logEndInterval();
     }
 
     // Called to tally underrun frames in playback.
@@ -383,7 +383,7 @@ protected:
     int64_t             mLogStartFrames = 0;    // Timestamp frames at start()
     double              mLogLatencyMs = 0.;     // Track the last log latency
 
-    TrackMetrics        mTrackMetrics;
+    const std::shared_ptr<TrackMetrics> mTrackMetrics;
 
     bool                mServerLatencySupported = false;
     std::atomic<bool>   mServerLatencyFromTrack{}; // latency from track or server timestamp.
@@ -17,7 +17,11 @@
 #ifndef ANDROID_AUDIO_TRACKMETRICS_H
 #define ANDROID_AUDIO_TRACKMETRICS_H
 
+#include <atomic>
 #include <mutex>
+#include <thread>
+
+#include "MetricsReporter.h"
 
 namespace android {
 
@@ -31,22 +35,35 @@ namespace android {
  * as this class only executes external one-way calls in Mediametrics and does not
  * call any other AudioFlinger class.
  *
+ * The calls from the audio thread (logVolume(), logLatencyAndStartup(), logUnderruns())
+ * do not lock, allocate, or build items: they only update RtCounters, which the
+ * MetricsReporter thread submits in report().
+ *
  * Terminology:
  * An AudioInterval is a contiguous playback segment.
  * An AudioIntervalGroup is a group of continuous playback segments on the same device.
  *
  * We currently deliver metrics based on an AudioIntervalGroup.
  */
-class TrackMetrics final {
+class TrackMetrics final : public MetricsReporter::Client {
 public:
+    // Creates the metrics and registers them with the MetricsReporter.
+    static std::shared_ptr<TrackMetrics> create(std::string metricsId, bool isOut) {
+        auto metrics = std::make_shared<TrackMetrics>(std::move(metricsId), isOut);
+        MetricsReporter::getInstance().add(metrics);
+        return metrics;
+    }
+
     TrackMetrics(std::string metricsId, bool isOut)
         : mMetricsId(std::move(metricsId))
         , mIsOut(isOut)
         {}  // we don't log a constructor item, we wait for more info in logConstructor().
 
+    // May run on the MetricsReporter thread, if a report() was in progress.
     ~TrackMetrics() {
         logEndInterval();
         std::lock_guard l(mLock);
+        collect_l();
         deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
         // we don't log a destructor item here.
     }
@@ -57,6 +74,7 @@ public:
     void logBeginInterval(const std::string& devices) {
         std::lock_guard l(mLock);
         if (mDevices != devices) {
+            collect_l();
             deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
             mDevices = devices;
             resetIntervalGroupMetrics();
@@ -105,40 +123,112 @@ public:
             .record();
     }
 
+    // Audio thread only, lock free.
     void logLatencyAndStartup(double latencyMs, double startupMs) {
-        mediametrics::LogItem(mMetricsId)
-            .set(AMEDIAMETRICS_PROP_LATENCYMS, latencyMs)
-            .set(AMEDIAMETRICS_PROP_STARTUPMS, startupMs)
-            .record();
-        std::lock_guard l(mLock);
-        mDeviceLatencyMs.add(latencyMs);
-        mDeviceStartupMs.add(startupMs);
+        mRt.latencyMs.store(latencyMs, std::memory_order_relaxed);
+        mRt.startupMs.store(startupMs, std::memory_order_relaxed);
+        mRt.latencySeq.fetch_add(1, std::memory_order_release);
     }
 
-    // may be called multiple times during an interval
+    // may be called multiple times during an interval; audio thread only (single writer).
     void logVolume(float volume) {
         const int64_t timeNs = systemTime();
-        std::lock_guard l(mLock);
-        if (mStartVolumeTimeNs == 0) {
-            mDeviceVolume = mVolume = volume;
-            mLastVolumeChangeTimeNs = mStartVolumeTimeNs = timeNs;
-            return;
+        // seqlock: odd while the volume fields are being updated.
+        const uint32_t seq = mRt.volumeSeq.load(std::memory_order_relaxed);
+        mRt.volumeSeq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const int64_t lastTimeNs = mRt.lastVolumeChangeTimeNs.load(std::memory_order_relaxed);
+        if (lastTimeNs == 0) {
+            mRt.firstVolumeChangeTimeNs.store(timeNs, std::memory_order_relaxed);
+        } else {
+            mRt.volumeTimeIntegral.store(mRt.volumeTimeIntegral.load(std::memory_order_relaxed)
+                    + mRt.volume.load(std::memory_order_relaxed) * (timeNs - lastTimeNs),
+                    std::memory_order_relaxed);
         }
-        mDeviceVolume = (mDeviceVolume * (mLastVolumeChangeTimeNs - mStartVolumeTimeNs) +
-            mVolume * (timeNs - mLastVolumeChangeTimeNs)) / (timeNs - mStartVolumeTimeNs);
-        mVolume = volume;
-        mLastVolumeChangeTimeNs = timeNs;
+        mRt.volume.store(volume, std::memory_order_relaxed);
+        mRt.lastVolumeChangeTimeNs.store(timeNs, std::memory_order_relaxed);
+        mRt.volumeSeq.store(seq + 2, std::memory_order_release);
     }
 
-    // Use absolute numbers returned by AudioTrackShared.
+    // Use absolute numbers returned by AudioTrackShared.  Audio thread only, lock free.
     void logUnderruns(size_t count, size_t frames) {
-        std::lock_guard l(mLock);
-        mUnderrunCount = count;
-        mUnderrunFrames = frames;
+        mRt.underrunCount.store(count, std::memory_order_relaxed);
+        mRt.underrunFrames.store(frames, std::memory_order_relaxed);
         // Consider delivering a message here (also be aware of excessive spam).
     }
 
+    // MetricsReporter::Client
+    void report() override {
+        std::lock_guard l(mLock);
+        collect_l();
+    }
+
 private:
+    /**
+     * Fixed-layout counter block written by the audio thread without locks
+     * and read by collect_l().
+     *
+     * The volume fields are the running time integral of volume up to the last
+     * change, guarded by the volumeSeq seqlock (volumeSeq / 2 is the number of
+     * volume changes).  The reporter derives the interval group average from
+     * differences, so the audio thread never resets them.
+     */
+    struct RtCounters {
+        std::atomic<int64_t>  underrunCount{0};
+        std::atomic<int64_t>  underrunFrames{0};
+        std::atomic<uint32_t> latencySeq{0};
+        std::atomic<double>   latencyMs{0.};
+        std::atomic<double>   startupMs{0.};
+        std::atomic<uint32_t> volumeSeq{0};
+        std::atomic<double>   volume{0.};
+        std::atomic<double>   volumeTimeIntegral{0.};   // volume * ns
+        std::atomic<int64_t>  lastVolumeChangeTimeNs{0};
+        std::atomic<int64_t>  firstVolumeChangeTimeNs{0}; // the integral starts here
+    };
+
+    // Submits the events and picks up the counters written by the audio thread.
+    void collect_l() REQUIRES(mLock) {
+        const uint32_t latencySeq = mRt.latencySeq.load(std::memory_order_acquire);
+        if (latencySeq != mLatencySeq) {
+            mLatencySeq = latencySeq;
+            const double latencyMs = mRt.latencyMs.load(std::memory_order_relaxed);
+            const double startupMs = mRt.startupMs.load(std::memory_order_relaxed);
+            mediametrics::LogItem(mMetricsId)
+                .set(AMEDIAMETRICS_PROP_LATENCYMS, latencyMs)
+                .set(AMEDIAMETRICS_PROP_STARTUPMS, startupMs)
+                .record();
+            mDeviceLatencyMs.add(latencyMs);
+            mDeviceStartupMs.add(startupMs);
+        }
+        mUnderrunCount = mRt.underrunCount.load(std::memory_order_relaxed);
+        mUnderrunFrames = mRt.underrunFrames.load(std::memory_order_relaxed);
+
+        double volume, integral;
+        int64_t lastTimeNs, firstTimeNs;
+        for (;;) {
+            const uint32_t seq = mRt.volumeSeq.load(std::memory_order_acquire);
+            volume = mRt.volume.load(std::memory_order_relaxed);
+            integral = mRt.volumeTimeIntegral.load(std::memory_order_relaxed);
+            lastTimeNs = mRt.lastVolumeChangeTimeNs.load(std::memory_order_relaxed);
+            firstTimeNs = mRt.firstVolumeChangeTimeNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((seq & 1) == 0 && seq == mRt.volumeSeq.load(std::memory_order_relaxed)) break;
+            std::this_thread::yield(); // the audio thread is mid update.
+        }
+        if (lastTimeNs == 0) return; // no volume yet.
+        if (mStartVolumeTimeNs == 0) {
+            // no volume before this interval group, the average starts at the first one.
+            mStartVolumeTimeNs = firstTimeNs;
+            mStartVolumeIntegral = 0.;
+        }
+        mDeviceVolume = lastTimeNs > mStartVolumeTimeNs
+                ? (integral - mStartVolumeIntegral) / (lastTimeNs - mStartVolumeTimeNs)
+                : volume;
+        mVolume = volume;
+        mVolumeIntegral = integral;
+        mLastVolumeChangeTimeNs = lastTimeNs;
+    }
+
     // no lock required - all arguments and constants.
     void deliverDeviceMetrics(const char *eventName, const char *devices) const {
         mediametrics::LogItem(mMetricsId)
@@ -180,10 +270,10 @@ private:
         // mCumulativeTimeNs is not reset by resetIntervalGroupMetrics.
         mDeviceTimeNs = 0;
 
-        mVolume = 0.f;
-        mDeviceVolume = 0.f;
-        mStartVolumeTimeNs = 0;
-        mLastVolumeChangeTimeNs = 0;
+        // The volume average carries on from the last volume change before the group.
+        mDeviceVolume = mVolume;
+        mStartVolumeTimeNs = mLastVolumeChangeTimeNs;
+        mStartVolumeIntegral = mVolumeIntegral;
 
         mDeviceLatencyMs.reset();
         mDeviceStartupMs.reset();
@@ -207,12 +297,20 @@ private:
     int64_t           mCumulativeTimeNs GUARDED_BY(mLock) = 0;
     int64_t           mDeviceTimeNs GUARDED_BY(mLock) = 0;
 
-    // Average volume
+    // Average volume, as of the last collect_l()
     double            mVolume GUARDED_BY(mLock) = 0.f;
     double            mDeviceVolume GUARDED_BY(mLock) = 0.f;
+    double            mVolumeIntegral GUARDED_BY(mLock) = 0.;
+    double            mStartVolumeIntegral GUARDED_BY(mLock) = 0.;
     int64_t           mStartVolumeTimeNs GUARDED_BY(mLock) = 0;
     int64_t           mLastVolumeChangeTimeNs GUARDED_BY(mLock) = 0;
 
+    // last latency event sequence number submitted by collect_l()
+    uint32_t          mLatencySeq GUARDED_BY(mLock) = 0;
+
+    // written by the audio thread
+    RtCounters        mRt;
+
     // latency and startup for each interval.
     audio_utils::Statistics<double> mDeviceLatencyMs GUARDED_BY(mLock);
     audio_utils::Statistics<double> mDeviceStartupMs GUARDED_BY(mLock);
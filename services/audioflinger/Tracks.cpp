@@ -106,7 +106,7 @@ AudioFlinger::ThreadBase::TrackBase::TrackBase(
         mThreadIoHandle(thread ? thread->id() : AUDIO_IO_HANDLE_NONE),
         mPortId(portId),
         mIsInvalid(false),
-        mTrackMetrics(std::move(metricsId), isOut),
+        mTrackMetrics(TrackMetrics::create(std::move(metricsId), isOut)),
         mCreatorPid(creatorPid)
 {
     const uid_t callingUid = IPCThreadState::self()->getCallingUid();
@@ -618,7 +618,7 @@ AudioFlinger::PlaybackThread::Track::Track(
 
     // Once this item is logged by the server, the client can add properties.
     const char * const traits = sharedBuffer == 0 ? "" : "static";
-    mTrackMetrics.logConstructor(creatorPid, uid, traits, streamType);
+    mTrackMetrics->logConstructor(creatorPid, uid, traits, streamType);
 }
 
 AudioFlinger::PlaybackThread::Track::~Track()
@@ -824,8 +824,10 @@ status_t AudioFlinger::PlaybackThread::Track::getNextBuffer(AudioBufferProvider:
         ALOGV("%s(%d): underrun,  framesReady(%zu) < framesDesired(%zd), state: %d",
                 __func__, mId, buf.mFrameCount, desiredFrames, mState);
         mAudioTrackServerProxy->tallyUnderrunFrames(desiredFrames);
+        mAudioTrackServerProxy->autoTuneBufferSize(desiredFrames, true /* underrun */);
     } else {
         mAudioTrackServerProxy->tallyUnderrunFrames(0);
+        mAudioTrackServerProxy->autoTuneBufferSize(desiredFrames, false /* underrun */);
     }
     return status;
 }
@@ -944,84 +946,90 @@ status_t AudioFlinger::PlaybackThread::Track::start(AudioSystem::sync_event_t ev
             }
         }
         Mutex::Autolock _lth(thread->mLock);
-        track_state state = mState;
-        // here the track could be either new, or restarted
-        // in both cases "unstop" the track
-
-        // initial state-stopping. next state-pausing.
-        // What if resume is called ?
-
-        if (state == PAUSED || state == PAUSING) {
-            if (mResumeToStopping) {
-                // happened we need to resume to STOPPING_1
-                mState = TrackBase::STOPPING_1;
-                ALOGV("%s(%d): PAUSED => STOPPING_1 on thread %d",
-                        __func__, mId, (int)mThreadIoHandle);
-            } else {
-                mState = TrackBase::RESUMING;
-                ALOGV("%s(%d): PAUSED => RESUMING on thread %d",
-                        __func__,  mId, (int)mThreadIoHandle);
-            }
-        } else {
-            mState = TrackBase::ACTIVE;
-            ALOGV("%s(%d): ? => ACTIVE on thread %d",
+        status = start_l((PlaybackThread *)thread.get());
+    } else {
+        status = BAD_VALUE;
+    }
+    if (status == NO_ERROR) {
+        forEachTeePatchTrack([](auto patchTrack) { patchTrack->start(); });
+    }
+    return status;
+}
+
+// Called with the thread lock held, see start() and PlaybackThread::controlTracks().
+status_t AudioFlinger::PlaybackThread::Track::start_l(PlaybackThread *playbackThread)
+{
+    track_state state = mState;
+    // here the track could be either new, or restarted
+    // in both cases "unstop" the track
+
+    // initial state-stopping. next state-pausing.
+    // What if resume is called ?
+
+    if (state == PAUSED || state == PAUSING) {
+        if (mResumeToStopping) {
+            // happened we need to resume to STOPPING_1
+            mState = TrackBase::STOPPING_1;
+            ALOGV("%s(%d): PAUSED => STOPPING_1 on thread %d",
                     __func__, mId, (int)mThreadIoHandle);
+        } else {
+            mState = TrackBase::RESUMING;
+            ALOGV("%s(%d): PAUSED => RESUMING on thread %d",
+                    __func__,  mId, (int)mThreadIoHandle);
         }
+    } else {
+        mState = TrackBase::ACTIVE;
+        ALOGV("%s(%d): ? => ACTIVE on thread %d",
+                __func__, mId, (int)mThreadIoHandle);
+    }
 
-        // states to reset position info for non-offloaded/direct tracks
-        if (!isOffloaded() && !isDirect()
-                && (state == IDLE || state == STOPPED || state == FLUSHED)) {
-            mFrameMap.reset();
-        }
-        PlaybackThread *playbackThread = (PlaybackThread *)thread.get();
-        if (isFastTrack()) {
-            // refresh fast track underruns on start because that field is never cleared
-            // by the fast mixer; furthermore, the same track can be recycled, i.e. start
-            // after stop.
-            mObservedUnderruns = playbackThread->getFastTrackUnderruns(mFastIndex);
-        }
-        status = playbackThread->addTrack_l(this);
-        if (status == INVALID_OPERATION || status == PERMISSION_DENIED) {
-            triggerEvents(AudioSystem::SYNC_EVENT_PRESENTATION_COMPLETE);
-            //  restore previous state if start was rejected by policy manager
-            if (status == PERMISSION_DENIED) {
-                mState = state;
-            }
+    // states to reset position info for non-offloaded/direct tracks
+    if (!isOffloaded() && !isDirect()
+            && (state == IDLE || state == STOPPED || state == FLUSHED)) {
+        mFrameMap.reset();
+    }
+    if (isFastTrack()) {
+        // refresh fast track underruns on start because that field is never cleared
+        // by the fast mixer; furthermore, the same track can be recycled, i.e. start
+        // after stop.
+        mObservedUnderruns = playbackThread->getFastTrackUnderruns(mFastIndex);
+    }
+    status_t status = playbackThread->addTrack_l(this);
+    if (status == INVALID_OPERATION || status == PERMISSION_DENIED) {
+        triggerEvents(AudioSystem::SYNC_EVENT_PRESENTATION_COMPLETE);
+        //  restore previous state if start was rejected by policy manager
+        if (status == PERMISSION_DENIED) {
+            mState = state;
         }
+    }
 
-        // Audio timing metrics are computed a few mix cycles after starting.
-        {
-            mLogStartCountdown = LOG_START_COUNTDOWN;
-            mLogStartTimeNs = systemTime();
-            mLogStartFrames = mAudioTrackServerProxy->getTimestamp()
-                    .mPosition[ExtendedTimestamp::LOCATION_KERNEL];
-            mLogLatencyMs = 0.;
-        }
+    // Audio timing metrics are computed a few mix cycles after starting.
+    {
+        mLogStartCountdown = LOG_START_COUNTDOWN;
+        mLogStartTimeNs = systemTime();
+        mLogStartFrames = mAudioTrackServerProxy->getTimestamp()
+                .mPosition[ExtendedTimestamp::LOCATION_KERNEL];
+        mLogLatencyMs = 0.;
+    }
 
-        if (status == NO_ERROR || status == ALREADY_EXISTS) {
-            // for streaming tracks, remove the buffer read stop limit.
-            mAudioTrackServerProxy->start();
-        }
+    if (status == NO_ERROR || status == ALREADY_EXISTS) {
+        // for streaming tracks, remove the buffer read stop limit.
+        mAudioTrackServerProxy->start();
+    }
 
-        // track was already in the active list, not a problem
-        if (status == ALREADY_EXISTS) {
-            status = NO_ERROR;
-        } else {
-            // Acknowledge any pending flush(), so that subsequent new data isn't discarded.
-            // It is usually unsafe to access the server proxy from a binder thread.
-            // But in this case we know the mixer thread (whether normal mixer or fast mixer)
-            // isn't looking at this track yet:  we still hold the normal mixer thread lock,
-            // and for fast tracks the track is not yet in the fast mixer thread's active set.
-            // For static tracks, this is used to acknowledge change in position or loop.
-            ServerProxy::Buffer buffer;
-            buffer.mFrameCount = 1;
-            (void) mAudioTrackServerProxy->obtainBuffer(&buffer, true /*ackFlush*/);
-        }
+    // track was already in the active list, not a problem
+    if (status == ALREADY_EXISTS) {
+        status = NO_ERROR;
     } else {
-        status = BAD_VALUE;
-    }
-    if (status == NO_ERROR) {
-        forEachTeePatchTrack([](auto patchTrack) { patchTrack->start(); });
+        // Acknowledge any pending flush(), so that subsequent new data isn't discarded.
+        // It is usually unsafe to access the server proxy from a binder thread.
+        // But in this case we know the mixer thread (whether normal mixer or fast mixer)
+        // isn't looking at this track yet:  we still hold the normal mixer thread lock,
+        // and for fast tracks the track is not yet in the fast mixer thread's active set.
+        // For static tracks, this is used to acknowledge change in position or loop.
+        ServerProxy::Buffer buffer;
+        buffer.mFrameCount = 1;
+        (void) mAudioTrackServerProxy->obtainBuffer(&buffer, true /*ackFlush*/);
     }
     return status;
 }
@@ -1032,31 +1040,36 @@ void AudioFlinger::PlaybackThread::Track::stop()
     sp<ThreadBase> thread = mThread.promote();
     if (thread != 0) {
         Mutex::Autolock _l(thread->mLock);
-        track_state state = mState;
-        if (state == RESUMING || state == ACTIVE || state == PAUSING || state == PAUSED) {
-            // If the track is not active (PAUSED and buffers full), flush buffers
-            PlaybackThread *playbackThread = (PlaybackThread *)thread.get();
-            if (playbackThread->mActiveTracks.indexOf(this) < 0) {
-                reset();
-                mState = STOPPED;
-            } else if (!isFastTrack() && !isOffloaded() && !isDirect()) {
-                mState = STOPPED;
-            } else {
-                // For fast tracks prepareTracks_l() will set state to STOPPING_2
-                // presentation is complete
-                // For an offloaded track this starts a drain and state will
-                // move to STOPPING_2 when drain completes and then STOPPED
-                mState = STOPPING_1;
-                if (isOffloaded()) {
-                    mRetryCount = PlaybackThread::kMaxTrackStopRetriesOffload;
-                }
+        stop_l((PlaybackThread *)thread.get());
+    }
+    forEachTeePatchTrack([](auto patchTrack) { patchTrack->stop(); });
+}
+
+// Called with the thread lock held, see stop() and PlaybackThread::controlTracks().
+void AudioFlinger::PlaybackThread::Track::stop_l(PlaybackThread *playbackThread)
+{
+    track_state state = mState;
+    if (state == RESUMING || state == ACTIVE || state == PAUSING || state == PAUSED) {
+        // If the track is not active (PAUSED and buffers full), flush buffers
+        if (playbackThread->mActiveTracks.indexOf(this) < 0) {
+            reset();
+            mState = STOPPED;
+        } else if (!isFastTrack() && !isOffloaded() && !isDirect()) {
+            mState = STOPPED;
+        } else {
+            // For fast tracks prepareTracks_l() will set state to STOPPING_2
+            // presentation is complete
+            // For an offloaded track this starts a drain and state will
+            // move to STOPPING_2 when drain completes and then STOPPED
+            mState = STOPPING_1;
+            if (isOffloaded()) {
+                mRetryCount = PlaybackThread::kMaxTrackStopRetriesOffload;
             }
-            playbackThread->broadcast_l();
-            ALOGV("%s(%d): not stopping/stopped => stopping/stopped on thread %d",
-                    __func__, mId, (int)mThreadIoHandle);
         }
+        playbackThread->broadcast_l();
+        ALOGV("%s(%d): not stopping/stopped => stopping/stopped on thread %d",
+                __func__, mId, (int)mThreadIoHandle);
     }
-    forEachTeePatchTrack([](auto patchTrack) { patchTrack->stop(); });
 }
 
 void AudioFlinger::PlaybackThread::Track::pause()
@@ -1065,32 +1078,37 @@ void AudioFlinger::PlaybackThread::Track::pause()
     sp<ThreadBase> thread = mThread.promote();
     if (thread != 0) {
         Mutex::Autolock _l(thread->mLock);
-        PlaybackThread *playbackThread = (PlaybackThread *)thread.get();
-        switch (mState) {
-        case STOPPING_1:
-        case STOPPING_2:
-            if (!isOffloaded()) {
-                /* nothing to do if track is not offloaded */
-                break;
-            }
-
-            // Offloaded track was draining, we need to carry on draining when resumed
-            mResumeToStopping = true;
-            FALLTHROUGH_INTENDED;
-        case ACTIVE:
-        case RESUMING:
-            mState = PAUSING;
-            ALOGV("%s(%d): ACTIVE/RESUMING => PAUSING on thread %d",
-                    __func__, mId, (int)mThreadIoHandle);
-            playbackThread->broadcast_l();
-            break;
+        pause_l((PlaybackThread *)thread.get());
+    }
+    // Pausing the TeePatch to avoid a glitch on underrun, at the cost of buffered audio loss.
+    forEachTeePatchTrack([](auto patchTrack) { patchTrack->pause(); });
+}
 
-        default:
+// Called with the thread lock held, see pause() and PlaybackThread::controlTracks().
+void AudioFlinger::PlaybackThread::Track::pause_l(PlaybackThread *playbackThread)
+{
+    switch (mState) {
+    case STOPPING_1:
+    case STOPPING_2:
+        if (!isOffloaded()) {
+            /* nothing to do if track is not offloaded */
             break;
         }
+
+        // Offloaded track was draining, we need to carry on draining when resumed
+        mResumeToStopping = true;
+        FALLTHROUGH_INTENDED;
+    case ACTIVE:
+    case RESUMING:
+        mState = PAUSING;
+        ALOGV("%s(%d): ACTIVE/RESUMING => PAUSING on thread %d",
+                __func__, mId, (int)mThreadIoHandle);
+        playbackThread->broadcast_l();
+        break;
+
+    default:
+        break;
     }
-    // Pausing the TeePatch to avoid a glitch on underrun, at the cost of buffered audio loss.
-    forEachTeePatchTrack([](auto patchTrack) { patchTrack->pause(); });
 }
 
 void AudioFlinger::PlaybackThread::Track::flush()
@@ -1260,7 +1278,7 @@ void AudioFlinger::PlaybackThread::Track::setFinalVolume(float volume)
     if (mFinalVolume != volume) { // Compare to an epsilon if too many meaningless updates
         mFinalVolume = volume;
         setMetadataHasChanged();
-        mTrackMetrics.logVolume(volume);
+        mTrackMetrics->logVolume(volume);
     }
 }
 
@@ -1553,7 +1571,7 @@ void AudioFlinger::PlaybackThread::Track::updateTrackFrameInfo(
                     (long long)mLogStartTimeNs,
                     (long long)local.mPosition[ExtendedTimestamp::LOCATION_KERNEL],
                     (long long)mLogStartFrames);
-            mTrackMetrics.logLatencyAndStartup(latencyMs, startUpMs);
+            mTrackMetrics->logLatencyAndStartup(latencyMs, startUpMs);
         }
         mLogLatencyMs = latencyMs;
     }
@@ -1604,6 +1622,7 @@ AudioFlinger::PlaybackThread::OutputTrack::OutputTrack(
             audio_format_t format,
             audio_channel_mask_t channelMask,
             size_t frameCount,
+            size_t minBufferSizeInFrames,
             uid_t uid)
     :   Track(playbackThread, NULL, AUDIO_STREAM_PATCH,
               audio_attributes_t{} /* currently unused for output track */,
@@ -1611,7 +1630,8 @@ AudioFlinger::PlaybackThread::OutputTrack::OutputTrack(
               nullptr /* buffer */, (size_t)0 /* bufferSize */, nullptr /* sharedBuffer */,
               AUDIO_SESSION_NONE, getpid(), uid, AUDIO_OUTPUT_FLAG_NONE,
               TYPE_OUTPUT),
-    mActive(false), mSourceThread(sourceThread)
+    mActive(false), mSourceThread(sourceThread),
+    mMinBufferSizeInFrames(std::min(minBufferSizeInFrames, frameCount))
 {
 
     if (mCblk != NULL) {
@@ -1628,6 +1648,8 @@ AudioFlinger::PlaybackThread::OutputTrack::OutputTrack(
         mClientProxy->setVolumeLR(GAIN_MINIFLOAT_PACKED_UNITY);
         mClientProxy->setSendLevel(0.0);
         mClientProxy->setSampleRate(sampleRate);
+        // start with the minimum write-ahead, adaptBufferSize() may raise it up to frameCount
+        mClientProxy->setBufferSizeInFrames(mMinBufferSizeInFrames);
     } else {
         ALOGW("%s(%d): Error creating output track on thread %d",
                 __func__, mId, (int)mThreadIoHandle);
@@ -1771,6 +1793,42 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
     return frames - inBuffer.frameCount;  // number of frames consumed.
 }
 
+void AudioFlinger::PlaybackThread::OutputTrack::adaptBufferSize(
+        size_t stepFrames, uint32_t stableWrites)
+{
+    const uint32_t underrunCount = mClientProxy->getUnderrunCount();
+    if (!mActive) {
+        // the downstream thread underruns while the track is stopped; ignore that
+        mObservedUnderrunCount = underrunCount;
+        mStableWrites = 0;
+        mMinFramesFilled = SIZE_MAX;
+        return;
+    }
+    const size_t bufferSize = mClientProxy->getBufferSizeInFrames();
+    size_t newBufferSize = bufferSize;
+    if (underrunCount != mObservedUnderrunCount) {
+        mObservedUnderrunCount = underrunCount;
+        newBufferSize = bufferSize + stepFrames;
+        mStableWrites = 0;
+        mMinFramesFilled = SIZE_MAX;
+    } else {
+        // observed just before we write, when the fill level is lowest
+        mMinFramesFilled = std::min(mMinFramesFilled, mAudioTrackServerProxy->framesReadySafe());
+        if (++mStableWrites >= stableWrites) {
+            if (mMinFramesFilled > stepFrames && bufferSize > mMinBufferSizeInFrames) {
+                newBufferSize = bufferSize - std::min(stepFrames, bufferSize);
+            }
+            mStableWrites = 0;
+            mMinFramesFilled = SIZE_MAX;
+        }
+    }
+    newBufferSize = std::max(mMinBufferSizeInFrames, std::min(newBufferSize, mFrameCount));
+    if (newBufferSize != bufferSize) {
+        const size_t actual = mClientProxy->setBufferSizeInFrames(newBufferSize);
+        ALOGV("%s(%d): write-ahead %zu -> %zu frames", __func__, mId, bufferSize, actual);
+    }
+}
+
 void AudioFlinger::PlaybackThread::OutputTrack::copyMetadataTo(MetadataInserter& backInserter) const
 {
     std::lock_guard<std::mutex> lock(mTrackMetadatasMutex);
@@ -2180,7 +2238,7 @@ AudioFlinger::RecordThread::RecordTrack::RecordTrack(
 #endif
 
     // Once this item is logged by the server, the client can add properties.
-    mTrackMetrics.logConstructor(creatorPid, uid);
+    mTrackMetrics->logConstructor(creatorPid, uid);
 }
 
 AudioFlinger::RecordThread::RecordTrack::~RecordTrack()
@@ -2743,7 +2801,7 @@ AudioFlinger::MmapThread::MmapTrack::MmapTrack(ThreadBase *thread,
         mPid(pid), mSilenced(false), mSilencedNotified(false)
 {
     // Once this item is logged by the server, the client can add properties.
-    mTrackMetrics.logConstructor(creatorPid, uid);
+    mTrackMetrics->logConstructor(creatorPid, uid);
 }
 
 AudioFlinger::MmapThread::MmapTrack::~MmapTrack()
@@ -675,7 +675,7 @@ bool SwAudioOutputCollection::isActive(VolumeSource volumeSource, uint32_t inPas
 {
     nsecs_t sysTime = systemTime();
     for (size_t i = 0; i < this->size(); i++) {
-        const sp<SwAudioOutputDescriptor> outputDesc = this->valueAt(i);
+        const sp<SwAudioOutputDescriptor>& outputDesc = this->valueAt(i);
         if (outputDesc->isActive(volumeSource, inPastMs, sysTime)) {
             return true;
         }
@@ -687,7 +687,7 @@ bool SwAudioOutputCollection::isActiveLocally(VolumeSource volumeSource, uint32_
 {
     nsecs_t sysTime = systemTime();
     for (size_t i = 0; i < this->size(); i++) {
-        const sp<SwAudioOutputDescriptor> outputDesc = this->valueAt(i);
+        const sp<SwAudioOutputDescriptor>& outputDesc = this->valueAt(i);
         if (outputDesc->isActive(volumeSource, inPastMs, sysTime)
                 && (!(outputDesc->devices()
                         .containsDeviceAmongTypes(getAllOutRemoteDevices())
@@ -703,9 +703,10 @@ bool SwAudioOutputCollection::isActiveRemotely(VolumeSource volumeSource, uint32
 {
     nsecs_t sysTime = systemTime();
     for (size_t i = 0; i < size(); i++) {
-        const sp<SwAudioOutputDescriptor> outputDesc = valueAt(i);
-        if (outputDesc->devices().containsDeviceAmongTypes(getAllOutRemoteDevices()) &&
-                outputDesc->isActive(volumeSource, inPastMs, sysTime)) {
+        const sp<SwAudioOutputDescriptor>& outputDesc = valueAt(i);
+        // Check activity first: devices() returns a copy of the device vector.
+        if (outputDesc->isActive(volumeSource, inPastMs, sysTime) &&
+                outputDesc->devices().containsDeviceAmongTypes(getAllOutRemoteDevices())) {
             // do not consider re routing (when the output is going to a dynamic policy)
             // as "remote playback"
             if (outputDesc->mPolicyMix == NULL) {
@@ -19,10 +19,13 @@
 
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <hidl/Status.h>
 #include <libxml/parser.h>
+#include <libxml/uri.h>
 #include <libxml/xinclude.h>
 #include <media/convert.h>
 #include <utils/Log.h>
@@ -269,6 +272,80 @@ constexpr auto make_xmlUnique(T *t) {
     return std::unique_ptr<T, decltype(deleter)>{t, deleter};
 }
 
+struct XInclude {
+    xmlNode *node;
+    std::string path;
+    xmlDoc *doc = nullptr;
+};
+
+void collectXIncludes(xmlNode *cur, std::vector<XInclude> *includes)
+{
+    for (; cur != nullptr; cur = cur->next) {
+        if (cur->type != XML_ELEMENT_NODE) {
+            continue;
+        }
+        if (cur->ns == nullptr || xmlStrcmp(cur->ns->href, XINCLUDE_NS) ||
+                xmlStrcmp(cur->name, XINCLUDE_NODE)) {
+            collectXIncludes(cur->children, includes);
+            continue;
+        }
+        // Text includes and XPointers are left to xmlXIncludeProcess().
+        auto parse = make_xmlUnique(xmlGetProp(cur, XINCLUDE_PARSE));
+        auto xpointer = make_xmlUnique(xmlGetProp(cur, XINCLUDE_XPOINTER));
+        auto href = make_xmlUnique(xmlGetProp(cur, XINCLUDE_HREF));
+        if (href == nullptr || xpointer != nullptr ||
+                (parse != nullptr && xmlStrcmp(parse.get(), XINCLUDE_PARSE_XML))) {
+            continue;
+        }
+        auto base = make_xmlUnique(xmlNodeGetBase(cur->doc, cur));
+        auto uri = make_xmlUnique(xmlBuildURI(href.get(), base.get()));
+        if (uri != nullptr) {
+            includes->push_back({cur, reinterpret_cast<const char*>(uri.get())});
+        }
+    }
+}
+
+/**
+ * Parses the documents included by the XIncludes of doc in parallel and substitutes them,
+ * as xmlXIncludeProcess() would. Includes nested in those documents, and any that failed
+ * to parse here, are left to xmlXIncludeProcess() to resolve or report.
+ */
+void preloadXIncludes(xmlDoc *doc)
+{
+    std::vector<XInclude> includes;
+    collectXIncludes(xmlDocGetRootElement(doc), &includes);
+    if (includes.size() < 2) {
+        return;
+    }
+    xmlInitParser(); // must be called from a single thread before parsing in several
+    std::vector<std::thread> parsers;
+    parsers.reserve(includes.size());
+    for (auto &include : includes) {
+        parsers.emplace_back([&include] {
+            include.doc = xmlReadFile(include.path.c_str(), nullptr, 0);
+        });
+    }
+    for (auto &parser : parsers) {
+        parser.join();
+    }
+    for (auto &include : includes) {
+        auto includedDoc = make_xmlUnique(include.doc);
+        xmlNode *includedRoot = includedDoc ? xmlDocGetRootElement(includedDoc.get()) : nullptr;
+        if (includedRoot == nullptr) {
+            continue;
+        }
+        xmlNode *copy = xmlDocCopyNode(includedRoot, doc, 1 /* recursive */);
+        if (copy == nullptr) {
+            continue;
+        }
+        // Keep relative hrefs of nested includes relative to the included file.
+        xmlNodeSetBase(copy, reinterpret_cast<const xmlChar*>(include.path.c_str()));
+        xmlAddPrevSibling(include.node, copy);
+        xmlUnlinkNode(include.node);
+        xmlFreeNode(include.node);
+    }
+}
+
 std::string getXmlAttribute(const xmlNode *cur, const char *attribute)
 {
     auto xmlValue = make_xmlUnique(xmlGetProp(cur, reinterpret_cast<const xmlChar*>(attribute)));
@@ -1073,6 +1150,7 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
         ALOGE("%s: Could not parse %s document: empty.", __func__, configFile);
         return BAD_VALUE;
     }
+    preloadXIncludes(doc.get());
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
@@ -201,8 +201,7 @@ status_t ParameterManagerWrapper::setPhoneState(audio_mode_t mode)
     if (!isValueValidForCriterion(criterion, static_cast<int>(mode))) {
         return BAD_VALUE;
     }
-    criterion->setCriterionState((int)(mode));
-    applyPlatformConfiguration();
+    setCriterionStateAndApply(criterion, (int)(mode));
     return NO_ERROR;
 }
 
@@ -234,8 +233,7 @@ status_t ParameterManagerWrapper::setForceUse(audio_policy_force_use_t usage,
     if (!isValueValidForCriterion(criterion, static_cast<int>(config))) {
         return BAD_VALUE;
     }
-    criterion->setCriterionState((int)config);
-    applyPlatformConfiguration();
+    setCriterionStateAndApply(criterion, (int)config);
     return NO_ERROR;
 }
 
@@ -292,7 +290,11 @@ status_t ParameterManagerWrapper::setDeviceConnectionState(
     else {
         currentValueMask &= ~deviceAddressId;
     }
-    criterion->setCriterionState(currentValueMask);
+    if (currentValueMask != criterion->getCriterionState()) {
+        // Applied along with the next device availability update.
+        criterion->setCriterionState(currentValueMask);
+        mHasPendingCriteria = true;
+    }
     return NO_ERROR;
 }
 
@@ -304,8 +306,7 @@ status_t ParameterManagerWrapper::setAvailableInputDevices(audio_devices_t input
         ALOGE("%s: no criterion found for %s", __FUNCTION__, gInputDeviceCriterionName);
         return DEAD_OBJECT;
     }
-    criterion->setCriterionState(inputDevices & ~AUDIO_DEVICE_BIT_IN);
-    applyPlatformConfiguration();
+    setCriterionStateAndApply(criterion, inputDevices & ~AUDIO_DEVICE_BIT_IN);
     return NO_ERROR;
 }
 
@@ -317,15 +318,25 @@ status_t ParameterManagerWrapper::setAvailableOutputDevices(audio_devices_t outp
         ALOGE("%s: no criterion found for %s", __FUNCTION__, gOutputDeviceCriterionName);
         return DEAD_OBJECT;
     }
-    criterion->setCriterionState(outputDevices);
-    applyPlatformConfiguration();
+    setCriterionStateAndApply(criterion, outputDevices);
     return NO_ERROR;
 }
 
 void ParameterManagerWrapper::applyPlatformConfiguration()
 {
+    mHasPendingCriteria = false;
     mPfwConnector->applyConfigurations();
 }
 
+void ParameterManagerWrapper::setCriterionStateAndApply(ISelectionCriterionInterface *criterion,
+                                                        int state)
+{
+    if (criterion->getCriterionState() == state && !mHasPendingCriteria) {
+        return;
+    }
+    criterion->setCriterionState(state);
+    applyPlatformConfiguration();
+}
+
 } // namespace audio_policy
 } // namespace android
@@ -151,6 +151,16 @@ private:
      */
     void applyPlatformConfiguration();
 
+    /**
+     * Set the state of a criterion and apply the platform configuration.
+     * The apply, which evaluates all the domain rules, is skipped if the criterion state is
+     * unchanged and no other criterion has been modified since the last apply.
+     *
+     * @param[in] criterion to update.
+     * @param[in] state new state of the criterion.
+     */
+    void setCriterionStateAndApply(ISelectionCriterionInterface *criterion, int state);
+
      /**
      * Retrieve an element from a map by its name.
      *
@@ -196,6 +206,7 @@ private:
     bool isValueValidForCriterion(ISelectionCriterionInterface *criterion, int valueToCheck);
 
     Criteria mPolicyCriteria; /**< Policy Criterion Map. */
+    bool mHasPendingCriteria = false; /**< Criteria modified since last apply. */
 
     CParameterMgrPlatformConnector *mPfwConnector; /**< Policy Parameter Manager connector. */
     ParameterMgrPlatformConnectorLogger *mPfwConnectorLogger; /**< Policy PFW logger. */
@@ -145,6 +145,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
     // handle output devices
     if (audio_is_output_device(device->type())) {
         SortedVector <audio_io_handle_t> outputs;
+        invalidateOutputSelectionCache();
 
         ssize_t index = mAvailableOutputDevices.indexOf(device);
 
@@ -756,6 +757,8 @@ void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
     if (config == mEngine->getForceUse(usage)) {
         return;
     }
+    // forced encoded surround modes change the formats reported for devices.
+    invalidateOutputSelectionCache();
 
     if (mEngine->setForceUse(usage, config) != NO_ERROR) {
         ALOGW("setForceUse() could not set force cfg %d for usage %d", config, usage);
@@ -1126,15 +1129,22 @@ status_t AudioPolicyManager::openDirectOutput(audio_stream_type_t stream,
                                               const audio_config_t *config,
                                               audio_output_flags_t flags,
                                               const DeviceVector &devices,
-                                              audio_io_handle_t *output) {
+                                              audio_io_handle_t *output,
+                                              bool *noDirectProfile) {
 
     *output = AUDIO_IO_HANDLE_NONE;
+    if (noDirectProfile != nullptr) {
+        *noDirectProfile = false;
+    }
 
     // skip direct output selection if the request can obviously be attached to a mixed output
     // and not explicitly requested
     if (((flags & AUDIO_OUTPUT_FLAG_DIRECT) == 0) &&
             audio_is_linear_pcm(config->format) && config->sample_rate <= SAMPLE_RATE_HZ_MAX &&
             audio_channel_count_from_out_mask(config->channel_mask) <= 2) {
+        if (noDirectProfile != nullptr) {
+            *noDirectProfile = true;
+        }
         return NAME_NOT_FOUND;
     }
 
@@ -1150,6 +1160,9 @@ status_t AudioPolicyManager::openDirectOutput(audio_stream_type_t stream,
         profile = getProfileForOutput(
                 devices, config->sample_rate, config->format, config->channel_mask,
                 flags, true /* directOnly */);
+        if (profile == nullptr && noDirectProfile != nullptr) {
+            *noDirectProfile = true;
+        }
     }
 
     if (profile == nullptr) {
@@ -1276,9 +1289,21 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
         ALOGV("Set VoIP and Direct output flags for PCM format");
     }
 
+    OutputSelectionKey key{{}, config->sample_rate, config->format, channelMask, *flags};
+    key.deviceIds.reserve(devices.size());
+    for (const auto& device : devices) {
+        key.deviceIds.push_back(device->getId());
+    }
+    if (const auto it = mOutputSelectionCache.find(key); it != mOutputSelectionCache.end()) {
+        *flags = it->second.flags;
+        return it->second.output;
+    }
+
     audio_config_t directConfig = *config;
     directConfig.channel_mask = channelMask;
-    status_t status = openDirectOutput(stream, session, &directConfig, *flags, devices, &output);
+    bool noDirectProfile = false;
+    status_t status = openDirectOutput(stream, session, &directConfig, *flags, devices, &output,
+                                       &noDirectProfile);
     if (status != NAME_NOT_FOUND) {
         return output;
     }
@@ -1303,6 +1328,12 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
         *flags = (audio_output_flags_t)(*flags & ~AUDIO_OUTPUT_FLAG_DIRECT);
         output = selectOutput(outputs, *flags, config->format, channelMask, config->sample_rate);
     }
+    if (noDirectProfile && output != AUDIO_IO_HANDLE_NONE) {
+        if (mOutputSelectionCache.size() >= kOutputSelectionCacheMax) {
+            mOutputSelectionCache.clear();
+        }
+        mOutputSelectionCache.emplace(std::move(key), OutputSelection{output, *flags});
+    }
     ALOGW_IF((output == 0), "getOutputForDevices() could not find output for stream %d, "
             "sampling rate %d, format %#x, channels %#x, flags %#x",
             stream, config->sample_rate, config->format, channelMask, *flags);
@@ -2845,7 +2876,7 @@ bool AudioPolicyManager::isStreamActiveRemotely(audio_stream_type_t stream, uint
 bool AudioPolicyManager::isSourceActive(audio_source_t source) const
 {
     for (size_t i = 0; i < mInputs.size(); i++) {
-        const sp<AudioInputDescriptor>  inputDescriptor = mInputs.valueAt(i);
+        const sp<AudioInputDescriptor>& inputDescriptor = mInputs.valueAt(i);
         if (inputDescriptor->isSourceActive(source)) {
             return true;
         }
@@ -3275,6 +3306,7 @@ void AudioPolicyManager::dump(String8 *dst) const
     mAudioPatches.dump(dst);
     mPolicyMixes.dump(dst);
     mAudioSources.dump(dst);
+    dst->appendFormat(" Output selection cache: %zu entries\n", mOutputSelectionCache.size());
 
     dst->appendFormat(" AllowedCapturePolicies:\n");
     for (auto& policy : mAllowedCapturePolicies) {
@@ -4584,6 +4616,7 @@ AudioPolicyManager::~AudioPolicyManager()
    mAvailableOutputDevices.clear();
    mAvailableInputDevices.clear();
    mOutputs.clear();
+   invalidateOutputSelectionCache();
    mInputs.clear();
    mHwModules.clear();
    mHwModulesAll.clear();
@@ -4609,6 +4642,7 @@ void AudioPolicyManager::onNewAudioModulesAvailable()
 
 void AudioPolicyManager::onNewAudioModulesAvailableInt(DeviceVector *newDevices)
 {
+    invalidateOutputSelectionCache();
     for (const auto& hwModule : mHwModulesAll) {
         if (std::find(mHwModules.begin(), mHwModules.end(), hwModule) != mHwModules.end()) {
             continue;
@@ -4743,6 +4777,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
     mOutputs.add(output, outputDesc);
+    invalidateOutputSelectionCache();
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
@@ -4752,6 +4787,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
 void AudioPolicyManager::removeOutput(audio_io_handle_t output)
 {
     mOutputs.removeItem(output);
+    invalidateOutputSelectionCache();
     selectOutputForMusicEffects();
 }
 
@@ -18,8 +18,11 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <tuple>
 #include <unordered_set>
+#include <vector>
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -787,6 +790,31 @@ protected:
         std::unordered_set<audio_format_t> mManualSurroundFormats;
 
         std::unordered_map<uid_t, audio_flags_mask_t> mAllowedCapturePolicies;
+
+        // Memoized mixed output selections of getOutputForDevices(), for requests which no
+        // direct output profile can serve. Such a selection only depends on the open outputs,
+        // the available output devices and their formats: invalidateOutputSelectionCache()
+        // must be called whenever one of them changes.
+        struct OutputSelectionKey {
+            std::vector<audio_port_handle_t> deviceIds;
+            uint32_t sampleRate;
+            audio_format_t format;
+            audio_channel_mask_t channelMask;
+            audio_output_flags_t flags;    // after adjustment for the stream type
+
+            bool operator<(const OutputSelectionKey& other) const {
+                return std::tie(deviceIds, sampleRate, format, channelMask, flags)
+                        < std::tie(other.deviceIds, other.sampleRate, other.format,
+                                other.channelMask, other.flags);
+            }
+        };
+        struct OutputSelection {
+            audio_io_handle_t output;
+            audio_output_flags_t flags;    // flags returned to the caller
+        };
+        static constexpr size_t kOutputSelectionCacheMax = 64;
+        std::map<OutputSelectionKey, OutputSelection> mOutputSelectionCache;
+        void invalidateOutputSelectionCache() { mOutputSelectionCache.clear(); }
 protected:
         void onNewAudioModulesAvailableInt(DeviceVector *newDevices);
 
@@ -851,13 +879,16 @@ protected:
         // Internal method checking if a direct output can be opened matching the requested
         // attributes, flags, config and devices.
         // If NAME_NOT_FOUND is returned, an attempt can be made to open a mixed output.
+        // noDirectProfile, if not null, is set when that is because no direct profile
+        // matches the request at all (rather than because of the current output state).
         status_t openDirectOutput(
                 audio_stream_type_t stream,
                 audio_session_t session,
                 const audio_config_t *config,
                 audio_output_flags_t flags,
                 const DeviceVector &devices,
-                audio_io_handle_t *output);
+                audio_io_handle_t *output,
+                bool *noDirectProfile = nullptr);
         /**
          * @brief getInputForDevice selects an input handle for a given input device and
          * requester context
@@ -867,6 +867,23 @@ audio_devices_t AudioPolicyService::getDevicesForStream(audio_stream_type_t stre
     return mAudioPolicyManager->getDevicesForStream(stream);
 }
 
+status_t AudioPolicyService::getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                                  std::vector<audio_devices_t> *devices)
+{
+    if (mAudioPolicyManager == NULL) {
+        return NO_INIT;
+    }
+    devices->assign(streams.size(), AUDIO_DEVICE_NONE);
+    Mutex::Autolock _l(mLock);
+    AutoCallerClear acc;
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (uint32_t(streams[i]) < AUDIO_STREAM_PUBLIC_CNT) {
+            (*devices)[i] = mAudioPolicyManager->getDevicesForStream(streams[i]);
+        }
+    }
+    return NO_ERROR;
+}
+
 status_t AudioPolicyService::getDevicesForAttributes(const AudioAttributes &aa,
                                                      AudioDeviceTypeAddrVector *devices) const
 {
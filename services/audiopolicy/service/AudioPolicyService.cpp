@@ -23,6 +23,7 @@
 #define __STDC_LIMIT_MACROS
 #include <stdint.h>
 #include <sys/time.h>
+#include <algorithm>
 
 #include <audio_utils/clock.h>
 #include <binder/IServiceManager.h>
@@ -1370,6 +1371,13 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
                 default:
                     ALOGW("AudioCommandThread() unknown command %d", command->mCommand);
                 }
+                if (command->mCommand >= 0 && command->mCommand < kNumCommands) {
+                    CommandLatency& latency = mCommandLatency[command->mCommand];
+                    const nsecs_t latencyNs = systemTime() - command->mTime;
+                    latency.mCount++;
+                    latency.mTotalNs += latencyNs;
+                    latency.mMaxNs = std::max(latency.mMaxNs, latencyNs);
+                }
                 {
                     Mutex::Autolock _l(command->mLock);
                     if (command->mWaitStatus) {
@@ -1444,6 +1452,19 @@ status_t AudioPolicyService::AudioCommandThread::dump(int fd)
     } else {
         result.append("     none\n");
     }
+    result.append("- Command latency (scheduled to completed):\n");
+    result.append("   Command Count      Avg(ms)  Max(ms)\n");
+    for (int i = 0; i < kNumCommands; i++) {
+        const CommandLatency& latency = mCommandLatency[i];
+        if (latency.mCount == 0) {
+            continue;
+        }
+        snprintf(buffer, SIZE, "   %02d      %-10u %-8.3f %-8.3f\n",
+                i, latency.mCount,
+                (double)latency.mTotalNs / latency.mCount * 1e-6,
+                (double)latency.mMaxNs * 1e-6);
+        result.append(buffer);
+    }
 
     write(fd, result.string(), result.size());
 
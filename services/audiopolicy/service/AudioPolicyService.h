@@ -130,6 +130,8 @@ public:
 
     virtual uint32_t getStrategyForStream(audio_stream_type_t stream);
     virtual audio_devices_t getDevicesForStream(audio_stream_type_t stream);
+    virtual status_t getDevicesForStreams(const std::vector<audio_stream_type_t>& streams,
+                                          std::vector<audio_devices_t> *devices);
     virtual status_t getDevicesForAttributes(const AudioAttributes &aa,
                                              AudioDeviceTypeAddrVector *devices) const;
 
@@ -476,6 +478,7 @@ private:
             SET_EFFECT_SUSPENDED,
             AUDIO_MODULES_UPDATE,
         };
+        static constexpr int kNumCommands = AUDIO_MODULES_UPDATE + 1;
 
         AudioCommandThread (String8 name, const wp<AudioPolicyService>& service);
         virtual             ~AudioCommandThread();
@@ -629,6 +632,12 @@ private:
         Condition mWaitWorkCV;
         Vector < sp<AudioCommand> > mAudioCommands; // list of pending commands
         sp<AudioCommand> mLastCommand;      // last processed command (used by dump)
+        // latency from scheduled time to completion, per command type (used by dump)
+        struct CommandLatency {
+            uint32_t mCount = 0;
+            nsecs_t mTotalNs = 0;
+            nsecs_t mMaxNs = 0;
+        } mCommandLatency[kNumCommands];
         String8 mName;                      // string used by wake lock fo delayed commands
         wp<AudioPolicyService> mService;
     };
@@ -506,6 +506,36 @@ TEST_F(AudioPolicyManagerTestWithConfigurationFile, Dump) {
     dumpToLog();
 }
 
+TEST_F(AudioPolicyManagerTestWithConfigurationFile, RepeatedOutputSelectionIsStable) {
+    audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            48000 /*sampleRate*/, AUDIO_OUTPUT_FLAG_NONE, &output);
+    ASSERT_NE(AUDIO_IO_HANDLE_NONE, output);
+
+    // A repeated request is served from the output selection cache.
+    audio_port_handle_t repeatedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t repeatedOutput = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&repeatedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            48000 /*sampleRate*/, AUDIO_OUTPUT_FLAG_NONE, &repeatedOutput);
+    EXPECT_EQ(output, repeatedOutput);
+    EXPECT_EQ(selectedDeviceId, repeatedDeviceId);
+
+    // A device connection cycle invalidates the cache, and must give the same result back.
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_HDMI, AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+            "audio_policy_test_out_hdmi", "test_out_hdmi", AUDIO_FORMAT_DEFAULT));
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_HDMI, AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+            "audio_policy_test_out_hdmi", "test_out_hdmi", AUDIO_FORMAT_DEFAULT));
+    repeatedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    repeatedOutput = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&repeatedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            48000 /*sampleRate*/, AUDIO_OUTPUT_FLAG_NONE, &repeatedOutput);
+    EXPECT_EQ(output, repeatedOutput);
+    EXPECT_EQ(selectedDeviceId, repeatedDeviceId);
+}
+
 using PolicyMixTuple = std::tuple<audio_usage_t, audio_source_t, uint32_t>;
 
 class AudioPolicyManagerTestDynamicPolicy : public AudioPolicyManagerTestWithConfigurationFile {
@@ -1654,6 +1654,7 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
             static_cast<int>(effectiveApiLevel));
 
     sp<CLIENT> client = nullptr;
+    nsecs_t connectStart = systemTime();
     {
         // Acquire mServiceLock and prevent other clients from connecting
         std::unique_ptr<AutoConditionLock> lock =
@@ -1668,10 +1669,12 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
         }
 
         // Enforce client permissions and do basic validity checks
+        nsecs_t phaseStart = systemTime();
         if(!(ret = validateConnectLocked(cameraId, clientName8,
                 /*inout*/clientUid, /*inout*/clientPid, /*out*/originalClientPid)).isOk()) {
             return ret;
         }
+        mConnectValidateLatency.add(phaseStart, systemTime());
 
         // Check the shim parameters after acquiring lock, if they have already been updated and
         // we were doing a shim update, return immediately
@@ -1686,6 +1689,7 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
 
         sp<BasicClient> clientTmp = nullptr;
         std::shared_ptr<resource_policy::ClientDescriptor<String8, sp<BasicClient>>> partial;
+        phaseStart = systemTime();
         if ((err = handleEvictionsLocked(cameraId, originalClientPid, effectiveApiLevel,
                 IInterface::asBinder(cameraCb), clientName8, /*out*/&clientTmp,
                 /*out*/&partial)) != NO_ERROR) {
@@ -1709,6 +1713,8 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
             }
         }
 
+        mConnectEvictionLatency.add(phaseStart, systemTime());
+
         if (clientTmp.get() != nullptr) {
             // Handle special case for API1 MediaRecorder where the existing client is returned
             device = static_cast<CLIENT*>(clientTmp.get());
@@ -1739,6 +1745,7 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
         LOG_ALWAYS_FATAL_IF(client.get() == nullptr, "%s: CameraService in invalid state",
                 __FUNCTION__);
 
+        phaseStart = systemTime();
         err = client->initialize(mCameraProviderManager, mMonitorTags);
         if (err != OK) {
             ALOGE("%s: Could not initialize client from HAL.", __FUNCTION__);
@@ -1767,6 +1774,7 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
                             strerror(-err), err);
             }
         }
+        mConnectInitializeLatency.add(phaseStart, systemTime());
 
         // Update shim paremeters for legacy clients
         if (effectiveApiLevel == API_1) {
@@ -1798,6 +1806,7 @@ Status CameraService::connectHelper(const sp<CALLBACK>& cameraCb, const String8&
             // Otherwise, add client to active clients list
             physicalFrontCam(cameraId == "1");
             finishConnectLocked(client, partial);
+            mConnectLatency.add(connectStart, systemTime());
         }
     } // lock is destroyed, allow further connect calls
 
@@ -3607,6 +3616,10 @@ status_t CameraService::dump(int fd, const Vector<String16>& args) {
     String8 activeClientString = mActiveClientManager.toString();
     dprintf(fd, "Active Camera Clients:\n%s", activeClientString.string());
     dprintf(fd, "Allowed user IDs: %s\n", toString(mAllowedUsers).string());
+    mConnectLatency.dump(fd, "Camera connect latency histogram:");
+    mConnectValidateLatency.dump(fd, "  Permission and validity check latency histogram:");
+    mConnectEvictionLatency.dump(fd, "  Client eviction latency histogram:");
+    mConnectInitializeLatency.dump(fd, "  Device open and initialize latency histogram:");
 
     dumpEventLog(fd);
 
@@ -46,6 +46,7 @@
 #include "media/RingBuffer.h"
 #include "utils/AutoConditionLock.h"
 #include "utils/ClientManager.h"
+#include "utils/LatencyHistogram.h"
 
 #include <set>
 #include <string>
@@ -757,6 +758,13 @@ private:
     RingBuffer<String8> mEventLog;
     Mutex mLogLock;
 
+    // Latency of the phases of connectHelper, updated with mServiceLock held
+    static const int32_t kConnectLatencyBinSize = 20; // in ms
+    CameraLatencyHistogram mConnectValidateLatency{kConnectLatencyBinSize};
+    CameraLatencyHistogram mConnectEvictionLatency{kConnectLatencyBinSize};
+    CameraLatencyHistogram mConnectInitializeLatency{kConnectLatencyBinSize};
+    CameraLatencyHistogram mConnectLatency{kConnectLatencyBinSize};
+
     // The last monitored tags set by client
     String8 mMonitorTags;
 
@@ -1578,6 +1578,15 @@ status_t Camera2Client::setParameters(const String8& params) {
 
     SharedParameters::Lock l(mParameters);
 
+    // Legacy apps often call setParameters(getParameters()) in a loop. Re-applying the current
+    // flattened parameters is a no-op, so skip the re-parse and request update, unless an
+    // autofocus cycle is temporarily overriding the focus mode.
+    if (params == l.mParameters.paramsFlattened &&
+            l.mParameters.shadowFocusMode == Parameters::FOCUS_MODE_INVALID) {
+        ALOGV("%s: Camera %d: Parameters unchanged", __FUNCTION__, mCameraId);
+        return OK;
+    }
+
     Parameters::focusMode_t focusModeBefore = l.mParameters.focusMode;
     res = l.mParameters.set(params);
     if (res != OK) return res;
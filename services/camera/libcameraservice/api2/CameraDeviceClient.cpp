@@ -1975,6 +1975,31 @@ binder::Status CameraDeviceClient::getGlobalAudioRestriction(/*out*/ int32_t* ou
     return binder::Status::ok();
 }
 
+binder::Status CameraDeviceClient::setResultTagFilter(const std::vector<int32_t>& tags) {
+    ATRACE_CALL();
+    binder::Status res;
+    if (!(res = checkPidStatus(__FUNCTION__)).isOk()) return res;
+
+    std::vector<uint32_t> filter;
+    filter.reserve(tags.size() + 1);
+    for (int32_t tag : tags) {
+        if (get_camera_metadata_tag_type(tag) == -1) {
+            String8 msg = String8::format("Camera %s: invalid result tag 0x%x",
+                    mCameraIdStr.string(), tag);
+            ALOGW("%s: %s", __FUNCTION__, msg.string());
+            return STATUS_ERROR(CameraService::ERROR_ILLEGAL_ARGUMENT, msg.string());
+        }
+        filter.push_back(static_cast<uint32_t>(tag));
+    }
+    if (!filter.empty()) {
+        filter.push_back(ANDROID_SENSOR_TIMESTAMP);
+    }
+
+    Mutex::Autolock l(mResultTagFilterLock);
+    mResultTagFilter = std::move(filter);
+    return binder::Status::ok();
+}
+
 status_t CameraDeviceClient::setRotateAndCropOverride(uint8_t rotateAndCrop) {
     if (rotateAndCrop > ANDROID_SCALER_ROTATE_AND_CROP_AUTO) return BAD_VALUE;
 
@@ -2254,10 +2279,25 @@ void CameraDeviceClient::onResultAvailable(const CaptureResult& result) {
     // Thread-safe. No lock necessary.
     sp<hardware::camera2::ICameraDeviceCallbacks> remoteCb = mRemoteCallback;
     if (remoteCb != NULL) {
-        remoteCb->onResultReceived(result.mMetadata, result.mResultExtras,
-                result.mPhysicalMetadatas);
+        Mutex::Autolock l(mResultTagFilterLock);
+        if (mResultTagFilter.empty()) {
+            remoteCb->onResultReceived(result.mMetadata, result.mResultExtras,
+                    result.mPhysicalMetadatas);
+        } else {
+            // Only serialize the tags the client subscribed to.
+            CameraMetadata filtered(mResultTagFilter.size());
+            for (uint32_t tag : mResultTagFilter) {
+                camera_metadata_ro_entry entry = result.mMetadata.find(tag);
+                if (entry.count > 0) {
+                    filtered.update(entry);
+                }
+            }
+            remoteCb->onResultReceived(filtered, result.mResultExtras,
+                    result.mPhysicalMetadatas);
+        }
     }
 
+    // Composite streams always see the full result.
     for (size_t i = 0; i < mCompositeStreamMap.size(); i++) {
         mCompositeStreamMap.valueAt(i)->onResultAvailable(result);
     }
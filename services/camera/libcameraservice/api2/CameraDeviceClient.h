@@ -162,6 +162,8 @@ public:
 
     virtual binder::Status getGlobalAudioRestriction(/*out*/int32_t* outMode) override;
 
+    virtual binder::Status setResultTagFilter(const std::vector<int32_t>& tags) override;
+
     virtual binder::Status switchToOffline(
             const sp<hardware::camera2::ICameraDeviceCallbacks>& cameraCb,
             const std::vector<int>& offlineOutputIds,
@@ -336,6 +338,10 @@ private:
 
     int32_t mRequestIdCounter;
 
+    // Result tags delivered to the remote callback; empty means all tags.
+    std::vector<uint32_t> mResultTagFilter;
+    Mutex mResultTagFilterLock;
+
     // The list of output streams whose surfaces are deferred. We have to track them separately
     // as there are no surfaces available and can not be put into mStreamMap. Once the deferred
     // Surface is configured, the stream id will be moved to mStreamMap.
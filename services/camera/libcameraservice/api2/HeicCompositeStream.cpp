@@ -783,8 +783,8 @@ bool HeicCompositeStream::getNextReadyInputLocked(int64_t *frameNumber /*out*/)
         // 2. App segment and muxer is created, or
         // 3. A codec output tile is ready, and an output buffer is available.
         // This makes sure that muxer gets created only when an output tile is
-        // generated, because right now we only handle 1 HEIC output buffer at a
-        // time (max dequeued buffer count is 1).
+        // generated, because only kMaxOutputSurfaceProducerCount HEIC output
+        // buffers can be dequeued at a time.
         bool appSegmentReady =
                 (it.second.appSegmentBuffer.data != nullptr || it.second.exifError) &&
                 !it.second.appSegmentWritten && it.second.result != nullptr &&
@@ -228,7 +228,9 @@ private:
     bool              mYuvBufferAcquired; // Only applicable to HEVC codec
     std::queue<int64_t> mMainImageFrameNumbers;
 
-    static const int32_t kMaxOutputSurfaceProducerCount = 1;
+    // Allows the next capture to start muxing its tiles while the previous
+    // one is still being finished, so burst captures overlap.
+    static const int32_t kMaxOutputSurfaceProducerCount = 2;
     sp<Surface>       mOutputSurface;
     sp<ProducerListener> mProducerListener;
     int32_t           mDequeuedOutputBufferCnt;
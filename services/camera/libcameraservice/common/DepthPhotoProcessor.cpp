@@ -31,6 +31,7 @@
 #include <dynamic_depth/pose.h>
 #include <dynamic_depth/profile.h>
 #include <dynamic_depth/profiles.h>
+#include <future>
 #include <jpeglib.h>
 #include <libexif/exif-data.h>
 #include <libexif/exif-system.h>
@@ -243,11 +244,12 @@ inline void unpackDepth16(uint16_t value, std::vector<float> *points /*out*/,
     // The confidence data needs to be additionally normalized with
     // values 1.0f, 0.0f representing maximum and minimum confidence
     // respectively.
-    auto point = static_cast<float>(value & 0x1FFF) / 1000.f;
+    static constexpr float kNormConfidence[8] = {
+        1.f, 0.f, 1.f / 7.f, 2.f / 7.f, 3.f / 7.f, 4.f / 7.f, 5.f / 7.f, 6.f / 7.f };
+    auto point = static_cast<float>(value & 0x1FFF) * 0.001f;
     points->push_back(point);
 
-    auto conf = (value >> 13) & 0x7;
-    float normConfidence = (conf == 0) ? 1.f : (static_cast<float>(conf) - 1) / 7.f;
+    float normConfidence = kNormConfidence[(value >> 13) & 0x7];
     confidence->push_back(normConfidence);
     if (normConfidence < CONFIDENCE_THRESHOLD) {
         return;
@@ -388,24 +390,29 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
     depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
+    // The two maps are independent, so compress the confidence map on a
+    // separate thread while the depth map is compressed on this one.
+    size_t actualConfidenceJpegSize;
+    auto confidenceRet = std::async(std::launch::async, [&]() {
+        return encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, actualConfidenceJpegSize);
+    });
+
     size_t actualJpegSize;
     auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
             depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
             inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
-    if (ret != NO_ERROR) {
-        ALOGE("%s: Depth map compression failed!", __FUNCTION__);
+    if (confidenceRet.get() != NO_ERROR) {
+        ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.depth_image_data.resize(actualJpegSize);
-
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
     if (ret != NO_ERROR) {
-        ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
+        ALOGE("%s: Depth map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.depth_image_data.resize(actualJpegSize);
+    depthParams.confidence_data.resize(actualConfidenceJpegSize);
 
     return DepthMap::FromData(depthParams, items);
 }
@@ -166,30 +166,32 @@ void Camera3BufferManager::notifyBufferRemoved(int streamId, int streamSetId) {
 
 status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         int streamId, int streamSetId) {
-    StreamId firstOtherStreamId = CAMERA3_STREAM_ID_INVALID;
+    StreamId idlestStreamId = CAMERA3_STREAM_ID_INVALID;
     StreamSet &streamSet = mStreamSetMap.editValueFor(streamSetId);
     if (streamSet.streamInfoMap.size() == 1) {
         ALOGV("StreamSet %d has no other stream available to free", streamSetId);
         return OK;
     }
 
-    bool freeBufferIsAttached = false;
+    // Free from the other stream holding the most idle attached buffers, as that is
+    // the stream least likely to be streaming right now.
+    size_t maxIdleBufferCount = 0;
     for (size_t i = 0; i < streamSet.streamInfoMap.size(); i++) {
-        firstOtherStreamId = streamSet.streamInfoMap[i].streamId;
-        if (firstOtherStreamId != streamId) {
-
-            size_t otherBufferCount  =
-                    streamSet.handoutBufferCountMap.valueFor(firstOtherStreamId);
-            size_t otherAttachedBufferCount =
-                    streamSet.attachedBufferCountMap.valueFor(firstOtherStreamId);
-            if (otherAttachedBufferCount > otherBufferCount) {
-                freeBufferIsAttached = true;
-                break;
-            }
+        StreamId otherStreamId = streamSet.streamInfoMap[i].streamId;
+        if (otherStreamId == streamId) {
+            continue;
+        }
+        size_t otherBufferCount  =
+                streamSet.handoutBufferCountMap.valueFor(otherStreamId);
+        size_t otherAttachedBufferCount =
+                streamSet.attachedBufferCountMap.valueFor(otherStreamId);
+        if (otherAttachedBufferCount > otherBufferCount &&
+                otherAttachedBufferCount - otherBufferCount > maxIdleBufferCount) {
+            maxIdleBufferCount = otherAttachedBufferCount - otherBufferCount;
+            idlestStreamId = otherStreamId;
         }
-        firstOtherStreamId = CAMERA3_STREAM_ID_INVALID;
     }
-    if (firstOtherStreamId == CAMERA3_STREAM_ID_INVALID || !freeBufferIsAttached) {
+    if (idlestStreamId == CAMERA3_STREAM_ID_INVALID) {
         ALOGV("StreamSet %d has no buffer available to free", streamSetId);
         return OK;
     }
@@ -202,12 +204,12 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         totalAllocatedBufferCount += streamSet.attachedBufferCountMap[i];
     }
     if (totalAllocatedBufferCount > streamSet.allocatedBufferWaterMark) {
-        ALOGV("Stream %d: Freeing buffer: detach", firstOtherStreamId);
+        ALOGV("Stream %d: Freeing buffer: detach", idlestStreamId);
         sp<Camera3OutputStream> stream =
-                mStreamMap.valueFor(firstOtherStreamId).promote();
+                mStreamMap.valueFor(idlestStreamId).promote();
         if (stream == nullptr) {
             ALOGE("%s: unable to promote stream %d to detach buffer", __FUNCTION__,
-                    firstOtherStreamId);
+                    idlestStreamId);
             return INVALID_OPERATION;
         }
 
@@ -228,7 +230,7 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         }
         if (bufferFreed) {
             size_t& otherAttachedBufferCount =
-                    streamSet.attachedBufferCountMap.editValueFor(firstOtherStreamId);
+                    streamSet.attachedBufferCountMap.editValueFor(idlestStreamId);
             otherAttachedBufferCount--;
         }
     }
@@ -311,8 +313,6 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
         // Proactively free buffers for other streams if the current number of allocated buffers
         // exceeds the water mark. This only for Gralloc V1, for V2, this logic can also be handled
         // in returnBufferForStream() if we want to free buffer more quickly.
-        // TODO: probably should find out all the inactive stream IDs, and free the firstly found
-        // buffers for them.
         res = checkAndFreeBufferOnOtherStreamsLocked(streamId, streamSetId);
         if (res != OK) {
             return res;
@@ -452,6 +452,12 @@ void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
                 mStreamSetMap[i].maxAllowedBufferCount);
         lines.appendFormat("          Stream set buffer count water mark: %zu\n",
                 mStreamSetMap[i].allocatedBufferWaterMark);
+        size_t totalAttachedBufferCount = 0;
+        for (size_t m = 0; m < mStreamSetMap[i].attachedBufferCountMap.size(); m++) {
+            totalAttachedBufferCount += mStreamSetMap[i].attachedBufferCountMap.valueAt(m);
+        }
+        lines.appendFormat("          Stream set allocated buffer count: %zu\n",
+                totalAttachedBufferCount);
         lines.appendFormat("          Handout buffer counts:\n");
         for (size_t m = 0; m < mStreamSetMap[i].handoutBufferCountMap.size(); m++) {
             int streamId = mStreamSetMap[i].handoutBufferCountMap.keyAt(m);
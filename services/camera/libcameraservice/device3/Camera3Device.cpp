@@ -770,6 +770,8 @@ status_t Camera3Device::dump(int fd, const Vector<String16> &args) {
                     r.numBuffersLeft);
         }
     }
+    lines.append("    In-flight lock:\n");
+    mInFlightLock.dump(&lines);
     write(fd, lines.string(), lines.size());
 
     if (mRequestThread != NULL) {
@@ -2801,7 +2803,7 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
         bool isZslCapture, bool rotateAndCropAuto, const std::set<std::string>& cameraIdsWithZoom,
         const SurfaceMap& outputSurfaces) {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
+    std::lock_guard<InFlightLock> l(mInFlightLock);
 
     ssize_t res;
     res = mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
@@ -3694,7 +3696,7 @@ status_t Camera3Device::HalInterface::switchToOffline(
     // Validate buffer caches
     std::vector<int32_t> streams;
     streams.reserve(offlineSessionInfo->offlineStreams.size());
-    for (auto offlineStream : offlineSessionInfo->offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo->offlineStreams) {
         int32_t id = offlineStream.id;
         streams.push_back(id);
         // Verify buffer caches
@@ -3820,6 +3822,7 @@ void Camera3Device::RequestThread::configurationComplete(bool isConstrainedHighS
     Mutex::Autolock l(mRequestLock);
     mReconfigured = true;
     mLatestSessionParams = sessionParams;
+    mSessionParamsRequest.clear();
     // Prepare video stream for high speed recording.
     mPrepareVideoStream = isConstrainedHighSpeed;
     mConstrainedMode = isConstrainedHighSpeed;
@@ -4208,10 +4211,13 @@ bool Camera3Device::RequestThread::updateSessionParameters(const CameraMetadata&
     ATRACE_CALL();
     bool updatesDetected = false;
 
-    CameraMetadata updatedParams(mLatestSessionParams);
+    // Only copy the session parameters once a change is found; for the common
+    // case of unchanged settings this avoids a metadata copy per frame.
+    CameraMetadata updatedParams;
+    bool paramsCopied = false;
     for (auto tag : mSessionParamKeys) {
         camera_metadata_ro_entry entry = settings.find(tag);
-        camera_metadata_entry lastEntry = updatedParams.find(tag);
+        camera_metadata_entry lastEntry = mLatestSessionParams.find(tag);
 
         if (entry.count > 0) {
             bool isDifferent = false;
@@ -4240,11 +4246,19 @@ bool Camera3Device::RequestThread::updateSessionParameters(const CameraMetadata&
                 if (!skipHFRTargetFPSUpdate(tag, entry, lastEntry)) {
                     updatesDetected = true;
                 }
+                if (!paramsCopied) {
+                    updatedParams = mLatestSessionParams;
+                    paramsCopied = true;
+                }
                 updatedParams.update(entry);
             }
         } else if (lastEntry.count > 0) {
             // Value has been removed
             ALOGV("%s: Session parameter tag id %d removed", __FUNCTION__, tag);
+            if (!paramsCopied) {
+                updatedParams = mLatestSessionParams;
+                paramsCopied = true;
+            }
             updatedParams.erase(tag);
             updatesDetected = true;
         }
@@ -4294,8 +4308,12 @@ bool Camera3Device::RequestThread::threadLoop() {
     // 'mNextRequests' will at this point contain either a set of HFR batched requests
     //  or a single request from streaming or burst. In either case the first element
     //  should contain the latest camera settings that we need to check for any session
-    //  parameter updates.
-    if (updateSessionParameters(mNextRequests[0].captureRequest->mSettingsList.begin()->metadata)) {
+    //  parameter updates. A repeating request whose settings were already checked
+    //  cannot carry new session parameters, so skip the scan for it.
+    bool sessionParamsChecked = (mNextRequests[0].captureRequest == mSessionParamsRequest);
+    mSessionParamsRequest = mNextRequests[0].captureRequest;
+    if (!sessionParamsChecked &&
+            updateSessionParameters(mNextRequests[0].captureRequest->mSettingsList.begin()->metadata)) {
         res = OK;
 
         //Input stream buffers are already acquired at this point so an input stream
@@ -4825,6 +4843,7 @@ void Camera3Device::RequestThread::resetPipelineDrain() {
 void Camera3Device::RequestThread::clearPreviousRequest() {
     Mutex::Autolock l(mRequestLock);
     mPrevRequest.clear();
+    mSessionParamsRequest.clear();
 }
 
 status_t Camera3Device::RequestThread::switchToOffline(
@@ -4872,7 +4891,7 @@ status_t Camera3Device::RequestThread::setRotateAndCropAutoBehavior(
 
 nsecs_t Camera3Device::getExpectedInFlightDuration() {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
+    std::lock_guard<InFlightLock> l(mInFlightLock);
     return mExpectedInflightDuration > kMinInflightDuration ?
             mExpectedInflightDuration : kMinInflightDuration;
 }
@@ -4958,7 +4977,7 @@ void Camera3Device::RequestThread::cleanUpFailedRequests(bool sendRequestError)
         {
           sp<Camera3Device> parent = mParent.promote();
           if (parent != NULL) {
-              std::lock_guard<std::mutex> l(parent->mInFlightLock);
+              std::lock_guard<InFlightLock> l(parent->mInFlightLock);
               ssize_t idx = parent->mInFlightMap.indexOfKey(captureRequest->mResultExtras.frameNumber);
               if (idx >= 0) {
                   ALOGV("%s: Remove inflight request from queue: frameNumber %" PRId64,
@@ -5468,7 +5487,7 @@ status_t Camera3Device::PreparerThread::prepare(int maxCount, sp<Camera3StreamIn
     }
 
     // queue up the work
-    mPendingStreams.emplace(maxCount, stream);
+    mPendingStreams.emplace_back(maxCount, stream);
     ALOGV("%s: Stream %d queued for preparing", __FUNCTION__, stream->getId());
 
     return OK;
@@ -5479,11 +5498,10 @@ void Camera3Device::PreparerThread::pause() {
 
     Mutex::Autolock l(mLock);
 
-    std::unordered_map<int, sp<camera3::Camera3StreamInterface> > pendingStreams;
-    pendingStreams.insert(mPendingStreams.begin(), mPendingStreams.end());
+    PendingStreamList pendingStreams;
+    pendingStreams.splice(pendingStreams.end(), mPendingStreams);
     sp<camera3::Camera3StreamInterface> currentStream = mCurrentStream;
     int currentMaxCount = mCurrentMaxCount;
-    mPendingStreams.clear();
     mCancelNow = true;
     while (mActive) {
         auto res = mThreadActiveSignal.waitRelative(mLock, kActiveTimeout);
@@ -5497,15 +5515,15 @@ void Camera3Device::PreparerThread::pause() {
     }
 
     //Check whether the prepare thread was able to complete the current
-    //stream. In case work is still pending emplace it along with the rest
-    //of the streams in the pending list.
+    //stream. In case work is still pending put it back at the front of the
+    //pending list, ahead of the streams queued after it.
     if (currentStream != nullptr) {
         if (!mCurrentPrepareComplete) {
-            pendingStreams.emplace(currentMaxCount, currentStream);
+            pendingStreams.emplace_front(currentMaxCount, currentStream);
         }
     }
 
-    mPendingStreams.insert(pendingStreams.begin(), pendingStreams.end());
+    mPendingStreams.splice(mPendingStreams.begin(), pendingStreams);
     for (const auto& it : mPendingStreams) {
         it.second->cancelPrepare();
     }
@@ -5852,7 +5870,7 @@ status_t Camera3Device::switchToOffline(
     // Verify offlineSessionInfo
     std::vector<int32_t> offlineStreamIds;
     offlineStreamIds.reserve(offlineSessionInfo.offlineStreams.size());
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         // verify stream IDs
         int32_t id = offlineStream.id;
         if (std::find(streamIds.begin(), streamIds.end(), id) == streamIds.end()) {
@@ -5905,8 +5923,8 @@ status_t Camera3Device::switchToOffline(
     InFlightRequestMap offlineReqs;
     // Verify inflight requests and their pending buffers
     {
-        std::lock_guard<std::mutex> l(mInFlightLock);
-        for (auto offlineReq : offlineSessionInfo.offlineRequests) {
+        std::lock_guard<InFlightLock> l(mInFlightLock);
+        for (const auto& offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
                 SET_ERR("Offline request frame number %d not found!", offlineReq.frameNumber);
@@ -5929,7 +5947,7 @@ status_t Camera3Device::switchToOffline(
     //   (streams, inflight requests, buffer caches)
     camera3::StreamSet offlineStreamSet;
     sp<camera3::Camera3Stream> inputStream;
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             inputStream = mInputStream;
@@ -5955,7 +5973,7 @@ status_t Camera3Device::switchToOffline(
 
     // Delete all streams that has been transferred to offline session
     Mutex::Autolock l(mLock);
-    for (auto offlineStream : offlineSessionInfo.offlineStreams) {
+    for (const auto& offlineStream : offlineSessionInfo.offlineStreams) {
         int32_t id = offlineStream.id;
         if (mInputStream != nullptr && id == mInputStream->getId()) {
             mInputStream.clear();
@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA3DEVICE_H
 #define ANDROID_SERVERS_CAMERA3DEVICE_H
 
+#include <list>
 #include <utility>
 #include <unordered_map>
 #include <set>
@@ -1013,6 +1014,8 @@ class Camera3Device :
 
         Vector<int32_t>    mSessionParamKeys;
         CameraMetadata     mLatestSessionParams;
+        // Last request checked for session parameter updates
+        sp<CaptureRequest> mSessionParamsRequest;
 
         const bool         mUseHalBufManager;
     };
@@ -1021,7 +1024,7 @@ class Camera3Device :
     /**
      * In-flight queue for tracking completion of capture requests.
      */
-    std::mutex                    mInFlightLock;
+    camera3::InFlightLock         mInFlightLock;
     camera3::InFlightRequestMap   mInFlightMap;
     nsecs_t                       mExpectedInflightDuration = 0;
     int64_t                       mLastCompletedRegularFrameNumber = -1;
@@ -1090,7 +1093,9 @@ class Camera3Device :
         // Guarded by mLock
 
         wp<NotificationListener> mListener;
-        std::unordered_map<int, sp<camera3::Camera3StreamInterface> > mPendingStreams;
+        // Streams waiting to be prepared with their max buffer count, in FIFO order
+        typedef std::list<std::pair<int, sp<camera3::Camera3StreamInterface>>> PendingStreamList;
+        PendingStreamList mPendingStreams;
         bool mActive;
         bool mCancelNow;
 
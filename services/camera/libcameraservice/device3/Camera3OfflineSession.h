@@ -210,7 +210,7 @@ class Camera3OfflineSession :
     camera3::StreamSet mOutputStreams;
     camera3::BufferRecords mBufferRecords;
 
-    std::mutex mOfflineReqsLock;
+    camera3::InFlightLock mOfflineReqsLock;
     camera3::InFlightRequestMap mOfflineReqs;
 
     sp<hardware::camera::device::V3_6::ICameraOfflineSession> mSession;
@@ -48,7 +48,8 @@ Camera3OutputStream::Camera3OutputStream(int id,
         mTimestampOffset(timestampOffset),
         mConsumerUsage(0),
         mDropBuffers(false),
-        mDequeueBufferLatency(kDequeueLatencyBinSize) {
+        mDequeueBufferLatency(kDequeueLatencyBinSize),
+        mCaptureToQueueLatency(kCaptureToQueueLatencyBinSize) {
 
     if (mConsumer == NULL) {
         ALOGE("%s: Consumer is NULL!", __FUNCTION__);
@@ -74,7 +75,8 @@ Camera3OutputStream::Camera3OutputStream(int id,
         mTimestampOffset(timestampOffset),
         mConsumerUsage(0),
         mDropBuffers(false),
-        mDequeueBufferLatency(kDequeueLatencyBinSize) {
+        mDequeueBufferLatency(kDequeueLatencyBinSize),
+        mCaptureToQueueLatency(kCaptureToQueueLatencyBinSize) {
 
     if (format != HAL_PIXEL_FORMAT_BLOB && format != HAL_PIXEL_FORMAT_RAW_OPAQUE) {
         ALOGE("%s: Bad format for size-only stream: %d", __FUNCTION__,
@@ -106,7 +108,8 @@ Camera3OutputStream::Camera3OutputStream(int id,
         mTimestampOffset(timestampOffset),
         mConsumerUsage(consumerUsage),
         mDropBuffers(false),
-        mDequeueBufferLatency(kDequeueLatencyBinSize) {
+        mDequeueBufferLatency(kDequeueLatencyBinSize),
+        mCaptureToQueueLatency(kCaptureToQueueLatencyBinSize) {
     // Deferred consumer only support preview surface format now.
     if (format != HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED) {
         ALOGE("%s: Deferred consumer only supports IMPLEMENTATION_DEFINED format now!",
@@ -146,7 +149,8 @@ Camera3OutputStream::Camera3OutputStream(int id, camera3_stream_type_t type,
         mTimestampOffset(timestampOffset),
         mConsumerUsage(consumerUsage),
         mDropBuffers(false),
-        mDequeueBufferLatency(kDequeueLatencyBinSize) {
+        mDequeueBufferLatency(kDequeueLatencyBinSize),
+        mCaptureToQueueLatency(kCaptureToQueueLatencyBinSize) {
 
     bool needsReleaseNotify = setId > CAMERA3_STREAM_SET_ID_INVALID;
     mBufferProducerListener = new BufferProducerListener(this, needsReleaseNotify);
@@ -233,6 +237,7 @@ status_t Camera3OutputStream::returnBufferCheckedLocked(
     mLock.unlock();
 
     ANativeWindowBuffer *anwBuffer = container_of(buffer.buffer, ANativeWindowBuffer, handle);
+    nsecs_t queueTime = 0;
     /**
      * Return buffer back to ANativeWindow
      */
@@ -284,10 +289,18 @@ status_t Camera3OutputStream::returnBufferCheckedLocked(
         if (shouldLogError(res, state)) {
             ALOGE("%s: Stream %d: Error queueing buffer to native window:"
                   " %s (%d)", __FUNCTION__, mId, strerror(-res), res);
+        } else if (res == OK) {
+            queueTime = systemTime(SYSTEM_TIME_BOOTTIME);
         }
     }
     mLock.lock();
 
+    // Sensor timestamps can only be compared against the current time when the HAL
+    // uses the BOOTTIME base, as signaled by a non-zero timestamp offset.
+    if (queueTime != 0 && mTimestampOffset != 0) {
+        mCaptureToQueueLatency.add(timestamp, queueTime);
+    }
+
     // Once a valid buffer has been returned to the queue, can no longer
     // dequeue all buffers for preallocation.
     if (buffer.status != CAMERA3_BUFFER_STATUS_ERROR) {
@@ -314,6 +327,8 @@ void Camera3OutputStream::dump(int fd, const Vector<String16> &args) const {
 
     mDequeueBufferLatency.dump(fd,
         "      DequeueBuffer latency histogram:");
+    mCaptureToQueueLatency.dump(fd,
+        "      Capture to consumer queue latency histogram:");
 }
 
 status_t Camera3OutputStream::setTransform(int transform) {
@@ -706,6 +721,8 @@ status_t Camera3OutputStream::disconnectLocked() {
 
     mDequeueBufferLatency.log("Stream %d dequeueBuffer latency histogram", mId);
     mDequeueBufferLatency.reset();
+    mCaptureToQueueLatency.log("Stream %d capture to consumer queue latency histogram", mId);
+    mCaptureToQueueLatency.reset();
     return OK;
 }
 
@@ -328,6 +328,10 @@ class Camera3OutputStream :
     static const int32_t kDequeueLatencyBinSize = 5; // in ms
     CameraLatencyHistogram mDequeueBufferLatency;
 
+    // Time from start of exposure until the filled buffer is queued to the consumer
+    static const int32_t kCaptureToQueueLatencyBinSize = 10; // in ms
+    CameraLatencyHistogram mCaptureToQueueLatency;
+
 }; // class Camera3OutputStream
 
 } // namespace camera3
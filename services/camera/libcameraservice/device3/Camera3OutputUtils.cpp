@@ -227,14 +227,17 @@ void sendCaptureResult(
         states.nextResultFrameNum = frameNumber + 1;
     }
 
+    // The pending metadata and collected partials are only sent once, so take
+    // over their buffers instead of copying them into the capture result.
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
-    captureResult.mMetadata = pendingMetadata;
+    captureResult.mMetadata.acquire(pendingMetadata);
     captureResult.mPhysicalMetadatas = physicalMetadatas;
 
     // Append any previous partials to form a complete result
     if (states.usePartialResult && !collectedPartialResult.isEmpty()) {
         captureResult.mMetadata.append(collectedPartialResult);
+        collectedPartialResult.clear();
     }
 
     captureResult.mMetadata.sort();
@@ -487,7 +490,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera3_capture_res
     // all result data and shutter timestamp have been received.
     nsecs_t shutterTimestamp = 0;
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         ssize_t idx = states.inflightMap.indexOfKey(frameNumber);
         if (idx == NAME_NOT_FOUND) {
             SET_ERR("Unknown frame number for capture result: %d",
@@ -614,7 +617,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera3_capture_res
             }
             if (shutterTimestamp == 0) {
                 request.pendingMetadata = result->result;
-                request.collectedPartialResult = collectedPartialResult;
+                request.collectedPartialResult.acquire(collectedPartialResult);
             } else if (request.hasCallback) {
                 CameraMetadata metadata;
                 metadata = result->result;
@@ -906,7 +909,7 @@ void notifyShutter(CaptureOutputStates& states, const camera3_shutter_msg_t &msg
     // Set timestamp for the request in the in-flight tracking
     // and get the request ID to send upstream
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         InFlightRequestMap& inflightMap = states.inflightMap;
         idx = inflightMap.indexOfKey(msg.frame_number);
         if (idx >= 0) {
@@ -1021,7 +1024,7 @@ void notifyError(CaptureOutputStates& states, const camera3_error_msg_t &msg) {
         case hardware::camera2::ICameraDeviceCallbacks::ERROR_CAMERA_REQUEST:
         case hardware::camera2::ICameraDeviceCallbacks::ERROR_CAMERA_RESULT:
             {
-                std::lock_guard<std::mutex> l(states.inflightLock);
+                std::lock_guard<InFlightLock> l(states.inflightLock);
                 ssize_t idx = states.inflightMap.indexOfKey(msg.frame_number);
                 if (idx >= 0) {
                     InFlightRequest &r = states.inflightMap.editValueAt(idx);
@@ -1384,7 +1387,7 @@ void returnStreamBuffers(ReturnBufferStates& states,
 void flushInflightRequests(FlushInflightReqStates& states) {
     ATRACE_CALL();
     { // First return buffers cached in mInFlightMap
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InFlightLock> l(states.inflightLock);
         for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
             const InFlightRequest &request = states.inflightMap.valueAt(idx);
             returnOutputBuffers(
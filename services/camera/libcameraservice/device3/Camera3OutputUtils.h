@@ -70,7 +70,7 @@ namespace camera3 {
     // callbacks
     struct CaptureOutputStates {
         const String8& cameraId;
-        std::mutex& inflightLock;
+        InFlightLock& inflightLock;
         int64_t& lastCompletedRegularFrameNumber;
         int64_t& lastCompletedZslFrameNumber;
         int64_t& lastCompletedReprocessFrameNumber;
@@ -142,7 +142,7 @@ namespace camera3 {
 
     struct FlushInflightReqStates {
         const String8& cameraId;
-        std::mutex& inflightLock;
+        InFlightLock& inflightLock;
         InFlightRequestMap& inflightMap; // end of inflightLock scope
         const bool useHalBufManager;
         sp<NotificationListener> listener;
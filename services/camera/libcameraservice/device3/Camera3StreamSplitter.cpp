@@ -441,6 +441,14 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
         mMutex.unlock();
         res = gbp->attachBuffer(&slot, gb);
         mMutex.lock();
+        if (res == TIMED_OUT && tracker->decrementReferenceCountLocked(surface_id) > 0) {
+            // A slow consumer must not hold back the other outputs; skip this frame
+            // for it and keep sending the buffer to the remaining outputs.
+            SP_LOGW("%s: Timed out attaching buffer to GraphicBufferProducer %p, skipping it",
+                    __FUNCTION__, gbp.get());
+            res = OK;
+            continue;
+        }
         if (res != OK) {
             SP_LOGE("%s: Cannot attachBuffer from GraphicBufferProducer %p: %s (%d)",
                     __FUNCTION__, gbp.get(), strerror(-res), res);
@@ -79,7 +79,8 @@ public:
     status_t notifyBufferReleased(const sp<GraphicBuffer>& buffer);
 
     // Attach a buffer to the specified outputs. This call reserves a buffer
-    // slot in the output queue.
+    // slot in the output queue. Outputs whose attach times out are dropped
+    // for this buffer, unless no output is left to receive it.
     status_t attachBufferToOutputs(ANativeWindowBuffer* anb,
             const std::vector<size_t>& surface_ids);
 
@@ -207,8 +207,11 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
         if (res != OK) return res;
     }
 
+    // Consecutive points usually belong to the same region or rectangle, so start each
+    // search from the quad that enclosed the previous point.
+    const GridQuad *quad = nullptr;
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mDistortedGrid);
+        quad = findEnclosingQuad(coordPairs + i, mDistortedGrid, quad);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -423,42 +426,63 @@ status_t DistortionMapper::buildGrids() {
 }
 
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
-        const int32_t pt[2], const std::vector<GridQuad>& grid) {
-    const float x = pt[0];
-    const float y = pt[1];
+        const int32_t pt[2], const std::vector<GridQuad>& grid, const GridQuad* hint) {
+    if (hint != nullptr && grid.size() == kGridSize * kGridSize &&
+            hint >= grid.data() && hint < grid.data() + grid.size()) {
+        // Grid is laid out column-major, see buildGrids()
+        const ssize_t hintIndex = hint - grid.data();
+        const ssize_t hintCol = hintIndex / kGridSize;
+        const ssize_t hintRow = hintIndex % kGridSize;
+        if (isPointInQuad(pt, *hint)) return hint;
+        for (ssize_t col = hintCol - 1; col <= hintCol + 1; col++) {
+            if (col < 0 || col >= static_cast<ssize_t>(kGridSize)) continue;
+            for (ssize_t row = hintRow - 1; row <= hintRow + 1; row++) {
+                if (row < 0 || row >= static_cast<ssize_t>(kGridSize)) continue;
+                const GridQuad& quad = grid[col * kGridSize + row];
+                if (&quad == hint) continue;
+                if (isPointInQuad(pt, quad)) return &quad;
+            }
+        }
+    }
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (isPointInQuad(pt, quad)) return &quad;
     }
     return nullptr;
 }
 
+bool DistortionMapper::isPointInQuad(const int32_t pt[2], const GridQuad& quad) {
+    const float x = pt[0];
+    const float y = pt[1];
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 float DistortionMapper::calculateUorV(const int32_t pt[2], const GridQuad& quad, bool calculateU) {
     const float x = pt[0];
     const float y = pt[1];
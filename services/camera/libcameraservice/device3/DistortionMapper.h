@@ -133,9 +133,15 @@ class DistortionMapper : private CoordinateMapper {
         std::array<float, 8> coords;
     };
 
-    // Find which grid quad encloses the point; returns null if none do
+    // Find which grid quad encloses the point; returns null if none do.
+    // If hint is non-null, the hint quad and its immediate neighbors are tested before falling
+    // back to a full scan of the grid.
     static const GridQuad* findEnclosingQuad(
-            const int32_t pt[2], const std::vector<GridQuad>& grid);
+            const int32_t pt[2], const std::vector<GridQuad>& grid,
+            const GridQuad* hint = nullptr);
+
+    // Returns true if the point lies within the quad, or on one of its edges
+    static bool isPointInQuad(const int32_t pt[2], const GridQuad& quad);
 
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
@@ -17,6 +17,9 @@
 #ifndef ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
+#include <inttypes.h>
+#include <atomic>
+#include <mutex>
 #include <set>
 
 #include <camera/CaptureResult.h>
@@ -166,6 +169,59 @@ struct InFlightRequest {
 // Map from frame number to the in-flight request state
 typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
 
+// Mutex guarding an InFlightRequestMap. It is taken by the HAL result/notify
+// callbacks and the request thread for every frame, so it keeps contention
+// and hold time statistics for dumpsys.
+class InFlightLock {
+  public:
+    void lock() {
+        if (!mMutex.try_lock()) {
+            nsecs_t waitStart = systemTime();
+            mMutex.lock();
+            mContendedCount++;
+            mTotalWaitNs += systemTime() - waitStart;
+        }
+        mLockCount++;
+        mAcquiredAt = systemTime();
+    }
+
+    void unlock() {
+        nsecs_t held = systemTime() - mAcquiredAt;
+        mTotalHoldNs += held;
+        if (held > mMaxHoldNs) {
+            mMaxHoldNs = held;
+        }
+        mMutex.unlock();
+    }
+
+    void dump(String8 *lines) const {
+        int64_t lockCount = mLockCount;
+        int64_t contendedCount = mContendedCount;
+        lines->appendFormat("      Acquired: %" PRId64 ", contended: %" PRId64, lockCount,
+                contendedCount);
+        if (lockCount > 0) {
+            lines->appendFormat(", avg hold: %" PRId64 " ns, max hold: %" PRId64 " ns",
+                    (int64_t)mTotalHoldNs / lockCount, (int64_t)mMaxHoldNs);
+        }
+        if (contendedCount > 0) {
+            lines->appendFormat(", avg wait: %" PRId64 " ns",
+                    (int64_t)mTotalWaitNs / contendedCount);
+        }
+        lines->append("\n");
+    }
+
+  private:
+    std::mutex mMutex;
+    nsecs_t mAcquiredAt = 0; // only accessed with mMutex held
+
+    // Written with mMutex held, read without it by dump().
+    std::atomic<int64_t> mLockCount{0};
+    std::atomic<int64_t> mContendedCount{0};
+    std::atomic<nsecs_t> mTotalWaitNs{0};
+    std::atomic<nsecs_t> mTotalHoldNs{0};
+    std::atomic<nsecs_t> mMaxHoldNs{0};
+};
+
 } // namespace camera3
 
 } // namespace android
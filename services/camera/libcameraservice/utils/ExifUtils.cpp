@@ -207,18 +207,18 @@ public:
     virtual std::unique_ptr<ExifEntry> addEntry(ExifIfd ifd, ExifTag tag);
 
     // Helpe functions to add exif data with different types.
-    virtual bool setShort(ExifIfd ifd, ExifTag tag, uint16_t value, const std::string& msg);
+    virtual bool setShort(ExifIfd ifd, ExifTag tag, uint16_t value, const char* msg);
 
-    virtual bool setLong(ExifIfd ifd, ExifTag tag, uint32_t value, const std::string& msg);
+    virtual bool setLong(ExifIfd ifd, ExifTag tag, uint32_t value, const char* msg);
 
     virtual bool setRational(ExifIfd ifd, ExifTag tag, uint32_t numerator,
-            uint32_t denominator, const std::string& msg);
+            uint32_t denominator, const char* msg);
 
     virtual bool setSRational(ExifIfd ifd, ExifTag tag, int32_t numerator,
-            int32_t denominator, const std::string& msg);
+            int32_t denominator, const char* msg);
 
     virtual bool setString(ExifIfd ifd, ExifTag tag, ExifFormat format,
-            const std::string& buffer, const std::string& msg);
+            const std::string& buffer, const char* msg);
 
     float convertToApex(float val) {
         return 2.0f * log2f(val);
@@ -805,20 +805,20 @@ std::unique_ptr<ExifEntry> ExifUtilsImpl::addEntry(ExifIfd ifd, ExifTag tag) {
     return entry;
 }
 
-bool ExifUtilsImpl::setShort(ExifIfd ifd, ExifTag tag, uint16_t value, const std::string& msg) {
+bool ExifUtilsImpl::setShort(ExifIfd ifd, ExifTag tag, uint16_t value, const char* msg) {
     std::unique_ptr<ExifEntry> entry = addEntry(ifd, tag);
     if (!entry) {
-        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg.c_str());
+        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg);
         return false;
     }
     exif_set_short(entry->data, EXIF_BYTE_ORDER_INTEL, value);
     return true;
 }
 
-bool ExifUtilsImpl::setLong(ExifIfd ifd, ExifTag tag, uint32_t value, const std::string& msg) {
+bool ExifUtilsImpl::setLong(ExifIfd ifd, ExifTag tag, uint32_t value, const char* msg) {
     std::unique_ptr<ExifEntry> entry = addEntry(ifd, tag);
     if (!entry) {
-        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg.c_str());
+        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg);
         return false;
     }
     exif_set_long(entry->data, EXIF_BYTE_ORDER_INTEL, value);
@@ -826,10 +826,10 @@ bool ExifUtilsImpl::setLong(ExifIfd ifd, ExifTag tag, uint32_t value, const std:
 }
 
 bool ExifUtilsImpl::setRational(ExifIfd ifd, ExifTag tag, uint32_t numerator,
-        uint32_t denominator, const std::string& msg) {
+        uint32_t denominator, const char* msg) {
     std::unique_ptr<ExifEntry> entry = addEntry(ifd, tag);
     if (!entry) {
-        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg.c_str());
+        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg);
         return false;
     }
     exif_set_rational(entry->data, EXIF_BYTE_ORDER_INTEL, {numerator, denominator});
@@ -837,10 +837,10 @@ bool ExifUtilsImpl::setRational(ExifIfd ifd, ExifTag tag, uint32_t numerator,
 }
 
 bool ExifUtilsImpl::setSRational(ExifIfd ifd, ExifTag tag, int32_t numerator,
-        int32_t denominator, const std::string& msg) {
+        int32_t denominator, const char* msg) {
     std::unique_ptr<ExifEntry> entry = addEntry(ifd, tag);
     if (!entry) {
-        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg.c_str());
+        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg);
         return false;
     }
     exif_set_srational(entry->data, EXIF_BYTE_ORDER_INTEL, {numerator, denominator});
@@ -848,16 +848,24 @@ bool ExifUtilsImpl::setSRational(ExifIfd ifd, ExifTag tag, int32_t numerator,
 }
 
 bool ExifUtilsImpl::setString(ExifIfd ifd, ExifTag tag, ExifFormat format,
-        const std::string& buffer, const std::string& msg) {
+        const std::string& buffer, const char* msg) {
     size_t entry_size = buffer.length();
     // Since the exif format is undefined, NULL termination is not necessary.
     if (format == EXIF_FORMAT_ASCII) {
         entry_size++;
     }
+    // Overwrite an existing entry of the same shape in place rather than
+    // removing it and allocating a new one.
+    ExifEntry* existing = exif_content_get_entry(exif_data_->ifd[ifd], tag);
+    if (existing && existing->data && existing->format == format &&
+            existing->size == entry_size) {
+        memcpy(existing->data, buffer.c_str(), entry_size);
+        return true;
+    }
     std::unique_ptr<ExifEntry> entry =
             addVariableLengthEntry(ifd, tag, format, entry_size, entry_size);
     if (!entry) {
-        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg.c_str());
+        ALOGE("%s: Adding '%s' entry failed", __FUNCTION__, msg);
         return false;
     }
     memcpy(entry->data, buffer.c_str(), entry_size);
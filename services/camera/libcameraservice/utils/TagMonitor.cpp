@@ -126,23 +126,27 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
     }
 
     std::string emptyId;
+    CameraMetadata &lastValues = (source == REQUEST) ?
+            mLastMonitoredRequestValues : mLastMonitoredResultValues;
     for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata);
+        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata,
+                lastValues);
+    }
 
-        for (auto& m : physicalMetadata) {
-            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second);
+    for (auto& m : physicalMetadata) {
+        CameraMetadata &lastPhysicalValues = (source == REQUEST) ?
+                mLastMonitoredPhysicalRequestKeys[m.first] :
+                mLastMonitoredPhysicalResultKeys[m.first];
+        for (auto tag : mMonitoredTagList) {
+            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second,
+                    lastPhysicalValues);
         }
     }
 }
 
 void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
-        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata) {
-
-    CameraMetadata &lastValues = (source == REQUEST) ?
-            (cameraId.empty() ? mLastMonitoredRequestValues :
-                    mLastMonitoredPhysicalRequestKeys[cameraId]) :
-            (cameraId.empty() ? mLastMonitoredResultValues :
-                    mLastMonitoredPhysicalResultKeys[cameraId]);
+        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata,
+        CameraMetadata& lastValues) {
 
     camera_metadata_ro_entry entry = metadata.find(tag);
     if (lastValues.isEmpty()) {
@@ -227,11 +231,11 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
                             mVendorTagId),
                     get_local_camera_metadata_tag_name_vendor_id(event.tag,
                             mVendorTagId));
-            if (event.newData.size() == 0) {
+            if (event.dataSize == 0) {
                 dprintf(fd, " (Removed)\n");
             } else {
-                printData(fd, event.newData.data(), event.tag,
-                        event.type, event.newData.size() / camera_metadata_type_size[event.type],
+                printData(fd, event.data(), event.tag,
+                        event.type, event.dataSize / camera_metadata_type_size[event.type],
                         indentation + 18);
             }
         }
@@ -331,11 +335,15 @@ TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, ns
         timestamp(timestamp),
         tag(value.tag),
         type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
+        dataSize(camera_metadata_type_size[value.type] * value.count),
         cameraId(cameraId) {
-}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
+    if (dataSize == 0) {
+        // Removed entry, no value to copy
+    } else if (dataSize <= kInlineDataSize) {
+        memcpy(inlineData, value.data.u8, dataSize);
+    } else {
+        newData.assign(value.data.u8, value.data.u8 + dataSize);
+    }
 }
 
 } // namespace android
@@ -78,7 +78,7 @@ class TagMonitor {
 
     void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata);
+            const CameraMetadata& metadata, CameraMetadata& lastValues);
 
     std::atomic<bool> mMonitoringEnabled;
     std::mutex mMonitorMutex;
@@ -96,19 +96,29 @@ class TagMonitor {
     /**
      * A monitoring event
      * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
+     * Copies the source metadata value array; small values are kept inline so
+     * that recording an event does not allocate.
      */
     struct MonitorEvent {
         template<typename T>
         MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
                 const T &newValue, const std::string& cameraId);
-        ~MonitorEvent();
+
+        const uint8_t* data() const {
+            return (dataSize <= kInlineDataSize) ? inlineData : newData.data();
+        }
+
+        // Large enough for 3A modes, states, and metering regions
+        static const size_t kInlineDataSize = 32;
 
         eventSource source;
         uint32_t frameNumber;
         nsecs_t timestamp;
         uint32_t tag;
         uint8_t type;
+        size_t dataSize;
+        uint8_t inlineData[kInlineDataSize];
+        // Only used for values larger than kInlineDataSize
         std::vector<uint8_t> newData;
         std::string cameraId;
     };
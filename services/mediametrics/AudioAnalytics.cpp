@@ -352,6 +352,12 @@ std::pair<std::string, int32_t> AudioAnalytics::dump(
         }
     }
 
+    if (ll > 0 && prefix == nullptr) {
+        auto [s, l] = mDeviceUse.dump(ll);
+        ss << s;
+        ll -= l;
+    }
+
     if (ll > 0 && prefix == nullptr) {
         auto [s, l] = mAudioPowerUsage.dump(ll);
         ss << s;
@@ -534,6 +540,10 @@ void AudioAnalytics::DeviceUse::endAudioIntervalGroup(
         int32_t underrun = 0; // zero for record types
         mAudioAnalytics.mAnalyticsState->timeMachine().get(
                 key, AMEDIAMETRICS_PROP_UNDERRUN, &underrun);
+        {
+            std::lock_guard l(mLock);
+            mThreadUnderruns.add(underrun);
+        }
 
         const bool isInput = types::isInputThreadType(type);
         const auto encodingForStats = types::lookup<types::ENCODING, short_enum_type_t>(encoding);
@@ -619,6 +629,13 @@ void AudioAnalytics::DeviceUse::endAudioIntervalGroup(
         int32_t underrun = 0;
         mAudioAnalytics.mAnalyticsState->timeMachine().get(
                 key, AMEDIAMETRICS_PROP_UNDERRUN, &underrun);
+        {
+            std::lock_guard l(mLock);
+            mTrackUnderruns.add(underrun);
+            if (deviceStartupMs > 0.) {
+                mTrackDeviceStartupMs.add(deviceStartupMs);
+            }
+        }
         std::string usage;
         mAudioAnalytics.mAnalyticsState->timeMachine().get(
                 key, AMEDIAMETRICS_PROP_USAGE, &usage);
@@ -695,6 +712,31 @@ void AudioAnalytics::DeviceUse::endAudioIntervalGroup(
     }
 }
 
+std::pair<std::string, int32_t> AudioAnalytics::DeviceUse::dump(int32_t lines) const
+{
+    if (lines < 4) {
+        return {{}, 0};
+    }
+    std::lock_guard l(mLock);
+    std::stringstream ss;
+    ss << "DeviceUse:\n";
+    const auto dumpStatistics = [&ss](
+            const char *name, const audio_utils::Statistics<double> &stats) {
+        ss << "  " << name << " n:" << stats.getN();
+        if (stats.getN() > 0) {
+            ss << " mean:" << stats.getMean()
+               << " stddev:" << stats.getStdDev()
+               << " min:" << stats.getMin()
+               << " max:" << stats.getMax();
+        }
+        ss << "\n";
+    };
+    dumpStatistics("thread underrun", mThreadUnderruns);
+    dumpStatistics("track underrun", mTrackUnderruns);
+    dumpStatistics("track deviceStartupMs", mTrackDeviceStartupMs);
+    return { ss.str(), 4 };
+}
+
 // DeviceConnection helper class.
 void AudioAnalytics::DeviceConnection::a2dpConnected(
        const std::shared_ptr<const android::mediametrics::Item> &item) {
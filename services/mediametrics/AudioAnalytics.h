@@ -18,6 +18,7 @@
 
 #include <android-base/thread_annotations.h>
 #include <audio_utils/SimpleLog.h>
+#include <audio_utils/Statistics.h>
 #include "AnalyticsActions.h"
 #include "AnalyticsState.h"
 #include "AudioPowerUsage.h"
@@ -144,8 +145,17 @@ private:
                 const std::shared_ptr<const android::mediametrics::Item> &item,
                 ItemType itemType) const;
 
+        // Returns the running health statistics and the number of lines in the string.
+        std::pair<std::string, int32_t> dump(int32_t lines = INT32_MAX) const;
+
     private:
         AudioAnalytics &mAudioAnalytics;
+
+        // Running statistics, updated in O(1) per interval group without retaining items.
+        mutable std::mutex mLock;
+        mutable audio_utils::Statistics<double> mThreadUnderruns GUARDED_BY(mLock);
+        mutable audio_utils::Statistics<double> mTrackUnderruns GUARDED_BY(mLock);
+        mutable audio_utils::Statistics<double> mTrackDeviceStartupMs GUARDED_BY(mLock);
     } mDeviceUse{*this};
 
     // DeviceConnected is a nested class which handles audio device connection
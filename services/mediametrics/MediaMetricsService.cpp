@@ -283,6 +283,8 @@ status_t MediaMetricsService::dump(int fd, const Vector<String16>& args)
         }
     }
 
+    const char *prefixptr = prefix.size() > 0 ? prefix.c_str() : nullptr;
+    std::deque<std::shared_ptr<const mediametrics::Item>> items;
     {
         std::lock_guard _l(mLock);
 
@@ -292,17 +294,21 @@ status_t MediaMetricsService::dump(int fd, const Vector<String16>& args)
             mAudioAnalytics.clear();
         } else {
             result.appendFormat("Dump of the %s process:\n", kServiceName);
-            const char *prefixptr = prefix.size() > 0 ? prefix.c_str() : nullptr;
             dumpHeaders(result, sinceNs, prefixptr);
-            dumpQueue(result, sinceNs, prefixptr);
-
-            // TODO: maybe consider a better way of dumping audio analytics info.
-            const int32_t linesToDump = all ? INT32_MAX : 1000;
-            auto [ dumpString, lines ] = mAudioAnalytics.dump(linesToDump, sinceNs, prefixptr);
-            result.append(dumpString.c_str());
-            if (lines == linesToDump) {
-                result.append("-- some lines may be truncated --\n");
-            }
+            // Saved items are immutable, so snapshot the queue and format it outside
+            // of the lock to avoid stalling submissions for the length of the dump.
+            items = mItems;
+        }
+    }
+    if (!clear) {
+        dumpQueue(result, items, sinceNs, prefixptr);
+
+        // TODO: maybe consider a better way of dumping audio analytics info.
+        const int32_t linesToDump = all ? INT32_MAX : 1000;
+        auto [ dumpString, lines ] = mAudioAnalytics.dump(linesToDump, sinceNs, prefixptr);
+        result.append(dumpString.c_str());
+        if (lines == linesToDump) {
+            result.append("-- some lines may be truncated --\n");
         }
     }
     write(fd, result.string(), result.size());
@@ -348,15 +354,18 @@ void MediaMetricsService::dumpHeaders(String8 &result, int64_t sinceNs, const ch
 }
 
 // TODO: should prefix be a set<string>?
-void MediaMetricsService::dumpQueue(String8 &result, int64_t sinceNs, const char* prefix)
+/* static */
+void MediaMetricsService::dumpQueue(String8 &result,
+        const std::deque<std::shared_ptr<const mediametrics::Item>>& items,
+        int64_t sinceNs, const char* prefix)
 {
-    if (mItems.empty()) {
+    if (items.empty()) {
         result.append("empty\n");
         return;
     }
 
     int slot = 0;
-    for (const auto &item : mItems) {         // TODO: consider std::lower_bound() on mItems
+    for (const auto &item : items) {          // TODO: consider std::lower_bound() on items
         if (item->getTimestamp() < sinceNs) { // sinceNs == 0 means all items shown
             continue;
         }
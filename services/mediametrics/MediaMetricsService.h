@@ -93,7 +93,9 @@ private:
     bool expirations(const std::shared_ptr<const mediametrics::Item>& item) REQUIRES(mLock);
 
     // support for generating output
-    void dumpQueue(String8 &result, int64_t sinceNs, const char* prefix) REQUIRES(mLock);
+    static void dumpQueue(String8 &result,
+            const std::deque<std::shared_ptr<const mediametrics::Item>>& items,
+            int64_t sinceNs, const char* prefix);
     void dumpHeaders(String8 &result, int64_t sinceNs, const char* prefix) REQUIRES(mLock);
 
     // The following variables accessed without mLock
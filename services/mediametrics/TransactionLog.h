@@ -96,7 +96,8 @@ public:
 
         (void)gc(garbage);
         mLog.emplace_hint(mLog.end(), time, item);
-        mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
+        auto& keyHist = mItemMap[key];
+        keyHist.emplace_hint(keyHist.end(), time, item);
         return NO_ERROR;  // no errors for now.
     }
 
@@ -143,7 +144,11 @@ public:
             ss << "Consolidated:\n";
             --ll;
         }
-        auto [s, l] = dumpMapTimeItem(mLog, ll, sinceNs, prefix);
+        // With a prefix, only merge the per-key histories that match
+        // rather than filtering the entire log.
+        auto [s, l] = prefix != nullptr
+                ? dumpMapTimeItem(getMapTimeItemWithPrefix(prefix, sinceNs), ll, sinceNs)
+                : dumpMapTimeItem(mLog, ll, sinceNs);
         ss << s;
         ll -= l;
 
@@ -211,6 +216,21 @@ private:
         return { ss.str(), lines - ll };
     }
 
+    /**
+     * Returns the items whose key starts with prefix, from sinceNs on, in time order.
+     *
+     * Only the keys in mItemMap matching the prefix are visited.
+     */
+    MapTimeItem getMapTimeItemWithPrefix(const char *prefix, int64_t sinceNs) const
+            REQUIRES(mLock) {
+        MapTimeItem merged;
+        for (auto it = mItemMap.lower_bound(prefix);
+                it != mItemMap.end() && startsWith(it->first, prefix); ++it) {
+            merged.insert(it->second.lower_bound(sinceNs), it->second.end());
+        }
+        return merged;
+    }
+
     /**
      * Garbage collects if the TimeMachine size exceeds the high water mark.
      *
@@ -14,6 +14,13 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <binder/IServiceManager.h>
 #include <media/MediaMetricsItem.h>
 #include <benchmark/benchmark.h>
 
@@ -44,4 +51,41 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+static void BM_SubmitBufferWithDump(benchmark::State& state)
+{
+    // Same as BM_SubmitBuffer, but with another thread continuously dumping the service
+    // so that submissions contend with dumps for the item queue.
+    android::sp<android::IBinder> binder = android::defaultServiceManager()->checkService(
+            android::String16("media.metrics"));
+    if (binder == nullptr) {
+        state.SkipWithError("media.metrics service not found");
+        return;
+    }
+    const int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    std::atomic<bool> done{false};
+    std::thread dumper([&] {
+        const android::Vector<android::String16> args;
+        while (!done) {
+            binder->dump(fd, args);
+        }
+    });
+
+    while (state.KeepRunning()) {
+        MyItem myItem;
+        bool ok = myItem.mySubmitBuffer();
+        if (ok == false) {
+            // See BM_SubmitBuffer.
+            state.SkipWithError("failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    done = true;
+    dumper.join();
+    close(fd);
+}
+
+BENCHMARK(BM_SubmitBufferWithDump)->Iterations(4000);
+
 BENCHMARK_MAIN();
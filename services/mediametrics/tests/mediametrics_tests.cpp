@@ -740,6 +740,25 @@ TEST(mediametrics_tests, transaction_log_gc) {
   ASSERT_EQ((size_t)2, transactionLog.size());
 }
 
+TEST(mediametrics_tests, transaction_log_prefix_dump) {
+  android::mediametrics::TransactionLog transactionLog;
+
+  int64_t timestamp = 10;
+  for (const char *key : { "audio.track.1", "video.codec.1", "audio.record.2" }) {
+    auto item = std::make_shared<mediametrics::Item>(key);
+    (*item).set("value", (int32_t)1)
+           .setTimestamp(timestamp++);
+    ASSERT_EQ(NO_ERROR, transactionLog.put(item));
+  }
+
+  // Consolidated header + 3 items + Categorized header + 3 * (key + item)
+  ASSERT_EQ(11, transactionLog.dump(100, 0 /* sinceNs */).second /* lines */);
+  // Consolidated header + 2 items + Categorized header + 2 * (key + item)
+  ASSERT_EQ(8, transactionLog.dump(100, 0 /* sinceNs */, "audio.").second /* lines */);
+  // Only the last audio item is at or after timestamp 11.
+  ASSERT_EQ(5, transactionLog.dump(100, 11 /* sinceNs */, "audio.").second /* lines */);
+}
+
 TEST(mediametrics_tests, analytics_actions) {
   mediametrics::AnalyticsActions analyticsActions;
   bool action1 = false;
@@ -732,16 +732,29 @@ bool ResourceManagerService::getAllClients_l(
         int callingPid, MediaResource::Type type,
         Vector<std::shared_ptr<IResourceManagerClient>> *clients) {
     Vector<std::shared_ptr<IResourceManagerClient>> temp;
+    // Priorities are looked up at most once per pid (and once for the caller), rather than
+    // once per matching client, as each lookup may go out to the process info service.
+    int callingPriority;
+    bool hasCallingPriority = false;
     for (size_t i = 0; i < mMap.size(); ++i) {
         ResourceInfos &infos = mMap.editValueAt(i);
+        bool isPidChecked = false;
         for (size_t j = 0; j < infos.size(); ++j) {
             if (hasResourceType(type, infos[j].resources)) {
-                if (!isCallingPriorityHigher_l(callingPid, mMap.keyAt(i))) {
-                    // some higher/equal priority process owns the resource,
-                    // this request can't be fulfilled.
-                    ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
-                            asString(type), mMap.keyAt(i));
-                    return false;
+                if (!isPidChecked) {
+                    if (!hasCallingPriority) {
+                        hasCallingPriority = getPriority_l(callingPid, &callingPriority);
+                    }
+                    int priority;
+                    if (!hasCallingPriority || !getPriority_l(mMap.keyAt(i), &priority)
+                            || callingPriority >= priority) {
+                        // some higher/equal priority process owns the resource,
+                        // this request can't be fulfilled.
+                        ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
+                                asString(type), mMap.keyAt(i));
+                        return false;
+                    }
+                    isPidChecked = true;
                 }
                 temp.push_back(infos[j].client);
             }
@@ -78,6 +78,7 @@ std::string AAudioEndpointManager::dump() const {
         result << "  ExclusiveOpenCount:    " << mExclusiveOpenCount << "\n";
         result << "  ExclusiveCloseCount:   " << mExclusiveCloseCount << "\n";
         result << "  ExclusiveStolenCount:  " << mExclusiveStolenCount << "\n";
+        result << "  ExclusiveBusyCount:    " << mExclusiveBusyCount << "\n";
         result << "\n";
 
         if (isExclusiveLocked) {
@@ -184,6 +185,10 @@ sp<AAudioServiceEndpoint> AAudioEndpointManager::openExclusiveEndpoint(
             // the app is paused.
             AAudioClientTracker::getInstance().setExclusiveEnabled(request.getProcessId(), false);
             endpointToSteal = endpoint; // return it to caller
+        } else {
+            ALOGD("%s() endpoint in %s use, cannot steal it", __func__,
+                  endpoint->isForSharing() ? "SHARED" : "EXCLUSIVE");
+            mExclusiveBusyCount++;
         }
         return nullptr;
     } else {
@@ -94,6 +94,7 @@ private:
     int32_t mExclusiveOpenCount   = 0; // number of times we OPENED an exclusive endpoint
     int32_t mExclusiveCloseCount  = 0; // number of times we CLOSED an exclusive endpoint
     int32_t mExclusiveStolenCount = 0; // number of times we STOLE an exclusive endpoint
+    int32_t mExclusiveBusyCount   = 0; // number of times an exclusive endpoint was BUSY
 
     // Same as above but for SHARED endpoints.
     int32_t mSharedSearchCount    = 0;
@@ -20,6 +20,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
+#include <algorithm>
 #include <cstring>
 #include <utils/Trace.h>
 
@@ -46,76 +47,149 @@ void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
 }
 
 void AAudioMixer::clear() {
-    memset(mOutputBuffer, 0, mBufferSizeInBytes);
+    // The first pass of the next burst overwrites the buffer instead of accumulating.
+    mOutputCleared = true;
 }
 
+namespace {
+
+// Sums NUM_SOURCES sources into destination, or over it if ACCUMULATE.
+// The source count is a template parameter so that the inner loop is unrolled
+// and the sample loop can be vectorized.
+template <int NUM_SOURCES, bool ACCUMULATE>
+void mixSamples(float * __restrict destination, const float * const *sources,
+                int32_t numSamples) {
+    const float *source[NUM_SOURCES];
+    for (int s = 0; s < NUM_SOURCES; s++) {
+        source[s] = sources[s];
+    }
+    for (int32_t i = 0; i < numSamples; i++) {
+        float sum = ACCUMULATE ? destination[i] : 0.0f;
+        for (int s = 0; s < NUM_SOURCES; s++) {
+            sum += source[s][i];
+        }
+        destination[i] = sum;
+    }
+}
+
+template <bool ACCUMULATE>
+void mixSamples(float *destination, const float * const *sources, int numSources,
+                int32_t numSamples) {
+    static_assert(AAudioMixer::kMaxSourcesPerPass == 4, "update the cases below");
+    switch (numSources) {
+        case 0:
+            if (!ACCUMULATE) {
+                memset(destination, 0, numSamples * sizeof(float));
+            }
+            break;
+        case 1: mixSamples<1, ACCUMULATE>(destination, sources, numSamples); break;
+        case 2: mixSamples<2, ACCUMULATE>(destination, sources, numSamples); break;
+        case 3: mixSamples<3, ACCUMULATE>(destination, sources, numSamples); break;
+        case 4: mixSamples<4, ACCUMULATE>(destination, sources, numSamples); break;
+    }
+}
+
+} // namespace
+
 int32_t AAudioMixer::mix(int streamIndex, FifoBuffer *fifo, bool allowUnderflow) {
-    WrappingBuffer wrappingBuffer;
-    float *destination = mOutputBuffer;
+    Source source;
+    source.fifo = fifo;
+    source.allowUnderflow = allowUnderflow;
+    mixSources(streamIndex, &source, 1);
+    return source.framesRead;
+}
+
+void AAudioMixer::mixSources(int streamIndex, Source *sources, int numSources) {
+    WrappingBuffer wrappingBuffers[kMaxSourcesPerPass];
+    fifo_frames_t framesDesired[kMaxSourcesPerPass];
+    numSources = std::min(numSources, kMaxSourcesPerPass);
 
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_BEGIN("aaMix");
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
-    // Gather the data from the client. May be in two parts.
-    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&wrappingBuffer);
+    for (int i = 0; i < numSources; i++) {
+        // Gather the data from the client. May be in two parts.
+        fifo_frames_t fullFrames = sources[i].fifo->getFullDataAvailable(&wrappingBuffers[i]);
 #if AAUDIO_MIXER_ATRACE_ENABLED
-    if (ATRACE_ENABLED()) {
-        char rdyText[] = "aaMixRdy#";
-        char letter = 'A' + (streamIndex % 26);
-        rdyText[sizeof(rdyText) - 2] = letter;
-        ATRACE_INT(rdyText, fullFrames);
-    }
+        if (ATRACE_ENABLED()) {
+            char rdyText[] = "aaMixRdy#";
+            char letter = 'A' + ((streamIndex + i) % 26);
+            rdyText[sizeof(rdyText) - 2] = letter;
+            ATRACE_INT(rdyText, fullFrames);
+        }
 #else /* MIXER_ATRACE_ENABLED */
-    (void) trackIndex;
+        (void) streamIndex;
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
-    // If allowUnderflow then always advance by one burst even if we do not have the data.
-    // Otherwise the stream timing will drift whenever there is an underflow.
-    // This actual underflow can then be detected by the client for XRun counting.
-    //
-    // Generally, allowUnderflow will be false when stopping a stream and we want to
-    // use up whatever data is in the queue.
-    fifo_frames_t framesDesired = mFramesPerBurst;
-    if (!allowUnderflow && fullFrames < framesDesired) {
-        framesDesired = fullFrames; // just use what is available then stop
+        // If allowUnderflow then always advance by one burst even if we do not have the data.
+        // Otherwise the stream timing will drift whenever there is an underflow.
+        // This actual underflow can then be detected by the client for XRun counting.
+        //
+        // Generally, allowUnderflow will be false when stopping a stream and we want to
+        // use up whatever data is in the queue.
+        framesDesired[i] = mFramesPerBurst;
+        if (!sources[i].allowUnderflow && fullFrames < framesDesired[i]) {
+            framesDesired[i] = fullFrames; // just use what is available then stop
+        }
+        // After an underflow the FIFO may be empty with the read index ahead.
+        sources[i].framesRead = std::max(0, std::min(framesDesired[i], fullFrames));
     }
 
-    // Mix data in one or two parts.
-    int partIndex = 0;
-    int32_t framesLeft = framesDesired;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToMixFromPart = framesLeft;
-        fifo_frames_t framesAvailableFromPart = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailableFromPart > 0) {
-            if (framesToMixFromPart > framesAvailableFromPart) {
-                framesToMixFromPart = framesAvailableFromPart;
+    // Mix in segments over which the data of every source is contiguous.
+    // A source wraps or runs out at most once per burst,
+    // so there are at most 2 * numSources + 1 segments.
+    int32_t frame = 0;
+    while (frame < mFramesPerBurst) {
+        int32_t segmentFrames = mFramesPerBurst - frame;
+        const float *segmentSources[kMaxSourcesPerPass];
+        int numSegmentSources = 0;
+        for (int i = 0; i < numSources; i++) {
+            const int32_t framesRead = sources[i].framesRead;
+            if (frame >= framesRead) {
+                continue; // no more data from this source
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
-
-            destination += framesToMixFromPart * mSamplesPerFrame;
-            framesLeft -= framesToMixFromPart;
+            const WrappingBuffer &wrappingBuffer = wrappingBuffers[i];
+            const int32_t firstFrames = std::min(wrappingBuffer.numFrames[0], framesRead);
+            const float *data;
+            int32_t contiguousFrames;
+            if (frame < firstFrames) {
+                data = (const float *) wrappingBuffer.data[0] + frame * mSamplesPerFrame;
+                contiguousFrames = firstFrames - frame;
+            } else {
+                data = (const float *) wrappingBuffer.data[1]
+                        + (frame - firstFrames) * mSamplesPerFrame;
+                contiguousFrames = framesRead - frame;
+            }
+            segmentFrames = std::min(segmentFrames, contiguousFrames);
+            segmentSources[numSegmentSources++] = data;
+        }
+        float *destination = mOutputBuffer + frame * mSamplesPerFrame;
+        if (mOutputCleared) {
+            mixSamples<false>(destination, segmentSources, numSegmentSources,
+                              segmentFrames * mSamplesPerFrame);
+        } else {
+            mixSamples<true>(destination, segmentSources, numSegmentSources,
+                             segmentFrames * mSamplesPerFrame);
         }
-        partIndex++;
+        frame += segmentFrames;
+    }
+    mOutputCleared = false;
+
+    for (int i = 0; i < numSources; i++) {
+        sources[i].fifo->advanceReadIndex(framesDesired[i]);
     }
-    fifo->advanceReadIndex(framesDesired);
 
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_END();
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
-
-    return (framesDesired - framesLeft); // framesRead
-}
-
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
-    }
 }
 
 float *AAudioMixer::getOutputBuffer() {
+    if (mOutputCleared) {
+        // nothing was mixed into this burst
+        memset(mOutputBuffer, 0, mBufferSizeInBytes);
+        mOutputCleared = false;
+    }
     return mOutputBuffer;
 }
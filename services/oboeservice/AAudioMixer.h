@@ -40,14 +40,34 @@ public:
      */
     int32_t mix(int streamIndex, android::FifoBuffer *fifo, bool allowUnderflow);
 
+    /**
+     * A FIFO to be mixed by mixSources().
+     */
+    struct Source {
+        android::FifoBuffer *fifo = nullptr;
+        bool allowUnderflow = true; // see mix()
+        int32_t framesRead = 0;     // set by mixSources()
+    };
+
+    static constexpr int kMaxSourcesPerPass = 4;
+
+    /**
+     * Mix up to kMaxSourcesPerPass FIFOs in a single pass over the output buffer.
+     * This is equivalent to calling mix() for each source in order.
+     * The FIFOs must stay open until this returns.
+     * @param streamIndex of the first source, for marking stream variables in systrace
+     * @param sources to read from, framesRead is set for each
+     * @param numSources from 1 to kMaxSourcesPerPass
+     */
+    void mixSources(int streamIndex, Source *sources, int numSources);
+
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
-
     float   *mOutputBuffer = nullptr;
+    bool     mOutputCleared = false; // nothing mixed since clear(), the buffer is stale
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
     int32_t  mBufferSizeInBytes = 0;
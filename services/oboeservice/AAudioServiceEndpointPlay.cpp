@@ -79,8 +79,10 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
+            // Running streams are mixed in groups, one pass of the mixer per group.
+            StreamToMix streamsToMix[AAudioMixer::kMaxSourcesPerPass];
+            int numStreamsToMix = 0;
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -94,50 +96,17 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                     continue; // this stream is not running so skip it.
                 }
 
-                sp<AAudioServiceStreamShared> streamShared =
-                        static_cast<AAudioServiceStreamShared *>(clientStream.get());
-
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->getAudioDataQueueLock());
-
-                    FifoBuffer *fifo = streamShared->getAudioDataFifoBuffer_l();
-                    if (fifo != nullptr) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
-                    }
+                StreamToMix &streamToMix = streamsToMix[numStreamsToMix++];
+                streamToMix.stream = static_cast<AAudioServiceStreamShared *>(clientStream.get());
+                streamToMix.allowUnderflow = allowUnderflow;
+                if (numStreamsToMix == AAudioMixer::kMaxSourcesPerPass) {
+                    mixStreams_l(index, streamsToMix, numStreamsToMix, mmapFramesWritten);
+                    index += numStreamsToMix; // just used for labelling tracks in systrace
+                    numStreamsToMix = 0;
                 }
-
-                if (clientFramesRead > 0) {
-                    // This timestamp represents the completion of data being read out of the
-                    // client buffer. It is sent to the client and used in the timing model
-                    // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
-                }
-
-                index++; // just used for labelling tracks in systrace
+            }
+            if (numStreamsToMix > 0) {
+                mixStreams_l(index, streamsToMix, numStreamsToMix, mmapFramesWritten);
             }
         }
 
@@ -160,3 +129,70 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
           __func__, mCallbackEnabled.load(), getStreamInternal()->getState(), result);
     return NULL; // TODO review
 }
+
+void AAudioServiceEndpointPlay::mixStreams_l(int index, StreamToMix *streams, int numStreams,
+                                             int64_t mmapFramesWritten) {
+    AAudioMixer::Source sources[AAudioMixer::kMaxSourcesPerPass];
+    int sourceStreams[AAudioMixer::kMaxSourcesPerPass]; // stream of each source
+    int64_t clientFramesRead[AAudioMixer::kMaxSourcesPerPass] = {};
+    int numSources = 0;
+
+    {
+        // Lock the AudioFifos to protect against close.
+        // Only this thread holds more than one of these locks at a time.
+        std::unique_lock<std::mutex> fifoLocks[AAudioMixer::kMaxSourcesPerPass];
+        for (int i = 0; i < numStreams; i++) {
+            AAudioServiceStreamShared *streamShared = streams[i].stream.get();
+            fifoLocks[i] = std::unique_lock<std::mutex>(
+                    streamShared->getAudioDataQueueLock());
+
+            FifoBuffer *fifo = streamShared->getAudioDataFifoBuffer_l();
+            if (fifo != nullptr) {
+                // Determine offset between framePosition in client's stream
+                // vs the underlying MMAP stream.
+                int64_t framesRead = fifo->getReadCounter();
+                // These two indices refer to the same frame.
+                int64_t positionOffset = mmapFramesWritten - framesRead;
+                streamShared->setTimestampPositionOffset(positionOffset);
+
+                sources[numSources].fifo = fifo;
+                sources[numSources].allowUnderflow = streams[i].allowUnderflow;
+                sourceStreams[numSources] = i;
+                numSources++;
+            }
+        }
+
+        if (numSources > 0) {
+            mMixer.mixSources(index, sources, numSources);
+        }
+
+        for (int s = 0; s < numSources; s++) {
+            const int i = sourceStreams[s];
+            AAudioServiceStreamShared *streamShared = streams[i].stream.get();
+            int32_t framesMixed = sources[s].framesRead;
+            if (streamShared->isFlowing()) {
+                // Consider it an underflow if we got less than a burst
+                // after the data started flowing.
+                bool underflowed = streams[i].allowUnderflow
+                                   && framesMixed < mMixer.getFramesPerBurst();
+                if (underflowed) {
+                    streamShared->incrementXRunCount();
+                }
+            } else if (framesMixed > 0) {
+                // Mark beginning of data flow after a start.
+                streamShared->setFlowing(true);
+            }
+            clientFramesRead[i] = sources[s].fifo->getReadCounter();
+        }
+    }
+
+    for (int i = 0; i < numStreams; i++) {
+        if (clientFramesRead[i] > 0) {
+            // This timestamp represents the completion of data being read out of the
+            // client buffer. It is sent to the client and used in the timing model
+            // to decide when the client has room to write more data.
+            Timestamp timestamp(clientFramesRead[i], AudioClock::getNanoseconds());
+            streams[i].stream->markTransferTime(timestamp);
+        }
+    }
+}
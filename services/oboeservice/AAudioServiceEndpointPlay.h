@@ -45,6 +45,19 @@ public:
     void *callbackLoop() override;
 
 private:
+    struct StreamToMix {
+        android::sp<AAudioServiceStreamShared> stream;
+        bool allowUnderflow = true;
+    };
+
+    /**
+     * Mix up to AAudioMixer::kMaxSourcesPerPass streams in one pass of the mixer.
+     * Called with mLockStreams held.
+     * @param index of the first stream, for labelling tracks in systrace
+     */
+    void mixStreams_l(int index, StreamToMix *streams, int numStreams,
+                      int64_t mmapFramesWritten);
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
 };
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include "binding/RingBufferParcelable.h"
 #include "binding/AudioEndpointParcelable.h"
@@ -32,7 +33,9 @@ SharedRingBuffer::~SharedRingBuffer()
 {
     if (mSharedMemory != nullptr) {
         delete mFifoBuffer;
-        munmap(mSharedMemory, mSharedMemorySizeInBytes);
+        FifoBuffer::unmapMirrored(mMirroredData, mDataMemorySizeInBytes);
+        mMirroredData = nullptr;
+        munmap(mSharedMemory, mMappedMemorySizeInBytes);
         mSharedMemory = nullptr;
     }
 }
@@ -42,8 +45,13 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
     mCapacityInFrames = capacityInFrames;
 
     // Create shared memory large enough to hold the data and the read and write counters.
+    // If possible the data gets its own pages, so that it can be mirrored and read or
+    // written here without splitting at the wrap point.
     mDataMemorySizeInBytes = bytesPerFrame * capacityInFrames;
-    mSharedMemorySizeInBytes = mDataMemorySizeInBytes + (2 * (sizeof(fifo_counter_t)));
+    const bool mirror = FifoBuffer::canMirror(mDataMemorySizeInBytes);
+    mDataOffsetInBytes = mirror ? (int32_t) sysconf(_SC_PAGESIZE)
+                                : SHARED_RINGBUFFER_DATA_OFFSET;
+    mSharedMemorySizeInBytes = mDataOffsetInBytes + mDataMemorySizeInBytes;
     mFileDescriptor.reset(ashmem_create_region("AAudioSharedRingBuffer", mSharedMemorySizeInBytes));
     if (mFileDescriptor.get() == -1) {
         ALOGE("allocate() ashmem_create_region() failed %d", errno);
@@ -58,26 +66,40 @@ aaudio_result_t SharedRingBuffer::allocate(fifo_frames_t   bytesPerFrame,
         return AAUDIO_ERROR_INTERNAL; // TODO convert errno to a better AAUDIO_ERROR;
     }
 
-    // Map the fd to memory addresses.
-    mSharedMemory = (uint8_t *) mmap(0, mSharedMemorySizeInBytes,
+    // Map the fd to memory addresses. Mirrored data is mapped separately.
+    mMappedMemorySizeInBytes = mirror ? mDataOffsetInBytes : mSharedMemorySizeInBytes;
+    mSharedMemory = (uint8_t *) mmap(0, mMappedMemorySizeInBytes,
                          PROT_READ|PROT_WRITE,
                          MAP_SHARED,
                          mFileDescriptor.get(), 0);
     if (mSharedMemory == MAP_FAILED) {
         ALOGE("allocate() mmap() failed %d", errno);
+        mSharedMemory = nullptr;
         mFileDescriptor.reset();
         return AAUDIO_ERROR_INTERNAL; // TODO convert errno to a better AAUDIO_ERROR;
     }
+    uint8_t *dataAddress = &mSharedMemory[SHARED_RINGBUFFER_DATA_OFFSET];
+    if (mirror) {
+        mMirroredData = (uint8_t *) FifoBuffer::mapMirrored(mFileDescriptor.get(),
+                mDataOffsetInBytes, mDataMemorySizeInBytes);
+        if (mMirroredData == nullptr) {
+            munmap(mSharedMemory, mMappedMemorySizeInBytes);
+            mSharedMemory = nullptr;
+            mFileDescriptor.reset();
+            return AAUDIO_ERROR_INTERNAL;
+        }
+        dataAddress = mMirroredData;
+    }
 
     // Get addresses for our counters and data from the shared memory.
     fifo_counter_t *readCounterAddress =
             (fifo_counter_t *) &mSharedMemory[SHARED_RINGBUFFER_READ_OFFSET];
     fifo_counter_t *writeCounterAddress =
             (fifo_counter_t *) &mSharedMemory[SHARED_RINGBUFFER_WRITE_OFFSET];
-    uint8_t *dataAddress = &mSharedMemory[SHARED_RINGBUFFER_DATA_OFFSET];
 
     mFifoBuffer = new FifoBuffer(bytesPerFrame, capacityInFrames,
-                                 readCounterAddress, writeCounterAddress, dataAddress);
+                                 readCounterAddress, writeCounterAddress, dataAddress,
+                                 mirror);
     return AAUDIO_OK;
 }
 
@@ -85,7 +107,7 @@ void SharedRingBuffer::fillParcelable(AudioEndpointParcelable &endpointParcelabl
                     RingBufferParcelable &ringBufferParcelable) {
     int fdIndex = endpointParcelable.addFileDescriptor(mFileDescriptor, mSharedMemorySizeInBytes);
     ringBufferParcelable.setupMemory(fdIndex,
-                                     SHARED_RINGBUFFER_DATA_OFFSET,
+                                     mDataOffsetInBytes,
                                      mDataMemorySizeInBytes,
                                      SHARED_RINGBUFFER_READ_OFFSET,
                                      SHARED_RINGBUFFER_WRITE_OFFSET,
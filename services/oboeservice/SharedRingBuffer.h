@@ -32,6 +32,7 @@ namespace aaudio {
 #define SHARED_RINGBUFFER_READ_OFFSET   0
 #define SHARED_RINGBUFFER_WRITE_OFFSET  sizeof(fifo_counter_t)
 #define SHARED_RINGBUFFER_DATA_OFFSET   (SHARED_RINGBUFFER_WRITE_OFFSET + sizeof(fifo_counter_t))
+// When the data is mirrored it starts on the page after the counters.
 
 /**
  * Atomic FIFO that uses shared memory.
@@ -54,9 +55,12 @@ public:
 private:
     android::base::unique_fd  mFileDescriptor;
     android::FifoBuffer      *mFifoBuffer = nullptr;
-    uint8_t                  *mSharedMemory = nullptr;
+    uint8_t                  *mSharedMemory = nullptr; // at least the counters
+    uint8_t                  *mMirroredData = nullptr; // see FifoBuffer::mapMirrored()
     int32_t                   mSharedMemorySizeInBytes = 0;
+    int32_t                   mMappedMemorySizeInBytes = 0; // of mSharedMemory
     int32_t                   mDataMemorySizeInBytes = 0;
+    int32_t                   mDataOffsetInBytes = SHARED_RINGBUFFER_DATA_OFFSET;
     android::fifo_frames_t    mCapacityInFrames = 0;
 };
 